@@ -11,6 +11,10 @@
 #endif // THIS_DEVICE_ADDRESS
 // USE_LCD_CHARGE_PUMP is not set
 #define USE_WATCHDOG
+#define USE_TICKLESS_IDLE
+// CONFIG_SYNC_WOR is not set
+// CONFIG_LINK_CACHE is not set
+// CONFIG_FREQ_AGILITY is not set
 // DEBUG is not set
 #define CONFIG_DAY_OF_WEEK
 #define CONFIG_TEST
@@ -18,10 +22,16 @@
 // CONFIG_PHASE_CLOCK is not set
 #define CONFIG_ALTITUDE
 // CONFIG_VARIO is not set
+// CONFIG_ALTI_KALMAN is not set
 // CONFIG_PROUT is not set
 #define CONFIG_ACCEL
+// CONFIG_ACCEL_STREAM is not set
+// CONFIG_PEDOMETER is not set
+// CONFIG_FLICK_BACKLIGHT is not set
 #define CONFIG_ALARM
 #define CONFIG_BATTERY
+#define CONFIG_DATALOG
+#define CONFIG_ENERGY_STATS
 #define CONFIG_CLOCK
 #define CONFIG_DATE
 #define CONFIG_RFBSL
@@ -35,34 +35,166 @@
 #
 
 
-import serial
+from __future__ import print_function
+
+import random
+import sys
+
 import array
 
+# Packed acceleration stream (CONFIG_ACCEL_STREAM, see logic/rfsimpliciti.h):
+#  (0) button flags | 0x05  (1) sequence  (2) bits 7..6 delta width (0=4, 1=6, 2=8 bits),
+#  bits 3..0 number of samples  (3..5) first sample X/Y/Z  (6..) deltas to the previous
+#  sample, X/Y/Z per sample, two's complement, MSB first
+STREAM_EVENTS = 0x05
+STREAM_SAMPLES = 15
+STREAM_HEADER = 6
+STREAM_MAX_PAYLOAD = 50
+
+
 def startAccessPoint():
     return array.array('B', [0xFF, 0x07, 0x03]).tostring()
 
 def accDataRequest():
     return array.array('B', [0xFF, 0x08, 0x07, 0x00, 0x00, 0x00, 0x00]).tostring()
 
-#Open COM port 6 (check your system info to see which port
-#yours is actually on.)
-#argments are 5 (COM6), 115200 (bit rate), and timeout is set so
-#the serial read function won't loop forever.
-#ser = serial.Serial(5,115200,timeout=1)
-ser = serial.Serial('/dev/ttyACM0',115200,timeout=1)
+def streamDataRequest():
+    return array.array('B', [0xFF, 0x08, 3 + STREAM_MAX_PAYLOAD] + [0x00] * STREAM_MAX_PAYLOAD).tostring()
+
+
+def encode_stream(samples, seq, buttons=0):
+    """Encode up to STREAM_SAMPLES X/Y/Z samples (0..255) like the watch does."""
+    width = 4
+    for prev, cur in zip(samples, samples[1:]):
+        for j in range(3):
+            d = ((cur[j] - prev[j] + 128) & 0xFF) - 128
+            if d < -32 or d > 31:
+                width = 8
+            elif (d < -8 or d > 7) and width < 6:
+                width = 6
+    data = [(buttons << 4) | STREAM_EVENTS, seq & 0xFF, len(samples) | ((width - 4) // 2) << 6]
+    if not samples:
+        return bytearray(data)
+    data += list(samples[0])
+    acc = bits = 0
+    for prev, cur in zip(samples, samples[1:]):
+        for j in range(3):
+            acc = (acc << width) | ((cur[j] - prev[j]) & ((1 << width) - 1))
+            bits += width
+            if bits >= 8:
+                bits -= 8
+                data.append((acc >> bits) & 0xFF)
+    if bits:
+        data.append((acc << (8 - bits)) & 0xFF)
+    return bytearray(data)
+
+
+def decode_stream(data):
+    """Decode a stream packet. Returns (buttons, sequence, [(x, y, z), ...])."""
+    data = bytearray(data)
+    if len(data) < 3 or (data[0] & 0x0F) != STREAM_EVENTS:
+        raise ValueError("not a stream packet")
+    count = data[2] & 0x0F
+    width = 4 + 2 * (data[2] >> 6)
+    if count == 0:
+        return data[0] >> 4, data[1], []
+    xyz = list(data[3:6])
+    samples = [tuple(xyz)]
+    acc = bits = 0
+    pos = STREAM_HEADER
+    for i in range(1, count):
+        for j in range(3):
+            if bits < width:
+                acc = (acc << 8) | data[pos]
+                pos += 1
+                bits += 8
+            bits -= width
+            d = (acc >> bits) & ((1 << width) - 1)
+            if d & (1 << (width - 1)):
+                d -= 1 << width
+            xyz[j] = (xyz[j] + d) & 0xFF
+        samples.append(tuple(xyz))
+    return data[0] >> 4, data[1], samples
+
+
+def selftest(rounds=2000):
+    """Round trip random walks with small, medium and large steps through encoder and decoder."""
+    rnd = random.Random(1)
+    for n in range(rounds):
+        step = rnd.choice((7, 31, 127))
+        count = rnd.randint(0, STREAM_SAMPLES)
+        xyz = [rnd.randint(0, 255) for j in range(3)]
+        samples = []
+        for i in range(count):
+            samples.append(tuple(xyz))
+            xyz = [(v + rnd.randint(-step, step)) & 0xFF for v in xyz]
+        data = encode_stream(samples, n, n & 0x0F)
+        assert len(data) <= STREAM_MAX_PAYLOAD, len(data)
+        buttons, seq, decoded = decode_stream(data)
+        assert buttons == n & 0x0F and seq == n & 0xFF and decoded == samples, (samples, decoded)
+    print("stream format self test passed (%d packets)" % rounds)
+
+
+def read_legacy(ser):
+    while True:
+        #Send request for acceleration data
+        ser.write(accDataRequest())
+        accel = ser.read(7)
+
+        if len(accel) < 3:
+            continue
+        if ord(accel[0]) != 0 and ord(accel[1]) != 0 and ord(accel[2]) != 0:
+            print("x: " + str(ord(accel[0])) + " y: " + str(ord(accel[1])) + " z: " + str(ord(accel[2])))
+
+
+def read_stream(ser):
+    #Needs an access point that forwards the whole packet: 0xFF 0x06 <length> <packet>
+    last = None
+    while True:
+        ser.write(streamDataRequest())
+        reply = bytearray(ser.read(3 + STREAM_MAX_PAYLOAD))
+        if len(reply) < 6:
+            continue
+        try:
+            buttons, seq, samples = decode_stream(reply[3:reply[2]])
+        except (ValueError, IndexError):
+            continue
+        #Button events repeat the last packet
+        if seq == last or not samples:
+            continue
+        if last is not None and seq != (last + 1) & 0xFF:
+            print("lost %d packets" % ((seq - last - 1) & 0xFF))
+        last = seq
+        for x, y, z in samples:
+            print("x: " + str(x) + " y: " + str(y) + " z: " + str(z))
+
+
+def main():
+    if "--selftest" in sys.argv:
+        selftest()
+        return 0
+
+    import serial
 
-#Start access point
-ser.write(startAccessPoint())
+    #Open COM port 6 (check your system info to see which port
+    #yours is actually on.)
+    #argments are 5 (COM6), 115200 (bit rate), and timeout is set so
+    #the serial read function won't loop forever.
+    #ser = serial.Serial(5,115200,timeout=1)
+    ser = serial.Serial('/dev/ttyACM0',115200,timeout=1)
 
+    #Start access point
+    ser.write(startAccessPoint())
 
-while True:
-    #Send request for acceleration data
-    ser.write(accDataRequest())
-    accel = ser.read(7)
+    #--stream reads packed samples from a watch built with CONFIG_ACCEL_STREAM
+    try:
+        if "--stream" in sys.argv:
+            read_stream(ser)
+        else:
+            read_legacy(ser)
+    finally:
+        ser.close()
 
-    if len(accel) < 3:
-        continue
-    if ord(accel[0]) != 0 and ord(accel[1]) != 0 and ord(accel[2]) != 0:
-         print "x: " + str(ord(accel[0])) + " y: " + str(ord(accel[1])) + " z: " + str(ord(accel[2]))
 
-ser.close()
+if __name__ == '__main__':
+    sys.exit(main())
@@ -46,6 +46,9 @@
 #include "adc12.h"
 #include "timer.h"
 
+// logic
+#include "energy.h"
+
 
 // *************************************************************************************************
 // Prototypes section
@@ -175,6 +178,7 @@ interrupt (ADC12_VECTOR) ADC12ISR (void)
 __interrupt void ADC12ISR (void)
 #endif
 {
+  ENERGY_ENTER(ENERGY_ADC12);
   switch(__even_in_range(ADC12IV,34))
   {
   case  0: break;                           // Vector  0:  No interrupt
@@ -201,6 +205,7 @@ __interrupt void ADC12ISR (void)
   case 34: break;                           // Vector 34:  ADC12IFG14
   default: break;
   }
+  ENERGY_EXIT(ENERGY_ADC12);
 }
 
 
@@ -50,6 +50,7 @@
 // logic
 #include "cycle_alarm.h"
 #include "alarm.h"
+#include "energy.h"
 
 
 // *************************************************************************************************
@@ -65,11 +66,13 @@ void countdown_buzzer(void);
 // *************************************************************************************************
 // Global Variable section
 struct buzzer sBuzzer;
+
+// Buzzer on/off cycle timer
+static struct sw_timer buzzer_timer;
  
 
 // *************************************************************************************************
 // Extern section
-//extern u16 timer0_A3_ticks_g;
 
 
 
@@ -118,15 +121,12 @@ void start_buzzer(u8 cycles, u16 on_time, u16 off_time)
 		// Allow buzzer PWM output on P2.7
 		P2SEL |= BIT7;
 
-		// Activate Timer0_A3 periodic interrupts
-		fptr_Timer0_A3_function = toggle_buzzer;
-		Timer0_A3_Start(sBuzzer.on_time);
-
-		// Preload timer advance variable
-		sTimer.timer0_A3_ticks = sBuzzer.off_time;
+		// Activate periodic timer, preload reload value for the following off time
+		sw_timer_start(&buzzer_timer, sBuzzer.on_time, sBuzzer.off_time, toggle_buzzer);
 
 		// Start with buzzer output on
 		sBuzzer.state 	 	= BUZZER_ON_OUTPUT_ENABLED;
+		ENERGY_START(ENERGY_BUZZER);
 	}
 }
 
@@ -156,9 +156,10 @@ void toggle_buzzer(void)
 		
 		// Update buzzer state
 		sBuzzer.state = BUZZER_ON_OUTPUT_DISABLED;
+		ENERGY_STOP(ENERGY_BUZZER);
 		
-		// Reload Timer0_A4 IRQ to restart output
-		sTimer.timer0_A3_ticks = sBuzzer.on_time;
+		// Reload timer to restart output
+		buzzer_timer.period = sBuzzer.on_time;
 	}
 	else // Turn on buzzer
 	{
@@ -177,9 +178,10 @@ void toggle_buzzer(void)
 	
 			// Update buzzer state
 			sBuzzer.state = BUZZER_ON_OUTPUT_ENABLED;
+			ENERGY_START(ENERGY_BUZZER);
 	
-			// Reload Timer0_A4 IRQ to turn off output
-			sTimer.timer0_A3_ticks = sBuzzer.off_time;
+			// Reload timer to turn off output
+			buzzer_timer.period = sBuzzer.off_time;
 		}
 	}
 }
@@ -193,6 +195,8 @@ void toggle_buzzer(void)
 // *************************************************************************************************
 void stop_buzzer(void)
 {
+	ENERGY_STOP(ENERGY_BUZZER);
+	
 	// Stop PWM timer 
 	TA1CTL &= ~(BIT4 | BIT5);
 
@@ -203,8 +207,8 @@ void stop_buzzer(void)
 	// Clear PWM timer interrupt    
 	TA1CCTL0 &= ~CCIE; 
 
-	// Disable periodic start/stop interrupts
-	Timer0_A3_Stop();
+	// Disable periodic start/stop timer
+	sw_timer_stop(&buzzer_timer);
 
 	// Clear variables
 	reset_buzzer();
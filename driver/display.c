@@ -160,18 +160,26 @@ void clear_display(void)
 // *************************************************************************************************
 void clear_line(u8 line)
 {
-	display_chars(switch_seg(line, LCD_SEG_L1_3_0, LCD_SEG_L2_5_0), NULL, SEG_OFF);
+	u8 first, last;
+	u8 * lcdmem;
+	
+	// Line segments and symbols are consecutive in segment tables
 	if (line == LINE1)
 	{
-		display_symbol(LCD_SEG_L1_DP1, SEG_OFF);
-		display_symbol(LCD_SEG_L1_DP0, SEG_OFF);
-		display_symbol(LCD_SEG_L1_COL, SEG_OFF);
+		first = LCD_SEG_L1_3;
+		last  = LCD_SEG_L1_DP0;
 	}
 	else // line == LINE2
 	{
-		display_symbol(LCD_SEG_L2_DP, SEG_OFF);
-		display_symbol(LCD_SEG_L2_COL1, SEG_OFF);
-		display_symbol(LCD_SEG_L2_COL0, SEG_OFF);
+		first = LCD_SEG_L2_5;
+		last  = LCD_SEG_L2_DP;
+	}
+	
+	// Clear visible segments, keep blink memory
+	for (; first <= last; first++)
+	{
+		lcdmem = (u8 *)segments_lcdmem[first];
+		*lcdmem &= ~segments_bitmask[first];
 	}
 }
 
@@ -189,11 +197,8 @@ void write_lcd_mem(u8 * lcdmem, u8 bits, u8 bitmask, u8 state)
 {
 	if (state == SEG_ON)
 	{
-		// Clear segments before writing
-		*lcdmem = (u8)(*lcdmem & ~bitmask);
-	
-		// Set visible segments
-		*lcdmem = (u8)(*lcdmem | bits);
+		// Clear segments and set visible segments in one write
+		*lcdmem = (u8)((*lcdmem & ~bitmask) | bits);
 	}
 	else if (state == SEG_OFF)
 	{
@@ -202,31 +207,20 @@ void write_lcd_mem(u8 * lcdmem, u8 bits, u8 bitmask, u8 state)
 	}
 	else if (state == SEG_ON_BLINK_ON)
 	{
-		// Clear visible / blink segments before writing
-		*lcdmem 		= (u8)(*lcdmem & ~bitmask);
-		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) & ~bitmask);
-	
 		// Set visible / blink segments
-		*lcdmem 		= (u8)(*lcdmem | bits);
-		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) | bits);
+		*lcdmem 		= (u8)((*lcdmem & ~bitmask) | bits);
+		*(lcdmem+0x20) 	= (u8)((*(lcdmem+0x20) & ~bitmask) | bits);
 	}
 	else if (state == SEG_ON_BLINK_OFF)
 	{
-		// Clear visible segments before writing
-		*lcdmem = (u8)(*lcdmem & ~bitmask);
-	
-		// Set visible segments
-		*lcdmem = (u8)(*lcdmem | bits);
-
-		// Clear blink segments
+		// Set visible segments, clear blink segments
+		*lcdmem 		= (u8)((*lcdmem & ~bitmask) | bits);
 		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) & ~bitmask);
 	}
 	else if (state == SEG_OFF_BLINK_OFF)
 	{
-		// Clear segments
-		*lcdmem = (u8)(*lcdmem & ~bitmask);
-
-		// Clear blink segments
+		// Clear visible / blink segments
+		*lcdmem 		= (u8)(*lcdmem & ~bitmask);
 		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) & ~bitmask);
 	}
 }
@@ -419,29 +413,17 @@ void display_symbol(u8 symbol, u8 mode)
 // *************************************************************************************************
 void display_char(u8 segment, u8 chr, u8 mode)
 {
-	u8 * lcdmem;			// Pointer to LCD memory
-	u8 bitmask;			// Bitmask for character
-	u8 bits, bits1;		// Bits to write
+	u8 bits;			// Bits to write
 	
 	// Write to single 7-segment character
 	if ((segment >= LCD_SEG_L1_3) && (segment <= LCD_SEG_L2_DP))
 	{
-		// Get LCD memory address for segment from table
-		lcdmem = (u8 *)segments_lcdmem[segment];
-
-		// Get bitmask for character from table
-		bitmask = segments_bitmask[segment];
-		
-		// Get bits from font set
-		if ((chr >= 0x30) && (chr <= 0x5A)) 
-		{
-			// Use font set
-			bits = lcd_font[chr-0x30];
-		}
-		else if (chr == 0x2D)
+		// Get bits from font set - LINE2 uses nibble-swapped font set, 
+		// because LCD COM/SEG assignment is mirrored against LINE1
+		if ((chr >= LCD_FONT_FIRST) && (chr <= LCD_FONT_LAST)) 
 		{
-			// '-' not in font set
-			bits = BIT1;
+			if (segment >= LCD_SEG_L2_5) 	bits = lcd_font_l2[chr - LCD_FONT_FIRST];
+			else 							bits = lcd_font[chr - LCD_FONT_FIRST];
 		}
 		else
 		{
@@ -449,23 +431,12 @@ void display_char(u8 segment, u8 chr, u8 mode)
 			bits = 0;
 		}
 
-		// When addressing LINE2 7-segment characters need to swap high- and low-nibble,
-		// because LCD COM/SEG assignment is mirrored against LINE1
-		if (segment >= LCD_SEG_L2_5) 
-		{
-			bits1 = ((bits << 4) & 0xF0) | ((bits >> 4) & 0x0F);
-			bits = bits1;
-
-			// When addressing LCD_SEG_L2_5, need to convert ASCII '1' and 'L' to 1 bit,
-			// because LCD COM/SEG assignment is special for this incomplete character
-			if (segment == LCD_SEG_L2_5) 
-			{
-				if ((chr == '1') || (chr == 'L')) bits = BIT7;
-			}
-		}
+		// When addressing LCD_SEG_L2_5, need to convert ASCII '1' and 'L' to 1 bit,
+		// because LCD COM/SEG assignment is special for this incomplete character
+		if ((segment == LCD_SEG_L2_5) && ((chr == '1') || (chr == 'L'))) bits = BIT7;
 		
 		// Physically write to LCD memory		
-		write_lcd_mem(lcdmem, bits, bitmask, mode);
+		write_lcd_mem((u8 *)segments_lcdmem[segment], bits, segments_bitmask[segment], mode);
 	}
 }	
 	
@@ -516,8 +487,8 @@ void display_chars(u8 segments, u8 * str, u8 mode)
 	// Write to consecutive digits
 	for(i=0; i<length; i++)
 	{
-		// Use single character routine to write display memory
-		display_char(char_start+i, *(str+i), mode);
+		// Use single character routine to write display memory (no string = blank characters)
+		display_char(char_start+i, (str != NULL) ? *(str+i) : ' ', mode);
 	}
 }
 
@@ -601,7 +572,7 @@ void set_blink_rate(u8 bits)
 // *************************************************************************************************
 void display_all_off(void)
 {
-	u8 * lcdptr = (u8*)0x0A20;
+	u8 * lcdptr = LCD_MEM_1;
 	u8 i;
 	
 	for (i=1; i<=12; i++) 
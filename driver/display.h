@@ -65,6 +65,7 @@
 
 // Constants defined in library
 extern const u8 lcd_font[];
+extern const u8 lcd_font_l2[];
 extern const u8 * segments_lcdmem[];
 extern const u8 segments_bitmask[];
 extern const u8 itoa_conversion_table[][3];
@@ -145,6 +146,14 @@ extern volatile s_display_flags display;
 #define SEG_F                	(BIT0)
 #define SEG_G                	(BIT1)
 
+// 7-segment character bits for LINE1 and LINE2 (LINE2 COM/SEG assignment is mirrored against LINE1)
+#define LCD_GLYPH_L1(bits)		((u8)(bits))
+#define LCD_GLYPH_L2(bits)		((u8)((((bits) << 4) & 0xF0) | (((bits) >> 4) & 0x0F)))
+
+// First and last character in font tables
+#define LCD_FONT_FIRST			('-')
+#define LCD_FONT_LAST			('Z')
+
 // ------------------------------------------
 // LCD symbols for easier access
 //
@@ -233,18 +242,21 @@ extern volatile s_display_flags display;
 
 
 // LCD controller memory map
-#define LCD_MEM_1          			((u8*)0x0A20)
-#define LCD_MEM_2          			((u8*)0x0A21)
-#define LCD_MEM_3          			((u8*)0x0A22)
-#define LCD_MEM_4          			((u8*)0x0A23)
-#define LCD_MEM_5          			((u8*)0x0A24)
-#define LCD_MEM_6          			((u8*)0x0A25)
-#define LCD_MEM_7          			((u8*)0x0A26)
-#define LCD_MEM_8          	 		((u8*)0x0A27)
-#define LCD_MEM_9          			((u8*)0x0A28)
-#define LCD_MEM_10         			((u8*)0x0A29)
-#define LCD_MEM_11         			((u8*)0x0A2A)
-#define LCD_MEM_12         			((u8*)0x0A2B)
+#ifndef LCD_MEM_BASE
+#define LCD_MEM_BASE				((u8*)0x0A20)
+#endif
+#define LCD_MEM_1          			(LCD_MEM_BASE + 0)
+#define LCD_MEM_2          			(LCD_MEM_BASE + 1)
+#define LCD_MEM_3          			(LCD_MEM_BASE + 2)
+#define LCD_MEM_4          			(LCD_MEM_BASE + 3)
+#define LCD_MEM_5          			(LCD_MEM_BASE + 4)
+#define LCD_MEM_6          			(LCD_MEM_BASE + 5)
+#define LCD_MEM_7          			(LCD_MEM_BASE + 6)
+#define LCD_MEM_8          			(LCD_MEM_BASE + 7)
+#define LCD_MEM_9          			(LCD_MEM_BASE + 8)
+#define LCD_MEM_10         			(LCD_MEM_BASE + 9)
+#define LCD_MEM_11         			(LCD_MEM_BASE + 10)
+#define LCD_MEM_12         			(LCD_MEM_BASE + 11)
 
 
 // Memory assignment
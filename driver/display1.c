@@ -58,58 +58,63 @@
 // *************************************************************************************************
 // Global Variable section
 
-// Table with memory bit assignment for digits "0" to "9" and characters "A" to "Z"
+// Table with memory bit assignment for "-", digits "0" to "9" and characters "A" to "Z"
 //   A
 // F   B
 //   G
 // E   C
 //   D
-const u8 lcd_font[] =
-{
-  SEG_A+SEG_B+SEG_C+SEG_D+SEG_E+SEG_F,           // Displays "0"
-        SEG_B+SEG_C,                             // Displays "1"
-  SEG_A+SEG_B+      SEG_D+SEG_E+      SEG_G,     // Displays "2"
-  SEG_A+SEG_B+SEG_C+SEG_D+            SEG_G,     // Displays "3"
-        SEG_B+SEG_C+            SEG_F+SEG_G,     // Displays "4"
-  SEG_A+      SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "5"
-  SEG_A+      SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "6"
-  SEG_A+SEG_B+SEG_C,                             // Displays "7"
-  SEG_A+SEG_B+SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "8"
-  SEG_A+SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "9"
-  0                                        ,     // Displays " " (:)
-  0                                        ,     // Displays " " (;)
-  SEG_A+                        SEG_F+SEG_G,     // Displays "<" as high c
-                    SEG_D+            SEG_G,     // Displays "="
-  0                                        ,     // Displays " " (>)
-  SEG_A+SEG_B+            SEG_E+      SEG_G,     // Displays "?"
-  0                                        ,     // Displays " " (@)
-  SEG_A+SEG_B+SEG_C+      SEG_E+SEG_F+SEG_G,     // Displays "A"
-              SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "b"
-                    SEG_D+SEG_E+      SEG_G,     // Displays "c"
-        SEG_B+SEG_C+SEG_D+SEG_E+      SEG_G,     // Displays "d"
-  SEG_A+           +SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "E"
-  SEG_A+                  SEG_E+SEG_F+SEG_G,     // Displays "f"
-  SEG_A+SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "g" same as 9
-              SEG_C+      SEG_E+SEG_F+SEG_G,     // Displays "h"
-                          SEG_E            ,     // Displays "i"
-  SEG_A+SEG_B+SEG_C+SEG_D                  ,     // Displays "J"
-  		     		SEG_D+      SEG_F+SEG_G,     // Displays "k"
-                    SEG_D+SEG_E+SEG_F      ,     // Displays "L"
-  SEG_A+SEG_B+SEG_C+      SEG_E+SEG_F      ,     // Displays "M"
-              SEG_C+      SEG_E+      SEG_G,     // Displays "n"
-              SEG_C+SEG_D+SEG_E+      SEG_G,     // Displays "o"
-  SEG_A+SEG_B+            SEG_E+SEG_F+SEG_G,     // Displays "P"
-  SEG_A+SEG_B+SEG_C+            SEG_F+SEG_G,     // Displays "q"
-                          SEG_E+      SEG_G,     // Displays "r"
-  SEG_A+      SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "S" same as 5
-                    SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "t"
-              SEG_C+SEG_D+SEG_E            ,     // Displays "u"
-              SEG_C+SEG_D+SEG_E            ,     // Displays "v" same as u
-        SEG_B+SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "W"
-        SEG_B+SEG_C+     +SEG_E+SEG_F+SEG_G,     // Displays "X" as H
-        SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "Y"
-  SEG_A+SEG_B+      SEG_D+SEG_E+      SEG_G,     // Displays "Z" same as 2
-};
+// Expanded twice: LINE1 glyphs and LINE2 glyphs (LINE2 COM/SEG assignment is nibble-swapped)
+#define LCD_FONT(glyph) \
+	glyph(                                    SEG_G),     /* Displays "-" */ \
+	glyph(0                                        ),     /* Displays " " (.) */ \
+	glyph(0                                        ),     /* Displays " " (/) */ \
+	glyph(SEG_A+SEG_B+SEG_C+SEG_D+SEG_E+SEG_F      ),     /* Displays "0" */ \
+	glyph(      SEG_B+SEG_C                        ),     /* Displays "1" */ \
+	glyph(SEG_A+SEG_B+      SEG_D+SEG_E+      SEG_G),     /* Displays "2" */ \
+	glyph(SEG_A+SEG_B+SEG_C+SEG_D+            SEG_G),     /* Displays "3" */ \
+	glyph(      SEG_B+SEG_C+            SEG_F+SEG_G),     /* Displays "4" */ \
+	glyph(SEG_A+      SEG_C+SEG_D+      SEG_F+SEG_G),     /* Displays "5" */ \
+	glyph(SEG_A+      SEG_C+SEG_D+SEG_E+SEG_F+SEG_G),     /* Displays "6" */ \
+	glyph(SEG_A+SEG_B+SEG_C                        ),     /* Displays "7" */ \
+	glyph(SEG_A+SEG_B+SEG_C+SEG_D+SEG_E+SEG_F+SEG_G),     /* Displays "8" */ \
+	glyph(SEG_A+SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G),     /* Displays "9" */ \
+	glyph(0                                        ),     /* Displays " " (:) */ \
+	glyph(0                                        ),     /* Displays " " (;) */ \
+	glyph(SEG_A+                        SEG_F+SEG_G),     /* Displays "<" as high c */ \
+	glyph(                  SEG_D+            SEG_G),     /* Displays "=" */ \
+	glyph(0                                        ),     /* Displays " " (>) */ \
+	glyph(SEG_A+SEG_B+            SEG_E+      SEG_G),     /* Displays "?" */ \
+	glyph(0                                        ),     /* Displays " " (@) */ \
+	glyph(SEG_A+SEG_B+SEG_C+      SEG_E+SEG_F+SEG_G),     /* Displays "A" */ \
+	glyph(            SEG_C+SEG_D+SEG_E+SEG_F+SEG_G),     /* Displays "b" */ \
+	glyph(                  SEG_D+SEG_E+      SEG_G),     /* Displays "c" */ \
+	glyph(      SEG_B+SEG_C+SEG_D+SEG_E+      SEG_G),     /* Displays "d" */ \
+	glyph(SEG_A+           +SEG_D+SEG_E+SEG_F+SEG_G),     /* Displays "E" */ \
+	glyph(SEG_A+                  SEG_E+SEG_F+SEG_G),     /* Displays "f" */ \
+	glyph(SEG_A+SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G),     /* Displays "g" same as 9 */ \
+	glyph(            SEG_C+      SEG_E+SEG_F+SEG_G),     /* Displays "h" */ \
+	glyph(                        SEG_E            ),     /* Displays "i" */ \
+	glyph(SEG_A+SEG_B+SEG_C+SEG_D                  ),     /* Displays "J" */ \
+	glyph(                  SEG_D+      SEG_F+SEG_G),     /* Displays "k" */ \
+	glyph(                  SEG_D+SEG_E+SEG_F      ),     /* Displays "L" */ \
+	glyph(SEG_A+SEG_B+SEG_C+      SEG_E+SEG_F      ),     /* Displays "M" */ \
+	glyph(            SEG_C+      SEG_E+      SEG_G),     /* Displays "n" */ \
+	glyph(            SEG_C+SEG_D+SEG_E+      SEG_G),     /* Displays "o" */ \
+	glyph(SEG_A+SEG_B+            SEG_E+SEG_F+SEG_G),     /* Displays "P" */ \
+	glyph(SEG_A+SEG_B+SEG_C+            SEG_F+SEG_G),     /* Displays "q" */ \
+	glyph(                        SEG_E+      SEG_G),     /* Displays "r" */ \
+	glyph(SEG_A+      SEG_C+SEG_D+      SEG_F+SEG_G),     /* Displays "S" same as 5 */ \
+	glyph(                  SEG_D+SEG_E+SEG_F+SEG_G),     /* Displays "t" */ \
+	glyph(            SEG_C+SEG_D+SEG_E            ),     /* Displays "u" */ \
+	glyph(            SEG_C+SEG_D+SEG_E            ),     /* Displays "v" same as u */ \
+	glyph(      SEG_B+SEG_C+SEG_D+SEG_E+SEG_F+SEG_G),     /* Displays "W" */ \
+	glyph(      SEG_B+SEG_C+     +SEG_E+SEG_F+SEG_G),     /* Displays "X" as H */ \
+	glyph(      SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G),     /* Displays "Y" */ \
+	glyph(SEG_A+SEG_B+      SEG_D+SEG_E+      SEG_G),     /* Displays "Z" same as 2 */
+
+const u8 lcd_font[]    = { LCD_FONT(LCD_GLYPH_L1) };
+const u8 lcd_font_l2[] = { LCD_FONT(LCD_GLYPH_L2) };
 
 
 // Table with memory address for each display element 
@@ -5,6 +5,10 @@
  * For some reason inline combination of this code tends to be messed up by the
  * msp430-gcc compiler, so we stick with the call overhead.
  *
+ * All routines are integer only. Multiplications are 16x16->32 bit, which is a single
+ * operation of the hardware multiplier, so no libgcc float or 64 bit code is pulled in.
+ * Only atan2_brad divides (once).
+ *
  *  Created on: Aug 5, 2010
  *      Author: Niek Lambert
  */
@@ -46,3 +50,259 @@ s16 mult_scale15(s16 a, s16 b)
 	ff <<= 1;
 	return (s16)((ff + HALF) >> 16);
 }
+
+
+// *************************************************************************************************
+// @fn          sat16
+// @brief       Saturate to 16 bits
+// @param       a value
+// @return      a limited to -32768..32767
+// *************************************************************************************************
+s16 sat16(s32 a)
+{
+	if (a > 32767) return 32767;
+	if (a < -32768) return -32768;
+	return (s16)a;
+}
+
+
+// *************************************************************************************************
+// @fn          sat_add16
+// @brief       Saturating addition
+// @param       a operand 1
+// @param       b operand 2
+// @return      a + b limited to -32768..32767
+// *************************************************************************************************
+s16 sat_add16(s16 a, s16 b)
+{
+	return sat16((s32)a + b);
+}
+
+
+// *************************************************************************************************
+// @fn          sat_sub16
+// @brief       Saturating subtraction
+// @param       a operand 1
+// @param       b operand 2
+// @return      a - b limited to -32768..32767
+// *************************************************************************************************
+s16 sat_sub16(s16 a, s16 b)
+{
+	return sat16((s32)a - b);
+}
+
+
+// *************************************************************************************************
+// @fn          iir1_filter
+// @brief       First order IIR (exponential average) y += alpha * (x - y).
+//				The difference is saturated to 16 bits, so steps larger than 32767 take more 
+//				than one call.
+// @param       y previous output
+// @param       x new input
+// @param       alpha weight of new input, Q15 (e.g. DSP_Q15(0.2))
+// @return      new output
+// *************************************************************************************************
+s32 iir1_filter(s32 y, s32 x, s16 alpha)
+{
+	return y + mult_scale15(sat16(x - y), alpha);
+}
+
+
+// *************************************************************************************************
+// @fn          step_filter
+// @brief       Move y towards x by at most step (slew rate limiter)
+// @param       y previous output
+// @param       x new input
+// @param       step maximum change
+// @return      new output
+// *************************************************************************************************
+s32 step_filter(s32 y, s32 x, u16 step)
+{
+	if (x > y + step) return y + step;
+	if (x < y - step) return y - step;
+	return x;
+}
+
+
+// *************************************************************************************************
+// @fn          biquad_filter
+// @brief       Second order IIR, direct form I with 32 bit accumulator.
+//				y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2, coefficients Q14.
+// @param       f filter coefficients and state
+// @param       x new input
+// @return      new output (saturated)
+// *************************************************************************************************
+s16 biquad_filter(struct biquad * f, s16 x)
+{
+	s32 acc;
+	s16 y;
+	
+	acc  = (s32)f->b0 * x;
+	acc += (s32)f->b1 * f->x1;
+	acc += (s32)f->b2 * f->x2;
+	acc -= (s32)f->a1 * f->y1;
+	acc -= (s32)f->a2 * f->y2;
+	y = sat16((acc + ((s32)1 << 13)) >> 14);
+	
+	f->x2 = f->x1;
+	f->x1 = x;
+	f->y2 = f->y1;
+	f->y1 = y;
+	return y;
+}
+
+
+// *************************************************************************************************
+// @fn          moving_avg_init
+// @brief       Set up moving average and fill it with one value
+// @param       f filter state
+// @param       buf buffer of 2^shift samples
+// @param       shift log2 of window length
+// @param       x initial value
+// @return      none
+// *************************************************************************************************
+void moving_avg_init(struct moving_avg * f, s16 * buf, u8 shift, s16 x)
+{
+	u8 i;
+	
+	f->buf   = buf;
+	f->shift = shift;
+	f->pos   = 0;
+	f->sum   = (s32)x << shift;
+	for (i = 0; i < (1u << shift); i++) buf[i] = x;
+}
+
+
+// *************************************************************************************************
+// @fn          moving_avg_filter
+// @brief       Add sample to moving average (running sum, no loop over the window)
+// @param       f filter state
+// @param       x new input
+// @return      rounded average of the last 2^shift samples
+// *************************************************************************************************
+s16 moving_avg_filter(struct moving_avg * f, s16 x)
+{
+	f->sum += (s32)x - f->buf[f->pos];
+	f->buf[f->pos] = x;
+	f->pos = (f->pos + 1) & ((1u << f->shift) - 1);
+	
+	if (f->shift == 0) return x;
+	return (s16)((f->sum + ((s32)1 << (f->shift - 1))) >> f->shift);
+}
+
+
+// *************************************************************************************************
+// @fn          moving_avg_min
+// @brief       Minimum of the samples in the moving average window
+// @param       f filter state
+// @return      minimum
+// *************************************************************************************************
+s16 moving_avg_min(const struct moving_avg * f)
+{
+	s16 min = f->buf[0];
+	u8 i;
+	
+	for (i = 1; i < (1u << f->shift); i++)
+	{
+		if (f->buf[i] < min) min = f->buf[i];
+	}
+	return min;
+}
+
+
+// *************************************************************************************************
+// @fn          moving_avg_max
+// @brief       Maximum of the samples in the moving average window
+// @param       f filter state
+// @return      maximum
+// *************************************************************************************************
+s16 moving_avg_max(const struct moving_avg * f)
+{
+	s16 max = f->buf[0];
+	u8 i;
+	
+	for (i = 1; i < (1u << f->shift); i++)
+	{
+		if (f->buf[i] > max) max = f->buf[i];
+	}
+	return max;
+}
+
+
+// *************************************************************************************************
+// @fn          median3
+// @brief       Median of three values, removes single sample spikes
+// @param       a, b, c values
+// @return      median
+// *************************************************************************************************
+s16 median3(s16 a, s16 b, s16 c)
+{
+	if (a > b)
+	{
+		if (b > c) return b;
+		return (a > c) ? c : a;
+	}
+	if (a > c) return a;
+	return (b > c) ? c : b;
+}
+
+
+// *************************************************************************************************
+// @fn          isqrt32
+// @brief       Integer square root (bitwise, shifts and adds only)
+// @param       a radicand
+// @return      floor(sqrt(a))
+// *************************************************************************************************
+u16 isqrt32(u32 a)
+{
+	u32 res = 0;
+	u32 bit = (u32)1 << 30;
+	
+	while (bit > a) bit >>= 2;
+	
+	while (bit != 0)
+	{
+		if (a >= res + bit)
+		{
+			a -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (u16)res;
+}
+
+
+// *************************************************************************************************
+// @fn          atan2_brad
+// @brief       Angle of vector (x, y). The octant is reduced to atan(t), 0 <= t <= 1, which is 
+//				approximated by pi/4*t + t*(1-t)*(0.2447+0.0663*t) (error < 0.1 deg).
+// @param       y y component
+// @param       x x component
+// @return      angle in binary radians: 0 = +x, DSP_BRAD_90 = +y, DSP_BRAD_180 = -x
+// *************************************************************************************************
+s16 atan2_brad(s16 y, s16 x)
+{
+	u16 ax = (x < 0) ? -(u16)x : (u16)x;
+	u16 ay = (y < 0) ? -(u16)y : (u16)y;
+	u16 t, a;
+	
+	if ((ax | ay) == 0) return 0;
+	
+	// t = min / max in Q15
+	if (ay <= ax)	t = (u16)(((u32)ay << 15) / ax);
+	else			t = (u16)(((u32)ax << 15) / ay);
+	
+	// 8192*t + t*(1-t)*(2552 + 691*t), 32768 brad = pi
+	a = (u16)(((u32)t * (32768u - t)) >> 15);
+	a = (t >> 2) + (u16)(((u32)a * (2552u + (u16)(((u32)691 * t) >> 15))) >> 15);
+	
+	if (ay > ax) a = 16384u - a;
+	if (x < 0) a = 32768u - a;
+	if (y < 0) a = -a;
+	return (s16)a;
+}
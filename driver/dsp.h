@@ -12,9 +12,58 @@
 // Include section
 #include "project.h"
 
+// *************************************************************************************************
+// Defines section
+
+// Q15 constant from a number in [-1, 1), evaluated by the compiler
+#define DSP_Q15(x)			((s16)((x) * 32768.0 + ((x) < 0 ? -0.5 : 0.5)))
+// Q14 constant from a number in [-2, 2), used for biquad coefficients
+#define DSP_Q14(x)			((s16)((x) * 16384.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+// Full circle for atan2_brad (binary radians, 0x8000 = 180 deg)
+#define DSP_BRAD_180		(-32768)
+#define DSP_BRAD_90			(16384)
+
+// Biquad filter (direct form I), coefficients Q14, a0 = 1
+struct biquad
+{
+	s16		b0, b1, b2;
+	s16		a1, a2;
+	s16		x1, x2;
+	s16		y1, y2;
+};
+
+// Moving average over 2^shift samples in a buffer provided by the caller
+struct moving_avg
+{
+	s16 *	buf;
+	u8		shift;
+	u8		pos;
+	s32		sum;
+};
+
 // *************************************************************************************************
 // Prototypes section
 extern s16 mult_scale16(s16 a, s16 b); // returns (s16)((s32)a*b + 0x8000) >> 16
 extern s16 mult_scale15(s16 a, s16 b); // returns (s16)(((s32)a*b << 1) + 0x8000) >> 16
 
+// Saturating arithmetic
+extern s16 sat16(s32 a);
+extern s16 sat_add16(s16 a, s16 b);
+extern s16 sat_sub16(s16 a, s16 b);
+
+// Filters
+extern s32 iir1_filter(s32 y, s32 x, s16 alpha);
+extern s32 step_filter(s32 y, s32 x, u16 step);
+extern s16 biquad_filter(struct biquad * f, s16 x);
+extern void moving_avg_init(struct moving_avg * f, s16 * buf, u8 shift, s16 x);
+extern s16 moving_avg_filter(struct moving_avg * f, s16 x);
+extern s16 moving_avg_min(const struct moving_avg * f);
+extern s16 moving_avg_max(const struct moving_avg * f);
+extern s16 median3(s16 a, s16 b, s16 c);
+
+// Integer math
+extern u16 isqrt32(u32 a);
+extern s16 atan2_brad(s16 y, s16 x);
+
 #endif /*DSP_H_*/
@@ -0,0 +1,183 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+// Main flash erase and write functions. Code runs from flash, the CPU is held while the flash
+// controller is busy.
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+
+// system
+#include "project.h"
+#include <stdint.h>
+
+// driver
+#include "flash.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+void flash_erase_segment(u16 * segment);
+void flash_write(u16 * dest, const u16 * data, u16 words);
+static void flash_wait_busy(void);
+
+
+// *************************************************************************************************
+// Defines section
+
+
+// *************************************************************************************************
+// Global Variable section
+
+
+// *************************************************************************************************
+// Extern section
+
+
+// *************************************************************************************************
+// @fn          flash_wait_busy
+// @brief       Wait until flash controller has finished.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void flash_wait_busy(void)
+{
+	while (FCTL3 & BUSY);
+}
+
+
+// *************************************************************************************************
+// @fn          flash_erase_segment
+// @brief       Erase one main flash segment (takes ~25 ms).
+// @param       u16 * segment		Start address of segment
+// @return      none
+// *************************************************************************************************
+void flash_erase_segment(u16 * segment)
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	// Interrupt vectors must not be fetched while flash is erased
+	__disable_interrupt();
+	
+	#ifdef USE_WATCHDOG
+	// Hold watchdog timer
+	WDTCTL = (WDTCTL & 0xff) | WDTPW | WDTHOLD;
+	#endif
+	
+	flash_wait_busy();
+	
+	// Clear LOCK, select segment erase, dummy write starts erase
+	FCTL3 = FWKEY;
+	FCTL1 = FWKEY | ERASE;
+	*segment = 0;
+	flash_wait_busy();
+	
+	// Set LOCK
+	FCTL1 = FWKEY;
+	FCTL3 = FWKEY | LOCK;
+	
+	#ifdef USE_WATCHDOG
+	// Restart and reset watchdog timer
+	WDTCTL = (WDTCTL & 0xff & ~WDTHOLD) | WDTPW | WDTCNTCL;
+	#endif
+	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          flash_write
+// @brief       Write erased flash. Full long words are written in long-word mode, which halves the 
+//				programming time. Words that are still erased in data are skipped.
+// @param       u16 * dest			Flash address (word aligned)
+//				const u16 * data	Data
+//				u16 words			Number of words
+// @return      none
+// *************************************************************************************************
+void flash_write(u16 * dest, const u16 * data, u16 words)
+{
+	istate_t int_state = __get_interrupt_state();
+	u16 i = 0;
+	
+	__disable_interrupt();
+	
+	#ifdef USE_WATCHDOG
+	// Hold watchdog timer
+	WDTCTL = (WDTCTL & 0xff) | WDTPW | WDTHOLD;
+	#endif
+	
+	flash_wait_busy();
+	FCTL3 = FWKEY;
+	
+	// Long-word writes need a 4 byte aligned address
+	if (((uintptr_t)dest & 2) && (words > 0))
+	{
+		FCTL1 = FWKEY | WRT;
+		if (data[0] != 0xFFFF) dest[0] = data[0];
+		flash_wait_busy();
+		i = 1;
+	}
+	
+	FCTL1 = FWKEY | BLKWRT;
+	for (; i + 1 < words; i += 2)
+	{
+		if ((data[i] != 0xFFFF) || (data[i+1] != 0xFFFF))
+		{
+			dest[i]   = data[i];
+			dest[i+1] = data[i+1];
+			flash_wait_busy();
+		}
+	}
+	
+	// Trailing single word
+	if (i < words)
+	{
+		FCTL1 = FWKEY | WRT;
+		if (data[i] != 0xFFFF) dest[i] = data[i];
+		flash_wait_busy();
+	}
+	
+	// Set LOCK
+	FCTL1 = FWKEY;
+	FCTL3 = FWKEY | LOCK;
+	
+	#ifdef USE_WATCHDOG
+	// Restart and reset watchdog timer
+	WDTCTL = (WDTCTL & 0xff & ~WDTHOLD) | WDTPW | WDTCNTCL;
+	#endif
+	
+	__set_interrupt_state(int_state);
+}
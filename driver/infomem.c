@@ -13,10 +13,21 @@
 
 struct infomem sInfomem;
 
-void infomem_write_flash_segment(u16* start, u16* data, u8 erase);
-void infomem_insert_delete_modify(u16* start, u16* data, u8 del_count, u8 ins_count, u16** mod_addr, u16* mod_data, u8 mod_count, u16* free_start, u16* free_stop);
-void infomem_write_data(u16* start, u16* data, u8 count);
-u16* infomem_get_app_addr(u8 identifier);
+void infomem_flash_unlock(u16* segment);
+void infomem_flash_lock(void);
+u16* infomem_segment_addr(u8 segment);
+u8 infomem_segment_first(void);
+u8 infomem_segment_blank(u8 segment);
+u8 infomem_free_segments(void);
+u8 infomem_next_free_segment(void);
+void infomem_erase_segment(u8 segment);
+void infomem_open_segment(u8 segment, u16 flags);
+u16* infomem_append(u8 identifier, u8 count, u16* old, u16* data, u8 offset, u8 data_count);
+void infomem_compact(u8 segment, struct infomem_app* skip);
+void infomem_compact_done(void);
+s16 infomem_scan_segment(u8 segment);
+struct infomem_app* infomem_get_app(u8 identifier);
+s16 infomem_write_record(u8 identifier, u16* data, u8 count, u8 offset, u8 data_count);
 
 #define infomem_waitbusy() \
 	while(1) \
@@ -25,30 +36,10 @@ u16* infomem_get_app_addr(u8 identifier);
 			break; \
 	}
 
-// write one complete flash segment
+// unlock flash for writing to or erasing segment
 //        FOR INTERNAL USE ONLY
-//
-// erases segment when needed. Only writes to a long word if data has changed
-//data has size of at least 128 Byte
-//erase 0: do not erase; 1: test if need to erase; 2: erase without test
-void infomem_write_flash_segment(u16* start, u16* data, u8 erase)
+void infomem_flash_unlock(u16* segment)
 {
-	int i;
-	
-	//check if we need to erase
-	if(erase ==1)
-	{
-		for(i=0; i <INFOMEM_SEGMENT_WORDS; i++)
-		{
-			//we have to erase if the new data has bits 1 that are 0 already
-			if( ( start[i] | data[i] ) != start[i])
-			{
-				erase=2;
-				break;
-			}
-		}
-	}
-	
 	#ifdef USE_WATCHDOG
 	//hold watch dog timer
 	WDTCTL = (WDTCTL &0xff) | WDTPW | WDTHOLD;
@@ -57,7 +48,7 @@ void infomem_write_flash_segment(u16* start, u16* data, u8 erase)
 	infomem_waitbusy()
 	
 	//remove LOCK and LOCKA bit if needed (LOCKA is toggled if it is written as 1)
-	if(start == (u16*)INFOMEM_A && (FCTL3 & LOCKA))
+	if(segment == (u16*)INFOMEM_A && (FCTL3 & LOCKA))
 	{
 		FCTL3 = FWKEY | LOCKA;
 	}
@@ -68,35 +59,19 @@ void infomem_write_flash_segment(u16* start, u16* data, u8 erase)
 	
 	//remove LOCKINFO bit
 	FCTL4 = FWKEY ;
-	
-	if(erase==2)
-	{
-	FCTL1 = FWKEY | ERASE;
-	*start = 0;
-	infomem_waitbusy()
-	}
-	
-	//set long-word write mode
-	FCTL1 = FWKEY | BLKWRT;
-	
-	//write long words if the new data is different from the old
-	for(i=0; i< INFOMEM_SEGMENT_WORDS; i+=2)
-	{
-		if(start[i] != data[i] || start[i+1] != data[i+1] )
-		{
-			start[i  ] = data[i  ];
-			start[i+1] = data[i+1];
-			infomem_waitbusy()
-		}
-	}
-	
+}
+
+// lock flash after infomem_flash_unlock
+//        FOR INTERNAL USE ONLY
+void infomem_flash_lock(void)
+{
 	//leave write mode
 	FCTL1 = FWKEY;
 	//set LOCKINFO bit
 	FCTL4 = FWKEY | (FCTL4 & 0xff) | LOCKINFO;
 	
-	//set LOCK bit
-	FCTL3 = FWKEY | (FCTL3 & 0xff) | LOCK;
+	//set LOCK bit and LOCKA bit if it was removed (LOCKA is toggled if it is written as 1)
+	FCTL3 = FWKEY | LOCK | (~FCTL3 & LOCKA);
 	
 	#ifdef USE_WATCHDOG
 	//restart and reset watchdog timer
@@ -104,227 +79,394 @@ void infomem_write_flash_segment(u16* start, u16* data, u8 erase)
 	#endif
 }
 
+//return address of segment (0 = INFOMEM_D)
+u16* infomem_segment_addr(u8 segment)
+{
+	return (u16*)INFOMEM_START + segment*INFOMEM_SEGMENT_WORDS;
+}
 
-//write count words at address start
-void infomem_write_data(u16* start, u16* data, u8 count)
+//return number of first segment of managed memory
+u8 infomem_segment_first(void)
 {
-	infomem_insert_delete_modify(start, data, count, count, NULL, NULL, 0, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
+	return ((u8*)sInfomem.startaddr - (u8*)INFOMEM_START)/INFOMEM_SEGMENT_SIZE;
 }
 
-// function to do nearly anything with memory
-//
-//        FOR INTERNAL USE ONLY
-//
-// mod_addr[n] < mod_addr[n+1]
-// the mod always precedes data (data is not read in that case and can point to invalid memory location)
-// mod_addr<free_start+ins_count-del_count
-// when data is NULL and ins_count>0, INFOMEM_ERASED_WORD will be inserted instead
-// memory right of free_stop is never changed
-// free_start is the first address after the meaningful data (BEFORE any insert or delete)
-// mod_addr are addresses AFTER the insert/delete
-void infomem_insert_delete_modify(u16* start, u16* data, u8 del_count, u8 ins_count, u16** mod_addr, u16* mod_data, u8 mod_count, u16* free_start, u16* free_stop)
+//check if segment is completely erased
+u8 infomem_segment_blank(u8 segment)
 {
+	u16* addr=infomem_segment_addr(segment);
 	int i;
-	u8 next_mod;
-	int more=ins_count-del_count;
-	
-	//beginning of segment that is the first (address wise) to be modified
-	u16* segment_first;
-	//beginning of the segment that is the last (address wise) to be modified
-	u16* segment_last;
 	
-	//find first modified flash segment
-	if((mod_count>0) && (mod_addr[0]< start))
+	for(i=0; i<INFOMEM_SEGMENT_WORDS; i++)
 	{
-		segment_first=(u16*)((u16) mod_addr[0] & ~(INFOMEM_SEGMENT_SIZE-1));
+		if(addr[i] != INFOMEM_ERASED_WORD)
+		{
+			return 0;
+		}
 	}
-	else
+	return 1;
+}
+
+//return number of managed segments without current records
+u8 infomem_free_segments(void)
+{
+	u8 segment, first=infomem_segment_first();
+	u8 count=0;
+	
+	for(segment=first; segment<first+sInfomem.segments; segment++)
 	{
-		segment_first=(u16*)((u16) start & ~(INFOMEM_SEGMENT_SIZE-1));
+		if(!(sInfomem.live & (1<<segment)))
+		{
+			count++;
+		}
 	}
+	return count;
+}
+
+//return next segment without current records following the head segment in the ring
+u8 infomem_next_free_segment(void)
+{
+	u8 first=infomem_segment_first();
+	u8 segment=sInfomem.head;
+	u8 i;
 	
-	//find last modified flash segment
-	if(more==0)
+	for(i=0; i<sInfomem.segments; i++)
 	{
-		if((mod_count>0) && (mod_addr[mod_count-1]>=start+ins_count))
+		if(++segment >= first+sInfomem.segments)
 		{
-			segment_last= (u16*)((u16) mod_addr[mod_count-1] & ~(INFOMEM_SEGMENT_SIZE-1));
+			segment=first;
 		}
-		else
+		if(!(sInfomem.live & (1<<segment)))
 		{
-			segment_last= (u16*)((u16) (start+ins_count-1) & ~(INFOMEM_SEGMENT_SIZE-1));
+			return segment;
 		}
 	}
-	else if(more>0)
+	return 0xFF;
+}
+
+// erase one flash segment
+//        FOR INTERNAL USE ONLY
+void infomem_erase_segment(u8 segment)
+{
+	u16* addr=infomem_segment_addr(segment);
+	
+	infomem_flash_unlock(addr);
+	
+	//invalidate header first, a partly erased segment must not look valid after power fail
+	if(*addr != 0)
 	{
-		segment_last= (u16*)((u16) (free_start+more-1) & ~(INFOMEM_SEGMENT_SIZE-1));
+		FCTL1 = FWKEY | WRT;
+		*addr = 0;
+		infomem_waitbusy()
 	}
-	else  //more<0
+	
+	FCTL1 = FWKEY | ERASE;
+	*addr = 0;
+	infomem_waitbusy()
+	
+	infomem_flash_lock();
+	
+	sInfomem.live &= ~(1<<segment);
+}
+
+// start new head segment of the log
+//        FOR INTERNAL USE ONLY
+//
+// flags INFOMEM_CONTINUED|INFOMEM_OPEN: next segment of the log
+//       INFOMEM_OPEN: base segment, records are copied next
+//       0: empty base segment
+void infomem_open_segment(u8 segment, u16 flags)
+{
+	u16* addr=infomem_segment_addr(segment);
+	
+	//segment left over by compaction and not erased in the background yet
+	if(!infomem_segment_blank(segment))
 	{
-		segment_last= (u16*)((u16) (free_start-1) & ~(INFOMEM_SEGMENT_SIZE-1));
+		infomem_erase_segment(segment);
 	}
 	
-	//we need buffer memory to store a flash page while it is erased and rewritten
-	u16 buf[INFOMEM_SEGMENT_WORDS];
+	sInfomem.sequence++;
+	sInfomem.head=segment;
+	sInfomem.free=addr+INFOMEM_HEADER_WORDS;
+	sInfomem.live |= 1<<segment;
+	
+	infomem_flash_unlock(addr);
+	FCTL1 = FWKEY | WRT;
+	
+	//sequence word first, a valid identifier word implies a valid sequence word
+	addr[1] = sInfomem.sequence | (infomem_segment_first()<<INFOMEM_FIRST_SHIFT) | ((sInfomem.segments-1)<<INFOMEM_SEGMENTS_SHIFT) | flags;
+	infomem_waitbusy()
+	addr[0] = INFOMEM_IDENTIFIER;
+	infomem_waitbusy()
+	
+	infomem_flash_lock();
+}
+
+// append record at the end of the head segment, the caller has to make sure it fits
+//        FOR INTERNAL USE ONLY
+//
+// data_count words of data are written at offset, all other words are copied from old
+// the terminator is written last and marks the record valid
+// returns address of the first data word of the record
+u16* infomem_append(u8 identifier, u8 count, u16* old, u16* data, u8 offset, u8 data_count)
+{
+	u16* addr=sInfomem.free;
+	u8 i;
+	
+	infomem_flash_unlock(addr);
+	FCTL1 = FWKEY | WRT;
 	
-	//position of the newly to insert data relative to the beginning of the segment
-	int data_offset;
+	addr[0] = identifier | (count<<8);
+	infomem_waitbusy()
 	
-	//we insert data, so start with the last segment and make your way to the beginning
-	if(more>0)
+	for(i=0; i<count; i++)
 	{
-		//start with the last mod
-		next_mod=mod_count;
-		//while we have not processed all modified flash segments
-		while(segment_first<=segment_last)
+		if(i >= offset && i < offset+data_count)
 		{
-			data_offset=((u16)start - (u16)segment_last)/2;
-			
-			for(i=INFOMEM_SEGMENT_WORDS-1;i>=0;i--)
-			{
-				//data we need to preserve
-				if( (segment_last+i) >= free_stop)
-				{
-					buf[i]=segment_last[i];
-				}
-				//data to change with single modify
-				else if( next_mod!=0 && (segment_last+i) == mod_addr[next_mod-1] )
-				{
-					buf[i] = mod_data[next_mod-1];
-					next_mod --;
-				}
-				//data we do not care about (leave erased)
-				else if( (segment_last+i) >= (free_start+more))
-				{
-					buf[i]=INFOMEM_ERASED_WORD;
-				}
-				//data not to change
-				else if((segment_last+i) < start)
-				{
-					buf[i]=segment_last[i];
-				}
-				//data following the data we insert
-				else if( (segment_last+i) >= (start+ins_count))
-				{
-					buf[i]=segment_last[i-more];
-				}
-				//data to insert
-				else // if( (segment_last+i) >= start &&  (segment_last+i) < (start+ins_count) )
-				{
-					if(data == NULL)
-					{
-						buf[i]=INFOMEM_ERASED_WORD;
-					}
-					else
-					{
-						buf[i]=data[i-data_offset];
-					}
-				}
-			}
-			//write buffer to flash
-			infomem_write_flash_segment(segment_last,buf,1);
-			//we have processed the last segment, process the next in the next loop run
-			segment_last-=INFOMEM_SEGMENT_WORDS;
+			addr[i+1] = data[i-offset];
+		}
+		else
+		{
+			addr[i+1] = old[i];
 		}
+		infomem_waitbusy()
 	}
-	//start with the first segment
-	else //if more<0
+	
+	addr[count+1] = INFOMEM_TERMINATOR;
+	infomem_waitbusy()
+	
+	infomem_flash_lock();
+	
+	sInfomem.free = addr+count+INFOMEM_RECORD_WORDS;
+	return addr+1;
+}
+
+// copy the current records of all applications except skip into segment, which becomes the
+// new base of the log. The new record of skip has to be appended before infomem_compact_done().
+//        FOR INTERNAL USE ONLY
+void infomem_compact(u8 segment, struct infomem_app* skip)
+{
+	struct infomem_app* app;
+	
+	infomem_open_segment(segment, INFOMEM_OPEN);
+	
+	for(app=sInfomem.app; app<sInfomem.app+sInfomem.apps; app++)
 	{
-		//start with the first mod
-		next_mod=0;
-		while(segment_first<=segment_last)
+		if(app != skip)
+		{
+			app->data=infomem_append(app->identifier, app->count, app->data, NULL, 0, 0);
+		}
+	}
+}
+
+// mark base segment written by infomem_compact complete, older segments are ignored from now on
+// and erased in the background
+//        FOR INTERNAL USE ONLY
+void infomem_compact_done(void)
+{
+	u16* addr=infomem_segment_addr(sInfomem.head);
+	
+	infomem_flash_unlock(addr);
+	FCTL1 = FWKEY | WRT;
+	addr[1] &= ~INFOMEM_OPEN;
+	infomem_waitbusy()
+	infomem_flash_lock();
+	
+	sInfomem.live = 1<<sInfomem.head;
+	request.flag.infomem = 1;
+}
+
+// add the records of one segment to the index and set the free pointer behind them
+//        FOR INTERNAL USE ONLY
+// returns -4 if there are too many applications, 0 otherwise
+s16 infomem_scan_segment(u8 segment)
+{
+	u16* addr=infomem_segment_addr(segment)+INFOMEM_HEADER_WORDS;
+	u16* end=infomem_segment_addr(segment)+INFOMEM_SEGMENT_WORDS;
+	struct infomem_app* app;
+	u8 count;
+	
+	while(addr<end && *addr != INFOMEM_ERASED_WORD)
+	{
+		count=((u8*)addr)[1];
+		
+		//record was not completed (power fail), nothing must be appended to this segment
+		if(count > end-addr-INFOMEM_RECORD_WORDS || addr[count+1] != INFOMEM_TERMINATOR)
+		{
+			addr=end;
+			break;
+		}
+		
+		app=infomem_get_app(((u8*)addr)[0]);
+		//record with zero count deletes application
+		if(count == 0)
 		{
-			data_offset=((u16)start - (u16)segment_first)/2;
-			
-			for(i=0;i<INFOMEM_SEGMENT_WORDS;i++)
+			if(app != NULL)
 			{
-				//data we need to preserve
-				if( (segment_first+i) >= free_stop)
-				{
-					buf[i]=segment_first[i];
-				}
-				//data to change with single modify
-				else if( next_mod!=mod_count && (segment_first+i) == mod_addr[next_mod] )
-				{
-					buf[i] = mod_data[next_mod];
-					next_mod++;
-				}
-				//data we do not care about (leave erased)
-				else if( (segment_first+i) >= (free_start+more))
-				{
-					buf[i]=INFOMEM_ERASED_WORD;
-				}
-				//data not to change
-				else if((segment_first+i) < start)
-				{
-					buf[i]=segment_first[i];
-				}
-				//data following the data we insert
-				else if( (segment_first+i) >= (start+ins_count))
-				{
-					buf[i]=segment_first[i-more];
-				}
-				//data to insert
-				else // if( (segment_first+i) >= start &&  (segment_first+i) < (start+ins_count) )
+				*app=sInfomem.app[--sInfomem.apps];
+			}
+		}
+		else
+		{
+			if(app == NULL)
+			{
+				if(sInfomem.apps >= INFOMEM_MAX_APPS)
 				{
-					if(data == NULL)
-					{
-						buf[i]=INFOMEM_ERASED_WORD;
-					}
-					else
-					{
-						buf[i]=data[i-data_offset];
-					}
+					return -4;
 				}
+				app=&sInfomem.app[sInfomem.apps++];
+				app->identifier=((u8*)addr)[0];
 			}
-			infomem_write_flash_segment(segment_first,buf,1);
-			segment_first +=INFOMEM_SEGMENT_WORDS;
+			app->count=count;
+			app->data=addr+1;
 		}
+		addr+=count+INFOMEM_RECORD_WORDS;
 	}
+	
+	sInfomem.free=addr;
+	sInfomem.live |= 1<<segment;
+	return 0;
 }
 
 // *************************************************************************************************
-// @fn          infomem_get_app_addr
-// @brief       return the address of the header for an address
+// @fn          infomem_get_app
+// @brief       return the index entry for an application
 //				FOR INTERNAL USE ONLY
 // @param       u8 identifier	Identifier byte for application
 // @return		NULL not present
-//				n address of identifier byte
+//				n index entry
+// *************************************************************************************************
+struct infomem_app* infomem_get_app(u8 identifier)
+{
+	struct infomem_app* app;
+	
+	for(app=sInfomem.app; app<sInfomem.app+sInfomem.apps; app++)
+	{
+		if(app->identifier == identifier)
+		{
+			return app;
+		}
+	}
+	//application not found
+	return NULL;
+}
+
+// *************************************************************************************************
+// @fn          infomem_write_record
+// @brief       append new record for application, start a new segment or compact the log if needed
+//				FOR INTERNAL USE ONLY
+// @param       u8 identifier	Identifier byte for application
+//				u16* data		Data array
+//				u8 count		new size of application data (0 deletes application)
+//				u8 offset		word offset of data in new record
+//				u8 data_count	number of words from data, all other words are kept
+// @return		-4 not enough memory
+//				0 written
 // *************************************************************************************************
-u16* infomem_get_app_addr(u8 identifier)
+s16 infomem_write_record(u8 identifier, u16* data, u8 count, u8 offset, u8 data_count)
 {
-	//start at the first word of payload
-	u16* addr= sInfomem.startaddr +2;
+	struct infomem_app* app=infomem_get_app(identifier);
+	s16 size=sInfomem.size;
+	u16* old=NULL;
+	u8 i, compacted=0;
 	
-	//while we have not reached the end
-	while(addr<sInfomem.startaddr+2+sInfomem.size)
+	if(app != NULL)
 	{
-		//application found, return address
-		if( ((u8*)addr)[0] == identifier )
+		size-=app->count+INFOMEM_RECORD_WORDS;
+		old=app->data;
+		
+		//nothing changes, save the flash
+		if(count == app->count)
 		{
-			return addr;
+			for(i=0; i<data_count; i++)
+			{
+				if(old[offset+i] != data[i])
+				{
+					break;
+				}
+			}
+			if(i == data_count)
+			{
+				return 0;
+			}
 		}
-		//step to header of next application
+	}
+	else if(count == 0)
+	{
+		return 0;
+	}
+	
+	if(count > 0)
+	{
+		size+=count+INFOMEM_RECORD_WORDS;
+		
+		//check if new data does fit
+		if(count > INFOMEM_APP_MAX_WORDS || size > sInfomem.maxsize || (app == NULL && sInfomem.apps >= INFOMEM_MAX_APPS))
+		{
+			return -4;
+		}
+	}
+	
+	//record does not fit into head segment
+	if(sInfomem.free+count+INFOMEM_RECORD_WORDS > infomem_segment_addr(sInfomem.head)+INFOMEM_SEGMENT_WORDS)
+	{
+		//keep one free segment for compaction
+		if(infomem_free_segments() > 1)
+		{
+			infomem_open_segment(infomem_next_free_segment(), INFOMEM_CONTINUED | INFOMEM_OPEN);
+		}
+		//copy all other applications into the last free segment, the old record is not erased yet
 		else
 		{
-			addr+=((u8*)addr)[1]+1;
+			infomem_compact(infomem_next_free_segment(), app);
+			compacted=1;
 		}
 	}
-	//application not found
-	return NULL;
+	
+	if(count == 0)
+	{
+		//deleted application is simply not copied by compaction, write record that deletes it otherwise
+		if(!compacted)
+		{
+			infomem_append(identifier, 0, NULL, NULL, 0, 0);
+		}
+		*app=sInfomem.app[--sInfomem.apps];
+	}
+	else
+	{
+		if(app == NULL)
+		{
+			app=&sInfomem.app[sInfomem.apps++];
+			app->identifier=identifier;
+		}
+		app->data=infomem_append(identifier, count, old, data, offset, data_count);
+		app->count=count;
+	}
+	
+	if(compacted)
+	{
+		infomem_compact_done();
+	}
+	
+	sInfomem.size=size;
+	return 0;
 }
 
 // *************************************************************************************************
 // @fn          infomem_ready
 // @brief       check if infomem is initialized and in sane state, return amount of data present
+//				the log is read once and the index of current records is built
 // @param		none
 // @return		-2 no memory structure present
-//				-3,-4,-5 data structure error
+//				-3,-4 data structure error
 //				>=0 size of data present
 // *************************************************************************************************
 s16 infomem_ready()
 {
-	u8 found_beg=0;
+	u8 segment, first, base=0xFF;
+	u16 base_header=0;
+	u16* addr;
+	struct infomem_app* app;
 	
 	//already checked, trust that and just return size
 	if(sInfomem.sane== INFOMEM_SANE)
@@ -332,67 +474,78 @@ s16 infomem_ready()
 		return sInfomem.size;
 	}
 	
-	//if address is already set and in right range, look if it is correct, otherwise reset it
-	if( (((u16) (sInfomem.startaddr)) >= INFOMEM_START) && (((u16) (sInfomem.startaddr)) < (INFOMEM_START+4*INFOMEM_SEGMENT_SIZE)))
-	{
-		if(  *(sInfomem.startaddr) == INFOMEM_IDENTIFIER)
-		{
-			found_beg=1;
-		}
-		else
-		{
-			sInfomem.startaddr= NULL;
-		}
-	}
-	
-	//search for identifier word of information memory by looping over memory
-	if( found_beg == 0 )
+	//search newest complete base segment by looping over memory
+	for(segment=0; segment<INFOMEM_SEGMENT_COUNT; segment++)
 	{
-		u16* addr;
-		for(addr=(u16*)INFOMEM_START; addr<(u16*)(INFOMEM_START+4*INFOMEM_SEGMENT_SIZE); addr++)
+		addr=infomem_segment_addr(segment);
+		if( addr[0] == INFOMEM_IDENTIFIER && !(addr[1] & (INFOMEM_CONTINUED | INFOMEM_OPEN)) )
 		{
-			if( *addr == INFOMEM_IDENTIFIER )
+			if( base == 0xFF || (s8)((u8)addr[1] - (u8)base_header) > 0 )
 			{
-				sInfomem.startaddr= addr;
-				found_beg=1;
-				break;
+				base=segment;
+				base_header=addr[1];
 			}
 		}
 	}
 	
 	//give up searching
-	if( found_beg ==0)
+	if( base == 0xFF )
 	{
 		return -2;
 	}
 	
-	//read size and maxsize
-	sInfomem.size = ((u8*)(sInfomem.startaddr))[2];
-	sInfomem.maxsize =  ((u8*)(sInfomem.startaddr))[3];
-	
-	//check size and maxsize for plausibility
-	if(sInfomem.size > sInfomem.maxsize || sInfomem.maxsize > (INFOMEM_START+4*INFOMEM_SEGMENT_SIZE-6 - (u16)sInfomem.startaddr)/2 )
+	//read ring of segments and check it for plausibility
+	first=(base_header >> INFOMEM_FIRST_SHIFT) & 0x03;
+	sInfomem.segments=((base_header >> INFOMEM_SEGMENTS_SHIFT) & 0x03) + 1;
+	if( sInfomem.segments < 2 || first+sInfomem.segments > INFOMEM_SEGMENT_COUNT || base < first || base >= first+sInfomem.segments )
 	{
 		return -3;
 	}
+	sInfomem.startaddr=infomem_segment_addr(first);
+	sInfomem.sequence=(u8)base_header;
+	sInfomem.live=0;
+	sInfomem.apps=0;
 	
-	//loop through applications towards the end of the memory
-	u16* addr= sInfomem.startaddr+2;
-	while(addr<sInfomem.startaddr+2+sInfomem.size)
+	//follow the log from the base segment along increasing sequence numbers
+	segment=base;
+	while(segment != 0xFF)
 	{
-		addr+=((u8*)addr)[1]+1;
+		if(infomem_scan_segment(segment) < 0)
+		{
+			return -4;
+		}
+		sInfomem.head=segment;
+		
+		for(segment=first; segment<first+sInfomem.segments; segment++)
+		{
+			addr=infomem_segment_addr(segment);
+			if( addr[0] == INFOMEM_IDENTIFIER && (addr[1] & INFOMEM_CONTINUED) && (u8)addr[1] == (u8)(sInfomem.sequence+1) && !(sInfomem.live & (1<<segment)) )
+			{
+				sInfomem.sequence++;
+				break;
+			}
+		}
+		if(segment == first+sInfomem.segments)
+		{
+			segment=0xFF;
+		}
 	}
-	//return when the sum of the application sizes does not match the total size
-	if(addr !=sInfomem.startaddr+sInfomem.size+2)
+	
+	//sum up size of current records
+	sInfomem.size=0;
+	for(app=sInfomem.app; app<sInfomem.app+sInfomem.apps; app++)
 	{
-		return -4;
+		sInfomem.size+=app->count+INFOMEM_RECORD_WORDS;
 	}
+	sInfomem.maxsize=INFOMEM_SEGMENT_WORDS-INFOMEM_HEADER_WORDS;
 	
-	
-	//check if terminator word is in place
-	if( sInfomem.startaddr[sInfomem.size+2] != INFOMEM_TERMINATOR)
+	//erase segments left over by compaction or power fail in the background
+	for(segment=first; segment<first+sInfomem.segments; segment++)
 	{
-		return -5;
+		if( !(sInfomem.live & (1<<segment)) && !infomem_segment_blank(segment) )
+		{
+			request.flag.infomem = 1;
+		}
 	}
 	
 	//exerything seems to be OK
@@ -405,57 +558,56 @@ s16 infomem_ready()
 // *************************************************************************************************
 // @fn          infomem_init
 // @brief       write infomem data structure
-// @param		u16	start		(word) address of first word of used memory
-//				u16	end			(word) address of first word of NOT used memory
+//				content of the memory range (e.g. of an older firmware) is erased
+// @param		u16	start		address of first segment of used memory
+//				u16	end			address of first segment of NOT used memory
 // @return		-1 infomem already present
-//				-2 addresses not word addresses or out of range
-//				-3 memory not empty
+//				-2 addresses not segment addresses, out of range or less than two segments
 //				>0 new maximum size
 // *************************************************************************************************
 s16 infomem_init(u16 start, u16 end)
 {
+	u8 segment;
+	
 	if(sInfomem.sane==INFOMEM_SANE)
 	{
 		return -1;
 	}
 	
-	u16 numwords=(end-start)/2;
-	
 	//check if address boundaries are usable
-	if( start & 0x1 || end &0x1 || end<start || numwords<10 || start < INFOMEM_START || end > INFOMEM_START+4*INFOMEM_SEGMENT_SIZE )
+	if( start & (INFOMEM_SEGMENT_SIZE-1) || end & (INFOMEM_SEGMENT_SIZE-1) || end<start+2*INFOMEM_SEGMENT_SIZE || start < INFOMEM_START || end > INFOMEM_START+INFOMEM_SEGMENT_COUNT*INFOMEM_SEGMENT_SIZE )
 	{
 		return -2;
 	}
 	
+	//init struct with standard values
+	sInfomem.startaddr = infomem_segment_addr((start-INFOMEM_START)/INFOMEM_SEGMENT_SIZE);
+	sInfomem.segments=(end-start)/INFOMEM_SEGMENT_SIZE;
+	sInfomem.size=0;
+	sInfomem.maxsize=INFOMEM_SEGMENT_WORDS-INFOMEM_HEADER_WORDS;
+	sInfomem.sequence=0;
+	sInfomem.live=0;
+	sInfomem.apps=0;
+	sInfomem.not_lock=0;
 	
-	int i;
-	//check if memory area is empty
-	for(i=0; i<numwords; i++)
+	//make sure memory area is empty
+	for(segment=infomem_segment_first(); segment<infomem_segment_first()+sInfomem.segments; segment++)
 	{
-		if( ((u16*)start)[i] != INFOMEM_ERASED_WORD )
+		if(!infomem_segment_blank(segment))
 		{
-			return -3;
+			infomem_erase_segment(segment);
 		}
 	}
 	
-	//init struct with standard values
-	sInfomem.startaddr = (u16*) start;
-	sInfomem.size=0;
-	sInfomem.maxsize=(end-start-6)/2;
-	sInfomem.not_lock=0;
-	
-	//prepare the three words of the initial structure
-	u16 buf[3]={INFOMEM_IDENTIFIER,((numwords-3) & 0xFF)<<8,INFOMEM_TERMINATOR};
-	
-	//write the initial structure to memory
-	infomem_write_data((u16*)start, buf,3);
+	//write empty base segment
+	infomem_open_segment(infomem_segment_first(), 0);
 	
 	//make structure usable
 	sInfomem.sane= INFOMEM_SANE;
 	sInfomem.not_lock=1;
 	
 	return sInfomem.maxsize;
-
+	
 };
 
 // *************************************************************************************************
@@ -480,20 +632,23 @@ s16 infomem_space()
 
 // *************************************************************************************************
 // @fn          infomem_relocate
-// @brief       change start and end address of data storage (can change size)
-// @param		u16	start		(word) address of first word of used memory
-//				u16	end			(word) address of first word of NOT used memory
+// @brief       change start and end address of data storage
+//				current records are copied into a free segment of the new range
+// @param		u16	start		address of first segment of used memory
+//				u16	end			address of first segment of NOT used memory
 // @return		-1 data structure error or memory not initialized
 //				-2 temporary error (try again later)
-//				-3 address not word addresses
+//				-3 address not segment addresses
 //				-4 addresses out of range
-//				-5 new space too small
+//				-5 new space too small or no free segment in new space
 //				>0 new maximum size
 // *************************************************************************************************
 s16 infomem_relocate(u16 start, u16 end)
 {
-	//check if we really have word addresses
-	if((start & 0x1) || (end & 0x1))
+	u8 segment, first, segments, old_live;
+	
+	//check if we really have segment addresses
+	if((start & (INFOMEM_SEGMENT_SIZE-1)) || (end & (INFOMEM_SEGMENT_SIZE-1)))
 	{
 		return -3;
 	}
@@ -503,12 +658,12 @@ s16 infomem_relocate(u16 start, u16 end)
 		return -1;
 	}
 	//check if range is within memory
-	if(end > INFOMEM_START+4*INFOMEM_SEGMENT_SIZE || start < INFOMEM_START)
+	if(end > INFOMEM_START+INFOMEM_SEGMENT_COUNT*INFOMEM_SEGMENT_SIZE || start < INFOMEM_START)
 	{
 		return -4;
 	}
 	//check if new memory range is big enough
-	if((u16*)end < (u16*)start +sInfomem.size+3)
+	if(end < start+2*INFOMEM_SEGMENT_SIZE)
 	{
 		return -5;
 	}
@@ -519,39 +674,39 @@ s16 infomem_relocate(u16 start, u16 end)
 	}
 	sInfomem.not_lock=0;
 	
+	first=(start-INFOMEM_START)/INFOMEM_SEGMENT_SIZE;
+	segments=(end-start)/INFOMEM_SEGMENT_SIZE;
 	
-	u16* old_end=sInfomem.startaddr+sInfomem.maxsize+3;
-	
-	sInfomem.maxsize= (u16*)end - (u16*)start - 3;
-	
-	//new address of size word
-	u16* mod_addr= (u16*)start+1;
-	
-	//prepare new size word
-	u16 buf;
-	((u8*)(&buf))[0] = sInfomem.size;
-	((u8*)(&buf))[1] = sInfomem.maxsize;
-	
-	//no relocation, just resize
-	if((u16*)start == sInfomem.startaddr)
+	//find segment of new range without current records
+	for(segment=first; segment<first+segments; segment++)
 	{
-		infomem_write_data(mod_addr, &buf, 1);
+		if(!(sInfomem.live & (1<<segment)))
+		{
+			break;
+		}
 	}
-	//left shift (might be with resize)
-	else if((u16*)start < sInfomem.startaddr)
+	if(segment == first+segments)
 	{
-		//delete bytes before information memory
-		infomem_insert_delete_modify((u16*)start, NULL, (u8)(sInfomem.startaddr-(u16*)start), 0, &mod_addr, &buf, 1, sInfomem.startaddr+3+sInfomem.size, old_end);
+		sInfomem.not_lock=1;
+		return -5;
 	}
-	//right shift
-	else
+	
+	//new base segment carries the new range
+	old_live=sInfomem.live;
+	sInfomem.startaddr=infomem_segment_addr(first);
+	sInfomem.segments=segments;
+	infomem_compact(segment, NULL);
+	infomem_compact_done();
+	
+	//segments outside of the new range are not managed any more
+	for(segment=0; segment<INFOMEM_SEGMENT_COUNT; segment++)
 	{
-		//insert empty bytes before information memory
-		infomem_insert_delete_modify(sInfomem.startaddr, NULL, 0, (u8)((u16*)start-sInfomem.startaddr), &mod_addr, &buf, 1, sInfomem.startaddr+3+sInfomem.size, (u16*)start+3+sInfomem.maxsize);
+		if( (old_live & (1<<segment)) && (segment < first || segment >= first+segments) )
+		{
+			infomem_erase_segment(segment);
+		}
 	}
 	
-	sInfomem.startaddr=(u16*)start;
-	
 	sInfomem.not_lock=1;
 	return sInfomem.maxsize;
 }
@@ -565,21 +720,56 @@ s16 infomem_relocate(u16 start, u16 end)
 // *************************************************************************************************
 s16 infomem_delete_all(void)
 {
+	u8 segment;
+	
 	if(sInfomem.sane!=INFOMEM_SANE)
 	{
 		return -1;
 	}
 	
-	//overwrite complete previously reserved memory with erased bytes
-	infomem_insert_delete_modify(sInfomem.startaddr, NULL, sInfomem.maxsize+3, sInfomem.maxsize+3, NULL, NULL, 0, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
+	//erase all managed segments
+	for(segment=infomem_segment_first(); segment<infomem_segment_first()+sInfomem.segments; segment++)
+	{
+		if(!infomem_segment_blank(segment))
+		{
+			infomem_erase_segment(segment);
+		}
+	}
 	
 	sInfomem.sane=0;
 	sInfomem.startaddr=NULL;
 	sInfomem.size=0;
 	sInfomem.maxsize=0;
+	sInfomem.apps=0;
+	sInfomem.live=0;
 	return 0;
 }
 
+// *************************************************************************************************
+// @fn          infomem_erase_stale
+// @brief       erase segments that do not hold current records any more
+//				called by process_requests after log compaction
+// @param       none
+// @return		none
+// *************************************************************************************************
+void infomem_erase_stale(void)
+{
+	u8 segment;
+	
+	if(sInfomem.sane!=INFOMEM_SANE || sInfomem.not_lock ==0)
+	{
+		return;
+	}
+	
+	for(segment=infomem_segment_first(); segment<infomem_segment_first()+sInfomem.segments; segment++)
+	{
+		if( !(sInfomem.live & (1<<segment)) && !infomem_segment_blank(segment) )
+		{
+			infomem_erase_segment(segment);
+		}
+	}
+}
+
 // *************************************************************************************************
 // @fn          infomem_app_amount
 // @brief       return how much data for the application is available
@@ -595,16 +785,16 @@ s16 infomem_app_amount(u8 identifier)
 		return -1;
 	}
 	
-	u16* addr= infomem_get_app_addr(identifier);
-	if( addr == NULL)
+	struct infomem_app* app= infomem_get_app(identifier);
+	if( app == NULL)
 	{
 		return 0;
 	}
 	
-	return ((u8*)addr)[1];
+	return app->count;
 }
-	
-	
+
+
 // *************************************************************************************************
 // @fn          infomem_app_read
 // @brief       read count bytes of data with offset for given application into prepared memory
@@ -625,32 +815,28 @@ s16 infomem_app_read(u8 identifier, u16* data, u8 count, u8 offset)
 	}
 	
 	//find application
-	u16* addr= infomem_get_app_addr(identifier);
-	if( addr == NULL)
+	struct infomem_app* app= infomem_get_app(identifier);
+	if( app == NULL)
 	{
 		return 0;
 	}
 	
-	//read application size
-	u8 size=((u8*)addr)[1];
 	//check if offset is still within application memory
-	if (offset>=size)
+	if (offset>=app->count)
 	{
 		return 0;
 	}
 	//do not read more data than what is present
-	if(count+offset>size)
+	if(count+offset>app->count)
 	{
-		count= size-offset;
+		count= app->count-offset;
 	}
-	//set address to read from
-	addr+=offset+1;
 	
 	int i;
 	//copy data
 	for(i=0;i<count;i++)
 	{
-		data[i]=addr[i];
+		data[i]=app->data[offset+i];
 	}
 	
 	return count;
@@ -669,6 +855,8 @@ s16 infomem_app_read(u8 identifier, u16* data, u8 count, u8 offset)
 // *************************************************************************************************
 s16 infomem_app_replace(u8 identifier, u16* data, u8 count)
 {
+	s16 ret;
+	
 	//delete app completely if we have to replace it with zero content.
 	if(count ==0)
 	{
@@ -685,59 +873,13 @@ s16 infomem_app_replace(u8 identifier, u16* data, u8 count)
 	}
 	sInfomem.not_lock=0;
 	
-	u8 old_size=0;
-	//get address of application
-	u16* addr= infomem_get_app_addr(identifier);
-	//application is already present, really replace memory content
-	if( addr != NULL)
-	{
-		old_size=((u8*)addr)[1];
-		
-		//check if new data does fit
-		if((s16)sInfomem.size + (s16) count - (s16)old_size > sInfomem.maxsize)
-		{
-			sInfomem.not_lock=1;
-			return -4;
-		}
-		
-		//set global header and application header to be modified
-		u16* mod_addr[2]={sInfomem.startaddr+1,addr};
-		u16 mod_data[2];
-		((u8*)mod_data)[0]=sInfomem.size+count-old_size;
-		((u8*)mod_data)[1]=sInfomem.maxsize;
-		((u8*)mod_data)[2]=identifier;
-		((u8*)mod_data)[3]=count;
-		
-		//delete old_size words and write count new words instead, also replace headers
-		infomem_insert_delete_modify(addr+1, data, old_size, count, mod_addr, mod_data, 2, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
-		//store new size
-		sInfomem.size=((u8*)mod_data)[0];
-	}
-	//application not present, add it at the end of the information memory
-	else
+	ret=infomem_write_record(identifier, data, count, 0, count);
+	
+	sInfomem.not_lock=1;
+	if(ret<0)
 	{
-		//check if new data does fit
-		if((s16)sInfomem.size + (s16) count +1 > sInfomem.maxsize)
-		{
-			sInfomem.not_lock=1;
-			return -4;
-		}
-		
-		//prepare header words
-		u16* mod_addr[2]={sInfomem.startaddr+1,sInfomem.startaddr+2+sInfomem.size};
-		u16 mod_data[2];
-		((u8*)mod_data)[0]=sInfomem.size+count+1;
-		((u8*)mod_data)[1]=sInfomem.maxsize;
-		((u8*)mod_data)[2]=identifier;
-		((u8*)mod_data)[3]=count;
-		
-		//hack: to write the application header and size add it to mod, increase count and decrease data pointer. the first data word at data-1 will not be read
-		//this avoids copying data to add a header
-		infomem_insert_delete_modify(sInfomem.startaddr+2+sInfomem.size, data-1, 0, count+1, mod_addr, mod_data, 2, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
-		//store size
-		sInfomem.size=((u8*)mod_data)[0];
+		return ret;
 	}
-	sInfomem.not_lock=1;
 	return sInfomem.size;
 }
 
@@ -779,53 +921,24 @@ s16 infomem_app_delete(u8 identifier,u8 offset)
 	}
 	sInfomem.not_lock=0;
 	
-	//get address of application
-	u16* addr= infomem_get_app_addr(identifier);
-	if( addr == NULL)
+	//get index entry of application
+	struct infomem_app* app= infomem_get_app(identifier);
+	if( app == NULL)
 	{
 		sInfomem.not_lock=1;
 		return 0;
 	}
-	//get old size of application
-	u8 old_size=((u8*)addr)[1];
-	//delete application completely
-	if(offset==0)
-	{
-		//prepare global size header
-		u16* mod_addr[1]={sInfomem.startaddr+1};
-		u16 mod_data[1];
-		((u8*)mod_data)[0]=sInfomem.size-old_size-1;
-		((u8*)mod_data)[1]=sInfomem.maxsize;
-		
-		infomem_insert_delete_modify(addr, NULL, old_size+1, 0, mod_addr, mod_data, 1, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
-		//store new size
-		sInfomem.size=((u8*)mod_data)[0];
-	}
-	//let some data be present
-	else
+	
+	//check if offset is in range
+	if(offset>=app->count)
 	{
-		//check if offset is in range
-		if(offset>=old_size)
-		{
-			sInfomem.not_lock=1;
-			return -3;
-		}
-		
-		//determine count of data to be deleted
-		u8 count_delete=old_size-offset;
-		
-		//prepare new size headers
-		u16* mod_addr[2]={sInfomem.startaddr+1,addr};
-		u16 mod_data[2];
-		((u8*)mod_data)[0]=sInfomem.size-count_delete;
-		((u8*)mod_data)[1]=sInfomem.maxsize;
-		((u8*)mod_data)[2]=identifier;
-		((u8*)mod_data)[3]=old_size-count_delete;
-		
-		infomem_insert_delete_modify(addr+1+offset, NULL, count_delete, 0, mod_addr, mod_data, 2, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
-		//store new size
-		sInfomem.size=((u8*)mod_data)[0];
+		sInfomem.not_lock=1;
+		return -3;
 	}
+	
+	//keep first offset words (delete complete application if offset==0)
+	infomem_write_record(identifier, NULL, offset, 0, 0);
+	
 	sInfomem.not_lock=1;
 	return sInfomem.size;
 }
@@ -847,6 +960,9 @@ s16 infomem_app_delete(u8 identifier,u8 offset)
 // *************************************************************************************************
 s16 infomem_app_modify(u8 identifier, u16* data, u8 count, u8 offset)
 {
+	s16 ret;
+	u8 new_size;
+	
 	if(sInfomem.sane!=INFOMEM_SANE)
 	{
 		return -1;
@@ -857,57 +973,35 @@ s16 infomem_app_modify(u8 identifier, u16* data, u8 count, u8 offset)
 	}
 	sInfomem.not_lock=0;
 	
-	u16* addr= infomem_get_app_addr(identifier);
+	struct infomem_app* app= infomem_get_app(identifier);
 	
-	if( addr == NULL)
+	if( app == NULL)
 	{
 		sInfomem.not_lock=1;
 		return 0;
 	}
-	u8 old_size=((u8*)addr)[1];
 	
-	if(offset>old_size)
+	if(offset>app->count)
 	{
 		sInfomem.not_lock=1;
 		return -3;
 	}
 	
-	//new data does fit in old data, just modify the selected words
-	if(count+offset<=old_size)
+	//increase size of application's storage if new data does not fit
+	new_size=app->count;
+	if(count+offset>new_size)
 	{
-		infomem_write_data(addr+1+offset,data,count);
-		sInfomem.not_lock=1;
-		return old_size;
+		new_size=count+offset;
 	}
-	//new data does not fit, increase size of application's storage
-	else
+	
+	ret=infomem_write_record(identifier, data, new_size, offset, count);
+	
+	sInfomem.not_lock=1;
+	if(ret<0)
 	{
-		//calculate number of words that are overwritten
-		u8 count_delete=old_size-offset;
-		
-		//check if new data does fit into memory
-		if((s16)sInfomem.size -(s16)count_delete+(s16) count > sInfomem.maxsize)
-		{
-			sInfomem.not_lock=1;
-			return -4;
-		}
-		
-		//prepare new headers with size
-		u16* mod_addr[2]={sInfomem.startaddr+1,addr};
-		u16 mod_data[2];
-		((u8*)mod_data)[0]=sInfomem.size-count_delete+count;
-		((u8*)mod_data)[1]=sInfomem.maxsize;
-		((u8*)mod_data)[2]=identifier;
-		((u8*)mod_data)[3]=old_size-count_delete+count;
-		
-		infomem_insert_delete_modify(addr+1+offset, data, count_delete, count, mod_addr, mod_data, 2, sInfomem.startaddr+3+sInfomem.size, sInfomem.startaddr+3+sInfomem.maxsize);
-		
-		//store new size
-		sInfomem.size=((u8*)mod_data)[0];
-		
-		sInfomem.not_lock=1;
-		return offset+count;
+		return ret;
 	}
+	return new_size;
 }
 
 #endif
\ No newline at end of file
@@ -28,6 +28,21 @@
  * 
  * All pointers and addresses have to be word addresses (even numbers) and all counts
  * are given in units of words (two bytes).
+ * 
+ * Memory layout:
+ * The managed memory is a ring of 2-4 flash segments used as a log. Every change of
+ * application data appends a complete new record, the latest record of an identifier
+ * wins and a record with zero count deletes the application. infomem_ready() walks the
+ * log once and keeps an index of the current records in RAM.
+ * 
+ * segment:	header (identifier word, sequence/flags word), records, erased words
+ * record:	(identifier, count) word, count data words, terminator word
+ * 
+ * A record without terminator (power fail while writing) is ignored. When the log has
+ * reached the last free segment, the current records are copied into it ("base" segment,
+ * flagged complete after the copy) and the older segments are erased later by
+ * infomem_erase_stale(), called from process_requests(). All live data has to fit into
+ * one segment, a single application can store up to INFOMEM_APP_MAX_WORDS words.
  */
 
 
@@ -55,20 +70,12 @@ extern s16 infomem_app_delete(u8 identifier,u8 offset);
 //modify given bytes of data
 extern s16 infomem_app_modify(u8 identifier, u16* data, u8 count, u8 offset);
 
+//erase segments left over by log compaction (called by process_requests)
+extern void infomem_erase_stale(void);
 
 
-struct infomem
-{
-	u16*		startaddr; //starting address (position of header)
-	u8			size;  //size of payload in words
-	u8			maxsize;  //maximum size of payload in words
-	volatile u8	not_lock;  //memory is not locked for write
-	u8			sane;  //sanity check passed
-};
-// extern struct infomem sInfomem;
 
-
-#define INFOMEM_IDENTIFIER 0x5a74
+#define INFOMEM_IDENTIFIER 0x5a75
 #define INFOMEM_TERMINATOR 0xdaf4
 #define INFOMEM_SANE 0xda
 
@@ -79,7 +86,51 @@ struct infomem
 #define INFOMEM_A 0x1980
 #define INFOMEM_SEGMENT_SIZE 128
 #define INFOMEM_SEGMENT_WORDS INFOMEM_SEGMENT_SIZE/2
+#define INFOMEM_SEGMENT_COUNT 4
 #define INFOMEM_ERASED_WORD 0xFFFF
 
+//segment header: identifier word and sequence/flags word
+#define INFOMEM_HEADER_WORDS 2
+//low byte: sequence number, high byte: first segment and number of segments of the ring and flags
+#define INFOMEM_SEQUENCE_MASK 0x00FF
+#define INFOMEM_FIRST_SHIFT 8
+#define INFOMEM_SEGMENTS_SHIFT 10
+#define INFOMEM_RING_MASK 0x0F00
+//segment continues the log of the previous one (cleared: base segment holding a copy of all records)
+#define INFOMEM_CONTINUED 0x4000
+//base segment is still being written (cleared when the copy is complete)
+#define INFOMEM_OPEN 0x8000
+
+//record header (identifier, count) and terminator word
+#define INFOMEM_RECORD_WORDS 2
+#define INFOMEM_APP_MAX_WORDS (INFOMEM_SEGMENT_WORDS-INFOMEM_HEADER_WORDS-INFOMEM_RECORD_WORDS)
+#define INFOMEM_MAX_APPS 8
+
+
+
+//current record of an application
+struct infomem_app
+{
+	u8			identifier;
+	u8			count;  //size of payload in words
+	u16*		data;  //address of first payload word
+};
+
+struct infomem
+{
+	u16*		startaddr; //address of first segment of managed memory
+	u8			segments;  //number of segments
+	u8			head;  //segment records are appended to (0 = INFOMEM_D)
+	u16*		free;  //first erased word of head segment
+	u8			sequence;  //sequence number of head segment
+	u8			live;  //bit mask of segments holding current records
+	u8			size;  //size of payload in words (including record headers and terminators)
+	u8			maxsize;  //maximum size of payload in words
+	volatile u8	not_lock;  //memory is not locked for write
+	u8			sane;  //sanity check passed
+	u8			apps;  //number of applications in index
+	struct infomem_app app[INFOMEM_MAX_APPS];
+};
+// extern struct infomem sInfomem;
 
-#endif /*INFOMEM_H_*/
\ No newline at end of file
+#endif /*INFOMEM_H_*/
@@ -60,6 +60,7 @@
 #include "simpliciti.h"
 #include "altitude.h"
 #include "stopwatch.h"
+#include "energy.h"
 
 #ifdef CONFIG_EGGTIMER
 #include "eggtimer.h"
@@ -85,10 +86,12 @@ void button_repeat_function(void);
 volatile s_button_flags button;
 volatile struct struct_button sButton;
 
+// Button auto repeat timer
+static struct sw_timer button_repeat_timer;
+
 
 // *************************************************************************************************
 // Extern section
-extern void (*fptr_Timer0_A3_function)(void);
 
 
 // *************************************************************************************************
@@ -141,6 +144,9 @@ __interrupt void PORT2_ISR(void)
 	u8 buzzer = 0;
 	u8 simpliciti_button_event = 0;
 	static u8 simpliciti_button_repeat = 0;
+	u8 exit_lpm = 1;
+
+	ENERGY_ENTER(ENERGY_PORT2);
 
 	// Clear button flags
 	button.all_flags = 0;
@@ -204,6 +210,7 @@ __interrupt void PORT2_ISR(void)
 			Timer0_A4_Delay(CONV_MS_TO_TICKS(BUTTONS_DEBOUNCE_TIME_IN));
 	
 			// Reset inactivity detection
+			Rtc_Sync();
 			sTime.last_activity = sTime.system_time;
 		}
 
@@ -302,6 +309,7 @@ __interrupt void PORT2_ISR(void)
 				P2OUT |= BUTTON_BACKLIGHT_PIN;
 				P2DIR |= BUTTON_BACKLIGHT_PIN;
 				button.flag.backlight = 1;
+				ENERGY_START(ENERGY_BACKLIGHT);
 			}
 		}	
 	}
@@ -358,8 +366,11 @@ __interrupt void PORT2_ISR(void)
 	// Acceleration sensor IRQ
 	if (IRQ_TRIGGERED(int_flag, AS_INT_PIN))
 	{
-		// Get data from sensor
-		request.flag.acceleration_measurement = 1;
+		// Store sample in ring buffer, request processing only when a block is complete
+		if (as_push_sample()) request.flag.acceleration_measurement = 1;
+		
+		// Stay in LPM if sample was the only reason for this IRQ
+		else if (int_flag == AS_INT_PIN) exit_lpm = 0;
   	}
 	#endif
 	
@@ -389,8 +400,10 @@ __interrupt void PORT2_ISR(void)
 	BUTTONS_IE  = int_enable; 	
 	__enable_interrupt();
 
+	ENERGY_EXIT(ENERGY_PORT2);
+
 	// Exit from LPM3/LPM4 on RETI
-	__bic_SR_register_on_exit(LPM4_bits); 
+	if (exit_lpm) __bic_SR_register_on_exit(LPM4_bits); 
 }
 
 
@@ -405,11 +418,8 @@ void button_repeat_on(u16 msec)
 	// Set button repeat flag
 	sys.flag.up_down_repeat_enabled = 1;
 	
-	// Set Timer0_A3 function pointer to button repeat function
-	fptr_Timer0_A3_function = button_repeat_function;
-	
-	// Timer0_A3 IRQ triggers every 200ms
-	Timer0_A3_Start(CONV_MS_TO_TICKS(msec));
+	// Call button repeat function every "msec" milliseconds
+	sw_timer_start(&button_repeat_timer, CONV_MS_TO_TICKS(msec), CONV_MS_TO_TICKS(msec), button_repeat_function);
 }
 
 
@@ -424,8 +434,8 @@ void button_repeat_off(void)
 	// Clear button repeat flag
 	sys.flag.up_down_repeat_enabled = 0;
 	
-	// Timer0_A3 IRQ repeats with 4Hz
-	Timer0_A3_Stop();
+	// Stop button repeat timer
+	sw_timer_stop(&button_repeat_timer);
 }
 
 
@@ -485,6 +495,7 @@ void button_repeat_function(void)
 		sButton.repeats++;
 
 		// Reset inactivity detection counter
+		Rtc_Sync();
 		sTime.last_activity = sTime.system_time;
 		
 		// Disable blinking
@@ -44,6 +44,7 @@
 
 // logic
 #include "rfsimpliciti.h"
+#include "energy.h"
 //pfs
 #ifndef ELIMINATE_BLUEROBIN
 #include "bluerobin.h"
@@ -131,6 +132,7 @@ void open_radio(void)
 {
 	// Reset radio core
 	radio_reset();
+	ENERGY_START(ENERGY_RADIO);
 
 	// Enable radio IRQ
 	RF1AIFG &= ~BIT4;                         // Clear a pending interrupt
@@ -157,6 +159,7 @@ void close_radio(void)
 	
 	// Put radio to sleep
 	radio_powerdown();
+	ENERGY_STOP(ENERGY_RADIO);
 }
 
 
@@ -179,10 +182,15 @@ __interrupt void radio_ISR(void)
 {
 	u8 rf1aivec = RF1AIV;
 	
+	ENERGY_ENTER(ENERGY_RADIO_ISR);
+	
 	// Forward to SimpliciTI interrupt service routine
 	if (is_rf())
 	{
 		MRFI_RadioIsr();
+		
+		// Let low power delays in the stack check their early-out condition
+		__bic_SR_register_on_exit(LPM4_bits);
 	}
 	else // BlueRobin packet end interrupt service routine
 	{		
@@ -202,4 +210,6 @@ __interrupt void radio_ISR(void)
 			asm("	nop"); // break here
 		}
 	}
+	
+	ENERGY_EXIT(ENERGY_RADIO_ISR);
 }
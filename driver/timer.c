@@ -53,7 +53,9 @@
 #include "display.h"
 
 // logic
+#include "menu.h"
 #include "clock.h"
+#include "date.h"
 #include "battery.h"
 #include "stopwatch.h"
 #include "cycle_alarm.h"
@@ -84,24 +86,40 @@
 #ifdef CONFIG_STRENGTH
 #include "strength.h"
 #endif
+#include "energy.h"
+#ifdef CONFIG_DATALOG
+#include "datalog.h"
+#endif
+#ifdef CONFIG_PHASE_CLOCK
+#include "phase_clock.h"
+#endif
+#ifdef CONFIG_PEDOMETER
+#include "pedometer.h"
+#endif
 
 // *************************************************************************************************
 // Prototypes section
 void Timer0_Init(void);
 void Timer0_Stop(void);
-void Timer0_A1_Start(u16 ticks);
-void Timer0_A1_Stop(void);
-void Timer0_A3_Start(u16 ticks);
-void Timer0_A3_Stop(void);
+void Rtc_Init(void);
+void Rtc_SetTime(u8 hour, u8 minute, u8 second);
+void Rtc_Sync(void);
+u32 Rtc_GetTicks(void);
+static u32 rtc_read(u8 * hour, u8 * minute, u8 * second);
+void Timer0_A0_Reschedule(void);
+void sw_timer_start(struct sw_timer * t, u16 ticks, u16 period, void (*function)(void));
+void sw_timer_stop(struct sw_timer * t);
+static void sw_timer_service(void);
 void Timer0_A4_Delay(u16 ticks);
-void (*fptr_Timer0_A3_function)(void);
-#ifdef CONFIG_USE_GPS
-void (*fptr_Timer0_A1_function)(void);
-#endif
+u8 Timer0_A4_DelayUntil(u16 ticks, volatile u8 * flag, u8 mask);
+static void second_timer_function(void);
 
 // *************************************************************************************************
 // Defines section
 
+// Delay of the clock tick after the RTC second, so that the time registers already show it
+#define SECOND_TIMER_MARGIN				(4u)
+
 
 // *************************************************************************************************
 // Global Variable section
@@ -118,27 +136,23 @@ extern u8 alt_accum_enable; // 1 means the altitude accumulator is enabled
 
 // *************************************************************************************************
 // @fn          Timer0_Init
-// @brief       Set Timer0 to a period of 1 or 2 sec. IRQ TACCR0 is asserted when timer overflows.
+// @brief       Start Timer0 in continuous mode. TA0CCR0 is loaded with the first deadline of the
+//				software timer queue, the 1/s clock tick is one of its timers.
 // @param       none
 // @return      none
 // *************************************************************************************************
 void Timer0_Init(void)
 {
-	// Set interrupt frequency to 1Hz
-	TA0CCR0   = 32768 - 1;                
-
-	// Enable timer interrupt    
-	TA0CCTL0 |= CCIE;                     
-
 	// Clear and start timer now   
-	// Continuous mode: Count to 0xFFFF and restart from 0 again - 1sec timing will be generated by ISR
+	// Continuous mode: Count to 0xFFFF and restart from 0 again - the IRQ is enabled with the first
+	// software timer
 	TA0CTL   |= TASSEL0 + MC1 + TACLR;                       
 }
 
 
 // *************************************************************************************************
 // @fn          Timer0_Start
-// @brief       Start Timer0.
+// @brief       Start Timer0 and the RTC.
 // @param       none
 // @return      none
 // *************************************************************************************************
@@ -146,12 +160,15 @@ void Timer0_Start(void)
 { 
 	// Start Timer0 in continuous mode	 
 	TA0CTL |= MC_2;          
+
+	// Release RTC
+	RTCCTL01 &= ~RTCHOLD;
 }
 
 
 // *************************************************************************************************
 // @fn          Timer0_Stop
-// @brief       Stop and reset Timer0.
+// @brief       Stop and reset Timer0, hold the RTC.
 // @param       none
 // @return      none
 // *************************************************************************************************
@@ -162,83 +179,379 @@ void Timer0_Stop(void)
 
 	// Set Timer0 count register to 0x0000
 	TA0R = 0;                             
+
+	// Hold RTC
+	RTCCTL01 |= RTCHOLD;
 }
 
 
-void Timer0_A1_Start(u16 ticks)
+// *************************************************************************************************
+// @fn          Rtc_Init
+// @brief       Start RTC_A in calendar mode with the time of sTime. The RTC counts the time of day
+//				on its own, its minute event wakes up the CPU when no module needs a clock tick.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void Rtc_Init(void)
 {
-	/*old version
-	// Set interrupt frequency to 1Hz
-	TA0CCR1   = TA0R + 32678 ;
+	// Calendar mode, interrupt when the minute changes
+	RTCCTL01 = RTCTEVIE + RTCMODE + RTCHOLD + RTCTEV_0;
 
-	// Enable timer interrupt
-	TA0CCTL1 |= CCIE; */
+	// Date registers are not used (add_day() counts days), they only need valid values
+	RTCDAY  = sDate.day;
+	RTCMON  = sDate.month;
+	RTCYEAR = sDate.year;
 
-	u16 value;
+	// Load time and release RTC
+	Rtc_SetTime(sTime.hour, sTime.minute, sTime.second);
+}
 
-		// Store timer ticks in global variable
-		sTimer.timer0_A1_ticks = ticks;
 
-		// Delay based on current counter value
-		value = TA0R + ticks;
+// *************************************************************************************************
+// @fn          Rtc_SetTime
+// @brief       Set the time of day in RTC and sTime. The new second starts now.
+// @param       u8 hour, minute, second		New time
+// @return      none
+// *************************************************************************************************
+void Rtc_SetTime(u8 hour, u8 minute, u8 second)
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	__disable_interrupt();
+	
+	RTCCTL01 |= RTCHOLD;
+	RTCPS     = 0;
+	RTCSEC    = second;
+	RTCMIN    = minute;
+	RTCHOUR   = hour;
+	RTCCTL01 &= ~RTCHOLD;
+	
+	sTime.hour   = hour;
+	sTime.minute = minute;
+	sTime.second = second;
+	
+	// Clock tick follows the new second when it is started again
+	sw_timer_stop(&sTimer.second);
+	
+	__set_interrupt_state(int_state);
+}
+
 
-		// Update CCR
-		TA0CCR1 = value;
+// *************************************************************************************************
+// @fn          rtc_read
+// @brief       Read time registers and prescaler. They may change while being read, so read again 
+//				if the second changed in the meantime.
+// @param       u8 * hour, minute, second		Time of day
+// @return      u32								ACLK ticks since midnight
+// *************************************************************************************************
+static u32 rtc_read(u8 * hour, u8 * minute, u8 * second)
+{
+	u16 prescaler;
+	u8 sec;
+	
+	do
+	{
+		sec       = RTCSEC;
+		prescaler = RTCPS;
+		*minute   = RTCMIN;
+		*hour     = RTCHOUR;
+		*second   = RTCSEC;
+	}
+	while (*second != sec);
+	
+	// RT1PS counts at 128Hz, its bit 7 toggles with the seconds
+	return (((u32)(*hour * 60u + *minute) * 60u + sec) * 32768u + (prescaler & 0x7FFF));
+}
 
-		// Reset IRQ flag
-		TA0CCTL1 &= ~CCIFG;
 
-		// Enable timer interrupt
-		TA0CCTL1 |= CCIE;
+// *************************************************************************************************
+// @fn          Rtc_GetTicks
+// @brief       Time of day with ACLK resolution, for time spans longer than the 2 sec of Timer0.
+// @param       none
+// @return      u32		ACLK ticks since midnight, wraps at RTC_TICKS_PER_DAY
+// *************************************************************************************************
+u32 Rtc_GetTicks(void)
+{
+	u8 hour, minute, second;
+	
+	return (rtc_read(&hour, &minute, &second));
+}
+
+
+// *************************************************************************************************
+// @fn          Rtc_Sync
+// @brief       Bring sTime up to the RTC. Seconds that passed without a clock tick are added at once.
+//				Call before reading sTime outside of the clock tick and the minute event.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void Rtc_Sync(void)
+{
+	istate_t int_state = __get_interrupt_state();
+	u8 hour, minute, second;
+	
+	__disable_interrupt();
+	
+	rtc_read(&hour, &minute, &second);
+#ifdef CONFIG_ENERGY_STATS
+	// Count uptime and add on-time of running slots
+	energy_tick(clock_advance(hour, minute, second));
+#else
+	clock_advance(hour, minute, second);
+#endif
 	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          timer0_A0_tick_needed
+// @brief       Check if the next second needs the 1/s clock tick. This is not the case while line 1 
+//				shows HH:MM, line 2 shows the date and no module is active - the RTC minute event 
+//				then updates the display and services the 1/min modules.
+// @param       none
+// @return      u8		1 = Next second must be serviced, 0 = Clock tick can be stopped
+// *************************************************************************************************
+#ifdef USE_TICKLESS_IDLE
+static u8 timer0_A0_tick_needed(void)
+{
+	// Sync freezes the system state and waits with delays of its own
+	if (sRFsmpl.mode == SIMPLICITI_SYNC) return (0);
+	
+	// Radio, messages, set_value() timeout, backlight and long button presses
+	if (is_rf() || message.all_flags || sys.flag.low_battery || sys.flag.idle_timeout_enabled) return (1);
+	if (sButton.backlight_status || !NO_BUTTON_IS_PRESSED) return (1);
+
+	// Modules that need 1/s processing while active
+#ifndef ELIMINATE_BLUEROBIN
+	if (is_bluerobin() || is_bluerobin_searching()) return (1);
+#endif
+#ifdef CONFIG_ALARM
+	if (sAlarm.state == ALARM_ON) return (1);
+#endif
+#ifdef CONFIG_CYCLE_ALARM
+	if (sCycleAlarm.state == CYCLE_ALARM_RINGING) return (1);
+#endif
+#ifdef CONFIG_EGGTIMER
+	if ((sEggtimer.state == EGGTIMER_RUN) || (sEggtimer.state == EGGTIMER_ALARM)) return (1);
+#endif
+#ifdef CONFIG_STRENGTH
+	if (is_strength()) return (1);
+#endif
+#ifdef CONFIG_TEMP
+	if (is_temp_measurement()) return (1);
+#endif
+#ifdef CONFIG_ALTITUDE
+	if (is_altitude_measurement()) return (1);
+#endif
+#ifdef FEATURE_PROVIDE_ACCEL
+	if (is_acceleration_measurement()) return (1);
+#endif
+
+	// Display content that changes every second (seconds view, sensor values, ...)
+	if ((ptrMenu_L1 != &menu_L1_Time) || (sTime.line1ViewStyle != DISPLAY_DEFAULT_VIEW)) return (1);
+	if ((ptrMenu_L2 != &menu_L2_Date) || (sDate.view == 3)) return (1);
+
+	return (0);
 }
+#endif
+
 
-void Timer0_A1_Stop(void)
+// *************************************************************************************************
+// @fn          Timer0_A0_Reschedule
+// @brief       Called before going to LPM3. If the clock tick is stopped, but a module became active 
+//				in the meantime, start it again at the next RTC second.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void Timer0_A0_Reschedule(void)
 {
-	// Clear timer interrupt    
-	TA0CCTL1 &= ~CCIE; 
+	if (sTimer.second.active) return;
+#ifdef USE_TICKLESS_IDLE
+	if (!timer0_A0_tick_needed()) return;
+#endif
+	
+	// RTCPS counts the ticks since the last RTC second
+	sw_timer_start(&sTimer.second, 32768u - (RTCPS & 0x7FFF) + SECOND_TIMER_MARGIN, 32768u, second_timer_function);
 }
 
 
+// *************************************************************************************************
+// @fn          sw_timer_elapsed
+// @brief       Ticks from sw_timer_ref to now, if the first queued timer is not due yet the 
+//				reference is moved to now.
+// @param       none
+// @return      u16		Ticks since sw_timer_ref (0 after moving the reference)
+// *************************************************************************************************
+static u16 sw_timer_elapsed(void)
+{
+	u16 now = TA0R;
+	u16 elapsed = now - sTimer.sw_timer_ref;
+	
+	// All queued timers expire after now, they keep their order relative to the new reference
+	if ((sTimer.sw_timer_queue == NULL) || (elapsed < (u16)(sTimer.sw_timer_queue->expires - sTimer.sw_timer_ref)))
+	{
+		sTimer.sw_timer_ref = now;
+		return (0);
+	}
+	return (elapsed);
+}
+
 
 // *************************************************************************************************
-// @fn          Timer0_A3_Start
-// @brief       Trigger IRQ every "ticks" microseconds
-// @param       ticks (1 tick = 1/32768 sec)
+// @fn          sw_timer_insert
+// @brief       Sort timer into deadline queue. Interrupts must be disabled.
+// @param       struct sw_timer * t		Timer
+//				u32 distance			Ticks from sw_timer_ref to expiry
 // @return      none
 // *************************************************************************************************
-void Timer0_A3_Start(u16 ticks)
+static void sw_timer_insert(struct sw_timer * t, u32 distance)
 {
-	u16 value;
+	struct sw_timer ** pos = &sTimer.sw_timer_queue;
 	
-	// Store timer ticks in global variable
-	sTimer.timer0_A3_ticks = ticks;
+	// A due timer was not serviced yet and the new deadline is more than 2 sec after it - expire
+	// a few ticks early instead of wrapping around
+	if (distance > 0xFFFF) distance = 0xFFFF;
+	t->expires = sTimer.sw_timer_ref + (u16)distance;
 	
-	// Delay based on current counter value
-	value = TA0R + ticks;
+	// Timers with the same deadline expire in the order they were started
+	while ((*pos != NULL) && ((u16)((*pos)->expires - sTimer.sw_timer_ref) <= distance)) pos = &(*pos)->next;
+	t->next = *pos;
+	*pos = t;
+	t->active = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          sw_timer_remove
+// @brief       Take timer out of deadline queue. Interrupts must be disabled.
+// @param       struct sw_timer * t		Timer
+// @return      none
+// *************************************************************************************************
+static void sw_timer_remove(struct sw_timer * t)
+{
+	struct sw_timer ** pos = &sTimer.sw_timer_queue;
 	
-	// Update CCR
-	TA0CCR3 = value;   
+	while (*pos != NULL)
+	{
+		if (*pos == t)
+		{
+			*pos = t->next;
+			break;
+		}
+		pos = &(*pos)->next;
+	}
+	t->active = 0;
+}
+
 
+// *************************************************************************************************
+// @fn          sw_timer_program
+// @brief       Load TA0CCR0 with the first deadline of the queue. Interrupts must be disabled.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void sw_timer_program(void)
+{
+	if (sTimer.sw_timer_queue == NULL)
+	{
+		// Queue is empty, disable timer interrupt    
+		TA0CCTL0 &= ~CCIE; 
+		return;
+	}
+	
+	// Update CCR
+	TA0CCR0 = sTimer.sw_timer_queue->expires;
+	
 	// Reset IRQ flag    
-	TA0CCTL3 &= ~CCIFG; 
-	          
+	TA0CCTL0 &= ~CCIFG; 
+	
+	// Counter reached deadline before CCR was written, there will be no compare event
+	if ((u16)(TA0R - sTimer.sw_timer_ref) >= (u16)(sTimer.sw_timer_queue->expires - sTimer.sw_timer_ref))
+	{
+		TA0CCTL0 |= CCIFG;
+	}
+	
 	// Enable timer interrupt    
-	TA0CCTL3 |= CCIE; 
+	TA0CCTL0 |= CCIE; 
 }
 
 
+// *************************************************************************************************
+// @fn          sw_timer_start
+// @brief       Start or restart a software timer. The function is called from TIMER0_A0_ISR
+//				"ticks" after now and then every "period" ticks. Timers are multiplexed on Timer0_A0,
+//				any number of them can run at the same time. 
+// @param       struct sw_timer * t			Timer, must stay valid until it expires or is stopped
+//				u16 ticks					Delay to first call (1 tick = 1/32768 sec)
+//				u16 period					Interval of following calls, 0 = one-shot
+//				void (*function)(void)		Callback, runs in interrupt context
+// @return      none
+// *************************************************************************************************
+void sw_timer_start(struct sw_timer * t, u16 ticks, u16 period, void (*function)(void))
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	__disable_interrupt();
+	
+	if (t->active) sw_timer_remove(t);
+	t->period   = period;
+	t->function = function;
+	sw_timer_insert(t, (u32)sw_timer_elapsed() + ticks);
+	sw_timer_program();
+	
+	__set_interrupt_state(int_state);
+}
+
 
 // *************************************************************************************************
-// @fn          Timer0_A3_Stop
-// @brief       Stop Timer0_A3.
+// @fn          sw_timer_stop
+// @brief       Stop a software timer. Stopping an inactive timer does nothing.
+// @param       struct sw_timer * t		Timer
+// @return      none
+// *************************************************************************************************
+void sw_timer_stop(struct sw_timer * t)
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	__disable_interrupt();
+	
+	if (t->active) 
+	{
+		sw_timer_remove(t);
+		sw_timer_program();
+	}
+	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          sw_timer_service
+// @brief       Call all timers that are due and reload periodic ones. Periodic timers are reloaded 
+//				from their last deadline, so they do not drift. A function may stop or restart its 
+//				own timer or change its period for the next reload.
 // @param       none
 // @return      none
 // *************************************************************************************************
-void Timer0_A3_Stop(void)
+static void sw_timer_service(void)
 {
-	// Clear timer interrupt    
-	TA0CCTL3 &= ~CCIE; 
+	struct sw_timer * t;
+	
+	while (((t = sTimer.sw_timer_queue) != NULL) && 
+		   ((u16)(TA0R - sTimer.sw_timer_ref) >= (u16)(t->expires - sTimer.sw_timer_ref)))
+	{
+		// Remove from head, the deadline becomes the new reference
+		sTimer.sw_timer_queue = t->next;
+		sTimer.sw_timer_ref   = t->expires;
+		
+		// Reload before calling, so the function can still modify or stop its timer
+		if (t->period != 0)	sw_timer_insert(t, t->period);
+		else				t->active = 0;
+		
+		t->function();
+	}
+	sw_timer_program();
 }
 
 
@@ -249,11 +562,27 @@ void Timer0_A3_Stop(void)
 // @return      none
 // *************************************************************************************************
 void Timer0_A4_Delay(u16 ticks)
+{
+	Timer0_A4_DelayUntil(ticks, 0, 0);
+}
+
+
+// *************************************************************************************************
+// @fn          Timer0_A4_DelayUntil
+// @brief       Wait in LPM3 like Timer0_A4_Delay, but return early when (*flag & mask) is set.
+//				The flag is checked whenever an interrupt ends LPM.
+// @param       ticks (1 tick = 1/32768 sec)
+//				volatile u8 * flag		Early-out flag, 0 = none
+//				u8 mask					Early-out bits in *flag
+// @return      u8						1 = Delay cut short by flag
+// *************************************************************************************************
+u8 Timer0_A4_DelayUntil(u16 ticks, volatile u8 * flag, u8 mask)
 {
 	u16 value;
+	u8 aborted = 0;
 	
 	// Exit immediately if Timer0 not running - otherwise we'll get stuck here
-	if ((TA0CTL & (BIT4 | BIT5)) == 0) return;    
+	if ((TA0CTL & (BIT4 | BIT5)) == 0) return (0);    
 
 	// Disable timer interrupt    
 	TA0CCTL4 &= ~CCIE; 	
@@ -276,115 +605,77 @@ void Timer0_A4_Delay(u16 ticks)
 	// Wait for timer IRQ
 	while (1)
 	{
+		// Check stop condition with interrupts disabled - to_lpm() enables them together with LPM3,
+		// so the IRQ cannot hit between the check and going to sleep
+		__disable_interrupt();
+		if (sys.flag.delay_over) break;
+		if (flag && (*flag & mask))
+		{
+			// Cancel the pending delay IRQ
+			TA0CCTL4 &= ~CCIE;
+			aborted = 1;
+			break;
+		}
+
 		// Delay in LPM
 		to_lpm();
 
 #ifdef USE_WATCHDOG		
 		// Service watchdog
-		WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
 #endif
 #ifdef CONFIG_STOP_WATCH
 		// Redraw stopwatch display
 		if (is_stopwatch_run()) display_stopwatch(LINE2, DISPLAY_LINE_UPDATE_PARTIAL);
 #endif
-
-		// Check stop condition
-		if (sys.flag.delay_over) break;
 	}
+	__enable_interrupt();
+	
+	return (aborted);
 }
 
 
 
 // *************************************************************************************************
-// @fn          TIMER0_A0_ISR
-// @brief       IRQ handler for TIMER0_A0 IRQ
-//				Timer0_A0	1/1sec clock tick 			(serviced by function TIMER0_A0_ISR)
-//				Timer0_A1	 							(serviced by function TIMER0_A1_5_ISR)
-//				Timer0_A2	1/100 sec Stopwatch			(serviced by function TIMER0_A1_5_ISR)
-//				Timer0_A3	Configurable periodic IRQ	(serviced by function TIMER0_A1_5_ISR)
-//				Timer0_A4	One-time delay				(serviced by function TIMER0_A1_5_ISR)
+// @fn          second_timer_function
+// @brief       1/s clock tick, called by the software timer service right after each RTC second.
+//				With tickless idle the timer stops itself when no module needs it.
 // @param       none
 // @return      none
 // *************************************************************************************************
-//pfs 
-#ifdef __GNUC__  
-#include <signal.h>
-interrupt (TIMER0_A0_VECTOR) TIMER0_A0_ISR(void)
-#else
-#pragma vector = TIMER0_A0_VECTOR
-__interrupt void TIMER0_A0_ISR(void)
-#endif
+static void second_timer_function(void)
 {
 	static u8 button_lock_counter = 0;
 	static u8 button_beep_counter = 0;
 	
-	// Disable IE 
-	TA0CCTL0 &= ~CCIE;
-	// Reset IRQ flag  
-	TA0CCTL0 &= ~CCIFG;  
-	// Add 1 sec to TACCR0 register (IRQ will be asserted at 0x7FFF and 0xFFFF = 1 sec intervals)
-	TA0CCR0 += 32768;
-	// Enable IE 
-	TA0CCTL0 |= CCIE;
-	
-	// Add 1 second to global time
-	clock_tick();
+	// Bring global time up to the RTC
+	Rtc_Sync();
 	
 	// Set clock update flag
 	display.flag.update_time = 1;
 	
+#ifdef USE_TICKLESS_IDLE
+	// Stop clock tick if nobody needs it, the RTC minute event takes over
+	if (!timer0_A0_tick_needed())
+	{
+		sw_timer_stop(&sTimer.second);
+		
+		// No button is pressed, reset long button press detection
+		button_lock_counter  = 0;
+		sButton.star_timeout = 0;
+		sButton.num_timeout  = 0;
+		return;
+	}
+#endif
+	
 	// While SimpliciTI stack operates or BlueRobin searches, freeze system state
 	//pfs
 	#ifdef ELIMINATE_BLUEROBIN
-	if (is_rf())
+	if (is_rf()) return;
 	#else
-	if (is_rf() || is_bluerobin_searching()) 
+	if (is_rf() || is_bluerobin_searching()) return;
 	#endif
-	{
-		// SimpliciTI automatic timeout
-		if (sRFsmpl.timeout == 0) 
-		{
-			simpliciti_flag |= SIMPLICITI_TRIGGER_STOP;
-		}
-		else
-		{
-			sRFsmpl.timeout--;
-		}
-		
-		// Exit from LPM3 on RETI
-		_BIC_SR_IRQ(LPM3_bits);     
-		return;
-	}
 	
-	// -------------------------------------------------------------------
-	// Service modules that require 1/min processing
-	if (sTime.drawFlag >= 2) 
-	{
-		#ifdef CONFIG_BATTERY
-		// Measure battery voltage to keep track of remaining battery life
-		request.flag.voltage_measurement = 1;
-		#endif
-		#ifdef CONFIG_ALARM
-		// If the chime is enabled, we beep here
-		if (sTime.minute == 0) {
-			if (sAlarm.hourly == ALARM_ENABLED) {
-				request.flag.alarm_buzzer = 1;
-			}
-		}
-		// Check if alarm needs to be turned on
-		check_alarm();
-		#endif
-		#ifdef CONFIG_CYCLE_ALARM
-		// Check if cycle alarm needs to be turned on
-		check_cycle_alarm();
-		#endif
-		#ifdef CONFIG_ALTI_ACCUMULATOR
-		// Check if we need to do an altitude accumulation
-		if (alt_accum_enable)
-			request.flag.altitude_accumulator = 1;
-		#endif
-	}
-
 	// -------------------------------------------------------------------
 	// Service active modules that require 1/s processing
 #ifdef CONFIG_EGGTIMER
@@ -470,8 +761,16 @@ __interrupt void TIMER0_A0_ISR(void)
 		
 		// In case we missed the IRQ due to debouncing, get data now
 		if ((PS_INT_IN & PS_INT_PIN) == PS_INT_PIN) request.flag.altitude_measurement = 1;
+#ifdef CONFIG_ALTI_KALMAN
+		// Same for acceleration samples feeding the altitude estimator
+		if ((AS_INT_IE & AS_INT_PIN) && ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN)) request.flag.acceleration_measurement = 1;
+#endif
 	}	
 #endif
+#ifdef CONFIG_ALTI_ACCUMULATOR
+	// Triggered samples of the altitude accumulator can miss their IRQ as well
+	if (is_altitude_accumulator() && ((PS_INT_IN & PS_INT_PIN) == PS_INT_PIN)) request.flag.altitude_measurement = 1;
+#endif
 
 #ifdef FEATURE_PROVIDE_ACCEL
 	// Count down timeout
@@ -486,6 +785,14 @@ __interrupt void TIMER0_A0_ISR(void)
 		// If DRDY is (still) high, request data again
 		if ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN) request.flag.acceleration_measurement = 1; 
 	}	
+#ifdef CONFIG_PEDOMETER
+	// Same for background samples of the pedometer
+	else if (is_pedometer() && ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN)) request.flag.acceleration_measurement = 1;
+#endif
+#ifdef CONFIG_FLICK_BACKLIGHT
+	// Same for the 40Hz samples of the wrist flick detector
+	else if ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN) request.flag.acceleration_measurement = 1;
+#endif
 #endif
 
 	//pfs
@@ -542,6 +849,7 @@ __interrupt void TIMER0_A0_ISR(void)
 			P2DIR &= ~BUTTON_BACKLIGHT_PIN;
 			sButton.backlight_timeout = 0;
 			sButton.backlight_status = 0;
+			ENERGY_STOP(ENERGY_BACKLIGHT);
 		}
 		else
 		{
@@ -619,6 +927,127 @@ __interrupt void TIMER0_A0_ISR(void)
 			sButton.num_timeout = 0;
 		}
 	}
+}
+
+
+// *************************************************************************************************
+// @fn          TIMER0_A0_ISR
+// @brief       IRQ handler for TIMER0_A0 IRQ
+//				Timer0_A0	Software timer queue, 1/s clock tick	(serviced by function TIMER0_A0_ISR)
+//				Timer0_A1	 										(serviced by function TIMER0_A1_5_ISR)
+//				Timer0_A2	1/100 sec Stopwatch						(serviced by function TIMER0_A1_5_ISR)
+//				Timer0_A4	One-time delay							(serviced by function TIMER0_A1_5_ISR)
+// @param       none
+// @return      none
+// *************************************************************************************************
+//pfs 
+#ifdef __GNUC__  
+#include <signal.h>
+interrupt (TIMER0_A0_VECTOR) TIMER0_A0_ISR(void)
+#else
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void)
+#endif
+{
+	ENERGY_ENTER(ENERGY_TIMER0_A0);
+	
+	// Call all functions that are due and load CCR with next deadline
+	sw_timer_service();
+	
+	ENERGY_EXIT(ENERGY_TIMER0_A0);
+	
+	// Exit from LPM3 on RETI
+	_BIC_SR_IRQ(LPM3_bits);               
+}
+
+
+// *************************************************************************************************
+// @fn          RTC_ISR
+// @brief       IRQ handler for the RTC minute event. Brings global time up to date and services 
+//				modules that require 1/min processing, whether the clock tick runs or not.
+// @param       none
+// @return      none
+// *************************************************************************************************
+#ifdef __GNUC__  
+#include <signal.h>
+interrupt (RTC_VECTOR) RTC_ISR(void)
+#else
+#pragma vector = RTC_VECTOR
+__interrupt void RTC_ISR(void)
+#endif
+{
+	ENERGY_ENTER(ENERGY_RTC);
+	
+	// Minute changed - reading RTCIV resets RTCTEVIFG
+	if (RTCIV == RTC_RTCTEVIFG)
+	{
+		// Add the seconds since the last clock tick to global time
+		Rtc_Sync();
+		
+		// Set clock update flag
+		display.flag.update_time = 1;
+		
+		// While SimpliciTI stack operates or BlueRobin searches, freeze system state
+		//pfs
+		#ifdef ELIMINATE_BLUEROBIN
+		if (is_rf())
+		#else
+		if (is_rf() || is_bluerobin_searching()) 
+		#endif
+		{
+			// SimpliciTI automatic timeout
+			if (sRFsmpl.timeout < 60) 
+			{
+				simpliciti_flag |= SIMPLICITI_TRIGGER_STOP;
+			}
+			else
+			{
+				sRFsmpl.timeout -= 60;
+			}
+		}
+		else
+		{
+			// -------------------------------------------------------------------
+			// Service modules that require 1/min processing
+			#ifdef CONFIG_BATTERY
+			// Measure battery voltage to keep track of remaining battery life
+			request.flag.voltage_measurement = 1;
+			#endif
+			#ifdef CONFIG_ALARM
+			// If the chime is enabled, we beep here
+			if (sTime.minute == 0) {
+				if (sAlarm.hourly == ALARM_ENABLED) {
+					request.flag.alarm_buzzer = 1;
+				}
+			}
+			// Check if alarm needs to be turned on
+			check_alarm();
+			#endif
+			#ifdef CONFIG_CYCLE_ALARM
+			// Check if cycle alarm needs to be turned on
+			check_cycle_alarm();
+			#endif
+			#ifdef CONFIG_ALTI_ACCUMULATOR
+			// Check if we need to do an altitude accumulation
+			if (alt_accum_enable)
+				request.flag.altitude_accumulator = 1;
+			#endif
+			#ifdef CONFIG_DATALOG
+			// Add data logger record at full intervals
+			if ((sTime.minute % DATALOG_INTERVAL) == 0) request.flag.datalog = 1;
+			#endif
+			#ifdef CONFIG_PHASE_CLOCK
+			// One sleep phase epoch per minute
+			if (sPhase.recording) request.flag.phase_clock = 1;
+			#endif
+			#ifdef CONFIG_PEDOMETER
+			// Close pedometer minute
+			if (is_pedometer()) request.flag.pedometer = 1;
+			#endif
+		}
+	}
+	
+	ENERGY_EXIT(ENERGY_RTC);
 	
 	// Exit from LPM3 on RETI
 	_BIC_SR_IRQ(LPM3_bits);               
@@ -628,10 +1057,9 @@ __interrupt void TIMER0_A0_ISR(void)
 // *************************************************************************************************
 // @fn          Timer0_A1_5_ISR
 // @brief       IRQ handler for timer IRQ.
-//				Timer0_A0	1/1sec clock tick (serviced by function TIMER0_A0_ISR)
-//				Timer0_A1	BlueRobin timer / doorlock
+//				Timer0_A0	Software timer queue (serviced by function TIMER0_A0_ISR)
+//				Timer0_A1	BlueRobin timer
 //				Timer0_A2	1/100 sec Stopwatch
-//				Timer0_A3	Configurable periodic IRQ (used by button_repeat and buzzer)
 //				Timer0_A4	One-time delay
 // @param       none
 // @return      none
@@ -645,8 +1073,8 @@ interrupt (TIMER0_A1_VECTOR) TIMER0_A1_5_ISR(void)
 __interrupt void TIMER0_A1_5_ISR(void)
 #endif
 {
-	u16 value;
-		
+	ENERGY_ENTER(ENERGY_TIMER0_A1_5);
+	
 	switch (TA0IV)
 	{
 	//pfs
@@ -655,48 +1083,6 @@ __interrupt void TIMER0_A1_5_ISR(void)
 		case 0x02:	// Timer0_A1 handler
 					BRRX_TimerTask_v();
 					break;
-	#endif
-	#ifdef CONFIG_SIDEREAL
-		// Timer0_A1	Used for sidereal time until CCR0 becomes free
-		case 0x02:  // Timer0_A1 handler
-				// Disable IE 
-				TA0CCTL1 &= ~CCIE;
-				// Reset IRQ flag  
-				TA0CCTL1 &= ~CCIFG;  
-				//for sidereal time we need 32768/1.00273790935=32678.529149 clock cycles for one second
-				//32678.5 clock cycles gives a deviation of ~0.9e-7~0.1s/day which is likely less than the ozillator deviation
-				if(sSidereal_time.second & 1)
-				{
-					TA0CCR1+=32678;
-				}
-				else
-				{
-					TA0CCR1+=32679;
-				}
-				// Enable IE 
-				TA0CCTL1 |= CCIE;
-				
-				// Add 1 second to global time
-				sidereal_clock_tick();
-				
-				// Set clock update flag
-				display.flag.update_sidereal_time = 1;
-				break;
-	#endif
-	#ifdef CONFIG_USE_GPS
-		case 0x02: // Disable IE
-							TA0CCTL1 &= ~CCIE;
-							// Reset IRQ flag
-							TA0CCTL1 &= ~CCIFG;
-							// Store new value in CCR
-							value = TA0R + sTimer.timer0_A1_ticks; //timer0_A1_ticks_g;
-							// Load CCR register with next capture point
-							TA0CCR1 = value;
-							// Enable timer interrupt
-							TA0CCTL1 |= CCIE;
-							// Call function handler
-							fptr_Timer0_A1_function();
-							break;
 	#endif
 		// Timer0_A2	1/1 or 1/100 sec Stopwatch				
 		case 0x04:	// Timer0_A2 handler
@@ -715,21 +1101,6 @@ __interrupt void TIMER0_A1_5_ISR(void)
 					stopwatch_tick();
 #endif
 					break;
-					
-		// Timer0_A3	Configurable periodic IRQ (used by button_repeat and buzzer)			
-		case 0x06:	// Disable IE 
-					TA0CCTL3 &= ~CCIE;
-					// Reset IRQ flag  
-					TA0CCTL3 &= ~CCIFG;  
-					// Store new value in CCR
-					value = TA0R + sTimer.timer0_A3_ticks; //timer0_A3_ticks_g;
-					// Load CCR register with next capture point
-					TA0CCR3 = value;   
-					// Enable timer interrupt    
-					TA0CCTL3 |= CCIE; 	
-					// Call function handler
-					fptr_Timer0_A3_function();
-					break;
 		
 		// Timer0_A4	One-time delay			
 		case 0x08:	// Disable IE 
@@ -741,6 +1112,8 @@ __interrupt void TIMER0_A1_5_ISR(void)
 					break;
 	}
 	
+	ENERGY_EXIT(ENERGY_TIMER0_A1_5);
+	
 	// Exit from LPM3 on RETI
 	_BIC_SR_IRQ(LPM3_bits);               
 }
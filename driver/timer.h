@@ -45,25 +45,46 @@
 extern void Timer0_Init(void);
 extern void Timer0_Start(void);
 extern void Timer0_Stop(void);
-extern void Timer0_A1_Start(u16 ticks);
-extern void Timer0_A1_Stop(void);
-extern void Timer0_A3_Start(u16 ticks);
-extern void Timer0_A3_Stop(void);
+extern void Rtc_Init(void);
+extern void Rtc_SetTime(u8 hour, u8 minute, u8 second);
+extern void Rtc_Sync(void);
+extern u32 Rtc_GetTicks(void);
+extern void Timer0_A0_Reschedule(void);
+struct sw_timer;
+extern void sw_timer_start(struct sw_timer * t, u16 ticks, u16 period, void (*function)(void));
+extern void sw_timer_stop(struct sw_timer * t);
 extern void Timer0_A4_Delay(u16 ticks);
-extern void (*fptr_Timer0_A3_function)(void);
-#ifdef CONFIG_USE_GPS
-extern void (*fptr_Timer0_A1_function)(void);
-#endif
+extern u8 Timer0_A4_DelayUntil(u16 ticks, volatile u8 * flag, u8 mask);
 
 
 // *************************************************************************************************
 // Defines section
+// ACLK ticks per day, Rtc_GetTicks() wraps at midnight
+#define RTC_TICKS_PER_DAY		(86400ul * 32768ul)
+
+// Software timer, multiplexed on Timer0_A0 with all other software timers
+struct sw_timer
+{
+	// Next timer in deadline queue
+	struct sw_timer *	next;
+	// TA0R value of next expiry
+	u16		expires;
+	// Reload ticks after expiry, 0 = one-shot
+	u16		period;
+	// Called from TIMER0_A0_ISR on expiry
+	void	(*function)(void);
+	// 1 = Timer is queued
+	u8		active;
+};
+
 struct timer
 {
-	// Timer0_A1 periodic delay
-	u16		timer0_A1_ticks;
-		// Timer0_A3 periodic delay
-	u16		timer0_A3_ticks;
+	// Software timers, sorted by deadline
+	struct sw_timer *	sw_timer_queue;
+	// TA0R reference for deadline comparisons - no queued timer expires before it
+	u16		sw_timer_ref;
+	// 1/s clock tick, follows the RTC seconds
+	struct sw_timer		second;
 };
 extern struct timer sTimer;
 
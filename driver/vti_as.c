@@ -69,11 +69,23 @@ void as_disconnect(void)
 // Prototypes section
 void as_start(void);
 void as_stop(void);
+void as_start_background(u8 mode, u8 block);
+void as_stop_background(void);
+static void as_power_on(void);
+static void as_power_up(void);
+static void as_power_down(void);
+static void as_configure(u8 mode);
 u8 as_read_register(u8 bAddress);
 u8 as_write_register(u8 bAddress, u8 bData);
 u8 as_get_x(void);
 u8 as_get_y(void);
 u8 as_get_z(void);
+u8 as_look(void);
+u8 as_push_sample(void);
+void as_poll(void);
+u8 as_pop_sample(u8 * xyz);
+u8 as_samples_available(void);
+void as_set_block(u8 block);
 
 // *************************************************************************************************
 // Defines section
@@ -94,6 +106,13 @@ u8 as_get_z(void);
 // Valid sample rates for 8g range are: 40, 100, 400
 #define AS_SAMPLE_RATE       (400u)
 
+// CTRL register values of the background modes (8g range, interrupt active high)
+#define AS_CTRL_40HZ         (0x06)    // Measurement mode 40Hz
+#define AS_CTRL_MOTION       (0x08)    // Motion detection mode, 10Hz internal sampling
+
+// First 40Hz sample is ready 25ms after configuring the sensor
+#define AS_LOOK_TICKS        (CONV_MS_TO_TICKS(26))
+
 
 // *************************************************************************************************
 // Global Variable section
@@ -101,6 +120,9 @@ u8 as_get_z(void);
 // Global flag for proper acceleration sensor operation
 u8 as_ok;
 
+// Sample ring buffer (single producer: PORT2 ISR, single consumer: main loop)
+struct as_ring sAsRing;
+
 
 // *************************************************************************************************
 // Extern section
@@ -138,20 +160,21 @@ void as_init(void)
 
 	// Reset global sensor flag
 	as_ok = 1;
+	
+	// Wake up main loop once per block of samples
+	sAsRing.block = AS_BLOCK_DEFAULT;
 }
 
 
 // *************************************************************************************************
-// @fn          as_start
-// @brief       Power-up and initialize acceleration sensor
+// @fn          as_power_on
+// @brief       Power-up acceleration sensor and wait until it can be configured. A sensor that was
+//				switched off comes out of its power-on reset.
 // @param       none
 // @return      none
 // *************************************************************************************************
-void as_start(void)
+static void as_power_on(void)
 {
-	volatile u16 Counter_u16;
-	u8 bConfig;//, bStatus;
-	
 	// Initialize SPI interface to acceleration sensor
 	AS_SPI_CTL0 |= UCSYNC | UCMST | UCMSB // SPI master, 8 data bits,  MSB first,
 	               | UCCKPH;              //  clock idle low, data output on falling edge
@@ -175,11 +198,76 @@ void as_start(void)
 
 	// Delay of >5ms required between switching on power and configuring sensor
 	Timer0_A4_Delay(CONV_MS_TO_TICKS(10));
+}
+
+
+// *************************************************************************************************
+// @fn          as_power_up
+// @brief       Power-up and reset acceleration sensor. The sensor does not sample until it is
+//				configured.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void as_power_up(void)
+{
+	as_power_on();
 	
-	// Initialize interrupt pin for data read out from acceleration sensor
-	AS_INT_IFG &= ~AS_INT_PIN;            // Reset flag
-	AS_INT_IE  |=  AS_INT_PIN;            // Enable interrupt
+	// Reset sensor
+	as_write_register(0x04, 0x02);   
+	as_write_register(0x04, 0x0A);   
+	as_write_register(0x04, 0x04);   
 	
+	// Wait 5 ms before starting sensor output
+	Timer0_A4_Delay(CONV_MS_TO_TICKS(5));
+}
+
+
+// *************************************************************************************************
+// @fn          as_power_down
+// @brief       Power down acceleration sensor
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void as_power_down(void)
+{
+#ifdef AS_DISCONNECT
+	// Power-down sensor
+	AS_PWR_OUT &= ~AS_PWR_PIN;            	// Power off
+	AS_INT_OUT &= ~AS_INT_PIN;            	// Pin to low to avoid floating pins
+	AS_SPI_OUT &= ~(AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN); // Pins to low to avoid floating pins
+	AS_SPI_SEL &= ~(AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN); // Port pins to I/O function
+	AS_CSN_OUT &= ~AS_CSN_PIN; 				// Pin to low to avoid floating pins
+	AS_INT_DIR |= AS_INT_PIN;            	// Pin to output to avoid floating pins
+	AS_SPI_DIR |= AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN;    // Pins to output to avoid floating pins
+	AS_CSN_DIR |= AS_CSN_PIN;				// Pin to output to avoid floating pins
+#else
+	// Reset sensor -> sensor to powerdown
+	as_write_register(0x04, 0x02);   
+	as_write_register(0x04, 0x0A);   
+	as_write_register(0x04, 0x04);   
+#endif
+}
+
+
+// *************************************************************************************************
+// @fn          as_configure
+// @brief       Switch powered sensor to another mode. Only the CTRL register is written, so this
+//				does not wait and may be called from interrupt context.
+// @param       u8 mode		AS_MODE_FULL, AS_MODE_40HZ or AS_MODE_MOTION
+// @return      none
+// *************************************************************************************************
+static void as_configure(u8 mode)
+{
+	u8 bConfig;
+	istate_t int_state = __get_interrupt_state();
+	
+	switch (mode)
+	{
+		case AS_MODE_40HZ:		bConfig = AS_CTRL_40HZ;
+								break;
+		case AS_MODE_MOTION:	bConfig = AS_CTRL_MOTION;
+								break;
+		default:
 	// Configure sensor and start to sample data
 #if (AS_RANGE == 2)
   bConfig = 0x80;
@@ -204,48 +292,112 @@ void as_start(void)
 #else
   #error "Measurement range not supported"    
 #endif  
-
-	// Reset sensor
-	as_write_register(0x04, 0x02);   
-	as_write_register(0x04, 0x0A);   
-	as_write_register(0x04, 0x04);   
+								break;
+	}
 	
-	// Wait 5 ms before starting sensor output
-	Timer0_A4_Delay(CONV_MS_TO_TICKS(5));
+	__disable_interrupt();
 	
-	// Set 2g measurement range, start to output data with 100Hz rate
+	// Discard samples left over from previous mode
+	sAsRing.head = 0;
+	sAsRing.tail = 0;
+	sAsRing.motion = 0;
+	sAsRing.mode = mode;
+	
+	// Any axis changing by more than the threshold raises INT
+	if (mode == AS_MODE_MOTION) as_write_register(0x09, AS_MOTION_THRESHOLD);
+	
+	// Initialize interrupt pin for data read out from acceleration sensor
+	AS_INT_IFG &= ~AS_INT_PIN;            // Reset flag
+	AS_INT_IE  |=  AS_INT_PIN;            // Enable interrupt
+	
+	// Set measurement range and start to output data (or wait for motion)
 	as_write_register(0x02, bConfig);   
+	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          as_start
+// @brief       Power-up and initialize acceleration sensor for full rate measurement. A sensor
+//				running in background mode is switched over without a power cycle.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void as_start(void)
+{
+	if (sAsRing.mode == AS_MODE_OFF) as_power_up();
+	
+	// Background mode may have changed the block size
+	sAsRing.block = AS_BLOCK_DEFAULT;
+	
+	as_configure(AS_MODE_FULL);
 }
 
 
 
 // *************************************************************************************************
 // @fn          as_stop
-// @brief       Power down acceleration sensor
+// @brief       Stop full rate measurement. The sensor returns to background mode if a background
+//				user is active, otherwise it is powered down.
 // @param       none
 // @return      none
 // *************************************************************************************************
 void as_stop(void)
 {
+	if (sAsRing.background != AS_MODE_OFF)
+	{
+		if (sAsRing.mode == AS_MODE_OFF) as_power_up();
+		sAsRing.block = sAsRing.background_block;
+		as_configure(sAsRing.background);
+		return;
+	}
+	
 	// Disable interrupt 
 	AS_INT_IE  &=  ~AS_INT_PIN;            	// Disable interrupt
+	
+	// Restore default block size for next user
+	sAsRing.block = AS_BLOCK_DEFAULT;
+	sAsRing.mode  = AS_MODE_OFF;
 
-#ifdef AS_DISCONNECT
-	// Power-down sensor
-	AS_PWR_OUT &= ~AS_PWR_PIN;            	// Power off
-	AS_INT_OUT &= ~AS_INT_PIN;            	// Pin to low to avoid floating pins
-	AS_SPI_OUT &= ~(AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN); // Pins to low to avoid floating pins
-	AS_SPI_SEL &= ~(AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN); // Port pins to I/O function
-	AS_CSN_OUT &= ~AS_CSN_PIN; 				// Pin to low to avoid floating pins
-	AS_INT_DIR |= AS_INT_PIN;            	// Pin to output to avoid floating pins
-	AS_SPI_DIR |= AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN;    // Pins to output to avoid floating pins
-	AS_CSN_DIR |= AS_CSN_PIN;				// Pin to output to avoid floating pins
-#else
-	// Reset sensor -> sensor to powerdown
-	as_write_register(0x04, 0x02);   
-	as_write_register(0x04, 0x0A);   
-	as_write_register(0x04, 0x04);   
-#endif
+	as_power_down();
+}
+
+
+// *************************************************************************************************
+// @fn          as_start_background
+// @brief       Run the sensor in a low power mode while no full rate measurement is active. While
+//				one is, the mode is only stored and entered by as_stop. Changing between the
+//				background modes does not power cycle the sensor.
+// @param       u8 mode		AS_MODE_40HZ (samples) or AS_MODE_MOTION (wakeup on movement)
+//				u8 block	Samples per main loop wakeup
+// @return      none
+// *************************************************************************************************
+void as_start_background(u8 mode, u8 block)
+{
+	sAsRing.background = mode;
+	sAsRing.background_block = block;
+	
+	if (sAsRing.mode == AS_MODE_FULL) return;
+	
+	if (sAsRing.mode == AS_MODE_OFF) as_power_up();
+	as_set_block(block);
+	as_configure(mode);
+}
+
+
+// *************************************************************************************************
+// @fn          as_stop_background
+// @brief       End background mode, the sensor is powered down unless a full rate measurement 
+//				is running.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void as_stop_background(void)
+{
+	sAsRing.background = AS_MODE_OFF;
+	
+	if (sAsRing.mode != AS_MODE_FULL && sAsRing.mode != AS_MODE_OFF) as_stop();
 }
 
 
@@ -388,4 +540,135 @@ u8 as_get_z(void)
 }
 
 
+// *************************************************************************************************
+// @fn          as_look
+// @brief       Power up the sensor for a single 40Hz sample and power it down again. Skips the 
+//				reset of as_power_up and reads Z only, to keep a look short. Must not be called 
+//				while the sensor is in use.
+// @param       none
+// @return      u8		Raw Z sample (8g range)
+// *************************************************************************************************
+u8 as_look(void)
+{
+	u8 z;
+	
+	as_power_on();
+	as_write_register(0x02, AS_CTRL_40HZ);
+	Timer0_A4_Delay(AS_LOOK_TICKS);
+	z = as_read_register(0x08);
+	as_power_down();
+	
+	return (z);
+}
+
+
+// *************************************************************************************************
+// @fn          as_push_sample
+// @brief       Read X/Y/Z sample from sensor into ring buffer. Releases DRDY. In motion detection
+//				mode sets sAsRing.motion instead. Must only be called from interrupt context (or 
+//				with interrupts disabled).
+// @param       none
+// @return      u8		1 = a complete block of samples (or motion) is waiting for the main loop
+// *************************************************************************************************
+u8 as_push_sample(void)
+{
+	u8 head = sAsRing.head;
+	u8 next = (head + 1) & AS_RING_MASK;
+	u8 dummy[3];
+
+	if (sAsRing.mode == AS_MODE_MOTION)
+	{
+		// No sample in motion detection mode, reading INT_STATUS releases INT
+		as_read_register(0x05);
+		sAsRing.motion = 1;
+		return (1);
+	}
+
+	if (next == sAsRing.tail)
+	{
+		// Ring is full - read sample anyway to release DRDY, but drop it
+		as_get_data(dummy);
+		sAsRing.overrun++;
+	}
+	else
+	{
+		as_get_data(sAsRing.xyz[head]);
+		sAsRing.head = next;
+	}
+	
+	return (as_samples_available() >= sAsRing.block);
+}
+
+
+// *************************************************************************************************
+// @fn          as_poll
+// @brief       Fetch a sample whose DRDY edge was missed (e.g. while PORT2 IRQ was disabled 
+//				for button debouncing). Otherwise DRDY would stay high and no further IRQ occurs.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void as_poll(void)
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	__disable_interrupt();
+	if ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN) 
+	{
+		as_push_sample();
+		AS_INT_IFG &= ~AS_INT_PIN;
+	}
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          as_pop_sample
+// @brief       Get oldest sample from ring buffer.
+// @param       u8 * xyz		Destination for X/Y/Z raw data (unchanged if ring is empty)
+// @return      u8				1 = sample copied, 0 = ring is empty
+// *************************************************************************************************
+u8 as_pop_sample(u8 * xyz)
+{
+	u8 tail = sAsRing.tail;
+	
+	if (tail == sAsRing.head) return (0);
+	
+	xyz[0] = sAsRing.xyz[tail][0];
+	xyz[1] = sAsRing.xyz[tail][1];
+	xyz[2] = sAsRing.xyz[tail][2];
+	
+	// Release slot only after sample has been copied
+	sAsRing.tail = (tail + 1) & AS_RING_MASK;
+	
+	return (1);
+}
+
+
+// *************************************************************************************************
+// @fn          as_samples_available
+// @brief       Number of samples waiting in ring buffer.
+// @param       none
+// @return      u8		Number of samples
+// *************************************************************************************************
+u8 as_samples_available(void)
+{
+	return ((sAsRing.head - sAsRing.tail) & AS_RING_MASK);
+}
+
+
+// *************************************************************************************************
+// @fn          as_set_block
+// @brief       Set number of samples collected per main loop wakeup. 
+//				Use 1 for consumers that need to react on every single sample.
+// @param       u8 block		Samples per wakeup (1 .. AS_RING_SIZE-1)
+// @return      none
+// *************************************************************************************************
+void as_set_block(u8 block)
+{
+	if (block == 0) block = 1;
+	if (block > AS_RING_SIZE - 1) block = AS_RING_SIZE - 1;
+	sAsRing.block = block;
+}
+
+
 #endif
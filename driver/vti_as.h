@@ -48,12 +48,20 @@ extern void as_disconnect(void);
 extern void as_init(void);
 extern void as_start(void);
 extern void as_stop(void);
+extern void as_start_background(u8 mode, u8 block);
+extern void as_stop_background(void);
 extern u8 as_read_register(u8 bAddress);
 extern u8 as_write_register(u8 bAddress, u8 bData);
 extern void as_get_data(u8 * data);
 extern u8 as_get_x(void);
 extern u8 as_get_y(void);
 extern u8 as_get_z(void);
+extern u8 as_look(void);
+extern u8 as_push_sample(void);
+extern void as_poll(void);
+extern u8 as_pop_sample(u8 * xyz);
+extern u8 as_samples_available(void);
+extern void as_set_block(u8 block);
 #endif
 
 
@@ -106,9 +114,57 @@ extern u8 as_get_z(void);
 // SPI timeout to detect sensor failure
 #define SPI_TIMEOUT				(1000u)
 
+// Sample ring buffer filled by PORT2 ISR (size must be a power of 2)
+#define AS_RING_SIZE			(32u)
+#define AS_RING_MASK			(AS_RING_SIZE - 1)
+
+// Default number of samples collected before main loop is woken up (16 @ 400Hz = 25 wakeups/s)
+#define AS_BLOCK_DEFAULT		(16u)
+
+// Sensor modes (sAsRing.mode, sAsRing.background)
+#define AS_MODE_OFF				(0u)		// Powered down
+#define AS_MODE_FULL			(1u)		// 2g 400Hz, started by as_start
+#define AS_MODE_40HZ			(2u)		// 8g 40Hz, lowest sample rate
+#define AS_MODE_MOTION			(3u)		// Motion detection, INT on movement, no samples
+
+// Motion detection threshold (8g range, 71mg/digit)
+#define AS_MOTION_THRESHOLD		(2u)
+
 
 // *************************************************************************************************
 // Global Variable section
+#ifdef FEATURE_PROVIDE_ACCEL
+struct as_ring
+{
+	// Raw X/Y/Z samples
+	u8			xyz[AS_RING_SIZE][3];
+	
+	// Write index, only modified by producer (interrupt context)
+	volatile u8	head;
+	
+	// Read index, only modified by consumer (main loop)
+	volatile u8	tail;
+	
+	// Number of samples per main loop wakeup
+	u8			block;
+	
+	// Number of samples dropped because ring was full
+	u16			overrun;
+	
+	// Current sensor mode, AS_MODE_*
+	u8			mode;
+	
+	// Mode entered when full rate measurement stops, AS_MODE_OFF = power down
+	u8			background;
+	
+	// Samples per main loop wakeup in background mode
+	u8			background_block;
+	
+	// 1 = motion detected, set by producer, cleared by consumer
+	volatile u8	motion;
+};
+extern struct as_ring sAsRing;
+#endif
 
 
 // *************************************************************************************************
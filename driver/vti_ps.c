@@ -56,11 +56,19 @@ u16 ps_read_register(u8 address, u8 mode);
 u8 ps_write_register(u8 address, u8 data);
 u8 ps_twi_read(u8 ack);
 void twi_delay(void);
+static u8 ps_select_mode(void);
 
 
 // *************************************************************************************************
 // Defines section
 
+// OPERATION register values
+#define PS_MODE_STANDBY				(0x00u)
+#define PS_MODE_HIGH_SPEED			(0x09u)		// Continuous 9Hz, 15 bit
+#define PS_MODE_HIGH_RES			(0x0Au)		// Continuous 1.8Hz, 17 bit
+#define PS_MODE_ULTRA_LOW_POWER		(0x0Bu)		// Continuous 1Hz, 15 bit
+#define PS_MODE_TRIGGERED			(0x0Cu)		// Single 17 bit sample after ca. 100ms, then standby
+
 
 // *************************************************************************************************
 // Global Variable section
@@ -81,6 +89,17 @@ static s16 hLast; // Last altitude estimate in normalized units b/H0/2^15
 // Global flag for proper pressure sensor operation
 u8 ps_ok;
 
+// Pressure bits 18..16 (DATARD8) and bits 15..0 (DATARD16) of last sample
+static u8 ps_msb;
+static u16 ps_lsb;
+
+// 1 = ps_msb is valid and follows the wrap-arounds of DATARD16, DATARD8 is not read
+static u8 ps_msb_valid;
+
+// Needs of all consumers (PS_NEED_xxx) and mode they were last served with
+static u8 ps_need[PS_USERS];
+static u8 ps_mode;
+
 
 // *************************************************************************************************
 // Extern section
@@ -96,6 +115,7 @@ u8 ps_ok;
 void ps_init(void)
 {
 	volatile u8 success, status, eeprom, timeout;
+	u8 i;
 	
 	PS_INT_DIR &= ~PS_INT_PIN;            	// DRDY is input
 	PS_INT_IES &= ~PS_INT_PIN;				// Interrupt on DRDY rising edge
@@ -104,6 +124,10 @@ void ps_init(void)
 	
 	// Reset global ps_ok flag
 	ps_ok = 0;
+	
+	// Sensor is in standby after reset, nobody needs it yet
+	for (i = 0; i < PS_USERS; i++) ps_need[i] = PS_NEED_NONE;
+	ps_mode = PS_MODE_STANDBY;
 
 	// 100msec delay to allow VDD stabilisation
 	Timer0_A4_Delay(CONV_MS_TO_TICKS(100));
@@ -127,29 +151,88 @@ void ps_init(void)
 
 
 // *************************************************************************************************
-// @fn          ps_start
-// @brief       Init pressure sensor registers and start sampling
+// @fn          ps_select_mode
+// @brief       Cheapest sensor mode that serves all consumers. A fast consumer gets high speed mode 
+//				even if another one asked for high resolution.
 // @param       none
-// @return      u8		1=Sensor started, 0=Sensor did not start
+// @return      u8		PS_MODE_xxx
 // *************************************************************************************************
-void ps_start(void)
+static u8 ps_select_mode(void)
 {
-	// Start sampling data in ultra low power mode 
-	ps_write_register(0x03, 0x0B);  
+	u8 i, rate = PS_NEED_NONE, high_res = 0;
+	
+	for (i = 0; i < PS_USERS; i++)
+	{
+		if ((ps_need[i] & PS_NEED_RATE) > rate) rate = ps_need[i] & PS_NEED_RATE;
+		if (ps_need[i] & PS_NEED_HIGH_RES) high_res = 1;
+	}
+	
+	switch (rate)
+	{
+		case PS_NEED_FAST:		return (PS_MODE_HIGH_SPEED);
+		case PS_NEED_1HZ:		return (high_res ? PS_MODE_HIGH_RES : PS_MODE_ULTRA_LOW_POWER);
+		case PS_NEED_SINGLE:	return (PS_MODE_TRIGGERED);
+		default:				return (PS_MODE_STANDBY);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          ps_start
+// @brief       Set sample rate and resolution a consumer needs and reconfigure the sensor if the 
+//				cheapest mode serving all consumers has changed. DRDY IRQ is enabled while any 
+//				consumer needs samples. Each PS_NEED_SINGLE request triggers a new sample.
+// @param       u8 user		PS_USER_xxx
+//				u8 need		PS_NEED_xxx, optionally | PS_NEED_HIGH_RES
+// @return      none
+// *************************************************************************************************
+void ps_start(u8 user, u8 need)
+{
+	u8 mode;
+	
+	ps_need[user] = need;
+	mode = ps_select_mode();
+	
+	// Continuous modes keep running, a triggered sample is started by writing the mode again
+	if ((mode == ps_mode) && (mode != PS_MODE_TRIGGERED || need != PS_NEED_SINGLE)) return;
+	
+	// Sensor may have been idle for a long time, read full pressure value again
+	if (ps_mode == PS_MODE_STANDBY || ps_mode == PS_MODE_TRIGGERED) ps_msb_valid = 0;
+	
+	if (ps_mode == PS_MODE_STANDBY) 
+	{
+		// Enable DRDY IRQ on rising edge
+		PS_INT_IFG &= ~PS_INT_PIN;
+		PS_INT_IE  |= PS_INT_PIN;
+	}
+	else if (mode != PS_MODE_STANDBY)
+	{
+		// Mode can only be changed from standby
+		ps_write_register(0x03, PS_MODE_STANDBY);
+	}
+	
+	ps_write_register(0x03, mode);
+	ps_mode = mode;
+	
+	if (mode == PS_MODE_STANDBY)
+	{
+		// Disable DRDY IRQ
+		PS_INT_IE  &= ~PS_INT_PIN;
+		PS_INT_IFG &= ~PS_INT_PIN;
+	}
 }
 
 
 
 // *************************************************************************************************
 // @fn          ps_stop
-// @brief       Power down pressure sensor
-// @param       none
+// @brief       Consumer does not need samples any more. Sensor goes to standby after the last one.
+// @param       u8 user		PS_USER_xxx
 // @return      none
 // *************************************************************************************************
-void ps_stop(void)
+void ps_stop(u8 user)
 {
-	// Put sensor to standby
-	ps_write_register(0x03, 0x00);   
+	ps_start(user, PS_NEED_NONE);
 }
 
 
@@ -293,10 +376,11 @@ u8 ps_twi_read(u8 ack)
 		if ((PS_TWI_IN & PS_SDA_PIN) == PS_SDA_PIN) data |= BIT0; 
 	}
 
-	PS_TWI_SDA_OUT;			// SDA is output
-	
 	// 1 aditional clock phase to generate master ACK
 	PS_TWI_SCL_LO;			// SCL=0
+	
+	// Take over SDA only now, while SCL=1 a level change would be a start or stop condition
+	PS_TWI_SDA_OUT;			// SDA is output
 	if (ack == 1)	PS_TWI_SDA_LO		// Send ack -> continue read
 	else			PS_TWI_SDA_HI		// Send nack -> stop read
 	twi_delay();
@@ -395,13 +479,29 @@ u16 ps_read_register(u8 address, u8 mode)
 u32 ps_get_pa(void)
 {
 	volatile u32 data = 0;
+	u16 lsb;
 	
-	// Get 3 MSB from DATARD8 register
-	data = ps_read_register(0x7F, PS_TWI_8BIT_ACCESS);
-	data = ((data & 0x07) << 8) << 8;
-
-	// Get 16 LSB from DATARD16 register
-	data |= ps_read_register(0x80, PS_TWI_16BIT_ACCESS);
+	if (!ps_msb_valid)
+	{
+		// Get 3 MSB from DATARD8 register, read before DATARD16 as the datasheet requires
+		ps_msb = ps_read_register(0x7F, PS_TWI_8BIT_ACCESS) & 0x07;
+		ps_msb_valid = 1;
+		
+		// Get 16 LSB from DATARD16 register (releases DRDY)
+		ps_lsb = ps_read_register(0x80, PS_TWI_16BIT_ACCESS);
+	}
+	else
+	{
+		// Pressure changes by far less than 1/4 of the DATARD16 range (4096 Pa) between two samples 
+		// of a continuous mode. The 3 MSB follow from the wrap-around of DATARD16, DATARD8 is not 
+		// read at all. Saves one of three TWI register reads for each sample.
+		lsb = ps_read_register(0x80, PS_TWI_16BIT_ACCESS);
+		if ((lsb < 0x4000) && (ps_lsb >= 0xC000)) 		ps_msb = (ps_msb + 1) & 0x07;
+		else if ((lsb >= 0xC000) && (ps_lsb < 0x4000)) 	ps_msb = (ps_msb - 1) & 0x07;
+		ps_lsb = lsb;
+	}
+	
+	data = ((u32)ps_msb << 16) | ps_lsb;
 	
 	// Convert decimal value to Pa
 	data = (data >> 2);
@@ -43,8 +43,8 @@
 // *************************************************************************************************
 // Prototypes section
 extern void ps_init(void);
-extern void ps_start(void);
-extern void ps_stop(void);
+extern void ps_start(u8 user, u8 need);
+extern void ps_stop(u8 user);
 extern u32 ps_get_pa(void);
 extern u16 ps_get_temp(void);
 
@@ -77,6 +77,24 @@ extern s16 conv_pa_to_altitude(u32 p_meas, u16 t_meas);
 #define PS_INT_IFG           (P2IFG)
 #define PS_INT_PIN           (BIT6)
 
+// Pressure sensor consumers
+#define PS_USER_ALTITUDE	(0u)		// Altimeter menu item
+#define PS_USER_VARIO		(1u)		// Vario
+#define PS_USER_SINGLE		(2u)		// Single measurements waiting for the result
+#define PS_USER_DATALOG		(3u)		// Data logger
+#define PS_USER_ACCUMULATOR	(4u)		// Altitude accumulator
+#define PS_USERS			(5u)
+
+// Sample rate a consumer needs, optionally | PS_NEED_HIGH_RES. PS_NEED_HIGH_RES alone asks for 
+// resolution whenever other consumers sample continuously. The driver picks the cheapest mode: 
+// standby, triggered, ultra low power, high resolution (1.8Hz) or high speed (9Hz).
+#define PS_NEED_NONE		(0u)
+#define PS_NEED_SINGLE		(1u)		// One sample, then standby
+#define PS_NEED_1HZ			(2u)		// At least one sample per second
+#define PS_NEED_FAST		(3u)		// As many samples per second as possible
+#define PS_NEED_RATE		(0x03u)
+#define PS_NEED_HIGH_RES	(BIT2)		// Low noise samples, 7 times the current of 1Hz
+
 // TWI defines
 #define PS_TWI_WRITE		(0u)
 #define PS_TWI_READ			(1u)
@@ -83,6 +83,12 @@
 #ifdef CONFIG_PHASE_CLOCK
 #include "phase_clock.h"
 #endif
+#ifdef CONFIG_PEDOMETER
+#include "pedometer.h"
+#endif
+#ifdef CONFIG_FLICK_BACKLIGHT
+#include "flick.h"
+#endif
 #ifdef CONFIG_SIDEREAL
 #include "sidereal.h"
 #endif
@@ -93,6 +99,10 @@
 #ifdef CONFIG_STRENGTH
 #include "strength.h"
 #endif
+#include "energy.h"
+#ifdef CONFIG_DATALOG
+#include "datalog.h"
+#endif
 
 #include "mrfi.h"
 #include "nwk_types.h"
@@ -204,9 +214,10 @@ void init_application(void)
 	// ---------------------------------------------------------------------
 	// Enable watchdog
 	
-	// Watchdog triggers after 16 seconds when not cleared
+	// Watchdog triggers after 16 seconds when not cleared (256 seconds while idle_loop() sleeps with
+	// tickless idle)
 #ifdef USE_WATCHDOG		
-	WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK;
+	WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK;
 #else
 	WDTCTL = WDTPW + WDTHOLD;
 #endif
@@ -380,6 +391,9 @@ void init_global_variables(void)
 	// Set date to default value
 	reset_date();
 	
+	// Start RTC with default time
+	Rtc_Init();
+	
 	#ifdef CONFIG_SIDEREAL
 	reset_sidereal_clock();
 	#endif
@@ -427,12 +441,30 @@ void init_global_variables(void)
 #endif
 
 #ifdef CONFIG_PHASE_CLOCK
-	// default program
-	sPhase.program = 0;
+	// Default program, not recording
+	reset_phase_clock();
+#endif
+
+#ifdef CONFIG_PEDOMETER
+	// Count steps from power-up
+	reset_pedometer();
+#endif
+
+#ifdef CONFIG_FLICK_BACKLIGHT
+	// Backlight on wrist flick
+	reset_flick();
 #endif
 
 	// Reset SimpliciTI stack
 	reset_rf();
+#ifdef CONFIG_ENERGY_STATS
+	// Reset energy accounting
+	reset_energy();
+#endif
+#ifdef CONFIG_DATALOG
+	// Continue data logger after newest segment in flash
+	reset_datalog();
+#endif
 #ifdef CONFIG_TEMP	
 	// Reset temperature measurement 
 	reset_temp_measurement();
@@ -581,26 +613,111 @@ void process_requests(void)
 {
 	#ifdef CONFIG_TEMP
 	// Do temperature measurement
-	if (request.flag.temperature_measurement) temperature_measurement(FILTER_ON);
+	if (request.flag.temperature_measurement) 
+	{
+		ENERGY_ENTER(ENERGY_TEMPERATURE);
+		temperature_measurement(FILTER_ON);
+		ENERGY_EXIT(ENERGY_TEMPERATURE);
+	}
 	#endif
 
 	// Do pressure measurement
 	#ifdef CONFIG_ALTITUDE
-  	if (request.flag.altitude_measurement) do_altitude_measurement(FILTER_ON);
+  	if (request.flag.altitude_measurement) 
+	{
+		ENERGY_ENTER(ENERGY_ALTITUDE);
+		#ifdef CONFIG_DATALOG
+		// Single unfiltered measurement started by data logger
+		if (sDatalog.altitude_pending) datalog_altitude_ready();
+		else
+		#endif
+		#ifdef CONFIG_ALTI_ACCUMULATOR
+		// Triggered sample of the accumulator, altimeter is not running
+		if (is_altitude_accumulator() && !is_altitude_measurement()) altitude_accumulator_ready();
+		else
+		#endif
+		do_altitude_measurement(FILTER_ON);
+		ENERGY_EXIT(ENERGY_ALTITUDE);
+	}
 	#endif
 
 	#ifdef CONFIG_ALTI_ACCUMULATOR
-	if (request.flag.altitude_accumulator) altitude_accumulator_periodic();
+	if (request.flag.altitude_accumulator) 
+	{
+		ENERGY_ENTER(ENERGY_ALTI_ACCUMULATOR);
+		altitude_accumulator_periodic();
+		ENERGY_EXIT(ENERGY_ALTI_ACCUMULATOR);
+	}
 	#endif
 	
 	#ifdef FEATURE_PROVIDE_ACCEL
 	// Do acceleration measurement
-	if (request.flag.acceleration_measurement) do_acceleration_measurement();
+	if (request.flag.acceleration_measurement) 
+	{
+		ENERGY_ENTER(ENERGY_ACCELERATION);
+		do_acceleration_measurement();
+		ENERGY_EXIT(ENERGY_ACCELERATION);
+	}
 	#endif
 	
 	#ifdef CONFIG_BATTERY
 	// Do voltage measurement
-	if (request.flag.voltage_measurement) battery_measurement();
+	if (request.flag.voltage_measurement) 
+	{
+		ENERGY_ENTER(ENERGY_BATTERY);
+		battery_measurement();
+		ENERGY_EXIT(ENERGY_BATTERY);
+	}
+	#endif
+	
+	#ifdef CONFIG_DATALOG
+	// Add data logger record (uses battery voltage measured above)
+	if (request.flag.datalog) 
+	{
+		ENERGY_ENTER(ENERGY_DATALOG);
+		datalog_record();
+		ENERGY_EXIT(ENERGY_DATALOG);
+	}
+	#endif
+	
+	#ifdef CONFIG_PHASE_CLOCK
+	// Close sleep phase epoch, upload at the set interval
+	if (request.flag.phase_clock) 
+	{
+		ENERGY_ENTER(ENERGY_PHASE_CLOCK);
+		phase_clock_minute();
+		ENERGY_EXIT(ENERGY_PHASE_CLOCK);
+	}
+	#endif
+	
+	#ifdef CONFIG_PEDOMETER
+	// Close pedometer minute
+	if (request.flag.pedometer) 
+	{
+		ENERGY_ENTER(ENERGY_PEDOMETER);
+		pedometer_minute();
+		ENERGY_EXIT(ENERGY_PEDOMETER);
+	}
+	#endif
+	
+	#ifdef CONFIG_FLICK_BACKLIGHT
+	// Look where the wrist rests
+	if (request.flag.flick) 
+	{
+		ENERGY_ENTER(ENERGY_FLICK);
+		flick_look();
+		ENERGY_EXIT(ENERGY_FLICK);
+	}
+	#endif
+	
+	#ifdef CONFIG_INFOMEM
+	// Erase information memory segments left over by compaction
+	if (request.flag.infomem) 
+	{
+		ENERGY_ENTER(ENERGY_INFOMEM);
+		infomem_erase_stale();
+		ENERGY_EXIT(ENERGY_INFOMEM);
+	}
 	#endif
 	
 	#ifdef CONFIG_ALARM
@@ -644,6 +761,8 @@ void display_update(void)
 	u8 line;
 	u8 string[8];
 	
+	ENERGY_ENTER(ENERGY_DISPLAY);
+	
 	// ---------------------------------------------------------------------
 	// Call Line1 display function
 	if (display.flag.full_update ||	display.flag.line1_full_update)
@@ -739,6 +858,8 @@ void display_update(void)
 	
 	// Clear display flag
 	display.all_flags = 0;
+	
+	ENERGY_EXIT(ENERGY_DISPLAY);
 }
 
 
@@ -865,12 +986,20 @@ void idle_loop(void)
 	}
 
 #endif
+	// Start the clock tick again if a module became active
+	Timer0_A0_Reschedule();
+
+#ifdef USE_WATCHDOG
+	// Service watchdog (reset counter), the next wakeup may be the RTC minute event
+	WDTCTL = WDTPW + WDT_SLEEP_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+#endif
+
 	// To low power mode
 	to_lpm();
 
 #ifdef USE_WATCHDOG
-	// Service watchdog (reset counter)
-	WDTCTL = (WDTCTL &0xff) | WDTPW | WDTCNTCL;
+	// Service watchdog (reset counter), running code gets the short interval
+	WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
 #endif
 }
 
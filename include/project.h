@@ -74,6 +74,17 @@
 // Conversion from msec to ACLK timer ticks
 #define CONV_MS_TO_TICKS(msec)         			(((msec) * 32768) / 1000) 
 
+// Watchdog interval (ACLK source)
+#define WDT_INTERVAL							(WDTIS__512K)		// 16 sec
+
+// Watchdog interval while idle_loop() sleeps - with tickless idle only the RTC minute event is 
+// sure to wake it up, the next shorter ACLK interval (16 sec) would need an extra wakeup
+#ifdef USE_TICKLESS_IDLE
+#define WDT_SLEEP_INTERVAL						(WDTIS__8192K)		// 256 sec
+#else
+#define WDT_SLEEP_INTERVAL						(WDTIS__512K)		// 16 sec
+#endif
+
 
 // *************************************************************************************************
 // Typedef section
@@ -133,6 +144,21 @@ typedef union
     #ifdef CONFIG_STRENGTH
     u16 strength_buzzer                 : 1;	// 1 = Output buzzer from strength_data
     #endif
+    #ifdef CONFIG_DATALOG
+    u16 datalog                         : 1;	// 1 = Add record to data logger
+    #endif
+    #ifdef CONFIG_INFOMEM
+    u16 infomem                         : 1;	// 1 = Erase unused information memory segments
+    #endif
+    #ifdef CONFIG_PHASE_CLOCK
+    u16 phase_clock                     : 1;	// 1 = Close sleep phase epoch
+    #endif
+    #ifdef CONFIG_PEDOMETER
+    u16 pedometer                       : 1;	// 1 = Close pedometer minute
+    #endif
+    #ifdef CONFIG_FLICK_BACKLIGHT
+    u16 flick                           : 1;	// 1 = Look where the wrist rests
+    #endif
   } flag;
   u16 all_flags;            // Shortcut to all display flags (for reset)
 } s_request_flags;
@@ -173,7 +199,7 @@ extern volatile s_message_flags message;
 
 // feature dependency calculations
 
-#if defined( CONFIG_PHASE_CLOCK ) || defined( CONFIG_ACCEL) || defined (CONFIG_USE_GPS)
+#if defined( CONFIG_PHASE_CLOCK ) || defined( CONFIG_ACCEL) || defined (CONFIG_USE_GPS) || defined (CONFIG_ALTI_KALMAN) || defined (CONFIG_PEDOMETER) || defined (CONFIG_FLICK_BACKLIGHT)
 	#define FEATURE_PROVIDE_ACCEL
 #endif
 
@@ -189,9 +215,13 @@ extern volatile s_message_flags message;
   #define SIMPLICITI_TX_ONLY_REQ
 #endif
 
-#if defined(CONFIG_INFOMEM) &&  !defined(CONFIG_SIDEREAL)
+#if defined(CONFIG_INFOMEM) &&  !defined(CONFIG_SIDEREAL) && !defined(CONFIG_LINK_CACHE)
 	//undefine feature if it is not used by any option
 	#undef CONFIG_INFOMEM
 #endif
 
+#if defined(CONFIG_LINK_CACHE) && !defined(CONFIG_INFOMEM)
+	#undef CONFIG_LINK_CACHE
+#endif
+
 #endif /*PROJECT_H_*/
@@ -51,6 +51,21 @@
 #include "acceleration.h"
 #include "simpliciti.h"
 #include "user.h"
+#ifdef CONFIG_DATALOG
+#include "datalog.h"
+#endif
+#ifdef CONFIG_PHASE_CLOCK
+#include "phase_clock.h"
+#endif
+#ifdef CONFIG_PEDOMETER
+#include "pedometer.h"
+#endif
+#ifdef CONFIG_FLICK_BACKLIGHT
+#include "flick.h"
+#endif
+#ifdef CONFIG_ALTI_KALMAN
+#include "altitude.h"
+#endif
 
 
 // *************************************************************************************************
@@ -99,8 +114,8 @@ void sx_acceleration(u8 line)
 	// Reset current acceleration value
 	sAccel.data = 0;
 	
-	// Get data from sensor
-	as_get_data(sAccel.xyz);
+	// Get latest sample from ring buffer
+	while (as_pop_sample(sAccel.xyz));
 }
 
 
@@ -160,14 +175,49 @@ u8 is_acceleration_measurement(void)
 
 // *************************************************************************************************
 // @fn          do_acceleration_measurement
-// @brief       Get sensor data and store in sAccel struct
+// @brief       Drain block of samples from ring buffer and store latest sample in sAccel struct
 // @param       none
 // @return      none
 // *************************************************************************************************
 void do_acceleration_measurement(void)
 {
-	// Get data from sensor
-	as_get_data(sAccel.xyz);
+	// Recover sample if DRDY edge was missed
+	as_poll();
+	
+	// Process all samples collected since last wakeup
+	while (as_pop_sample(sAccel.xyz))
+	{
+#ifdef CONFIG_DATALOG
+		// Track activity for data logger
+		datalog_accel_sample(sAccel.xyz);
+#endif
+#ifdef CONFIG_ALTI_KALMAN
+		// Vertical acceleration for altitude estimator
+		altitude_accel_sample(sAccel.xyz);
+#endif
+#ifdef CONFIG_PEDOMETER
+		// Step detection
+		pedometer_sample(sAccel.xyz);
+#endif
+#ifdef CONFIG_FLICK_BACKLIGHT
+		// Wrist flick detection
+		flick_sample(sAccel.xyz);
+#endif
+	}
+	
+#ifdef CONFIG_FLICK_BACKLIGHT
+	// Flick detector needs to see the motion flag before the pedometer clears it
+	flick_block();
+#endif
+#ifdef CONFIG_PEDOMETER
+	// Sensor mode follows movement
+	pedometer_block();
+#endif
+	
+#ifdef CONFIG_PHASE_CLOCK
+	// Sleep phase recording uses latest sample of block
+	phase_clock_sample(sAccel.xyz);
+#endif
 	
 	// Set display update flag
 	display.flag.update_acceleration = 1;
@@ -54,38 +54,135 @@
 #include "vti_ps.h"
 #include "ports.h"
 #include "timer.h"
+#include "dsp.h"
 
 // logic
 #include "user.h"
 #ifdef CONFIG_VARIO
 # include "vario.h"
 #endif
+#ifdef CONFIG_ALTI_ACCUMULATOR
+#include "clock.h"
+#endif
 
 
 // *************************************************************************************************
 // Prototypes section
+#ifdef CONFIG_ALTI_ACCUMULATOR
+static void altitude_accumulator_sample(u32 pressure, u16 temperature);
+#endif
 
 
 // *************************************************************************************************
 // Defines section
+#ifdef CONFIG_ALTI_KALMAN
+// Altitude estimator: Kalman filter for pressure, pressure change and acceleration bias. The gains 
+// (Q16) are the steady-state gains for one pressure sample per second with 3Pa noise, computed by 
+// tools/kalman_gains.py from these noise figures:
+//	with acceleration		0.2 (Pa/s2)^2/s random vertical acceleration, 0.002 (Pa/s2)^2/s bias drift
+//	pressure only			constant vertical speed, 2 (Pa/s2)^2/s random vertical acceleration
+#define ALT_KF_GAIN_P_ACC		(30883l)	// 0.471
+#define ALT_KF_GAIN_V_ACC		(9713l)		// 0.148 /s
+#define ALT_KF_GAIN_B_ACC		(710l)		// 0.0108 /s2
+#define ALT_KF_GAIN_P			(40715l)	// 0.621
+#define ALT_KF_GAIN_V			(19013l)	// 0.290 /s
+
+// Acceleration samples per prediction (16 @ 400Hz) and prediction interval (s * 65536)
+#define ALT_KF_SAMPLES			(16u)
+#define ALT_KF_DT				(2621l)
+
+// Acceleration sensor counts per g (2g range)
+#define ALT_KF_1G				(56l)
+
+// Largest pressure innovation used (Pa * 256), keeps products in range and rejects outliers
+#define ALT_KF_INNOVATION_MAX	(64l * 256)
+#endif
 
 
 // *************************************************************************************************
 // Global Variable section
 struct alt sAlt;
 
+#ifdef CONFIG_ALTI_KALMAN
+// Altitude estimator state
+struct alt_kalman
+{
+	// Pressure (Pa * 256)
+	s32		p;
+
+	// Pressure change (Pa/s * 256), negative while climbing
+	s32		v;
+
+	// Bias of vertical acceleration (Pa/s2 * 256)
+	s32		b;
+
+	// Vertical acceleration (Pa/s2 * 256) per 1/16 sensor count, from pressure and temperature
+	u16		acc_scale;
+
+	// Vertical speed (cm/s * 65536) per pressure change (Pa/s * 256)
+	u16		cm_scale;
+
+	// Sum of acceleration samples since last prediction
+	s16		xyz[3];
+	u8		samples;
+
+	// 1 = predicted from acceleration since last pressure sample
+	u8		accel;
+};
+static struct alt_kalman sKalman;
+#endif
+
 #ifdef CONFIG_ALTI_ACCUMULATOR
 
 #define	ALT_ACCUM_DIR_THRESHOLD  5 // change in meters needed to switch direction up <-> down
 
+// Triggered pressure samples averaged at each wakeup of the accumulator
+#define ALT_ACCUM_SAMPLES_SHIFT	(2u)
+#define ALT_ACCUM_SAMPLES		(1u << ALT_ACCUM_SAMPLES_SHIFT)
+
+// Background accumulator state, independent of the altimeter in sAlt
+struct alt_accum
+{
+	// Samples still missing in this wakeup
+	u8		pending;
+	
+	// Sum of the pressure samples of this wakeup (Pa)
+	u32		sum;
+	
+	// Sum of the previous wakeup (Pa), 0 until the first one has been taken
+	u32		pressure;
+	
+	// Height above start point (cm) and fraction carried to the next wakeup (1/1024 cm)
+	s32		height;
+	u16		frac;
+	
+	// Highest height going up, lowest height going down (cm)
+	s32		extreme;
+	
+	// Height up to which climb and descent have been added to the totals (cm)
+	s32		level;
+	
+	// 1 = going up, 0 = going down
+	u8		up;
+	
+	// Maximum height (cm)
+	s32		max;
+	
+	// Total ascent since start (dm)
+	u32		total;
+	
+	// Ascent and descent for each hour of the day (dm)
+	u16		ascent[24];
+	u16		descent[24];
+	
+	// Hour of the day that the totals are added to
+	u8		hour;
+};
+static struct alt_accum sAccum;
+
 // The following used by the altitude accumulation function
 u8  alt_accum_enable;		// 1 means the altitude accumulator is enabled, zero means disabled
 s32 alt_accum_startpoint;	// altitude in metres that user "zeroed" the accumulator at
-s32 alt_accum__accumtotal;	// total accumulated upwards vertical in metres
-s32 alt_accum_lastpeakdip;	// altitude in metres of last "inflection point", either a peak or a dip
-u8  alt_accum_direction;	// 1 means we're currently going up (last peakdip was a dip), 0 means we're going down
-s32 alt_accum_prevalt;		// previous altitude - altitude the last time we read the altimeter 
-s32 alt_accum_max;		// maximum altitude encountered
 u8  alt_accum_displaycode;	// what to display
 #endif
 
@@ -120,8 +217,7 @@ void reset_altitude_measurement(void)
 		init_pressure_table();
 		
 		// Do single conversion
-		start_altitude_measurement();
-		stop_altitude_measurement();	
+		single_altitude_measurement();
 
 		// Apply calibration offset and recalculate pressure table
 		if (sAlt.altitude_offset != 0)
@@ -188,12 +284,8 @@ void start_altitude_measurement(void)
 	// Start altitude measurement if timeout has elapsed
 	if (sAlt.timeout == 0)
 	{
-		// Enable DRDY IRQ on rising edge
-		PS_INT_IFG &= ~PS_INT_PIN;
-		PS_INT_IE |= PS_INT_PIN;
-
 		// Start pressure sensor
-		ps_start(); 
+		ps_start(PS_USER_ALTITUDE, PS_NEED_1HZ); 
 
 		// Set timeout counter only if sensor status was OK
 		sAlt.timeout = ALTITUDE_MEASUREMENT_TIMEOUT;
@@ -217,17 +309,158 @@ void stop_altitude_measurement(void)
 	if (!ps_ok) return;
 	
 	// Stop pressure sensor
-	ps_stop();
-	
-	// Disable DRDY IRQ
-	PS_INT_IE  &= ~PS_INT_PIN;
-	PS_INT_IFG &= ~PS_INT_PIN;
+	ps_stop(PS_USER_ALTITUDE);
 	
 	// Clear timeout counter
 	sAlt.timeout = 0;
 }
 
 
+// *************************************************************************************************
+// @fn          single_altitude_measurement
+// @brief       Update sAlt with a single triggered sample. Uses the current values while the menu 
+//				item is measuring every second.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void single_altitude_measurement(void)
+{
+	if (!ps_ok || is_altitude_measurement()) return;
+	
+	ps_start(PS_USER_SINGLE, PS_NEED_SINGLE);
+	while((PS_INT_IN & PS_INT_PIN) == 0); 
+	do_altitude_measurement(FILTER_OFF);
+	ps_stop(PS_USER_SINGLE);
+}
+
+
+
+#ifdef CONFIG_ALTI_KALMAN
+// *************************************************************************************************
+// @fn          altitude_kalman_climb
+// @brief       Convert pressure change of altitude estimator to vertical speed.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void altitude_kalman_climb(void)
+{
+	sAlt.climb = (s16)(-((sKalman.v * sKalman.cm_scale) >> 16));
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_kalman_scale
+// @brief       Pressure gradient at current pressure and temperature (scale height 29.27m/K).
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void altitude_kalman_scale(void)
+{
+	// 16 / 56 g = 1.0945cm/s2, Pa/cm = 10 * p / (2927 * T), T in 0.1K
+	sKalman.acc_scale = (u16)((sAlt.pressure * 245) / sAlt.temperature);
+	
+	// cm/Pa = 2927 * T / (10 * p)
+	sKalman.cm_scale  = (u16)((74931ul * sAlt.temperature) / sAlt.pressure);
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_kalman_reset
+// @brief       Restart altitude estimator at a single pressure sample. The bias is kept.
+// @param       u32 pressure	Pressure (Pa)
+// @return      none
+// *************************************************************************************************
+static void altitude_kalman_reset(u32 pressure)
+{
+	sKalman.p		= (s32)pressure << 8;
+	sKalman.v		= 0;
+	sKalman.xyz[0]	= 0;
+	sKalman.xyz[1]	= 0;
+	sKalman.xyz[2]	= 0;
+	sKalman.samples	= 0;
+	sKalman.accel	= 0;
+	
+	altitude_kalman_scale();
+	sAlt.climb = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_kalman_update
+// @brief       Correct altitude estimator with a new pressure sample. Without acceleration samples 
+//				since the last pressure sample, first predict one second at constant speed.
+// @param       u32 pressure	Pressure (Pa)
+// @return      u32				Estimated pressure (Pa)
+// *************************************************************************************************
+static u32 altitude_kalman_update(u32 pressure)
+{
+	s32 e;
+	
+	if (!sKalman.accel) sKalman.p += sKalman.v;
+	
+	// Innovation
+	e = ((s32)pressure << 8) - sKalman.p;
+	if (e > ALT_KF_INNOVATION_MAX) e = ALT_KF_INNOVATION_MAX;
+	if (e < -ALT_KF_INNOVATION_MAX) e = -ALT_KF_INNOVATION_MAX;
+	
+	if (sKalman.accel)
+	{
+		sKalman.p += (e * ALT_KF_GAIN_P_ACC) >> 16;
+		sKalman.v += (e * ALT_KF_GAIN_V_ACC) >> 16;
+		sKalman.b -= (e * ALT_KF_GAIN_B_ACC) >> 16;
+	}
+	else
+	{
+		sKalman.p += (e * ALT_KF_GAIN_P) >> 16;
+		sKalman.v += (e * ALT_KF_GAIN_V) >> 16;
+	}
+	sKalman.accel = 0;
+	
+	return ((u32)(sKalman.p + 128) >> 8);
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accel_sample
+// @brief       Add acceleration sample to altitude estimator, predict every ALT_KF_SAMPLES samples. 
+//				Vertical acceleration is |a| - 1g of the block, which does not depend on how the 
+//				watch is held. Called by do_acceleration_measurement.
+// @param       u8 * xyz		Raw sensor data (2g range)
+// @return      none
+// *************************************************************************************************
+void altitude_accel_sample(u8 * xyz)
+{
+	u32 sq;
+	s32 u, dv;
+	u8 i;
+	
+	if (sAlt.timeout == 0) return;
+	
+	for (i = 0; i < 3; i++) sKalman.xyz[i] += (s8)xyz[i];
+	if (++sKalman.samples < ALT_KF_SAMPLES) return;
+	
+	sq = 0;
+	for (i = 0; i < 3; i++)
+	{
+		sq += (s32)sKalman.xyz[i] * sKalman.xyz[i];
+		sKalman.xyz[i] = 0;
+	}
+	sKalman.samples = 0;
+	
+	// Vertical acceleration (1/16 counts) to pressure domain, minus estimated bias
+	u  = (s32)isqrt32(sq) - ALT_KF_SAMPLES * ALT_KF_1G;
+	u  = -((u * sKalman.acc_scale) >> 8) - sKalman.b;
+	
+	// Constant acceleration over prediction interval
+	dv = (u * ALT_KF_DT) >> 16;
+	sKalman.p += ((sKalman.v + dv / 2) * ALT_KF_DT) >> 16;
+	sKalman.v += dv;
+	sKalman.accel = 1;
+	
+	altitude_kalman_climb();
+}
+#endif
+
 
 // *************************************************************************************************
 // @fn          do_altitude_measurement
@@ -247,22 +480,35 @@ void do_altitude_measurement(u8 filter)
 
 	// Get pressure (format is 1Pa) from sensor
 	pressure = ps_get_pa();	
+	
+#ifdef CONFIG_ALTI_ACCUMULATOR
+	// Waiting accumulator takes the raw sample as well
+	altitude_accumulator_sample(pressure, sAlt.temperature);
+#endif
 		
 	// Store measured pressure value
 	if (filter == FILTER_OFF) //sAlt.pressure == 0) 
 	{
 		sAlt.pressure = pressure;
+#ifdef CONFIG_ALTI_KALMAN
+		altitude_kalman_reset(pressure);
+#endif
 	}
 	else
 	{
-		// Filter current pressure
-#ifdef FIXEDPOINT
-        pressure = (u32)(((pressure * 2) + (sAlt.pressure * 8))/10);
+#ifdef CONFIG_ALTI_KALMAN
+		// Correct altitude estimator
+		pressure = altitude_kalman_update(pressure);
 #else
-		pressure = (u32)((pressure * 0.2) + (sAlt.pressure * 0.8));
+		// Filter current pressure
+		pressure = iir1_filter(sAlt.pressure, pressure, DSP_Q15(0.2));
 #endif
 		// Store average pressure
 		sAlt.pressure = pressure;
+#ifdef CONFIG_ALTI_KALMAN
+		altitude_kalman_scale();
+		altitude_kalman_climb();
+#endif
 	}
 
 	// Convert pressure (Pa) and temperature (?K) to altitude (m).
@@ -531,114 +777,209 @@ void display_altitude(u8 line, u8 update)
 
 #ifdef CONFIG_ALTI_ACCUMULATOR
 // *************************************************************************************************
-// @fn          altitude_accumulator_periodic
-// @brief       Is called periodically, reads altitude and accumulates upwards vertical
+// @fn          is_altitude_accumulator
+// @brief       Accumulator is waiting for pressure samples
+// @param       none
+// @return      u8		1=Samples pending, 0=idle
+// *************************************************************************************************
+u8 is_altitude_accumulator(void)
+{
+	return (sAccum.pending > 0);
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_ready
+// @brief       DRDY of a triggered accumulator sample while the altimeter is not measuring. Reads
+//				the sensor without touching sAlt.
 // @param       none
 // @return      none
+// *************************************************************************************************
+void altitude_accumulator_ready(void)
+{
+	u16 temperature;
+	u32 pressure;
+
+	// If sensor is not ready, skip data read
+	if ((PS_INT_IN & PS_INT_PIN) == 0) return;
+
+	temperature = ps_get_temp();
+	pressure = ps_get_pa();
+
+	altitude_accumulator_sample(pressure, temperature);
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_hour
+// @brief       Move totals to the current hour of the day. Hours skipped since the last wakeup
+//				start from zero, so the slots from midnight up to now always hold today.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void altitude_accumulator_hour(void)
+{
+	while (sAccum.hour != sTime.hour)
+	{
+		if (++sAccum.hour > 23) sAccum.hour = 0;
+		sAccum.ascent[sAccum.hour]  = 0;
+		sAccum.descent[sAccum.hour] = 0;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_add
+// @brief       Add climb or descent from the last added level to the given height to the totals.
+//				Only whole decimetres are added, the rest stays in the level for the next time.
+// @param       s32 height		Height above start point (cm)
+// @return      none
+// *************************************************************************************************
+static void altitude_accumulator_add(s32 height)
+{
+	u16 dm;
+
+	if (height > sAccum.level)
+	{
+		dm = (u16)((height - sAccum.level) / 10);
+		sAccum.ascent[sAccum.hour] += dm;
+		sAccum.total += dm;
+		sAccum.level += (s32)dm * 10;
+	}
+	else
+	{
+		dm = (u16)((sAccum.level - height) / 10);
+		sAccum.descent[sAccum.hour] += dm;
+		sAccum.level -= (s32)dm * 10;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_update
+// @brief       Update height and totals with the averaged pressure of one wakeup
+// @param       u16 temperature		Temperature (0.1K)
+// @return      none
 //
-// This function is called once a minute. It reads the current altitude, then uses that to accumulate
-// upwards altitude only (it does not measure or accumulate downwards altitude - only altitude gains.
-// It functions as follows. Current direction (either up or down) is given in alt_accum_direction.
-//
-// If we're currently going up, then alt_accum_lastpeakdip contains the altitude of the last dip (valley)
-// we encountered and we're rising up above that. If the current altimeter value is greater than the
-// previous altimeter reading alt_accum_prevalt, then update alt_accum_prevalt with the current altitude
-// and we're done. If however we've dropped below the previous value, then if we've exceeded our
-// "direction change threshold" ALT_ACCUM_DIR_THRESHOLD, then it appears we've peaked and have started
-// heading downhill. So add (alt_accum_prevalt - alt_accum_lastpeakdip) to alt_accum__accumtotal to
-// collect that recently-finished uphill into our accumulated uphill total. Then reverse course:
-// set alt_accum_lastpeakdip equal to alt_accum_prevalt so that lastpeakdip contains the altitude of the
-// top of that recently-crossed hill (it's now a peak altitude rather than a dip (valley) altitude),
-// change the alt_accum_direction flag to downhill, and as usual set the alt_accum_prevalt to our current
-// altitude.
-//
-// On the other hand, if our current altitude is only slightly less than the previous altitude, then
-// do nothing - not even update our "previous" altitude. When we're going uphill, only 2 things matter to
-// us: either we've gone uphill some more, or we've gone downhill enough to trigger the change-or-direction
-// threshold.
-//
-// If we're going downhill (direction flag alt_accum_direction says downhill), there's little to do except
-// keep updating alt_accum_prevalt with the current altitude if we've dropped lower, and watch for a
-// change of direction to an uphill. Much the same as the uphill case, but we don't accumulate downhills
-// once the change of direction occurs.
-//
-// In addition, independently of all this, we also update alt_accum_max with the highest altitude
-// we've found.
-//
-// All measurements are recorded & stored in metres.
+// The height change since the last wakeup follows from the pressure change and the local pressure
+// gradient (dh = -29.27m/K * T * dp / p), so the accumulator does not need the altitude conversion
+// of the altimeter. The fraction of a centimetre is carried over, rounding does not add up to a
+// drift over the day.
 //
-// Yes it's a bit convoluted. That's OK. The basic thing to understand is that a "simple" accumulator
-// simply adds altitude every time we take an altimeter reading. However every reading has an error, so
-// adding a bunch of readings results in a lot of error. For that reason we have this more complicated
-// system whereby we look for peaks and dips, and only add to the accumulator when we find the next peak.
-// In that way we obtain the best accumulator accuracy possible. It does make for a more complicated
-// system though.
+// Climb and descent are found with a hysteresis. Current direction (either up or down) is given in
+// sAccum.up, sAccum.extreme holds the highest height since the last dip while going up and the
+// lowest height since the last peak while going down. Going up, every new height above what has
+// been added so far is added to the ascent right away. Once the height drops ALT_ACCUM_DIR_THRESHOLD
+// below the peak, we've started heading downhill and the drop is added to the descent. Going down
+// works the same the other way round. Changes smaller than the threshold - pressure noise, a few
+// stairs - are never added, but a climb counts in full from the dip to the peak.
 //
+// Climb and descent are added to the hour of the day they happened in.
 // *************************************************************************************************
-void altitude_accumulator_periodic (void)
+static void altitude_accumulator_update(u16 temperature)
 {
-	s32 currentalt;					// our current altitude
+	s32 dh;
+	s32 threshold = ALT_ACCUM_DIR_THRESHOLD * 100;
+	u16 scale;
 
-	// First a quick sanity check. If we're not supposed to be running, something's wrong, so just exit
-	if (alt_accum_enable==0) return;
-
-	// First thing we need to know is our current altitude. Take 4 measurements & average them.
-	start_altitude_measurement();
-	stop_altitude_measurement();
-	currentalt = sAlt.altitude;			// first reading
-
-	// Now it's comparisions time. First we'll quickly update the maximum altitude tracker
-	if (currentalt > alt_accum_max)
-		alt_accum_max = currentalt;		// update max altitude if we're at a new high
-
-	// Now our convoluted altitude accumulator, looking for peaks and valleys, etc.
-	if (alt_accum_direction) {
-		// Execute here if we're supposedly going upwards
-		if (currentalt >= alt_accum_prevalt) {
-			// Execute here if we're still going upwards - current alt is greater than previous alt
-			alt_accum_prevalt = currentalt;	// just update our "previous" value for next time
-			return;								// and that's it - we're done
+	altitude_accumulator_hour();
+
+	// First wakeup only sets the reference pressure
+	if (sAccum.pressure != 0)
+	{
+		// cm/Pa (Q8) = 2927 * T / (10 * p), T in 0.1K
+		scale = (u16)((74931ul * temperature) / (sAccum.sum >> ALT_ACCUM_SAMPLES_SHIFT));
+
+		// Height change in 1/1024 cm: 8 bit of scale fraction, 2 bit of summed samples
+		dh = ((s32)sAccum.pressure - (s32)sAccum.sum) * scale + sAccum.frac;
+		sAccum.height += dh >> (8 + ALT_ACCUM_SAMPLES_SHIFT);
+		sAccum.frac    = (u16)(dh & ((1u << (8 + ALT_ACCUM_SAMPLES_SHIFT)) - 1));
+	}
+	sAccum.pressure = sAccum.sum;
+
+	if (sAccum.height > sAccum.max) sAccum.max = sAccum.height;
+
+	if (sAccum.up)
+	{
+		if (sAccum.height > sAccum.extreme) sAccum.extreme = sAccum.height;
+
+		if (sAccum.extreme - sAccum.height >= threshold)
+		{
+			// Crested the hill, now tracking downhill
+			sAccum.up = 0;
+			sAccum.extreme = sAccum.height;
+			altitude_accumulator_add(sAccum.height);
 		}
-		else {
-			// Execute here if our current altitude is below our previous - have we crested the hill and
-			// started to descend? If we've exceeded the threshold altitude drop we need to deal with that.
-			if ((alt_accum_prevalt - currentalt) >= ALT_ACCUM_DIR_THRESHOLD) {
-				// Execute here if we've descended enough off the hillcrest to exceed the threshold - we've just
-				// gone through a change of direction, so we need to accumulate the previously gained altitude,
-				// then set things up for going downhill now.
-				alt_accum__accumtotal += alt_accum_prevalt - alt_accum_lastpeakdip;	// accumulate the vertical from that last hill climb
-				alt_accum_lastpeakdip = alt_accum_prevalt;				// peakdip is now a peak elevation
-				alt_accum_direction = 0;						// indicate we're tracking downhill now
-				return;
-			}
-			else	// we've dropped a little, but not enough to trigger any action yet
-				return;
+		else if (sAccum.height > sAccum.level)
+		{
+			altitude_accumulator_add(sAccum.height);
 		}
 	}
-	else {
-		// Execute here if we're supposedly going downwards
-		if (currentalt <= alt_accum_prevalt) {
-			// Execute here if we're still going downwards - current alt is less than previous alt
-			alt_accum_prevalt = currentalt;		// just update our "previous" value for next time
-			return;					// and that's it - we're done
+	else
+	{
+		if (sAccum.height < sAccum.extreme) sAccum.extreme = sAccum.height;
+
+		if (sAccum.height - sAccum.extreme >= threshold)
+		{
+			// Bottomed the valley, now tracking uphill
+			sAccum.up = 1;
+			sAccum.extreme = sAccum.height;
+			altitude_accumulator_add(sAccum.height);
 		}
-		else {
-			// Execute here if our current altitude is above our previous - have we bottomed the valley and
-			// started to ascend? If we've exceeded the threshold altitude increase we need to deal with that.
-			if ((currentalt - alt_accum_prevalt) >= ALT_ACCUM_DIR_THRESHOLD) {
-				// Execute here if we've ascended enough above the valley floor to exceed the threshold - we've just
-				// gone through a change of direction, so we need to set things up for going uphill now.
-				alt_accum_lastpeakdip = alt_accum_prevalt;	// peakdip is now a dip (valley) elevation
-				alt_accum_direction = 1;			// indicate we're tracking uphill now
-				return;
-			}
-			else	// we've ascended a little, but not enough to trigger any action yet
-				return;
+		else if (sAccum.height < sAccum.level)
+		{
+			altitude_accumulator_add(sAccum.height);
 		}
 	}
 }
 
 
+// *************************************************************************************************
+// @fn          altitude_accumulator_sample
+// @brief       Add a pressure sample to the current wakeup. Triggers the next sample until
+//				ALT_ACCUM_SAMPLES are taken, then releases the sensor. Called with every sample read,
+//				so the accumulator uses the altimeter's samples while the altimeter is running.
+// @param       u32 pressure		Pressure (Pa)
+//				u16 temperature		Temperature (0.1K)
+// @return      none
+// *************************************************************************************************
+static void altitude_accumulator_sample(u32 pressure, u16 temperature)
+{
+	if (sAccum.pending == 0) return;
+
+	sAccum.sum += pressure;
+
+	if (--sAccum.pending > 0)
+	{
+		// Next triggered sample
+		ps_start(PS_USER_ACCUMULATOR, PS_NEED_SINGLE);
+		return;
+	}
+
+	ps_stop(PS_USER_ACCUMULATOR);
+	altitude_accumulator_update(temperature);
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_periodic
+// @brief       Is called once a minute, starts a new wakeup of ALT_ACCUM_SAMPLES triggered samples.
+//				The sensor returns to standby once the last sample is in, the CPU sleeps between
+//				samples. Samples still missing from the last wakeup are dropped.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void altitude_accumulator_periodic (void)
+{
+	// First a quick sanity check. If we're not supposed to be running, something's wrong, so just exit
+	if (alt_accum_enable==0 || !ps_ok) return;
+
+	sAccum.sum = 0;
+	sAccum.pending = ALT_ACCUM_SAMPLES;
+	ps_start(PS_USER_ACCUMULATOR, PS_NEED_SINGLE);
+}
+
+
 // *************************************************************************************************
 // @fn          altitude_accumulator_start
 // @brief       Initialises the altitude accumulator function
@@ -647,30 +988,60 @@ void altitude_accumulator_periodic (void)
 // *************************************************************************************************
 void altitude_accumulator_start (void)
 {
-	s32 temp;
+	u8 i;
+
+	// Altitude the user zeroed the accumulator at
+	single_altitude_measurement();
+	alt_accum_startpoint = sAlt.altitude;
+
+	sAccum.pressure	= 0;
+	sAccum.height	= 0;
+	sAccum.frac		= 0;
+	sAccum.extreme	= 0;
+	sAccum.level	= 0;
+	sAccum.up		= 1;		// start off by assuming we're heading uphill
+	sAccum.max		= 0;
+	sAccum.total	= 0;
+	for (i = 0; i < 24; i++)
+	{
+		sAccum.ascent[i]  = 0;
+		sAccum.descent[i] = 0;
+	}
+	sAccum.hour = sTime.hour;
 
-	alt_accum__accumtotal = 0;		// So far total upwards vertical accumulation is zero
-	alt_accum_direction = 1;		// start off by assuming we're heading uphill
-
-	// Now let's get 4 altitude readings, then average them, to obtain our current altitude
-	start_altitude_measurement();
-	stop_altitude_measurement();
-	temp = sAlt.altitude;				// first reading
-	/* start_altitude_measurement();
-	   stop_altitude_measurement();
-	   temp += sAlt.altitude;			// second reading
-	   start_altitude_measurement();
-	   stop_altitude_measurement();
-	   temp += sAlt.altitude;			// third reading
-	   start_altitude_measurement();
-	   stop_altitude_measurement();
-	   temp += sAlt.altitude;			// fourth reading
-	   temp = temp >> 2;				// divide result by 4 = our current altitude */
-
-	alt_accum_startpoint = temp;		// the altitude the user zeroed the accumulator at
-	alt_accum_lastpeakdip = temp;		// altitude of the last dip (in this case, as we assume we're going uphill)
-	alt_accum_prevalt = temp;		// previous altitude value
-	alt_accum_max = temp;			// maximum altitude we've encountered so far
+	// Take reference pressure right away
+	altitude_accumulator_periodic();
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_stop
+// @brief       Stops the altitude accumulator function
+// @param       none
+// @return      none
+// *************************************************************************************************
+void altitude_accumulator_stop (void)
+{
+	sAccum.pending = 0;
+	ps_stop(PS_USER_ACCUMULATOR);
+}
+
+
+// *************************************************************************************************
+// @fn          altitude_accumulator_today
+// @brief       Sum of the hourly totals from midnight up to now
+// @param       u16 * totals		sAccum.ascent or sAccum.descent
+// @return      s32					Today's climb or descent (m)
+// *************************************************************************************************
+static s32 altitude_accumulator_today(u16 * totals)
+{
+	u32 sum = 0;
+	u8 i;
+
+	altitude_accumulator_hour();
+	for (i = 0; i <= sAccum.hour; i++) sum += totals[i];
+
+	return ((s32)(sum / 10));
 }
 
 
@@ -710,12 +1081,14 @@ void display_selection_altaccum (u8 segments, u32 index, u8 digits, u8 blanks)
 // alt_accum_displaycode = 0:  Altitude relative to start point
 // alt_accum_displaycode = 1:  Total accumulated upwards vertical altitude
 // alt_accum_displaycode = 2:  Maximum altitude encountered (max height)
+// alt_accum_displaycode = 3:  Upwards vertical altitude today
+// alt_accum_displaycode = 4:  Downwards vertical altitude today
 // *************************************************************************************************
 void sx_alt_accumulator(u8 line)
 {
 	alt_accum_displaycode++;
 
-	if (alt_accum_displaycode > 2)
+	if (alt_accum_displaycode > 4)
 		alt_accum_displaycode = 0;
 }
 
@@ -748,7 +1121,7 @@ void display_alt_accumulator (u8 line, u8 update)
 
 		// Otherwise the accumulator is running, so display on the second line whatever alt_accum_displaycode
 		// says to display, in metres or feet as appropriate.
-		if (alt_accum_displaycode>2) alt_accum_displaycode=0;		// sanity check
+		if (alt_accum_displaycode>4) alt_accum_displaycode=0;		// sanity check
 
 		// light up "m" or "ft" display symbol as appropriate
 		if (sys.flag.use_metric_units)
@@ -756,16 +1129,17 @@ void display_alt_accumulator (u8 line, u8 update)
 		else
 			display_symbol(LCD_UNIT_L1_FT, SEG_ON);			// or feet symbol
 
+		// up or down arrow marks today's totals
+		display_symbol(LCD_SYMB_ARROW_UP, (alt_accum_displaycode==3) ? SEG_ON : SEG_OFF);
+		display_symbol(LCD_SYMB_ARROW_DOWN, (alt_accum_displaycode==4) ? SEG_ON : SEG_OFF);
+
 		if (alt_accum_displaycode==0)
 		{
 			// Display current altitude relative to the accumulator's starting point
 			// "DIFF" means difference between starting elevation & current elevation
 			display_chars(LCD_SEG_L1_3_0, (u8*)"DIFF", SEG_ON);		// top line display message
 
-			start_altitude_measurement();
-			stop_altitude_measurement();					// grab our current altitude
-
-			temp = sAlt.altitude - alt_accum_startpoint;	// difference between starting altitude & current altitude
+			temp = sAccum.height / 100;					// height above starting altitude at the last wakeup
 			if (sys.flag.use_metric_units==0) temp = (temp*328)/100;	// convert to feet if necessary
 
 			clear_line(LINE2);						// clear the bottom line of the display
@@ -787,18 +1161,12 @@ void display_alt_accumulator (u8 line, u8 update)
 
 		else if (alt_accum_displaycode==1)
 		{
-			// Display total accumulated elevation gain. Remember we might currently be going uphill
-			// so we need to check for, and include, any current elevation gain
+			// Display total accumulated elevation gain. Gain of the current climb is included as we go.
 			display_chars(LCD_SEG_L1_3_0, (u8*)"ACCA", SEG_ON);		// top line display message
 			clear_line(LINE2);						// clear the bottom line of the display
 
-			if (alt_accum__accumtotal<0) alt_accum__accumtotal = 0;	// accumulated total should never be negative!
-			temp = alt_accum__accumtotal;				// local copy of accumulated total
-
-			// Now we need to add on any vertical gained recently, that hasn't yet been included in alt_accum__accumtotal
-			// This only happens if we're currently going uphill, and we've above our last valley / dip elevation
-			if (alt_accum_direction && (sAlt.altitude>alt_accum_lastpeakdip))	// if we're going up, and we're higher than our last dip (valley) altitude
-				temp += sAlt.altitude - alt_accum_lastpeakdip;			// then add the vertical we've gained so far above that last dip / valley point
+			temp = sAccum.total / 10;				// accumulated total in metres
+			if (sys.flag.use_metric_units==0) temp = (temp*328)/100;	// convert to feet if necessary
 
 			// display the result
 			str = itoa(temp, 5, 4);					// 5 digits, up to 4 leading blank digits
@@ -806,18 +1174,36 @@ void display_alt_accumulator (u8 line, u8 update)
 			return;
 		}
 
-		else
+		else if (alt_accum_displaycode==2)
 		{
 			// Display maximum altitude found so far
 			display_chars(LCD_SEG_L1_3_0, (u8*)"PEAK", SEG_ON);	// top line display message
 			clear_line(LINE2);					// clear the bottom line of the display
 
-			temp = alt_accum_max;					// local copy of peak altitude
+			temp = alt_accum_startpoint + sAccum.max / 100;		// peak altitude
+			if (sys.flag.use_metric_units==0) temp = (temp*328)/100;	// convert to feet if necessary
 			if (temp < 0) temp = 0;					// I can't be bothered displaying a negative number! So make it zero if it is.
 			str = itoa(temp, 5, 4);					// 5 digits, up to 4 leading blank digits
 			display_chars(LCD_SEG_L2_4_0, str, SEG_ON);		// display peak altitude on bottom line (5 digits)
 			return;
 		}
+
+		else
+		{
+			// Display vertical altitude up or down since midnight, summed from the hourly totals
+			display_chars(LCD_SEG_L1_3_0, (u8*)"DAY ", SEG_ON);	// top line display message
+			clear_line(LINE2);					// clear the bottom line of the display
+
+			if (alt_accum_displaycode==3)
+				temp = altitude_accumulator_today(sAccum.ascent);
+			else
+				temp = altitude_accumulator_today(sAccum.descent);
+			if (sys.flag.use_metric_units==0) temp = (temp*328)/100;	// convert to feet if necessary
+
+			str = itoa(temp, 5, 4);					// 5 digits, up to 4 leading blank digits
+			display_chars(LCD_SEG_L2_4_0, str, SEG_ON);		// display today's total on bottom line (5 digits)
+			return;
+		}
 	}
 
 
@@ -830,6 +1216,7 @@ void display_alt_accumulator (u8 line, u8 update)
 		// Clean up function-specific segments before leaving function
 		display_symbol(LCD_UNIT_L1_M, SEG_OFF);
 		display_symbol(LCD_UNIT_L1_FT, SEG_OFF);
+		display_symbol(LCD_SYMB_ARROW_UP, SEG_OFF);
 		display_symbol(LCD_SYMB_ARROW_DOWN, SEG_OFF);
 	}
 }
@@ -857,7 +1244,12 @@ void mx_alt_accumulator(u8 line)
 
 	// If the altitude accumulator has just been enabled, call its initialisation routine
 	if ( (temp_enable==1) && (alt_accum_enable==0) )
+	{
+		alt_accum_enable = 1;
 		altitude_accumulator_start();
+	}
+	else if ( (temp_enable==0) && (alt_accum_enable==1) )
+		altitude_accumulator_stop();
 
 	alt_accum_enable = temp_enable;		// global flag that the accumulator is running, or not, as the user selected
 
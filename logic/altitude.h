@@ -47,10 +47,16 @@ extern void reset_altitude_measurement(void);
 extern u8 is_altitude_measurement(void);
 extern void start_altitude_measurement(void);
 extern void stop_altitude_measurement(void);
+extern void single_altitude_measurement(void);
 extern void do_altitude_measurement(u8 filter);
+#ifdef CONFIG_ALTI_KALMAN
+extern void altitude_accel_sample(u8 * xyz);
+#endif
 #ifdef CONFIG_ALTI_ACCUMULATOR
 extern void display_selection_altunits(u8 segments, u32 index, u8 digits, u8 blanks);
 extern void altitude_accumulator_periodic (void);
+extern u8 is_altitude_accumulator(void);
+extern void altitude_accumulator_ready(void);
 #endif
 
 // menu functions
@@ -89,6 +95,11 @@ struct alt
 	// Altitude offset stored during calibration
 	s16		altitude_offset;
 
+#ifdef CONFIG_ALTI_KALMAN
+	// Vertical speed (cm/s)
+	s16		climb;
+#endif
+
 	// Timeout
 	u16		timeout;
 };
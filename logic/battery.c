@@ -47,6 +47,7 @@
 #include "display.h"
 #include "ports.h"
 #include "adc12.h"
+#include "dsp.h"
 
 // logic
 #include "menu.h"
@@ -120,7 +121,7 @@ void battery_measurement(void)
 	}
 	
 	// Filter battery voltage
-	sBatt.voltage = ((voltage*2) + (sBatt.voltage*8))/10;
+	sBatt.voltage = iir1_filter(sBatt.voltage, voltage, DSP_Q15(0.2));
 
 	// If battery voltage falls below low battery threshold, set system flag and modify LINE2 display function pointer
 	if (sBatt.voltage < BATTERY_LOW_THRESHOLD) 
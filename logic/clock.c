@@ -71,7 +71,7 @@
 // *************************************************************************************************
 // Prototypes section
 void reset_clock(void);
-void clock_tick(void);
+u32 clock_advance(u8 hour, u8 minute, u8 second);
 void mx_time(u8 line);
 void sx_time(u8 line);
 
@@ -126,47 +126,41 @@ void reset_clock(void)
 
 
 // *************************************************************************************************
-// @fn          clock_tick
-// @brief       Add 1 second to system time and to display time
-// @param       none
-// @return      none
+// @fn          clock_advance
+// @brief       Move display time forward to the RTC time and add the seconds in between to system 
+//				time. Any number of seconds up to one day.
+// @param       u8 hour, minute, second		RTC time of day
+// @return      u32							Seconds added
 // *************************************************************************************************
-void clock_tick(void)
+u32 clock_advance(u8 hour, u8 minute, u8 second)
 {
+	s32 elapsed = ((s32)((s16)hour - sTime.hour) * 60 + ((s16)minute - sTime.minute)) * 60 + ((s16)second - sTime.second);
+
+	if (elapsed == 0) return (0);
+
 	// Use sTime.drawFlag to minimize display updates
 	// sTime.drawFlag = 1: second
 	// sTime.drawFlag = 2: minute, second
 	// sTime.drawFlag = 3: hour, minute
-	sTime.drawFlag = 1;
-
-	// Increase global system time
-	sTime.system_time++;
-
-	// Add 1 second
-	sTime.second++;
+	if (hour != sTime.hour)				sTime.drawFlag = 3;
+	else if (minute != sTime.minute)	sTime.drawFlag = 2;
+	else								sTime.drawFlag = 1;
 
-	// Add 1 minute
-	if (sTime.second == 60)
+	// Add 1 day
+	if (elapsed < 0)
 	{
-		sTime.second = 0;
-		sTime.minute++;
-		sTime.drawFlag++;
-
-		// Add 1 hour
-		if (sTime.minute == 60)
-		{
-			sTime.minute = 0;
-			sTime.hour++;
-			sTime.drawFlag++;
-
-			// Add 1 day
-			if (sTime.hour == 24)
-			{
-				sTime.hour = 0;
-				add_day();
-			}
-		}
+		elapsed += 86400;
+		add_day();
 	}
+
+	// Increase global system time
+	sTime.system_time += elapsed;
+
+	sTime.hour   = hour;
+	sTime.minute = minute;
+	sTime.second = second;
+	
+	return ((u32)elapsed);
 }
 
 
@@ -282,16 +276,8 @@ void mx_time(u8 line)
     // Button STAR (short): save, then exit
     if (button.flag.star)
     {
-      // Stop clock timer
-      Timer0_Stop();
-
-      // Store local variables in global clock time
-      sTime.hour 	 = hours;
-      sTime.minute = minutes;
-      sTime.second = seconds;
-
-      // Start clock timer
-      Timer0_Start();
+      // Store local variables in global clock time and RTC
+      Rtc_SetTime(hours, minutes, seconds);
 
       // Full display update is done when returning from function
       display_symbol(LCD_SYMB_AM, SEG_OFF);
@@ -48,7 +48,7 @@
 extern void reset_clock(void);
 extern void sx_time(u8 line);
 extern void mx_time(u8 line);
-extern void clock_tick(void);
+extern u32 clock_advance(u8 hour, u8 minute, u8 second);
 extern void display_selection_Timeformat1(u8 segments, u32 index, u8 digits, u8 blanks, u8 dummy);
 extern void display_time(u8 line, u8 update);
 
@@ -0,0 +1,392 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+// Data logger. Records altitude, temperature, battery voltage and acceleration activity every
+// DATALOG_INTERVAL minutes. Records are collected in a RAM copy of one flash segment, a full 
+// segment is written to a ring of DATALOG_SEGMENTS main flash segments.
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+
+// system
+#include "project.h"
+#ifdef CONFIG_DATALOG
+
+#include <string.h>
+
+// driver
+#include "flash.h"
+#include "vti_ps.h"
+
+// logic
+#include "clock.h"
+#include "date.h"
+#include "battery.h"
+#include "temperature.h"
+#include "altitude.h"
+#include "datalog.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+void reset_datalog(void);
+void datalog_record(void);
+void datalog_altitude_ready(void);
+void datalog_accel_sample(u8 * xyz);
+void datalog_erase(void);
+u16 datalog_packets(void);
+void datalog_read_packet(u16 index, u8 * data);
+static struct datalog_segment * datalog_segment_addr(u8 segment);
+static void datalog_new_page(void);
+static void datalog_flush(void);
+static void datalog_commit(s16 altitude);
+
+
+// *************************************************************************************************
+// Defines section
+
+
+// *************************************************************************************************
+// Global Variable section
+struct datalog sDatalog;
+
+
+// *************************************************************************************************
+// Extern section
+extern u8 ps_ok;
+
+
+// *************************************************************************************************
+// @fn          datalog_segment_addr
+// @brief       Flash address of log segment.
+// @param       u8 segment		0 .. DATALOG_SEGMENTS-1
+// @return      struct datalog_segment *	Segment in flash
+// *************************************************************************************************
+static struct datalog_segment * datalog_segment_addr(u8 segment)
+{
+	return ((struct datalog_segment *)((u8 *)DATALOG_START + segment * FLASH_SEGMENT_SIZE));
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_new_page
+// @brief       Start new RAM page. Header is written with the first record.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void datalog_new_page(void)
+{
+	memset(&sDatalog.page, 0xFF, sizeof(sDatalog.page));
+	sDatalog.records = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          reset_datalog
+// @brief       Find newest segment in flash and continue the ring after it. Records that were not
+//				written to flash before a reset are lost.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void reset_datalog(void)
+{
+	struct datalog_segment * seg;
+	u16 newest_sequence = 0;
+	u8 newest = DATALOG_SEGMENTS;
+	u8 i;
+	
+	for (i = 0; i < DATALOG_SEGMENTS; i++)
+	{
+		seg = datalog_segment_addr(i);
+		if (seg->header.magic != DATALOG_MAGIC) continue;
+		if ((newest == DATALOG_SEGMENTS) || ((s16)(seg->header.sequence - newest_sequence) > 0))
+		{
+			newest = i;
+			newest_sequence = seg->header.sequence;
+		}
+	}
+	
+	if (newest == DATALOG_SEGMENTS)
+	{
+		// Empty log
+		sDatalog.next_segment  = 0;
+		sDatalog.used_segments = 0;
+		sDatalog.sequence      = 0;
+	}
+	else
+	{
+		// Count contiguous older segments before the newest one
+		sDatalog.used_segments = 1;
+		for (i = 1; i < DATALOG_SEGMENTS; i++)
+		{
+			seg = datalog_segment_addr((newest + DATALOG_SEGMENTS - i) % DATALOG_SEGMENTS);
+			if ((seg->header.magic != DATALOG_MAGIC) || (seg->header.sequence != (u16)(newest_sequence - i))) break;
+			sDatalog.used_segments++;
+		}
+		sDatalog.next_segment = (newest + 1) % DATALOG_SEGMENTS;
+		sDatalog.sequence     = newest_sequence + 1;
+	}
+	
+	sDatalog.activity         = 0;
+	sDatalog.accel_valid      = 0;
+	sDatalog.altitude_pending = 0;
+	datalog_new_page();
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_flush
+// @brief       Write RAM page to the next flash segment. The oldest segment is overwritten when the
+//				ring is full.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void datalog_flush(void)
+{
+	u16 * segment = (u16 *)datalog_segment_addr(sDatalog.next_segment);
+	
+	flash_erase_segment(segment);
+	flash_write(segment, (u16 *)&sDatalog.page, FLASH_SEGMENT_WORDS);
+	
+	if (++sDatalog.next_segment >= DATALOG_SEGMENTS) sDatalog.next_segment = 0;
+	if (sDatalog.used_segments < DATALOG_SEGMENTS) sDatalog.used_segments++;
+	sDatalog.sequence++;
+	
+	datalog_new_page();
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_commit
+// @brief       Copy pending record to RAM page, write page to flash when full.
+// @param       s16 altitude		Altitude (m) or DATALOG_NO_DATA
+// @return      none
+// *************************************************************************************************
+static void datalog_commit(s16 altitude)
+{
+	// First record sets page header
+	if (sDatalog.records == 0)
+	{
+		sDatalog.page.header.magic    = DATALOG_MAGIC;
+		sDatalog.page.header.sequence = sDatalog.sequence;
+		sDatalog.page.header.year     = sDate.year;
+		sDatalog.page.header.month    = sDate.month;
+		sDatalog.page.header.interval = DATALOG_INTERVAL;
+	}
+	
+	sDatalog.pending.altitude = altitude;
+	sDatalog.page.record[sDatalog.records] = sDatalog.pending;
+	sDatalog.altitude_pending = 0;
+	
+	if (++sDatalog.records >= DATALOG_RECORDS_PER_SEGMENT) datalog_flush();
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_record
+// @brief       Called by process_requests every DATALOG_INTERVAL minutes, after the battery voltage 
+//				was measured. If the pressure sensor is idle, it is started and the record is 
+//				completed by datalog_altitude_ready when the DRDY IRQ has requested the data.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void datalog_record(void)
+{
+	struct datalog_record * rec = &sDatalog.pending;
+	
+	// Pressure sensor did not deliver data within one interval
+	if (sDatalog.altitude_pending)
+	{
+#ifdef CONFIG_ALTITUDE
+		ps_stop(PS_USER_DATALOG);
+#endif
+		datalog_commit(DATALOG_NO_DATA);
+	}
+	
+	rec->time = ((u16)sDate.day << 11) | (sTime.hour * 60u + sTime.minute);
+	
+#ifdef CONFIG_TEMP
+	if (!is_temp_measurement()) temperature_measurement(FILTER_OFF);
+	rec->temperature = sTemp.degrees;
+#else
+	rec->temperature = DATALOG_NO_DATA;
+#endif
+
+#ifdef CONFIG_BATTERY
+	if (sBatt.voltage <= DATALOG_VOLTAGE_OFFSET)				rec->voltage = 0;
+	else if (sBatt.voltage >= DATALOG_VOLTAGE_OFFSET + 255u)	rec->voltage = 255;
+	else 														rec->voltage = sBatt.voltage - DATALOG_VOLTAGE_OFFSET;
+#else
+	rec->voltage = 0xFF;
+#endif
+	
+	// Restart acceleration summary
+	rec->activity        = sDatalog.activity;
+	sDatalog.activity    = 0;
+	sDatalog.accel_valid = 0;
+	
+#ifdef CONFIG_ALTITUDE
+	if (ps_ok)
+	{
+		// Menu item is measuring every second
+		if (is_altitude_measurement())
+		{
+			datalog_commit(sAlt.altitude);
+			return;
+		}
+		
+		// Start single measurement, do not wait in active mode for the result
+		ps_start(PS_USER_DATALOG, PS_NEED_SINGLE);
+		sDatalog.altitude_pending = 1;
+		return;
+	}
+#endif
+	datalog_commit(DATALOG_NO_DATA);
+}
+
+
+#ifdef CONFIG_ALTITUDE
+// *************************************************************************************************
+// @fn          datalog_altitude_ready
+// @brief       Pressure sensor has data for pending record. Called by process_requests instead of 
+//				the filtered altitude measurement.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void datalog_altitude_ready(void)
+{
+	do_altitude_measurement(FILTER_OFF);
+	ps_stop(PS_USER_DATALOG);
+	
+	datalog_commit(sAlt.altitude);
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          datalog_accel_sample
+// @brief       Keep largest change between two acceleration samples for next record.
+// @param       u8 * xyz		Raw sensor data (2's complement)
+// @return      none
+// *************************************************************************************************
+void datalog_accel_sample(u8 * xyz)
+{
+	u16 sum = 0;
+	s16 diff;
+	u8 i;
+	
+	for (i = 0; i < 3; i++)
+	{
+		diff = (s8)xyz[i] - (s8)sDatalog.last_xyz[i];
+		sum += (diff < 0) ? -diff : diff;
+		sDatalog.last_xyz[i] = xyz[i];
+	}
+	if (sum > 255) sum = 255;
+	
+	if (sDatalog.accel_valid && (sum > sDatalog.activity)) sDatalog.activity = sum;
+	sDatalog.accel_valid = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_erase
+// @brief       Erase all log segments and records in RAM. Called by SYNC_AP_CMD_ERASE_MEMORY.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void datalog_erase(void)
+{
+	u8 i;
+	
+	for (i = 0; i < DATALOG_SEGMENTS; i++) flash_erase_segment((u16 *)datalog_segment_addr(i));
+	
+	sDatalog.next_segment  = 0;
+	sDatalog.used_segments = 0;
+	datalog_new_page();
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_packets
+// @brief       Number of SYNC packets for the whole log. Flash segments from oldest to newest are 
+//				followed by the RAM page.
+// @param       none
+// @return      u16		Packets of DATALOG_PACKET_SIZE bytes
+// *************************************************************************************************
+u16 datalog_packets(void)
+{
+	u16 packets = sDatalog.used_segments * DATALOG_PACKETS_PER_SEGMENT;
+	
+	if (sDatalog.records > 0)
+	{
+		packets += (sizeof(struct datalog_header) + sDatalog.records * sizeof(struct datalog_record) 
+					+ DATALOG_PACKET_SIZE - 1) / DATALOG_PACKET_SIZE;
+	}
+	return (packets);
+}
+
+
+// *************************************************************************************************
+// @fn          datalog_read_packet
+// @brief       Copy DATALOG_PACKET_SIZE bytes of the log. Packets beyond the end are filled with 0xFF.
+// @param       u16 index		Packet index (0 = start of oldest segment)
+//				u8 * data		Destination
+// @return      none
+// *************************************************************************************************
+void datalog_read_packet(u16 index, u8 * data)
+{
+	u16 segment = index / DATALOG_PACKETS_PER_SEGMENT;
+	u16 offset  = (index % DATALOG_PACKETS_PER_SEGMENT) * DATALOG_PACKET_SIZE;
+	u8 * src;
+	
+	if (index >= datalog_packets())
+	{
+		memset(data, 0xFF, DATALOG_PACKET_SIZE);
+		return;
+	}
+	
+	if (segment < sDatalog.used_segments)
+	{
+		src = (u8 *)datalog_segment_addr((sDatalog.next_segment + DATALOG_SEGMENTS - sDatalog.used_segments + segment) % DATALOG_SEGMENTS);
+	}
+	else
+	{
+		src = (u8 *)&sDatalog.page;
+	}
+	memcpy(data, src + offset, DATALOG_PACKET_SIZE);
+}
+
+#endif /* CONFIG_DATALOG */
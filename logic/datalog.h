@@ -0,0 +1,161 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+
+#ifndef DATALOG_H_
+#define DATALOG_H_
+
+// *************************************************************************************************
+// Include section
+#include "flash.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+extern void reset_datalog(void);
+extern void datalog_record(void);
+extern void datalog_altitude_ready(void);
+extern void datalog_accel_sample(u8 * xyz);
+extern void datalog_erase(void);
+extern u16 datalog_packets(void);
+extern void datalog_read_packet(u16 index, u8 * data);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Log area in main flash: 4 segments below the interrupt vector segment. The linked image must end
+// below DATALOG_START (checked by tools/memory.py, see makefile).
+#define DATALOG_START				(0xF600u)
+#define DATALOG_SEGMENTS			(4u)
+
+// Record interval in minutes, must divide 60
+#define DATALOG_INTERVAL			(10u)
+
+// Segment header identifier
+#define DATALOG_MAGIC				(0xDA7Au)
+
+// Records after the header in each segment
+#define DATALOG_RECORDS_PER_SEGMENT	((FLASH_SEGMENT_SIZE - sizeof(struct datalog_header)) / sizeof(struct datalog_record))
+
+// Payload bytes per SYNC_ED_TYPE_MEMORY packet (2 bytes packet index precede the payload)
+#define DATALOG_PACKET_SIZE			(16u)
+#define DATALOG_PACKETS_PER_SEGMENT	(FLASH_SEGMENT_SIZE / DATALOG_PACKET_SIZE)
+
+// Value of record fields without sensor data
+#define DATALOG_NO_DATA				((s16)0x8000)
+
+// Battery voltage is stored as offset to 2.00V in 10mV steps
+#define DATALOG_VOLTAGE_OFFSET		(200u)
+
+
+// *************************************************************************************************
+// Global Variable section
+
+// First 8 bytes of a log segment
+struct datalog_header
+{
+	// DATALOG_MAGIC
+	u16			magic;
+	
+	// Incremented per segment, the oldest segment has the lowest number
+	u16			sequence;
+	
+	// Date of first record
+	u16			year;
+	u8			month;
+	
+	// Minutes between records
+	u8			interval;
+};
+
+// Sensor summary, little-endian as in flash
+struct datalog_record
+{
+	// Day of month (bits 15..11), minute of day (bits 10..0)
+	u16			time;
+	
+	// Altitude (m)
+	s16			altitude;
+	
+	// Temperature (1/10 degree Celsius)
+	s16			temperature;
+	
+	// Battery voltage - DATALOG_VOLTAGE_OFFSET in 10mV
+	u8			voltage;
+	
+	// Largest change of raw acceleration between two samples (sum of X/Y/Z), 0 if sensor was off
+	u8			activity;
+};
+
+struct datalog_segment
+{
+	struct datalog_header	header;
+	struct datalog_record	record[DATALOG_RECORDS_PER_SEGMENT];
+};
+
+struct datalog
+{
+	// Segment that is filled in RAM and written when full
+	struct datalog_segment	page;
+	
+	// Records in page
+	u8			records;
+	
+	// Next flash segment to write
+	u8			next_segment;
+	
+	// Written flash segments (oldest is DATALOG_SEGMENTS - used before next_segment)
+	u8			used_segments;
+	
+	// Sequence number of page
+	u16			sequence;
+	
+	// Record waiting for pressure sensor data
+	struct datalog_record	pending;
+	u8			altitude_pending;
+	
+	// Acceleration summary since last record
+	u8			activity;
+	u8			last_xyz[3];
+	u8			accel_valid;
+};
+extern struct datalog sDatalog;
+
+
+// *************************************************************************************************
+// Extern section
+
+
+#endif /*DATALOG_H_*/
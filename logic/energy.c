@@ -0,0 +1,347 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+// Energy accounting. Time spent in interrupt service routines, requests, display updates and
+// peripheral on-time, measured with Timer0 and the RTC (1/32768 sec resolution).
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+
+// system
+#include "project.h"
+#ifdef CONFIG_ENERGY_STATS
+
+#include <string.h>
+
+// driver
+#include "display.h"
+#include "timer.h"
+
+// logic
+#include "menu.h"
+#include "energy.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+void reset_energy(void);
+void energy_start(u8 slot);
+void energy_stop(u8 slot);
+void energy_tick(u32 seconds);
+static u32 energy_on_time(u8 slot, u32 now);
+u32 energy_per_day(u8 slot);
+static u8 energy_slot_of_rank(u8 rank);
+
+
+// *************************************************************************************************
+// Defines section
+
+
+// *************************************************************************************************
+// Global Variable section
+struct energy sEnergy;
+
+// Slot names shown in menu item
+const u8 energy_label[ENERGY_SLOTS][3] =
+{
+	"T0", "T1", "P2", "AD", "RI",
+	"TE", "AL", "AA", "AC", "BA", "DI",
+	"RF", "BU", "BL", "DL", "IM",
+	"PC", "PE", "FL", "RT",
+};
+
+
+// *************************************************************************************************
+// Extern section
+extern void (*fptr_lcd_function_line2)(u8 line, u8 update);
+
+
+// *************************************************************************************************
+// @fn          reset_energy
+// @brief       Clear all counters. Running measurements continue from now.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void reset_energy(void)
+{
+	istate_t int_state = __get_interrupt_state();
+	u32 now;
+	u8 slot;
+	
+	__disable_interrupt();
+	
+	now = Rtc_GetTicks();
+	memset(sEnergy.ticks, 0, sizeof(sEnergy.ticks));
+	for (slot = 0; slot < ENERGY_ON_TIME_SLOTS; slot++) sEnergy.on_start[slot] = now;
+	sEnergy.uptime = 0;
+	sEnergy.rank   = 0;
+	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          energy_start
+// @brief       Start on-time measurement of a peripheral. Starting a running slot does nothing.
+// @param       u8 slot		ENERGY_RADIO, ENERGY_BUZZER, ENERGY_BACKLIGHT
+// @return      none
+// *************************************************************************************************
+void energy_start(u8 slot)
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	__disable_interrupt();
+	
+	if ((sEnergy.running & (1u << slot)) == 0)
+	{
+		sEnergy.on_start[slot - ENERGY_ON_TIME_FIRST] = Rtc_GetTicks();
+		sEnergy.running |= (1u << slot);
+	}
+	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          energy_stop
+// @brief       Stop on-time measurement of a peripheral and add the elapsed time.
+// @param       u8 slot		ENERGY_RADIO, ENERGY_BUZZER, ENERGY_BACKLIGHT
+// @return      none
+// *************************************************************************************************
+void energy_stop(u8 slot)
+{
+	istate_t int_state = __get_interrupt_state();
+	
+	__disable_interrupt();
+	
+	if (sEnergy.running & (1u << slot))
+	{
+		sEnergy.ticks[slot] += energy_on_time(slot, Rtc_GetTicks());
+		sEnergy.running &= ~(1u << slot);
+	}
+	
+	__set_interrupt_state(int_state);
+}
+
+
+// *************************************************************************************************
+// @fn          energy_on_time
+// @brief       Time since start of an on-time measurement. The RTC time of day wraps at midnight.
+// @param       u8 slot		ENERGY_RADIO, ENERGY_BUZZER, ENERGY_BACKLIGHT
+//				u32 now		Rtc_GetTicks()
+// @return      u32			ACLK ticks
+// *************************************************************************************************
+static u32 energy_on_time(u8 slot, u32 now)
+{
+	u32 start = sEnergy.on_start[slot - ENERGY_ON_TIME_FIRST];
+	
+	if (now < start) now += RTC_TICKS_PER_DAY;
+	return (now - start);
+}
+
+
+// *************************************************************************************************
+// @fn          energy_tick
+// @brief       Called by Rtc_Sync() when global time advances. Count uptime and add the time of 
+//				running on-time slots, so that the counters grow during long on-times.
+// @param       u32 seconds		Seconds since last call
+// @return      none
+// *************************************************************************************************
+void energy_tick(u32 seconds)
+{
+	u32 now;
+	u8 slot;
+	
+	sEnergy.uptime += seconds;
+	
+	// Only on-time slots (radio, buzzer, backlight) are in running, ENERGY_ENTER does not set it
+	if (sEnergy.running == 0) return;
+	
+	now = Rtc_GetTicks();
+	for (slot = ENERGY_ON_TIME_FIRST; slot < ENERGY_ON_TIME_FIRST + ENERGY_ON_TIME_SLOTS; slot++)
+	{
+		if (sEnergy.running & (1u << slot))
+		{
+			sEnergy.ticks[slot] += energy_on_time(slot, now);
+			sEnergy.on_start[slot - ENERGY_ON_TIME_FIRST] = now;
+		}
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          energy_per_day
+// @brief       Average time per day of a slot.
+// @param       u8 slot		ENERGY_TIMER0_A0 .. ENERGY_BACKLIGHT
+// @return      u32			1/100 sec per day
+// *************************************************************************************************
+u32 energy_per_day(u8 slot)
+{
+	u32 ticks, uptime;
+	
+	// Counters are updated by ISRs
+	__disable_interrupt();
+	ticks  = sEnergy.ticks[slot];
+	uptime = sEnergy.uptime;
+	__enable_interrupt();
+	
+	if (uptime == 0) return (0);
+	
+	// Keep ticks*4219 within 32 bit. Slot time <= uptime, so uptime stays > 0.
+	while (ticks >= 0x80000ul)
+	{
+		ticks  >>= 1;
+		uptime >>= 1;
+	}
+	
+	// 86400 sec/day * 100 / 32768 ticks/sec = 263.67 ~ 4219/16
+	return ((ticks * 4219u) / (uptime * 16u));
+}
+
+
+// *************************************************************************************************
+// @fn          energy_slot_of_rank
+// @brief       Find slot with n-th highest time. Equal times are ranked by slot number.
+// @param       u8 rank		0 = top consumer
+// @return      u8			Slot
+// *************************************************************************************************
+static u8 energy_slot_of_rank(u8 rank)
+{
+	u8 slot, other, higher;
+	
+	for (slot = 0; slot < ENERGY_SLOTS; slot++)
+	{
+		higher = 0;
+		for (other = 0; other < ENERGY_SLOTS; other++)
+		{
+			if ((sEnergy.ticks[other] > sEnergy.ticks[slot]) || 
+				((sEnergy.ticks[other] == sEnergy.ticks[slot]) && (other < slot))) higher++;
+		}
+		if (higher == rank) break;
+	}
+	return (slot);
+}
+
+
+// *************************************************************************************************
+// @fn          sx_energy_enter
+// @brief       Hidden menu item. Switch LINE2 from battery voltage to energy statistics.
+// @param       u8 line		LINE2
+// @return      none
+// *************************************************************************************************
+void sx_energy_enter(u8 line)
+{
+	// Clean up display before activating hidden menu item
+	fptr_lcd_function_line2(LINE2, DISPLAY_LINE_CLEAR);
+	
+	// Start with top consumer
+	sEnergy.rank = 0;
+	
+	// Menu position is not changed, next item function continues after battery voltage
+	ptrMenu_L2 = &menu_L2_Energy;
+	fptr_lcd_function_line2 = ptrMenu_L2->display_function;
+}
+
+
+// *************************************************************************************************
+// @fn          sx_energy
+// @brief       Button DOWN shows next consumer.
+// @param       u8 line		LINE2
+// @return      none
+// *************************************************************************************************
+void sx_energy(u8 line)
+{
+	if (++sEnergy.rank >= ENERGY_SLOTS) sEnergy.rank = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          mx_energy
+// @brief       Long button NUM clears counters.
+// @param       u8 line		LINE2
+// @return      none
+// *************************************************************************************************
+void mx_energy(u8 line)
+{
+	reset_energy();
+}
+
+
+// *************************************************************************************************
+// @fn          display_energy
+// @brief       Display slot name and average time per day ("x.xx" sec or "xxx" sec) of current rank.
+// @param       u8 line		LINE2
+//				u8 update		DISPLAY_LINE_UPDATE_FULL, DISPLAY_LINE_UPDATE_PARTIAL, DISPLAY_LINE_CLEAR
+// @return      none
+// *************************************************************************************************
+void display_energy(u8 line, u8 update)
+{
+	u8 * str;
+	u32 value;
+	u8 slot;
+	
+	if ((update == DISPLAY_LINE_UPDATE_FULL) || (update == DISPLAY_LINE_UPDATE_PARTIAL))
+	{
+		slot  = energy_slot_of_rank(sEnergy.rank);
+		value = energy_per_day(slot);
+		
+		display_symbol(LCD_SYMB_AVERAGE, SEG_ON);
+		display_chars(LCD_SEG_L2_4_3, (u8 *)energy_label[slot], SEG_ON);
+		
+		if (value < 1000)
+		{
+			// Display x.xx sec
+			str = itoa(value, 3, 0);
+			display_symbol(LCD_SEG_L2_DP, SEG_ON);
+		}
+		else
+		{
+			// Display xxx sec
+			if (value > 99999ul) value = 99999ul;
+			str = itoa(value / 100, 3, 2);
+			display_symbol(LCD_SEG_L2_DP, SEG_OFF);
+		}
+		display_chars(LCD_SEG_L2_2_0, str, SEG_ON);
+	}
+	else if (update == DISPLAY_LINE_CLEAR)
+	{
+		// Clear function-specific symbols
+		display_symbol(LCD_SYMB_AVERAGE, SEG_OFF);
+		display_symbol(LCD_SEG_L2_DP, SEG_OFF);
+	}
+}
+
+#endif /* CONFIG_ENERGY_STATS */
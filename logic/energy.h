@@ -0,0 +1,145 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+
+// *************************************************************************************************
+// Include section
+
+
+// *************************************************************************************************
+// Prototypes section
+
+// Internal functions
+extern void reset_energy(void);
+extern void energy_start(u8 slot);
+extern void energy_stop(u8 slot);
+extern void energy_tick(u32 seconds);
+extern u32 energy_per_day(u8 slot);
+
+// Menu functions
+extern void sx_energy_enter(u8 line);
+extern void sx_energy(u8 line);
+extern void mx_energy(u8 line);
+extern void display_energy(u8 line, u8 update);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Accounting slots - do not renumber, the order is used by SYNC_AP_CMD_GET_ENERGY
+// Interrupt service routines (time from entry to exit)
+#define ENERGY_TIMER0_A0			(0u)
+#define ENERGY_TIMER0_A1_5			(1u)
+#define ENERGY_PORT2				(2u)
+#define ENERGY_ADC12				(3u)
+#define ENERGY_RADIO_ISR			(4u)
+// process_requests() per request flag and display_update()
+#define ENERGY_TEMPERATURE			(5u)
+#define ENERGY_ALTITUDE				(6u)
+#define ENERGY_ALTI_ACCUMULATOR		(7u)
+#define ENERGY_ACCELERATION			(8u)
+#define ENERGY_BATTERY				(9u)
+#define ENERGY_DISPLAY				(10u)
+// Peripheral on-time
+#define ENERGY_RADIO				(11u)
+#define ENERGY_BUZZER				(12u)
+#define ENERGY_BACKLIGHT			(13u)
+// process_requests(), added later
+#define ENERGY_DATALOG				(14u)
+#define ENERGY_INFOMEM				(15u)
+#define ENERGY_PHASE_CLOCK			(16u)
+#define ENERGY_PEDOMETER			(17u)
+#define ENERGY_FLICK				(18u)
+#define ENERGY_RTC					(19u)
+#define ENERGY_SLOTS				(20u)
+
+// Slots started by ENERGY_START, timed with the RTC
+#define ENERGY_ON_TIME_FIRST		(ENERGY_RADIO)
+#define ENERGY_ON_TIME_SLOTS		(3u)
+
+// Counters in one SYNC_ED_TYPE_ENERGY reply packet
+#define ENERGY_SYNC_SLOTS_PER_PACKET	(3u)
+#define ENERGY_SYNC_PACKETS			((ENERGY_SLOTS + ENERGY_SYNC_SLOTS_PER_PACKET - 1) / ENERGY_SYNC_SLOTS_PER_PACKET)
+
+// Accounting hooks, compiled out without CONFIG_ENERGY_STATS
+// ENERGY_ENTER/EXIT:	Code sections that do not nest with themselves and are shorter than one 
+//						Timer0 period (2 sec) - ISRs, requests, display update
+// ENERGY_START/STOP:	Peripheral on-time of any length (ENERGY_RADIO .. ENERGY_BACKLIGHT)
+#ifdef CONFIG_ENERGY_STATS
+#define ENERGY_ENTER(slot)			(sEnergy.start[slot] = TA0R)
+#define ENERGY_EXIT(slot)			(sEnergy.ticks[slot] += (u16)(TA0R - sEnergy.start[slot]))
+#define ENERGY_START(slot)			energy_start(slot)
+#define ENERGY_STOP(slot)			energy_stop(slot)
+#else
+#define ENERGY_ENTER(slot)
+#define ENERGY_EXIT(slot)
+#define ENERGY_START(slot)
+#define ENERGY_STOP(slot)
+#endif
+
+
+// *************************************************************************************************
+// Global Variable section
+struct energy
+{
+	// Accumulated time per slot (ACLK ticks)
+	u32			ticks[ENERGY_SLOTS];
+	
+	// TA0R at start of measurement
+	u16			start[ENERGY_SLOTS];
+	
+	// Rtc_GetTicks() at start of on-time measurement or at last minute event
+	u32			on_start[ENERGY_ON_TIME_SLOTS];
+	
+	// 1 bit per running on-time slot
+	u16			running;
+	
+	// Seconds since last reset
+	u32			uptime;
+	
+	// Rank of slot shown in menu item (0 = top consumer)
+	u8			rank;
+};
+extern struct energy sEnergy;
+
+
+// *************************************************************************************************
+// Extern section
+
+
+#endif /*ENERGY_H_*/
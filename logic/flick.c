@@ -0,0 +1,355 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Wrist flick: turning the watch towards the face switches on the backlight. Armed from power-up,
+// the acceleration sensor is switched off. Every 1.9 sec a look powers it up for a single sample,
+// only a wrist that moved since the last look is followed at 40Hz until it rests.
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+
+// system
+#include "project.h"
+#ifdef CONFIG_FLICK_BACKLIGHT
+
+#include <string.h>
+
+// driver
+#include "display.h"
+#include "ports.h"
+#include "timer.h"
+#include "vti_as.h"
+
+// logic
+#include "energy.h"
+#include "flick.h"
+#ifdef CONFIG_PEDOMETER
+#include "pedometer.h"
+#endif
+
+
+// *************************************************************************************************
+// Prototypes section
+void reset_flick(void);
+void flick_sample(u8 * xyz);
+void flick_block(void);
+void flick_look(void);
+static void flick_start(void);
+static void flick_rest(u8 * xyz);
+static void flick_backlight(void);
+static void flick_look_timer(void);
+
+
+// *************************************************************************************************
+// Defines section
+
+
+// *************************************************************************************************
+// Global Variable section
+struct flick sFlick;
+
+// Requests a look every 1.9 sec
+static struct sw_timer flick_timer;
+
+
+// *************************************************************************************************
+// Extern section
+
+
+// *************************************************************************************************
+// @fn          reset_flick
+// @brief       Clear detector state and arm it.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void reset_flick(void)
+{
+	memset(&sFlick, 0, sizeof(sFlick));
+	
+	// No flick before two looks agree on the first rest
+	sFlick.rest_z = FLICK_Z_FACE;
+	sFlick.busy   = 1;
+	
+	sw_timer_start(&flick_timer, FLICK_LOOK_TICKS, FLICK_LOOK_TICKS, flick_look_timer);
+}
+
+
+// *************************************************************************************************
+// @fn          flick_start
+// @brief       Take 40Hz samples until the wrist rests, the sensor is switched off after that.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void flick_start(void)
+{
+	// Reference sample and FLICK_REST more
+	sFlick.first = 1;
+	sFlick.done  = 0;
+	as_start_background(AS_MODE_40HZ, FLICK_REST + 1);
+}
+
+
+// *************************************************************************************************
+// @fn          flick_look
+// @brief       Take a single sample and compare it to the last one. A wrist that moved is followed
+//				at 40Hz until it rests. While it moves for longer than any flick (walking), looks go
+//				on until two of them agree. Skipped while the sensor is in use, its 40Hz samples 
+//				come through flick_sample then.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void flick_look(void)
+{
+	s8 d, z;
+	
+	if (sAsRing.mode != AS_MODE_OFF) return;
+	
+	z = (s8)as_look();
+	d = z - sFlick.look_z;
+	sFlick.look_z = z;
+	
+	if ((d <= FLICK_LOOK_LEVEL) && (d >= -FLICK_LOOK_LEVEL))
+	{
+		// Wrist rests where the last look found it
+		sFlick.busy   = 0;
+		sFlick.moved  = 0;
+		sFlick.rest_z = z;
+		sFlick.motion = 0;
+		return;
+	}
+	
+	if (sFlick.moved)
+	{
+		// Moved over two looks, slower than a flick even if 40Hz samples saw it rest in between
+		sFlick.busy = 1;
+	}
+	else if (!sFlick.busy)
+	{
+		// Turn may be over already, it still has to come to rest
+		sFlick.motion = FLICK_LOOK_SAMPLES;
+		flick_start();
+	}
+	sFlick.moved = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          flick_look_timer
+// @brief       Request a look. Called in interrupt context.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void flick_look_timer(void)
+{
+	request.flag.flick = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          flick_backlight
+// @brief       Same as pressing the backlight button, and redraw the display.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void flick_backlight(void)
+{
+	// Timer0_A0 switches the backlight off again
+	__disable_interrupt();
+	sButton.backlight_status = 1;
+	sButton.backlight_timeout = 0;
+	P2OUT |= BUTTON_BACKLIGHT_PIN;
+	P2DIR |= BUTTON_BACKLIGHT_PIN;
+	__enable_interrupt();
+	ENERGY_START(ENERGY_BACKLIGHT);
+	
+	display.flag.full_update = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          flick_rest
+// @brief       Wrist came to rest. Classify the movement since the last rest.
+// @param       u8 * xyz		Raw X/Y/Z sample at rest
+// @return      none
+//
+// A flick starts at rest with the face pointing away (arm hanging, hand in the lap), turns for 
+// FLICK_MOTION_MIN to FLICK_MOTION_MAX and comes to rest with the face towards the eyes. It must
+// cover FLICK_DIST digits, Z before the 40Hz samples started counts as well. The part of the turn 
+// seen at 40Hz must move FLICK_SPEED digits every 8 samples on average. A slow turn, the end of a 
+// walk or putting the watch down on a desk are too slow or move for too long, a twitch on the desk
+// or moving the wrist while reading the watch do not start from a face pointing away. A turn that
+// ends between two looks is only seen at rest and passes on FLICK_DIST alone, a turn still moving
+// over two looks is too slow.
+// *************************************************************************************************
+static void flick_rest(u8 * xyz)
+{
+	s8 d, z = (s8)xyz[2];
+	u8 i;
+	u16 seen = 0, dist;
+	
+	for (i = 0; i < 3; i++)
+	{
+		d = (s8)xyz[i] - sFlick.start[i];
+		seen += (d < 0) ? -d : d;
+	}
+	d = sFlick.start[2] - sFlick.rest_z;
+	dist = seen + ((d < 0) ? -d : d);
+	
+	if ((sFlick.rest_z <= FLICK_Z_AWAY) && (z >= FLICK_Z_FACE) && ((s8)xyz[1] <= FLICK_Y_RAISED) &&
+	    (sFlick.motion >= FLICK_MOTION_MIN) && (sFlick.motion <= FLICK_MOTION_MAX) &&
+	    (dist >= FLICK_DIST) && (seen * 8 >= (u16)sFlick.turn * FLICK_SPEED))
+	{
+		flick_backlight();
+	}
+	
+	sFlick.rest_z = z;
+	sFlick.busy   = 0;
+	sFlick.motion = 0;
+	sFlick.turn   = 0;
+	memcpy(sFlick.start, xyz, 3);
+}
+
+
+// *************************************************************************************************
+// @fn          flick_sample
+// @brief       Process one sample. Called by do_acceleration_measurement for every sample of the
+//				block. Only 40Hz samples are used, full rate samples of a menu function are skipped.
+// @param       u8 * xyz		Raw X/Y/Z sample
+// @return      none
+//
+// The wrist rests once FLICK_REST samples in a row stay within FLICK_STILL_LEVEL of a reference 
+// sample. Every other sample counts as movement, so do short pauses within a turn. Movement that 
+// goes on for longer than any flick is taken as a rest right away, so the detector does not sample
+// at 40Hz for as long as the wrist moves slowly.
+// *************************************************************************************************
+void flick_sample(u8 * xyz)
+{
+	s8 d;
+	u8 i, n, moved = 0;
+	u8 rest = (sFlick.turn == 0) ? FLICK_REST_SLOW : FLICK_REST;
+	u16 motion;
+	
+	if (sAsRing.mode != AS_MODE_40HZ) return;
+	
+	// Next look compares to the last sample
+	sFlick.look_z = (s8)xyz[2];
+	
+	if (sFlick.first)
+	{
+		// Reference before the wakeup is long gone
+		sFlick.first = 0;
+		sFlick.still = 0;
+		sFlick.turn  = 0;
+		memcpy(sFlick.ref, xyz, 3);
+		memcpy(sFlick.start, xyz, 3);
+		
+		// No look found the rest before, the pedometer's motion interrupt came right after it
+		if (sFlick.busy) sFlick.rest_z = (s8)xyz[2];
+		return;
+	}
+	
+	for (i = 0; i < 3; i++)
+	{
+		d = (s8)xyz[i] - sFlick.ref[i];
+		if ((d > FLICK_STILL_LEVEL) || (d < -FLICK_STILL_LEVEL)) moved = 1;
+	}
+	
+	if (moved)
+	{
+		// Pause was part of the movement
+		n = 1;
+		if (sFlick.still < rest) n += sFlick.still;
+		motion = sFlick.motion + n;
+		sFlick.motion = (motion > 0xFF) ? 0xFF : (u8)motion;
+		motion = sFlick.turn + n;
+		sFlick.turn   = (motion > 0xFF) ? 0xFF : (u8)motion;
+		sFlick.still  = 0;
+		memcpy(sFlick.ref, xyz, 3);
+		
+		if (sFlick.motion > FLICK_MOTION_MAX)
+		{
+			// Too long for a flick, look until the wrist rests
+			sFlick.motion = 0xFF;
+			sFlick.done   = 1;
+		}
+	}
+	else if ((sFlick.still < rest) && (++sFlick.still == rest))
+	{
+		flick_rest(xyz);
+		sFlick.done = 1;
+		
+		// Rests until the next movement
+		sFlick.still = FLICK_REST_SLOW;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          flick_block
+// @brief       Switch the sensor off once the wrist rests or moved for too long. With the pedometer
+//				on, a motion interrupt stands for movement not seen at 40Hz and the pedometer 
+//				switches the sensor mode. Called before pedometer_block, which clears the motion flag.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void flick_block(void)
+{
+	u16 motion;
+	
+	if (sAsRing.motion)
+	{
+		motion = sFlick.motion + FLICK_MOTION_SAMPLES;
+		sFlick.motion = (motion > 0xFF) ? 0xFF : (u8)motion;
+		sFlick.first  = 1;
+	}
+	
+#ifdef CONFIG_PEDOMETER
+	// Pedometer switches the sensor mode
+	if (is_pedometer()) return;
+#endif
+	
+	if ((sAsRing.background == AS_MODE_40HZ) && sFlick.done)
+	{
+		// Waits for a menu function to release the sensor
+		sFlick.done = 0;
+		
+		// Moving for longer than any flick (walking)
+		if (sFlick.motion > FLICK_MOTION_MAX) sFlick.busy = 1;
+		
+		as_stop_background();
+	}
+}
+
+#endif /* CONFIG_FLICK_BACKLIGHT */
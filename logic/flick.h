@@ -0,0 +1,130 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+
+#ifndef FLICK_H_
+#define FLICK_H_
+
+
+// *************************************************************************************************
+// Include section
+
+
+// *************************************************************************************************
+// Prototypes section
+
+// Internal functions
+extern void reset_flick(void);
+extern void flick_sample(u8 * xyz);
+extern void flick_block(void);
+extern void flick_look(void);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Face points away up to 0.35g on Z, towards the face from 0.7g on (8g range, 71mg/digit)
+#define FLICK_Z_AWAY				(5)
+#define FLICK_Z_FACE				(10)
+
+// Hand above the elbow, the face tilts towards the eyes from -0.14g on Y
+#define FLICK_Y_RAISED				(-2)
+
+// Wrist rests once no axis moved by more than 1 digit for 0.2 sec (samples @ 40Hz)
+#define FLICK_STILL_LEVEL			(1)
+#define FLICK_REST					(8u)
+
+// Before the first movement, 0.5 sec so that the end of a slow turn does not pass for a rest
+#define FLICK_REST_SLOW				(20u)
+
+// Sensor looks every 1.9 sec (just within the 2 sec reach of a software timer),
+// Z changing by more than 1 digit between two looks is movement
+#define FLICK_LOOK_TICKS			(CONV_MS_TO_TICKS(1900))
+#define FLICK_LOOK_LEVEL			(1)
+
+// Movement found by a look stands for 0.25 sec, a pedometer motion interrupt for 0.1 sec 
+// (samples @ 40Hz)
+#define FLICK_LOOK_SAMPLES			(10u)
+#define FLICK_MOTION_SAMPLES		(4u)
+
+// Turn between two rests takes 0.15 .. 1.5 sec (samples @ 40Hz)
+#define FLICK_MOTION_MIN			(6u)
+#define FLICK_MOTION_MAX			(60u)
+
+// Turn covers at least 8 digits, 6 digits every 8 samples on average
+#define FLICK_DIST					(8u)
+#define FLICK_SPEED					(6u)
+
+
+// *************************************************************************************************
+// Global Variable section
+struct flick
+{
+	// Z at the last rest
+	s8					rest_z;
+	
+	// Movement since the last rest (samples @ 40Hz) and the part of it seen at 40Hz
+	u8					motion;
+	u8					turn;
+	
+	// Sample the turn seen at 40Hz started with
+	s8					start[3];
+	
+	// Samples in a row within FLICK_STILL_LEVEL of the reference sample
+	u8					still;
+	s8					ref[3];
+	
+	// 1 = next sample is the reference
+	u8					first;
+	
+	// 1 = 40Hz samples are over, switch the sensor off
+	u8					done;
+	
+	// Z of the last look or 40Hz sample
+	s8					look_z;
+	
+	// 1 = last look found the wrist moved
+	u8					moved;
+	
+	// 1 = wrist moves for longer than any flick, looks do not start 40Hz samples
+	u8					busy;
+};
+extern struct flick sFlick;
+
+
+// *************************************************************************************************
+// Extern section
+
+
+#endif /*FLICK_H_*/
@@ -78,6 +78,10 @@
 #include "phase_clock.h"
 #endif
 
+#ifdef CONFIG_PEDOMETER
+#include "pedometer.h"
+#endif
+
 #ifdef CONFIG_EGGTIMER
 #include "eggtimer.h"
 #endif
@@ -98,6 +102,10 @@
 #include "strength.h"
 #endif
 
+#ifdef CONFIG_ENERGY_STATS
+#include "energy.h"
+#endif
+
 #ifdef CONFIG_USE_GPS
 #include "gps.h"
 #endif
@@ -356,11 +364,26 @@ const struct menu menu_L2_Eggtimer =
         FUNCTION(update_eggtimer),      // new display data
 };
 #endif
+#ifdef CONFIG_PEDOMETER
+// Line2 - Pedometer (steps today, cadence, activity level)
+const struct menu menu_L2_Pedometer =
+{
+	FUNCTION(sx_pedometer),			// direct function
+	FUNCTION(mx_pedometer),			// sub menu function
+	FUNCTION(menu_skip_next),		// next item function
+	FUNCTION(display_pedometer),	// display function
+	FUNCTION(update_time),			// new display data
+};
+#endif
 // Line2 - Battery 
 #ifdef CONFIG_BATTERY
 const struct menu menu_L2_Battery =
 {
+	#ifndef CONFIG_ENERGY_STATS
 	FUNCTION(dummy),					// direct function
+	#else
+	FUNCTION(sx_energy_enter),			// direct function switches to energy statistics
+	#endif
 	#ifndef CONFIG_USE_DISCRET_RFBSL
 	FUNCTION(dummy),					// sub menu function
 	#else
@@ -371,6 +394,17 @@ const struct menu menu_L2_Battery =
 	FUNCTION(update_battery_voltage),	// new display data
 };
 #endif
+#ifdef CONFIG_ENERGY_STATS
+// Line2 - Energy statistics (hidden, entered from battery voltage)
+const struct menu menu_L2_Energy =
+{
+	FUNCTION(sx_energy),				// direct function
+	FUNCTION(mx_energy),				// sub menu function
+	FUNCTION(menu_skip_next),			// next item function
+	FUNCTION(display_energy),			// display function
+	FUNCTION(update_time),				// new display data
+};
+#endif
 #ifdef CONFIG_PHASE_CLOCK
 // Line2 - ACC (acceleration data + button events via SimpliciTI)
 const struct menu menu_L2_Phase =
@@ -529,6 +563,9 @@ const struct menu *menu_L2[]={
 	#ifdef CONFIG_EGGTIMER
 	&menu_L2_Eggtimer,
 	#endif
+	#ifdef CONFIG_PEDOMETER
+	&menu_L2_Pedometer,
+	#endif
 	#ifdef CONFIG_BATTERY
 	&menu_L2_Battery,
 	#endif
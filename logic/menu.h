@@ -97,6 +97,7 @@ extern const struct menu menu_L2_CycleAlarm;
 extern const struct menu menu_L2_Stopwatch;
 extern const struct menu menu_L2_Eggtimer;
 extern const struct menu menu_L2_Battery;
+extern const struct menu menu_L2_Energy;
 extern const struct menu menu_L2_Rf;
 extern const struct menu menu_L2_Phase;
 extern const struct menu menu_L2_Ppt;
@@ -0,0 +1,484 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Step counter and activity level. Runs around the clock on the acceleration sensor's background 
+// modes: 40Hz samples while the wrist moves, motion detection (no samples, no wakeups) while it 
+// is still.
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+
+// system
+#include "project.h"
+#ifdef CONFIG_PEDOMETER
+
+#include <string.h>
+
+// driver
+#include "display.h"
+#include "ports.h"
+#include "vti_as.h"
+#include "dsp.h"
+
+// logic
+#include "menu.h"
+#include "clock.h"
+#include "pedometer.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+void reset_pedometer(void);
+u8 is_pedometer(void);
+void pedometer_sample(u8 * xyz);
+void pedometer_block(void);
+void pedometer_minute(void);
+u8 pedometer_sync_packet(u8 index, u8 * data);
+static void pedometer_start(void);
+static void pedometer_hour(void);
+static void pedometer_add(u8 steps);
+static void pedometer_step(void);
+static void pedometer_filter(s16 magnitude);
+static u32 pedometer_today(void);
+
+
+// *************************************************************************************************
+// Defines section
+
+
+// *************************************************************************************************
+// Global Variable section
+struct pedometer sPedometer;
+
+
+// *************************************************************************************************
+// Extern section
+
+
+// *************************************************************************************************
+// @fn          reset_pedometer
+// @brief       Clear counters and start counting. The sensor waits for the first movement.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void reset_pedometer(void)
+{
+	memset(&sPedometer, 0, sizeof(sPedometer));
+	sPedometer.view = DISPLAY_PEDOMETER_STEPS;
+	
+	pedometer_start();
+}
+
+
+// *************************************************************************************************
+// @fn          is_pedometer
+// @brief       Returns 1 if steps are counted.
+// @param       none
+// @return      u8		1 = pedometer is on
+// *************************************************************************************************
+u8 is_pedometer(void)
+{
+	return (sPedometer.on);
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_start
+// @brief       Put the sensor into motion detection, sampling starts when the wrist moves.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void pedometer_start(void)
+{
+	sPedometer.on			= 1;
+	sPedometer.fresh		= 1;
+	sPedometer.since		= 0xFF;
+	sPedometer.candidates	= 0;
+	sPedometer.hour			= sTime.hour;
+	
+	as_start_background(AS_MODE_MOTION, 1);
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_hour
+// @brief       Move counters to the current hour of the day. Hours skipped since the last call
+//				start from zero, so the slots from midnight up to now always hold today.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void pedometer_hour(void)
+{
+	while (sPedometer.hour != sTime.hour)
+	{
+		if (++sPedometer.hour > 23) sPedometer.hour = 0;
+		sPedometer.steps[sPedometer.hour]    = 0;
+		sPedometer.activity[sPedometer.hour] = 0;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_add
+// @brief       Add steps to the current minute and hour.
+// @param       u8 steps		Number of steps
+// @return      none
+// *************************************************************************************************
+static void pedometer_add(u8 steps)
+{
+	pedometer_hour();
+	sPedometer.minute_steps += steps;
+	sPedometer.steps[sPedometer.hour] += steps;
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_step
+// @brief       Check the interval of a detected peak. A peak too soon after the last step is the 
+//				second peak of the same step and ignored. Steps are counted once PEDOMETER_REGULATION
+//				of them came in a row at a valid interval, the first ones are added then. A pause 
+//				longer than PEDOMETER_STEP_MAX starts over.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void pedometer_step(void)
+{
+	if (sPedometer.since < PEDOMETER_STEP_MIN) return;
+	
+	if (sPedometer.since > PEDOMETER_STEP_MAX)
+	{
+		// First step after a pause
+		sPedometer.candidates = 1;
+	}
+	else if (sPedometer.candidates < PEDOMETER_REGULATION)
+	{
+		if (++sPedometer.candidates == PEDOMETER_REGULATION) pedometer_add(PEDOMETER_REGULATION);
+	}
+	else
+	{
+		pedometer_add(1);
+	}
+	sPedometer.since = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_filter
+// @brief       Step detection on one 40Hz magnitude sample.
+// @param       s16 magnitude		Acceleration magnitude (1/16 digit of the 8g range)
+// @return      none
+//
+// Gravity is removed with a slow average, what remains is the acceleration of the arm. Walking
+// makes it swing up and down once per step. The detector looks for a peak followed by a drop 
+// of at least the hysteresis, then for a trough followed by a rise of the same amount. The 
+// hysteresis grows with the swing of the last steps, so small wiggles on top of a step do not 
+// count as peaks of their own.
+// *************************************************************************************************
+static void pedometer_filter(s16 magnitude)
+{
+	s16 s, d, hyst;
+	
+	if (sPedometer.fresh)
+	{
+		moving_avg_init(&sPedometer.smooth, sPedometer.smooth_buf, PEDOMETER_SMOOTH_SHIFT, magnitude);
+		sPedometer.gravity = (s32)magnitude << 4;
+		sPedometer.rising  = 1;
+		sPedometer.peak    = 0;
+		sPedometer.fresh   = 0;
+	}
+	
+	s = moving_avg_filter(&sPedometer.smooth, magnitude);
+	sPedometer.gravity = iir1_filter(sPedometer.gravity, (s32)s << 4, PEDOMETER_GRAVITY_ALPHA);
+	d = s - (s16)(sPedometer.gravity >> 4);
+	
+	if (sPedometer.since < 0xFF) sPedometer.since++;
+	
+	// Activity and still detection
+	if (d < 0)	sPedometer.minute_activity -= d;
+	else		sPedometer.minute_activity += d;
+	if ((d > PEDOMETER_STILL_LEVEL) || (d < -PEDOMETER_STILL_LEVEL))	sPedometer.still = 0;
+	else if (sPedometer.still < 0xFFFF)									sPedometer.still++;
+	
+	hyst = sPedometer.swing / 4;
+	if (hyst < PEDOMETER_HYST_MIN) hyst = PEDOMETER_HYST_MIN;
+	
+	if (sPedometer.rising)
+	{
+		if (d > sPedometer.peak)
+		{
+			sPedometer.peak = d;
+		}
+		else if (d < sPedometer.peak - hyst)
+		{
+			// Peak is behind us
+			sPedometer.rising = 0;
+			sPedometer.trough = d;
+			if (sPedometer.peak >= PEDOMETER_PEAK_MIN) pedometer_step();
+		}
+	}
+	else
+	{
+		if (d < sPedometer.trough)
+		{
+			sPedometer.trough = d;
+		}
+		else if (d > sPedometer.trough + hyst)
+		{
+			// Trough is behind us, track swing of the step
+			sPedometer.swing += (sPedometer.peak - sPedometer.trough - sPedometer.swing) / 4;
+			sPedometer.rising = 1;
+			sPedometer.peak   = d;
+		}
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_sample
+// @brief       Process one sample. Called by do_acceleration_measurement for every sample of the
+//				block. Full rate samples of a menu function are scaled to the 8g range and averaged
+//				down to 40Hz.
+// @param       u8 * xyz		Raw X/Y/Z sample
+// @return      none
+// *************************************************************************************************
+void pedometer_sample(u8 * xyz)
+{
+	s16 x = (s8)xyz[0];
+	s16 y = (s8)xyz[1];
+	s16 z = (s8)xyz[2];
+	u32 sq;
+	
+	if (!sPedometer.on) return;
+	
+	sq = (u32)((s32)x * x) + (u32)((s32)y * y) + (u32)((s32)z * z);
+	
+	if (sAsRing.mode == AS_MODE_FULL)
+	{
+		// 2g range has 4 times the resolution of the 8g range
+		sPedometer.decimate_sum += isqrt32(sq << 4);
+		if (++sPedometer.decimate < PEDOMETER_DECIMATE) return;
+		
+		pedometer_filter((s16)(sPedometer.decimate_sum / PEDOMETER_DECIMATE));
+		sPedometer.decimate = 0;
+		sPedometer.decimate_sum = 0;
+	}
+	else
+	{
+		pedometer_filter((s16)isqrt32(sq << 8));
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_block
+// @brief       Switch sensor mode after a block of samples or a motion interrupt. Sampling starts
+//				when the sensor detects motion and stops after PEDOMETER_STILL_SAMPLES without.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void pedometer_block(void)
+{
+	if (!sPedometer.on) return;
+	
+	if (sAsRing.motion)
+	{
+		sAsRing.motion		= 0;
+		sPedometer.fresh	= 1;
+		sPedometer.still	= 0;
+		sPedometer.since	= 0xFF;
+		as_start_background(AS_MODE_40HZ, PEDOMETER_BLOCK);
+	}
+	else if ((sAsRing.background == AS_MODE_40HZ) && (sPedometer.still >= PEDOMETER_STILL_SAMPLES))
+	{
+		// Moves on to motion detection once a menu function releases the sensor
+		as_start_background(AS_MODE_MOTION, 1);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_minute
+// @brief       Called by process_requests once per minute. Closes the minute: steps give the 
+//				cadence, mean deviation from gravity the activity level. Also picks up a motion
+//				interrupt whose edge was missed.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void pedometer_minute(void)
+{
+	u32 level;
+	
+	if (!sPedometer.on) return;
+	
+	pedometer_hour();
+	
+	// Still time counts as no activity
+	level = sPedometer.minute_activity * PEDOMETER_MG_PER_DIGIT / (16 * PEDOMETER_MINUTE_SAMPLES);
+	if (level > 999) level = 999;
+	
+	sPedometer.cadence	= sPedometer.minute_steps;
+	sPedometer.level	= (u16)level;
+	
+	// Saturate instead of overflow
+	if (sPedometer.activity[sPedometer.hour] > 0xFFFF - level)	sPedometer.activity[sPedometer.hour] = 0xFFFF;
+	else														sPedometer.activity[sPedometer.hour] += level;
+	
+	sPedometer.minute_steps		= 0;
+	sPedometer.minute_activity	= 0;
+	
+	as_poll();
+	if (sAsRing.motion) pedometer_block();
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_today
+// @brief       Steps from midnight up to now.
+// @param       none
+// @return      u32		Steps
+// *************************************************************************************************
+static u32 pedometer_today(void)
+{
+	u32 sum = 0;
+	u8 i;
+	
+	pedometer_hour();
+	for (i = 0; i <= sPedometer.hour; i++) sum += sPedometer.steps[i];
+	
+	return (sum);
+}
+
+
+// *************************************************************************************************
+// @fn          pedometer_sync_packet
+// @brief       Fill a SYNC_ED_TYPE_STEPS reply packet.
+// @param       u8 index		Packet number (0 .. PEDOMETER_SYNC_PACKETS-1)
+//				u8 * data		Packet, data[0] holds the type
+// @return      u8				Number of bytes used
+//
+// (1) first hour (2) current hour (3..18) steps and activity (mg minutes) of 4 hours, all values
+// MSB first. Slots after the current hour are from yesterday.
+// *************************************************************************************************
+u8 pedometer_sync_packet(u8 index, u8 * data)
+{
+	u8 i, hour, pos = 3;
+	
+	pedometer_hour();
+	hour = index * PEDOMETER_SYNC_HOURS_PER_PACKET;
+	data[1] = hour;
+	data[2] = sPedometer.hour;
+	
+	for (i = 0; i < PEDOMETER_SYNC_HOURS_PER_PACKET; i++, hour++)
+	{
+		data[pos++] = sPedometer.steps[hour] >> 8;
+		data[pos++] = sPedometer.steps[hour] & 0xFF;
+		data[pos++] = sPedometer.activity[hour] >> 8;
+		data[pos++] = sPedometer.activity[hour] & 0xFF;
+	}
+	
+	return (pos);
+}
+
+
+// *************************************************************************************************
+// @fn          sx_pedometer
+// @brief       Button DOWN shows steps today, cadence or activity level.
+// @param       u8 line		LINE2
+// @return      none
+// *************************************************************************************************
+void sx_pedometer(u8 line)
+{
+	if (++sPedometer.view > DISPLAY_PEDOMETER_ACTIVITY) sPedometer.view = DISPLAY_PEDOMETER_STEPS;
+}
+
+
+// *************************************************************************************************
+// @fn          mx_pedometer
+// @brief       Long NUM switches the pedometer off and on. Counters are kept.
+// @param       u8 line		LINE2
+// @return      none
+// *************************************************************************************************
+void mx_pedometer(u8 line)
+{
+	if (sPedometer.on)
+	{
+		sPedometer.on = 0;
+		as_stop_background();
+	}
+	else
+	{
+		pedometer_start();
+	}
+	
+	// Clear button flags
+	button.all_flags = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          display_pedometer
+// @brief       Display routine. 
+// @param       u8 line			LINE2
+//				u8 update		DISPLAY_LINE_UPDATE_FULL, DISPLAY_LINE_UPDATE_PARTIAL, DISPLAY_LINE_CLEAR
+// @return      none
+// *************************************************************************************************
+void display_pedometer(u8 line, u8 update)
+{
+	u32 steps;
+	
+	if ((update != DISPLAY_LINE_UPDATE_FULL) && (update != DISPLAY_LINE_UPDATE_PARTIAL)) return;
+	
+	if (!sPedometer.on)
+	{
+		display_chars(LCD_SEG_L2_4_0, (u8 *)"  OFF", SEG_ON);
+		return;
+	}
+	
+	switch (sPedometer.view)
+	{
+		case DISPLAY_PEDOMETER_STEPS:		steps = pedometer_today();
+											if (steps > 99999ul) steps = 99999ul;
+											display_chars(LCD_SEG_L2_4_0, itoa(steps, 5, 4), SEG_ON);
+											break;
+		case DISPLAY_PEDOMETER_CADENCE:		display_chars(LCD_SEG_L2_4_3, (u8 *)"CA", SEG_ON);
+											display_chars(LCD_SEG_L2_2_0, itoa(sPedometer.cadence, 3, 2), SEG_ON);
+											break;
+		default:							display_chars(LCD_SEG_L2_4_3, (u8 *)"AC", SEG_ON);
+											display_chars(LCD_SEG_L2_2_0, itoa(sPedometer.level, 3, 2), SEG_ON);
+											break;
+	}
+}
+
+#endif /* CONFIG_PEDOMETER */
@@ -0,0 +1,165 @@
+// *************************************************************************************************
+//
+//	Copyright (C) 2009 Texas Instruments Incorporated - http://www.ti.com/ 
+//	 
+//	 
+//	  Redistribution and use in source and binary forms, with or without 
+//	  modification, are permitted provided that the following conditions 
+//	  are met:
+//	
+//	    Redistributions of source code must retain the above copyright 
+//	    notice, this list of conditions and the following disclaimer.
+//	 
+//	    Redistributions in binary form must reproduce the above copyright
+//	    notice, this list of conditions and the following disclaimer in the 
+//	    documentation and/or other materials provided with the   
+//	    distribution.
+//	 
+//	    Neither the name of Texas Instruments Incorporated nor the names of
+//	    its contributors may be used to endorse or promote products derived
+//	    from this software without specific prior written permission.
+//	
+//	  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+//	  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+//	  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//	  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+//	  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+//	  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+//	  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//	  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//	  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+//	  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+//	  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// *************************************************************************************************
+
+#ifndef PEDOMETER_H_
+#define PEDOMETER_H_
+
+
+// *************************************************************************************************
+// Include section
+#include "dsp.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+
+// Internal functions
+extern void reset_pedometer(void);
+extern u8 is_pedometer(void);
+extern void pedometer_sample(u8 * xyz);
+extern void pedometer_block(void);
+extern void pedometer_minute(void);
+extern u8 pedometer_sync_packet(u8 index, u8 * data);
+
+// Menu functions
+extern void sx_pedometer(u8 line);
+extern void mx_pedometer(u8 line);
+extern void display_pedometer(u8 line, u8 update);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Menu item views
+#define DISPLAY_PEDOMETER_STEPS		(0u)
+#define DISPLAY_PEDOMETER_CADENCE	(1u)
+#define DISPLAY_PEDOMETER_ACTIVITY	(2u)
+
+// Samples per main loop wakeup @ 40Hz (0.75 sec)
+#define PEDOMETER_BLOCK				(30u)
+
+// Full rate samples (400Hz) averaged to one 40Hz sample while a menu function runs the sensor
+#define PEDOMETER_DECIMATE			(10u)
+
+// Magnitude is kept in 1/16 digit of the 8g range (1g = 224), smoothed over 2^shift samples
+#define PEDOMETER_SMOOTH_SHIFT		(2u)
+
+// Gravity follows orientation with a time constant of 32 samples (0.8 sec)
+#define PEDOMETER_GRAVITY_ALPHA		DSP_Q15(1.0 / 32)
+
+// Peak detector: smallest peak above gravity (0.1g), smallest swing between peak and trough (0.06g)
+#define PEDOMETER_PEAK_MIN			(22)
+#define PEDOMETER_HYST_MIN			(13)
+
+// Valid step interval in samples @ 40Hz (0.25 .. 2 sec = 240 .. 30 steps/min)
+#define PEDOMETER_STEP_MIN			(10u)
+#define PEDOMETER_STEP_MAX			(80u)
+
+// Steps in a row at a valid interval before they are counted (shorter bouts are arm movements)
+#define PEDOMETER_REGULATION		(4u)
+
+// Wrist is still while the magnitude stays within 0.08g of gravity for 10 sec
+#define PEDOMETER_STILL_LEVEL		(18)
+#define PEDOMETER_STILL_SAMPLES		(400u)
+
+// Samples per minute @ 40Hz and mg per 1/16 digit (71mg/digit), for the activity level
+#define PEDOMETER_MINUTE_SAMPLES	(2400ul)
+#define PEDOMETER_MG_PER_DIGIT		(71ul)
+
+// Hours in one SYNC_ED_TYPE_STEPS reply packet
+#define PEDOMETER_SYNC_HOURS_PER_PACKET	(4u)
+#define PEDOMETER_SYNC_PACKETS		(24u / PEDOMETER_SYNC_HOURS_PER_PACKET)
+
+
+// *************************************************************************************************
+// Global Variable section
+struct pedometer
+{
+	// 1 = counting steps
+	u8					on;
+	
+	// DISPLAY_PEDOMETER_STEPS, _CADENCE, _ACTIVITY
+	u8					view;
+	
+	// Full rate samples added up for the next 40Hz sample
+	u8					decimate;
+	u16					decimate_sum;
+	
+	// 1 = filters start again with the next sample
+	u8					fresh;
+	
+	// Smoothed magnitude and gravity (1/16 digit, gravity 1/256 digit)
+	struct moving_avg	smooth;
+	s16					smooth_buf[1u << PEDOMETER_SMOOTH_SHIFT];
+	s32					gravity;
+	
+	// Peak detector state, peak and trough relative to gravity
+	u8					rising;
+	s16					peak;
+	s16					trough;
+	
+	// Average swing from trough to peak of the last steps
+	s16					swing;
+	
+	// Samples since the last step (saturates)
+	u8					since;
+	
+	// Steps in a row while waiting for PEDOMETER_REGULATION
+	u8					candidates;
+	
+	// Samples without movement
+	u16					still;
+	
+	// Current minute: steps and sum of deviation from gravity
+	u16					minute_steps;
+	u32					minute_activity;
+	
+	// Last full minute: steps (= steps/min) and mean deviation from gravity (mg)
+	u16					cadence;
+	u16					level;
+	
+	// Steps and activity (mg minutes) per hour of the day, hour of the current slot
+	u16					steps[24];
+	u16					activity[24];
+	u8					hour;
+};
+extern struct pedometer sPedometer;
+
+
+// *************************************************************************************************
+// Extern section
+
+
+#endif /*PEDOMETER_H_*/
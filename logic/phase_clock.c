@@ -52,6 +52,7 @@
 #include "ports.h"
 #include "timer.h"
 #include "radio.h"
+#include "flash.h"
 
 // logic
 #include "acceleration.h"
@@ -69,91 +70,92 @@
 
 // *************************************************************************************************
 // Prototypes section
-void simpliciti_get_data_callback(void);
-void start_simpliciti_sleep();
-void start_simpliciti_sync(void);
+void reset_phase_clock(void);
+void phase_clock_sample(u8 * xyz);
+void phase_clock_minute(void);
+u8 phase_clock_batch(u8 * data);
+static void phase_clock_start_sensor(void);
+static void phase_clock_store(void);
+static u16 phase_clock_epoch(u16 index);
+static void phase_clock_upload(void);
 
 
 // *************************************************************************************************
 // Defines section
-#define TEST
-
-// Each packet index requires 2 bytes, so we can have 9 packet indizes in 18 bytes usable payload
-#define BM_SYNC_BURST_PACKETS_IN_DATA		(9u)
 
 
 // *************************************************************************************************
 // Global Variable section
 struct SPhase sPhase;
 
-// flag contains status information, trigger to send data and trigger to exit SimpliciTI
-unsigned char phase_clock_flag;
-
-// 4 data bytes to send 
-unsigned char phase_clock_data[SIMPLICITI_MAX_PAYLOAD_LENGTH];
-
-// 4 byte device address overrides SimpliciTI end device address set in "smpl_config.dat"
-unsigned char phase_clock_ed_address[4];
-
-// 1 = send one or more reply packets, 0 = no need to reply
-//unsigned char simpliciti_reply;
-unsigned char phase_clock_reply_count;
-
-// 1 = send packets sequentially from burst_start to burst_end, 2 = send packets addressed by their index
-//u8 		burst_mode;
-
-// Start and end index of packets to send out
-//u16		burst_start, burst_end;
-
-// Array containing requested packets
-//u16		burst_packet[BM_SYNC_BURST_PACKETS_IN_DATA];
 
-// Current packet index
-//u8		burst_packet_index;
+// *************************************************************************************************
+// Extern section
 
 
 // *************************************************************************************************
-// Extern section
+// @fn          reset_phase_clock
+// @brief       Reset sleep phase recording.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void reset_phase_clock(void)
+{
+	memset(&sPhase, 0, sizeof(sPhase));
+}
 
 
 // *************************************************************************************************
-// @fn          sx_sleep
-// @brief       Start Sleep mode. Button DOWN connects/disconnects to access point.
+// @fn          sx_phase
+// @brief       Button DOWN starts recording movement, or stops recording and uploads the epochs to 
+//				the access point. Data left from a failed upload is sent before a new recording starts.
 // @param       u8 line		LINE2
 // @return      none
 // *************************************************************************************************
 void sx_phase(u8 line)
 {
-	// Exit if battery voltage is too low for radio operation
-	if (sys.flag.low_battery) return;
-
-    sPhase.session = 0;
-    sPhase.out_nr = 0;
-    sPhase.data_nr = 0;
-
-	// Exit if BlueRobin stack is active
-#ifndef ELIMINATE_BLUEROBIN
-	if (is_bluerobin()) return;
-#endif
-  	// Start SimpliciTI in tx only mode
-    if(sPhase.bug)
-        start_simpliciti_tx_only(SIMPLICITI_PHASE_CLOCK);
-    else
-        start_simpliciti_tx_only(SIMPLICITI_PHASE_CLOCK_START);
-    //start_simpliciti_tx_only(SIMPLICITI_PHASE_CLOCK);
+	if (sPhase.recording)
+	{
+		// Keep sensor running for acceleration display
+		if (!is_acceleration_measurement()) as_stop();
+		
+		// Store last (partial) epoch
+		phase_clock_store();
+		sPhase.recording = 0;
+		display_symbol(LCD_ICON_RECORD, SEG_OFF);
+		
+		phase_clock_upload();
+	}
+	else
+	{
+		if (sPhase.flash_epochs + sPhase.ram_epochs > 0) phase_clock_upload();
+		
+		// Start with empty log
+		sPhase.epochs		= 0;
+		sPhase.first		= 0;
+		sPhase.flash_epochs	= 0;
+		sPhase.ram_epochs	= 0;
+		sPhase.activity		= 0;
+		sPhase.countdown	= sPhase.interval * 60;
+		sPhase.recording	= 1;
+		
+		phase_clock_start_sensor();
+		display_symbol(LCD_ICON_RECORD, SEG_ON);
+	}
 }
 
 // *************************************************************************************************
 // @fn          mx_phase
-// @brief       Set program number to use
+// @brief       Set program number to use, bug mode and upload interval
 // @param       u8 line		LINE2
 // @return      none
 // *************************************************************************************************
 void mx_phase(u8 line){
-		s32 prog, bug;
+		s32 prog, bug, interval;
         u8 mode = 0;
 		prog = (s32)sPhase.program;
         bug = (s32)sPhase.bug;
+		interval = (s32)sPhase.interval;
 		// Loop values until all are set or user breaks	set
 		while(1) 
 		{
@@ -168,11 +170,13 @@ void mx_phase(u8 line){
 				//sAlarm.minute = minutes;
 				sPhase.program = (u8)prog;
                 sPhase.bug = (u8)bug;
+				sPhase.interval = (u8)interval;
+				sPhase.countdown = sPhase.interval * 60;
 				display.flag.line2_full_update = 1;
 				break;
 			}
 			if (button.flag.star) 
-                mode = (mode+1)%2;
+                mode = (mode+1)%3;
 
             switch (mode) {
                 case 0:
@@ -184,6 +188,10 @@ void mx_phase(u8 line){
                     display_chars(LCD_SEG_L2_5_0, (u8 *)" BUG", SEG_ON);
                     set_value(&bug, 2, 0, 0, 1, SETVALUE_ROLLOVER_VALUE + SETVALUE_DISPLAY_VALUE + SETVALUE_NEXT_VALUE, LCD_SEG_L2_1_0, display_value1);
                     break;
+                case 2:
+                    display_chars(LCD_SEG_L2_5_0, (u8 *)" INT", SEG_ON);
+                    set_value(&interval, 2, 0, 0, SLEEP_UPLOAD_INTERVAL_MAX, SETVALUE_ROLLOVER_VALUE + SETVALUE_DISPLAY_VALUE + SETVALUE_NEXT_VALUE, LCD_SEG_L2_1_0, display_value1);
+                    break;
             }
 		}
 	
@@ -205,36 +213,189 @@ static u8 diff(u8 x1, u8 x2) {
     if(b1 > 127)
         b1 = x2 - x1;
     // high pass filter
-    if (b1 < 2)
+    if (b1 < SLEEP_HIGH_PASS)
         return 0;
     return b1;
 }
 
 // *************************************************************************************************
-// @fn          phase_clock_calcpoint
-// @brief       calculate one data point for the out buffer
+// @fn          phase_clock_start_sensor
+// @brief       Start acceleration sensor with one main loop wakeup per SLEEP_AS_BLOCK samples.
 // @param       none
 // @return      none
 // *************************************************************************************************
-void phase_clock_calcpoint() {
-	u16 x,y,z,res;
-	x = y = z = res = 0;
+static void phase_clock_start_sensor(void)
+{
+	as_start();
+	as_set_block(SLEEP_AS_BLOCK);
+	sPhase.xyz_valid = 0;
+}
 
-	u8 i = 0;
-	for(i=1;i<SLEEP_DATA_BUFFER;i++) {
-		x += diff(sPhase.data[i-1][0], sPhase.data[i][0]);
-		y += diff(sPhase.data[i-1][1], sPhase.data[i][1]);
-		z += diff(sPhase.data[i-1][2], sPhase.data[i][2]);
+// *************************************************************************************************
+// @fn          phase_clock_sample
+// @brief       Add movement since last sample to current epoch. Called by do_acceleration_measurement
+//				with the latest sample of each block.
+// @param       u8 * xyz		Raw X/Y/Z sample
+// @return      none
+// *************************************************************************************************
+void phase_clock_sample(u8 * xyz)
+{
+	u8 i, d;
+	
+	if (!sPhase.recording) return;
+	
+	if (sPhase.xyz_valid)
+	{
+		for (i=0; i<3; i++)
+		{
+			d = diff(sPhase.xyz[i], xyz[i]);
+			
+			// Saturate instead of overflow
+			if (sPhase.activity > 0xFFFF - d)	sPhase.activity = 0xFFFF;
+			else								sPhase.activity += d;
+		}
 	}
-	// can't overflow when SLEEP_BUFFER is not larger then 171
-	res = x + y + z;
+	sPhase.xyz[0] = xyz[0];
+	sPhase.xyz[1] = xyz[1];
+	sPhase.xyz[2] = xyz[2];
+	sPhase.xyz_valid = 1;
+}
 
-	// set the result into the out buffer
-	sPhase.out[sPhase.out_nr] = res;
-	sPhase.out_nr++;
+// *************************************************************************************************
+// @fn          phase_clock_store
+// @brief       Close current epoch. Epochs go to RAM, a full RAM buffer is written to flash. 
+//				Epochs are dropped when the log is full.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void phase_clock_store(void)
+{
+	u16 * dest;
+	
+	sPhase.epochs++;
+	if (sPhase.flash_epochs + sPhase.ram_epochs < SLEEP_LOG_EPOCHS)
+	{
+		sPhase.ram[sPhase.ram_epochs++] = sPhase.activity;
+	}
+	sPhase.activity = 0;
+	
+	if (sPhase.ram_epochs < SLEEP_RAM_EPOCHS) return;
+	
+	// Erase flash segment before its first write
+	dest = (u16 *)SLEEP_LOG_START + sPhase.flash_epochs;
+	if ((sPhase.flash_epochs % FLASH_SEGMENT_WORDS) == 0) flash_erase_segment(dest);
+	flash_write(dest, sPhase.ram, SLEEP_RAM_EPOCHS);
+	
+	sPhase.flash_epochs += SLEEP_RAM_EPOCHS;
+	sPhase.ram_epochs = 0;
+}
 
-	sPhase.data_nr = 0;
+// *************************************************************************************************
+// @fn          phase_clock_epoch
+// @brief       Read stored epoch.
+// @param       u16 index		0 = first stored epoch
+// @return      u16				Movement
+// *************************************************************************************************
+static u16 phase_clock_epoch(u16 index)
+{
+	if (index < sPhase.flash_epochs) return (*((u16 *)SLEEP_LOG_START + index));
+	return (sPhase.ram[index - sPhase.flash_epochs]);
+}
+
+// *************************************************************************************************
+// @fn          phase_clock_minute
+// @brief       Called by process_requests once per minute while recording. Closes the epoch, 
+//				restarts the sensor if another function stopped it and uploads at the set interval.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void phase_clock_minute(void)
+{
+	if (!sPhase.recording) return;
+	
+	phase_clock_store();
+	
+	if ((AS_INT_IE & AS_INT_PIN) == 0)	phase_clock_start_sensor();
+	else								as_poll();
+	
+	if (sPhase.interval > 0 && --sPhase.countdown == 0)
+	{
+		sPhase.countdown = sPhase.interval * 60;
+		phase_clock_upload();
+	}
+}
 
+// *************************************************************************************************
+// @fn          phase_clock_upload
+// @brief       Send stored epochs to the access point. The log is cleared if all epochs were sent. 
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void phase_clock_upload(void)
+{
+	// Exit if battery voltage is too low for radio operation
+	if (sys.flag.low_battery) return;
+
+	// Exit if BlueRobin stack is active
+#ifndef ELIMINATE_BLUEROBIN
+	if (is_bluerobin()) return;
+#endif
+
+	sPhase.sent = 0;
+	sPhase.packet = 0;
+	
+	// Start SimpliciTI in tx only mode, get a session id first unless in bug mode
+	if (sPhase.bug)	start_simpliciti_tx_only(SIMPLICITI_PHASE_CLOCK);
+	else			start_simpliciti_tx_only(SIMPLICITI_PHASE_CLOCK_START);
+	
+	if (sPhase.sent > 0 && sPhase.sent == sPhase.flash_epochs + sPhase.ram_epochs)
+	{
+		sPhase.first		+= sPhase.sent;
+		sPhase.flash_epochs	= 0;
+		sPhase.ram_epochs	= 0;
+	}
+	
+	// SimpliciTI stopped the sensor
+	if (sPhase.recording)
+	{
+		phase_clock_start_sensor();
+		display_symbol(LCD_ICON_RECORD, SEG_ON);
+	}
+}
+
+// *************************************************************************************************
+// @fn          phase_clock_batch
+// @brief       Fill next upload packet with stored epochs.
+// @param       u8 * data		Packet payload
+// @return      u8				Payload length, 0 = all epochs sent
+// *************************************************************************************************
+u8 phase_clock_batch(u8 * data)
+{
+	u16 stored = sPhase.flash_epochs + sPhase.ram_epochs;
+	u16 value;
+	u8 i, count;
+	
+	if (sPhase.sent >= stored) return (0);
+	
+	count = SLEEP_BATCH_EPOCHS;
+	if (stored - sPhase.sent < count) count = stored - sPhase.sent;
+	
+	data[0] = SIMPLICITI_PHASE_CLOCK_BATCH_EVENTS;
+	data[1] = (sPhase.session << (8-SLEEP_RF_ID_BIT_LENGHT)) | sPhase.packet;
+	data[2] = (sPhase.first + sPhase.sent) >> 8;
+	data[3] = (sPhase.first + sPhase.sent) & 0xFF;
+	data[4] = sPhase.epochs >> 8;
+	data[5] = sPhase.epochs & 0xFF;
+	data[6] = count;
+	for (i=0; i<count; i++)
+	{
+		value = phase_clock_epoch(sPhase.sent++);
+		data[SLEEP_BATCH_HEADER + 2*i]		= value >> 8;
+		data[SLEEP_BATCH_HEADER + 2*i + 1]	= value & 0xFF;
+	}
+	sPhase.packet = (sPhase.packet + 1) % SLEEP_MAX_PACKET_COUNTER;
+	
+	return (SLEEP_BATCH_HEADER + 2*count);
 }
 
 
@@ -40,6 +40,7 @@
 
 #include "rfsimpliciti.h"
 #include "simpliciti.h"
+#include "flash.h"
 
 // *************************************************************************************************
 // Include section
@@ -47,18 +48,16 @@
 
 // *************************************************************************************************
 // Prototypes section
-extern void reset_sleep(void);
-extern void ping_clock(void);
-extern void collcet_data(void);
-extern void send_data(void);
+extern void reset_phase_clock(void);
+extern void phase_clock_sample(u8 * xyz);
+extern void phase_clock_minute(void);
+extern u8 phase_clock_batch(u8 * data);
 
 extern void display_phase_clock(u8 line, u8 update);
 
 extern void sx_phase(u8 line);
 extern void mx_phase(u8 line);
 
-extern void phase_clock_calcpoint();
-
 
 // *************************************************************************************************
 // Defines section
@@ -79,8 +78,31 @@ typedef enum
 #define SLEEP_MAX_PACKET_COUNTER 32 
 
 
-#define SLEEP_DATA_BUFFER              30
-#define SLEEP_OUT_BUFFER               10
+// Movement of less than this per axis between two samples is sensor noise
+#define SLEEP_HIGH_PASS                      2
+
+// One sample per 24 @ 400Hz, every 60ms like the former online mode
+#define SLEEP_AS_BLOCK                       24
+
+// Epochs (1 minute of movement each) are collected in RAM and spilled to flash when the RAM is full.
+// Log area in main flash: 2 segments below the data logger, 512 epochs or 8.5 hours. The linked image 
+// must end below SLEEP_LOG_START (checked by tools/memory.py, see makefile).
+#define SLEEP_RAM_EPOCHS                     16
+#define SLEEP_LOG_START                      (0xF200u)
+#define SLEEP_LOG_SEGMENTS                   (2u)
+#define SLEEP_LOG_EPOCHS                     (SLEEP_LOG_SEGMENTS * FLASH_SEGMENT_WORDS)
+
+// Hours between uploads while recording, 0 = only when recording is stopped
+#define SLEEP_UPLOAD_INTERVAL_MAX            12
+
+// Upload packet: (0) SIMPLICITI_PHASE_CLOCK_BATCH_EVENTS  (1) session | packet counter  
+// (2..3) index of first epoch  (4..5) epochs since start of recording  (6) number of epochs  
+// (7..) epochs, all 16 bit values MSB first
+#define SLEEP_BATCH_HEADER                   7
+#define SLEEP_BATCH_EPOCHS                   16
+
+// Pause between upload packets (ms)
+#define SLEEP_BATCH_GAP                      10
 
 // how often should a the clock be searched again
 #define SEARCH_CLOCK                         (60*10)
@@ -113,13 +135,27 @@ struct SPhase
     u8                  session;
 	// sleep program to start
 	u8					program;
-    // collected data
-    // 
-	u8                  data[SLEEP_DATA_BUFFER][3];
-    u8                  data_nr;
-    //u8                  out[PHASE_CLOCK_BUFFER];
-    u16                 out[SLEEP_OUT_BUFFER];
-    u8                  out_nr;
+	// 1 = movement is recorded
+	u8					recording;
+	// hours between uploads while recording, 0 = upload when recording is stopped
+	u8					interval;
+	// minutes until next upload
+	u16					countdown;
+	// last sample
+	u8					xyz[3];
+	u8					xyz_valid;
+	// movement in current epoch
+	u16					activity;
+	// epochs since start of recording
+	u16					epochs;
+	// index of first stored epoch, stored epochs are in flash first, then in RAM
+	u16					first;
+	u16					flash_epochs;
+	u16					ram[SLEEP_RAM_EPOCHS];
+	u8					ram_epochs;
+	// stored epochs sent by current upload
+	u16					sent;
+	u8					packet;
 };
 extern struct SPhase sPhase;
 
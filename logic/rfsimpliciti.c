@@ -62,6 +62,7 @@
 #include "bluerobin.h"
 #endif
 #include "simpliciti.h"
+#include "mrfi_bm.h"
 #include "clock.h"
 #include "date.h"
 #include "alarm.h"
@@ -78,23 +79,108 @@
 #ifdef CONFIG_SIDEREAL
 #include "sidereal.h"
 #endif
+
+#ifdef CONFIG_ENERGY_STATS
+#include "energy.h"
+#endif
+
+#ifdef CONFIG_PEDOMETER
+#include "pedometer.h"
+#endif
+
+#ifdef CONFIG_DATALOG
+#include "datalog.h"
+#endif
+
+#ifdef CONFIG_LINK_CACHE
+#include "infomem.h"
+#endif
 // *************************************************************************************************
 // Defines section
 
+// The radio ends its low power delays on the bit that stops the link
+#if (MRFI_CANCEL_MASK != SIMPLICITI_TRIGGER_STOP)
+#error "MRFI_CANCEL_MASK does not match SIMPLICITI_TRIGGER_STOP"
+#endif
+
+// Windowed downloads carry whole log packets
+#if defined(CONFIG_DATALOG) && (DATALOG_PACKET_SIZE != BM_SYNC_BULK_PACKET_SIZE)
+#error "BM_SYNC_BULK_PACKET_SIZE does not match DATALOG_PACKET_SIZE"
+#endif
+
 // Each packet index requires 2 bytes, so we can have 9 packet indizes in 18 bytes usable payload
 #define BM_SYNC_BURST_PACKETS_IN_DATA		(9u)
 
+// Packed acceleration stream: sleep time between callbacks, 8 samples at 400Hz
+#define ACCEL_STREAM_WAIT					(20u)
+
+// Output power control. The access point transmits at about the top level, so it hears the watch with
+// the RSSI of its last frame minus the power reduction. Keep that estimate above LINK_RSSI_TARGET (dBm)
+// and go down one level after LINK_GOOD_FRAMES frames with LINK_RSSI_HYST (dB) to spare at the lower level.
+#define LINK_RSSI_TARGET					(-80)
+#define LINK_RSSI_HYST						(6)
+#define LINK_GOOD_FRAMES					(4u)
+
+// Frames with a higher LQI (lower is better) count as weak
+#define LINK_LQI_WEAK						(48u)
+
+// Go up one level after this many ready-to-receive packets without reply, the access point may not
+// hear the watch any more
+#define LINK_IDLE_PACKETS					(20u)
+
+// Missed replies in the status packet saturate here
+#define LINK_MISSES_MAX						(63u)
+
+// Channel agility. A frame costs CHAN_COST_FRAME, each failed clear channel assessment before it
+// CHAN_COST_CCA more - little radio time itself, but a busy channel also loses frames that do go out.
+// A frame that could not be sent or whose reply is missing costs CHAN_COST_FRAME more for the repetition.
+// The average per channel is kept times 8, a channel never used counts as clean.
+#define CHAN_COST_FRAME						(16u)
+#define CHAN_COST_CCA						(8u)
+#define CHAN_COST_CLEAN						(CHAN_COST_FRAME * 8u)
+
+// Every CHAN_DECIDE_FRAMES frames: ask to move when the average of the current channel is above
+// CHAN_COST_MOVE (one assessment in three busy) and another channel promises CHAN_COST_HYST less. 
+// The other channels drift back towards clean by 1/8 of the difference, interferers come and go.
+#define CHAN_COST_MOVE						(CHAN_COST_CLEAN * 5u / 4u)
+#define CHAN_COST_HYST						(CHAN_COST_CLEAN / 4u)
+#define CHAN_DECIDE_FRAMES					(16u)
+#define CHAN_NONE							(0xFFu)
+
 // *************************************************************************************************
 // Prototypes section
 void simpliciti_get_data_callback(void);
 void start_simpliciti_tx_only(simpliciti_mode_t mode);
 void start_simpliciti_sync(void);
 int simpliciti_get_rvc_callback(u8 len) __attribute__((noinline));
+#ifdef CONFIG_ACCEL_STREAM
+static void accel_stream_pack(void);
+static void accel_stream_add(u8 * xyz);
+#endif
+#ifdef CONFIG_FREQ_AGILITY
+static void channel_charge(u8 chan, u8 cost);
+#endif
 
 
 // *************************************************************************************************
 // Global Variable section
 struct RFsmpl sRFsmpl;
+struct RFlink sRFlink;
+
+// Output power of the levels in mrfiRFPowerTable (dBm)
+static const s8 link_level_dbm[SIMPLICITI_TX_LEVELS] = { -20, -10, 1 };
+
+#ifdef CONFIG_FREQ_AGILITY
+// Channel statistics, kept across SimpliciTI sessions
+static struct
+{
+	u16		cost[SIMPLICITI_CHANNELS];		// Average cost of a frame times 8, 0 = not initialised
+	s8		rssi[SIMPLICITI_CHANNELS];		// RSSI of the last failed clear channel assessment (dBm)
+	u8		chan;							// Channel of the last frame
+	u8		frames;							// Frames since the last decision
+	u8		asked;							// Channel asked for at the last decision, CHAN_NONE = none
+} sRFchan;
+#endif
 
 // flag contains status information, trigger to send data and trigger to exit SimpliciTI
 unsigned char simpliciti_flag;
@@ -112,7 +198,11 @@ unsigned char simpliciti_payload_length;
 //unsigned char simpliciti_reply;
 unsigned char simpliciti_reply_count;
 
-// 1 = send packets sequentially from burst_start to burst_end, 2 = send packets addressed by their index
+// Frames of a windowed memory download, 0 = no download requested
+unsigned int simpliciti_bulk_packets;
+
+// 1 = send packets sequentially from burst_start to burst_end, 2 = send packets addressed by their index,
+// 3 = windowed download of BM_SYNC_BULK_LOG_PACKETS packets per frame from burst_start to burst_end
 u8 		burst_mode;
 
 // Start and end index of packets to send out
@@ -124,6 +214,13 @@ u16		burst_packet[BM_SYNC_BURST_PACKETS_IN_DATA];
 // Current packet index
 u8		burst_packet_index;
 
+#ifdef CONFIG_ACCEL_STREAM
+// Samples for next acceleration stream packet
+u8		accel_stream_xyz[ACCEL_STREAM_SAMPLES][3];
+u8		accel_stream_count;
+u8		accel_stream_seq;
+#endif
+
 
 // *************************************************************************************************
 // Extern section
@@ -241,8 +338,6 @@ void start_simpliciti_tx_only(simpliciti_mode_t mode)
 #ifdef CONFIG_PHASE_CLOCK
     if (mode == SIMPLICITI_PHASE_CLOCK_START || mode == SIMPLICITI_PHASE_CLOCK)
     {
-        if(mode == SIMPLICITI_PHASE_CLOCK)
-            start_as = 1;
     	display_symbol(LCD_ICON_RECORD, SEG_ON_BLINK_ON);
     }
 #endif
@@ -253,6 +348,16 @@ void start_simpliciti_tx_only(simpliciti_mode_t mode)
 	simpliciti_data[1] = 0;
 	simpliciti_data[2] = 0;
 	simpliciti_data[3] = 0;
+#ifdef CONFIG_ACCEL_STREAM
+	// Button events before the first stream packet go out as header without samples
+	if (mode == SIMPLICITI_ACCELERATION)
+	{
+		simpliciti_data[0] = SIMPLICITI_ACCEL_STREAM_EVENTS;
+		accel_stream_count = 0;
+		accel_stream_seq = 0;
+		simpliciti_payload_length = 3;
+	}
+#endif
 	
 	// Turn on beeper icon to show activity
 	display_symbol(LCD_ICON_BEEPER1, SEG_ON_BLINK_ON);
@@ -295,6 +400,9 @@ void start_simpliciti_tx_only(simpliciti_mode_t mode)
 	as_stop();
 	#endif
 
+	// Standard packets are 4 bytes long	
+	simpliciti_payload_length = 4;
+
 	// Powerdown radio
 	close_radio();
 	
@@ -404,18 +512,30 @@ WDTCTL = WDTPW + WDTHOLD;
 #ifdef CONFIG_ACCEL
 	if (sRFsmpl.mode == SIMPLICITI_ACCELERATION)
 	{
+#ifdef CONFIG_ACCEL_STREAM
+		// Wait for next samples
+		Timer0_A4_Delay(CONV_MS_TO_TICKS(ACCEL_STREAM_WAIT));	
+
+		// Samples are collected by PORT2 ISR
+		request.flag.acceleration_measurement = 0;
+		as_poll();
+
+		// Pack samples until a packet is ready, the rest waits in the ring for the next call
+		while (!getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_SEND_DATA) && as_pop_sample(sAccel.xyz))
+		{
+			accel_stream_add(sAccel.xyz);
+		}
+#else
 		// Wait for next sample
 		Timer0_A4_Delay(CONV_MS_TO_TICKS(5));	
 
-		// Read from sensor if DRDY pin indicates new data (set in PORT2 ISR)
-		if (request.flag.acceleration_measurement && ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN))
+		// Samples are collected by PORT2 ISR
+		request.flag.acceleration_measurement = 0;
+		as_poll();
+
+		// Process all samples collected since last call
+		while (as_pop_sample(sAccel.xyz))
 		{
-			// Clear flag
-			request.flag.acceleration_measurement = 0;
-			
-			// Get data from sensor
-			as_get_data(sAccel.xyz);
-			
 			// Transmit only every 3rd data set (= 33 packets / second) 
 			if (packet_counter++ > 1)
 			{
@@ -431,6 +551,7 @@ WDTCTL = WDTPW + WDTHOLD;
 				simpliciti_flag |= SIMPLICITI_TRIGGER_SEND_DATA;
 			}
 		}
+#endif
 	}
 #endif
 #ifdef CONFIG_PHASE_CLOCK
@@ -460,72 +581,12 @@ WDTCTL = WDTPW + WDTHOLD;
 	}
 	else if (sRFsmpl.mode == SIMPLICITI_PHASE_CLOCK)
 	{
-		//display_symbol(LCD_ICON_BEEPER1, SEG_ON_BLINK_ON);
-		// Wait for next sample
-		display_symbol(LCD_ICON_RECORD, SEG_ON);
-		Timer0_A4_Delay(CONV_MS_TO_TICKS(60));	
-		// Read from sensor if DRDY pin indicates new data (set in PORT2 ISR)
-		if (request.flag.acceleration_measurement && ((AS_INT_IN & AS_INT_PIN) == AS_INT_PIN))
-		{
-			// Clear flag
-			request.flag.acceleration_measurement = 0;
-			
-			// Get data from sensor
-			as_get_data(sAccel.xyz);
-			
-			// push messured data onto the stack
-			if (sPhase.data_nr > SLEEP_DATA_BUFFER-1) {
-				phase_clock_calcpoint();
-				display_symbol(LCD_ICON_BEEPER1, SEG_OFF);
-				display_symbol(LCD_ICON_BEEPER2, SEG_OFF);
-				display_symbol(LCD_ICON_BEEPER3, SEG_OFF);
-
-			} else {
-				// copy current value onto the stack
-				//memcpy(&sPhase.data[sPhase.data_nr][0], &sAccel.xyz, sizeof(u8)*3);
-				sPhase.data[sPhase.data_nr][0] = sAccel.xyz[0];
-				sPhase.data[sPhase.data_nr][1] = sAccel.xyz[1];
-				sPhase.data[sPhase.data_nr][2] = sAccel.xyz[2];
-				//simpliciti_data[3] = sAccel.xyz[2];
-				sPhase.data_nr++;
-			}
-//str = itoa(accel_data, 3, 0);
-
-			if ((sPhase.out_nr > SLEEP_OUT_BUFFER-1))
-			{
-				// Reset counter
-				sPhase.out_nr = 0;
-				res = 0;
-
-				for(i=0; i < SLEEP_OUT_BUFFER; i++) {
-					//if (((2**17)-1))
-					// FIXME: overflow detection ?
-					res += sPhase.out[i];
-				}
-				packet_counter = (packet_counter+1)%SLEEP_MAX_PACKET_COUNTER;
-				simpliciti_data[3] =  (sPhase.session << (8-SLEEP_RF_ID_BIT_LENGHT)) | packet_counter;
-				simpliciti_data[2] =  res  & 0xFF;
-				simpliciti_data[1] =  (res >> 8) & 0xFF;
-				simpliciti_data[0] = SIMPLICITI_PHASE_CLOCK_EVENTS;
-
-				simpliciti_payload_length = 4;
-
-				display_symbol(LCD_ICON_BEEPER1, SEG_ON_BLINK_ON);
-				display_symbol(LCD_ICON_BEEPER2, SEG_ON_BLINK_ON);
-				display_symbol(LCD_ICON_BEEPER3, SEG_ON_BLINK_ON);
-
-                open_radio();
-                
-				simpliciti_flag |= SIMPLICITI_TRIGGER_SEND_DATA;
-			} else if (sPhase.out_nr == 0) {
-                // shutoff radio. no need to let it run for so long
-                close_radio();
-            }
-
-
-            sRFsmpl.timeout = SIMPLICITI_TIMEOUT; 
-
-		}
+		// Upload recorded epochs back-to-back, then quit
+		packet_counter = 0;
+		Timer0_A4_Delay(CONV_MS_TO_TICKS(SLEEP_BATCH_GAP));
+		simpliciti_payload_length = phase_clock_batch(simpliciti_data);
+		if (simpliciti_payload_length > 0)	simpliciti_flag |= SIMPLICITI_TRIGGER_SEND_DATA;
+		else								simpliciti_flag |= SIMPLICITI_TRIGGER_STOP;
     }
 #endif
 	if (sRFsmpl.mode == SIMPLICITI_BUTTONS) // transmit only button events
@@ -566,9 +627,85 @@ WDTCTL = WDTPW + WDTHOLD;
 		display.flag.update_time = 0;
 
 		// Service watchdog
-		WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+	}
+}
+
+#ifdef CONFIG_ACCEL_STREAM
+// *************************************************************************************************
+// @fn          accel_stream_add
+// @brief       Add a sample to the acceleration stream. Every ACCEL_STREAM_SAMPLES samples a packet 
+//				is assembled and sending is triggered.
+// @param       u8 * xyz		X/Y/Z raw data
+// @return      none
+// *************************************************************************************************
+static void accel_stream_add(u8 * xyz)
+{
+	accel_stream_xyz[accel_stream_count][0] = xyz[0];
+	accel_stream_xyz[accel_stream_count][1] = xyz[1];
+	accel_stream_xyz[accel_stream_count][2] = xyz[2];
+	
+	if (++accel_stream_count == ACCEL_STREAM_SAMPLES) accel_stream_pack();
+}
+
+
+// *************************************************************************************************
+// @fn          accel_stream_pack
+// @brief       Assemble stream packet from the collected samples: first sample absolute, then the 
+//				deltas with the smallest width (4, 6 or 8 bits) that fits all of them.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void accel_stream_pack(void)
+{
+	u8 i, j, width = 4, bits = 0, pos = ACCEL_STREAM_HEADER;
+	u16 acc = 0;
+	s8 delta;
+	
+	// Find delta width
+	for (i=1; i<accel_stream_count; i++)
+	{
+		for (j=0; j<3; j++)
+		{
+			delta = (s8)(accel_stream_xyz[i][j] - accel_stream_xyz[i-1][j]);
+			if (delta < -32 || delta > 31) 					width = 8;
+			else if ((delta < -8 || delta > 7) && width < 6) 	width = 6;
+		}
 	}
+	
+	// Header and first sample, keep button flags in byte 0
+	simpliciti_data[1] = accel_stream_seq++;
+	simpliciti_data[2] = accel_stream_count;
+	if (width == 6) 		simpliciti_data[2] |= ACCEL_STREAM_WIDTH_6;
+	else if (width == 8) 	simpliciti_data[2] |= ACCEL_STREAM_WIDTH_8;
+	simpliciti_data[3] = accel_stream_xyz[0][0];
+	simpliciti_data[4] = accel_stream_xyz[0][1];
+	simpliciti_data[5] = accel_stream_xyz[0][2];
+	
+	// Pack deltas MSB first
+	for (i=1; i<accel_stream_count; i++)
+	{
+		for (j=0; j<3; j++)
+		{
+			acc   = (acc << width) | ((u8)(accel_stream_xyz[i][j] - accel_stream_xyz[i-1][j]) & ((1 << width) - 1));
+			bits += width;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				simpliciti_data[pos++] = acc >> bits;
+			}
+		}
+	}
+	if (bits > 0) simpliciti_data[pos++] = acc << (8 - bits);
+	
+	simpliciti_payload_length = pos;
+	accel_stream_count = 0;
+	
+	// Trigger packet sending
+	simpliciti_flag |= SIMPLICITI_TRIGGER_SEND_DATA;
 }
+#endif
+
 
 // *************************************************************************************************
 // @fn          simpliciti_get_rvc_callback
@@ -589,7 +726,6 @@ int simpliciti_get_rvc_callback(u8 len)
             simpliciti_data[0] = 0x00;
             simpliciti_data[1] = 0x00;
             simpliciti_data[2] = 0x00;
-            as_start();
             return 1;
 #endif
     }
@@ -615,9 +751,8 @@ void start_simpliciti_sync(void)
 	#endif
 
 	// Get updated altitude
-#ifdef CONFIG_ALTITUTDE
-	start_altitude_measurement();
-	stop_altitude_measurement();	
+#ifdef CONFIG_ALTITUDE
+	single_altitude_measurement();
 #endif
 #ifdef CONFIG_TEMP
 	// Get updated temperature	
@@ -684,6 +819,7 @@ void simpliciti_sync_decode_ap_cmd_callback(void)
 	
 	// Default behaviour is to send no reply packets
 	simpliciti_reply_count = 0;
+	simpliciti_bulk_packets = 0;
 	
 	switch (simpliciti_data[0])
 	{
@@ -697,9 +833,7 @@ void simpliciti_sync_decode_ap_cmd_callback(void)
 
 		case SYNC_AP_CMD_SET_WATCH:		// Set watch parameters
 										sys.flag.use_metric_units = (simpliciti_data[1] >> 7) & 0x01;
-										sTime.hour 			= simpliciti_data[1] & 0x7F;
-										sTime.minute 		= simpliciti_data[2];
-										sTime.second 		= simpliciti_data[3];
+										Rtc_SetTime(simpliciti_data[1] & 0x7F, simpliciti_data[2], simpliciti_data[3]);
 										sDate.year 			= (simpliciti_data[4]<<8) + simpliciti_data[5];
 										sDate.month 		= simpliciti_data[6];
 										sDate.day 			= simpliciti_data[7];
@@ -753,13 +887,45 @@ void simpliciti_sync_decode_ap_cmd_callback(void)
 										// Number of packets to send
 										simpliciti_reply_count = BM_SYNC_BURST_PACKETS_IN_DATA;
 										break;
+
+		case SYNC_AP_CMD_GET_MEMORY_BULK:	
+										// Send sequential packets out in windowed frames
+										simpliciti_data[0]  = SYNC_ED_TYPE_MEMORY_BULK;
+										// Get start and end packet
+										burst_start = (simpliciti_data[1]<<8)+simpliciti_data[2];
+										burst_end   = (simpliciti_data[3]<<8)+simpliciti_data[4];
+										// Set burst mode
+										burst_mode = 3;
+										// Number of frames to send
+										if (burst_end > burst_start)
+										{
+											simpliciti_bulk_packets = (burst_end - burst_start + BM_SYNC_BULK_LOG_PACKETS - 1) / BM_SYNC_BULK_LOG_PACKETS;
+										}
+										break;
 		
 		case SYNC_AP_CMD_ERASE_MEMORY:	// Erase data logger memory
+#ifdef CONFIG_DATALOG
+										datalog_erase();
+#endif
 										break;
 										
 		case SYNC_AP_CMD_EXIT:			// Exit sync mode
 										simpliciti_flag |= SIMPLICITI_TRIGGER_STOP;
 										break;										
+#ifdef CONFIG_ENERGY_STATS
+		case SYNC_AP_CMD_GET_ENERGY:	// Send energy counters
+										simpliciti_data[0]  = SYNC_ED_TYPE_ENERGY;
+										// Send one packet per ENERGY_SYNC_SLOTS_PER_PACKET slots
+										simpliciti_reply_count = ENERGY_SYNC_PACKETS;
+										break;
+#endif
+#ifdef CONFIG_PEDOMETER
+		case SYNC_AP_CMD_GET_STEPS:		// Send steps and activity per hour of the day
+										simpliciti_data[0]  = SYNC_ED_TYPE_STEPS;
+										// Send one packet per PEDOMETER_SYNC_HOURS_PER_PACKET hours
+										simpliciti_reply_count = PEDOMETER_SYNC_PACKETS;
+										break;
+#endif
 	}
 	
 }
@@ -774,11 +940,19 @@ void simpliciti_sync_decode_ap_cmd_callback(void)
 void simpliciti_sync_get_data_callback(unsigned int index)
 {
 	u8 i;
+#ifdef CONFIG_ENERGY_STATS
+	u8 slot;
+	u32 value;
+#endif
+#ifdef CONFIG_DATALOG
+	u16 packets;
+#endif
 	
 	// simpliciti_data[0] contains data type and needs to be returned to AP
 	switch (simpliciti_data[0])
 	{
 		case SYNC_ED_TYPE_STATUS:		// Assemble status packet
+										Rtc_Sync();
 										simpliciti_data[1]  = (sys.flag.use_metric_units << 7) | (sTime.hour & 0x7F);
 										simpliciti_data[2]  = sTime.minute;
 										simpliciti_data[3]  = sTime.second;
@@ -804,6 +978,16 @@ void simpliciti_sync_get_data_callback(unsigned int index)
 										simpliciti_data[12] = sAlt.altitude >> 8;
 										simpliciti_data[13] = sAlt.altitude & 0xFF;
 #endif
+#ifdef CONFIG_DATALOG
+										// Number of data logger packets
+										packets = datalog_packets();
+										simpliciti_data[14] = packets >> 8;
+										simpliciti_data[15] = packets & 0xFF;
+#endif
+										// Link statistics
+										simpliciti_data[16] = (sRFlink.level << 6) | sRFlink.misses;
+										simpliciti_data[17] = sRFlink.rssi;
+										simpliciti_data[18] = sRFlink.lqi;
 										break;
 										
 		case SYNC_ED_TYPE_MEMORY:		
@@ -812,17 +996,239 @@ void simpliciti_sync_get_data_callback(unsigned int index)
 											// Set burst packet address
 											simpliciti_data[1] = ((burst_start + index) >> 8) & 0xFF;
 											simpliciti_data[2] = (burst_start + index) & 0xFF;
-											// Assemble payload
-											for (i=3; i<BM_SYNC_DATA_LENGTH; i++) simpliciti_data[i] = index;
 										} 
 										else if (burst_mode == 2)
 										{
 											// Set burst packet address
 											simpliciti_data[1] = (burst_packet[index] >> 8) & 0xFF;
 											simpliciti_data[2] = burst_packet[index] & 0xFF;
-											// Assemble payload
-											for (i=3; i<BM_SYNC_DATA_LENGTH; i++) simpliciti_data[i] = index;
 										}
+										// Assemble payload
+#ifdef CONFIG_DATALOG
+										datalog_read_packet((simpliciti_data[1] << 8) + simpliciti_data[2], &simpliciti_data[3]);
+#else
+										for (i=3; i<BM_SYNC_DATA_LENGTH; i++) simpliciti_data[i] = index;
+#endif
+										break;
+
+		case SYNC_ED_TYPE_MEMORY_BULK:	// (1) frame sequence (2..) BM_SYNC_BULK_LOG_PACKETS log packets, the host drops packets past burst_end
+										simpliciti_data[1] = index & BM_SYNC_BULK_SEQ_MASK;
+#ifdef CONFIG_DATALOG
+										for (i=0; i<BM_SYNC_BULK_LOG_PACKETS; i++)
+										{
+											datalog_read_packet(burst_start + index * BM_SYNC_BULK_LOG_PACKETS + i, &simpliciti_data[BM_SYNC_BULK_HEADER_LENGTH + i * BM_SYNC_BULK_PACKET_SIZE]);
+										}
+#else
+										for (i=BM_SYNC_BULK_HEADER_LENGTH; i<BM_SYNC_BULK_DATA_LENGTH; i++) simpliciti_data[i] = index;
+#endif
+										break;
+#ifdef CONFIG_ENERGY_STATS
+		case SYNC_ED_TYPE_ENERGY:		// (1) first slot (2) number of slots (3..6) uptime in sec 
+										// (7..18) 3 slots in 1/32768 sec, all values MSB first
+										slot = index * ENERGY_SYNC_SLOTS_PER_PACKET;
+										simpliciti_data[1]  = slot;
+										simpliciti_data[2]  = ENERGY_SLOTS;
+										// Counters are updated by ISRs
+										__disable_interrupt();
+										for (i=3; i<BM_SYNC_DATA_LENGTH; i+=4)
+										{
+											if (i == 3)						value = sEnergy.uptime;
+											else if (slot < ENERGY_SLOTS)	value = sEnergy.ticks[slot++];
+											else							value = 0;
+											simpliciti_data[i]   = (value >> 24) & 0xFF;
+											simpliciti_data[i+1] = (value >> 16) & 0xFF;
+											simpliciti_data[i+2] = (value >> 8) & 0xFF;
+											simpliciti_data[i+3] = value & 0xFF;
+										}
+										__enable_interrupt();
+										break;
+#endif
+#ifdef CONFIG_PEDOMETER
+		case SYNC_ED_TYPE_STEPS:		// (1) first hour (2) current hour (3..18) steps and activity
+										// of 4 hours, all values MSB first
+										pedometer_sync_packet(index, simpliciti_data);
 										break;
+#endif
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_link_quality_callback
+// @brief       Track the link and choose the output power. Starts at full power, steps down while
+//				frames from the access point arrive with a comfortable margin and back up when the
+//				margin shrinks, when a reply is missing or when the access point stays silent.
+// @param       u8 event		SIMPLICITI_LINK_START, _FRAME, _MISS, _IDLE
+//				s8 rssi			RSSI of the received frame (dBm), SIMPLICITI_LINK_FRAME only
+//				u8 lqi			LQI and CRC_OK bit of the received frame, SIMPLICITI_LINK_FRAME only
+// @return      u8				Output power level to use
+// *************************************************************************************************
+unsigned char simpliciti_link_quality_callback(unsigned char event, signed char rssi, unsigned char lqi)
+{
+	s16 uplink;
+	
+	switch (event)
+	{
+		case SIMPLICITI_LINK_START:	memset(&sRFlink, 0, sizeof(sRFlink));
+									sRFlink.level = SIMPLICITI_TX_LEVELS - 1;
+									break;
+		
+		case SIMPLICITI_LINK_FRAME:	sRFlink.rssi = rssi;
+									sRFlink.lqi  = lqi & 0x7F;
+									sRFlink.idle = 0;
+									
+									// Estimated RSSI of our frames at the access point
+									uplink = rssi - (link_level_dbm[SIMPLICITI_TX_LEVELS - 1] - link_level_dbm[sRFlink.level]);
+									if (uplink < LINK_RSSI_TARGET || sRFlink.lqi > LINK_LQI_WEAK)
+									{
+										if (sRFlink.level < SIMPLICITI_TX_LEVELS - 1) sRFlink.level++;
+										sRFlink.good = 0;
+									}
+									else if (sRFlink.level > 0 && uplink - (link_level_dbm[sRFlink.level] - 
+											 link_level_dbm[sRFlink.level - 1]) >= LINK_RSSI_TARGET + LINK_RSSI_HYST)
+									{
+										if (++sRFlink.good >= LINK_GOOD_FRAMES)
+										{
+											sRFlink.level--;
+											sRFlink.good = 0;
+										}
+									}
+									else
+									{
+										sRFlink.good = 0;
+									}
+									break;
+		
+		case SIMPLICITI_LINK_MISS:	// Estimate was wrong - back to full power
+									if (sRFlink.misses < LINK_MISSES_MAX) sRFlink.misses++;
+									sRFlink.level = SIMPLICITI_TX_LEVELS - 1;
+									sRFlink.good  = 0;
+#ifdef CONFIG_FREQ_AGILITY
+									// The request will be repeated
+									if (sRFchan.cost[0] != 0) channel_charge(sRFchan.chan, CHAN_COST_FRAME);
+#endif
+									break;
+		
+		case SIMPLICITI_LINK_IDLE:	if (++sRFlink.idle >= LINK_IDLE_PACKETS)
+									{
+										if (sRFlink.level < SIMPLICITI_TX_LEVELS - 1) sRFlink.level++;
+										sRFlink.idle = 0;
+									}
+									break;
+	}
+	
+	return (sRFlink.level);
+}
+
+
+#ifdef CONFIG_FREQ_AGILITY
+// *************************************************************************************************
+// @fn          channel_charge
+// @brief       Add the cost of one frame to the average of a channel.
+// @param       u8 chan			Logical channel
+//				u8 cost			Cost of the frame, CHAN_COST_FRAME for a frame that went out at once
+// @return      none
+// *************************************************************************************************
+static void channel_charge(u8 chan, u8 cost)
+{
+	sRFchan.cost[chan] = sRFchan.cost[chan] - (sRFchan.cost[chan] >> 3) + cost;
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_channel_callback
+// @brief       Keep the cost of a frame per channel and choose the channel for the link. Every
+//				CHAN_DECIDE_FRAMES frames the link is asked to move when the current channel has become
+//				expensive and another one promises to be cheaper. When the link is still on the old
+//				channel at the next decision the access point did not follow, the channel asked for
+//				then counts as busy.
+// @param       u8 chan			Logical channel of the frame just sent
+//				u8 cca_fails	Failed clear channel assessments, SIMPLICITI_CCA_ATTEMPTS = not sent
+//				s8 rssi			RSSI of the last failed assessment (dBm)
+// @return      u8				Logical channel for the link
+// *************************************************************************************************
+unsigned char simpliciti_channel_callback(unsigned char chan, unsigned char cca_fails, signed char rssi)
+{
+	u8 i, best, cost;
+
+	if (chan >= SIMPLICITI_CHANNELS) return (chan);
+
+	// First frame since reset - nothing known, all channels count as clean
+	if (sRFchan.cost[0] == 0)
+	{
+		for (i = 0; i < SIMPLICITI_CHANNELS; i++)
+		{
+			sRFchan.cost[i] = CHAN_COST_CLEAN;
+			sRFchan.rssi[i] = -128;
+		}
+		sRFchan.asked = CHAN_NONE;
+	}
+
+	cost = CHAN_COST_FRAME + cca_fails * CHAN_COST_CCA;
+	if (cca_fails >= SIMPLICITI_CCA_ATTEMPTS) cost += CHAN_COST_FRAME;
+	if (cca_fails > 0) sRFchan.rssi[chan] = rssi;
+	channel_charge(chan, cost);
+	sRFchan.chan = chan;
+
+	if (++sRFchan.frames < CHAN_DECIDE_FRAMES) return (chan);
+	sRFchan.frames = 0;
+
+	// Move asked for at the last decision did not happen
+	if (sRFchan.asked != CHAN_NONE && sRFchan.asked != chan) sRFchan.cost[sRFchan.asked] = CHAN_COST_MOVE + CHAN_COST_HYST;
+	sRFchan.asked = CHAN_NONE;
+
+	// Cheapest other channel, the one with the weaker interferer if equal. Forget slowly.
+	best = chan;
+	for (i = 0; i < SIMPLICITI_CHANNELS; i++)
+	{
+		if (i == chan) continue;
+		if (sRFchan.cost[i] > CHAN_COST_CLEAN) sRFchan.cost[i] -= (sRFchan.cost[i] - CHAN_COST_CLEAN) >> 3;
+		if (best == chan || sRFchan.cost[i] < sRFchan.cost[best] ||
+			(sRFchan.cost[i] == sRFchan.cost[best] && sRFchan.rssi[i] < sRFchan.rssi[best])) best = i;
 	}
+
+	if (sRFchan.cost[chan] <= CHAN_COST_MOVE || sRFchan.cost[best] + CHAN_COST_HYST > sRFchan.cost[chan]) return (chan);
+	sRFchan.asked = best;
+	return (best);
 }
+#endif
+
+
+#ifdef CONFIG_LINK_CACHE
+// *************************************************************************************************
+// @fn          simpliciti_link_cache_load
+// @brief       Read the join context of the last link from information memory.
+// @param       u8 * data		Destination
+//				u8 len			Size of the context in bytes
+// @return      u8				1 = Context read, 0 = None saved or saved with another size
+// *************************************************************************************************
+unsigned char simpliciti_link_cache_load(unsigned char * data, unsigned char len)
+{
+	u16 buf[SIMPLICITI_LINK_CACHE_WORDS];
+	u8 words = (len + 1) / 2;
+	
+	if (words > SIMPLICITI_LINK_CACHE_WORDS || infomem_app_amount(SIMPLICITI_INFOMEM_ID) != words) return (0);
+	if (infomem_app_read(SIMPLICITI_INFOMEM_ID, buf, words, 0) != words) return (0);
+	memcpy(data, buf, len);
+	return (1);
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_link_cache_store
+// @brief       Save the join context of a new link in information memory.
+// @param       u8 * data		Context
+//				u8 len			Size of the context in bytes
+// @return      none
+// *************************************************************************************************
+void simpliciti_link_cache_store(unsigned char * data, unsigned char len)
+{
+	u16 buf[SIMPLICITI_LINK_CACHE_WORDS];
+	u8 words = (len + 1) / 2;
+	
+	if (words == 0 || words > SIMPLICITI_LINK_CACHE_WORDS) return;
+	buf[words - 1] = 0;
+	memcpy(buf, data, len);
+	infomem_app_replace(SIMPLICITI_INFOMEM_ID, buf, words);
+}
+#endif
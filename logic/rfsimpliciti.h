@@ -83,10 +83,31 @@ typedef enum
 #define SIMPLICITI_KEY_EVENTS               (0x02)
 #define SIMPLICITI_PHASE_CLOCK_EVENTS   	(0x03)
 #define SIMPLICITI_PHASE_CLOCK_START_EVENTS	(0x04)
+#define SIMPLICITI_ACCEL_STREAM_EVENTS		(0x05)
+#define SIMPLICITI_PHASE_CLOCK_BATCH_EVENTS	(0x06)
+
+// Packed acceleration stream (CONFIG_ACCEL_STREAM)
+// (0) button flags | SIMPLICITI_ACCEL_STREAM_EVENTS  (1) sequence  (2) bits 7..6 delta width code, 
+// bits 3..0 number of samples (0 = button event only)  (3..5) first sample X/Y/Z  (6..) deltas to the 
+// previous sample, X/Y/Z per sample, two's complement, MSB first, last byte padded with 0 bits
+// Up to 15 samples (4 bit count), as many as fit into MAX_APP_PAYLOAD with 8 bit deltas: 15 samples
+// take 48 bytes, with SMPL_SECURE (47 byte payload) 14 samples fit.
+#define ACCEL_STREAM_HEADER					(6u)
+#define ACCEL_STREAM_FIT					((MAX_APP_PAYLOAD - ACCEL_STREAM_HEADER) / 3u + 1u)
+#define ACCEL_STREAM_SAMPLES				((ACCEL_STREAM_FIT > 15u) ? 15u : ACCEL_STREAM_FIT)
+#define ACCEL_STREAM_WIDTH_4				(0x00)
+#define ACCEL_STREAM_WIDTH_6				(0x40)
+#define ACCEL_STREAM_WIDTH_8				(0x80)
+#define ACCEL_STREAM_WIDTH_MASK				(0xC0)
+#define ACCEL_STREAM_COUNT_MASK				(0x0F)
 
 // notify the ap that sync mode started
 #define SIMPLICITI_SYNC_STARTED_EVENTS      (0x10)
 
+// Information memory id and size (words) of the link cache
+#define SIMPLICITI_INFOMEM_ID				(0x11)
+#define SIMPLICITI_LINK_CACHE_WORDS			(12u)
+
 
 #define WATCH_ID(dst,offset) \
 		dst[offset] = simpliciti_ed_address[0] ^ simpliciti_ed_address[1];\
@@ -108,6 +129,27 @@ struct RFsmpl
 };
 extern struct RFsmpl sRFsmpl;
 
+// Link quality and output power of the current SimpliciTI session
+struct RFlink
+{
+	// Output power level, 0 .. SIMPLICITI_TX_LEVELS-1
+	u8		level;
+	
+	// Frames in a row with enough margin for the next lower level
+	u8		good;
+	
+	// Ready-to-receive packets without reply since the last frame
+	u8		idle;
+	
+	// Expected replies that did not arrive
+	u8		misses;
+	
+	// RSSI (dBm) and LQI (lower is better) of the last frame from the access point
+	s8		rssi;
+	u8		lqi;
+};
+extern struct RFlink sRFlink;
+
 extern unsigned char simpliciti_flag;
 
 // *************************************************************************************************
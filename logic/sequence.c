@@ -59,6 +59,9 @@ u8 sequence_compare(u8* sequence_a, u8* sequence_b);
 volatile u8 doorlock_sequence_pause = 0;
 volatile u8 doorlock_sequence_timeout = 0;
 
+// Sequence timeout and pause timer
+static struct sw_timer doorlock_timer;
+
 // *************************************************************************************************
 // @fn          doorlock_sequence
 // @brief       collects door unlock code sequence using accelerometer
@@ -73,6 +76,7 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 	u8 length = 0;
 	u8 max = 0;
 	u8 raw = 0;
+	u8 xyz[3];
 	u8 i = 0;
 	float ratio = 0.0f;
 
@@ -87,9 +91,10 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 	//as_start(AS_MODE_2G_400HZ);
 	as_start();
 
-	fptr_Timer0_A1_function = doorlock_sequence_timer;
-	Timer0_A1_Start(32768u);
-	//Timer0_A1_Start();
+	// tap detection needs every single sample
+	as_set_block(1);
+
+	sw_timer_start(&doorlock_timer, 32768u, 32768u, doorlock_sequence_timer);
 
 
 	for(;;)
@@ -101,7 +106,8 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 			// Enable button interrupts
 		BUTTONS_IE &= ~ALL_BUTTONS;
 
-		idle_loop();
+		// sleep unless samples are still queued
+		if (!as_samples_available()) idle_loop();
 
 
 
@@ -119,16 +125,16 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 		// were we interrupted because pause is too long?
 		if (doorlock_sequence_pause <= DOORLOCK_SEQUENCE_PAUSE_MAX_LENGTH)
 		{
-			// look for accelerometer data ready event
-			if (!request.flag.acceleration_measurement)
+			request.flag.acceleration_measurement = 0;
+
+			// look for accelerometer sample
+			if (!as_pop_sample(xyz))
 			{
 				continue;
 			}
 
-			request.flag.acceleration_measurement = 0;
-
-			// read accelerometer z-a
-			raw = as_get_z();
+			// use accelerometer z-axis
+			raw = xyz[2];
 			delta = raw - previous_raw;
 			ddelta = delta - previous_delta;
 			previous_raw = raw;
@@ -141,7 +147,7 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 				continue;
 			}
 
-			Timer0_A1_Stop();
+			sw_timer_stop(&doorlock_timer);
 
 			// first tap?
 			if (length == 0)
@@ -161,8 +167,7 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 				display_symbol(LCD_ICON_RECORD, SEG_OFF);
 
 				// start pause timer
-				fptr_Timer0_A1_function = doorlock_sequence_pause_timer;
-				Timer0_A1_Start(DOORLOCK_SEQUENCE_PAUSE_RESOLUTION);
+				sw_timer_start(&doorlock_timer, DOORLOCK_SEQUENCE_PAUSE_RESOLUTION, DOORLOCK_SEQUENCE_PAUSE_RESOLUTION, doorlock_sequence_pause_timer);
 				continue;
 			}
 
@@ -191,8 +196,7 @@ u8 doorlock_sequence(u8 sequence[DOORLOCK_SEQUENCE_MAX_LENGTH])
 			if (length <= DOORLOCK_SEQUENCE_MAX_LENGTH)
 			{
 				// start pause timer
-				fptr_Timer0_A1_function = doorlock_sequence_pause_timer;
-				Timer0_A1_Start(DOORLOCK_SEQUENCE_PAUSE_RESOLUTION);
+				sw_timer_start(&doorlock_timer, DOORLOCK_SEQUENCE_PAUSE_RESOLUTION, DOORLOCK_SEQUENCE_PAUSE_RESOLUTION, doorlock_sequence_pause_timer);
 				continue;
 			}
 
@@ -252,7 +256,7 @@ void doorlock_sequence_timer(void)
 	}
 	else
 	{
-		Timer0_A1_Stop();
+		sw_timer_stop(&doorlock_timer);
 	}
 }
 
@@ -267,7 +271,7 @@ void doorlock_sequence_pause_timer(void)
 	if (doorlock_sequence_pause > DOORLOCK_SEQUENCE_PAUSE_MAX_LENGTH)
     {
             // stop timer
-            Timer0_A1_Stop();
+            sw_timer_stop(&doorlock_timer);
     }
     else
     {
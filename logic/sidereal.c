@@ -70,6 +70,7 @@
 // Prototypes section
 void reset_sidereal_clock(void);
 void clock_sidereal_tick(void);
+void sidereal_timer_function(void);
 void mx_time(u8 line);
 void sx_time(u8 line);
 
@@ -77,6 +78,10 @@ void sx_time(u8 line);
 // *************************************************************************************************
 // Defines section
 
+// One sidereal second is 32768/1.00273790935=32678.529149 ACLK ticks, alternate between 32678 and 32679
+// ticks. This gives a deviation of ~0.9e-7~0.1s/day which is likely less than the oscillator deviation
+#define SIDEREAL_SECOND_TICKS		(32678u)
+
 // for details on used formulas see
 // http://www.usno.navy.mil/USNO/astronomical-applications/astronomical-information-center/approx-sider-time
 
@@ -117,6 +122,9 @@ const unsigned long rational[][2]={ {440501801,31055},{50828929,78494},{16958560
 // Global Variable section
 struct sidereal_time sSidereal_time;
 
+// Sidereal second timer
+static struct sw_timer sidereal_timer;
+
 
 // *************************************************************************************************
 // Extern section
@@ -206,8 +214,8 @@ void sync_sidereal(void)
 		sidtime -=86400;
 	}
 	
-	// Disable interrupts to prevent race conditions
-	Timer0_A1_Stop();
+	// Stop sidereal second timer to prevent race conditions
+	sw_timer_stop(&sidereal_timer);
 	// Set sidereal 24H time to calculated value
 	sSidereal_time.hour   = sidtime/3600;
 	sidtime %=3600;
@@ -215,7 +223,7 @@ void sync_sidereal(void)
 	sidtime %=60;
 	sSidereal_time.second = sidtime;
 	// Set clock timer for one sidereal second in the future
-	Timer0_A1_Start();
+	sw_timer_start(&sidereal_timer, SIDEREAL_SECOND_TICKS, SIDEREAL_SECOND_TICKS, sidereal_timer_function);
 	
 	//sync=1: automatically sync only one time
 	if (sSidereal_time.sync==1)
@@ -273,6 +281,25 @@ void reset_sidereal_clock(void)
 }
 
 
+// *************************************************************************************************
+// @fn          sidereal_timer_function
+// @brief       Called by the software timer service once per sidereal second.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void sidereal_timer_function(void)
+{
+	// Length of the following second, alternate between 32678 and 32679 ticks
+	sidereal_timer.period = SIDEREAL_SECOND_TICKS + ((sSidereal_time.second & 1) ^ 1);
+	
+	// Add 1 second to global time
+	sidereal_clock_tick();
+	
+	// Set clock update flag
+	display.flag.update_sidereal_time = 1;
+}
+
+
 // *************************************************************************************************
 // @fn          sidereal_clock_tick
 // @brief       Add 1 second to display sidereal time
@@ -507,8 +534,8 @@ void mx_sidereal(u8 line)
 			}
 			else
 			{
-				// Disable interrupts to prevent race conditions
-				Timer0_A1_Stop();
+				// Stop sidereal second timer to prevent race conditions
+				sw_timer_stop(&sidereal_timer);
 
 				// Store local variables in global sidereal clock time
 				sSidereal_time.hour   = hours;
@@ -516,7 +543,7 @@ void mx_sidereal(u8 line)
 				sSidereal_time.second = seconds;
 
 				// Set clock timer for one sidereal second in the future
-				Timer0_A1_Start();
+				sw_timer_start(&sidereal_timer, SIDEREAL_SECOND_TICKS, SIDEREAL_SECOND_TICKS, sidereal_timer_function);
 			}
 			
 			// Full display update is done when returning from function
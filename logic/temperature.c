@@ -50,6 +50,7 @@
 #include "display.h"
 #include "adc12.h"
 #include "timer.h"
+#include "dsp.h"
 
 // logic
 #include "user.h"
@@ -120,8 +121,7 @@ void temperature_measurement(u8 filter)
 	if (filter == FILTER_ON)
 	{
 		// Change temperature in 0.1 steps towards measured value
-		if (temperature > sTemp.degrees)		sTemp.degrees += 1;
-		else if (temperature < sTemp.degrees)	sTemp.degrees -= 1;
+		sTemp.degrees = step_filter(sTemp.degrees, temperature, 1);
 	}
 	else
 	{
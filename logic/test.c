@@ -182,7 +182,7 @@ void test_mode(void)
 								for (i=0; i<4; i++)
 								{
 									Timer0_A4_Delay(CONV_MS_TO_TICKS(250));
-									as_get_data(sAccel.xyz);
+									while (as_pop_sample(sAccel.xyz));
 									str = itoa( sAccel.xyz[0], 3, 0);
 									display_chars(LCD_SEG_L1_2_0, str, SEG_ON);
 									str = itoa( sAccel.xyz[2], 3, 0);
@@ -256,8 +256,8 @@ void test_mode(void)
 				}
 				
 #ifdef USE_WATCHDOG		
-				// Service watchdog
-				WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+				// Service watchdog - only buttons and the RTC minute event end LPM3
+				WDTCTL = WDTPW + WDT_SLEEP_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
 #endif
 				// To LPM3
 				_BIS_SR(LPM3_bits + GIE);  
@@ -278,7 +278,7 @@ void test_mode(void)
 
 void display_all_on(void)
 {
-	u8 * lcdptr = (u8*)0x0A20;
+	u8 * lcdptr = LCD_MEM_1;
 	u8 i;
 	
 	for (i=1; i<=12; i++) 
@@ -60,6 +60,11 @@
 // driver
 #include "display.h"
 #include "buzzer.h"
+#include "dsp.h"
+#ifdef CONFIG_ALTI_KALMAN
+#include "vti_as.h"
+#include "vti_ps.h"
+#endif
 
 // logic
 #include "altitude.h"
@@ -84,6 +89,9 @@ struct
    u8 p_valid;    // mutex for pressure field
    u8 view_mode;  // view mode, controlled by "v" key
    u8 beep_mode;  // beeper mode, controlled by "#" key
+#ifdef CONFIG_ALTI_KALMAN
+   u8 as_owner;   // acceleration sensor started by the vario
+#endif
    struct
      {
 #if VARIO_VZ
@@ -232,7 +240,7 @@ vario_p_write( u32 p )
 	// low power with external trigger mode), average in the new pressure
 	// value.
 	//
-	G_vario.pressure = (G_vario.pressure + p) >> 1;
+	G_vario.pressure = iir1_filter(G_vario.pressure, p, DSP_Q15(0.5));
      }
 }
 
@@ -365,6 +373,12 @@ display_vario( u8 line, u8 update )
       case DISPLAY_LINE_CLEAR:
 
 	stop_buzzer();
+#ifdef CONFIG_ALTI_KALMAN
+	// Stop acceleration sensor unless it was already running for someone else
+	if ( G_vario.as_owner ) as_stop();
+	G_vario.as_owner = 0;
+	ps_stop( PS_USER_VARIO );
+#endif
 	display_symbol( LCD_ICON_BEEPER1, SEG_OFF );
 	display_symbol( LCD_ICON_BEEPER2, SEG_OFF );
 	display_symbol( LCD_ICON_RECORD,  SEG_OFF );
@@ -380,6 +394,22 @@ display_vario( u8 line, u8 update )
 			(  ( G_vario.beep_mode == VARIO_BEEPMODE_ASCENT_0 )
 			|| ( G_vario.beep_mode == VARIO_BEEPMODE_BOTH ))
 			  ? SEG_ON : SEG_OFF );
+#ifdef CONFIG_ALTI_KALMAN
+	//
+	// Vertical acceleration keeps the altitude estimator current between
+	// pressure samples.
+	//
+	if ( !G_vario.as_owner && !( AS_INT_IE & AS_INT_PIN ) )
+	  {
+	     as_start();
+	     G_vario.as_owner = 1;
+	  }
+	//
+	// It also corrects with every pressure sample. While the altimeter
+	// samples, ask for the less noisy high resolution mode (1.8Hz).
+	//
+	ps_start( PS_USER_VARIO, PS_NEED_HIGH_RES );
+#endif
 	//
 	// fall through to partial update
 	//
@@ -443,7 +473,14 @@ display_vario( u8 line, u8 update )
 	     // buzzer. Pressure decreases with altitude, ensure going lower is
 	     // negative.
 	     // 
+#ifdef CONFIG_ALTI_KALMAN
+	     // The altitude estimator knows better, take its vertical speed in
+	     // the same 10cm/s units.
+	     //
+	     diff = sAlt.climb / 10;
+#else
 	     diff = G_vario.prev_pa - pressure;
+#endif
 
 #if VARIO_VZ
 	     // update stats as we may want to see these after the flight.
@@ -472,7 +509,11 @@ display_vario( u8 line, u8 update )
 	     //
 	     // convert the difference in Pa to a vertical velocity.
 	     //
+#ifdef CONFIG_ALTI_KALMAN
+	     _display_signed( sAlt.climb, 1 );
+#else
 	     _display_signed( _pascal_to_vz( diff ), 1 );
+#endif
 	     break;
 
 #if VARIO_ALT_PA
@@ -0,0 +1,410 @@
+// *************************************************************************************************
+// Host test of the LCD render path (driver/display.c, driver/display1.c).
+//
+// display_char, clear_line and write_lcd_mem are compared with the implementation they replaced:
+// one font table for LINE1 that is nibble-swapped at run time for LINE2, '-' as a special case,
+// separate clear and set writes per LCD byte and clear_line through blank characters and symbols.
+// That path is kept below as reference. Every segment, character and mode is rendered on random
+// LCD and blink memory, and whole lines with random strings are rendered and cleared. LCD memory
+// (LCDM1..) and blink memory (LCDBM1..) have to match the reference byte for byte.
+//
+// make sim-test; exit status 0 if all checks passed
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+#include "display.h"
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+volatile void * sim_io(unsigned short addr, unsigned char size);
+
+
+// *************************************************************************************************
+// Defines section
+
+// LCD memory and blink memory as written by the render path
+#define LCD_BYTES				(0x20u)
+#define LCD_MEM_ADDR			(0x0A20u)
+
+// Random LCD contents per segment / character / mode, random lines per line
+#define TEST_RUNS_CHAR			(4u)
+#define TEST_RUNS_LINE			(2000u)
+#define TEST_RUNS_WRITE			(20000u)
+#define TEST_MODES				(SEG_OFF_BLINK_OFF + 1u)
+#define TEST_SEED				(0x1CDu)
+
+
+// *************************************************************************************************
+// Global Variable section
+volatile unsigned char sim_mem[0x1000];
+void (*fptr_lcd_function_line1)(u8 line, u8 update);
+void (*fptr_lcd_function_line2)(u8 line, u8 update);
+
+static uint32_t lcg = TEST_SEED;
+static unsigned long failures;
+static unsigned long renders;
+
+// Reference font: digits "0" to "9" and characters "A" to "Z", LINE1 bit assignment
+static const u8 ref_font[] =
+{
+  SEG_A+SEG_B+SEG_C+SEG_D+SEG_E+SEG_F,           // Displays "0"
+        SEG_B+SEG_C,                             // Displays "1"
+  SEG_A+SEG_B+      SEG_D+SEG_E+      SEG_G,     // Displays "2"
+  SEG_A+SEG_B+SEG_C+SEG_D+            SEG_G,     // Displays "3"
+        SEG_B+SEG_C+            SEG_F+SEG_G,     // Displays "4"
+  SEG_A+      SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "5"
+  SEG_A+      SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "6"
+  SEG_A+SEG_B+SEG_C,                             // Displays "7"
+  SEG_A+SEG_B+SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "8"
+  SEG_A+SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "9"
+  0                                        ,     // Displays " " (:)
+  0                                        ,     // Displays " " (;)
+  SEG_A+                        SEG_F+SEG_G,     // Displays "<" as high c
+                    SEG_D+            SEG_G,     // Displays "="
+  0                                        ,     // Displays " " (>)
+  SEG_A+SEG_B+            SEG_E+      SEG_G,     // Displays "?"
+  0                                        ,     // Displays " " (@)
+  SEG_A+SEG_B+SEG_C+      SEG_E+SEG_F+SEG_G,     // Displays "A"
+              SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "b"
+                    SEG_D+SEG_E+      SEG_G,     // Displays "c"
+        SEG_B+SEG_C+SEG_D+SEG_E+      SEG_G,     // Displays "d"
+  SEG_A+           +SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "E"
+  SEG_A+                  SEG_E+SEG_F+SEG_G,     // Displays "f"
+  SEG_A+SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "g" same as 9
+              SEG_C+      SEG_E+SEG_F+SEG_G,     // Displays "h"
+                          SEG_E            ,     // Displays "i"
+  SEG_A+SEG_B+SEG_C+SEG_D                  ,     // Displays "J"
+                    SEG_D+      SEG_F+SEG_G,     // Displays "k"
+                    SEG_D+SEG_E+SEG_F      ,     // Displays "L"
+  SEG_A+SEG_B+SEG_C+      SEG_E+SEG_F      ,     // Displays "M"
+              SEG_C+      SEG_E+      SEG_G,     // Displays "n"
+              SEG_C+SEG_D+SEG_E+      SEG_G,     // Displays "o"
+  SEG_A+SEG_B+            SEG_E+SEG_F+SEG_G,     // Displays "P"
+  SEG_A+SEG_B+SEG_C+            SEG_F+SEG_G,     // Displays "q"
+                          SEG_E+      SEG_G,     // Displays "r"
+  SEG_A+      SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "S" same as 5
+                    SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "t"
+              SEG_C+SEG_D+SEG_E            ,     // Displays "u"
+              SEG_C+SEG_D+SEG_E            ,     // Displays "v" same as u
+        SEG_B+SEG_C+SEG_D+SEG_E+SEG_F+SEG_G,     // Displays "W"
+        SEG_B+SEG_C+     +SEG_E+SEG_F+SEG_G,     // Displays "X" as H
+        SEG_B+SEG_C+SEG_D+      SEG_F+SEG_G,     // Displays "Y"
+  SEG_A+SEG_B+      SEG_D+SEG_E+      SEG_G,     // Displays "Z" same as 2
+};
+
+
+// *************************************************************************************************
+// @fn          sim_io
+// @brief       Register access of display.c, plain backing store.
+// @param       unsigned short addr		Register address
+//				unsigned char size		Access width in bytes
+// @return      volatile void *			Register backing store
+// *************************************************************************************************
+volatile void * sim_io(unsigned short addr, unsigned char size)
+{
+	(void)size;
+	return &sim_mem[addr];
+}
+
+
+// *************************************************************************************************
+// @fn          test_rand
+// @brief       Deterministic pseudo random numbers, same sequence on every host.
+// @param       uint32_t range		Number of values (0 = full 32 bits)
+// @return      uint32_t			0 .. range-1
+// *************************************************************************************************
+static uint32_t test_rand(uint32_t range)
+{
+	uint32_t r;
+
+	lcg = lcg * 1103515245u + 12345u;
+	r = lcg >> 8;
+	lcg = lcg * 1103515245u + 12345u;
+	r = (r << 16) ^ (lcg >> 8);
+	return range ? r % range : r;
+}
+
+
+// *************************************************************************************************
+// @fn          test_fail
+// @brief       Report a failed check. The run goes on to report further failures.
+// @param       const char * fmt	printf style message
+// @return      none
+// *************************************************************************************************
+static void __attribute__((format(printf, 1, 2))) test_fail(const char * fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "display-test: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	failures++;
+}
+
+
+// *************************************************************************************************
+// @fn          ref_write_lcd_mem
+// @brief       Reference write_lcd_mem: clear, then set, each as its own write.
+// @param       lcdmem		Pointer to LCD byte memory
+//				bits		Segments to address
+//				bitmask		Bitmask for particular display item
+//				mode		On, off or blink segments
+// @return      none
+// *************************************************************************************************
+static void ref_write_lcd_mem(u8 * lcdmem, u8 bits, u8 bitmask, u8 state)
+{
+	if (state == SEG_ON)
+	{
+		*lcdmem = (u8)(*lcdmem & ~bitmask);
+		*lcdmem = (u8)(*lcdmem | bits);
+	}
+	else if (state == SEG_OFF)
+	{
+		*lcdmem = (u8)(*lcdmem & ~bitmask);
+	}
+	else if (state == SEG_ON_BLINK_ON)
+	{
+		*lcdmem 		= (u8)(*lcdmem & ~bitmask);
+		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) & ~bitmask);
+		*lcdmem 		= (u8)(*lcdmem | bits);
+		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) | bits);
+	}
+	else if (state == SEG_ON_BLINK_OFF)
+	{
+		*lcdmem = (u8)(*lcdmem & ~bitmask);
+		*lcdmem = (u8)(*lcdmem | bits);
+		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) & ~bitmask);
+	}
+	else if (state == SEG_OFF_BLINK_OFF)
+	{
+		*lcdmem = (u8)(*lcdmem & ~bitmask);
+		*(lcdmem+0x20) 	= (u8)(*(lcdmem+0x20) & ~bitmask);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          ref_display_char
+// @brief       Reference display_char: LINE1 font, '-' special case, LINE2 nibble swap at run time.
+// @param       u8 segment		A valid LCD segment
+//				u8 chr			Character to display
+//				u8 mode			SEG_ON, SEG_OFF, SEG_BLINK
+// @return      none
+// *************************************************************************************************
+static void ref_display_char(u8 segment, u8 chr, u8 mode)
+{
+	u8 bits;
+
+	if ((segment >= LCD_SEG_L1_3) && (segment <= LCD_SEG_L2_DP))
+	{
+		if ((chr >= 0x30) && (chr <= 0x5A)) bits = ref_font[chr-0x30];
+		else if (chr == 0x2D)				bits = BIT1;
+		else								bits = 0;
+
+		if (segment >= LCD_SEG_L2_5)
+		{
+			bits = ((bits << 4) & 0xF0) | ((bits >> 4) & 0x0F);
+			if ((segment == LCD_SEG_L2_5) && ((chr == '1') || (chr == 'L'))) bits = BIT7;
+		}
+		ref_write_lcd_mem((u8 *)segments_lcdmem[segment], bits, segments_bitmask[segment], mode);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          ref_clear_line
+// @brief       Reference clear_line: blank characters, then the symbols of the line.
+// @param       u8 line		LINE1, LINE2
+// @return      none
+// *************************************************************************************************
+static void ref_clear_line(u8 line)
+{
+	u8 i;
+
+	if (line == LINE1)
+	{
+		for (i = LCD_SEG_L1_3; i <= LCD_SEG_L1_0; i++) ref_display_char(i, ' ', SEG_OFF);
+		ref_write_lcd_mem((u8 *)segments_lcdmem[LCD_SEG_L1_DP1], segments_bitmask[LCD_SEG_L1_DP1],
+						  segments_bitmask[LCD_SEG_L1_DP1], SEG_OFF);
+		ref_write_lcd_mem((u8 *)segments_lcdmem[LCD_SEG_L1_DP0], segments_bitmask[LCD_SEG_L1_DP0],
+						  segments_bitmask[LCD_SEG_L1_DP0], SEG_OFF);
+		ref_write_lcd_mem((u8 *)segments_lcdmem[LCD_SEG_L1_COL], segments_bitmask[LCD_SEG_L1_COL],
+						  segments_bitmask[LCD_SEG_L1_COL], SEG_OFF);
+	}
+	else
+	{
+		for (i = LCD_SEG_L2_5; i <= LCD_SEG_L2_0; i++) ref_display_char(i, ' ', SEG_OFF);
+		ref_write_lcd_mem((u8 *)segments_lcdmem[LCD_SEG_L2_DP], segments_bitmask[LCD_SEG_L2_DP],
+						  segments_bitmask[LCD_SEG_L2_DP], SEG_OFF);
+		ref_write_lcd_mem((u8 *)segments_lcdmem[LCD_SEG_L2_COL1], segments_bitmask[LCD_SEG_L2_COL1],
+						  segments_bitmask[LCD_SEG_L2_COL1], SEG_OFF);
+		ref_write_lcd_mem((u8 *)segments_lcdmem[LCD_SEG_L2_COL0], segments_bitmask[LCD_SEG_L2_COL0],
+						  segments_bitmask[LCD_SEG_L2_COL0], SEG_OFF);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          lcd_random / lcd_compare
+// @brief       Fill LCD and blink memory with random bits, compare them with a reference copy.
+// *************************************************************************************************
+static void lcd_random(void)
+{
+	u8 i;
+
+	for (i = 0; i < 2 * LCD_BYTES; i++) sim_mem[LCD_MEM_ADDR + i] = (u8)test_rand(0x100);
+}
+
+
+static int lcd_compare(const u8 * ref, const char * what, u8 a, u8 b, u8 mode)
+{
+	u8 i;
+
+	for (i = 0; i < 2 * LCD_BYTES; i++)
+	{
+		if (sim_mem[LCD_MEM_ADDR + i] != ref[i])
+		{
+			test_fail("%s (%u, 0x%02X, mode %u): %s%u is 0x%02X, reference 0x%02X", what, a, b, mode,
+					  (i < LCD_BYTES) ? "LCDM" : "LCDBM", (i % LCD_BYTES) + 1,
+					  sim_mem[LCD_MEM_ADDR + i], ref[i]);
+			return 0;
+		}
+	}
+	renders++;
+	return 1;
+}
+
+
+// *************************************************************************************************
+// @fn          test_chars
+// @brief       Every segment, character and mode on random memory through both paths.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_chars(void)
+{
+	u8 start[2 * LCD_BYTES], ref[2 * LCD_BYTES];
+	unsigned segment, chr, mode, run;
+
+	for (segment = LCD_SEG_L1_3; segment <= LCD_SEG_L2_DP; segment++)
+	{
+		for (chr = 0; chr < 0x100; chr++)
+		{
+			for (mode = 0; mode < TEST_MODES; mode++)
+			{
+				for (run = 0; run < TEST_RUNS_CHAR; run++)
+				{
+					lcd_random();
+					memcpy(start, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(start));
+					ref_display_char(segment, chr, mode);
+					memcpy(ref, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(ref));
+					memcpy((u8 *)&sim_mem[LCD_MEM_ADDR], start, sizeof(start));
+					display_char(segment, chr, mode);
+					if (!lcd_compare(ref, "display_char", segment, chr, mode)) break;
+				}
+			}
+		}
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          test_lines
+// @brief       Random strings on both lines, then clear_line, through both paths.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_lines(void)
+{
+	u8 start[2 * LCD_BYTES], ref[2 * LCD_BYTES];
+	u8 str[6];
+	u8 line, first, last, mode, i;
+	unsigned run;
+
+	for (run = 0; run < TEST_RUNS_LINE; run++)
+	{
+		for (line = LINE1; line <= LINE2; line++)
+		{
+			first = (line == LINE1) ? LCD_SEG_L1_3 : LCD_SEG_L2_5;
+			last  = (line == LINE1) ? LCD_SEG_L1_0 : LCD_SEG_L2_0;
+			mode  = (u8)test_rand(TEST_MODES);
+			for (i = 0; i <= last - first; i++) str[i] = (u8)test_rand(0x100);
+
+			lcd_random();
+			memcpy(start, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(start));
+			for (i = first; i <= last; i++) ref_display_char(i, str[i - first], mode);
+			memcpy(ref, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(ref));
+			memcpy((u8 *)&sim_mem[LCD_MEM_ADDR], start, sizeof(start));
+			display_chars(switch_seg(line, LCD_SEG_L1_3_0, LCD_SEG_L2_5_0), str, mode);
+			lcd_compare(ref, "display_chars line", line, str[0], mode);
+
+			memcpy(start, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(start));
+			ref_clear_line(line);
+			memcpy(ref, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(ref));
+			memcpy((u8 *)&sim_mem[LCD_MEM_ADDR], start, sizeof(start));
+			clear_line(line);
+			lcd_compare(ref, "clear_line", line, 0, SEG_OFF);
+		}
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          test_write
+// @brief       write_lcd_mem with random bits and masks, bits may lie outside the mask.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_write(void)
+{
+	u8 start[2 * LCD_BYTES], ref[2 * LCD_BYTES];
+	u8 offset, bits, bitmask, mode;
+	unsigned run;
+
+	for (run = 0; run < TEST_RUNS_WRITE; run++)
+	{
+		offset  = (u8)test_rand(LCD_BYTES);
+		bits    = (u8)test_rand(0x100);
+		bitmask = (u8)test_rand(0x100);
+		mode    = (u8)test_rand(TEST_MODES);
+
+		lcd_random();
+		memcpy(start, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(start));
+		ref_write_lcd_mem((u8 *)&sim_mem[LCD_MEM_ADDR + offset], bits, bitmask, mode);
+		memcpy(ref, (u8 *)&sim_mem[LCD_MEM_ADDR], sizeof(ref));
+		memcpy((u8 *)&sim_mem[LCD_MEM_ADDR], start, sizeof(start));
+		write_lcd_mem((u8 *)&sim_mem[LCD_MEM_ADDR + offset], bits, bitmask, mode);
+		lcd_compare(ref, "write_lcd_mem", offset, bits, mode);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          main
+// @brief       Render through both paths and compare LCD memory.
+// @param       none
+// @return      0 if all checks passed
+// *************************************************************************************************
+int main(void)
+{
+	test_chars();
+	test_lines();
+	test_write();
+
+	printf("\n=== display-test ===\n");
+	printf("%-24s %12lu\n", "renders compared", renders);
+	printf("%-24s %12lu\n", "failed checks", failures);
+	return failures ? 1 : 0;
+}
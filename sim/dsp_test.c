@@ -0,0 +1,435 @@
+// *************************************************************************************************
+// Host test of the fixed point filter library (driver/dsp.c).
+//
+// Every function is compared with a double precision reference and has to stay within the
+// tolerance it was released with. dsp.c is compiled with the coverage callbacks of the simulator,
+// so the cycles of each call are estimated with the simulator's cycle model (SIM_CYCLES_PER_BLOCK
+// per executed basic block) and listed per function.
+//
+// make sim-test; exit status 0 if all checks passed
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+#include "dsp.h"
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+void __sanitizer_cov_trace_pc(void);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Tolerances
+#define TOL_ATAN2_DEG			(0.10)		// atan2_brad, degrees
+#define TOL_BIQUAD_LSB			(4.2)		// biquad_filter, Butterworth low pass
+#define TOL_IIR1_PA(alpha)		(0.5 / (alpha))	// iir1_filter on pressure (Pa), dead band
+#define TOL_MOVING_AVG_LSB		(0.5)		// moving_avg_filter, rounding only
+
+// Butterworth low pass for the biquad, cut-off as fraction of the sample rate
+#define BIQUAD_FC				(0.1)
+
+// Weights of iir1_filter in altitude and vario
+#define IIR1_WEIGHTS			(2u)
+
+#define TEST_SEED				(0xD5Bu)
+
+enum dsp_fn
+{
+	FN_MULT_SCALE15, FN_SAT_ADD16, FN_IIR1, FN_STEP, FN_BIQUAD, FN_MOVING_AVG, FN_MOVING_MIN,
+	FN_MEDIAN3, FN_ISQRT32, FN_ATAN2, FN_COUNT
+};
+
+// Calls and cycles per function
+struct dsp_cost
+{
+	const char *	name;
+	uint64_t		calls;
+	uint64_t		blocks;
+	uint64_t		max;
+};
+
+// Run one call and book its blocks to the function
+#define MEASURE(fn, call)	(blocks = 0, (call), cost_add((fn)))
+
+
+// *************************************************************************************************
+// Global Variable section
+static uint64_t blocks;
+static const double iir1_alphas[IIR1_WEIGHTS] = { 0.2, 0.5 };
+static uint32_t lcg = TEST_SEED;
+static unsigned long failures;
+
+static struct dsp_cost costs[FN_COUNT] =
+{
+	[FN_MULT_SCALE15]	= { "mult_scale15" },
+	[FN_SAT_ADD16]		= { "sat_add16" },
+	[FN_IIR1]			= { "iir1_filter" },
+	[FN_STEP]			= { "step_filter" },
+	[FN_BIQUAD]			= { "biquad_filter" },
+	[FN_MOVING_AVG]		= { "moving_avg_filter" },
+	[FN_MOVING_MIN]		= { "moving_avg_min (16)" },
+	[FN_MEDIAN3]		= { "median3" },
+	[FN_ISQRT32]		= { "isqrt32" },
+	[FN_ATAN2]			= { "atan2_brad" },
+};
+
+
+// *************************************************************************************************
+// @fn          __sanitizer_cov_trace_pc
+// @brief       Called by every basic block of dsp.c.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void __sanitizer_cov_trace_pc(void)
+{
+	blocks++;
+}
+
+
+// *************************************************************************************************
+// @fn          cost_add
+// @brief       Book the blocks of the last call to a function.
+// @param       enum dsp_fn fn
+// @return      none
+// *************************************************************************************************
+static void cost_add(enum dsp_fn fn)
+{
+	costs[fn].calls++;
+	costs[fn].blocks += blocks;
+	if (blocks > costs[fn].max) costs[fn].max = blocks;
+}
+
+
+// *************************************************************************************************
+// @fn          test_rand
+// @brief       Deterministic pseudo random numbers (LCG), the run is the same every time.
+// @param       uint32_t range		Number of values (0 = full 32 bits)
+// @return      uint32_t			0 .. range-1
+// *************************************************************************************************
+static uint32_t test_rand(uint32_t range)
+{
+	uint32_t r;
+
+	lcg = lcg * 1103515245u + 12345u;
+	r = lcg >> 8;
+	lcg = lcg * 1103515245u + 12345u;
+	r = (r << 16) ^ (lcg >> 8);
+	return range ? r % range : r;
+}
+
+
+// *************************************************************************************************
+// @fn          test_gauss
+// @brief       Normal distributed noise (Box-Muller).
+// @param       none
+// @return      double		Sample, sigma 1
+// *************************************************************************************************
+static double test_gauss(void)
+{
+	double u1 = (test_rand(1u << 24) + 1.0) / 16777217.0;
+	double u2 = test_rand(1u << 24) / 16777216.0;
+
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+
+// *************************************************************************************************
+// @fn          test_fail
+// @brief       Report a failed check. The run goes on to report further failures.
+// @param       const char * fmt	printf style message
+// @return      none
+// *************************************************************************************************
+static void __attribute__((format(printf, 1, 2))) test_fail(const char * fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "dsp-test: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	failures++;
+}
+
+
+// *************************************************************************************************
+// @fn          test_arith
+// @brief       mult_scale15, saturating arithmetic, step filter and median against their
+//				definitions.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_arith(void)
+{
+	s16 a, b, c, r, expected;
+	s32 y, x, d, expected32;
+	u16 step;
+	u32 i;
+
+	for (i = 0; i < 1000000u; i++)
+	{
+		a = (s16)test_rand(0x10000);
+		b = (s16)test_rand(0x10000);
+		c = (s16)test_rand(0x10000);
+
+		MEASURE(FN_MULT_SCALE15, r = mult_scale15(a, b));
+		if (fabs(r - a * (double)b / 32768.0) > 0.5 && !(a == -32768 && b == -32768))
+		{
+			test_fail("mult_scale15(%d, %d) = %d", a, b, r);
+		}
+
+		MEASURE(FN_SAT_ADD16, r = sat_add16(a, b));
+		expected = (a + b > 32767) ? 32767 : ((a + b < -32768) ? -32768 : a + b);
+		if (r != expected) test_fail("sat_add16(%d, %d) = %d", a, b, r);
+		expected = (a - b > 32767) ? 32767 : ((a - b < -32768) ? -32768 : a - b);
+		if (sat_sub16(a, b) != expected) test_fail("sat_sub16(%d, %d) = %d", a, b, sat_sub16(a, b));
+
+		MEASURE(FN_MEDIAN3, r = median3(a, b, c));
+		if ((r != a && r != b && r != c) || ((r < a) + (r < b) + (r < c) > 1) ||
+			((r > a) + (r > b) + (r > c) > 1))
+		{
+			test_fail("median3(%d, %d, %d) = %d", a, b, c, r);
+		}
+
+		// Start d away from x, move by at most step towards it
+		x = (s32)test_rand(2000000) - 1000000;
+		d = (s32)test_rand(1024) - 512;
+		step = (u16)test_rand(512);
+		MEASURE(FN_STEP, y = step_filter(x + d, x, step));
+		expected32 = (d > step) ? x + d - step : ((d < -step) ? x + d + step : x);
+		if (y != expected32) test_fail("step_filter(%ld, %ld, %u) = %ld", (long)(x + d), (long)x, step, (long)y);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          test_iir1
+// @brief       iir1_filter on a day of pressure samples (weather drift, climbs, sensor noise)
+//				with the weights used by altitude (0.2) and vario (0.5). The integer state stops 
+//				moving once alpha * (x - y) rounds to 0, so it may stay up to 0.5 / alpha away from
+//				the double precision filter.
+// @param       double * err	Largest difference to the double precision filter per weight (Pa)
+// @return      none
+// *************************************************************************************************
+static void test_iir1(double * err)
+{
+	double p, ref, d;
+	s32 y;
+	u32 i, a;
+
+	for (a = 0; a < IIR1_WEIGHTS; a++)
+	{
+		y = 101325;
+		ref = y;
+		err[a] = 0.0;
+		for (i = 0; i < 86400u; i++)
+		{
+			// Weather +-300 Pa, a 400m climb (4800 Pa) every few hours, 3 Pa rms noise
+			p = 101325.0 + 300.0 * sin(i / 13751.0) - 4800.0 * pow(sin(M_PI * i / 21600.0), 8);
+			p += 3.0 * test_gauss();
+			MEASURE(FN_IIR1, y = iir1_filter(y, lrint(p), DSP_Q15(iir1_alphas[a])));
+			ref += iir1_alphas[a] * (lrint(p) - ref);
+			d = fabs(y - ref);
+			if (d > err[a]) err[a] = d;
+		}
+		if (err[a] > TOL_IIR1_PA(iir1_alphas[a]))
+		{
+			test_fail("iir1_filter (%.1f) %.2f Pa from double (limit %.2f)", iir1_alphas[a], err[a],
+					  TOL_IIR1_PA(iir1_alphas[a]));
+		}
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          test_biquad
+// @brief       Butterworth low pass (bilinear transform) on steps, sines and noise. The double
+//				reference runs with the same Q14 coefficients, the difference is arithmetic only.
+// @param       none
+// @return      double		Largest difference to the double precision filter (LSB)
+// *************************************************************************************************
+static double test_biquad(void)
+{
+	struct biquad f;
+	double k = tan(M_PI * BIQUAD_FC), n = 1.0 / (1.0 + M_SQRT2 * k + k * k);
+	double b[3], a[2], x[3] = { 0 }, r[3] = { 0 }, in, err, max = 0.0;
+	s16 y;
+	u32 i;
+
+	memset(&f, 0, sizeof(f));
+	f.b0 = DSP_Q14(k * k * n);
+	f.b1 = DSP_Q14(2.0 * k * k * n);
+	f.b2 = f.b0;
+	f.a1 = DSP_Q14(2.0 * (k * k - 1.0) * n);
+	f.a2 = DSP_Q14((1.0 - M_SQRT2 * k + k * k) * n);
+	b[0] = f.b0 / 16384.0;	b[1] = f.b1 / 16384.0;	b[2] = f.b2 / 16384.0;
+	a[0] = f.a1 / 16384.0;	a[1] = f.a2 / 16384.0;
+
+	for (i = 0; i < 200000u; i++)
+	{
+		// Steps of +-12000, a sweeping sine and noise, always within 16 bits after the filter
+		in = ((i / 997) & 1 ? 12000.0 : -12000.0) + 6000.0 * sin(i * i * 1e-7) + 1500.0 * test_gauss();
+		in = (in > 32767.0) ? 32767.0 : ((in < -32768.0) ? -32768.0 : in);
+		x[2] = x[1];	x[1] = x[0];	x[0] = lrint(in);
+		r[2] = r[1];	r[1] = r[0];
+		r[0] = b[0] * x[0] + b[1] * x[1] + b[2] * x[2] - a[0] * r[1] - a[1] * r[2];
+
+		MEASURE(FN_BIQUAD, y = biquad_filter(&f, (s16)x[0]));
+		err = fabs(y - r[0]);
+		if (err > max) max = err;
+	}
+	if (max > TOL_BIQUAD_LSB) test_fail("biquad_filter %.2f LSB from double (limit %.1f)", max, TOL_BIQUAD_LSB);
+	return max;
+}
+
+
+// *************************************************************************************************
+// @fn          test_moving_avg
+// @brief       Moving average and window min/max against a direct computation over the window.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_moving_avg(void)
+{
+	struct moving_avg f;
+	s16 buf[16], window[16], y, min, max, x;
+	double sum;
+	u8 shift, j;
+	u32 i;
+
+	for (shift = 0; shift <= 4; shift++)
+	{
+		moving_avg_init(&f, buf, shift, 1000);
+		for (j = 0; j < (1u << shift); j++) window[j] = 1000;
+
+		for (i = 0; i < 100000u; i++)
+		{
+			x = (s16)test_rand(0x10000);
+			window[i & ((1u << shift) - 1)] = x;
+			MEASURE(FN_MOVING_AVG, y = moving_avg_filter(&f, x));
+
+			sum = 0.0;
+			min = max = window[0];
+			for (j = 0; j < (1u << shift); j++)
+			{
+				sum += window[j];
+				if (window[j] < min) min = window[j];
+				if (window[j] > max) max = window[j];
+			}
+			if (fabs(y - sum / (1u << shift)) > TOL_MOVING_AVG_LSB)
+			{
+				test_fail("moving_avg_filter (2^%u) = %d, window average %.2f", shift, y, sum / (1u << shift));
+			}
+			if (shift == 4) MEASURE(FN_MOVING_MIN, y = moving_avg_min(&f));
+			else y = moving_avg_min(&f);
+			if ((y != min) || (moving_avg_max(&f) != max)) test_fail("moving_avg_min/max wrong");
+		}
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          test_isqrt32
+// @brief       isqrt32 on every square and its neighbours and on a sweep through 32 bits.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_isqrt32(void)
+{
+	uint64_t a;
+	u32 n;
+	u16 r;
+
+	for (a = 0; a <= 0xFFFFFFFFull; a += (a < 0x100000ull) ? 1 : 4093 + (a & 0xFF))
+	{
+		MEASURE(FN_ISQRT32, r = isqrt32((u32)a));
+		if ((uint64_t)r * r > a || ((uint64_t)r + 1) * (r + 1) <= a) test_fail("isqrt32(%llu) = %u", (unsigned long long)a, r);
+	}
+	for (n = 1; n <= 0xFFFFu; n++)
+	{
+		if (isqrt32(n * n) != n || isqrt32(n * n - 1) != n - 1) test_fail("isqrt32 wrong around %lu^2", (unsigned long)n);
+	}
+	if (isqrt32(0xFFFFFFFFu) != 0xFFFFu) test_fail("isqrt32(0xFFFFFFFF) = %u", isqrt32(0xFFFFFFFFu));
+}
+
+
+// *************************************************************************************************
+// @fn          test_atan2
+// @brief       atan2_brad on a grid over the whole 16 bit plane and on every small vector.
+// @param       none
+// @return      double		Largest error (degrees)
+// *************************************************************************************************
+static double test_atan2(void)
+{
+	double err, max = 0.0;
+	s32 x, y;
+	s16 a;
+
+	for (y = -32768; y <= 32767; y += (y > -128 && y < 128) ? 1 : 251)
+	{
+		for (x = -32768; x <= 32767; x += (x > -128 && x < 128) ? 1 : 127)
+		{
+			if (x == 0 && y == 0) continue;
+			MEASURE(FN_ATAN2, a = atan2_brad((s16)y, (s16)x));
+			err = fabs(remainder(a * (180.0 / 32768.0) - atan2(y, x) * (180.0 / M_PI), 360.0));
+			if (err > max) max = err;
+		}
+	}
+	if (max > TOL_ATAN2_DEG) test_fail("atan2_brad %.3f deg from atan2 (limit %.2f)", max, TOL_ATAN2_DEG);
+	return max;
+}
+
+
+// *************************************************************************************************
+// @fn          main
+// @brief       Run the reference checks and print the error and cycle tables.
+// @param       none
+// @return      0 if all checks passed
+// *************************************************************************************************
+int main(void)
+{
+	double err_iir1[IIR1_WEIGHTS], err_biquad, err_atan2;
+	char label[32];
+	int i;
+
+	test_arith();
+	test_iir1(err_iir1);
+	err_biquad = test_biquad();
+	test_moving_avg();
+	test_isqrt32();
+	err_atan2 = test_atan2();
+
+	printf("\n=== dsp-test ===\n");
+	printf("%-24s %12.3f deg    (limit %.2f)\n", "atan2_brad error", err_atan2, TOL_ATAN2_DEG);
+	printf("%-24s %12.3f LSB    (limit %.1f, Butterworth fc %.2f fs)\n", "biquad_filter error", err_biquad,
+		   TOL_BIQUAD_LSB, BIQUAD_FC);
+	for (i = 0; i < IIR1_WEIGHTS; i++)
+	{
+		snprintf(label, sizeof(label), "iir1_filter error (%.1f)", iir1_alphas[i]);
+		printf("%-24s %12.3f Pa     (limit %.2f)\n", label, err_iir1[i], TOL_IIR1_PA(iir1_alphas[i]));
+	}
+	printf("%-24s %12s\n", "isqrt32", "exact");
+
+	printf("\n%-24s %12s %12s %12s\n", "cycles (sim model)", "calls", "mean", "max");
+	for (i = 0; i < FN_COUNT; i++)
+	{
+		if (costs[i].calls == 0) continue;
+		printf("%-24s %12llu %12.1f %12llu\n", costs[i].name, (unsigned long long)costs[i].calls,
+			   (double)costs[i].blocks * SIM_CYCLES_PER_BLOCK / costs[i].calls,
+			   (unsigned long long)costs[i].max * SIM_CYCLES_PER_BLOCK);
+	}
+	printf("%-24s %12lu\n", "failed checks", failures);
+	return failures ? 1 : 0;
+}
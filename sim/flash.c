@@ -0,0 +1,113 @@
+// *************************************************************************************************
+// Host simulation: flash write trapping. Flash is mapped read-only at its device addresses, a
+// firmware write faults and is handed to periph_flash_write, which decides what the write really
+// did. Shared by the simulator and the host tests of the flash drivers.
+// *************************************************************************************************
+
+#define _GNU_SOURCE
+
+// *************************************************************************************************
+// Include section
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Global Variable section
+static uint16_t flash_segment;
+static uint16_t flash_length;
+static uint8_t flash_before[512];
+
+
+// *************************************************************************************************
+// @fn          flash_fault / flash_step
+// @brief       A firmware write faults, the page is opened for one single-stepped instruction and
+//				the flash controller model then decides what the write really did (program, erase
+//				or access violation).
+// *************************************************************************************************
+static void flash_fault(int sig, siginfo_t * si, void * context)
+{
+	ucontext_t * uc = context;
+	uintptr_t addr = (uintptr_t)si->si_addr;
+
+	(void)sig;
+	if (addr < FLASH_START || addr >= FLASH_END || !(uc->uc_mcontext.gregs[REG_ERR] & 2))
+	{
+		static const char msg[] = "sim: firmware crashed (invalid memory access)\n";
+
+		if (write(2, msg, sizeof(msg) - 1) < 0) { }
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+
+	// Information memory segments are 128 bytes, all others 512 bytes
+	flash_length  = (addr >= 0x1800 && addr < 0x1A00) ? 128 : 512;
+	flash_segment = (uint16_t)(addr & ~(uintptr_t)(flash_length - 1));
+	memcpy(flash_before, (void *)(uintptr_t)flash_segment, flash_length);
+
+	mprotect((void *)(addr & ~(uintptr_t)0xFFF), 0x1000, PROT_READ | PROT_WRITE);
+	uc->uc_mcontext.gregs[REG_EFL] |= 0x100;
+}
+
+
+static void flash_step(int sig, siginfo_t * si, void * context)
+{
+	ucontext_t * uc = context;
+
+	(void)sig;
+	(void)si;
+	uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+	periph_flash_write(flash_segment, flash_length, flash_before);
+	mprotect((void *)(uintptr_t)(flash_segment & ~0xFFFu), 0x1000, PROT_READ);
+}
+
+
+// *************************************************************************************************
+// @fn          sim_flash_map
+// @brief       Map erased flash at the device addresses. It stays writable for the caller to
+//				install initial content until sim_flash_protect.
+// @param       none
+// @return      uint8_t *		Flash at FLASH_START
+// *************************************************************************************************
+uint8_t * sim_flash_map(void)
+{
+	uint8_t * flash;
+
+	flash = mmap((void *)(uintptr_t)FLASH_START, FLASH_END - FLASH_START, PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if (flash != (void *)(uintptr_t)FLASH_START)
+	{
+		fprintf(stderr, "sim: cannot map flash at 0x%04X (check vm.mmap_min_addr)\n", FLASH_START);
+		exit(2);
+	}
+	memset(flash, 0xFF, FLASH_END - FLASH_START);
+	return flash;
+}
+
+
+// *************************************************************************************************
+// @fn          sim_flash_protect
+// @brief       Make flash read-only and trap firmware writes from now on.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void sim_flash_protect(void)
+{
+	struct sigaction sa;
+
+	mprotect((void *)(uintptr_t)FLASH_START, FLASH_END - FLASH_START, PROT_READ);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sa.sa_sigaction = flash_fault;
+	sigaction(SIGSEGV, &sa, NULL);
+	sa.sa_sigaction = flash_step;
+	sigaction(SIGTRAP, &sa, NULL);
+}
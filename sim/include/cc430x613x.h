@@ -0,0 +1,823 @@
+// *************************************************************************************************
+// Host simulation stand-in for the CC430F613x device header.
+//
+// Every peripheral register is mapped onto the simulated I/O page (sim_io) at its datasheet
+// address, so the firmware keeps using the usual register names. Each register access calls into
+// the simulator, which lets the peripheral models react to the access (status flags, timer counts,
+// SPI/TWI transfers, ...). Only the registers and bits used by the firmware are declared here.
+// *************************************************************************************************
+
+#ifndef __CC430X613X_SIM_H
+#define __CC430X613X_SIM_H
+
+#include <stdint.h>
+#include <intrinsics.h>
+
+// *************************************************************************************************
+// Simulator interface
+
+extern volatile void * sim_io(unsigned short addr, unsigned char size);
+extern volatile unsigned char sim_mem[0x1000];
+
+#define SFR_8BIT(addr)				(*(volatile unsigned char  *)sim_io((addr), 1))
+#define SFR_16BIT(addr)				(*(volatile unsigned short *)sim_io((addr), 2))
+
+// Status register emulation
+extern void 			sim_bis_sr(unsigned short bits);
+extern void 			sim_bic_sr(unsigned short bits);
+extern void 			sim_bic_sr_on_exit(unsigned short bits);
+extern unsigned short 	sim_get_sr(void);
+
+#define _BIS_SR(x)						sim_bis_sr(x)
+#define _BIC_SR(x)						sim_bic_sr(x)
+#define __bis_SR_register(x)			sim_bis_sr(x)
+#define __bic_SR_register(x)			sim_bic_sr(x)
+#define _BIS_SR_IRQ(x)					sim_bis_sr(x)
+#define _BIC_SR_IRQ(x)					sim_bic_sr_on_exit(x)
+#define __bic_SR_register_on_exit(x)	sim_bic_sr_on_exit(x)
+#define READ_SR							sim_get_sr()
+#define __get_SR_register()				sim_get_sr()
+#define __enable_interrupt()			sim_bis_sr(GIE)
+#define __disable_interrupt()			sim_bic_sr(GIE)
+#define _EINT()							sim_bis_sr(GIE)
+#define _DINT()							sim_bic_sr(GIE)
+#define __no_operation()				do { } while (0)
+#define _NOP()							do { } while (0)
+
+// *************************************************************************************************
+// Standard bits
+
+#define BIT0                (0x0001)
+#define BIT1                (0x0002)
+#define BIT2                (0x0004)
+#define BIT3                (0x0008)
+#define BIT4                (0x0010)
+#define BIT5                (0x0020)
+#define BIT6                (0x0040)
+#define BIT7                (0x0080)
+#define BIT8                (0x0100)
+#define BIT9                (0x0200)
+#define BITA                (0x0400)
+#define BITB                (0x0800)
+#define BITC                (0x1000)
+#define BITD                (0x2000)
+#define BITE                (0x4000)
+#define BITF                (0x8000)
+
+// Status register bits
+#define C                   (0x0001)
+#define Z                   (0x0002)
+#define N                   (0x0004)
+#define V                   (0x0100)
+#define GIE                 (0x0008)
+#define CPUOFF              (0x0010)
+#define OSCOFF              (0x0020)
+#define SCG0                (0x0040)
+#define SCG1                (0x0080)
+
+#define LPM0_bits           (CPUOFF)
+#define LPM1_bits           (SCG0+CPUOFF)
+#define LPM2_bits           (SCG1+CPUOFF)
+#define LPM3_bits           (SCG1+SCG0+CPUOFF)
+#define LPM4_bits           (SCG1+SCG0+OSCOFF+CPUOFF)
+
+#define LPM0                _BIS_SR(LPM0_bits)
+#define LPM0_EXIT           _BIC_SR_IRQ(LPM0_bits)
+#define LPM3                _BIS_SR(LPM3_bits)
+#define LPM3_EXIT           _BIC_SR_IRQ(LPM3_bits)
+
+// *************************************************************************************************
+// Special function registers
+
+#define SFRIE1              SFR_16BIT(0x0100)
+#define SFRIFG1             SFR_16BIT(0x0102)
+#define SFRRPCR             SFR_16BIT(0x0104)
+
+#define WDTIFG              (0x0001)
+#define OFIFG               (0x0002)
+#define VMAIFG              (0x0008)
+#define NMIIFG              (0x0010)
+
+// *************************************************************************************************
+// Power management module
+
+#define PMMCTL0             SFR_16BIT(0x0120)
+#define PMMCTL0_L           SFR_8BIT(0x0120)
+#define PMMCTL0_H           SFR_8BIT(0x0121)
+#define PMMCTL1             SFR_16BIT(0x0122)
+#define SVSMHCTL            SFR_16BIT(0x0124)
+#define SVSMLCTL            SFR_16BIT(0x0126)
+#define PMMIFG              SFR_16BIT(0x012C)
+#define PMMRIE              SFR_16BIT(0x012E)
+#define PM5CTL0             SFR_16BIT(0x0130)
+
+#define PMMPW               (0xA500)
+#define PMMCOREV0           (0x0001)
+#define PMMCOREV1           (0x0002)
+#define PMMSWBOR            (0x0004)
+#define PMMSWPOR            (0x0008)
+#define PMMREGOFF           (0x0010)
+#define PMMHPMRE            (0x0080)
+#define PMMCOREV_0          (0x0000)
+#define PMMCOREV_1          (0x0001)
+#define PMMCOREV_2          (0x0002)
+#define PMMCOREV_3          (0x0003)
+
+#define SVSHRVL0            (0x0100)
+#define SVSHRVL1            (0x0200)
+#define SVSHE               (0x0400)
+#define SVMHE               (0x4000)
+#define SVSMHRRL0           (0x0001)
+#define SVSMHRRL1           (0x0002)
+#define SVSMHRRL2           (0x0004)
+#define SVSLRVL0            (0x0100)
+#define SVSLRVL1            (0x0200)
+#define SVSLE               (0x0400)
+#define SVMLE               (0x4000)
+#define SVSMLRRL0           (0x0001)
+#define SVSMLRRL1           (0x0002)
+#define SVSMLRRL2           (0x0004)
+
+#define SVSMLDLYIFG         (0x0001)
+#define SVMLIFG             (0x0002)
+#define SVMLVLRIFG          (0x0004)
+#define SVSMHDLYIFG         (0x0010)
+#define SVMHIFG             (0x0020)
+#define SVMHVLRIFG          (0x0040)
+
+// *************************************************************************************************
+// Flash controller
+
+#define FCTL1               SFR_16BIT(0x0140)
+#define FCTL3               SFR_16BIT(0x0144)
+#define FCTL4               SFR_16BIT(0x0146)
+
+#define FRKEY               (0x9600)
+#define FWKEY               (0xA500)
+#define FXKEY               (0x3300)
+
+#define ERASE               (0x0002)
+#define MERAS               (0x0004)
+#define WRT                 (0x0040)
+#define BLKWRT              (0x0080)
+
+#define BUSY                (0x0001)
+#define KEYV                (0x0002)
+#define ACCVIFG             (0x0004)
+#define WAIT                (0x0008)
+#define LOCK                (0x0010)
+#define EMEX                (0x0020)
+#define LOCKA               (0x0040)
+
+#define LOCKINFO            (0x0080)
+
+// *************************************************************************************************
+// Watchdog timer
+
+#define WDTCTL              SFR_16BIT(0x015C)
+
+#define WDTPW               (0x5A00)
+#define WDTIS0              (0x0001)
+#define WDTIS1              (0x0002)
+#define WDTIS2              (0x0004)
+#define WDTCNTCL            (0x0008)
+#define WDTTMSEL            (0x0010)
+#define WDTSSEL0            (0x0020)
+#define WDTSSEL1            (0x0040)
+#define WDTHOLD             (0x0080)
+
+#define WDTIS__2G           (0x0000)
+#define WDTIS__128M         (0x0001)
+#define WDTIS__8192K        (0x0002)
+#define WDTIS__512K         (0x0003)
+#define WDTIS__32K          (0x0004)
+#define WDTIS__8192         (0x0005)
+#define WDTIS__512          (0x0006)
+#define WDTIS__64           (0x0007)
+#define WDTSSEL__SMCLK      (0x0000)
+#define WDTSSEL__ACLK       (0x0020)
+#define WDTSSEL__VLO        (0x0040)
+
+// *************************************************************************************************
+// Unified clock system
+
+#define UCSCTL0             SFR_16BIT(0x0160)
+#define UCSCTL1             SFR_16BIT(0x0162)
+#define UCSCTL2             SFR_16BIT(0x0164)
+#define UCSCTL3             SFR_16BIT(0x0166)
+#define UCSCTL4             SFR_16BIT(0x0168)
+#define UCSCTL5             SFR_16BIT(0x016A)
+#define UCSCTL6             SFR_16BIT(0x016C)
+#define UCSCTL7             SFR_16BIT(0x016E)
+#define UCSCTL8             SFR_16BIT(0x0170)
+
+#define DCORSEL_0           (0x0000)
+#define DCORSEL_1           (0x0010)
+#define DCORSEL_2           (0x0020)
+#define DCORSEL_3           (0x0030)
+#define DCORSEL_4           (0x0040)
+#define DCORSEL_5           (0x0050)
+#define DCORSEL_6           (0x0060)
+#define DCORSEL_7           (0x0070)
+#define FLLD_0              (0x0000)
+#define FLLD_1              (0x1000)
+#define FLLD_2              (0x2000)
+#define SELREF__XT1CLK      (0x0000)
+#define SELA__XT1CLK        (0x0000)
+#define SELA__REFOCLK       (0x0200)
+#define SELS__DCOCLKDIV     (0x0040)
+#define SELM__DCOCLKDIV     (0x0004)
+#define XT1OFF              (0x0001)
+#define SMCLKOFF            (0x0002)
+#define XCAP_0              (0x0000)
+#define XCAP_1              (0x0004)
+#define XCAP_2              (0x0008)
+#define XCAP_3              (0x000C)
+#define XT2OFF              (0x0100)
+#define DCOFFG              (0x0001)
+#define XT1LFOFFG           (0x0002)
+#define XT1HFOFFG           (0x0004)
+#define XT2OFFG             (0x0008)
+
+// *************************************************************************************************
+// Shared reference
+
+#define REFCTL0             SFR_16BIT(0x01B0)
+
+#define REFON               (0x0001)
+#define REFOUT              (0x0002)
+#define REFTCOFF            (0x0008)
+#define REFVSEL0            (0x0010)
+#define REFVSEL1            (0x0020)
+#define REFMSTR             (0x0080)
+#define REFVSEL_0           (0x0000)
+#define REFVSEL_1           (0x0010)
+#define REFVSEL_2           (0x0020)
+#define REFVSEL_3           (0x0030)
+
+// *************************************************************************************************
+// Port mapping
+
+#define PMAPPWD             SFR_16BIT(0x01C0)
+#define PMAPCTL             SFR_16BIT(0x01C2)
+#define P1MAP0              SFR_8BIT(0x01C8)
+#define P2MAP0              SFR_8BIT(0x01D0)
+#define P3MAP0              SFR_8BIT(0x01D8)
+
+#define PMAPKEY             (0x2D52)
+#define PMAPLOCKED          (0x0001)
+#define PMAPRECFG           (0x0002)
+
+#define PM_NONE             (0)
+#define PM_CBOUT0           (1)
+#define PM_TA0CLK           (1)
+#define PM_CBOUT1           (2)
+#define PM_TA1CLK           (2)
+#define PM_ACLK             (3)
+#define PM_MCLK             (4)
+#define PM_SMCLK            (5)
+#define PM_RTCCLK           (6)
+#define PM_ADC12CLK         (7)
+#define PM_DMAE0            (7)
+#define PM_SVMOUT           (8)
+#define PM_TA0CCR0A         (9)
+#define PM_TA0CCR1A         (10)
+#define PM_TA0CCR2A         (11)
+#define PM_TA0CCR3A         (12)
+#define PM_TA0CCR4A         (13)
+#define PM_TA1CCR0A         (14)
+#define PM_TA1CCR1A         (15)
+#define PM_TA1CCR2A         (16)
+#define PM_UCA0RXD          (17)
+#define PM_UCA0SOMI         (17)
+#define PM_UCA0TXD          (18)
+#define PM_UCA0SIMO         (18)
+#define PM_UCA0CLK          (19)
+#define PM_UCB0STE          (19)
+#define PM_UCB0SOMI         (20)
+#define PM_UCB0SCL          (20)
+#define PM_UCB0SIMO         (21)
+#define PM_UCB0SDA          (21)
+#define PM_UCB0CLK          (22)
+#define PM_UCA0STE          (22)
+#define PM_RFGDO0           (23)
+#define PM_RFGDO1           (24)
+#define PM_RFGDO2           (25)
+
+// *************************************************************************************************
+// Digital I/O
+
+#define P1IN                SFR_8BIT(0x0200)
+#define P2IN                SFR_8BIT(0x0201)
+#define P1OUT               SFR_8BIT(0x0202)
+#define P2OUT               SFR_8BIT(0x0203)
+#define P1DIR               SFR_8BIT(0x0204)
+#define P2DIR               SFR_8BIT(0x0205)
+#define P1REN               SFR_8BIT(0x0206)
+#define P2REN               SFR_8BIT(0x0207)
+#define P1DS                SFR_8BIT(0x0208)
+#define P2DS                SFR_8BIT(0x0209)
+#define P1SEL               SFR_8BIT(0x020A)
+#define P2SEL               SFR_8BIT(0x020B)
+#define P1IV                SFR_16BIT(0x020E)
+#define P1IES               SFR_8BIT(0x0218)
+#define P2IES               SFR_8BIT(0x0219)
+#define P1IE                SFR_8BIT(0x021A)
+#define P2IE                SFR_8BIT(0x021B)
+#define P1IFG               SFR_8BIT(0x021C)
+#define P2IFG               SFR_8BIT(0x021D)
+#define P2IV                SFR_16BIT(0x021E)
+
+#define P3IN                SFR_8BIT(0x0220)
+#define P4IN                SFR_8BIT(0x0221)
+#define P3OUT               SFR_8BIT(0x0222)
+#define P4OUT               SFR_8BIT(0x0223)
+#define P3DIR               SFR_8BIT(0x0224)
+#define P4DIR               SFR_8BIT(0x0225)
+#define P3REN               SFR_8BIT(0x0226)
+#define P4REN               SFR_8BIT(0x0227)
+#define P3DS                SFR_8BIT(0x0228)
+#define P4DS                SFR_8BIT(0x0229)
+#define P3SEL               SFR_8BIT(0x022A)
+#define P4SEL               SFR_8BIT(0x022B)
+
+#define P5IN                SFR_8BIT(0x0240)
+#define P5OUT               SFR_8BIT(0x0242)
+#define P5DIR               SFR_8BIT(0x0244)
+#define P5REN               SFR_8BIT(0x0246)
+#define P5DS                SFR_8BIT(0x0248)
+#define P5SEL               SFR_8BIT(0x024A)
+
+#define PJIN                SFR_16BIT(0x0320)
+#define PJOUT               SFR_16BIT(0x0322)
+#define PJDIR               SFR_16BIT(0x0324)
+#define PJREN               SFR_16BIT(0x0326)
+#define PJDS                SFR_16BIT(0x0328)
+
+// *************************************************************************************************
+// Timer0_A5 / Timer1_A3
+
+#define TA0CTL              SFR_16BIT(0x0340)
+#define TA0CCTL0            SFR_16BIT(0x0342)
+#define TA0CCTL1            SFR_16BIT(0x0344)
+#define TA0CCTL2            SFR_16BIT(0x0346)
+#define TA0CCTL3            SFR_16BIT(0x0348)
+#define TA0CCTL4            SFR_16BIT(0x034A)
+#define TA0R                SFR_16BIT(0x0350)
+#define TA0CCR0             SFR_16BIT(0x0352)
+#define TA0CCR1             SFR_16BIT(0x0354)
+#define TA0CCR2             SFR_16BIT(0x0356)
+#define TA0CCR3             SFR_16BIT(0x0358)
+#define TA0CCR4             SFR_16BIT(0x035A)
+#define TA0EX0              SFR_16BIT(0x0360)
+#define TA0IV               SFR_16BIT(0x036E)
+
+#define TA1CTL              SFR_16BIT(0x0380)
+#define TA1CCTL0            SFR_16BIT(0x0382)
+#define TA1CCTL1            SFR_16BIT(0x0384)
+#define TA1CCTL2            SFR_16BIT(0x0386)
+#define TA1R                SFR_16BIT(0x0390)
+#define TA1CCR0             SFR_16BIT(0x0392)
+#define TA1CCR1             SFR_16BIT(0x0394)
+#define TA1CCR2             SFR_16BIT(0x0396)
+#define TA1EX0              SFR_16BIT(0x03A0)
+#define TA1IV               SFR_16BIT(0x03AE)
+
+#define TASSEL1             (0x0200)
+#define TASSEL0             (0x0100)
+#define ID1                 (0x0080)
+#define ID0                 (0x0040)
+#define MC1                 (0x0020)
+#define MC0                 (0x0010)
+#define TACLR               (0x0004)
+#define TAIE                (0x0002)
+#define TAIFG               (0x0001)
+
+#define MC_0                (0x0000)
+#define MC_1                (0x0010)
+#define MC_2                (0x0020)
+#define MC_3                (0x0030)
+#define TASSEL_0            (0x0000)
+#define TASSEL_1            (0x0100)
+#define TASSEL_2            (0x0200)
+#define TASSEL__TACLK       (0x0000)
+#define TASSEL__ACLK        (0x0100)
+#define TASSEL__SMCLK       (0x0200)
+
+#define CM1                 (0x8000)
+#define CM0                 (0x4000)
+#define CCIS1               (0x2000)
+#define CCIS0               (0x1000)
+#define SCS                 (0x0800)
+#define SCCI                (0x0400)
+#define CAP                 (0x0100)
+#define OUTMOD2             (0x0080)
+#define OUTMOD1             (0x0040)
+#define OUTMOD0             (0x0020)
+#define CCIE                (0x0010)
+#define CCI                 (0x0008)
+#define OUT                 (0x0004)
+#define COV                 (0x0002)
+#define CCIFG               (0x0001)
+
+#define OUTMOD_0            (0x0000)
+#define OUTMOD_1            (0x0020)
+#define OUTMOD_2            (0x0040)
+#define OUTMOD_3            (0x0060)
+#define OUTMOD_4            (0x0080)
+#define OUTMOD_5            (0x00A0)
+#define OUTMOD_6            (0x00C0)
+#define OUTMOD_7            (0x00E0)
+
+#define TA0IV_NONE          (0x0000)
+#define TA0IV_TA0CCR1       (0x0002)
+#define TA0IV_TA0CCR2       (0x0004)
+#define TA0IV_TA0CCR3       (0x0006)
+#define TA0IV_TA0CCR4       (0x0008)
+#define TA0IV_TA0IFG        (0x000E)
+
+// *************************************************************************************************
+// RTC_A (calendar mode)
+
+#define RTCCTL01            SFR_16BIT(0x04A0)
+#define RTCPS0CTL           SFR_16BIT(0x04A8)
+#define RTCPS1CTL           SFR_16BIT(0x04AA)
+#define RTCPS               SFR_16BIT(0x04AC)
+#define RT0PS               SFR_8BIT(0x04AC)
+#define RT1PS               SFR_8BIT(0x04AD)
+#define RTCIV               SFR_16BIT(0x04AE)
+#define RTCSEC              SFR_8BIT(0x04B0)
+#define RTCMIN              SFR_8BIT(0x04B1)
+#define RTCHOUR             SFR_8BIT(0x04B2)
+#define RTCDOW              SFR_8BIT(0x04B3)
+#define RTCDAY              SFR_8BIT(0x04B4)
+#define RTCMON              SFR_8BIT(0x04B5)
+#define RTCYEAR             SFR_16BIT(0x04B6)
+
+#define RTCBCD              (0x8000)
+#define RTCHOLD             (0x4000)
+#define RTCMODE             (0x2000)
+#define RTCRDY              (0x1000)
+#define RTCSSEL1            (0x0800)
+#define RTCSSEL0            (0x0400)
+#define RTCTEV1             (0x0200)
+#define RTCTEV0             (0x0100)
+#define RTCTEVIE            (0x0040)
+#define RTCAIE              (0x0020)
+#define RTCRDYIE            (0x0010)
+#define RTCTEVIFG           (0x0004)
+#define RTCAIFG             (0x0002)
+#define RTCRDYIFG           (0x0001)
+
+#define RTCTEV_0            (0x0000)	// Minute changed
+#define RTCTEV_1            (0x0100)	// Hour changed
+#define RTCTEV_2            (0x0200)	// Midnight
+#define RTCTEV_3            (0x0300)	// Noon
+
+#define RTC_NONE            (0x0000)
+#define RTC_RTCRDYIFG       (0x0002)
+#define RTC_RTCTEVIFG       (0x0004)
+#define RTC_RTCAIFG         (0x0006)
+#define RTC_RT0PSIFG        (0x0008)
+#define RTC_RT1PSIFG        (0x000A)
+
+// *************************************************************************************************
+// USCI_A0 (SPI mode)
+
+#define UCA0CTLW0           SFR_16BIT(0x05C0)
+#define UCA0CTL1            SFR_8BIT(0x05C0)
+#define UCA0CTL0            SFR_8BIT(0x05C1)
+#define UCA0BRW             SFR_16BIT(0x05C6)
+#define UCA0BR0             SFR_8BIT(0x05C6)
+#define UCA0BR1             SFR_8BIT(0x05C7)
+#define UCA0MCTL            SFR_8BIT(0x05C8)
+#define UCA0STAT            SFR_8BIT(0x05CA)
+#define UCA0RXBUF           SFR_8BIT(0x05CC)
+#define UCA0TXBUF           SFR_8BIT(0x05CE)
+#define UCA0IE              SFR_8BIT(0x05DC)
+#define UCA0IFG             SFR_8BIT(0x05DD)
+#define UCA0IV              SFR_16BIT(0x05DE)
+
+#define UCCKPH              (0x80)
+#define UCCKPL              (0x40)
+#define UCMSB               (0x20)
+#define UC7BIT              (0x10)
+#define UCMST               (0x08)
+#define UCMODE1             (0x04)
+#define UCMODE0             (0x02)
+#define UCSYNC              (0x01)
+#define UCSSEL1             (0x80)
+#define UCSSEL0             (0x40)
+#define UCSWRST             (0x01)
+#define UCSSEL__ACLK        (0x40)
+#define UCSSEL__SMCLK       (0x80)
+
+#define UCBUSY              (0x01)
+#define UCRXIE              (0x01)
+#define UCTXIE              (0x02)
+#define UCRXIFG             (0x01)
+#define UCTXIFG             (0x02)
+
+// *************************************************************************************************
+// ADC12_A
+
+#define ADC12CTL0           SFR_16BIT(0x0700)
+#define ADC12CTL1           SFR_16BIT(0x0702)
+#define ADC12CTL2           SFR_16BIT(0x0704)
+#define ADC12IFG            SFR_16BIT(0x070A)
+#define ADC12IE             SFR_16BIT(0x070C)
+#define ADC12IV             SFR_16BIT(0x070E)
+#define ADC12MCTL0          SFR_8BIT(0x0710)
+#define ADC12MEM0           SFR_16BIT(0x0720)
+
+#define ADC12SC             (0x0001)
+#define ADC12ENC            (0x0002)
+#define ADC12TOVIE          (0x0004)
+#define ADC12OVIE           (0x0008)
+#define ADC12ON             (0x0010)
+#define ADC12REFON          (0x0020)
+#define ADC12REF2_5V        (0x0040)
+#define ADC12MSC            (0x0080)
+
+#define ADC12SHT0_0         (0x0000)
+#define ADC12SHT0_1         (0x0100)
+#define ADC12SHT0_2         (0x0200)
+#define ADC12SHT0_3         (0x0300)
+#define ADC12SHT0_4         (0x0400)
+#define ADC12SHT0_5         (0x0500)
+#define ADC12SHT0_6         (0x0600)
+#define ADC12SHT0_7         (0x0700)
+#define ADC12SHT0_8         (0x0800)
+#define ADC12SHT0_9         (0x0900)
+#define ADC12SHT0_10        (0x0A00)
+#define ADC12SHT0_11        (0x0B00)
+#define ADC12SHT0_12        (0x0C00)
+
+#define ADC12BUSY           (0x0001)
+#define ADC12SHP            (0x0200)
+#define ADC12SSEL_0         (0x0000)
+#define ADC12SSEL_1         (0x0008)
+#define ADC12SSEL_2         (0x0010)
+#define ADC12SSEL_3         (0x0018)
+
+#define ADC12SR             (0x0004)
+#define ADC12RES_0          (0x0000)
+#define ADC12RES_1          (0x0010)
+#define ADC12RES_2          (0x0020)
+
+#define ADC12INCH_0         (0x0000)
+#define ADC12INCH_10        (0x000A)
+#define ADC12INCH_11        (0x000B)
+#define ADC12SREF_0         (0x0000)
+#define ADC12SREF_1         (0x0010)
+#define ADC12EOS            (0x0080)
+
+#define ADC12IFG0           (0x0001)
+#define ADC12IE0            (0x0001)
+
+// *************************************************************************************************
+// AES accelerator
+
+#define __MSP430_HAS_AES__
+
+#define AESACTL0            SFR_16BIT(0x09C0)
+#define AESASTAT            SFR_16BIT(0x09C4)
+#define AESAKEY             SFR_16BIT(0x09C6)
+#define AESADIN             SFR_16BIT(0x09C8)
+#define AESADOUT            SFR_16BIT(0x09CA)
+
+#define AESOP0              (0x0001)
+#define AESOP1              (0x0002)
+#define AESSWRST            (0x0080)
+#define AESRDYIFG           (0x0100)
+#define AESERRFG            (0x0800)
+#define AESRDYIE            (0x1000)
+
+#define AESBUSY             (0x0001)
+#define AESKEYWR            (0x0002)
+#define AESDINWR            (0x0004)
+#define AESDOUTRD           (0x0008)
+
+// *************************************************************************************************
+// LCD_B
+
+#define LCDBCTL0            SFR_16BIT(0x0A00)
+#define LCDBCTL1            SFR_16BIT(0x0A02)
+#define LCDBBLKCTL          SFR_16BIT(0x0A04)
+#define LCDBMEMCTL          SFR_16BIT(0x0A06)
+#define LCDBVCTL            SFR_16BIT(0x0A08)
+#define LCDBPCTL0           SFR_16BIT(0x0A0A)
+#define LCDBPCTL1           SFR_16BIT(0x0A0C)
+#define LCDBPCTL2           SFR_16BIT(0x0A0E)
+#define LCDBCPCTL           SFR_16BIT(0x0A12)
+#define LCDBIV              SFR_16BIT(0x0A1E)
+
+// LCD memory and blinking memory (LCDM1 / LCDBM1); direct pointer access bypasses sim_io
+#define LCDMEM              ((unsigned char *)&sim_mem[0x0A20])
+#define LCDBMEM             ((unsigned char *)&sim_mem[0x0A40])
+#define LCD_MEM_BASE        ((u8 *)LCDMEM)
+
+#define LCDON               (0x0001)
+#define LCDSON              (0x0004)
+#define LCDMX0              (0x0008)
+#define LCDMX1              (0x0010)
+#define LCDPRE0             (0x0100)
+#define LCDPRE1             (0x0200)
+#define LCDPRE2             (0x0400)
+#define LCDDIV0             (0x0800)
+#define LCDDIV1             (0x1000)
+#define LCDDIV2             (0x2000)
+#define LCDDIV3             (0x4000)
+#define LCDDIV4             (0x8000)
+#define LCD4MUX             (LCDMX1+LCDMX0)
+
+#define LCDBLKMOD0          (0x0001)
+#define LCDBLKMOD1          (0x0002)
+#define LCDBLKPRE0          (0x0004)
+#define LCDBLKPRE1          (0x0008)
+#define LCDBLKPRE2          (0x0010)
+#define LCDBLKDIV0          (0x0020)
+#define LCDBLKDIV1          (0x0040)
+#define LCDBLKDIV2          (0x0080)
+
+#define LCDDISP             (0x0001)
+#define LCDCLRM             (0x0002)
+#define LCDCLRBM            (0x0004)
+
+#define LCD2B               (0x0001)
+#define VLCDREF0            (0x0002)
+#define VLCDREF1            (0x0004)
+#define LCDCPEN             (0x0008)
+#define VLCDEXT             (0x0010)
+#define LCDEXTBIAS          (0x0020)
+#define R03EXT              (0x0040)
+#define LCDREXT             (0x0080)
+#define VLCD_2_72           (0x1200)
+
+// *************************************************************************************************
+// RF1A radio interface
+
+#define RF1AIFCTL0          SFR_16BIT(0x0F00)
+#define RF1AIFCTL1          SFR_16BIT(0x0F02)
+#define RF1AIFFLG           SFR_8BIT(0x0F02)
+#define RF1AIFIE            SFR_8BIT(0x0F03)
+#define RF1AIFERR           SFR_16BIT(0x0F06)
+#define RF1AIFERRV          SFR_16BIT(0x0F0C)
+#define RF1AIFIV            SFR_16BIT(0x0F0E)
+#define RF1AINSTRW          SFR_16BIT(0x0F10)
+#define RF1ADINB            SFR_8BIT(0x0F10)
+#define RF1AINSTRB          SFR_8BIT(0x0F11)
+#define RF1AINSTR1W         SFR_16BIT(0x0F12)
+#define RF1AINSTR1B         SFR_8BIT(0x0F13)
+#define RF1AINSTR2W         SFR_16BIT(0x0F14)
+#define RF1AINSTR2B         SFR_8BIT(0x0F15)
+#define RF1ADINW            SFR_16BIT(0x0F16)
+#define RF1ASTAT0W          SFR_16BIT(0x0F20)
+#define RF1ADOUT0B          SFR_8BIT(0x0F20)
+#define RF1ASTAT0B          SFR_8BIT(0x0F21)
+#define RF1ASTATW           SFR_16BIT(0x0F20)
+#define RF1ADOUTB           SFR_8BIT(0x0F20)
+#define RF1ASTATB           SFR_8BIT(0x0F21)
+#define RF1ASTAT1W          SFR_16BIT(0x0F22)
+#define RF1ADOUT1B          SFR_8BIT(0x0F22)
+#define RF1ASTAT1B          SFR_8BIT(0x0F23)
+#define RF1ASTAT2W          SFR_16BIT(0x0F24)
+#define RF1ADOUT2B          SFR_8BIT(0x0F24)
+#define RF1ASTAT2B          SFR_8BIT(0x0F25)
+#define RF1ADOUT0W          SFR_16BIT(0x0F28)
+#define RF1ADOUT1W          SFR_16BIT(0x0F2A)
+#define RF1ADOUT2W          SFR_16BIT(0x0F2C)
+#define RF1AIN              SFR_16BIT(0x0F30)
+#define RF1AIFG             SFR_16BIT(0x0F32)
+#define RF1AIES             SFR_16BIT(0x0F34)
+#define RF1AIE              SFR_16BIT(0x0F36)
+#define RF1AIV              SFR_16BIT(0x0F38)
+#define RF1ARXFIFO          SFR_16BIT(0x0F3C)
+#define RF1ATXFIFO          SFR_16BIT(0x0F3E)
+
+#define RFERRIFG            (0x0002)
+#define RFDINIFG            (0x0004)
+#define RFSTATIFG           (0x0008)
+#define RFDOUTIFG           (0x0010)
+#define RFINSTRIFG          (0x0080)
+
+#define RF1AIV_NONE         (0x0000)
+#define RF1AIV_RFIFG0       (0x0002)
+#define RF1AIV_RFIFG4       (0x000A)
+#define RF1AIV_RFIFG9       (0x0014)
+
+// Radio core command strobes and access flags
+#define RF_SRES             (0x30)
+#define RF_SFSTXON          (0x31)
+#define RF_SXOFF            (0x32)
+#define RF_SCAL             (0x33)
+#define RF_SRX              (0x34)
+#define RF_STX              (0x35)
+#define RF_SIDLE            (0x36)
+#define RF_SWOR             (0x38)
+#define RF_SPWD             (0x39)
+#define RF_SFRX             (0x3A)
+#define RF_SFTX             (0x3B)
+#define RF_SWORRST          (0x3C)
+#define RF_SNOP             (0x3D)
+#define RF_RXFIFORD         (0x3F)
+#define RF_TXFIFOWR         (0x3F)
+#define RF_SNGLREGRD        (0x80)
+#define RF_SNGLREGWR        (0x00)
+#define RF_REGRD            (0xC0)
+#define RF_REGWR            (0x40)
+#define RF_STATREGRD        (0xC0)
+#define RF_SNGLPATABRD      (RF_STATREGRD + 0x3E)
+#define RF_SNGLPATABWR      (0x3E)
+#define RF_PATABRD          (0xFE)
+#define RF_PATABWR          (0x7E)
+
+// Radio core configuration registers
+#define IOCFG2              (0x00)
+#define IOCFG1              (0x01)
+#define IOCFG0              (0x02)
+#define FIFOTHR             (0x03)
+#define SYNC1               (0x04)
+#define SYNC0               (0x05)
+#define PKTLEN              (0x06)
+#define PKTCTRL1            (0x07)
+#define PKTCTRL0            (0x08)
+#define ADDR                (0x09)
+#define CHANNR              (0x0A)
+#define FSCTRL1             (0x0B)
+#define FSCTRL0             (0x0C)
+#define FREQ2               (0x0D)
+#define FREQ1               (0x0E)
+#define FREQ0               (0x0F)
+#define MDMCFG4             (0x10)
+#define MDMCFG3             (0x11)
+#define MDMCFG2             (0x12)
+#define MDMCFG1             (0x13)
+#define MDMCFG0             (0x14)
+#define DEVIATN             (0x15)
+#define MCSM2               (0x16)
+#define MCSM1               (0x17)
+#define MCSM0               (0x18)
+#define FOCCFG              (0x19)
+#define BSCFG               (0x1A)
+#define AGCCTRL2            (0x1B)
+#define AGCCTRL1            (0x1C)
+#define AGCCTRL0            (0x1D)
+#define WOREVT1             (0x1E)
+#define WOREVT0             (0x1F)
+#define WORCTRL             (0x20)
+#define FREND1              (0x21)
+#define FREND0              (0x22)
+#define FSCAL3              (0x23)
+#define FSCAL2              (0x24)
+#define FSCAL1              (0x25)
+#define FSCAL0              (0x26)
+#define RCCTRL1             (0x27)
+#define RCCTRL0             (0x28)
+#define FSTEST              (0x29)
+#define PTEST               (0x2A)
+#define AGCTEST             (0x2B)
+#define TEST2               (0x2C)
+#define TEST1               (0x2D)
+#define TEST0               (0x2E)
+
+#define PARTNUM             (0x30)
+#define VERSION             (0x31)
+#define FREQEST             (0x32)
+#define LQI                 (0x33)
+#define RSSI                (0x34)
+#define MARCSTATE           (0x35)
+#define WORTIME1            (0x36)
+#define WORTIME0            (0x37)
+#define PKTSTATUS           (0x38)
+#define VCO_VC_DAC          (0x39)
+#define TXBYTES             (0x3A)
+#define RXBYTES             (0x3B)
+#define PATABLE             (0x3E)
+#define TXFIFO              (0x3F)
+#define RXFIFO              (0x3F)
+
+// *************************************************************************************************
+// Interrupt vectors (offset from 0xFF80, higher number = higher priority)
+
+#define AES_VECTOR          (46 * 2u)
+#define RTC_VECTOR          (47 * 2u)
+#define LCD_B_VECTOR        (48 * 2u)
+#define PORT2_VECTOR        (49 * 2u)
+#define PORT1_VECTOR        (50 * 2u)
+#define TIMER1_A1_VECTOR    (51 * 2u)
+#define TIMER1_A0_VECTOR    (52 * 2u)
+#define DMA_VECTOR          (53 * 2u)
+#define CC1101_VECTOR       (54 * 2u)
+#define TIMER0_A1_VECTOR    (55 * 2u)
+#define TIMER0_A0_VECTOR    (56 * 2u)
+#define ADC12_VECTOR        (57 * 2u)
+#define USCI_B0_VECTOR      (58 * 2u)
+#define USCI_A0_VECTOR      (59 * 2u)
+#define WDT_VECTOR          (60 * 2u)
+#define COMP_B_VECTOR       (61 * 2u)
+#define UNMI_VECTOR         (62 * 2u)
+#define SYSNMI_VECTOR       (63 * 2u)
+#define RESET_VECTOR        (64 * 2u)
+
+#endif // __CC430X613X_SIM_H
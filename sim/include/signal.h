@@ -0,0 +1,20 @@
+// *************************************************************************************************
+// Host simulation stand-in for the mspgcc <signal.h>.
+//
+// ISRs become plain functions; the simulator looks them up by name and calls them when the
+// corresponding interrupt flag is pending and enabled.
+// *************************************************************************************************
+
+#ifndef __SIGNAL_SIM_H
+#define __SIGNAL_SIM_H
+
+#define interrupt(vector)		void
+#define wakeup
+#define critical
+#define reentrant
+#define enablenested
+
+#define eint()					__enable_interrupt()
+#define dint()					__disable_interrupt()
+
+#endif // __SIGNAL_SIM_H
@@ -0,0 +1,549 @@
+// *************************************************************************************************
+// Host test of the information memory store (driver/infomem.c).
+//
+// infomem.c is compiled like firmware (sim/include register stand-in) and runs on the flash write
+// trapping of the simulator (sim/flash.c). This file supplies the flash controller: a RAM model
+// that programs and erases like the device, counts erases and can cut the power at any program or
+// erase step. A random workload of replace/modify/delete/relocate operations is checked against a
+// reference model. Every operation, including the background erase of stale segments, is then
+// repeated with the power cut at each of its flash steps, once with the step not done and once
+// torn (programming cleared only some bits, an erase set only some). After each power fail the
+// store is read back and must hold the content from before or after the operation, and must take
+// new records.
+//
+// make sim-test; exit status 0 if all checks passed
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "project.h"
+#include "infomem.h"
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+volatile void * sim_io(unsigned short addr, unsigned char size);
+void periph_flash_write(uint16_t addr, uint16_t len, const uint8_t * before);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Workload: operations, application identifiers 1..TEST_APPS, record sizes 1..TEST_MAX_COUNT
+#define TEST_OPS				(600u)
+#define TEST_APPS				(6u)
+#define TEST_MAX_COUNT			(14u)
+#define TEST_RELOCATE_EVERY		(97u)
+#define TEST_SEED				(0x1D5EEDu)
+
+// Written after each recovery to see that the store takes new records
+#define TEST_PROBE_ID			(0xEEu)
+
+// Old driver erased at least one segment per save, the log has to stay well below
+#define TEST_MAX_ERASES_PER_OP	(0.5)
+
+// Managed memory
+#define INFO_FIRST				(INFOMEM_D)
+#define INFO_BYTES				(INFOMEM_SEGMENT_COUNT * INFOMEM_SEGMENT_SIZE)
+
+// Payload that fits into one segment with a single record
+#define MODEL_WORDS				(INFOMEM_SEGMENT_WORDS - INFOMEM_HEADER_WORDS)
+
+enum op_kind { OP_REPLACE, OP_MODIFY, OP_DELETE, OP_RELOCATE };
+
+// Power fail at a flash step: step not done or torn
+enum cut_mode { CUT_NONE, CUT_SKIP, CUT_TORN };
+
+struct op
+{
+	enum op_kind	kind;
+	u8				id;
+	u8				count;
+	u8				offset;
+	u16				data[TEST_MAX_COUNT];
+	u16				start, end;
+};
+
+// Expected content of the store
+struct model
+{
+	u8				count[256];
+	u16				data[256][INFOMEM_APP_MAX_WORDS];
+};
+
+// Flash, driver state and expected content at an operation boundary
+struct snapshot
+{
+	uint8_t			flash[INFO_BYTES];
+	struct infomem	infomem;
+};
+
+
+// *************************************************************************************************
+// Global Variable section
+volatile s_request_flags request;
+
+static uint8_t regs[0x1000];
+
+static struct
+{
+	uint64_t		steps;					// Program and erase steps since the counter was cleared
+	uint64_t		erases;
+	uint64_t		words;
+	uint64_t		cut_at;					// Step the power fails at (0 = never)
+	enum cut_mode	cut_mode;
+	int				cut;					// Power is off, leave at the next register access
+} flash;
+
+static jmp_buf power_fail;
+static uint32_t lcg = TEST_SEED;
+static unsigned long failures;
+
+
+// *************************************************************************************************
+// Extern section
+extern struct infomem sInfomem;
+
+
+// *************************************************************************************************
+// @fn          test_rand
+// @brief       Deterministic pseudo random numbers (LCG), the run is the same every time.
+// @param       uint32_t range		Number of values
+// @return      uint32_t			0 .. range-1
+// *************************************************************************************************
+static uint32_t test_rand(uint32_t range)
+{
+	lcg = lcg * 1103515245u + 12345u;
+	return (lcg >> 8) % range;
+}
+
+
+// *************************************************************************************************
+// @fn          test_fail
+// @brief       Report a failed check. The run goes on to report further failures.
+// @param       const char * fmt	printf style message
+// @return      none
+// *************************************************************************************************
+static void __attribute__((format(printf, 1, 2))) test_fail(const char * fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "infomem-test: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	failures++;
+}
+
+
+// *************************************************************************************************
+// @fn          sim_io
+// @brief       Register access of infomem.c. Flash status is never busy. After a power fail the
+//				driver is left at its next register access, every flash step waits for BUSY.
+// @param       unsigned short addr		Register address
+//				unsigned char size		Access width in bytes
+// @return      volatile void *			Register backing store
+// *************************************************************************************************
+volatile void * sim_io(unsigned short addr, unsigned char size)
+{
+	(void)size;
+	if (flash.cut) longjmp(power_fail, 1);
+	return &regs[addr];
+}
+
+
+// *************************************************************************************************
+// @fn          periph_flash_write
+// @brief       Flash controller model, called by sim/flash.c for every firmware write to flash.
+// @param       uint16_t addr			Segment address
+//				uint16_t len			Segment size
+//				const uint8_t * before	Segment content before the write
+// @return      none
+// *************************************************************************************************
+void periph_flash_write(uint16_t addr, uint16_t len, const uint8_t * before)
+{
+	uint8_t * seg = (uint8_t *)(uintptr_t)addr;
+	uint16_t fctl1 = regs[0x0140] | (regs[0x0141] << 8);
+	uint16_t fctl3 = regs[0x0144] | (regs[0x0145] << 8);
+	uint16_t fctl4 = regs[0x0146] | (regs[0x0147] << 8);
+	uint16_t i, bytes = 0;
+	int torn;
+
+	if ((fctl3 & LOCK) || (fctl4 & LOCKINFO) || !(fctl1 & (ERASE | WRT | BLKWRT)))
+	{
+		test_fail("flash write at 0x%04X while locked or not in program/erase mode", addr);
+		memcpy(seg, before, len);
+		return;
+	}
+
+	flash.steps++;
+	torn = (flash.steps == flash.cut_at) && (flash.cut_mode == CUT_TORN);
+	if ((flash.steps == flash.cut_at) && (flash.cut_mode == CUT_SKIP))
+	{
+		memcpy(seg, before, len);
+	}
+	else if (fctl1 & ERASE)
+	{
+		// A torn erase has set only some bits
+		for (i = 0; i < len; i++) seg[i] = torn ? (before[i] | (uint8_t)test_rand(256)) : 0xFF;
+		flash.erases++;
+	}
+	else
+	{
+		// Programming can only clear bits, a torn write has cleared only some of them
+		for (i = 0; i < len; i++)
+		{
+			if (seg[i] == before[i]) continue;
+			if (seg[i] & ~before[i]) test_fail("flash write at 0x%04X sets bits", addr + i);
+			seg[i] = before[i] & (torn ? (seg[i] | (uint8_t)test_rand(256)) : seg[i]);
+			bytes++;
+		}
+		flash.words += (bytes + 1) / 2;
+	}
+
+	if (flash.steps == flash.cut_at) flash.cut = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          snapshot_save / snapshot_load
+// @brief       Keep and restore the information memory and the driver state.
+// *************************************************************************************************
+static void snapshot_save(struct snapshot * s)
+{
+	memcpy(s->flash, (void *)(uintptr_t)INFO_FIRST, INFO_BYTES);
+	s->infomem = sInfomem;
+}
+
+
+static void snapshot_load(const struct snapshot * s)
+{
+	mprotect((void *)(uintptr_t)FLASH_START, 0x1000, PROT_READ | PROT_WRITE);
+	memcpy((void *)(uintptr_t)INFO_FIRST, s->flash, INFO_BYTES);
+	mprotect((void *)(uintptr_t)FLASH_START, 0x1000, PROT_READ);
+	sInfomem = s->infomem;
+	request.flag.infomem = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          model_apply
+// @brief       Apply an operation to the reference model.
+// @param       struct model * m	Expected content
+//				const struct op * op
+// @return      s16					Expected return value of the driver (relocate: 0)
+// *************************************************************************************************
+static s16 model_apply(struct model * m, const struct op * op)
+{
+	u16 i, old = m->count[op->id], apps = 0, size = 0, count;
+
+	for (i = 0; i < 256; i++)
+	{
+		if (m->count[i] == 0) continue;
+		apps++;
+		size += m->count[i] + INFOMEM_RECORD_WORDS;
+	}
+	if (old) size -= old + INFOMEM_RECORD_WORDS;
+
+	switch (op->kind)
+	{
+		case OP_REPLACE:
+			if ((op->count > INFOMEM_APP_MAX_WORDS) || (size + op->count + INFOMEM_RECORD_WORDS > MODEL_WORDS) ||
+				(!old && apps >= INFOMEM_MAX_APPS)) return -4;
+			m->count[op->id] = op->count;
+			memcpy(m->data[op->id], op->data, op->count * 2);
+			return size + op->count + INFOMEM_RECORD_WORDS;
+
+		case OP_MODIFY:
+			if (!old) return 0;
+			if (op->offset > old) return -3;
+			count = (op->offset + op->count > old) ? op->offset + op->count : old;
+			if ((count > INFOMEM_APP_MAX_WORDS) || (size + count + INFOMEM_RECORD_WORDS > MODEL_WORDS)) return -4;
+			m->count[op->id] = count;
+			memcpy(&m->data[op->id][op->offset], op->data, op->count * 2);
+			return count;
+
+		case OP_DELETE:
+			if (!old) return 0;
+			if (op->offset >= old) return -3;
+			m->count[op->id] = op->offset;
+			return size + (op->offset ? op->offset + INFOMEM_RECORD_WORDS : 0);
+
+		default:
+			return 0;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          model_check
+// @brief       Compare the content of the store with the model.
+// @param       const struct model * m	Expected content
+// @return      int						1 = same
+// *************************************************************************************************
+static int model_check(const struct model * m)
+{
+	u16 data[INFOMEM_APP_MAX_WORDS];
+	u16 i, size = 0;
+
+	for (i = 0; i < 256; i++)
+	{
+		if (infomem_app_amount(i) != m->count[i]) return 0;
+		if (m->count[i] == 0) continue;
+		if (infomem_app_read(i, data, m->count[i], 0) != m->count[i]) return 0;
+		if (memcmp(data, m->data[i], m->count[i] * 2) != 0) return 0;
+		size += m->count[i] + INFOMEM_RECORD_WORDS;
+	}
+	return infomem_space() == MODEL_WORDS - size;
+}
+
+
+// *************************************************************************************************
+// @fn          op_make
+// @brief       Next operation of the workload.
+// @param       u16 n				Operation number
+//				const struct model * m	Current content
+//				struct op * op
+// @return      none
+// *************************************************************************************************
+static void op_make(u16 n, const struct model * m, struct op * op)
+{
+	// INFO A, B and C, INFO D holds the calibration record
+	static const u16 ranges[][2] =
+	{
+		{ INFOMEM_B, INFOMEM_A + INFOMEM_SEGMENT_SIZE },
+		{ INFOMEM_C, INFOMEM_A + INFOMEM_SEGMENT_SIZE },
+		{ INFOMEM_C, INFOMEM_A },
+	};
+	u8 i, kind = test_rand(20);
+
+	memset(op, 0, sizeof(*op));
+	op->id = 1 + test_rand(TEST_APPS);
+	op->count = 1 + test_rand(TEST_MAX_COUNT);
+	for (i = 0; i < op->count; i++) op->data[i] = (u16)test_rand(0x10000);
+
+	if (n % TEST_RELOCATE_EVERY == TEST_RELOCATE_EVERY - 1)
+	{
+		op->kind  = OP_RELOCATE;
+		op->start = ranges[n / TEST_RELOCATE_EVERY % 3][0];
+		op->end   = ranges[n / TEST_RELOCATE_EVERY % 3][1];
+	}
+	else if (kind < 8)
+	{
+		op->kind = OP_REPLACE;
+	}
+	else if (kind < 15)
+	{
+		op->kind = OP_MODIFY;
+		op->offset = test_rand(m->count[op->id] + 1);
+	}
+	else
+	{
+		op->kind = OP_DELETE;
+		op->offset = test_rand(m->count[op->id] + 1);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          op_run
+// @brief       Run an operation on the driver and the background erase that may follow it, as
+//				process_requests() would.
+// @param       const struct op * op
+// @return      s16		Return value of the driver
+// *************************************************************************************************
+static s16 op_run(const struct op * op)
+{
+	s16 ret;
+
+	switch (op->kind)
+	{
+		case OP_REPLACE:	ret = infomem_app_replace(op->id, (u16 *)op->data, op->count); break;
+		case OP_MODIFY:		ret = infomem_app_modify(op->id, (u16 *)op->data, op->count, op->offset); break;
+		case OP_DELETE:		ret = infomem_app_delete(op->id, op->offset); break;
+		default:			ret = infomem_relocate(op->start, op->end); break;
+	}
+
+	if (request.flag.infomem)
+	{
+		request.flag.infomem = 0;
+		infomem_erase_stale();
+	}
+	return ret;
+}
+
+
+// *************************************************************************************************
+// @fn          reboot
+// @brief       Power up: driver state is lost, the store is read back from flash.
+// @param       none
+// @return      s16		infomem_ready()
+// *************************************************************************************************
+static s16 reboot(void)
+{
+	memset(&sInfomem, 0, sizeof(sInfomem));
+	request.flag.infomem = 0;
+	return infomem_ready();
+}
+
+
+// *************************************************************************************************
+// @fn          cut_check
+// @brief       Run an operation with the power failing at one flash step, then check what the
+//				next power up finds.
+// @param       u16 n				Operation number
+//				const struct op * op
+//				uint64_t step		Flash step of the operation (1 = first)
+//				enum cut_mode mode
+//				const struct model * before / after	Content before and after the operation
+// @return      none
+// *************************************************************************************************
+static void cut_check(u16 n, const struct op * op, uint64_t step, enum cut_mode mode,
+					  const struct model * before, const struct model * after)
+{
+	static const char * const mode_names[] = { "", "skipped", "torn" };
+	struct model m;
+	const struct model * found;
+	u16 probe = (u16)n;
+	s16 ret;
+
+	flash.steps    = 0;
+	flash.cut_at   = step;
+	flash.cut_mode = mode;
+	flash.cut      = 0;
+	if (setjmp(power_fail) == 0)
+	{
+		op_run(op);
+		flash.cut_at = 0;
+		test_fail("op %u: power fail at step %llu not reached", n, (unsigned long long)step);
+		return;
+	}
+	flash.cut_at = 0;
+	flash.cut    = 0;
+
+	ret = reboot();
+	if (ret < 0)
+	{
+		test_fail("op %u: step %llu %s: infomem_ready() = %d", n, (unsigned long long)step,
+				  mode_names[mode], ret);
+		return;
+	}
+	found = model_check(before) ? before : (model_check(after) ? after : NULL);
+	if (found == NULL)
+	{
+		test_fail("op %u: step %llu %s: content is neither before nor after", n,
+				  (unsigned long long)step, mode_names[mode]);
+		return;
+	}
+
+	// Background erase, a new record and the next power up
+	m = *found;
+	if (request.flag.infomem) infomem_erase_stale();
+	if (infomem_space() >= 1 + INFOMEM_RECORD_WORDS)
+	{
+		infomem_app_replace(TEST_PROBE_ID, &probe, 1);
+		m.count[TEST_PROBE_ID] = 1;
+		m.data[TEST_PROBE_ID][0] = probe;
+	}
+	if ((reboot() < 0) || !model_check(&m))
+	{
+		test_fail("op %u: step %llu %s: store lost content after recovery", n,
+				  (unsigned long long)step, mode_names[mode]);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          main
+// @brief       Run the workload and the power fail checks.
+// @param       none
+// @return      0 if all checks passed
+// *************************************************************************************************
+int main(void)
+{
+	static struct model before, after;
+	static struct snapshot snap_before, snap_after;
+	struct op op;
+	uint64_t steps, step, erases = 0, words = 0, cuts = 0, compactions = 0;
+	uint8_t * cal;
+	s16 ret, expected;
+	u16 n;
+
+	// Calibration record in INFO D, the store must leave it alone
+	sim_flash_map();
+	cal = (uint8_t *)(uintptr_t)INFOMEM_D;
+	memcpy(cal, "\x01\x00\x00\x00\x00\x00\x79\x56\x34\x12\x00\x00\x01", 13);
+	sim_flash_protect();
+
+	if (infomem_ready() != -2) test_fail("blank memory is not reported as missing");
+	if (infomem_init(INFOMEM_C, INFOMEM_C + 2 * INFOMEM_SEGMENT_SIZE) != MODEL_WORDS) test_fail("infomem_init failed");
+	memset(&before, 0, sizeof(before));
+
+	for (n = 0; n < TEST_OPS; n++)
+	{
+		op_make(n, &before, &op);
+		after = before;
+		expected = model_apply(&after, &op);
+
+		// Clean run
+		snapshot_save(&snap_before);
+		flash.steps = 0;
+		flash.erases = 0;
+		flash.words = 0;
+		ret = op_run(&op);
+		steps = flash.steps;
+		erases += flash.erases;
+		words += flash.words;
+		if (flash.erases && (op.kind != OP_RELOCATE)) compactions++;
+
+		if ((op.kind == OP_RELOCATE) ? (ret != MODEL_WORDS && ret != -5) : (ret != expected))
+		{
+			test_fail("op %u: returned %d, expected %d", n, ret, expected);
+		}
+		if (!model_check(&after)) test_fail("op %u: content differs from the model", n);
+		if ((reboot() < 0) || !model_check(&after)) test_fail("op %u: content lost by power up", n);
+		snapshot_save(&snap_after);
+
+		// Same operation with the power failing at every flash step
+		for (step = 1; step <= steps; step++)
+		{
+			snapshot_load(&snap_before);
+			cut_check(n, &op, step, CUT_SKIP, &before, &after);
+			snapshot_load(&snap_before);
+			cut_check(n, &op, step, CUT_TORN, &before, &after);
+			cuts += 2;
+		}
+
+		snapshot_load(&snap_after);
+		before = after;
+	}
+
+	if (memcmp(cal, "\x01\x00\x00\x00\x00\x00\x79\x56\x34\x12\x00\x00\x01", 13) != 0)
+	{
+		test_fail("calibration record in INFO D was changed");
+	}
+	if ((double)erases / TEST_OPS > TEST_MAX_ERASES_PER_OP)
+	{
+		test_fail("%llu erases for %u operations", (unsigned long long)erases, TEST_OPS);
+	}
+
+	printf("\n=== infomem-test ===\n");
+	printf("%-24s %12u\n", "operations", TEST_OPS);
+	printf("%-24s %12llu  (%llu operations erased)\n", "flash segment erases", (unsigned long long)erases,
+		   (unsigned long long)compactions);
+	printf("%-24s %12llu\n", "flash words written", (unsigned long long)words);
+	printf("%-24s %12llu  (every program/erase step, skipped and torn)\n", "power fails",
+		   (unsigned long long)cuts);
+	printf("%-24s %12lu\n", "failed checks", failures);
+	return failures ? 1 : 0;
+}
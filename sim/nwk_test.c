@@ -0,0 +1,1969 @@
+// *************************************************************************************************
+// Host test of the SimpliciTI end device (main_ED_BM.c) on the real network stack (nwk/,
+// nwk_applications/).
+//
+// The simulator runs the firmware against sim/rf.c, a stand-in for main_ED_BM.c, so the network
+// stack itself never runs there. Here main_ED_BM.c and the NWK sources are linked as they are and
+// only the radio driver (MRFI) is replaced: a stub with the state machine, clear channel assessment,
+// reply delay and receive interrupt path of mrfi_radio.c on a virtual ACLK clock. Frames go over
+// the air to a scripted access point that answers join, link, frequency and sync frames like the
+// access point does. Each test links and syncs through the public entry points and checks what
+// arrived at the access point and what the stack reported to the application callbacks.
+//
+// Built a second time with SMPL_SECURE (nwk-secure-test): frames are then secured on a model of the
+// AES accelerator in both directions, and every secured frame is also checked against a reference
+// CTR / CMAC built here on the block cipher of the simulator.
+//
+// make sim-test; exit status 0 if all checks passed
+// *************************************************************************************************
+
+
+// *************************************************************************************************
+// Include section
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+#include "bsp.h"
+#include "mrfi.h"
+#include "nwk_types.h"
+#include "nwk_api.h"
+#include "nwk_frame.h"
+#include "nwk.h"
+#include "nwk_join.h"
+#include "nwk_link.h"
+#include "nwk_freq.h"
+#include "simpliciti.h"
+#include "rfsimpliciti.h"
+#include "sim.h"
+#ifdef SMPL_SECURE
+#include "nwk_security.h"
+#endif
+
+
+// *************************************************************************************************
+// Prototypes section
+volatile void * sim_io(unsigned short addr, unsigned char size);
+u8 Timer0_A4_DelayUntil(u16 ticks, volatile u8 * flag, u8 mask);
+
+
+// *************************************************************************************************
+// Defines section
+
+// Air time at 76.8 kBaud: preamble and sync word, length byte, frame, CRC
+#define RADIO_AIR_BYTES(p)		((p)->frame[0] + 1u + 8u + 2u)
+#define RADIO_AIR_TICKS(p)		((sim_time_t)RADIO_AIR_BYTES(p) * 8u * SIM_ACLK_HZ / 76800u + 1u)
+
+// Reply delay as MRFI_Init computes it for 76.8 kBaud and the largest frame (msec)
+#define MRFI_BACKOFF_PERIOD_USECS	__mrfi_BACKOFF_PERIOD_USECS__
+#define RADIO_REPLY_DELAY_MS	(PLATFORM_FACTOR_CONSTANT + 7u)
+
+// One CCA backoff period as MRFI_Init sets it up (1.25 msec)
+#define RADIO_BACKOFF_TICKS		(SIM_MS(125) / 100u)
+
+// Radio FIFO: length byte, frame and the two status bytes appended on receive
+#define RADIO_FIFO_BYTES		(64u)
+
+// Frames on the air at the same time, commands the access point holds
+#define AIR_FRAMES				(16u)
+#define AP_COMMANDS				(8u)
+
+// Access point: time from the end of a received frame to the start of its answer
+#define AP_TURNAROUND			(SIM_MS(1))
+#define AP_PORT					(PORT_BASE_NUMBER)
+#define AP_JOIN_TOKEN			(DEFAULT_JOIN_TOKEN)
+#define AP_LINK_TOKEN			(DEFAULT_LINK_TOKEN)
+
+// Answer of the access point to a channel move request
+#define AP_MOVE_FOLLOW			(0u)	// broadcast the move, then move
+#define AP_MOVE_SILENT			(1u)	// move, broadcast lost
+#define AP_MOVE_IGNORE			(2u)	// stay
+
+// Link quality callback: RSSI from which the lowest output power is enough
+#define TEST_RSSI_GOOD			(-60)
+#define TEST_RSSI_NEAR			(-45)
+#define TEST_RSSI_FAR			(-85)
+#define TEST_LQI				(45u)
+#define TEST_SEED				(0x4E57u)
+
+#ifdef SMPL_SECURE
+#define TEST_NAME				"nwk-secure-test"
+
+// AES accelerator registers
+#define R_AESACTL0				(0x09C0)
+#define R_AESASTAT				(0x09C4)
+#define R_AESAKEY				(0x09C6)
+#define R_AESADIN				(0x09C8)
+#define R_AESADOUT				(0x09CA)
+
+// Key and initialization vector both ends of a link are built with (nwk_security.c)
+#define TEST_KEY				"SimpliciTI's Key"
+#define TEST_IV					(0x87654321u)
+#else
+#define TEST_NAME				"nwk-test"
+#endif
+
+
+// *************************************************************************************************
+// Global Variable section
+
+// Firmware side of the SimpliciTI interface (logic/rfsimpliciti.c)
+unsigned char simpliciti_data[SIMPLICITI_MAX_PAYLOAD_LENGTH];
+unsigned char simpliciti_flag;
+unsigned char simpliciti_ed_address[4] = THIS_DEVICE_ADDRESS;
+unsigned char simpliciti_payload_length;
+unsigned char simpliciti_reply_count;
+unsigned int  simpliciti_bulk_packets;
+
+// Virtual time (ACLK ticks) and the point at which a test is stopped
+static sim_time_t now;
+static sim_time_t deadline;
+
+// Status register, only GIE is used
+static unsigned short sr;
+
+// Register page, written and read back
+static unsigned char regs[0x1000];
+
+#ifdef SMPL_SECURE
+// AES accelerator: encryption with a 128-bit key, a block is done as soon as its last word is in.
+// A register write takes effect at the next register access, like in the simulator.
+static struct
+{
+	uint8_t			key[16];
+	uint8_t			din[16];
+	uint8_t			dout[16];
+	uint8_t			key_pos;
+	uint8_t			din_pos;
+	uint8_t			dout_pos;
+	unsigned short	pending;		// register accessed last, 0 = none
+	unsigned long	blocks;
+} aes;
+
+// Secured frames checked against the reference
+static unsigned long sec_checked;
+#endif
+
+// A frame on its way from the access point to the watch. 'at' is the end of the frame.
+typedef struct
+{
+	uint8_t			used;
+	uint8_t			latched;		// received while interrupts were disabled
+	uint8_t			chan;
+	uint8_t			crc_ok;
+	int8_t			rssi;
+	uint8_t			lqi;
+	sim_time_t		at;
+	mrfiPacket_t	pkt;
+} air_t;
+static air_t air[AIR_FRAMES];
+
+// MRFI stub
+static struct
+{
+	uint8_t			state;			// MRFI_RADIO_STATE_*
+	uint8_t			wor;			// Wake-on-Radio: sleeps, but frames are received like in RX
+	uint8_t			chan;
+	uint8_t			level;			// MRFI_SetRFPwr
+	uint8_t			filter[NET_ADDR_SIZE];
+	uint8_t			filter_on;
+	uint8_t			busy[MRFI_NUM_LOGICAL_CHANS];	// percent of failing clear channel assessments
+	uint8_t			cca_fails;
+	int8_t			cca_rssi;
+	volatile uint8_t kill_sem;
+	uint8_t			reply_ctx;
+	mrfiPacket_t	own;			// receive buffer if the stack has none free
+	mrfiPacket_t *	rx;				// where the last frame was received to
+	unsigned long	pwr_sets;
+	unsigned long	tx_frames;
+	unsigned long	rx_frames;
+	unsigned long	lost;			// not listening, other channel or own transmission
+} radio;
+
+// Scripted access point
+static struct
+{
+	uint8_t			on;
+	uint8_t			addr[NET_ADDR_SIZE];
+	uint8_t			chan;
+	uint32_t		join_token;
+	uint32_t		link_token;
+	int8_t			rssi;			// signal at the watch
+	uint8_t			lqi;
+	sim_time_t		air_free;		// end of the last frame sent
+	uint8_t			tid;
+	// Link
+	uint8_t			linked;
+	uint8_t			ed_addr[NET_ADDR_SIZE];
+	uint8_t			ed_port;
+	// Commands sent one per ready-to-receive packet
+	uint8_t			cmd[AP_COMMANDS][BM_SYNC_DATA_LENGTH];
+	uint8_t			cmds;
+	uint8_t			cmd_next;
+	// Received
+	unsigned long	joins;
+	unsigned long	links;
+	unsigned long	link_dups;
+	unsigned long	pings;
+	unsigned long	started;
+	unsigned long	r2r;
+	unsigned long	status;
+	uint8_t			status_level;	// output power of the last status frame
+	unsigned long	frames;
+	unsigned long	sent;
+	// Channel move
+	uint8_t			move_mode;		// AP_MOVE_*
+	uint8_t			move_drop;		// requests lost on the air
+	unsigned long	move_reqs;
+	// Bulk download
+	uint16_t		bulk_next;		// first frame missing
+	uint8_t			bulk_got;		// bit j = frame bulk_next+1+j received
+	int16_t			bulk_drop;		// frame lost once on the air, -1 = none
+	unsigned long	bulk_frames;
+	unsigned long	bulk_dups;
+	unsigned long	bulk_bad;
+	unsigned long	bulk_acks;
+#ifdef SMPL_SECURE
+	// Frame counters of the link
+	uint32_t		tx_ctr;
+	uint32_t		rx_ctr;
+#endif
+} ap;
+
+// Link quality callback
+static struct
+{
+	unsigned long	events[4];
+	int8_t			rssi;
+	uint8_t			lqi;
+	uint8_t			level;
+} lq;
+
+// Channel callback
+static struct
+{
+	uint8_t			to;				// channel to ask for, SIMPLICITI_CHANNELS = stay
+	unsigned long	frames[SIMPLICITI_CHANNELS];
+	unsigned long	fails[SIMPLICITI_CHANNELS];
+} agility = { SIMPLICITI_CHANNELS };
+
+// Link cache callbacks
+static struct
+{
+	uint8_t			data[64];
+	uint8_t			len;
+	unsigned long	stores;
+} cache;
+
+static uint32_t lcg = TEST_SEED;
+static unsigned long failures;
+static const char * test_name;
+static sim_time_t air_time;
+static u8 race;						// next critical section of the stack: a frame arrives in it
+
+
+// *************************************************************************************************
+// Extern section
+extern uint8_t sInit_done;
+
+
+// *************************************************************************************************
+// @fn          test_rand
+// @brief       Deterministic pseudo random numbers, same sequence on every host.
+// @param       uint32_t range		Number of values (0 = full 32 bits)
+// @return      uint32_t			0 .. range-1
+// *************************************************************************************************
+static uint32_t test_rand(uint32_t range)
+{
+	uint32_t r;
+
+	lcg = lcg * 1103515245u + 12345u;
+	r = lcg >> 8;
+	lcg = lcg * 1103515245u + 12345u;
+	r = (r << 16) ^ (lcg >> 8);
+	return range ? r % range : r;
+}
+
+
+// *************************************************************************************************
+// @fn          test_fail
+// @brief       Report a failed check.
+// @param       const char * fmt	printf style message
+// @return      none
+// *************************************************************************************************
+static void __attribute__((format(printf, 1, 2))) test_fail(const char * fmt, ...)
+{
+	va_list args;
+
+	fprintf(stderr, TEST_NAME ": %s: ", test_name);
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputc('\n', stderr);
+	failures++;
+}
+
+
+// *************************************************************************************************
+// Status register and register page
+
+static air_t * air_next(sim_time_t until);
+static u8 radio_listens(u8 chan);
+void sim_bic_sr(unsigned short bits)
+{
+	air_t * f;
+
+	sr &= ~bits;
+
+	// Frame ends on the air while the stack holds interrupts off: latched, received on enable
+	if ((bits & GIE) && race && (f = air_next(~(sim_time_t)0)) != 0 && radio_listens(f->chan))
+	{
+		race = 0;
+		if (f->at > now) now = f->at;
+		f->latched = 1;
+	}
+}
+
+static void radio_eint(void);
+void sim_bis_sr(unsigned short bits)
+{
+	unsigned short was = sr;
+
+	sr |= bits;
+	if (!(was & GIE) && (sr & GIE)) radio_eint();
+}
+
+istate_t __get_interrupt_state(void)
+{
+	return sr;
+}
+
+void __set_interrupt_state(istate_t state)
+{
+	if (state & GIE) sim_bis_sr(GIE);
+	else sim_bic_sr(GIE);
+}
+
+#ifdef SMPL_SECURE
+// *************************************************************************************************
+// @fn          aes_write
+// @brief       A word written to the key or data input of the AES accelerator. The 8th data word
+//				starts the block.
+// @param       unsigned short addr	Register
+// @return      none
+// *************************************************************************************************
+static void aes_write(unsigned short addr)
+{
+	uint8_t * dst = (addr == R_AESAKEY) ? aes.key : aes.din;
+	uint8_t * pos = (addr == R_AESAKEY) ? &aes.key_pos : &aes.din_pos;
+
+	if (*pos >= 16) *pos = 0;
+	dst[(*pos)++] = regs[addr];
+	dst[(*pos)++] = regs[addr + 1];
+
+	if (addr == R_AESADIN && aes.din_pos == 16)
+	{
+		if (aes.key_pos != 16) test_fail("AES block started without a complete key");
+		sim_aes_encrypt(aes.key, aes.din, aes.dout);
+		aes.din_pos  = 0;
+		aes.dout_pos = 0;
+		aes.blocks++;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          aes_access
+// @brief       Register access to the AES accelerator: the previous access takes effect, status and
+//				output are put in place for a read.
+// @param       unsigned short addr	Register
+// @return      none
+// *************************************************************************************************
+static void aes_access(unsigned short addr)
+{
+	unsigned short stat = 0;
+
+	switch (aes.pending)
+	{
+		case R_AESACTL0:
+			if (regs[R_AESACTL0] & AESSWRST)
+			{
+				aes.key_pos  = 0;
+				aes.din_pos  = 0;
+				aes.dout_pos = 16;
+				regs[R_AESACTL0] = 0;
+			}
+			else if (regs[R_AESACTL0] & (AESOP0 | AESOP1)) test_fail("AES accelerator: only encryption is modelled");
+			break;
+
+		case R_AESAKEY:
+		case R_AESADIN:
+			aes_write(aes.pending);
+			break;
+	}
+	aes.pending = (addr >= R_AESACTL0 && addr <= R_AESADOUT) ? addr : 0;
+
+	if (addr == R_AESASTAT)
+	{
+		if (aes.key_pos == 16) stat |= AESKEYWR;
+		if (aes.dout_pos == 16) stat |= AESDOUTRD;
+		regs[R_AESASTAT]     = (uint8_t)stat;
+		regs[R_AESASTAT + 1] = 0;
+	}
+	else if (addr == R_AESADOUT)
+	{
+		if (aes.dout_pos >= 16) test_fail("AESADOUT read without a new result");
+		else
+		{
+			regs[R_AESADOUT]     = aes.dout[aes.dout_pos++];
+			regs[R_AESADOUT + 1] = aes.dout[aes.dout_pos++];
+		}
+	}
+}
+#endif
+
+volatile void * sim_io(unsigned short addr, unsigned char size)
+{
+	addr &= 0x0FFFu;
+#ifdef SMPL_SECURE
+	aes_access(addr);
+#endif
+	return &regs[addr];
+}
+
+
+// *************************************************************************************************
+// Air
+
+// *************************************************************************************************
+// @fn          air_alloc
+// @brief       Free entry for a frame on the air.
+// @param       none
+// @return      air_t *				Cleared entry
+// *************************************************************************************************
+static air_t * air_alloc(void)
+{
+	u8 i;
+
+	for (i = 0; i < AIR_FRAMES; i++)
+	{
+		if (!air[i].used)
+		{
+			memset(&air[i], 0, sizeof(air[i]));
+			air[i].used = 1;
+			return &air[i];
+		}
+	}
+	test_fail("more than %u frames on the air", AIR_FRAMES);
+	exit(1);
+}
+
+
+// *************************************************************************************************
+// @fn          air_next
+// @brief       Next frame that ends on the air until a given time, latched ones excluded.
+// @param       sim_time_t until	End of the period
+// @return      air_t *				Earliest frame, 0 if none
+// *************************************************************************************************
+static air_t * air_next(sim_time_t until)
+{
+	air_t * f = 0;
+	u8 i;
+
+	for (i = 0; i < AIR_FRAMES; i++)
+	{
+		if (air[i].used && !air[i].latched && air[i].at <= until && (!f || air[i].at < f->at)) f = &air[i];
+	}
+	return f;
+}
+
+
+// *************************************************************************************************
+// @fn          radio_listens
+// @brief       The radio receives frames on the given channel.
+// @param       u8 chan				Channel of the frame
+// @return      u8					1 = frame is received
+// *************************************************************************************************
+static u8 radio_listens(u8 chan)
+{
+	return (radio.state == MRFI_RADIO_STATE_RX) && (chan == radio.chan);
+}
+
+
+// *************************************************************************************************
+// @fn          radio_isr
+// @brief       Receive path of the radio ISR in mrfi_radio.c: frame goes into the buffer the stack
+//				offers (MRFI_RxBufferISR) or the driver's own, CRC and address filter are checked,
+//				metrics converted and MRFI_RxCompleteISR is called. Runs with interrupts disabled.
+// @param       air_t * f			Received frame
+// @return      none
+// *************************************************************************************************
+static void radio_isr(air_t * f)
+{
+	unsigned short s = sr;
+	mrfiPacket_t * p;
+	uint8_t * dst;
+
+	sr &= ~GIE;
+	f->used = 0;
+
+	p = MRFI_RxBufferISR();
+	if (!p) p = &radio.own;
+	radio.rx = p;
+	memcpy(p->frame, f->pkt.frame, sizeof(p->frame));
+	p->rxMetrics[MRFI_RX_METRICS_RSSI_OFS]    = (uint8_t)f->rssi;
+	p->rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] = f->lqi | (f->crc_ok ? 0x80 : 0);
+
+	dst = MRFI_P_DST_ADDR(p);
+	if (f->crc_ok && (!radio.filter_on || !memcmp(dst, radio.filter, NET_ADDR_SIZE) ||
+					  !memcmp(dst, mrfiBroadcastAddr, NET_ADDR_SIZE)))
+	{
+		p->rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] &= 0x7F;
+		radio.rx_frames++;
+		MRFI_RxCompleteISR();
+	}
+
+	// Wake-on-Radio goes back to sniffing, RX state stays
+	sr = s;
+}
+
+
+// *************************************************************************************************
+// @fn          air_arrive
+// @brief       A frame ends on the air. Received if the radio listens on its channel, with
+//				interrupts disabled the interrupt is held until they are enabled again.
+// @param       air_t * f			Frame
+// @return      none
+// *************************************************************************************************
+static void air_arrive(air_t * f)
+{
+	if (!radio_listens(f->chan))
+	{
+		f->used = 0;
+		radio.lost++;
+	}
+	else if (sr & GIE) radio_isr(f);
+	else f->latched = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          radio_eint
+// @brief       Interrupts enabled: run the receive interrupt of a frame latched before.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void radio_eint(void)
+{
+	u8 i;
+
+	for (i = 0; i < AIR_FRAMES; i++)
+	{
+		if (air[i].used && air[i].latched) radio_isr(&air[i]);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          radio_flush
+// @brief       Radio leaves RX: a latched frame is flushed with the RX FIFO.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void radio_flush(void)
+{
+	u8 i;
+
+	for (i = 0; i < AIR_FRAMES; i++)
+	{
+		if (air[i].used && air[i].latched)
+		{
+			air[i].used = 0;
+			radio.lost++;
+		}
+	}
+	radio.wor = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          radio_run
+// @brief       Let time pass until 'until' or until (*flag & mask) is set. Frames that end on the air
+//				meanwhile are received, which may set the flag. A test that runs past its deadline
+//				is stopped like the user stops the link.
+// @param       sim_time_t until	End of the period
+//				volatile u8 * flag	Early-out flag, 0 = none
+//				u8 mask				Early-out bits
+// @return      u8					1 = ended by the flag
+// *************************************************************************************************
+static u8 radio_run(sim_time_t until, volatile u8 * flag, u8 mask)
+{
+	air_t * f;
+
+	if (sr & GIE) radio_eint();
+	while (!(flag && (*flag & mask)))
+	{
+		if (deadline && (until > deadline))
+		{
+			test_fail("still running after %llu ms", (unsigned long long)(deadline * 1000 / SIM_ACLK_HZ));
+			deadline = 0;
+			setFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP);
+			continue;
+		}
+		f = air_next(until);
+		if (!f)
+		{
+			if (until > now) now = until;
+			return (0);
+		}
+		if (f->at > now) now = f->at;
+		air_arrive(f);
+	}
+	return (1);
+}
+
+
+// *************************************************************************************************
+// @fn          radio_skip
+// @brief       Let time pass without interrupts (spinning delay) or while transmitting. Frames are
+//				latched if the radio listens, else lost.
+// @param       sim_time_t until	End of the period
+//				u8 tx				1 = own transmission, nothing is received
+// @return      none
+// *************************************************************************************************
+static void radio_skip(sim_time_t until, u8 tx)
+{
+	air_t * f;
+
+	while ((f = air_next(until)) != 0)
+	{
+		if (!tx && radio_listens(f->chan)) f->latched = 1;
+		else
+		{
+			f->used = 0;
+			radio.lost++;
+		}
+	}
+	if (until > now) now = until;
+}
+
+
+// *************************************************************************************************
+// Access point
+
+// *************************************************************************************************
+// @fn          ap_reset
+// @brief       Access point powered up: no link, on channel 0.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void ap_reset(void)
+{
+	memset(&ap, 0, sizeof(ap));
+	ap.on = 1;
+	memcpy(ap.addr, "\xA1\xB2\xC3\xD4", NET_ADDR_SIZE);
+	ap.join_token = AP_JOIN_TOKEN;
+	ap.link_token = AP_LINK_TOKEN;
+	ap.rssi       = TEST_RSSI_NEAR;
+	ap.lqi        = TEST_LQI;
+	ap.bulk_drop  = -1;
+}
+
+
+#ifdef SMPL_SECURE
+// *************************************************************************************************
+// @fn          test_dbl
+// @brief       CMAC subkey step: shift left by one bit, XOR 0x87 into the last byte on carry.
+// @param       const uint8_t * in		Block
+//				uint8_t * out			Result, may be 'in'
+// @return      none
+// *************************************************************************************************
+static void test_dbl(const uint8_t * in, uint8_t * out)
+{
+	uint8_t msb = in[0] & 0x80;
+	u8 i;
+
+	for (i = 0; i < 15; i++) out[i] = (uint8_t)((in[i] << 1) | (in[i + 1] >> 7));
+	out[15] = (uint8_t)((in[15] << 1) ^ (msb ? 0x87 : 0));
+}
+
+
+// *************************************************************************************************
+// @fn          test_cmac
+// @brief       Reference AES-CMAC (NIST SP 800-38B, RFC 4493), byte by byte.
+// @param       const uint8_t * key		16 byte key
+//				const uint8_t * msg		Message
+//				uint8_t len				Message length
+//				uint8_t * mac			16 byte MAC
+// @return      none
+// *************************************************************************************************
+static void test_cmac(const uint8_t * key, const uint8_t * msg, uint8_t len, uint8_t * mac)
+{
+	uint8_t k[16], b[16];
+	u8 complete = len && !(len % 16);
+	u8 n = complete ? len / 16 : len / 16 + 1;
+	u8 i, j, rem;
+
+	// K1 for a complete last block, K2 for a padded one
+	memset(k, 0, 16);
+	sim_aes_encrypt(key, k, k);
+	test_dbl(k, k);
+	if (!complete) test_dbl(k, k);
+
+	memset(mac, 0, 16);
+	for (i = 0; i < n; i++)
+	{
+		rem = (i < n - 1) ? 16 : len - 16 * i;
+		memset(b, 0, 16);
+		memcpy(b, msg + 16 * i, rem);
+		if (i == n - 1)
+		{
+			if (rem < 16) b[rem] = 0x80;
+			for (j = 0; j < 16; j++) b[j] ^= k[j];
+		}
+		for (j = 0; j < 16; j++) mac[j] ^= b[j];
+		sim_aes_encrypt(key, mac, mac);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          test_unsecure
+// @brief       Reference check of a secured frame: CMAC over frame counter, source address and
+//				ciphertext, then CTR decryption with the counter blocks IV | counter | source address |
+//				block number.
+// @param       mrfiPacket_t * p		Secured frame, decrypted in place
+//				uint32_t ctr			Frame counter
+// @return      u8						1 = the CMAC matches
+// *************************************************************************************************
+static u8 test_unsecure(mrfiPacket_t * p, uint32_t ctr)
+{
+	uint8_t m[4 + NET_ADDR_SIZE + MAX_APP_PAYLOAD], mac[16], ks[16];
+	uint8_t * pl = MRFI_P_PAYLOAD(p);
+	uint8_t len = MRFI_GET_PAYLOAD_LEN(p) - F_APP_PAYLOAD_OS;
+	u8 i;
+
+	m[0] = (uint8_t)(ctr >> 24);
+	m[1] = (uint8_t)(ctr >> 16);
+	m[2] = (uint8_t)(ctr >> 8);
+	m[3] = (uint8_t)ctr;
+	memcpy(m + 4, MRFI_P_SRC_ADDR(p), NET_ADDR_SIZE);
+	memcpy(m + 4 + NET_ADDR_SIZE, pl + F_APP_PAYLOAD_OS, len);
+	test_cmac((const uint8_t *)TEST_KEY, m, 4 + NET_ADDR_SIZE + len, mac);
+	if (pl[F_SEC_CTR_OS] != (uint8_t)ctr || pl[F_SEC_ICHK_OS] != mac[0] || pl[F_SEC_MAC_OS] != mac[1]) return (0);
+
+	for (i = 0; i < len; i++)
+	{
+		if (!(i % 16))
+		{
+			memset(ks, 0, 16);
+			ks[0] = (uint8_t)(TEST_IV >> 24);
+			ks[1] = (uint8_t)(TEST_IV >> 16);
+			ks[2] = (uint8_t)(TEST_IV >> 8);
+			ks[3] = (uint8_t)TEST_IV;
+			memcpy(ks + 4, m, 4 + NET_ADDR_SIZE);
+			ks[15] = i / 16;
+			sim_aes_encrypt((const uint8_t *)TEST_KEY, ks, ks);
+		}
+		pl[F_APP_PAYLOAD_OS + i] ^= ks[i % 16];
+	}
+	return (1);
+}
+
+
+// *************************************************************************************************
+// @fn          ap_secure
+// @brief       Secure a frame of the access point with the stack's nwk_setSecureFrame, on the same
+//				accelerator model as the watch, and check it against the reference.
+// @param       mrfiPacket_t * p		Frame
+//				uint32_t * ctr			Frame counter of the link, 0 for NWK application frames
+// @return      none
+// *************************************************************************************************
+static void ap_secure(mrfiPacket_t * p, uint32_t * ctr)
+{
+	mrfiPacket_t plain = *p, ref;
+	unsigned short s = sr;
+	uint8_t len = MRFI_GET_PAYLOAD_LEN(p) - F_APP_PAYLOAD_OS;
+	uint32_t used;
+
+	// The access point is not the watch: its interrupts stay as they are
+	sr &= ~GIE;
+	used = ctr ? *ctr : 0;
+	nwk_setSecureFrame(p, len, ctr);
+	if (!ctr) used = GET_FROM_FRAME(MRFI_P_PAYLOAD(p), F_SEC_CTR_OS);
+	sr = s;
+
+	ref = *p;
+	if (!test_unsecure(&ref, used) || memcmp(MRFI_P_PAYLOAD(&ref) + F_APP_PAYLOAD_OS, MRFI_P_PAYLOAD(&plain) + F_APP_PAYLOAD_OS, len))
+	{
+		test_fail("secured frame to port %u differs from the reference", GET_FROM_FRAME(MRFI_P_PAYLOAD(p), F_PORT_OS));
+	}
+	sec_checked++;
+}
+
+
+// *************************************************************************************************
+// @fn          ap_unsecure
+// @brief       Check and decrypt a frame from the watch with the stack's nwk_getSecureFrame. The
+//				reference must come to the same result.
+// @param       mrfiPacket_t * p		Frame, decrypted in place
+//				uint32_t * ctr			Frame counter of the link, 0 for NWK application frames
+// @return      u8						1 = frame is authentic
+// *************************************************************************************************
+static u8 ap_unsecure(mrfiPacket_t * p, uint32_t * ctr)
+{
+	mrfiPacket_t ref = *p;
+	unsigned short s = sr;
+	uint8_t hint = GET_FROM_FRAME(MRFI_P_PAYLOAD(p), F_SEC_CTR_OS);
+	uint32_t full = hint;
+	u8 ok, ref_ok;
+
+	if (!GET_FROM_FRAME(MRFI_P_PAYLOAD(p), F_ENCRYPT_OS))
+	{
+		test_fail("frame to port %u not secured", GET_FROM_FRAME(MRFI_P_PAYLOAD(p), F_PORT_OS));
+		return (0);
+	}
+
+	// Full counter as the receiver resyncs to it: next value with this low byte
+	if (ctr)
+	{
+		full = (*ctr & 0xFFFFFF00u) | hint;
+		if (full < *ctr) full += 0x100;
+	}
+	ref_ok = test_unsecure(&ref, full);
+
+	sr &= ~GIE;
+	ok = nwk_getSecureFrame(p, MRFI_GET_PAYLOAD_LEN(p) - F_SEC_CTR_OS, ctr);
+	sr = s;
+
+	if (ok != ref_ok || (ok && memcmp(ref.frame, p->frame, p->frame[0] + 1)))
+	{
+		test_fail("frame to port %u: stack %s it, reference %s it", GET_FROM_FRAME(MRFI_P_PAYLOAD(p), F_PORT_OS),
+				  ok ? "accepts" : "rejects", ref_ok ? "accepts" : "rejects");
+	}
+	sec_checked++;
+	return (ok);
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          ap_air
+// @brief       Put a frame on the air, after the frames the access point sends already.
+// @param       const mrfiPacket_t * p	Frame
+// @return      mrfiPacket_t *			Frame on the air, for changes before it arrives
+// *************************************************************************************************
+static mrfiPacket_t * ap_air(const mrfiPacket_t * p)
+{
+	air_t * f = air_alloc();
+
+	f->pkt = *p;
+	if (ap.air_free < now + AP_TURNAROUND) ap.air_free = now + AP_TURNAROUND;
+	ap.air_free += RADIO_AIR_TICKS(p);
+	f->at     = ap.air_free;
+	f->chan   = ap.chan;
+	f->crc_ok = 1;
+	f->rssi   = ap.rssi;
+	f->lqi    = ap.lqi;
+	ap.sent++;
+	return &f->pkt;
+}
+
+
+// *************************************************************************************************
+// @fn          ap_send
+// @brief       Send a frame from the access point.
+// @param       const uint8_t * dst		Destination address
+//				uint8_t port			Destination port
+//				const uint8_t * msg		Application payload
+//				uint8_t len				Payload length
+//				uint8_t tid				Transaction ID of the NWK header
+// @return      mrfiPacket_t *			Frame on the air
+// *************************************************************************************************
+static mrfiPacket_t * ap_send(const uint8_t * dst, uint8_t port, const uint8_t * msg, uint8_t len, uint8_t tid)
+{
+	mrfiPacket_t p;
+	uint8_t * pl = MRFI_P_PAYLOAD(&p);
+
+	memset(&p, 0, sizeof(p));
+	MRFI_SET_PAYLOAD_LEN(&p, F_APP_PAYLOAD_OS + len);
+	memcpy(MRFI_P_DST_ADDR(&p), dst, NET_ADDR_SIZE);
+	memcpy(MRFI_P_SRC_ADDR(&p), ap.addr, NET_ADDR_SIZE);
+	pl[F_PORT_OS]    = port;
+	pl[F_TX_DEVICE]  = F_TX_DEVICE_AP | F_RX_TYPE_USER_CTL | MAX_HOPS;
+	pl[F_TRACTID_OS] = tid;
+	memcpy(pl + F_APP_PAYLOAD_OS, msg, len);
+#ifdef SMPL_SECURE
+	ap_secure(&p, (port > SMPL_PORT_MGMT) ? &ap.tx_ctr : 0);
+#endif
+	return ap_air(&p);
+}
+
+
+// *************************************************************************************************
+// @fn          ap_send_app
+// @brief       Send a frame to the application of the linked watch.
+// @param       const uint8_t * msg		Application payload
+//				uint8_t len				Payload length
+// @return      mrfiPacket_t *			Frame on the air
+// *************************************************************************************************
+static mrfiPacket_t * ap_send_app(const uint8_t * msg, uint8_t len)
+{
+	return ap_send(ap.ed_addr, ap.ed_port, msg, len, ++ap.tid);
+}
+
+
+// *************************************************************************************************
+// @fn          ap_command
+// @brief       Queue a command, sent as answer to the next ready-to-receive packet.
+// @param       uint8_t cmd				SYNC_AP_CMD_*
+//				uint8_t arg				First argument byte
+// @return      uint8_t *				Command, for more arguments
+// *************************************************************************************************
+static uint8_t * ap_command(uint8_t cmd, uint8_t arg)
+{
+	uint8_t * c = ap.cmd[ap.cmds++];
+
+	memset(c, 0, BM_SYNC_DATA_LENGTH);
+	c[0] = cmd;
+	c[1] = arg;
+	return c;
+}
+
+
+// *************************************************************************************************
+// @fn          ap_hear_nwk
+// @brief       Answer a frame to a NWK application port like the access point does.
+// @param       const uint8_t * src		Source address
+//				uint8_t port			Port
+//				const uint8_t * app		Application payload
+//				uint8_t len				Payload length
+// @return      none
+// *************************************************************************************************
+static void ap_hear_nwk(const uint8_t * src, uint8_t port, const uint8_t * app, uint8_t len)
+{
+	uint8_t msg[MAX_APP_PAYLOAD];
+	uint32_t token;
+
+	memset(msg, 0, sizeof(msg));
+	msg[1] = app[1];
+
+	if (port == SMPL_PORT_JOIN && len >= JOIN_FRAME_SIZE && app[JB_REQ_OS] == JOIN_REQ_JOIN)
+	{
+		nwk_getNumObjectFromMsg((void *)(app + J_JOIN_TOKEN_OS), &token, sizeof(token));
+		if (token != ap.join_token) return;
+		ap.joins++;
+		msg[JB_REQ_OS] = JOIN_REQ_JOIN | NWK_APP_REPLY_BIT;
+		memcpy(msg + JR_LINK_TOKEN_OS, &ap.link_token, sizeof(ap.link_token));
+		msg[JR_CRYPTKEY_SIZE_OS] = SEC_CRYPT_KEY_SIZE;
+		ap_send(src, SMPL_PORT_JOIN, msg, JOIN_REPLY_FRAME_SIZE, 0);
+	}
+	else if (port == SMPL_PORT_LINK && len >= LINK_FRAME_SIZE && app[LB_REQ_OS] == LINK_REQ_LINK)
+	{
+		nwk_getNumObjectFromMsg((void *)(app + L_LINK_TOKEN_OS), &token, sizeof(token));
+		if (token != ap.link_token) return;
+
+		// A repeated request gets the same connection
+		if (ap.linked && !memcmp(ap.ed_addr, src, NET_ADDR_SIZE) && ap.ed_port == app[L_RMT_PORT_OS]) ap.link_dups++;
+		else ap.links++;
+		ap.linked  = 1;
+		ap.ed_port = app[L_RMT_PORT_OS];
+		memcpy(ap.ed_addr, src, NET_ADDR_SIZE);
+
+		msg[LB_REQ_OS]       = LINK_REQ_LINK | NWK_APP_REPLY_BIT;
+		msg[LR_RMT_PORT_OS]  = AP_PORT;
+		msg[LR_MY_RXTYPE_OS] = F_RX_TYPE_USER_CTL;
+#ifdef SMPL_SECURE
+		// Each side starts the frame counter of its direction
+		nwk_getNumObjectFromMsg((void *)(app + L_CTR_OS), &ap.rx_ctr, sizeof(ap.rx_ctr));
+		ap.tx_ctr = test_rand(0);
+		nwk_putNumObjectIntoMsg(&ap.tx_ctr, msg + LR_CTR_OS, sizeof(ap.tx_ctr));
+#endif
+		ap_send(src, SMPL_PORT_LINK, msg, LINK_REPLY_FRAME_SIZE, 0);
+	}
+	else if (port == SMPL_PORT_FREQ && len >= FREQ_REQ_PING_FRAME_SIZE && app[FB_APP_INFO_OS] == FREQ_REQ_PING)
+	{
+		ap.pings++;
+		msg[FB_APP_INFO_OS] = FREQ_REQ_PING | NWK_APP_REPLY_BIT;
+		ap_send(src, SMPL_PORT_FREQ, msg, FREQ_REQ_PING_FRAME_SIZE, 0);
+	}
+	else if (port == SMPL_PORT_FREQ && len >= FREQ_REQ_REQ_MOVE_FRAME_SIZE && app[FB_APP_INFO_OS] == FREQ_REQ_REQ_MOVE &&
+			 ap.linked && !memcmp(src, ap.ed_addr, NET_ADDR_SIZE))
+	{
+		if (ap.move_drop)
+		{
+			ap.move_drop--;
+			return;
+		}
+		ap.move_reqs++;
+		if (ap.move_mode == AP_MOVE_IGNORE || app[F_CHAN_OS] >= MRFI_NUM_LOGICAL_CHANS) return;
+
+		// Move broadcast on the old channel, then the access point follows
+		if (ap.move_mode == AP_MOVE_FOLLOW)
+		{
+			msg[FB_APP_INFO_OS] = FREQ_REQ_MOVE;
+			msg[F_CHAN_OS]      = app[F_CHAN_OS];
+			ap_send(mrfiBroadcastAddr, SMPL_PORT_FREQ, msg, FREQ_REQ_MOVE_FRAME_SIZE, ++ap.tid);
+		}
+		ap.chan = app[F_CHAN_OS];
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          ap_hear_bulk
+// @brief       Host side of the windowed memory download: frames are taken in any order inside the
+//				window, the frame with the ACK request bit is answered with the first missing frame
+//				and a bitmap of the frames received after it.
+// @param       const uint8_t * app		Application payload
+//				uint8_t len				Payload length
+// @return      none
+// *************************************************************************************************
+static void ap_hear_bulk(const uint8_t * app, uint8_t len)
+{
+	uint8_t ack[3];
+	uint8_t d = (app[1] - ap.bulk_next) & BM_SYNC_BULK_SEQ_MASK;
+	uint16_t frame = ap.bulk_next + d;
+
+	if (len != BM_SYNC_BULK_DATA_LENGTH) test_fail("bulk frame of %u bytes", len);
+	if (frame == ap.bulk_drop)
+	{
+		ap.bulk_drop = -1;
+		return;
+	}
+	ap.bulk_frames++;
+	if (app[2] != (uint8_t)frame || app[len - 1] != (uint8_t)~frame) ap.bulk_bad++;
+
+	if (d == 0)
+	{
+		// Window moves past all frames received in a row
+		ap.bulk_next++;
+		while (ap.bulk_got & 1)
+		{
+			ap.bulk_got >>= 1;
+			ap.bulk_next++;
+		}
+		ap.bulk_got >>= 1;
+	}
+	else if (d <= BM_SYNC_BULK_WINDOW && !(ap.bulk_got & (1 << (d - 1)))) ap.bulk_got |= 1 << (d - 1);
+	else ap.bulk_dups++;
+
+	if (app[1] & BM_SYNC_BULK_ACK_REQUEST)
+	{
+		ack[0] = SYNC_AP_CMD_BULK_ACK;
+		ack[1] = ap.bulk_next & BM_SYNC_BULK_SEQ_MASK;
+		ack[2] = ap.bulk_got;
+		ap.bulk_acks++;
+		ap_send_app(ack, sizeof(ack));
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          ap_hear_app
+// @brief       Sync protocol of the access point on the link: commands go out as answer to the
+//				ready-to-receive packets, data frames are counted.
+// @param       const uint8_t * app		Application payload
+//				uint8_t len				Payload length
+// @return      none
+// *************************************************************************************************
+static void ap_hear_app(const uint8_t * app, uint8_t len)
+{
+	ap.frames++;
+	switch (app[0])
+	{
+		case SIMPLICITI_SYNC_STARTED_EVENTS:
+			ap.started++;
+			break;
+
+		case SYNC_ED_TYPE_R2R:
+			ap.r2r++;
+			if (ap.cmd_next < ap.cmds) ap_send_app(ap.cmd[ap.cmd_next++], BM_SYNC_DATA_LENGTH);
+			break;
+
+		case SYNC_ED_TYPE_STATUS:
+			if (len != BM_SYNC_DATA_LENGTH) test_fail("status frame of %u bytes", len);
+			ap.status++;
+			ap.status_level = radio.level;
+			break;
+
+		case SYNC_ED_TYPE_MEMORY_BULK:
+			ap_hear_bulk(app, len);
+			break;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          ap_hear
+// @brief       A frame from the watch ends on the air. The access point takes frames on its channel
+//				to its address or broadcast.
+// @param       mrfiPacket_t * pkt		Frame as transmitted
+// @return      none
+// *************************************************************************************************
+static void ap_hear(mrfiPacket_t * pkt)
+{
+	mrfiPacket_t p = *pkt;
+	uint8_t * pl = MRFI_P_PAYLOAD(&p);
+	uint8_t * src = MRFI_P_SRC_ADDR(&p);
+	uint8_t port, len;
+
+	if (!ap.on || radio.chan != ap.chan) return;
+	if (memcmp(MRFI_P_DST_ADDR(&p), ap.addr, NET_ADDR_SIZE) &&
+		memcmp(MRFI_P_DST_ADDR(&p), mrfiBroadcastAddr, NET_ADDR_SIZE)) return;
+
+	port = GET_FROM_FRAME(pl, F_PORT_OS);
+	len  = MRFI_GET_PAYLOAD_LEN(&p) - F_APP_PAYLOAD_OS;
+
+	if (port && port <= SMPL_PORT_MGMT)
+	{
+#ifdef SMPL_SECURE
+		if (!ap_unsecure(&p, 0)) return;
+#endif
+		ap_hear_nwk(src, port, pl + F_APP_PAYLOAD_OS, len);
+	}
+	else if (port == AP_PORT && ap.linked && !memcmp(src, ap.ed_addr, NET_ADDR_SIZE))
+	{
+#ifdef SMPL_SECURE
+		if (!ap_unsecure(&p, &ap.rx_ctr)) return;
+#endif
+		ap_hear_app(pl + F_APP_PAYLOAD_OS, len);
+	}
+}
+
+
+// *************************************************************************************************
+// MRFI stub (mrfi_radio.c)
+
+const uint8_t mrfiBroadcastAddr[] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+void MRFI_Init(void)
+{
+	memset(&radio.own, 0, sizeof(radio.own));
+	radio_flush();
+	radio.chan     = 0;
+	radio.level    = MRFI_NUM_POWER_SETTINGS - 1;
+	radio.state    = MRFI_RADIO_STATE_OFF;
+	radio.rx       = &radio.own;
+	radio.kill_sem = 0;
+	radio.reply_ctx = 0;
+	sim_bis_sr(GIE);
+}
+
+uint8_t MRFI_Transmit(mrfiPacket_t * pPacket, uint8_t txType)
+{
+	uint8_t tries = MRFI_CCA_RETRIES + 1;
+
+	if (radio.state == MRFI_RADIO_STATE_OFF) test_fail("MRFI_Transmit with radio off");
+	if (pPacket->frame[0] + 3u > RADIO_FIFO_BYTES) test_fail("frame of %u bytes does not fit the radio FIFO", pPacket->frame[0]);
+	radio_flush();
+
+	if (txType == MRFI_TX_TYPE_CCA)
+	{
+		radio.cca_fails = 0;
+		while (test_rand(100) < radio.busy[radio.chan])
+		{
+			radio.cca_fails++;
+			radio.cca_rssi = -70;
+			if (!--tries) return (MRFI_TX_RESULT_FAILED);
+			radio_skip(now + ((MRFI_RandomByte() & 0x0F) + 1) * RADIO_BACKOFF_TICKS, 1);
+		}
+	}
+
+	radio_skip(now + RADIO_AIR_TICKS(pPacket), 1);
+	air_time += RADIO_AIR_TICKS(pPacket);
+	radio.tx_frames++;
+	ap_hear(pPacket);
+	return (MRFI_TX_RESULT_SUCCESS);
+}
+
+void MRFI_Receive(mrfiPacket_t * pPacket)
+{
+	if (pPacket != radio.rx) *pPacket = *radio.rx;
+}
+
+uint8_t MRFI_GetRadioState(void)
+{
+	return (radio.state);
+}
+
+void MRFI_RxOn(void)
+{
+	if (radio.state == MRFI_RADIO_STATE_OFF) test_fail("MRFI_RxOn with radio off");
+	if (radio.state != MRFI_RADIO_STATE_RX) radio.state = MRFI_RADIO_STATE_RX;
+}
+
+void MRFI_RxIdle(void)
+{
+	if (radio.state == MRFI_RADIO_STATE_OFF) test_fail("MRFI_RxIdle with radio off");
+	radio_flush();
+	radio.state = MRFI_RADIO_STATE_IDLE;
+}
+
+#ifdef CONFIG_SYNC_WOR
+void MRFI_WorOn(void)
+{
+	MRFI_WakeUp();
+	MRFI_RxIdle();
+	radio.state = MRFI_RADIO_STATE_RX;
+	radio.wor   = 1;
+}
+#endif
+
+int8_t MRFI_Rssi(void)
+{
+	return (ap.on && ap.chan == radio.chan) ? ap.rssi : -100;
+}
+
+void MRFI_SetLogicalChannel(uint8_t chan)
+{
+	if (chan >= MRFI_NUM_LOGICAL_CHANS) test_fail("logical channel %u", chan);
+	radio_flush();
+	radio.chan = chan;
+}
+
+void MRFI_SetRFPwr(uint8_t level)
+{
+	if (level >= MRFI_NUM_POWER_SETTINGS) test_fail("power level %u", level);
+	radio.level = level;
+	radio.pwr_sets++;
+}
+
+uint8_t MRFI_SetRxAddrFilter(uint8_t * pAddr)
+{
+	memcpy(radio.filter, pAddr, NET_ADDR_SIZE);
+	return (0);
+}
+
+void MRFI_EnableRxAddrFilter(void)
+{
+	radio.filter_on = 1;
+}
+
+void MRFI_Sleep(void)
+{
+	if (radio.state != MRFI_RADIO_STATE_OFF)
+	{
+		radio_flush();
+		radio.state = MRFI_RADIO_STATE_OFF;
+	}
+}
+
+void MRFI_WakeUp(void)
+{
+	if (radio.state == MRFI_RADIO_STATE_OFF) radio.state = MRFI_RADIO_STATE_IDLE;
+}
+
+uint8_t MRFI_RandomByte(void)
+{
+	return (uint8_t)test_rand(256);
+}
+
+void MRFI_DelayMs(uint16_t milliseconds)
+{
+	if (!(sr & GIE)) radio_skip(now + SIM_MS(milliseconds), 0);
+	else radio_run(now + SIM_MS(milliseconds), &simpliciti_flag, SIMPLICITI_TRIGGER_STOP);
+}
+
+void MRFI_ReplyDelay(void)
+{
+	radio.reply_ctx = 1;
+	if (!(sr & GIE)) radio_skip(now + SIM_MS(RADIO_REPLY_DELAY_MS), 0);
+	else radio_run(now + SIM_MS(RADIO_REPLY_DELAY_MS), &radio.kill_sem, 1);
+	radio.kill_sem  = 0;
+	radio.reply_ctx = 0;
+}
+
+void MRFI_PostKillSem(void)
+{
+	if (radio.reply_ctx) radio.kill_sem = 1;
+}
+
+#ifdef FREQUENCY_AGILITY
+uint8_t MRFI_CcaFailures(int8_t * pRssi)
+{
+	*pRssi = radio.cca_rssi;
+	return (radio.cca_fails);
+}
+#endif
+
+
+// *************************************************************************************************
+// Board and timer
+
+void BSP_InitBoard(void)
+{
+}
+
+void Timer0_A4_Delay(u16 ticks)
+{
+	radio_run(now + ticks, 0, 0);
+}
+
+u8 Timer0_A4_DelayUntil(u16 ticks, volatile u8 * flag, u8 mask)
+{
+	return radio_run(now + ticks, flag, mask);
+}
+
+
+// *************************************************************************************************
+// Application callbacks (logic/rfsimpliciti.c)
+
+unsigned char simpliciti_link_quality_callback(unsigned char event, signed char rssi, unsigned char lqi)
+{
+	lq.events[event & 3]++;
+	if (event == SIMPLICITI_LINK_FRAME)
+	{
+		lq.rssi  = rssi;
+		lq.lqi   = lqi;
+		lq.level = (rssi >= TEST_RSSI_GOOD) ? 0 : SIMPLICITI_TX_LEVELS - 1;
+	}
+	else if (event != SIMPLICITI_LINK_IDLE) lq.level = SIMPLICITI_TX_LEVELS - 1;
+	return (lq.level);
+}
+
+unsigned char simpliciti_channel_callback(unsigned char chan, unsigned char cca_fails, signed char rssi)
+{
+	if (chan >= SIMPLICITI_CHANNELS) test_fail("frame reported on logical channel %u", chan);
+	else
+	{
+		agility.frames[chan]++;
+		agility.fails[chan] += cca_fails;
+	}
+	return (agility.to < SIMPLICITI_CHANNELS) ? agility.to : chan;
+}
+
+unsigned char simpliciti_link_cache_load(unsigned char * data, unsigned char len)
+{
+	if (cache.len != len) return (0);
+	memcpy(data, cache.data, len);
+	return (1);
+}
+
+void simpliciti_link_cache_store(unsigned char * data, unsigned char len)
+{
+	memcpy(cache.data, data, len);
+	cache.len = len;
+	cache.stores++;
+}
+
+void simpliciti_sync_decode_ap_cmd_callback(void)
+{
+	simpliciti_reply_count = 0;
+	switch (simpliciti_data[0])
+	{
+		case SYNC_AP_CMD_GET_STATUS:
+			simpliciti_reply_count = 1;
+			break;
+
+		case SYNC_AP_CMD_GET_MEMORY_BULK:
+			simpliciti_bulk_packets = ((simpliciti_data[3] | (simpliciti_data[4] << 8)) -
+									   (simpliciti_data[1] | (simpliciti_data[2] << 8)) +
+									   BM_SYNC_BULK_LOG_PACKETS - 1) / BM_SYNC_BULK_LOG_PACKETS;
+			break;
+
+		case SYNC_AP_CMD_EXIT:
+			setFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP);
+			break;
+	}
+}
+
+void simpliciti_sync_get_data_callback(unsigned int index)
+{
+	if (simpliciti_data[0] == SYNC_ED_TYPE_MEMORY_BULK)
+	{
+		// Frame number at both ends of the payload
+		memset(simpliciti_data + 2, 0, BM_SYNC_BULK_DATA_LENGTH - 2);
+		simpliciti_data[1] = index & BM_SYNC_BULK_SEQ_MASK;
+		simpliciti_data[2] = (unsigned char)index;
+		simpliciti_data[BM_SYNC_BULK_DATA_LENGTH - 1] = (unsigned char)~index;
+		return;
+	}
+	memset(simpliciti_data, 0, BM_SYNC_DATA_LENGTH);
+	simpliciti_data[0] = SYNC_ED_TYPE_STATUS;
+	simpliciti_data[1] = (unsigned char)index;
+}
+
+void simpliciti_get_ed_data_callback(void)
+{
+}
+
+int simpliciti_get_rvc_callback(unsigned char len)
+{
+	return (0);
+}
+
+
+// *************************************************************************************************
+// Tests
+
+// *************************************************************************************************
+// @fn          test_begin
+// @brief       Start a test: name for messages and the virtual time it may take.
+// @param       const char * name	Test name
+//				u16 seconds			Time limit
+// @return      none
+// *************************************************************************************************
+static void test_begin(const char * name, u16 seconds)
+{
+	test_name = name;
+	deadline  = now + SIM_SEC(seconds);
+	simpliciti_flag = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          test_link
+// @brief       Link through simpliciti_link.
+// @param       none
+// @return      u8					1 = linked
+// *************************************************************************************************
+static u8 test_link(void)
+{
+	if (!simpliciti_link())
+	{
+		test_fail("no link");
+		return (0);
+	}
+	return (1);
+}
+
+
+// *************************************************************************************************
+// @fn          test_sync
+// @brief       Run sync mode: the access point answers the ready-to-receive packets with a status
+//				request and then ends sync mode.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_sync(void)
+{
+	unsigned long status = ap.status;
+
+	ap.cmds = ap.cmd_next = 0;
+	ap_command(SYNC_AP_CMD_GET_STATUS, 0);
+	ap_command(SYNC_AP_CMD_EXIT, 0);
+	clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP);
+	simpliciti_main_sync();
+
+	if (ap.cmd_next != ap.cmds) test_fail("%u of %u commands sent", ap.cmd_next, ap.cmds);
+	if (ap.status != status + 1) test_fail("%lu status frames, expected 1", ap.status - status);
+}
+
+
+// *************************************************************************************************
+// @fn          test_power
+// @brief       Output power follows link quality: links at full power, the RSSI and LQI of frames
+//				from the access point reach simpliciti_link_quality_callback and the level it returns
+//				is set in the radio before the next frame goes out.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_power(void)
+{
+	test_begin("power", 30);
+	ap_reset();
+	memset(&lq, 0, sizeof(lq));
+	radio.pwr_sets = 0;
+	if (!test_link()) return;
+	if (ap.joins != 1 || ap.links != 1) test_fail("%lu joins and %lu links, expected 1 each", ap.joins, ap.links);
+	if (!radio.pwr_sets || radio.level != SIMPLICITI_TX_LEVELS - 1)
+	{
+		test_fail("linked at level %u after %lu MRFI_SetRFPwr, expected level %u", radio.level, radio.pwr_sets,
+				  SIMPLICITI_TX_LEVELS - 1);
+	}
+
+	// Strong signal: status goes out at the lowest level
+	ap.rssi = TEST_RSSI_NEAR;
+	test_sync();
+	if (!lq.events[SIMPLICITI_LINK_FRAME]) test_fail("no frame reported to the link quality callback");
+	if (lq.rssi != TEST_RSSI_NEAR || lq.lqi != TEST_LQI)
+	{
+		test_fail("RSSI %d LQI %u reported, access point sent with %d / %u", lq.rssi, lq.lqi, TEST_RSSI_NEAR, TEST_LQI);
+	}
+	if (ap.status_level != 0 || radio.level != 0) test_fail("status sent at level %u, radio at %u, expected 0", ap.status_level, radio.level);
+
+	// Weak signal: back to full power
+	test_begin("power", 30);
+	ap.rssi = TEST_RSSI_FAR;
+	if (!test_link()) return;
+	test_sync();
+	if (lq.rssi != TEST_RSSI_FAR) test_fail("RSSI %d reported, access point sent with %d", lq.rssi, TEST_RSSI_FAR);
+	if (ap.status_level != SIMPLICITI_TX_LEVELS - 1) test_fail("status sent at level %u, expected %u", ap.status_level, SIMPLICITI_TX_LEVELS - 1);
+}
+
+
+// *************************************************************************************************
+// @fn          test_resume
+// @brief       Link cache: a link with join stores the join context, the next link restores it and
+//				sends one link request, which the access point answers like a repeated one. After an
+//				access point restart (new link token) the request goes unanswered and the link falls
+//				back to a join. A cache written under another device address is not used.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_resume(void)
+{
+	unsigned long stores, pings;
+	sim_time_t start;
+
+	// Join on the channel the access point is on, context goes to the cache
+	test_begin("resume", 30);
+	ap_reset();
+	ap.chan = 2;
+	memset(&cache, 0, sizeof(cache));
+	sInit_done = 0;
+	if (!test_link()) return;
+	if (ap.joins != 1 || ap.links != 1) test_fail("%lu joins and %lu links, expected 1 each", ap.joins, ap.links);
+	if (cache.stores != 1) test_fail("%lu link cache stores after a join, expected 1", cache.stores);
+	sInit_done = 0;
+
+	// Access point still holds the link: one link request, no join, no scan
+	test_begin("resume", 30);
+	start = now;
+	pings = ap.pings;
+	if (!test_link()) return;
+	if (ap.joins != 1 || ap.pings != pings) test_fail("%lu joins and %lu pings on resume, expected 1 and 0", ap.joins, ap.pings - pings);
+	if (ap.link_dups != 1) test_fail("%lu repeated link requests, expected 1", ap.link_dups);
+	if (radio.chan != ap.chan) test_fail("resumed on channel %u, access point on %u", radio.chan, ap.chan);
+	if (now - start > SIM_MS(100)) test_fail("resume took %llu ms", (unsigned long long)((now - start) * 1000 / SIM_ACLK_HZ));
+	if (cache.stores != 1) test_fail("link cache written on resume");
+	test_sync();
+	sInit_done = 0;
+
+	// Access point restarted with a new link token: resume fails, join and link, cache updated
+	test_begin("resume", 30);
+	ap_reset();
+	ap.chan = 2;
+	ap.link_token = AP_LINK_TOKEN + 1;
+	stores = cache.stores;
+	if (!test_link()) return;
+	if (ap.joins != 1 || ap.links != 1) test_fail("%lu joins and %lu links after restart, expected 1 each", ap.joins, ap.links);
+	if (cache.stores != stores + 1) test_fail("link cache not updated after restart");
+	test_sync();
+	sInit_done = 0;
+
+	// Updated context resumes
+	test_begin("resume", 30);
+	if (!test_link()) return;
+	if (ap.joins != 1 || ap.link_dups != 1) test_fail("%lu joins and %lu repeated links, expected 1 each", ap.joins, ap.link_dups);
+	sInit_done = 0;
+
+	// Other device address: cache not used
+	test_begin("resume", 30);
+	simpliciti_ed_address[3] ^= 0x55;
+	if (!test_link()) return;
+	if (ap.joins != 2) test_fail("cache of another device address used");
+	simpliciti_ed_address[3] ^= 0x55;
+	sInit_done = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          test_move
+// @brief       Channel agility: the clear channel assessments of every frame reach
+//				simpliciti_channel_callback, the channel it returns is asked from the access point
+//				before the next ready-to-receive packet. A lost request is asked again. Moved with the
+//				broadcast of the access point, or by a scan if the broadcast is lost, the link cache is
+//				written and the next link resumes on the new channel. An access point that does not
+//				move keeps the link and the cache where they are.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_move(void)
+{
+	unsigned long stores, pings, reqs, dups;
+
+	// Busy channel 0: failed assessments reported, link stays until the callback asks
+	test_begin("move", 30);
+	ap_reset();
+	memset(&cache, 0, sizeof(cache));
+	memset(&agility, 0, sizeof(agility));
+	agility.to = SIMPLICITI_CHANNELS;
+	sInit_done = 0;
+	if (!test_link()) return;
+	radio.busy[0] = 50;
+	ap.cmds = ap.cmd_next = 0;
+	ap_command(SYNC_AP_CMD_EXIT, 0);
+	simpliciti_main_sync();
+	if (!agility.frames[0] || !agility.fails[0]) test_fail("%lu failed assessments in %lu frames on the busy channel", agility.fails[0], agility.frames[0]);
+	if (ap.move_reqs || radio.chan != 0) test_fail("%lu move requests, watch on channel %u, expected none", ap.move_reqs, radio.chan);
+
+	// Move to channel 1, first request lost
+	test_begin("move", 30);
+	if (!test_link()) return;
+	stores = cache.stores;
+	ap.move_drop = 1;
+	agility.to = 1;
+	test_sync();
+	radio.busy[0] = 0;
+	if (!agility.frames[1] || agility.fails[1]) test_fail("%lu failed assessments in %lu frames on the free channel", agility.fails[1], agility.frames[1]);
+	if (ap.move_drop || ap.move_reqs != 1) test_fail("%lu move requests after the lost one, expected 1", ap.move_reqs);
+	if (ap.chan != 1 || radio.chan != 1) test_fail("access point on channel %u, watch on %u, expected 1", ap.chan, radio.chan);
+	if (cache.stores != stores + 1) test_fail("link cache not written after the move");
+
+	// Next link resumes on the new channel, move follows the broadcast without a scan
+	test_begin("move", 30);
+	agility.to = SIMPLICITI_CHANNELS;
+	pings = ap.pings;
+	dups  = ap.link_dups;
+	if (!test_link()) return;
+	if (ap.joins != 1 || ap.link_dups != dups + 1 || ap.pings != pings)
+	{
+		test_fail("%lu joins, %lu repeated links and %lu pings on resume, expected 1, 1 and 0", ap.joins, ap.link_dups - dups, ap.pings - pings);
+	}
+	if (radio.chan != 1) test_fail("resumed on channel %u, expected 1", radio.chan);
+	stores = cache.stores;
+	reqs   = ap.move_reqs;
+	agility.to = 2;
+	test_sync();
+	if (ap.move_reqs != reqs + 1) test_fail("%lu move requests, expected 1", ap.move_reqs - reqs);
+	if (ap.chan != 2 || radio.chan != 2) test_fail("access point on channel %u, watch on %u, expected 2", ap.chan, radio.chan);
+	if (ap.pings != pings) test_fail("%lu pings after the move broadcast", ap.pings - pings);
+	if (cache.stores != stores + 1) test_fail("link cache not written after the move");
+
+	// Broadcast lost: access point found on the new channel by a scan
+	test_begin("move", 30);
+	agility.to = SIMPLICITI_CHANNELS;
+	if (!test_link()) return;
+	if (radio.chan != 2) test_fail("resumed on channel %u, expected 2", radio.chan);
+	ap.move_mode = AP_MOVE_SILENT;
+	stores = cache.stores;
+	agility.to = 3;
+	test_sync();
+	if (ap.chan != 3 || radio.chan != 3) test_fail("access point on channel %u, watch on %u, expected 3", ap.chan, radio.chan);
+	if (ap.pings == pings) test_fail("no scan after the lost move broadcast");
+	if (cache.stores != stores + 1) test_fail("link cache not written after the move");
+
+	// Access point stays: link and cache stay on its channel
+	test_begin("move", 30);
+	agility.to = SIMPLICITI_CHANNELS;
+	if (!test_link()) return;
+	ap.move_mode = AP_MOVE_IGNORE;
+	stores = cache.stores;
+	reqs   = ap.move_reqs;
+	agility.to = 0;
+	test_sync();
+	agility.to = SIMPLICITI_CHANNELS;
+	if (ap.move_reqs == reqs) test_fail("no move request");
+	if (ap.chan != 3 || radio.chan != 3) test_fail("access point on channel %u, watch on %u, expected 3", ap.chan, radio.chan);
+	if (cache.stores != stores) test_fail("link cache written without a move");
+}
+
+
+// *************************************************************************************************
+// @fn          test_lid
+// @brief       Link ID of the connection to the access point.
+// @param       none
+// @return      linkID_t			0 = not connected
+// *************************************************************************************************
+static linkID_t test_lid(void)
+{
+	connInfo_t * c;
+	u16 lid;
+
+	for (lid = 1; lid < SMPL_LINKID_USER_UUD; lid++)
+	{
+		c = nwk_getConnInfo((linkID_t)lid);
+		if (c && c->connState == CONNSTATE_CONNECTED && c->portTx == AP_PORT) return (linkID_t)lid;
+	}
+	test_fail("no connection to the access point");
+	return (0);
+}
+
+
+// *************************************************************************************************
+// @fn          test_frame
+// @brief       Access point sends an application frame that carries its number.
+// @param       uint8_t n			Frame number
+// @return      mrfiPacket_t *		Frame on the air
+// *************************************************************************************************
+static mrfiPacket_t * test_frame(uint8_t n)
+{
+	uint8_t msg[5];
+
+	memset(msg, n, sizeof(msg));
+	return ap_send_app(msg, sizeof(msg));
+}
+
+
+// *************************************************************************************************
+// @fn          test_frames
+// @brief       Access point sends frames 'first' .. 'last' and time passes until they are received.
+// @param       uint8_t first		First frame number
+//				uint8_t last		Last frame number
+// @return      none
+// *************************************************************************************************
+static void test_frames(uint8_t first, uint8_t last)
+{
+	for (; first <= last; first++) test_frame(first);
+	Timer0_A4_Delay(SIM_MS(20));
+}
+
+
+// *************************************************************************************************
+// @fn          test_expect
+// @brief       Next frame SMPL_Receive returns must carry the given number.
+// @param       linkID_t lid		Link ID
+//				uint8_t n			Frame number, 0 = no frame expected
+// @return      none
+// *************************************************************************************************
+static void test_expect(linkID_t lid, uint8_t n)
+{
+	uint8_t msg[MAX_APP_PAYLOAD], len;
+	smplStatus_t rc;
+
+	memset(msg, 0, sizeof(msg));
+	rc = SMPL_Receive(lid, msg, &len);
+	if (!n)
+	{
+		if (rc != SMPL_NO_FRAME) test_fail("frame %u received, expected none", msg[0]);
+	}
+	else if (rc != SMPL_SUCCESS) test_fail("no frame, expected frame %u", n);
+	else if (len != 5 || msg[0] != n || msg[4] != n) test_fail("frame %u of %u bytes, expected frame %u", msg[0], len, n);
+}
+
+
+// *************************************************************************************************
+// @fn          test_queue
+// @brief       Input frame queue: frames of a connection come out in arrival order, a full queue
+//				casts out the oldest frame, also when the frame arrives while SMPL_Receive takes one.
+//				A frame held with SMPL_ReceiveFrame stays intact while others arrive and is given back
+//				with SMPL_ReleaseFrame.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_queue(void)
+{
+	uint8_t * held;
+	uint8_t len;
+	linkID_t lid;
+
+	test_begin("queue", 30);
+	ap_reset();
+	if (!test_link() || !(lid = test_lid())) return;
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_AWAKE, 0);
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_RXON, 0);
+
+	// Arrival order
+	test_frames(1, 2);
+	test_expect(lid, 1);
+	test_expect(lid, 2);
+	test_expect(lid, 0);
+
+	// Queue full: oldest frame cast out
+	test_frames(3, 5);
+	test_expect(lid, 4);
+	test_expect(lid, 5);
+	test_expect(lid, 0);
+
+	// Frame arrives while SMPL_Receive takes the oldest: the other queued frame goes
+	test_frames(6, 7);
+	test_frame(8);
+	race = 1;
+	test_expect(lid, 6);
+	if (race) test_fail("no frame arrived in the critical section");
+	test_expect(lid, 8);
+	test_expect(lid, 0);
+
+	// Held frame: not cast out, not overwritten
+	test_frames(9, 9);
+	if (SMPL_ReceiveFrame(lid, &held, &len) != SMPL_SUCCESS) test_fail("SMPL_ReceiveFrame: no frame");
+	else
+	{
+		test_frames(10, 11);
+		if (len != 5 || held[0] != 9 || held[4] != 9) test_fail("held frame %u of %u bytes, expected frame 9", held[0], len);
+		test_expect(lid, 11);
+		test_expect(lid, 0);
+		if (SMPL_ReleaseFrame(held) != SMPL_SUCCESS) test_fail("SMPL_ReleaseFrame of the held frame failed");
+		if (SMPL_ReleaseFrame(held) != SMPL_BAD_PARAM) test_fail("frame released twice");
+		if (SMPL_ReleaseFrame(held + 1) != SMPL_BAD_PARAM) test_fail("SMPL_ReleaseFrame of a bad pointer accepted");
+	}
+
+	// Released slot is used again
+	test_frames(12, 13);
+	test_expect(lid, 12);
+	test_expect(lid, 13);
+	test_expect(lid, 0);
+
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SLEEP, 0);
+	sInit_done = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          test_bulk
+// @brief       Memory download in sync mode: all frames reach the host, a lost frame is repeated
+//				after the ACK of its window, frames received are not repeated.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_bulk(void)
+{
+	uint16_t frames = 20;
+	uint16_t end = frames * BM_SYNC_BULK_LOG_PACKETS;
+	uint8_t * c;
+
+	test_begin("bulk", 30);
+	ap_reset();
+	if (!test_link()) return;
+
+	ap.bulk_drop = 5;
+	c = ap_command(SYNC_AP_CMD_GET_MEMORY_BULK, 0);
+	c[3] = (uint8_t)end;
+	c[4] = (uint8_t)(end >> 8);
+	ap_command(SYNC_AP_CMD_EXIT, 0);
+	clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP);
+	simpliciti_main_sync();
+
+	if (ap.cmd_next != ap.cmds) test_fail("%u of %u commands sent", ap.cmd_next, ap.cmds);
+	if (ap.bulk_next != frames) test_fail("host has frames up to %u, expected %u", ap.bulk_next, frames);
+	if (ap.bulk_frames != frames || ap.bulk_dups) test_fail("%lu frames with %lu repeated, expected %u frames", ap.bulk_frames, ap.bulk_dups, frames);
+	if (ap.bulk_bad) test_fail("%lu frames with wrong data", ap.bulk_bad);
+	if (ap.bulk_drop != -1) test_fail("frame to lose never sent");
+	if (simpliciti_bulk_packets) test_fail("download still pending");
+	sInit_done = 0;
+}
+
+
+#ifdef SMPL_SECURE
+// *************************************************************************************************
+// @fn          test_secure
+// @brief       Frame security: block cipher and accelerator model give the FIPS-197 result, the
+//				reference CMAC the RFC 4493 ones (every secured frame of all tests is checked against
+//				it). A frame with a flipped bit in the ciphertext or in the MAC and a replayed frame are
+//				rejected, and their input queue slots are free again.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void test_secure(void)
+{
+	static const uint8_t fips_key[16] =
+	{
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	};
+	static const uint8_t fips_in[16] =
+	{
+		0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF,
+	};
+	static const uint8_t fips_out[16] =
+	{
+		0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A,
+	};
+	static const uint8_t rfc_key[16] =
+	{
+		0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C,
+	};
+	static const uint8_t rfc_msg[40] =
+	{
+		0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+		0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+		0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11,
+	};
+	static const uint8_t rfc_len[3] = { 0, 16, 40 };
+	static const uint8_t rfc_mac[3][16] =
+	{
+		{ 0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46 },
+		{ 0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C },
+		{ 0xDF, 0xA6, 0x67, 0x47, 0xDE, 0x9A, 0xE6, 0x30, 0x30, 0xCA, 0x32, 0x61, 0x14, 0x97, 0xC8, 0x27 },
+	};
+	mrfiPacket_t * f, replay;
+	uint8_t out[16];
+	uint16_t w;
+	linkID_t lid;
+	u8 i;
+
+	test_begin("secure", 30);
+
+	sim_aes_encrypt(fips_key, fips_in, out);
+	if (memcmp(out, fips_out, 16)) test_fail("AES-128 differs from FIPS-197 C.1");
+
+	// Through the registers like nwk_security.c, then reset so the stack loads its key again
+	AESACTL0 = AESSWRST;
+	for (i = 0; i < 16; i += 2) AESAKEY = (uint16_t)(fips_key[i] | (fips_key[i + 1] << 8));
+	for (i = 0; i < 16; i += 2) AESADIN = (uint16_t)(fips_in[i] | (fips_in[i + 1] << 8));
+	while (AESASTAT & AESBUSY) ;
+	for (i = 0; i < 16; i += 2)
+	{
+		w = AESADOUT;
+		out[i]     = (uint8_t)w;
+		out[i + 1] = (uint8_t)(w >> 8);
+	}
+	if (memcmp(out, fips_out, 16)) test_fail("AES accelerator model differs from FIPS-197 C.1");
+	AESACTL0 = AESSWRST;
+
+	for (i = 0; i < 3; i++)
+	{
+		test_cmac(rfc_key, rfc_msg, rfc_len[i], out);
+		if (memcmp(out, rfc_mac[i], 16)) test_fail("reference CMAC differs from RFC 4493 example %u", i + 1);
+	}
+
+	ap_reset();
+	if (!test_link() || !(lid = test_lid())) return;
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_AWAKE, 0);
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_RXON, 0);
+
+	// Flipped bit in the ciphertext and in the MAC
+	f = test_frame(20);
+	MRFI_P_PAYLOAD(f)[F_APP_PAYLOAD_OS] ^= 0x01;
+	f = test_frame(21);
+	MRFI_P_PAYLOAD(f)[F_SEC_MAC_OS] ^= 0x80;
+	Timer0_A4_Delay(SIM_MS(20));
+	test_expect(lid, 0);
+
+	// Both slots free again
+	test_frames(22, 23);
+	test_expect(lid, 22);
+	test_expect(lid, 23);
+	test_expect(lid, 0);
+
+	// Frame received before sent again
+	replay = *test_frame(24);
+	Timer0_A4_Delay(SIM_MS(20));
+	test_expect(lid, 24);
+	ap_air(&replay);
+	Timer0_A4_Delay(SIM_MS(20));
+	test_expect(lid, 0);
+	test_frames(25, 25);
+	test_expect(lid, 25);
+
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SLEEP, 0);
+	sInit_done = 0;
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          main
+// @brief       Run all tests.
+// @param       none
+// @return      0 if all checks passed
+// *************************************************************************************************
+int main(void)
+{
+	sim_bis_sr(GIE);
+
+	test_power();
+	test_resume();
+	test_move();
+	test_queue();
+	test_bulk();
+#ifdef SMPL_SECURE
+	test_secure();
+#endif
+
+	printf("\n=== " TEST_NAME " ===\n");
+	printf("%-24s %12lu\n", "frames sent", radio.tx_frames);
+	printf("%-24s %12lu\n", "frames received", radio.rx_frames);
+	printf("%-24s %12lu\n", "frames lost", radio.lost);
+	printf("%-24s %12llu\n", "air time (ms)", (unsigned long long)(air_time * 1000 / SIM_ACLK_HZ));
+	printf("%-24s %12llu\n", "virtual time (s)", (unsigned long long)(now / SIM_ACLK_HZ));
+#ifdef SMPL_SECURE
+	printf("%-24s %12lu\n", "AES blocks", aes.blocks);
+	printf("%-24s %12lu\n", "frames checked (ref.)", sec_checked);
+#endif
+	printf("%-24s %12lu\n", "failed checks", failures);
+	return failures ? 1 : 0;
+}
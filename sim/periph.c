@@ -0,0 +1,2125 @@
+// *************************************************************************************************
+// Host simulation: register-level models of the CC430F6137 peripherals used by the firmware and
+// of the parts soldered next to it (CMA3000 accelerometer on USCI_A0, SCP1000 pressure sensor on
+// the bit-banged TWI port, buttons on PORT2).
+//
+// Registers live in sim_mem. periph_access() runs before the firmware touches a register and
+// refreshes whatever the hardware would return; periph_commit() runs once the firmware has moved
+// on and reacts to what it wrote.
+// *************************************************************************************************
+
+// *************************************************************************************************
+// Include section
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Defines section
+
+// Register addresses (CC430F613x datasheet)
+#define R_SFRIFG1			(0x0102)
+#define R_PMMIFG			(0x012C)
+#define R_FCTL1				(0x0140)
+#define R_FCTL3				(0x0144)
+#define R_WDTCTL			(0x015C)
+#define R_REFCTL0			(0x01B0)
+#define R_P2IN				(0x0201)
+#define R_P2OUT				(0x0203)
+#define R_P2DIR				(0x0205)
+#define R_P2SEL				(0x020B)
+#define R_P2IES				(0x0219)
+#define R_P2IE				(0x021B)
+#define R_P2IFG				(0x021D)
+#define R_P2IV				(0x021E)
+#define R_PJIN				(0x0320)
+#define R_PJOUT				(0x0322)
+#define R_PJDIR				(0x0324)
+#define R_TA0CTL			(0x0340)
+#define R_TA0CCTL(n)		(0x0342 + 2 * (n))
+#define R_TA0R				(0x0350)
+#define R_TA0CCR(n)			(0x0352 + 2 * (n))
+#define R_TA0IV				(0x036E)
+#define R_TA1CTL			(0x0380)
+#define R_RTCCTL01			(0x04A0)
+#define R_RTCPS				(0x04AC)
+#define R_RTCIV				(0x04AE)
+#define R_RTCSEC			(0x04B0)
+#define R_RTCMIN			(0x04B1)
+#define R_RTCHOUR			(0x04B2)
+#define R_UCA0BRW			(0x05C6)
+#define R_UCA0RXBUF			(0x05CC)
+#define R_UCA0TXBUF			(0x05CE)
+#define R_UCA0IFG			(0x05DD)
+#define R_ADC12CTL0			(0x0700)
+#define R_ADC12CTL1			(0x0702)
+#define R_ADC12IFG			(0x070A)
+#define R_ADC12IE			(0x070C)
+#define R_ADC12IV			(0x070E)
+#define R_ADC12MCTL0		(0x0710)
+#define R_ADC12MEM0			(0x0720)
+#define R_AESACTL0			(0x09C0)
+#define R_AESASTAT			(0x09C4)
+#define R_AESAKEY			(0x09C6)
+#define R_AESADIN			(0x09C8)
+#define R_AESADOUT			(0x09CA)
+#define R_LCDBCTL0			(0x0A00)
+#define R_LCDBMEMCTL		(0x0A06)
+#define R_LCDBVCTL			(0x0A08)
+#define R_LCDMEM			(0x0A20)
+#define R_LCDBMEM			(0x0A40)
+#define R_RF1AIFCTL1		(0x0F02)
+#define R_RF1AINSTRW		(0x0F10)
+#define R_RF1AINSTRB		(0x0F11)
+#define R_RF1AINSTR1B		(0x0F13)
+#define R_RF1ADOUT0B		(0x0F20)
+#define R_RF1ASTATB			(0x0F21)
+#define R_RF1ADOUT1B		(0x0F22)
+#define R_RF1AIN			(0x0F30)
+#define R_RF1AIFG			(0x0F32)
+#define R_RF1AIE			(0x0F36)
+
+// Register bits
+#define TA_MC				(0x0030)
+#define TA_TACLR			(0x0004)
+#define TA_TAIE				(0x0002)
+#define TA_TAIFG			(0x0001)
+#define TA_CCIE				(0x0010)
+#define TA_CCIFG			(0x0001)
+#define RTC_HOLD			(0x4000)
+#define RTC_MODE			(0x2000)
+#define RTC_TEV				(0x0300)
+#define RTC_TEVIE			(0x0040)
+#define RTC_TEVIFG			(0x0004)
+#define WDT_PW				(0x5A00)
+#define WDT_HOLD			(0x0080)
+#define WDT_SSEL			(0x0060)
+#define WDT_CNTCL			(0x0008)
+#define WDT_IS				(0x0007)
+#define FC_ERASE			(0x0002)
+#define FC_WRT				(0x0040)
+#define FC_BLKWRT			(0x0080)
+#define FC_ACCVIFG			(0x0004)
+#define FC_LOCK				(0x0010)
+#define FC_LOCKA			(0x0040)
+#define UC_RXIFG			(0x01)
+#define UC_TXIFG			(0x02)
+#define ADC_SC				(0x0001)
+#define ADC_ENC				(0x0002)
+#define ADC_ON				(0x0010)
+#define ADC_BUSY			(0x0001)
+#define REF_ON				(0x0001)
+#define LCD_ON				(0x0001)
+#define LCD_CLRM			(0x0002)
+#define LCD_CLRBM			(0x0004)
+#define LCD_CPEN			(0x0008)
+#define AES_OP				(0x0003)
+#define AES_SWRST			(0x0080)
+#define AES_BUSY			(0x0001)
+#define AES_KEYWR			(0x0002)
+#define AES_DOUTRD			(0x0008)
+#define RF_IFCTL_READY		(0x009C)		// RFINSTRIFG | RFDOUTIFG | RFSTATIFG | RFDINIFG
+#define RF1A_IFG9			(0x0200)		// Sync word received / end of packet
+
+// Pins
+#define P2_BACKLIGHT		(0x08)
+#define P2_BUZZER			(0x80)
+#define PJ_AS_PWR			(0x01)
+#define PJ_AS_CSN			(0x02)
+#define PJ_PS_SDA			(0x04)
+#define PJ_PS_SCL			(0x08)
+
+// RTC_A calendar
+#define RTC_MINUTE			(60u * SIM_ACLK_HZ)
+#define RTC_DAY				(86400u * SIM_ACLK_HZ)
+
+// SCP1000 on the TWI bus
+#define PS_TWI_ADDRESS		(0x11)
+#define PS_STARTUP			SIM_MS(60)
+
+// Radio core states (MARCSTATE as reported in the status byte, WOR reads as SLEEP)
+enum { RADIO_SLEEP = 0, RADIO_IDLE, RADIO_RX, RADIO_TX, RADIO_WOR, RADIO_STATES };
+
+// Wake-on-Radio: RC oscillator period (750 / 26MHz) and carrier sense time after RX start
+#define RADIO_WOR_PERIOD_NS	(28846u)
+#define RADIO_WOR_CS_NS		(300000u)
+
+// CMA3000 operation modes (CTRL bits 3..1)
+enum { AS_OFF = 0, AS_100HZ, AS_400HZ, AS_40HZ, AS_MD, AS_FF100, AS_FF400, AS_MODES };
+
+// SCP1000 operation modes (OPERATION register)
+enum { PS_STANDBY = 0, PS_HIGH_SPEED, PS_HIGH_RES, PS_LOW_POWER, PS_TRIGGERED, PS_MODES };
+
+// TWI slave states
+enum { TWI_IDLE = 0, TWI_ADDRESS, TWI_WRITE, TWI_READ };
+
+// AES accelerator: MCLK cycles for one encryption with a 128-bit key
+#define AES_CYCLES			(167u)
+
+
+// *************************************************************************************************
+// Global Variable section
+static struct
+{
+	sim_time_t	origin;					// Time at which TA0R was 0 (running)
+	uint16_t	hold;					// TA0R while stopped
+	uint16_t	shadow;					// TA0R value handed to the firmware
+	uint8_t		running;
+} ta0;
+
+static struct
+{
+	sim_time_t	offset;					// Time of day at sim time 0 (running)
+	sim_time_t	hold;					// Time of day while held
+	uint8_t		running;
+} rtc;
+
+static struct
+{
+	uint8_t		ext;					// Levels driven from outside (buttons, sensor interrupts)
+	uint8_t		in;						// Last P2IN seen by the edge detector
+} p2;
+
+static struct
+{
+	sim_time_t	last_kick;
+	uint64_t	kicks;
+	uint16_t	ctl;
+} wdt;
+
+static struct
+{
+	sim_time_t	done;
+	uint64_t	conversions;
+	sim_time_t	ref_ticks;
+} adc;
+
+static struct
+{
+	uint8_t		reg[16];
+	uint8_t		mode;
+	uint8_t		frame;					// Bytes in the current SPI frame
+	uint8_t		address;
+	uint8_t		rx;
+	uint64_t	rx_cycle;				// MCLK cycle at which the SPI byte is complete
+	uint8_t		rx_pending;
+	sim_time_t	next;					// Next sample
+	uint64_t	samples;
+	uint8_t		log[256][3];			// Last samples, by sample number
+	sim_time_t	ticks[AS_MODES];
+	int8_t		md_ref[3];				// Last sample of motion detection
+	uint8_t		md_valid;
+	uint64_t	motions;				// Motion detection interrupts
+} as;
+
+static struct
+{
+	uint8_t		mode;
+	uint8_t		eeprom;					// DATARD8 still holds the EEPROM checksum result
+	sim_time_t	startup;				// End of power-on / reset sequence
+	sim_time_t	next;					// Next conversion result
+	uint32_t	pressure;				// Latched DATARD8/DATARD16 (Pa * 4)
+	uint16_t	temperature;			// Latched TEMPOUT (degC * 20)
+	uint64_t	samples;
+	sim_time_t	ticks[PS_MODES];
+} ps;
+
+static struct
+{
+	uint8_t		scl, sda;
+	uint8_t		state;
+	uint8_t		bits;
+	uint8_t		byte;
+	uint8_t		drive_low;
+	uint8_t		rw;
+	uint8_t		first;					// Next written byte is the register pointer
+	uint8_t		ptr;
+	uint8_t		tx[2];
+	uint8_t		tx_len, tx_pos;
+	uint8_t		master_ack;
+	uint64_t	transfers;
+} twi;
+
+static struct
+{
+	uint8_t		reg[64];
+	uint8_t		patable;
+	uint8_t		dout;
+	uint8_t		state;
+	uint64_t	strobes;
+	sim_time_t	ticks[RADIO_STATES];
+	sim_time_t	burst_until;
+	uint8_t		burst_state;
+	uint32_t	wor_na;
+} radio;
+
+static struct
+{
+	uint8_t		key[16];
+	uint8_t		din[16];
+	uint8_t		dout[16];
+	uint8_t		key_pos, din_pos, dout_pos;
+	uint64_t	done_cycle;				// sim_cycles at which AESBUSY clears
+	uint64_t	blocks;
+} aes;
+
+static struct
+{
+	uint64_t	erases;
+	uint64_t	words;
+	uint64_t	violations;
+} flash;
+
+// Vertical motion (scenario 'climb') and the vario readings taken off LINE2 while it lasts
+#define FLIGHT_GRID			(SIM_ACLK_HZ / 8)	// Reading interval (ticks)
+#define FLIGHT_READINGS		(65536u)			// 2.3 hours
+#define FLIGHT_LAG_MAX		(80u)				// Longest lag searched (readings)
+
+static struct
+{
+	uint8_t		active;
+	sim_time_t	next;					// Next reading
+	unsigned	count;
+	float		climb[FLIGHT_READINGS];	// True vertical speed (m/s)
+	float		shown[FLIGHT_READINGS];	// Vario reading (m/s), NAN = none on LINE2
+} flight;
+
+// Walking (scenario 'walk' or 'accel trace') and the step count taken off LINE2
+#define WALK_STILL			(0u)
+#define WALK_MOVING			(1u)
+
+static struct
+{
+	uint8_t		active;
+	double		phase;					// Step phase, a step is taken at every whole number
+	double		rate;					// Cadence jitter of the current step
+	uint64_t	steps;					// True steps
+	sim_time_t	ticks[2];				// Time still / moving
+	uint64_t	wakeups[2];				// LPM wakeups
+	uint64_t	irqs[2];				// PORT2 interrupts
+	double		charge[2];				// nA * ticks
+	uint64_t	last_wakeups;
+	uint64_t	last_irqs;
+	double		last_charge;
+} walk;
+
+// Recorded acceleration ('accel trace'): samples and annotated steps, times relative to the start
+struct trace_sample
+{
+	double		t;						// s
+	double		g[3];					// g
+};
+
+static struct
+{
+	struct trace_sample *	samples;
+	unsigned				count;
+	double *				steps;
+	unsigned				step_count;
+	uint8_t					running;
+	sim_time_t				start;
+	unsigned				pos;
+	unsigned				step_pos;
+} trace;
+
+static sim_time_t buzzer_ticks;
+static sim_time_t backlight_ticks;
+static uint8_t backlight_on;
+static uint64_t backlight_switch_ons, backlight_no_button;		// Switched on, without B/L button
+static sim_time_t lcd_ticks;
+
+static const char * const as_mode_names[AS_MODES] =
+{
+	"off", "100Hz", "400Hz", "40Hz", "motion", "free fall 100Hz", "free fall 400Hz",
+};
+
+static const char * const ps_mode_names[PS_MODES] =
+{
+	"standby", "high speed", "high resolution", "ultra low power", "triggered",
+};
+
+static const char * const radio_state_names[RADIO_STATES] =
+{
+	"sleep", "idle", "RX", "TX", "WOR",
+};
+
+
+// Gaussian sensor noise, each sensor uses a fixed seed of its own so that runs are reproducible
+static double noise(uint32_t * seed)
+{
+	double u1, u2;
+
+	*seed = *seed * 1103515245u + 12345u;
+	u1 = ((*seed >> 8) + 0.5) / 16777216.0;
+	*seed = *seed * 1103515245u + 12345u;
+	u2 = ((*seed >> 8) + 0.5) / 16777216.0;
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+
+// *************************************************************************************************
+// Timer0_A5 (continuous mode, ACLK)
+// *************************************************************************************************
+static uint16_t ta0_count(sim_time_t t)
+{
+	return ta0.running ? (uint16_t)(t - ta0.origin) : ta0.hold;
+}
+
+
+// First time after t at which TA0R counts to value
+static sim_time_t ta0_match(sim_time_t t, uint16_t value)
+{
+	return t + (uint16_t)(value - ta0_count(t) - 1) + 1;
+}
+
+
+static void ta0_control(void)
+{
+	uint16_t ctl = sim_rd16(R_TA0CTL);
+	uint8_t run = (ctl & TA_MC) != 0;
+
+	if (ctl & TA_TACLR)
+	{
+		ta0.origin = sim_now;
+		ta0.hold   = 0;
+		sim_wr16(R_TA0CTL, ctl & ~TA_TACLR);
+	}
+	if (run && !ta0.running) ta0.origin = sim_now - ta0.hold;
+	if (!run && ta0.running) ta0.hold = ta0_count(sim_now);
+	ta0.running = run;
+}
+
+
+static void ta0_advance(sim_time_t from, sim_time_t to)
+{
+	uint16_t cctl;
+	int n;
+
+	if (!ta0.running) return;
+
+	for (n = 0; n < 5; n++)
+	{
+		if (ta0_match(from, sim_rd16(R_TA0CCR(n))) <= to)
+		{
+			cctl = sim_rd16(R_TA0CCTL(n));
+			sim_wr16(R_TA0CCTL(n), cctl | TA_CCIFG);
+		}
+	}
+	if (ta0_match(from, 0) <= to) sim_wr16(R_TA0CTL, sim_rd16(R_TA0CTL) | TA_TAIFG);
+}
+
+
+// Highest priority enabled TA0IV source
+static uint16_t ta0_vector(void)
+{
+	int n;
+
+	for (n = 1; n < 5; n++)
+	{
+		if ((sim_rd16(R_TA0CCTL(n)) & (TA_CCIE | TA_CCIFG)) == (TA_CCIE | TA_CCIFG)) return 2 * n;
+	}
+	if ((sim_rd16(R_TA0CTL) & (TA_TAIE | TA_TAIFG)) == (TA_TAIE | TA_TAIFG)) return 0x0E;
+	return 0;
+}
+
+
+// *************************************************************************************************
+// RTC_A (calendar mode, ACLK). Only the time of day and the minute event are modelled.
+// *************************************************************************************************
+static sim_time_t rtc_time(sim_time_t t)
+{
+	return rtc.running ? (t + rtc.offset) % RTC_DAY : rtc.hold;
+}
+
+
+// Time registers and prescalers as the counters show them. RT1PS counts at 128 Hz, its bit 7
+// toggles with every second.
+static void rtc_refresh(void)
+{
+	sim_time_t tod = rtc_time(sim_now);
+	uint32_t s = (uint32_t)(tod / SIM_ACLK_HZ);
+
+	sim_wr8(R_RTCSEC, (uint8_t)(s % 60));
+	sim_wr8(R_RTCMIN, (uint8_t)(s / 60 % 60));
+	sim_wr8(R_RTCHOUR, (uint8_t)(s / 3600));
+	sim_wr16(R_RTCPS, (uint16_t)(((s & 1) << 15) | (tod % SIM_ACLK_HZ)));
+}
+
+
+// Time of day loaded by the firmware while the RTC is held
+static sim_time_t rtc_loaded(void)
+{
+	uint8_t sec = sim_rd8(R_RTCSEC), min = sim_rd8(R_RTCMIN), hour = sim_rd8(R_RTCHOUR);
+
+	if (sec > 59 || min > 59 || hour > 23) sim_fail("RTC_A loaded with an invalid time %u:%u:%u", hour, min, sec);
+	return (sim_time_t)(hour * 3600u + min * 60u + sec) * SIM_ACLK_HZ + (sim_rd16(R_RTCPS) & 0x7FFF);
+}
+
+
+static void rtc_control(void)
+{
+	uint16_t ctl = sim_rd16(R_RTCCTL01);
+	uint8_t run = !(ctl & RTC_HOLD);
+
+	if (run && (!(ctl & RTC_MODE) || (ctl & RTC_TEV))) sim_fail("RTC_A: only calendar mode with the minute event is modelled");
+	if (run && !rtc.running) rtc.offset = (rtc_loaded() + RTC_DAY - sim_now % RTC_DAY) % RTC_DAY;
+	if (!run && rtc.running)
+	{
+		rtc.hold = rtc_time(sim_now);
+		rtc.running = 0;
+		rtc_refresh();
+	}
+	rtc.running = run;
+}
+
+
+static void rtc_advance(sim_time_t from, sim_time_t to)
+{
+	if (!rtc.running) return;
+	if ((to + rtc.offset) / RTC_MINUTE != (from + rtc.offset) / RTC_MINUTE)
+	{
+		sim_wr16(R_RTCCTL01, sim_rd16(R_RTCCTL01) | RTC_TEVIFG);
+	}
+}
+
+
+// *************************************************************************************************
+// PORT2 inputs and edge detection
+// *************************************************************************************************
+static void p2_update(void)
+{
+	uint8_t dir = sim_rd8(R_P2DIR);
+	uint8_t in  = (uint8_t)((p2.ext & ~dir) | (sim_rd8(R_P2OUT) & dir));
+	uint8_t ies = sim_rd8(R_P2IES);
+	uint8_t rise = (uint8_t)(in & ~p2.in & ~ies);
+	uint8_t fall = (uint8_t)(~in & p2.in & ies);
+
+	sim_wr8(R_P2IN, in);
+	if (rise | fall)
+	{
+		sim_wr8(R_P2IFG, sim_rd8(R_P2IFG) | rise | fall);
+		sim_irq_update();
+	}
+	p2.in = in;
+}
+
+
+void periph_set_inputs(uint8_t mask, uint8_t value)
+{
+	p2.ext = (uint8_t)((p2.ext & ~mask) | (value & mask));
+	p2_update();
+}
+
+
+uint8_t periph_get_inputs(void)
+{
+	return p2.ext;
+}
+
+
+// *************************************************************************************************
+// Walking and recorded acceleration traces
+// *************************************************************************************************
+
+// *************************************************************************************************
+// @fn          walk_rest
+// @brief       Reading at rest. During a turn of the wrist it rotates from the last reading to the
+//				new one at constant angular speed, the magnitude changes linearly.
+// @param       double * g		X/Y/Z (g)
+// @return      none
+// *************************************************************************************************
+static void walk_rest(double * g)
+{
+	double a = 0.0, b = 0.0, ab = 0.0, t, angle, wa, wb, len;
+	int i;
+
+	memcpy(g, sim_env.accel, sizeof(sim_env.accel));
+	if (sim_now >= sim_env.turn_end) return;
+
+	t = (double)(sim_now - sim_env.turn_start) / (double)(sim_env.turn_end - sim_env.turn_start);
+	for (i = 0; i < 3; i++)
+	{
+		a  += sim_env.turn_from[i] * sim_env.turn_from[i];
+		b  += sim_env.accel[i] * sim_env.accel[i];
+		ab += sim_env.turn_from[i] * sim_env.accel[i];
+	}
+	a = sqrt(a);
+	b = sqrt(b);
+	if (a == 0.0 || b == 0.0) return;
+
+	// Spherical interpolation of the directions, straight line if they (nearly) coincide
+	angle = acos(fmax(-1.0, fmin(1.0, ab / (a * b))));
+	if (angle < 1e-3 || angle > M_PI - 1e-3)
+	{
+		wa = 1.0 - t;
+		wb = t;
+	}
+	else
+	{
+		wa = sin((1.0 - t) * angle) / sin(angle);
+		wb = sin(t * angle) / sin(angle);
+	}
+	len = 0.0;
+	for (i = 0; i < 3; i++)
+	{
+		g[i] = wa * sim_env.turn_from[i] / a + wb * sim_env.accel[i] / b;
+		len += g[i] * g[i];
+	}
+	len = sqrt(len);
+	for (i = 0; i < 3; i++) g[i] *= (len > 0.0) ? ((1.0 - t) * a + t * b) / len : 0.0;
+}
+
+
+// *************************************************************************************************
+// @fn          walk_accel
+// @brief       Acceleration at the sensor: the recorded trace while it plays, otherwise the reading
+//				at rest, scaled along gravity by vertical acceleration and the steps of a walk. The
+//				arm swings sideways once per stride on the axis least aligned with gravity.
+// @param       double * g		X/Y/Z (g)
+// @return      none
+// *************************************************************************************************
+static void walk_accel(double * g)
+{
+	double f = 1.0 + sim_env.vaccel / 9.80665, t, rest[3];
+	int i, k = 0;
+
+	if (trace.running)
+	{
+		t = (double)(sim_now - trace.start) / SIM_ACLK_HZ;
+		while (trace.pos + 1 < trace.count && trace.samples[trace.pos + 1].t <= t) trace.pos++;
+		memcpy(g, trace.samples[trace.pos].g, sizeof(trace.samples[0].g));
+		return;
+	}
+
+	if (sim_env.cadence > 0.0)
+	{
+		// Push-off and heel strike: one swing per step with a sharper peak
+		f += sim_env.step_g * (sin(2.0 * M_PI * walk.phase) + 0.25 * sin(4.0 * M_PI * walk.phase));
+	}
+	walk_rest(rest);
+	for (i = 0; i < 3; i++)
+	{
+		g[i] = rest[i] * f;
+		if (fabs(rest[i]) < fabs(rest[k])) k = i;
+	}
+	if (sim_env.cadence > 0.0) g[k] += 0.15 * sin(M_PI * walk.phase);
+}
+
+
+// *************************************************************************************************
+// @fn          walk_advance
+// @brief       Take the steps of a walk or play the trace. Time, wakeups, PORT2 interrupts and
+//				charge go to the activity (moving or still) during the span, from the first step on.
+// @param       sim_time_t from, to		Time span
+// @return      none
+// *************************************************************************************************
+static void walk_advance(sim_time_t from, sim_time_t to)
+{
+	static uint32_t seed = 11;
+	uint8_t state = (sim_env.cadence > 0.0 || trace.running) ? WALK_MOVING : WALK_STILL;
+	uint64_t wakeups, irqs;
+	double charge, t;
+
+	if (!walk.active)
+	{
+		if (state == WALK_STILL) return;
+		walk.active       = 1;
+		walk.rate         = 1.0;
+		walk.last_wakeups = sim_wakeups();
+		walk.last_irqs    = sim_irq_calls(SIM_IRQ_PORT2);
+		walk.last_charge  = sim_total_charge();
+	}
+
+	wakeups = sim_wakeups();
+	irqs    = sim_irq_calls(SIM_IRQ_PORT2);
+	charge  = sim_total_charge();
+	walk.ticks[state]   += to - from;
+	walk.wakeups[state] += wakeups - walk.last_wakeups;
+	walk.irqs[state]    += irqs - walk.last_irqs;
+	walk.charge[state]  += charge - walk.last_charge;
+	walk.last_wakeups = wakeups;
+	walk.last_irqs    = irqs;
+	walk.last_charge  = charge;
+
+	if (sim_env.cadence > 0.0)
+	{
+		walk.phase += (double)(to - from) / SIM_ACLK_HZ * sim_env.cadence / 60.0 * walk.rate;
+		while (walk.phase >= 1.0)
+		{
+			// Step intervals vary by 3% rms
+			walk.phase -= 1.0;
+			walk.steps++;
+			walk.rate = 1.0 + 0.03 * noise(&seed);
+		}
+	}
+
+	if (trace.running)
+	{
+		t = (double)(to - trace.start) / SIM_ACLK_HZ;
+		while (trace.step_pos < trace.step_count && trace.steps[trace.step_pos] <= t)
+		{
+			trace.step_pos++;
+			walk.steps++;
+		}
+		if (t > trace.samples[trace.count - 1].t) trace.running = 0;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          periph_trace_load
+// @brief       Read a recorded acceleration trace. One sample or annotated step per line, times in
+//				seconds from the start of the trace, rising:
+//
+//					<t> <x> <y> <z>		acceleration (g), held until the next sample
+//					<t> step			true step, for the walk report
+//
+//				'#' starts a comment.
+// @param       const char * path		Trace file
+// @return      int						0 on success
+// *************************************************************************************************
+int periph_trace_load(const char * path)
+{
+	char line[256], word[16], * p;
+	struct trace_sample s;
+	double last = -1.0;
+	unsigned lineno = 0;
+	void * grown;
+	FILE * f;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		lineno++;
+		if ((p = strchr(line, '#')) != NULL) *p = '\0';
+		if (sscanf(line, " %lf", &s.t) != 1) continue;
+		if (s.t < last) goto syntax;
+		last = s.t;
+
+		if (sscanf(line, " %*f %lf %lf %lf", &s.g[0], &s.g[1], &s.g[2]) == 3)
+		{
+			if ((trace.count & 0xFFF) == 0)
+			{
+				grown = realloc(trace.samples, (trace.count + 0x1000) * sizeof(trace.samples[0]));
+				if (grown == NULL) goto syntax;
+				trace.samples = grown;
+			}
+			trace.samples[trace.count++] = s;
+		}
+		else if (sscanf(line, " %*f %15s", word) == 1 && strcmp(word, "step") == 0)
+		{
+			if ((trace.step_count & 0xFFF) == 0)
+			{
+				grown = realloc(trace.steps, (trace.step_count + 0x1000) * sizeof(trace.steps[0]));
+				if (grown == NULL) goto syntax;
+				trace.steps = grown;
+			}
+			trace.steps[trace.step_count++] = s.t;
+		}
+		else goto syntax;
+	}
+	fclose(f);
+
+	if (trace.count == 0)
+	{
+		fprintf(stderr, "%s: no samples\n", path);
+		return -1;
+	}
+	return 0;
+
+syntax:
+	fprintf(stderr, "%s:%u: cannot parse trace line\n", path, lineno);
+	fclose(f);
+	return -1;
+}
+
+
+// *************************************************************************************************
+// @fn          periph_trace_start
+// @brief       Play the loaded trace from now on.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void periph_trace_start(void)
+{
+	trace.running  = (trace.count > 0);
+	trace.start    = sim_now;
+	trace.pos      = 0;
+	trace.step_pos = 0;
+}
+
+
+// *************************************************************************************************
+// CMA3000-D01 acceleration sensor (SPI on USCI_A0, CSN=PJ.1, VDD=PJ.0, INT=P2.5)
+// *************************************************************************************************
+static uint8_t as_powered(void)
+{
+	return (sim_rd16(R_PJOUT) & sim_rd16(R_PJDIR) & PJ_AS_PWR) != 0;
+}
+
+
+static sim_time_t as_period(void)
+{
+	switch (as.mode)
+	{
+		case AS_100HZ:
+		case AS_FF100:	return SIM_ACLK_HZ / 100;
+		case AS_400HZ:
+		case AS_FF400:	return SIM_ACLK_HZ / 400;
+		case AS_40HZ:	return SIM_ACLK_HZ / 40;
+		case AS_MD:		return SIM_ACLK_HZ / 10;
+		default:		return 0;
+	}
+}
+
+
+static void as_reset(void)
+{
+	memset(as.reg, 0, sizeof(as.reg));
+	as.reg[0x00] = 0x10;				// WHO_AM_I
+	as.reg[0x01] = 0x40;				// REVID
+	as.mode = AS_OFF;
+	as.next = SIM_NEVER;
+	periph_set_inputs(SIM_AS_INT, 0);
+}
+
+
+static int8_t as_counts(double g)
+{
+	// 2g range: 18mg/digit, 8g range: 71mg/digit
+	double counts = g * ((as.reg[0x02] & 0x80) ? 56.0 : 14.0);
+
+	if (counts > 127.0) counts = 127.0;
+	if (counts < -128.0) counts = -128.0;
+	return (int8_t)lrint(counts);
+}
+
+
+static void as_sample(void)
+{
+	static uint32_t seed = 3;
+	double g[3];
+	int8_t xyz[3];
+	uint8_t motion = 0, threshold = as.reg[0x09] ? as.reg[0x09] : 1;
+	int i;
+
+	walk_accel(g);
+	for (i = 0; i < 3; i++)
+	{
+		xyz[i] = as_counts(g[i] + ((sim_env.accel_noise > 0.0) ? sim_env.accel_noise * noise(&seed) : 0.0));
+	}
+
+	if (as.mode == AS_MD)
+	{
+		// Motion detection: an axis changed by MDTHR counts or more since the last 10Hz sample. 
+		// INT stays high until INT_STATUS is read, there is no output data.
+		for (i = 0; i < 3; i++)
+		{
+			if (as.md_valid && abs(xyz[i] - as.md_ref[i]) >= threshold) motion = 1;
+			as.md_ref[i] = xyz[i];
+		}
+		as.md_valid = 1;
+		if (motion && !(as.reg[0x05] & 0x01))
+		{
+			as.reg[0x05] |= 0x01;
+			as.motions++;
+			periph_set_inputs(SIM_AS_INT, SIM_AS_INT);
+		}
+		return;
+	}
+
+	memcpy(&as.reg[0x06], xyz, 3);
+	memcpy(as.log[as.samples & 0xFF], &as.reg[0x06], 3);
+	as.samples++;
+	periph_set_inputs(SIM_AS_INT, SIM_AS_INT);
+}
+
+
+static void as_write(uint8_t address, uint8_t value)
+{
+	if (address == 0x04)
+	{
+		// Reset sequence 0x02, 0x0A, 0x04
+		if (value == 0x04 && as.reg[0x04] == 0x0A) as_reset();
+		else as.reg[0x04] = value;
+		return;
+	}
+	// MDTHR, MDFFTMR, FFTHR
+	if (address >= 0x09 && address <= 0x0B) as.reg[address] = value;
+	if (address != 0x02) return;
+
+	// A new mode starts without pending data or motion
+	as.reg[0x02] = value;
+	as.reg[0x05] = 0;
+	as.mode = (value >> 1) & 0x07;
+	if (as.mode >= AS_MODES) as.mode = AS_OFF;
+	as.md_valid = 0;
+	as.next = as_period() ? sim_now + as_period() : SIM_NEVER;
+	periph_set_inputs(SIM_AS_INT, 0);
+}
+
+
+// One byte exchanged on the SPI bus
+static uint8_t as_spi(uint8_t mosi)
+{
+	uint8_t miso = 0;
+
+	if (!as_powered() || (sim_rd16(R_PJOUT) & PJ_AS_CSN)) return 0;
+
+	if (as.frame++ == 0)
+	{
+		as.address = mosi;
+	}
+	else if (as.address & 0x02)
+	{
+		as_write((uint8_t)(as.address >> 2), mosi);
+	}
+	else
+	{
+		miso = as.reg[(as.address >> 2) & 0x0F];
+		// Reading the output registers or INT_STATUS releases INT
+		if ((as.address >> 2) >= 0x06 && (as.address >> 2) <= 0x08) periph_set_inputs(SIM_AS_INT, 0);
+		if ((as.address >> 2) == 0x05)
+		{
+			as.reg[0x05] = 0;
+			periph_set_inputs(SIM_AS_INT, 0);
+		}
+	}
+	return miso;
+}
+
+
+// *************************************************************************************************
+// SCP1000-D11 pressure sensor (TWI slave 0x11, SDA=PJ.2, SCL=PJ.3, DRDY=P2.6)
+// *************************************************************************************************
+static sim_time_t ps_period(void)
+{
+	switch (ps.mode)
+	{
+		case PS_HIGH_SPEED:	return SIM_ACLK_HZ / 9;
+		case PS_HIGH_RES:	return SIM_ACLK_HZ * 10 / 18;
+		case PS_LOW_POWER:	return SIM_ACLK_HZ;
+		default:			return 0;
+	}
+}
+
+
+static void ps_sample(void)
+{
+	static uint32_t seed = 5;
+	double t = sim_env.temperature * 20.0;
+	double p = sim_env.pressure;
+
+	if (sim_env.pressure_noise > 0.0) p += sim_env.pressure_noise * noise(&seed);
+	ps.pressure    = (uint32_t)lrint(p * 4.0) & 0x7FFFF;
+	ps.temperature = (uint16_t)((int16_t)lrint(t) & 0x3FFF);
+	ps.eeprom      = 0;
+	ps.samples++;
+	periph_set_inputs(SIM_PS_INT, SIM_PS_INT);
+}
+
+
+static void ps_write(uint8_t address, uint8_t value)
+{
+	if (address == 0x06 && (value & 0x01))
+	{
+		// Soft reset
+		ps.mode    = PS_STANDBY;
+		ps.eeprom  = 1;
+		ps.startup = sim_now + PS_STARTUP;
+		ps.next    = SIM_NEVER;
+		periph_set_inputs(SIM_PS_INT, 0);
+	}
+	else if (address == 0x03)
+	{
+		switch (value)
+		{
+			case 0x09:	ps.mode = PS_HIGH_SPEED; break;
+			case 0x0A:	ps.mode = PS_HIGH_RES; break;
+			case 0x0B:	ps.mode = PS_LOW_POWER; break;
+			case 0x0C:	ps.mode = PS_TRIGGERED; break;
+			default:	ps.mode = PS_STANDBY; break;
+		}
+		if (ps.mode == PS_TRIGGERED) ps.next = sim_now + SIM_MS(110);
+		else if (ps.mode != PS_STANDBY) ps.next = sim_now + ps_period();
+		else ps.next = SIM_NEVER;
+	}
+}
+
+
+// Prepare the bytes returned for a register read
+static void ps_read(uint8_t address)
+{
+	twi.tx_pos = 0;
+	twi.tx_len = 1;
+	switch (address)
+	{
+		case 0x07:	// STATUS: STARTUP bit while resetting, DRDY; bit 6 reads back set on the D11
+			twi.tx[0] = (sim_now < ps.startup) ? 0x01 : (uint8_t)(0x40 | ((p2.ext & SIM_PS_INT) ? 0x20 : 0));
+			break;
+		case 0x7F:	// DATARD8: EEPROM checksum result after reset, then pressure bits 18..16
+			twi.tx[0] = ps.eeprom ? 0x01 : (uint8_t)(ps.pressure >> 16);
+			break;
+		case 0x80:	// DATARD16: pressure bits 15..0, reading it releases DRDY
+			twi.tx[0] = (uint8_t)(ps.pressure >> 8);
+			twi.tx[1] = (uint8_t)ps.pressure;
+			twi.tx_len = 2;
+			periph_set_inputs(SIM_PS_INT, 0);
+			break;
+		case 0x81:	// TEMPOUT
+			twi.tx[0] = (uint8_t)(ps.temperature >> 8);
+			twi.tx[1] = (uint8_t)ps.temperature;
+			twi.tx_len = 2;
+			break;
+		case 0x03:
+			twi.tx[0] = ps.mode;
+			break;
+		default:
+			twi.tx[0] = 0;
+			break;
+	}
+}
+
+
+static uint8_t twi_next_byte(void)
+{
+	uint8_t b = (twi.tx_pos < twi.tx_len) ? twi.tx[twi.tx_pos] : 0xFF;
+
+	twi.tx_pos++;
+	return b;
+}
+
+
+// *************************************************************************************************
+// @fn          twi_update
+// @brief       Bit level TWI slave, driven by the PJ.2/PJ.3 port pins of the firmware.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void twi_update(void)
+{
+	uint16_t out = sim_rd16(R_PJOUT);
+	uint16_t dir = sim_rd16(R_PJDIR);
+	uint8_t scl = (dir & PJ_PS_SCL) ? ((out & PJ_PS_SCL) != 0) : 1;
+	uint8_t sda = (dir & PJ_PS_SDA) ? ((out & PJ_PS_SDA) != 0) : !twi.drive_low;
+
+	if (twi.scl && scl && twi.sda != sda)
+	{
+		// SDA change while SCL is high: start or stop condition
+		twi.state     = sda ? TWI_IDLE : TWI_ADDRESS;
+		twi.bits      = 0;
+		twi.byte      = 0;
+		twi.drive_low = 0;
+	}
+	else if (!twi.scl && scl && twi.state != TWI_IDLE)
+	{
+		// Rising SCL: data is sampled
+		if (twi.state != TWI_READ && twi.bits < 8) twi.byte = (uint8_t)((twi.byte << 1) | sda);
+		if (twi.state == TWI_READ && twi.bits == 8) twi.master_ack = !sda;
+		twi.bits++;
+	}
+	else if (twi.scl && !scl && twi.state != TWI_IDLE)
+	{
+		// Falling SCL: data may change
+		if (twi.state == TWI_READ)
+		{
+			if (twi.bits < 8)
+			{
+				twi.drive_low = !(twi.tx[0] & (0x80 >> twi.bits));
+			}
+			else if (twi.bits == 8)
+			{
+				twi.drive_low = 0;
+			}
+			else
+			{
+				twi.bits = 0;
+				twi.drive_low = 0;
+				if (twi.master_ack)
+				{
+					twi.tx[0] = twi_next_byte();
+					twi.drive_low = !(twi.tx[0] & 0x80);
+				}
+			}
+		}
+		else if (twi.bits == 8)
+		{
+			// Byte received, acknowledge if it is for us
+			if (twi.state == TWI_ADDRESS)
+			{
+				if ((twi.byte >> 1) != PS_TWI_ADDRESS)
+				{
+					twi.state = TWI_IDLE;
+					return;
+				}
+				twi.rw = twi.byte & 0x01;
+			}
+			else if (twi.first)
+			{
+				twi.ptr   = twi.byte;
+				twi.first = 0;
+			}
+			else
+			{
+				ps_write(twi.ptr++, twi.byte);
+			}
+			twi.drive_low = 1;
+		}
+		else if (twi.bits == 9)
+		{
+			twi.drive_low = 0;
+			twi.bits = 0;
+			twi.byte = 0;
+			if (twi.state == TWI_ADDRESS)
+			{
+				twi.transfers++;
+				if (twi.rw)
+				{
+					// Present the MSB of the first byte right away
+					twi.state = TWI_READ;
+					ps_read(twi.ptr);
+					twi.tx[0] = twi_next_byte();
+					twi.drive_low = !(twi.tx[0] & 0x80);
+				}
+				else
+				{
+					twi.state = TWI_WRITE;
+					twi.first = 1;
+				}
+			}
+		}
+	}
+
+	twi.scl = scl;
+	twi.sda = (dir & PJ_PS_SDA) ? sda : !twi.drive_low;
+}
+
+
+// *************************************************************************************************
+// ADC12_A with shared reference
+// *************************************************************************************************
+static void adc_start(void)
+{
+	static const uint16_t sht[16] = { 4, 8, 16, 32, 64, 96, 128, 192, 256, 384, 512, 768, 1024,
+									  1024, 1024, 1024 };
+	uint16_t ctl0 = sim_rd16(R_ADC12CTL0);
+	double us;
+
+	// MODOSC ~4.8MHz: sample time plus 13 conversion clocks
+	us = (sht[(ctl0 >> 8) & 0x0F] + 13) / 4.8;
+	adc.done = sim_now + (sim_time_t)ceil(us * SIM_ACLK_HZ / 1e6);
+	sim_wr16(R_ADC12CTL0, ctl0 & ~ADC_SC);
+	sim_wr16(R_ADC12CTL1, sim_rd16(R_ADC12CTL1) | ADC_BUSY);
+}
+
+
+static void adc_complete(void)
+{
+	static const double vref[4] = { 1.5, 2.0, 2.5, 2.5 };
+	double v, ref = vref[(sim_rd16(R_REFCTL0) >> 4) & 0x03];
+	long counts;
+
+	switch (sim_rd8(R_ADC12MCTL0) & 0x0F)
+	{
+		case 10:	v = 0.680 + 0.00225 * sim_env.temperature; break;	// Temperature diode
+		case 11:	v = sim_env.battery / 2.0; break;					// (AVCC - AVSS) / 2
+		default:	v = 0.0; break;
+	}
+	counts = lrint(v / ref * 4096.0);
+	if (counts > 4095) counts = 4095;
+	if (counts < 0) counts = 0;
+
+	sim_wr16(R_ADC12MEM0, (uint16_t)counts);
+	sim_wr16(R_ADC12IFG, sim_rd16(R_ADC12IFG) | 0x0001);
+	sim_wr16(R_ADC12CTL1, sim_rd16(R_ADC12CTL1) & ~ADC_BUSY);
+	adc.done = SIM_NEVER;
+	adc.conversions++;
+	sim_irq_update();
+}
+
+
+// *************************************************************************************************
+// RF1A radio core interface
+// *************************************************************************************************
+
+// *************************************************************************************************
+// @fn          radio_wor_current
+// @brief       Average current of the automatic RX polling sequence set up in MCSM2, WOREVT1/0
+//				and WORCTRL. Every Event0 the radio spends EVENT1 in IDLE for XOSC start-up, then
+//				listens until RX_TIME expires or, with RX_TIME_RSSI, until carrier sense fails.
+//				RX_TIME follows the WOR_RES = 0 column of the datasheet.
+// @param       none
+// @return      uint32_t		Current in nA
+// *************************************************************************************************
+static uint32_t radio_wor_current(void)
+{
+	static const uint8_t event1_periods[8] = { 4, 6, 8, 12, 16, 24, 32, 48 };
+	uint64_t event0, rx_ns, idle_ns;
+	uint8_t rx_time = radio.reg[0x16] & 0x07;
+
+	if (rx_time == 7) return SIM_NA_RADIO_RX;
+
+	event0 = (uint64_t)((radio.reg[0x1E] << 8) | radio.reg[0x1F]) << (5 * (radio.reg[0x20] & 0x03));
+	if (event0 == 0) event0 = 1;
+	event0 *= RADIO_WOR_PERIOD_NS;
+	idle_ns = (uint64_t)event1_periods[(radio.reg[0x20] >> 4) & 0x07] * RADIO_WOR_PERIOD_NS;
+	rx_ns   = event0 * 36058 / (1000000ull << rx_time);
+	if ((radio.reg[0x16] & 0x10) && rx_ns > RADIO_WOR_CS_NS) rx_ns = RADIO_WOR_CS_NS;
+
+	return SIM_NA_RADIO_WOR + (uint32_t)((idle_ns * SIM_NA_RADIO_IDLE + rx_ns * SIM_NA_RADIO_RX) / event0);
+}
+
+
+// *************************************************************************************************
+// @fn          radio_wor_wake
+// @brief       Wake-on-Radio catches the wake-up train of a command queued at the access point. The
+//				sync word of the first packet sets RFIFG9, the channel is checked by sim/rf.c.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void radio_wor_wake(void)
+{
+	if (radio.state == RADIO_WOR && sim_env.ap && sim_env.ap_cmd)
+	{
+		sim_wr16(R_RF1AIFG, sim_rd16(R_RF1AIFG) | RF1A_IFG9);
+	}
+}
+
+
+static void radio_strobe(uint8_t strobe)
+{
+	radio.strobes++;
+	switch (strobe)
+	{
+		case 0x30:	memset(radio.reg, 0, sizeof(radio.reg));		// SRES
+					radio.state = RADIO_IDLE; break;
+		case 0x34:	radio.state = RADIO_RX; break;					// SRX
+		case 0x35:	radio.state = RADIO_TX; break;					// STX
+		case 0x36:	radio.state = RADIO_IDLE; break;				// SIDLE
+		case 0x32:													// SXOFF
+		case 0x39:	radio.state = RADIO_SLEEP; break;				// SPWD
+		case 0x38:	radio.state  = RADIO_WOR;						// SWOR
+					radio.wor_na = radio_wor_current();
+					radio_wor_wake(); break;
+		case 0x3D:	break;											// SNOP
+		default:	if (radio.state == RADIO_SLEEP) radio.state = RADIO_IDLE; break;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          sim_radio_burst
+// @brief       Radio activity reported by the SimpliciTI stand-in (sim/rf.c).
+// @param       uint8_t tx			1=TX, 0=RX
+//				sim_time_t ticks	Duration
+// @return      none
+// *************************************************************************************************
+void sim_radio_burst(uint8_t tx, sim_time_t ticks)
+{
+	radio.burst_state = tx ? RADIO_TX : RADIO_RX;
+	radio.burst_until = sim_now + ticks;
+}
+
+
+static uint8_t radio_current_state(void)
+{
+	return (sim_now < radio.burst_until) ? radio.burst_state : radio.state;
+}
+
+
+// *************************************************************************************************
+// @fn          radio_tx_current
+// @brief       TX current of the PATABLE setting. The lower levels of mrfiRFPowerTable are modelled,
+//				everything else (including a PATABLE never written) counts as full power.
+// @param       none
+// @return      uint32_t		Current in nA
+// *************************************************************************************************
+static uint32_t radio_tx_current(void)
+{
+	if (radio.patable == 0x0F) return SIM_NA_RADIO_TX_M20;
+	if (radio.patable == 0x27) return SIM_NA_RADIO_TX_M10;
+	return SIM_NA_RADIO_TX;
+}
+
+
+// *************************************************************************************************
+// @fn          periph_ap_update / sim_ap_in_range / sim_ap_command / sim_ap_lost / sim_ap_rssi / sim_ap_busy
+// @brief       Access point stand-in for sim/rf.c, driven by the scenario. Packet loss and interference 
+//				use fixed seeds of their own so that runs are reproducible. The scenario calls 
+//				periph_ap_update after every change, a radio in Wake-on-Radio hears queued commands.
+// @param       uint8_t chan	Logical channel (sim_ap_busy)
+// @return      uint8_t		1 = access point in range / Next sync command, 0 = none / 1 = packet lost /
+//							1 = interferer on the channel
+//				int8_t		RSSI of access point frames at the watch (dBm)
+// *************************************************************************************************
+void periph_ap_update(void)
+{
+	radio_wor_wake();
+}
+
+
+uint8_t sim_ap_in_range(void)
+{
+	return sim_env.ap;
+}
+
+
+uint8_t sim_ap_command(void)
+{
+	uint8_t cmd = sim_env.ap ? sim_env.ap_cmd : 0;
+
+	sim_env.ap_cmd = 0;
+	return cmd;
+}
+
+
+uint8_t sim_ap_lost(void)
+{
+	static uint32_t seed = 1;
+
+	if (sim_env.ap_loss == 0) return 0;
+	seed = seed * 1103515245u + 12345u;
+	return ((seed >> 16) % 100) < sim_env.ap_loss;
+}
+
+
+int8_t sim_ap_rssi(void)
+{
+	return sim_env.ap_rssi;
+}
+
+
+uint8_t sim_ap_busy(uint8_t chan)
+{
+	static uint32_t seed = 7;
+
+	if (chan >= SIM_AP_CHANNELS || sim_env.ap_busy[chan] == 0) return 0;
+	seed = seed * 1103515245u + 12345u;
+	return ((seed >> 16) % 100) < sim_env.ap_busy[chan];
+}
+
+
+// *************************************************************************************************
+// @fn          sim_as_samples / sim_as_sample
+// @brief       Samples of the acceleration sensor model, to check data sent by sim/rf.c.
+// @param       uint32_t n		Sample number (0 = first sample of the run)
+//				uint8_t * xyz	Destination
+// @return      uint32_t		Samples so far / uint8_t	1 = sample n still in the log
+// *************************************************************************************************
+uint32_t sim_as_samples(void)
+{
+	return (uint32_t)as.samples;
+}
+
+
+uint8_t sim_as_sample(uint32_t n, uint8_t * xyz)
+{
+	if (n >= as.samples || as.samples - n > 256) return 0;
+	memcpy(xyz, as.log[n & 0xFF], 3);
+	return 1;
+}
+
+
+// *************************************************************************************************
+// AES accelerator (encryption with a 128-bit key only, as used by SimpliciTI security)
+// *************************************************************************************************
+static void aes_reset(void)
+{
+	aes.key_pos  = 0;
+	aes.din_pos  = 0;
+	aes.dout_pos = 16;
+	sim_wr16(R_AESACTL0, 0);
+	sim_wr16(R_AESASTAT, 0);
+}
+
+
+static void aes_status(void)
+{
+	uint16_t stat = 0;
+
+	if (sim_cycles < aes.done_cycle) stat |= AES_BUSY;
+	if (aes.key_pos == 16) stat |= AES_KEYWR;
+	if (aes.dout_pos == 16) stat |= AES_DOUTRD;
+	sim_wr16(R_AESASTAT, stat);
+}
+
+
+static void aes_write(uint8_t * dst, uint8_t * pos, uint16_t value)
+{
+	if (sim_cycles < aes.done_cycle) sim_fail("AES accelerator written while busy");
+	if (*pos >= 16) *pos = 0;
+	dst[(*pos)++] = (uint8_t)value;
+	dst[(*pos)++] = (uint8_t)(value >> 8);
+}
+
+
+static void aes_start(void)
+{
+	if (aes.key_pos != 16) sim_fail("AES block started without a complete key");
+	sim_aes_encrypt(aes.key, aes.din, aes.dout);
+	aes.din_pos    = 0;
+	aes.dout_pos   = 0;
+	aes.done_cycle = sim_cycles + AES_CYCLES;
+	aes.blocks++;
+}
+
+
+// *************************************************************************************************
+// Flash controller
+// *************************************************************************************************
+void periph_flash_write(uint16_t addr, uint16_t len, const uint8_t * before)
+{
+	uint8_t * seg = (uint8_t *)(uintptr_t)addr;
+	uint16_t fctl1 = sim_rd16(R_FCTL1);
+	uint16_t fctl3 = sim_rd16(R_FCTL3);
+	uint16_t i, bytes = 0;
+
+	if ((fctl3 & FC_LOCK) || (addr == 0x1980 && (fctl3 & FC_LOCKA)))
+	{
+		memcpy(seg, before, len);
+		sim_wr16(R_FCTL3, fctl3 | FC_ACCVIFG);
+		flash.violations++;
+		return;
+	}
+
+	if (fctl1 & FC_ERASE)
+	{
+		// Segment erase: 23-32ms, the CPU is held
+		memset(seg, 0xFF, len);
+		flash.erases++;
+		sim_sleep_for(SIM_MS(25));
+	}
+	else if (fctl1 & (FC_WRT | FC_BLKWRT))
+	{
+		// Programming can only clear bits
+		for (i = 0; i < len; i++)
+		{
+			if (seg[i] != before[i]) bytes++;
+			seg[i] = before[i] & seg[i];
+		}
+		flash.words += (bytes + 1) / 2;
+		sim_sleep_for(((bytes + 1) / 2 * 75ull * SIM_ACLK_HZ + 999999) / 1000000);
+	}
+	else
+	{
+		memcpy(seg, before, len);
+		sim_wr16(R_FCTL3, fctl3 | FC_ACCVIFG);
+		flash.violations++;
+	}
+}
+
+
+// *************************************************************************************************
+// Watchdog
+// *************************************************************************************************
+static sim_time_t wdt_expiry(void)
+{
+	static const uint8_t shift[8] = { 31, 27, 23, 19, 15, 13, 9, 6 };
+
+	// Only the ACLK source is modelled, SMCLK stops in LPM3 anyway
+	if ((wdt.ctl & WDT_HOLD) || (wdt.ctl & WDT_SSEL) != 0x20) return SIM_NEVER;
+	return wdt.last_kick + (1ull << shift[wdt.ctl & WDT_IS]);
+}
+
+
+static void wdt_commit(void)
+{
+	uint16_t value = sim_rd16(R_WDTCTL);
+
+	if (value == (uint16_t)(0x6900 | wdt.ctl)) return;		// Read only
+	if ((value & 0xFF00) != WDT_PW) sim_fail("WDTCTL written without password (PUC)");
+
+	wdt.ctl = value & 0x00F7;
+	if (value & WDT_CNTCL)
+	{
+		wdt.last_kick = sim_now;
+		wdt.kicks++;
+	}
+	sim_wr16(R_WDTCTL, (uint16_t)(0x6900 | wdt.ctl));
+}
+
+
+// *************************************************************************************************
+// @fn          periph_reset
+// @brief       Power-on state.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void periph_reset(void)
+{
+	memset((void *)sim_mem, 0, sizeof(sim_mem));
+	sim_wr16(R_WDTCTL, 0x6904);
+	wdt.ctl = 0x0004;
+	sim_wr16(R_FCTL3, 0x9658);						// LOCK | WAIT, reads with FRKEY
+	sim_wr8(R_UCA0IFG, UC_TXIFG);
+	sim_wr16(R_RTCCTL01, RTC_HOLD);
+	rtc.running  = 0;
+	rtc.hold     = 0;
+	adc.done     = SIM_NEVER;
+	as.next      = SIM_NEVER;
+	ps.next      = SIM_NEVER;
+	ps.eeprom    = 1;
+	ps.startup   = PS_STARTUP;
+	twi.scl      = 1;
+	twi.sda      = 1;
+	radio.state  = RADIO_IDLE;
+	as_reset();
+	aes_reset();
+}
+
+
+// *************************************************************************************************
+// @fn          periph_access
+// @brief       Refresh a register before the firmware reads (or modifies) it.
+// @param       uint16_t addr		Register address
+//				uint8_t size		Access width
+// @return      none
+// *************************************************************************************************
+void periph_access(uint16_t addr, uint8_t size)
+{
+	uint16_t iv;
+	int n;
+
+	(void)size;
+	switch (addr)
+	{
+		case R_TA0R:
+			ta0.shadow = ta0_count(sim_now);
+			sim_wr16(R_TA0R, ta0.shadow);
+			break;
+
+		case R_TA0IV:
+			iv = ta0_vector();
+			sim_wr16(R_TA0IV, iv);
+			if (iv == 0x0E) sim_wr16(R_TA0CTL, sim_rd16(R_TA0CTL) & ~TA_TAIFG);
+			else if (iv) sim_wr16(R_TA0CCTL(iv / 2), sim_rd16(R_TA0CCTL(iv / 2)) & ~TA_CCIFG);
+			break;
+
+		case R_RTCPS:
+		case R_RTCPS + 1:
+		case R_RTCSEC:
+		case R_RTCMIN:
+		case R_RTCHOUR:
+			if (rtc.running) rtc_refresh();
+			break;
+
+		case R_RTCIV:
+			iv = (uint16_t)(periph_irq_pending(SIM_IRQ_RTC) ? 0x0004 : 0);
+			sim_wr16(R_RTCIV, iv);
+			if (iv) sim_wr16(R_RTCCTL01, sim_rd16(R_RTCCTL01) & ~RTC_TEVIFG);
+			break;
+
+		case R_P2IN:
+			p2_update();
+			break;
+
+		case R_P2IV:
+			iv = 0;
+			for (n = 0; n < 8; n++)
+			{
+				if (sim_rd8(R_P2IFG) & sim_rd8(R_P2IE) & (1 << n))
+				{
+					iv = (uint16_t)(2 * (n + 1));
+					sim_wr8(R_P2IFG, sim_rd8(R_P2IFG) & ~(1 << n));
+					break;
+				}
+			}
+			sim_wr16(R_P2IV, iv);
+			break;
+
+		case R_PJIN:
+			sim_wr16(R_PJIN, (uint16_t)((sim_rd16(R_PJOUT) & ~PJ_PS_SDA) | (twi.sda ? PJ_PS_SDA : 0)));
+			break;
+
+		case R_UCA0IFG:
+			if (as.rx_pending && sim_cycles >= as.rx_cycle)
+			{
+				as.rx_pending = 0;
+				sim_wr8(R_UCA0RXBUF, as.rx);
+				sim_wr8(R_UCA0IFG, sim_rd8(R_UCA0IFG) | UC_RXIFG);
+			}
+			break;
+
+		case R_UCA0RXBUF:
+			sim_wr8(R_UCA0IFG, sim_rd8(R_UCA0IFG) & ~UC_RXIFG);
+			break;
+
+		case R_ADC12IV:
+			if (sim_rd16(R_ADC12IFG) & sim_rd16(R_ADC12IE) & 0x0001)
+			{
+				sim_wr16(R_ADC12IV, 0x0006);
+				sim_wr16(R_ADC12IFG, sim_rd16(R_ADC12IFG) & ~0x0001);
+			}
+			else
+			{
+				sim_wr16(R_ADC12IV, 0);
+			}
+			break;
+
+		case R_ADC12MEM0:
+			sim_wr16(R_ADC12IFG, sim_rd16(R_ADC12IFG) & ~0x0001);
+			break;
+
+		case R_PMMIFG:
+			// SVS/SVM delays and level reached flags are always settled
+			sim_wr16(R_PMMIFG, (sim_rd16(R_PMMIFG) & ~0x0022) | 0x0055);
+			break;
+
+		case R_SFRIFG1:
+			// Oscillator faults clear as soon as the firmware resets them
+			break;
+
+		case R_RF1AIFCTL1:
+			sim_wr16(R_RF1AIFCTL1, (uint16_t)(sim_rd16(R_RF1AIFCTL1) | RF_IFCTL_READY));
+			break;
+
+		case R_RF1ADOUT0B:
+		case R_RF1ADOUT1B:
+			sim_wr8(addr, radio.dout);
+			sim_wr8(R_RF1ASTATB, (uint8_t)(radio.state == RADIO_RX ? 0x10 : radio.state == RADIO_TX ? 0x20 : 0x00));
+			break;
+
+		case R_RF1ASTATB:
+			sim_wr8(R_RF1ASTATB, (uint8_t)(radio.state == RADIO_RX ? 0x10 : radio.state == RADIO_TX ? 0x20 : 0x00));
+			break;
+
+		case R_RF1AIN:
+			sim_wr16(R_RF1AIN, 0);
+			break;
+
+		case R_AESASTAT:
+			aes_status();
+			break;
+
+		case R_AESADOUT:
+			if (sim_cycles < aes.done_cycle) sim_fail("AESADOUT read while the AES accelerator is busy");
+			if (aes.dout_pos >= 16) sim_fail("AESADOUT read without a new result");
+			sim_wr16(R_AESADOUT, (uint16_t)(aes.dout[aes.dout_pos] | (aes.dout[aes.dout_pos + 1] << 8)));
+			aes.dout_pos += 2;
+			break;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          periph_commit
+// @brief       React to a completed register access.
+// @param       uint16_t addr		Register address
+//				uint8_t size		Access width
+// @return      none
+// *************************************************************************************************
+void periph_commit(uint16_t addr, uint8_t size)
+{
+	uint16_t value;
+
+	switch (addr)
+	{
+		case R_TA0CTL:
+			ta0_control();
+			break;
+
+		case R_TA0R:
+			value = sim_rd16(R_TA0R);
+			if (value != ta0.shadow)
+			{
+				if (ta0.running) ta0.origin = sim_now - value;
+				else ta0.hold = value;
+			}
+			break;
+
+		case R_TA1CTL:
+			sim_wr16(R_TA1CTL, sim_rd16(R_TA1CTL) & ~TA_TACLR);
+			break;
+
+		case R_RTCCTL01:
+			rtc_control();
+			break;
+
+		case R_WDTCTL:
+			wdt_commit();
+			break;
+
+		case R_P2OUT:
+		case R_P2DIR:
+		case R_P2IES:
+			p2_update();
+			break;
+
+		case R_PJOUT:
+		case R_PJDIR:
+			if (!as_powered() && as.mode != AS_OFF) as_reset();
+			if (sim_rd16(R_PJOUT) & PJ_AS_CSN) as.frame = 0;
+			twi_update();
+			break;
+
+		case R_UCA0TXBUF:
+			as.rx = as_spi(sim_rd8(R_UCA0TXBUF));
+			as.rx_pending = 1;
+			as.rx_cycle = sim_cycles + 8u * (sim_rd16(R_UCA0BRW) ? sim_rd16(R_UCA0BRW) : 1u);
+			break;
+
+		case R_ADC12CTL0:
+			value = sim_rd16(R_ADC12CTL0);
+			if ((value & (ADC_SC | ADC_ENC | ADC_ON)) == (ADC_SC | ADC_ENC | ADC_ON)) adc_start();
+			if (!(value & ADC_ON)) adc.done = SIM_NEVER;
+			break;
+
+		case R_LCDBMEMCTL:
+			value = sim_rd16(R_LCDBMEMCTL);
+			if (value & LCD_CLRM) memset((void *)&sim_mem[R_LCDMEM], 0, 0x20);
+			if (value & LCD_CLRBM) memset((void *)&sim_mem[R_LCDBMEM], 0, 0x20);
+			sim_wr16(R_LCDBMEMCTL, value & ~(LCD_CLRM | LCD_CLRBM));
+			break;
+
+		case R_RF1AINSTRW:
+			if (size == 2)
+			{
+				value = sim_rd16(R_RF1AINSTRW);
+				if ((value >> 8) == 0x7E) radio.patable = (uint8_t)value;
+				else if (!((value >> 8) & 0x80)) radio.reg[(value >> 8) & 0x3F] = (uint8_t)value;
+			}
+			break;
+
+		case R_RF1AINSTRB:
+			value = sim_rd8(R_RF1AINSTRB);
+			if (value >= 0x30 && value <= 0x3D) radio_strobe((uint8_t)value);
+			else if (value == 0xFE) radio.dout = radio.patable;
+			else if (value & 0x80) radio.dout = radio.reg[value & 0x3F];
+			break;
+
+		case R_RF1AINSTR1B:
+			value = sim_rd8(R_RF1AINSTR1B);
+			radio.dout = (value == 0xFE) ? radio.patable : radio.reg[value & 0x3F];
+			break;
+
+		case R_AESACTL0:
+			value = sim_rd16(R_AESACTL0);
+			if (value & AES_SWRST) aes_reset();
+			else if (value & AES_OP) sim_fail("AES accelerator: only encryption is modelled");
+			break;
+
+		case R_AESAKEY:
+			aes_write(aes.key, &aes.key_pos, sim_rd16(R_AESAKEY));
+			break;
+
+		case R_AESADIN:
+			aes_write(aes.din, &aes.din_pos, sim_rd16(R_AESADIN));
+			if (aes.din_pos == 16) aes_start();
+			break;
+	}
+}
+
+
+// *************************************************************************************************
+// Vertical motion and vario readings
+// *************************************************************************************************
+
+// LINE2 glyphs of the digits 0..9 and '-' (driver/display1.c)
+static const uint8_t lcd_l2_digits[10] = { 0x5F, 0x06, 0x6B, 0x2F, 0x36, 0x3D, 0x7D, 0x07, 0x7F, 0x3F };
+#define LCD_L2_MINUS		(0x20)
+
+
+// *************************************************************************************************
+// @fn          lcd_read_l2
+// @brief       Read a number off LINE2 digits 4..0 (LCDM12..LCDM8). Leading blanks and a minus
+//				sign are allowed, a decimal point is ignored.
+// @param       long * value		Number as shown without decimal point
+// @return      int					Digits read, 0 = LINE2 shows no number
+// *************************************************************************************************
+static int lcd_read_l2(long * value)
+{
+	uint8_t seg;
+	int i, j, digits = 0, sign = 1;
+	long v = 0;
+
+	for (i = 11; i >= 7; i--)
+	{
+		seg = sim_mem[R_LCDMEM + i] & 0x7F;
+		if (seg == 0 && digits == 0 && sign > 0) continue;
+		if (seg == LCD_L2_MINUS && digits == 0 && sign > 0)
+		{
+			sign = -1;
+			continue;
+		}
+		for (j = 0; j < 10 && lcd_l2_digits[j] != seg; j++);
+		if (j == 10) return 0;
+		v = v * 10 + j;
+		digits++;
+	}
+	*value = sign * v;
+	return digits;
+}
+
+
+// *************************************************************************************************
+// @fn          flight_read_vario
+// @brief       Read a vertical speed off LINE2: digits 4..0 (LCDM12..LCDM8) with the decimal point
+//				(LCDM9.7) before the last two digits, as the vario shows it in m/s.
+// @param       double * value		Reading (m/s)
+// @return      int					1 = LINE2 shows a vertical speed
+// *************************************************************************************************
+static int flight_read_vario(double * value)
+{
+	long v;
+
+	if (!(sim_mem[R_LCDMEM + 8] & 0x80)) return 0;
+	if (lcd_read_l2(&v) < 3) return 0;
+	*value = v / 100.0;
+	return 1;
+}
+
+
+// *************************************************************************************************
+// @fn          flight_advance
+// @brief       Move the watch vertically and take vario readings on a fixed grid. The LCD does not 
+//				change while time advances. Pressure follows the barometric formula with the sensor 
+//				temperature as air temperature.
+// @param       sim_time_t from, to		Time span
+// @return      none
+// *************************************************************************************************
+static void flight_advance(sim_time_t from, sim_time_t to)
+{
+	double dt = (double)(to - from) / SIM_ACLK_HZ, dh, shown;
+
+	if (!flight.active)
+	{
+		if (sim_env.climb == 0.0 && sim_env.vaccel == 0.0) return;
+		flight.active = 1;
+		flight.next   = from;
+	}
+
+	for (; flight.next <= to && flight.count < FLIGHT_READINGS; flight.next += FLIGHT_GRID)
+	{
+		flight.climb[flight.count] = sim_env.climb + sim_env.vaccel * (double)(flight.next - from) / SIM_ACLK_HZ;
+		flight.shown[flight.count] = flight_read_vario(&shown) ? shown : NAN;
+		flight.count++;
+	}
+
+	dh = (sim_env.climb + 0.5 * sim_env.vaccel * dt) * dt;
+	sim_env.climb    += sim_env.vaccel * dt;
+	sim_env.pressure *= exp(-dh / (29.27 * (sim_env.temperature + 273.15)));
+}
+
+
+// *************************************************************************************************
+// @fn          flight_report
+// @brief       Compare vario readings with the true vertical speed. The lag is the delay that fits
+//				readings and true speed best, error is the remaining difference and noise the 
+//				readings during level flight.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void flight_report(void)
+{
+	double sum, best = INFINITY, noise_sum = 0.0, d;
+	unsigned lag, best_lag = 0, k, n, readings = 0, level = 0;
+
+	if (!flight.active) return;
+
+	for (lag = 0; lag <= FLIGHT_LAG_MAX; lag++)
+	{
+		sum = 0.0;
+		n = 0;
+		for (k = lag; k < flight.count; k++)
+		{
+			if (isnan(flight.shown[k])) continue;
+			d = flight.shown[k] - flight.climb[k - lag];
+			sum += d * d;
+			n++;
+		}
+		if (n && sum / n < best)
+		{
+			best = sum / n;
+			best_lag = lag;
+		}
+	}
+
+	for (k = 0; k < flight.count; k++)
+	{
+		if (isnan(flight.shown[k])) continue;
+		readings++;
+		if (k < best_lag || flight.climb[k] != 0.0 || flight.climb[k - best_lag] != 0.0) continue;
+		noise_sum += flight.shown[k] * flight.shown[k];
+		level++;
+	}
+
+	printf("\n%-24s %12s\n", "vario", "");
+	printf("%-24s %12u\n", "readings (8/s)", readings);
+	if (readings == 0) return;
+	printf("%-24s %12.3f\n", "lag (s)", (double)best_lag * FLIGHT_GRID / SIM_ACLK_HZ);
+	printf("%-24s %12.3f\n", "error (m/s rms)", sqrt(best));
+	if (level) printf("%-24s %12.3f\n", "noise level (m/s rms)", sqrt(noise_sum / level));
+}
+
+
+// *************************************************************************************************
+// @fn          walk_report
+// @brief       Compare the step count on LINE2 at the end of the run with the true steps and give
+//				wakeups, PORT2 interrupts and current per hour moving and per hour still.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void walk_report(void)
+{
+	static const char * const names[2] = { "still", "moving" };
+	char label[32];
+	double hours;
+	long shown;
+	int i;
+
+	if (!walk.active) return;
+
+	printf("\n%-24s %12s\n", "walk", "");
+	printf("%-24s %12llu\n", "true steps", (unsigned long long)walk.steps);
+	if (lcd_read_l2(&shown) > 0 && walk.steps > 0)
+	{
+		printf("%-24s %12ld  (%+.1f %%)\n", "steps shown", shown,
+			   100.0 * ((double)shown - (double)walk.steps) / (double)walk.steps);
+	}
+	for (i = WALK_MOVING; i >= (int)WALK_STILL; i--)
+	{
+		if (walk.ticks[i] == 0) continue;
+		hours = (double)walk.ticks[i] / SIM_ACLK_HZ / 3600.0;
+		snprintf(label, sizeof(label), "%s (h)", names[i]);
+		printf("%-24s %12.2f\n", label, hours);
+		printf("%-24s %12.0f\n", "  wakeups/h", (double)walk.wakeups[i] / hours);
+		printf("%-24s %12.0f\n", "  PORT2 IRQs/h", (double)walk.irqs[i] / hours);
+		printf("%-24s %12.3f\n", "  avg current (uA)", walk.charge[i] / (double)walk.ticks[i] / 1000.0);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          periph_advance
+// @brief       Let the peripherals run from one point in time to another.
+// @param       sim_time_t from, to		Time span
+// @return      none
+// *************************************************************************************************
+void periph_advance(sim_time_t from, sim_time_t to)
+{
+	sim_time_t dt = to - from;
+	uint8_t p2out = sim_rd8(R_P2OUT), p2dir = sim_rd8(R_P2DIR);
+
+	// On-time statistics
+	if ((sim_rd16(R_TA1CTL) & TA_MC) && (sim_rd8(R_P2SEL) & P2_BUZZER)) buzzer_ticks += dt;
+	if (p2out & p2dir & P2_BACKLIGHT)
+	{
+		backlight_ticks += dt;
+		if (!backlight_on)
+		{
+			backlight_switch_ons++;
+			if (!(p2.ext & SIM_BUTTON_BACKLIGHT)) backlight_no_button++;
+		}
+	}
+	backlight_on = (uint8_t)((p2out & p2dir & P2_BACKLIGHT) != 0);
+	if (sim_rd16(R_LCDBCTL0) & LCD_ON) lcd_ticks += dt;
+	if (sim_rd16(R_REFCTL0) & REF_ON) adc.ref_ticks += dt;
+	if (as_powered()) as.ticks[as.mode] += dt;
+	ps.ticks[ps.mode] += dt;
+	radio.ticks[radio_current_state()] += dt;
+
+	flight_advance(from, to);
+	walk_advance(from, to);
+	ta0_advance(from, to);
+	rtc_advance(from, to);
+
+	if (to >= adc.done) adc_complete();
+
+	while (to >= as.next)
+	{
+		as_sample();
+		as.next = as_period() ? as.next + as_period() : SIM_NEVER;
+	}
+
+	while (to >= ps.next)
+	{
+		ps_sample();
+		if (ps.mode == PS_TRIGGERED)
+		{
+			ps.mode = PS_STANDBY;
+			ps.next = SIM_NEVER;
+		}
+		else
+		{
+			ps.next = ps_period() ? ps.next + ps_period() : SIM_NEVER;
+		}
+	}
+
+	if (to >= wdt_expiry()) sim_fail("watchdog reset (not serviced for %.1f s)",
+									 (double)(to - wdt.last_kick) / SIM_ACLK_HZ);
+}
+
+
+// *************************************************************************************************
+// @fn          periph_next_event
+// @brief       Earliest future point in time at which a peripheral changes state on its own.
+// @param       none
+// @return      sim_time_t		Time or SIM_NEVER
+// *************************************************************************************************
+sim_time_t periph_next_event(void)
+{
+	sim_time_t next = SIM_NEVER, t;
+	int n;
+
+	if (ta0.running)
+	{
+		for (n = 0; n < 5; n++)
+		{
+			if (!(sim_rd16(R_TA0CCTL(n)) & TA_CCIE)) continue;
+			t = ta0_match(sim_now, sim_rd16(R_TA0CCR(n)));
+			if (t < next) next = t;
+		}
+	}
+	if (rtc.running && (sim_rd16(R_RTCCTL01) & RTC_TEVIE))
+	{
+		t = ((sim_now + rtc.offset) / RTC_MINUTE + 1) * RTC_MINUTE - rtc.offset;
+		if (t < next) next = t;
+	}
+	if (adc.done < next) next = adc.done;
+	if (as.next < next) next = as.next;
+	if (ps.next < next) next = ps.next;
+	if (radio.burst_until > sim_now && radio.burst_until < next) next = radio.burst_until;
+	t = wdt_expiry();
+	if (t < next) next = t;
+	return next;
+}
+
+
+// *************************************************************************************************
+// @fn          periph_irq_pending / periph_irq_accept
+// @brief       Interrupt request lines and the flags cleared by hardware on acceptance.
+// *************************************************************************************************
+int periph_irq_pending(sim_irq_t irq)
+{
+	switch (irq)
+	{
+		case SIM_IRQ_RTC:
+			return (sim_rd16(R_RTCCTL01) & (RTC_TEVIE | RTC_TEVIFG)) == (RTC_TEVIE | RTC_TEVIFG);
+		case SIM_IRQ_PORT2:
+			return (sim_rd8(R_P2IFG) & sim_rd8(R_P2IE)) != 0;
+		case SIM_IRQ_CC1101:
+			return (sim_rd16(R_RF1AIFG) & sim_rd16(R_RF1AIE)) != 0;
+		case SIM_IRQ_TIMER0_A1:
+			return ta0_vector() != 0;
+		case SIM_IRQ_TIMER0_A0:
+			return (sim_rd16(R_TA0CCTL(0)) & (TA_CCIE | TA_CCIFG)) == (TA_CCIE | TA_CCIFG);
+		case SIM_IRQ_ADC12:
+			return (sim_rd16(R_ADC12IFG) & sim_rd16(R_ADC12IE)) != 0;
+		default:
+			return 0;
+	}
+}
+
+
+void periph_irq_accept(sim_irq_t irq)
+{
+	// Single source vector: CCIFG of CCR0 is reset when the interrupt is accepted
+	if (irq == SIM_IRQ_TIMER0_A0) sim_wr16(R_TA0CCTL(0), sim_rd16(R_TA0CCTL(0)) & ~TA_CCIFG);
+}
+
+
+// *************************************************************************************************
+// @fn          periph_current
+// @brief       Current drawn by the peripherals in their present state.
+// @param       uint32_t * na		Per energy account, in nA
+// @return      none
+// *************************************************************************************************
+void periph_current(uint32_t * na)
+{
+	static const uint32_t as_na[AS_MODES] =
+	{
+		SIM_NA_AS_STANDBY, SIM_NA_AS_100HZ, SIM_NA_AS_400HZ, SIM_NA_AS_40HZ, SIM_NA_AS_MD,
+		SIM_NA_AS_100HZ, SIM_NA_AS_400HZ,
+	};
+	static const uint32_t ps_na[PS_MODES] =
+	{
+		SIM_NA_PS_STANDBY, SIM_NA_PS_HIGH_RES, SIM_NA_PS_HIGH_RES, SIM_NA_PS_LOW_POWER,
+		SIM_NA_PS_LOW_POWER,
+	};
+	static const uint32_t radio_na[RADIO_STATES] =
+	{
+		0, SIM_NA_RADIO_IDLE, SIM_NA_RADIO_RX, SIM_NA_RADIO_TX, 0,
+	};
+	uint8_t state;
+
+	if (sim_rd16(R_LCDBCTL0) & LCD_ON)
+	{
+		na[SIM_E_LCD] += SIM_NA_LCD;
+		if (sim_rd16(R_LCDBVCTL) & LCD_CPEN) na[SIM_E_LCD] += SIM_NA_LCD_CHARGE_PUMP;
+	}
+	if ((sim_rd16(R_REFCTL0) & REF_ON) || (sim_rd16(R_ADC12CTL0) & ADC_ON)) na[SIM_E_ADC] += SIM_NA_ADC_REF;
+	if ((sim_rd16(R_TA1CTL) & TA_MC) && (sim_rd8(R_P2SEL) & P2_BUZZER)) na[SIM_E_BUZZER] += SIM_NA_BUZZER;
+	if (sim_rd8(R_P2OUT) & sim_rd8(R_P2DIR) & P2_BACKLIGHT) na[SIM_E_BACKLIGHT] += SIM_NA_BACKLIGHT;
+	if (as_powered()) na[SIM_E_ACCEL] += as_na[as.mode];
+	na[SIM_E_PRESSURE] += ps_na[ps.mode];
+	state = radio_current_state();
+	if (state == RADIO_WOR)		na[SIM_E_RADIO] += radio.wor_na;
+	else if (state == RADIO_TX)	na[SIM_E_RADIO] += radio_tx_current();
+	else						na[SIM_E_RADIO] += radio_na[state];
+}
+
+
+// *************************************************************************************************
+// @fn          periph_report
+// @brief       Peripheral statistics and the final LCD content.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void periph_report(void)
+{
+	int i;
+
+	printf("\n%-24s %12s\n", "peripheral", "on time (s)");
+	printf("%-24s %12.3f\n", "LCD", (double)lcd_ticks / SIM_ACLK_HZ);
+	printf("%-24s %12.3f\n", "buzzer", (double)buzzer_ticks / SIM_ACLK_HZ);
+	printf("%-24s %12.3f  (%llu switch-ons, %llu without button)\n", "backlight", (double)backlight_ticks / SIM_ACLK_HZ,
+		   (unsigned long long)backlight_switch_ons, (unsigned long long)backlight_no_button);
+	printf("%-24s %12.3f  (%llu conversions)\n", "ADC reference", (double)adc.ref_ticks / SIM_ACLK_HZ,
+		   (unsigned long long)adc.conversions);
+	for (i = 0; i < AS_MODES; i++)
+	{
+		if (as.ticks[i] == 0) continue;
+		printf("accel %-18s %12.3f\n", as_mode_names[i], (double)as.ticks[i] / SIM_ACLK_HZ);
+	}
+	printf("%-24s %12llu\n", "accel samples", (unsigned long long)as.samples);
+	if (as.motions) printf("%-24s %12llu\n", "accel motion interrupts", (unsigned long long)as.motions);
+	for (i = 1; i < PS_MODES; i++)
+	{
+		if (ps.ticks[i] == 0) continue;
+		printf("pressure %-15s %12.3f\n", ps_mode_names[i], (double)ps.ticks[i] / SIM_ACLK_HZ);
+	}
+	printf("%-24s %12llu  (%llu TWI transfers)\n", "pressure samples", (unsigned long long)ps.samples,
+		   (unsigned long long)twi.transfers);
+	for (i = 1; i < RADIO_STATES; i++)
+	{
+		if (radio.ticks[i] == 0) continue;
+		printf("radio %-18s %12.3f\n", radio_state_names[i], (double)radio.ticks[i] / SIM_ACLK_HZ);
+	}
+	printf("%-24s %12llu\n", "watchdog kicks", (unsigned long long)wdt.kicks);
+	if (aes.blocks) printf("%-24s %12llu\n", "AES blocks", (unsigned long long)aes.blocks);
+	if (flash.erases || flash.words || flash.violations)
+	{
+		printf("%-24s %12llu\n", "flash segment erases", (unsigned long long)flash.erases);
+		printf("%-24s %12llu\n", "flash words written", (unsigned long long)flash.words);
+		printf("%-24s %12llu\n", "flash access violations", (unsigned long long)flash.violations);
+	}
+
+	flight_report();
+	walk_report();
+
+	printf("\nLCD memory  ");
+	for (i = 0; i < 12; i++) printf(" %02X", sim_mem[R_LCDMEM + i]);
+	printf("\nLCD blink   ");
+	for (i = 0; i < 12; i++) printf(" %02X", sim_mem[R_LCDBMEM + i]);
+	printf("\n");
+}
@@ -0,0 +1,1064 @@
+// *************************************************************************************************
+// Host simulation: stand-in for the SimpliciTI end device entry points (main_ED_BM.c).
+//
+// The network stack itself is not simulated. Without access point in range a link attempt behaves
+// like the real one without an answer: one join request with a short receive window per second
+// until TIMEOUT or until the user cancels. With the access point stand-in in range (scenario 'ap')
+// the first join succeeds, a link request follows one second later (with CONFIG_LINK_CACHE a saved 
+// link is resumed without join) and sync mode runs the radio pattern of main_ED_BM.c, answering the
+// commands the scenario queues at the access point. Log downloads run against an access point model
+// that loses packets as set by 'ap loss'. The access point hears the watch while the signal set by
+// 'ap rssi', reduced by the output power the watch chose, stays above its sensitivity. Acceleration 
+// packets are decoded and checked against the sensor model. With SMPL_SECURE every data frame is
+// secured with nwk_setSecureFrame and checked by the access point with nwk_getSecureFrame, and
+// every 16th frame is also offered to it with two payload bits flipped. Every frame waits for a clear
+// channel like MRFI_Transmit, against the interferers set by 'ap busy'; with CONFIG_FREQ_AGILITY the
+// failed assessments go to simpliciti_channel_callback and the link moves like nwk_requestMove, the
+// access point following unless it misses the request. Compiled like a firmware file.
+// *************************************************************************************************
+
+// *************************************************************************************************
+// Include section
+#include <stdio.h>
+#include <string.h>
+
+#include "project.h"
+#include "simpliciti.h"
+#include "rfsimpliciti.h"
+#include "radio.h"
+#include "rf1a.h"
+#include "timer.h"
+#ifdef CONFIG_PHASE_CLOCK
+#include "phase_clock.h"
+#endif
+#ifdef CONFIG_DATALOG
+#include "datalog.h"
+#else
+#define DATALOG_PACKET_SIZE		(16u)
+#endif
+#ifdef SMPL_SECURE
+#include "mrfi.h"
+#include "nwk_types.h"
+#include "nwk_frame.h"
+#include "nwk_security.h"
+#endif
+
+
+// *************************************************************************************************
+// Defines section
+
+// Same link timeout as main_ED_BM.c (seconds)
+#define TIMEOUT					(10u)
+
+// Radio activity of one join attempt (ACLK ticks)
+#define RF_JOIN_TX_TICKS		(CONV_MS_TO_TICKS(2))
+#define RF_JOIN_RX_TICKS		(CONV_MS_TO_TICKS(15))
+
+// Radio activity of one sync packet and of the listen window after a ready-to-receive packet
+#define RF_PACKET_TICKS			(CONV_MS_TO_TICKS(2))
+#define RF_SYNC_RX_TICKS		(CONV_MS_TO_TICKS(10))
+
+// Air time of a frame with payload length len at 76.8kBaud: preamble and sync (8), length (1), 
+// addresses (8), NWK header (3), security header (3 with SMPL_SECURE), CRC (2) - in ACLK ticks
+#ifdef SMPL_SECURE
+#define RF_SECURE_BYTES			(3u)
+#else
+#define RF_SECURE_BYTES			(0u)
+#endif
+#define RF_FRAME_TICKS(len)		((((len) + 22u + RF_SECURE_BYTES) * 8u * 32768u + 76799u) / 76800u)
+
+// Address of the access point stand-in, kept in the link cache
+#define RF_AP_ADDRESS			{ 0x11, 0x22, 0x33, 0x44 }
+
+// Access point turnaround before its ACK
+#define RF_AP_TURNAROUND_TICKS	(CONV_MS_TO_TICKS(1))
+
+// Session id the access point assigns to a sleep phase upload
+#define RF_PHASE_SESSION		(5u)
+
+// Log packets requested by 'ap burst' and 'ap download'. Packets past the end of the log read as 0xFF.
+#define RF_DOWNLOAD_PACKETS		(192u)
+
+// Access point receiver sensitivity at 76.8kBaud (dBm) and LQI with CRC_OK of its frames at the watch
+#define RF_AP_SENSITIVITY		(-95)
+#define RF_AP_LQI				(0x80 | 12u)
+
+// Logical channels (MRFI_NUM_LOGICAL_CHANS) and level of an interferer at the watch (dBm)
+#define RF_CHANNELS				(4u)
+#define RF_BUSY_RSSI			(-60)
+
+// Clear channel assessment of MRFI_Transmit: RX until the RSSI is valid, random backoff of 1..16 
+// times 250us after a busy channel, frame dropped after MRFI_CCA_RETRIES + 1 busy assessments
+#define RF_CCA_TICKS			(12u)
+#define RF_BACKOFF_TICKS		(8u)
+#define RF_CCA_ATTEMPTS			(5u)
+
+// Reply delay of nwk_requestMove and nwk_scanForChannels, payload of their frames
+#define RF_MOVE_REPLY_TICKS		(CONV_MS_TO_TICKS(5))
+#define RF_MOVE_FRAME_TICKS		(RF_FRAME_TICKS(2))
+
+// Link cache: addresses of both ends, with CONFIG_FREQ_AGILITY the logical channel
+#ifdef CONFIG_FREQ_AGILITY
+#define RF_CACHE_SIZE			(9u)
+#else
+#define RF_CACHE_SIZE			(8u)
+#endif
+
+
+// *************************************************************************************************
+// Global Variable section
+static u32 rf_link_attempts;
+static u32 rf_link_sessions;
+static u32 rf_link_resumed;
+static u32 rf_sync_commands;
+static u32 rf_sync_replies;
+
+// Output power: PATABLE and dBm of the levels in mrfiRFPowerTable (ISM_EU), frames sent per level
+static const u8 rf_patable[SIMPLICITI_TX_LEVELS] = { 0x0F, 0x27, 0x8C };
+static const s8 rf_level_dbm[SIMPLICITI_TX_LEVELS] = { -20, -10, 1 };
+static u32 rf_tx_frames[SIMPLICITI_TX_LEVELS];
+static u8 rf_level;
+
+// Logical channels of the watch and of the access point, frames per channel of the watch
+static u8 rf_chan;
+static u8 rf_ap_chan;
+static u8 rf_clear;		// Last frame went out on the access point channel and was not hit
+static u32 rf_seed = 3;
+static struct
+{
+	u32 frames;			// Frames to send, including dropped ones
+	u32 cca_fails;		// Busy assessments
+	u32 dropped;		// Frames not sent
+	u32 delivered;		// Frames the access point could receive
+	double charge;		// Radio charge of all attempts (nA * ticks)
+} rf_channel[RF_CHANNELS];
+
+#ifdef CONFIG_FREQ_AGILITY
+// Channel moves: channel the application asked for, moves requested, done, found by scan
+static u8 rf_move_to = RF_CHANNELS;
+static struct
+{
+	u32 requested;
+	u32 moved;
+	u32 scanned;
+} rf_moves;
+#endif
+
+// Log downloads: 0 = packet burst (SYNC_AP_CMD_GET_MEMORY_BLOCKS_MODE_1), 1 = windowed
+static struct
+{
+	u32 count;
+	u32 bytes;			// Log bytes the access point received
+	u32 frames;			// Frames sent, including repetitions
+	u32 ticks;			// Duration
+	u32 radio_ticks;	// Radio in RX or TX
+} rf_download[2];
+
+// Acceleration packets at the access point
+static struct
+{
+	u32 packets;
+	u32 bytes;			// Payload bytes
+	u32 samples;
+	u32 errors;			// Decoded samples that differ from the sensor model
+	u32 next;			// Sensor sample number of the next stream sample
+	u8  seq;
+} rf_accel;
+
+
+#ifdef SMPL_SECURE
+// Secured frames: frame counters of both ends, checks at the access point
+static struct
+{
+	u32 ed_ctr;
+	u32 ap_ctr;
+	u32 frames;
+	u32 bytes;			// Application payload bytes
+	unsigned long long cycles;	// MCLK cycles in nwk_setSecureFrame
+	u32 failed;			// Genuine frames the access point rejected or decrypted wrongly
+	u32 tampered;		// Frames offered with two flipped bits
+	u32 forged;			// ... that the access point accepted
+} rf_secure;
+#endif
+
+
+#ifdef CONFIG_PHASE_CLOCK
+// Sleep phase uploads at the access point
+static struct
+{
+	u32 packets;
+	u32 epochs;
+	u32 repeated;		// Epochs received before
+	u32 errors;			// Gaps in epoch index, wrong session
+	u32 sum;			// Movement in all new epochs
+	u16 next;			// Next expected epoch index
+} rf_phase;
+#endif
+
+
+// *************************************************************************************************
+// Extern section
+extern unsigned char simpliciti_payload_length;
+extern void sim_radio_burst(unsigned char tx, unsigned long long ticks);
+extern unsigned char sim_ap_in_range(void);
+extern unsigned char sim_ap_command(void);
+extern unsigned char sim_ap_lost(void);
+extern signed char sim_ap_rssi(void);
+extern unsigned char sim_ap_busy(unsigned char chan);
+extern double sim_radio_charge(void);
+extern u32 sim_as_samples(void);
+extern u8 sim_as_sample(u32 n, u8 * xyz);
+extern int simpliciti_get_rvc_callback(u8 len);
+extern unsigned long long sim_cycles;
+
+
+// *************************************************************************************************
+// @fn          rf_link_event
+// @brief       Report a link event like main_ED_BM.c and write the PATABLE when the level changes.
+// @param       u8 event		SIMPLICITI_LINK_START, _FRAME, _MISS, _IDLE
+// @return      none
+// *************************************************************************************************
+static void rf_link_event(u8 event)
+{
+	u8 level = simpliciti_link_quality_callback(event, sim_ap_rssi(), RF_AP_LQI);
+
+	if (level != rf_level)
+	{
+		rf_level = level;
+		WritePATable(rf_patable[level]);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          rf_in_reach / rf_heard
+// @brief       Access point can receive the watch at the current output power / receives the frame 
+//				just sent, unless it was not sent, hit by an interferer or lost.
+// @param       none
+// @return      u8		1 = in reach / received
+// *************************************************************************************************
+static u8 rf_in_reach(void)
+{
+	s16 rssi = sim_ap_rssi() - (rf_level_dbm[SIMPLICITI_TX_LEVELS - 1] - rf_level_dbm[rf_level]);
+
+	return sim_ap_in_range() && rssi >= RF_AP_SENSITIVITY;
+}
+
+
+static u8 rf_heard(void)
+{
+	return rf_clear && rf_in_reach() && !sim_ap_lost();
+}
+
+
+// *************************************************************************************************
+// @fn          rf_cca_tx
+// @brief       Transmit a frame at the current output power once the channel is clear. An interferer
+//				can still start during the frame, the access point receives it only when it is not hit.
+// @param       u16 ticks		Air time
+// @return      u8				Busy assessments, RF_CCA_ATTEMPTS = frame not sent
+// *************************************************************************************************
+static u8 rf_cca_tx(u16 ticks)
+{
+	double start = sim_radio_charge();
+	u8 fails = 0;
+
+	rf_channel[rf_chan].frames++;
+	rf_clear = 0;
+	while (sim_ap_busy(rf_chan))
+	{
+		sim_radio_burst(0, RF_CCA_TICKS);
+		Timer0_A4_Delay(RF_CCA_TICKS);
+		rf_channel[rf_chan].cca_fails++;
+		if (++fails == RF_CCA_ATTEMPTS) break;
+		rf_seed = rf_seed * 1103515245u + 12345u;
+		Timer0_A4_Delay(RF_BACKOFF_TICKS * (1 + ((rf_seed >> 16) & 0x0F)));
+	}
+
+	if (fails < RF_CCA_ATTEMPTS)
+	{
+		rf_tx_frames[rf_level]++;
+		sim_radio_burst(1, ticks);
+		Timer0_A4_Delay(ticks);
+		rf_clear = (rf_chan == rf_ap_chan) && !sim_ap_busy(rf_chan);
+		if (rf_clear && rf_in_reach()) rf_channel[rf_chan].delivered++;
+	}
+	else
+	{
+		rf_channel[rf_chan].dropped++;
+	}
+	rf_channel[rf_chan].charge += sim_radio_charge() - start;
+	return (fails);
+}
+
+
+// *************************************************************************************************
+// @fn          rf_tx
+// @brief       Send a frame on the link like simpliciti_send.
+// @param       u16 ticks		Air time
+// @return      none
+// *************************************************************************************************
+static void rf_tx(u16 ticks)
+{
+	u8 fails = rf_cca_tx(ticks);
+#ifdef CONFIG_FREQ_AGILITY
+	u8 move = simpliciti_channel_callback(rf_chan, fails, RF_BUSY_RSSI);
+
+	if (move != rf_chan) rf_move_to = move;
+#else
+	(void)fails;
+#endif
+}
+
+
+#ifdef SMPL_SECURE
+// *************************************************************************************************
+// @fn          rf_secure_frame
+// @brief       Secure the data frame just sent like SMPL_Send and check it at the access point like 
+//				SMPL_Receive. Every 16th frame a copy with bit 0 of the first two payload bytes 
+//				flipped is checked first, against a copy of the access point counter.
+// @param       u8 len			Application payload in simpliciti_data
+// @return      none
+// *************************************************************************************************
+static void rf_secure_frame(u8 len)
+{
+	mrfiPacket_t frame, copy;
+	unsigned long long start;
+	u32 ctr;
+
+	memset(&frame, 0, sizeof(frame));
+	MRFI_SET_PAYLOAD_LEN(&frame, len + F_APP_PAYLOAD_OS);
+	memcpy(MRFI_P_SRC_ADDR(&frame), simpliciti_ed_address, NET_ADDR_SIZE);
+	memcpy(MRFI_P_PAYLOAD(&frame) + F_APP_PAYLOAD_OS, simpliciti_data, len);
+	start = sim_cycles;
+	nwk_setSecureFrame(&frame, len, &rf_secure.ed_ctr);
+	rf_secure.cycles += sim_cycles - start;
+	rf_secure.frames++;
+	rf_secure.bytes += len;
+
+	if (len >= 2 && (rf_secure.frames & 0x0F) == 0)
+	{
+		copy = frame;
+		ctr  = rf_secure.ap_ctr;
+		MRFI_P_PAYLOAD(&copy)[F_APP_PAYLOAD_OS]     ^= 0x01;
+		MRFI_P_PAYLOAD(&copy)[F_APP_PAYLOAD_OS + 1] ^= 0x01;
+		rf_secure.tampered++;
+		if (nwk_getSecureFrame(&copy, len + F_APP_PAYLOAD_OS - F_SEC_CTR_OS, &ctr)) rf_secure.forged++;
+	}
+
+	if (!nwk_getSecureFrame(&frame, len + F_APP_PAYLOAD_OS - F_SEC_CTR_OS, &rf_secure.ap_ctr) ||
+		memcmp(MRFI_P_PAYLOAD(&frame) + F_APP_PAYLOAD_OS, simpliciti_data, len) != 0)
+	{
+		rf_secure.failed++;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          MRFI_RandomByte / nwk_getNumObjectFromMsg / nwk_putNumObjectIntoMsg
+// @brief       Parts of the network stack nwk_security.c uses. Only connection frames are secured 
+//				here, so the random counter of network application frames is never needed.
+// *************************************************************************************************
+uint8_t MRFI_RandomByte(void)
+{
+	return (0x5A);
+}
+
+
+void nwk_getNumObjectFromMsg(void * src, void * dest, uint8_t len)
+{
+	memmove(dest, src, len);
+}
+
+
+void nwk_putNumObjectIntoMsg(void * src, void * dest, uint8_t len)
+{
+	memmove(dest, src, len);
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          rf_join_attempt
+// @brief       Send a join request and listen for the access point.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_join_attempt(void)
+{
+	rf_link_attempts++;
+	sim_radio_burst(1, RF_JOIN_TX_TICKS);
+	Timer0_A4_Delay(RF_JOIN_TX_TICKS);
+	sim_radio_burst(0, RF_JOIN_RX_TICKS);
+	Timer0_A4_Delay(RF_JOIN_RX_TICKS);
+}
+
+
+// *************************************************************************************************
+// @fn          rf_link_request
+// @brief       Send a link request at full output power and listen for the reply.
+// @param       none
+// @return      u8		1 = Access point answered
+// *************************************************************************************************
+static u8 rf_link_request(void)
+{
+	u8 answered;
+	u16 ticks;
+
+	rf_level = 0xFF;
+	rf_link_event(SIMPLICITI_LINK_START);
+	rf_cca_tx(RF_PACKET_TICKS);
+	answered = rf_clear && rf_in_reach();
+	ticks = answered ? RF_PACKET_TICKS : RF_JOIN_RX_TICKS;
+	sim_radio_burst(0, ticks);
+	Timer0_A4_Delay(ticks);
+	return (answered);
+}
+
+
+#ifdef CONFIG_LINK_CACHE
+// *************************************************************************************************
+// @fn          rf_link_resume
+// @brief       Repeat the link request of the last link like main_ED_BM.c. The access point stand-in 
+//				keeps every link, so only a saved context and reach are needed. The request goes out on
+//				the saved channel.
+// @param       none
+// @return      u8		1 = Linked
+// *************************************************************************************************
+static u8 rf_link_resume(void)
+{
+	const u8 ap[4] = RF_AP_ADDRESS;
+	u8 cache[RF_CACHE_SIZE];
+
+	if (!simpliciti_link_cache_load(cache, sizeof(cache))) return (0);
+	if (memcmp(cache, simpliciti_ed_address, 4) != 0 || memcmp(cache + 4, ap, 4) != 0) return (0);
+#ifdef CONFIG_FREQ_AGILITY
+	rf_chan = cache[8] % RF_CHANNELS;
+#endif
+	return (rf_link_request());
+}
+
+
+// *************************************************************************************************
+// @fn          rf_link_save
+// @brief       Save the context of a link with join, flash is only written when it changed.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_link_save(void)
+{
+	const u8 ap[4] = RF_AP_ADDRESS;
+	u8 cache[RF_CACHE_SIZE], old[RF_CACHE_SIZE];
+
+	memcpy(cache, simpliciti_ed_address, 4);
+	memcpy(cache + 4, ap, 4);
+#ifdef CONFIG_FREQ_AGILITY
+	cache[8] = rf_chan;
+#endif
+	if (simpliciti_link_cache_load(old, sizeof(old)) && memcmp(old, cache, sizeof(cache)) == 0) return;
+	simpliciti_link_cache_store(cache, sizeof(cache));
+}
+#endif
+
+
+#ifdef CONFIG_FREQ_AGILITY
+// *************************************************************************************************
+// @fn          rf_channel_move
+// @brief       Move the link to the channel the application asked for, like simpliciti_channel_move.
+//				An access point that hears the request broadcasts the move once on the old channel and
+//				changes channel. Without the broadcast the watch waits the whole reply delay and pings
+//				every channel until the access point answers, or stays where it was.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_channel_move(void)
+{
+	u8 chan = rf_move_to, old = rf_chan, i;
+	u16 wait;
+
+	if (chan >= RF_CHANNELS) return;
+	rf_move_to = RF_CHANNELS;
+	rf_moves.requested++;
+
+	rf_cca_tx(RF_MOVE_FRAME_TICKS);
+	if (rf_heard())
+	{
+		rf_ap_chan = chan;
+		if (!sim_ap_busy(old) && !sim_ap_lost())
+		{
+			sim_radio_burst(0, RF_AP_TURNAROUND_TICKS + RF_MOVE_FRAME_TICKS);
+			Timer0_A4_Delay(RF_AP_TURNAROUND_TICKS + RF_MOVE_FRAME_TICKS);
+			rf_chan = chan;
+		}
+	}
+
+	if (rf_chan == old)
+	{
+		sim_radio_burst(0, RF_MOVE_REPLY_TICKS);
+		Timer0_A4_Delay(RF_MOVE_REPLY_TICKS);
+		for (i = 0; i < RF_CHANNELS; i++)
+		{
+			rf_chan = i;
+			rf_cca_tx(RF_MOVE_FRAME_TICKS);
+			wait = rf_heard() ? RF_AP_TURNAROUND_TICKS + RF_MOVE_FRAME_TICKS : RF_MOVE_REPLY_TICKS;
+			sim_radio_burst(0, wait);
+			Timer0_A4_Delay(wait);
+			if (wait < RF_MOVE_REPLY_TICKS) break;
+		}
+		if (i == RF_CHANNELS) rf_chan = old;
+		if (rf_chan != old) rf_moves.scanned++;
+	}
+	if (rf_chan == old) return;
+
+	rf_moves.moved++;
+#ifdef CONFIG_LINK_CACHE
+	rf_link_save();
+#endif
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          simpliciti_link
+// @brief       Try to link to access point.
+// @param       none
+// @return      unsigned char		0 = Could not link, timeout or external cancel.
+// *************************************************************************************************
+unsigned char simpliciti_link(void)
+{
+	u8 timeout = 0;
+
+	rf_link_sessions++;
+	simpliciti_flag = SIMPLICITI_STATUS_LINKING;
+#ifdef SMPL_SECURE
+	nwk_securityInit();
+	rf_secure.ed_ctr = 0;
+	rf_secure.ap_ctr = 0;
+#endif
+
+#ifdef CONFIG_LINK_CACHE
+	if (rf_link_resume())
+	{
+		rf_link_resumed++;
+		simpliciti_flag = SIMPLICITI_STATUS_LINKED;
+		return (1);
+	}
+#endif
+	while (1)
+	{
+		rf_join_attempt();
+		if (sim_ap_in_range())
+		{
+			// Join finds the access point channel. Link one second after the join like main_ED_BM.c
+			rf_chan = rf_ap_chan;
+			Timer0_A4_Delay(CONV_MS_TO_TICKS(1000));
+			if (rf_link_request())
+			{
+#ifdef CONFIG_LINK_CACHE
+				rf_link_save();
+#endif
+				simpliciti_flag = SIMPLICITI_STATUS_LINKED;
+				return (1);
+			}
+		}
+		Timer0_A4_Delay(CONV_MS_TO_TICKS(1000) - RF_JOIN_TX_TICKS - RF_JOIN_RX_TICKS);
+
+		// Service watchdog
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+
+		if (timeout++ > TIMEOUT)
+		{
+			simpliciti_flag = SIMPLICITI_STATUS_ERROR;
+			return (0);
+		}
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) return (0);
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          rf_accel_receive
+// @brief       Access point side of an acceleration packet. Stream packets are decoded and every 
+//				sample is compared with the sensor model.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_accel_receive(void)
+{
+#ifdef CONFIG_ACCEL_STREAM
+	u8 count, width, bits = 0, pos = ACCEL_STREAM_HEADER, i, j, xyz[3], ref[3];
+	u16 acc = 0;
+	s16 delta;
+#endif
+
+	rf_accel.packets++;
+	rf_accel.bytes += simpliciti_payload_length;
+#ifdef CONFIG_ACCEL_STREAM
+	// Button events without samples or repeating the last packet
+	count = simpliciti_data[2] & ACCEL_STREAM_COUNT_MASK;
+	if (count == 0 || simpliciti_data[1] == rf_accel.seq) return;
+	rf_accel.seq = simpliciti_data[1];
+
+	width = 4 + 2 * ((simpliciti_data[2] & ACCEL_STREAM_WIDTH_MASK) >> 6);
+	memcpy(xyz, &simpliciti_data[3], 3);
+	for (i = 0; i < count; i++)
+	{
+		for (j = 0; j < 3 && i > 0; j++)
+		{
+			if (bits < width)
+			{
+				acc   = (acc << 8) | simpliciti_data[pos++];
+				bits += 8;
+			}
+			bits -= width;
+			delta = (acc >> bits) & ((1 << width) - 1);
+			if (delta & (1 << (width - 1))) delta -= 1 << width;
+			xyz[j] += delta;
+		}
+		if (!sim_as_sample(rf_accel.next++, ref) || memcmp(xyz, ref, 3) != 0) rf_accel.errors++;
+		rf_accel.samples++;
+	}
+#else
+	rf_accel.samples++;
+#endif
+}
+
+
+#ifdef CONFIG_PHASE_CLOCK
+// *************************************************************************************************
+// @fn          rf_phase_receive
+// @brief       Access point side of a sleep phase upload packet. Checks that epochs arrive in order.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_phase_receive(void)
+{
+	u16 first = (simpliciti_data[2] << 8) | simpliciti_data[3];
+	u8 i;
+
+	rf_phase.packets++;
+	if ((simpliciti_data[1] >> (8 - SLEEP_RF_ID_BIT_LENGHT)) != (RF_PHASE_SESSION & 0x07) && !sPhase.bug) 
+		rf_phase.errors++;
+	if (first > rf_phase.next) rf_phase.errors++;
+	for (i = 0; i < simpliciti_data[6]; i++, first++)
+	{
+		if (first < rf_phase.next)
+		{
+			rf_phase.repeated++;
+			continue;
+		}
+		rf_phase.next = first + 1;
+		rf_phase.epochs++;
+		rf_phase.sum += (simpliciti_data[SLEEP_BATCH_HEADER + 2*i] << 8) | simpliciti_data[SLEEP_BATCH_HEADER + 2*i + 1];
+	}
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          rf_ready_to_receive
+// @brief       Ready-to-receive packets until the access point answers, like main_ED_BM.c. The access 
+//				point answers a sleep phase start with a session id.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_ready_to_receive(void)
+{
+	u8 i;
+
+	memset(simpliciti_data, 0, 5);
+	for (i = 0; i < 10; i++)
+	{
+		rf_tx(RF_PACKET_TICKS);
+		sim_radio_burst(0, RF_SYNC_RX_TICKS);
+		Timer0_A4_Delay(RF_SYNC_RX_TICKS);
+#ifdef CONFIG_PHASE_CLOCK
+		if (sRFsmpl.mode == SIMPLICITI_PHASE_CLOCK_START && rf_heard())
+		{
+			rf_link_event(SIMPLICITI_LINK_FRAME);
+			simpliciti_data[0] = SIMPLICITI_PHASE_CLOCK_START_RESPONSE;
+			simpliciti_data[1] = RF_PHASE_SESSION;
+			if (simpliciti_get_rvc_callback(2)) return;
+		}
+#endif
+		Timer0_A4_Delay(CONV_MS_TO_TICKS(500));
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+	}
+	rf_link_event(SIMPLICITI_LINK_MISS);
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_main_tx_only
+// @brief       Only reachable after a successful link. Get data through callback and send it like 
+//				main_ED_BM.c.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void simpliciti_main_tx_only(void)
+{
+	rf_accel.next = sim_as_samples();
+	rf_accel.seq  = 0xFF;
+
+	// Radio sleeps between packets
+	radio_sxoff();
+	while (1)
+	{
+		simpliciti_get_ed_data_callback();
+
+#ifdef CONFIG_FREQ_AGILITY
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_SEND_DATA) || 
+			getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVE_DATA)) rf_channel_move();
+#endif
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_SEND_DATA))
+		{
+			rf_tx(RF_FRAME_TICKS(simpliciti_payload_length));
+#ifdef SMPL_SECURE
+			rf_secure_frame(simpliciti_payload_length);
+#endif
+#ifdef CONFIG_PHASE_CLOCK
+			if (simpliciti_data[0] == SIMPLICITI_PHASE_CLOCK_BATCH_EVENTS) 	rf_phase_receive();
+			else if (simpliciti_data[0] != SIMPLICITI_PHASE_CLOCK_START_EVENTS)
+#endif
+			rf_accel_receive();
+			clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_SEND_DATA);
+		}
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVE_DATA))
+		{
+			clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVE_DATA);
+			rf_ready_to_receive();
+		}
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) break;
+	}
+}
+
+
+// *************************************************************************************************
+// @fn          rf_send
+// @brief       Transmit one packet.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_send(void)
+{
+	rf_tx(RF_PACKET_TICKS);
+}
+
+
+// *************************************************************************************************
+// @fn          rf_sync_bulk
+// @brief       Windowed download of main_ED_BM.c against an access point that keeps a bitmap of the
+//				frames it got and ACKs the frame with BM_SYNC_BULK_ACK_REQUEST.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_sync_bulk(void)
+{
+	u16 base = 0, ap_next = 0, ap_have = 0, frame, wait;
+	u8 acked = 0, last, i, retries = 0, ack_request;
+
+	rf_download[1].count++;
+	while (base < simpliciti_bulk_packets)
+	{
+		last = 0;
+		for (i = 0; i < BM_SYNC_BULK_WINDOW && base + i < simpliciti_bulk_packets; i++)
+		{
+			if (!(acked & (1 << i))) last = i;
+		}
+
+		// Frames back to back, the access point marks the ones it receives
+		ack_request = 0;
+		for (i = 0; i <= last; i++)
+		{
+			if (acked & (1 << i)) continue;
+			frame = base + i;
+			simpliciti_data[0] = SYNC_ED_TYPE_MEMORY_BULK;
+			simpliciti_sync_get_data_callback(frame);
+			rf_tx(RF_FRAME_TICKS(BM_SYNC_BULK_DATA_LENGTH));
+#ifdef SMPL_SECURE
+			rf_secure_frame(BM_SYNC_BULK_DATA_LENGTH);
+#endif
+			rf_download[1].frames++;
+			rf_download[1].ticks       += RF_FRAME_TICKS(BM_SYNC_BULK_DATA_LENGTH);
+			rf_download[1].radio_ticks += RF_FRAME_TICKS(BM_SYNC_BULK_DATA_LENGTH);
+			if (!rf_heard()) continue;
+			if (i == last) ack_request = 1;
+			if (frame < ap_next || (ap_have & (1 << (frame - ap_next)))) continue;
+
+			ap_have |= 1 << (frame - ap_next);
+			rf_download[1].bytes += BM_SYNC_BULK_LOG_PACKETS * DATALOG_PACKET_SIZE;
+			while (ap_have & 1)
+			{
+				ap_have >>= 1;
+				ap_next++;
+			}
+		}
+
+		// Listen until the ACK arrives or times out
+		if (ack_request && !sim_ap_lost())
+		{
+			wait = RF_AP_TURNAROUND_TICKS + RF_FRAME_TICKS(3);
+			base  = ap_next;
+			acked = (u8)(ap_have >> 1) << 1;
+			retries = 0;
+			rf_link_event(SIMPLICITI_LINK_FRAME);
+		}
+		else
+		{
+			wait = CONV_MS_TO_TICKS(BM_SYNC_BULK_ACK_TIMEOUT);
+			retries++;
+			rf_link_event(SIMPLICITI_LINK_MISS);
+		}
+		sim_radio_burst(0, wait);
+		Timer0_A4_Delay(wait);
+		rf_download[1].ticks       += wait;
+		rf_download[1].radio_ticks += wait;
+
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+		if (retries > BM_SYNC_BULK_RETRIES || getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) break;
+	}
+	simpliciti_bulk_packets = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          rf_sync_command
+// @brief       Decode a command from the access point and send the reply burst.
+// @param       u8 cmd			SYNC_AP_CMD_*
+// @return      none
+// *************************************************************************************************
+static void rf_sync_command(u8 cmd)
+{
+	u8 i, burst;
+
+	rf_sync_commands++;
+	rf_link_event(SIMPLICITI_LINK_FRAME);
+	memset(simpliciti_data, 0, sizeof(simpliciti_data));
+	simpliciti_data[0] = cmd;
+	if (cmd == SYNC_AP_CMD_GET_MEMORY_BLOCKS_MODE_1 || cmd == SYNC_AP_CMD_GET_MEMORY_BULK)
+	{
+		simpliciti_data[3] = RF_DOWNLOAD_PACKETS >> 8;
+		simpliciti_data[4] = RF_DOWNLOAD_PACKETS & 0xFF;
+	}
+	simpliciti_sync_decode_ap_cmd_callback();
+
+	if (simpliciti_bulk_packets > 0)
+	{
+		rf_sync_bulk();
+		return;
+	}
+
+	// Packets 10ms apart with the receiver left on, the access point does not ask for lost ones here
+	burst = (cmd == SYNC_AP_CMD_GET_MEMORY_BLOCKS_MODE_1);
+	if (burst) rf_download[0].count++;
+	for (i = 0; i < simpliciti_reply_count; i++)
+	{
+		sim_radio_burst(0, CONV_MS_TO_TICKS(10));
+		Timer0_A4_Delay(CONV_MS_TO_TICKS(10));
+		simpliciti_sync_get_data_callback(i);
+		rf_tx(RF_FRAME_TICKS(BM_SYNC_DATA_LENGTH));
+#ifdef SMPL_SECURE
+		rf_secure_frame(BM_SYNC_DATA_LENGTH);
+#endif
+		rf_sync_replies++;
+		if (!burst) continue;
+		rf_download[0].frames++;
+		rf_download[0].ticks       += CONV_MS_TO_TICKS(10) + RF_FRAME_TICKS(BM_SYNC_DATA_LENGTH);
+		rf_download[0].radio_ticks += CONV_MS_TO_TICKS(10) + RF_FRAME_TICKS(BM_SYNC_DATA_LENGTH);
+		if (rf_heard()) rf_download[0].bytes += DATALOG_PACKET_SIZE;
+	}
+}
+
+
+#ifndef CONFIG_SYNC_WOR
+// *************************************************************************************************
+// @fn          simpliciti_main_sync
+// @brief       Ready-to-receive packet and 10ms listen window every 0.5s, like main_ED_BM.c.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void simpliciti_main_sync(void)
+{
+	u8 cmd, contacted = 0;
+
+	radio_sxoff();
+	while (1)
+	{
+		if (!contacted) rf_send();
+		Timer0_A4_Delay(CONV_MS_TO_TICKS(500));
+#ifdef CONFIG_FREQ_AGILITY
+		rf_channel_move();
+#endif
+
+		// Access point answers only a ready-to-receive packet it can hear. Lost ones are not modelled, 
+		// they would only delay the command.
+		rf_send();
+		sim_radio_burst(0, RF_SYNC_RX_TICKS);
+		Timer0_A4_Delay(RF_SYNC_RX_TICKS);
+		if (rf_clear && rf_in_reach() && (cmd = sim_ap_command()) != 0)
+		{
+			contacted = 1;
+			rf_sync_command(cmd);
+		}
+		else
+		{
+			rf_link_event(SIMPLICITI_LINK_IDLE);
+		}
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) break;
+	}
+}
+#else
+// *************************************************************************************************
+// @fn          rf_wor_on
+// @brief       Start Wake-on-Radio with the settings of MRFI_WorOn.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void rf_wor_on(void)
+{
+	// Sync word interrupt ends the sleep of simpliciti_main_sync
+	RF1AIFG &= ~BIT9;
+	RF1AIE  |= BIT9;
+	Strobe(RF_SIDLE);
+	WriteSingleReg(MCSM2, BIT4 | 0x03);
+	WriteSingleReg(WOREVT1, 17333 >> 8);
+	WriteSingleReg(WOREVT0, 17333 & 0xFF);
+	WriteSingleReg(WORCTRL, 0x78);
+	Strobe(RF_SWOR);
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_main_sync
+// @brief       Wake-on-Radio sync like main_ED_BM.c. The access point repeats its command until
+//				the watch catches it during one of its carrier sniffs, on the channel the watch is on.
+//				The sync word interrupt ends the sleep.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void simpliciti_main_sync(void)
+{
+	u8 cmd;
+
+	rf_send();
+	rf_wor_on();
+	while (1)
+	{
+		Timer0_A4_DelayUntil(CONV_MS_TO_TICKS(BM_SYNC_WOR_TIMEOUT), &simpliciti_flag, 
+							 SIMPLICITI_TRIGGER_RECEIVED_DATA | SIMPLICITI_TRIGGER_STOP);
+		clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVED_DATA);
+
+		if (rf_chan == rf_ap_chan && (cmd = sim_ap_command()) != 0)
+		{
+			// Packet from the wake-up train, then replies and back to sniffing
+			sim_radio_burst(0, RF_PACKET_TICKS);
+			Timer0_A4_Delay(RF_PACKET_TICKS);
+			rf_sync_command(cmd);
+#ifdef CONFIG_FREQ_AGILITY
+			rf_channel_move();
+#endif
+			rf_wor_on();
+		}
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) break;
+	}
+	RF1AIE &= ~BIT9;
+	radio_sxoff();
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          MRFI_RadioIsr
+// @brief       Only the sync word interrupt of Wake-on-Radio is raised in the simulation. A packet
+//				on the channel the watch listens on is flagged like simpliciti_rx_callback does.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void MRFI_RadioIsr(void)
+{
+	if (!(RF1AIFG & BIT9)) return;
+	RF1AIFG &= ~BIT9;
+	if (rf_chan == rf_ap_chan) setFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVED_DATA);
+}
+
+
+// *************************************************************************************************
+// @fn          rf_report
+// @brief       Radio usage summary.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void rf_report(void)
+{
+	char name[24];
+	u32 busy;
+	u8 i;
+
+	if (rf_link_sessions == 0) return;
+	printf("%-24s %12lu  (%lu join requests, %lu resumed)\n", "SimpliciTI link attempts",
+		   (unsigned long)rf_link_sessions, (unsigned long)rf_link_attempts, (unsigned long)rf_link_resumed);
+	if (rf_accel.packets > 0)
+	{
+		printf("%-24s %12lu  (%lu samples, %lu payload bytes, %lu errors)\n", "SimpliciTI acc packets",
+			   (unsigned long)rf_accel.packets, (unsigned long)rf_accel.samples, 
+			   (unsigned long)rf_accel.bytes, (unsigned long)rf_accel.errors);
+	}
+#ifdef CONFIG_PHASE_CLOCK
+	if (rf_phase.packets > 0)
+	{
+		printf("%-24s %12lu  (%lu epochs, %lu repeated, %lu errors, movement %lu)\n", "SimpliciTI sleep packets",
+			   (unsigned long)rf_phase.packets, (unsigned long)rf_phase.epochs, (unsigned long)rf_phase.repeated,
+			   (unsigned long)rf_phase.errors, (unsigned long)rf_phase.sum);
+	}
+#endif
+	printf("%-24s %12lu  (%lu at -20dBm, %lu at -10dBm, %lu at +1dBm)\n", "SimpliciTI TX frames",
+		   (unsigned long)(rf_tx_frames[0] + rf_tx_frames[1] + rf_tx_frames[2]), (unsigned long)rf_tx_frames[0],
+		   (unsigned long)rf_tx_frames[1], (unsigned long)rf_tx_frames[2]);
+
+	// Channels only when there was interference or the link could move
+	busy = 0;
+	for (i = 0; i < RF_CHANNELS; i++) busy += rf_channel[i].cca_fails;
+#ifdef CONFIG_FREQ_AGILITY
+	busy++;
+#endif
+	for (i = 0; i < RF_CHANNELS && busy > 0; i++)
+	{
+		if (rf_channel[i].frames == 0) continue;
+		sprintf(name, "SimpliciTI channel %u", i);
+		printf("%-24s %12lu  (%lu CCA busy, %lu not sent, %lu delivered, %.1f uC radio per delivered frame)\n", 
+			   name, (unsigned long)rf_channel[i].frames, (unsigned long)rf_channel[i].cca_fails, 
+			   (unsigned long)rf_channel[i].dropped, (unsigned long)rf_channel[i].delivered,
+			   rf_channel[i].delivered ? rf_channel[i].charge / 32768.0 / 1000.0 / rf_channel[i].delivered : 0.0);
+	}
+#ifdef CONFIG_FREQ_AGILITY
+	printf("%-24s %12lu  (%lu requested, %lu found by scan)\n", "SimpliciTI channel moves",
+		   (unsigned long)rf_moves.moved, (unsigned long)rf_moves.requested, (unsigned long)rf_moves.scanned);
+#endif
+#ifdef SMPL_SECURE
+	if (rf_secure.frames > 0)
+	{
+		printf("%-24s %12lu  (%lu payload bytes, %lu cycles/byte, %lu failed, %lu of %lu tampered accepted)\n", 
+			   "SimpliciTI secured frames", (unsigned long)rf_secure.frames, (unsigned long)rf_secure.bytes, 
+			   (unsigned long)(rf_secure.cycles / rf_secure.bytes), (unsigned long)rf_secure.failed,
+			   (unsigned long)rf_secure.forged, (unsigned long)rf_secure.tampered);
+	}
+#endif
+	if (rf_sync_commands == 0) return;
+	printf("%-24s %12lu  (%lu reply packets)\n", "SimpliciTI sync commands",
+		   (unsigned long)rf_sync_commands, (unsigned long)rf_sync_replies);
+	for (i = 0; i < 2; i++)
+	{
+		if (rf_download[i].count == 0 || rf_download[i].bytes == 0) continue;
+		printf("%-24s %12lu  (%lu frames, %lu B/s, %lu ms radio on per KB)\n", 
+			   i ? "SimpliciTI window bytes" : "SimpliciTI burst bytes", (unsigned long)rf_download[i].bytes,
+			   (unsigned long)rf_download[i].frames,
+			   (unsigned long)((unsigned long long)rf_download[i].bytes * 32768u / rf_download[i].ticks),
+			   (unsigned long)((unsigned long long)rf_download[i].radio_ticks * 1000u * 1024u / 32768u / rf_download[i].bytes));
+	}
+}
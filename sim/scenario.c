@@ -0,0 +1,376 @@
+// *************************************************************************************************
+// Host simulation: scripted inputs.
+//
+// One event per line, sorted by time:
+//
+//		HH:MM:SS[.mmm]  press <star|num|up|down|backlight> [ms]
+//		HH:MM:SS[.mmm]  temperature <degC>
+//		HH:MM:SS[.mmm]  battery <V>
+//		HH:MM:SS[.mmm]  pressure <Pa>
+//		HH:MM:SS[.mmm]  pressure noise <Pa>					(rms)
+//		HH:MM:SS[.mmm]  accel <x> <y> <z> [s]				(g, turned to over s seconds)
+//		HH:MM:SS[.mmm]  accel noise <g>						(rms)
+//		HH:MM:SS[.mmm]  accel trace <file>					(recorded acceleration, see periph_trace_load)
+//		HH:MM:SS[.mmm]  climb <m/s> [s]						(vertical speed, reached after 2s)
+//		HH:MM:SS[.mmm]  walk <steps/min> [g]				(0 = stop, step acceleration 0.3g)
+//		HH:MM:SS[.mmm]  ap <on|off|nop|status|erase|exit|steps>	(SimpliciTI access point)
+//		HH:MM:SS[.mmm]  ap <burst|download>					(log download, 16 byte packets or windowed frames)
+//		HH:MM:SS[.mmm]  ap loss <percent>					(packet loss in both directions)
+//		HH:MM:SS[.mmm]  ap rssi <dBm>						(access point signal at the watch, -50)
+//		HH:MM:SS[.mmm]  ap busy <channel> <percent>			(interferer on a logical channel)
+//		HH:MM:SS[.mmm]  end
+//
+// '#' starts a comment. Button presses last 100ms unless a duration is given. 'ap on/off' moves the
+// access point in and out of range, 'ap loss', 'ap rssi' and 'ap busy' set the channel quality and the
+// other 'ap' events queue a command for a watch in sync mode. 'climb' changes the vertical speed with
+// constant acceleration over the given time, the next 'climb' must not start before. 'accel' is the 
+// reading at rest, vertical acceleration adds to it along gravity. With a time the reading turns 
+// from the last one at constant angular speed, the next 'accel' must not start before. 'walk' adds
+// steps along gravity and an arm swing to it, 'accel trace' replaces it until the trace ends. Only
+// one trace can be loaded per scenario.
+// *************************************************************************************************
+
+// *************************************************************************************************
+// Include section
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Defines section
+#define MAX_EVENTS				(4096u)
+
+enum { EV_INPUT = 0, EV_TEMPERATURE, EV_BATTERY, EV_PRESSURE, EV_ACCEL, EV_AP, EV_NOISE, EV_CLIMB, EV_WALK, EV_TRACE,
+	   EV_END };
+
+struct event
+{
+	sim_time_t	time;
+	uint8_t		type;
+	uint8_t		mask;
+	uint8_t		value;
+	double		arg[4];
+};
+
+
+// *************************************************************************************************
+// Global Variable section
+static struct event events[MAX_EVENTS];
+static unsigned event_count;
+static unsigned event_next;
+static const char * name = "";
+
+static const struct
+{
+	const char *	name;
+	uint8_t			mask;
+} buttons[] =
+{
+	{ "star",		SIM_BUTTON_STAR },
+	{ "num",		SIM_BUTTON_NUM },
+	{ "up",			SIM_BUTTON_UP },
+	{ "down",		SIM_BUTTON_DOWN },
+	{ "backlight",	SIM_BUTTON_BACKLIGHT },
+};
+
+// Access point range (mask 0), sync commands (mask 1, SYNC_AP_CMD_* in simpliciti/simpliciti.h),
+// packet loss (mask 2, value from the argument), signal strength (mask 3, negated argument) and
+// interference (mask 4, channel in arg[0], value from the second argument)
+static const struct
+{
+	const char *	name;
+	uint8_t			mask;
+	uint8_t			value;
+} ap_events[] =
+{
+	{ "off",		0,	0 },
+	{ "on",			0,	1 },
+	{ "nop",		1,	1 },
+	{ "status",		1,	2 },
+	{ "erase",		1,	6 },
+	{ "exit",		1,	7 },
+	{ "burst",		1,	4 },
+	{ "download",	1,	9 },
+	{ "steps",		1,	11 },
+	{ "loss",		2,	0 },
+	{ "rssi",		3,	0 },
+	{ "busy",		4,	0 },
+};
+
+
+static struct event * add_event(sim_time_t time, uint8_t type)
+{
+	struct event * e;
+
+	if (event_count == MAX_EVENTS) return NULL;
+	e = &events[event_count++];
+	memset(e, 0, sizeof(*e));
+	e->time = time;
+	e->type = type;
+	return e;
+}
+
+
+static int compare_events(const void * a, const void * b)
+{
+	const struct event * ea = a;
+	const struct event * eb = b;
+
+	if (ea->time != eb->time) return (ea->time > eb->time) - (ea->time < eb->time);
+	return (ea > eb) - (ea < eb);
+}
+
+
+// *************************************************************************************************
+// @fn          scenario_load
+// @brief       Read a scenario file.
+// @param       const char * path	Scenario file
+// @return      int					0 on success
+// *************************************************************************************************
+int scenario_load(const char * path)
+{
+	char line[256], cmd[32], arg[32], file[256];
+	unsigned h, m, s, ms, lineno = 0, i;
+	double ms_f, x = 0.0, y = 0.0, z = 0.0, w;
+	struct event * e;
+	FILE * f;
+	char * p;
+	int n, ok;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	name = path;
+
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		lineno++;
+		if ((p = strchr(line, '#')) != NULL) *p = '\0';
+		if (sscanf(line, " %31s", cmd) != 1) continue;
+
+		ms = 0;
+		n = 0;
+		if (sscanf(line, " %u:%u:%u.%3[0-9] %31s%n", &h, &m, &s, arg, cmd, &n) == 5)
+		{
+			// Fraction of a second, ".5" = 500ms
+			ms = (unsigned)strtoul(arg, NULL, 10);
+			for (i = strlen(arg); i < 3; i++) ms *= 10;
+		}
+		else if (sscanf(line, " %u:%u:%u %31s%n", &h, &m, &s, cmd, &n) != 4) goto syntax;
+		p  = line + n;
+		ok = 1;
+		e  = NULL;
+
+		if (strcmp(cmd, "press") == 0)
+		{
+			ms_f = 100.0;
+			if (sscanf(p, " %31s %lf", arg, &ms_f) < 1) goto syntax;
+			for (i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++)
+			{
+				if (strcmp(arg, buttons[i].name) == 0) break;
+			}
+			if (i == sizeof(buttons) / sizeof(buttons[0])) goto syntax;
+
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_INPUT);
+			if (e == NULL) break;
+			e->mask  = buttons[i].mask;
+			e->value = buttons[i].mask;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms) + SIM_MS((unsigned)ms_f), EV_INPUT);
+			if (e == NULL) break;
+			e->mask  = buttons[i].mask;
+			e->value = 0;
+			continue;
+		}
+
+		if (strcmp(cmd, "ap") == 0)
+		{
+			x = y = 0.0;
+			if (sscanf(p, " %31s %lf %lf", arg, &x, &y) < 1) goto syntax;
+			for (i = 0; i < sizeof(ap_events) / sizeof(ap_events[0]); i++)
+			{
+				if (strcmp(arg, ap_events[i].name) == 0) break;
+			}
+			if (i == sizeof(ap_events) / sizeof(ap_events[0])) goto syntax;
+			if (ap_events[i].mask == 2 && (x < 0.0 || x > 100.0)) goto syntax;
+			if (ap_events[i].mask == 3 && (x < -127.0 || x > 0.0)) goto syntax;
+			if (ap_events[i].mask == 4 && (x < 0.0 || x >= SIM_AP_CHANNELS || y < 0.0 || y > 100.0)) goto syntax;
+
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_AP);
+			if (e == NULL) break;
+			e->mask  = ap_events[i].mask;
+			e->value = (ap_events[i].mask == 2) ? (uint8_t)x : (ap_events[i].mask == 3) ? (uint8_t)-x : ap_events[i].value;
+			if (ap_events[i].mask == 4)
+			{
+				e->arg[0] = x;
+				e->value  = (uint8_t)y;
+			}
+			continue;
+		}
+
+		if ((strcmp(cmd, "pressure") == 0 || strcmp(cmd, "accel") == 0) && sscanf(p, " noise %lf", &x) == 1)
+		{
+			if (x < 0.0) goto syntax;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_NOISE);
+			if (e == NULL) break;
+			e->mask   = (cmd[0] == 'a');
+			e->arg[0] = x;
+			continue;
+		}
+
+		if (strcmp(cmd, "accel") == 0 && sscanf(p, " trace %255s", file) == 1)
+		{
+			if (periph_trace_load(file) != 0) goto syntax;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_TRACE);
+			if (e == NULL) break;
+			continue;
+		}
+
+		if (strcmp(cmd, "accel") == 0 && sscanf(p, "%lf %lf %lf %lf", &x, &y, &z, &w) == 4)
+		{
+			// Turn (mask 1) from the last reading to the new one in arg[3] seconds
+			if (w <= 0.0) goto syntax;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_ACCEL);
+			if (e == NULL) break;
+			e->mask   = 1;
+			e->arg[0] = x;
+			e->arg[1] = y;
+			e->arg[2] = z;
+			e->arg[3] = w;
+			continue;
+		}
+
+		if (strcmp(cmd, "walk") == 0)
+		{
+			y = sim_env.step_g;
+			if (sscanf(p, "%lf %lf", &x, &y) < 1 || x < 0.0 || y < 0.0) goto syntax;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_WALK);
+			if (e == NULL) break;
+			e->arg[0] = x;
+			e->arg[1] = y;
+			continue;
+		}
+
+		if (strcmp(cmd, "climb") == 0)
+		{
+			// Start (mask 0) and end (mask 1) of the change of vertical speed
+			y = 2.0;
+			if (sscanf(p, "%lf %lf", &x, &y) < 1 || y <= 0.0) goto syntax;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms), EV_CLIMB);
+			if (e == NULL) break;
+			e->arg[0] = x;
+			e->arg[1] = y;
+			e = add_event(SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms) + SIM_MS((unsigned)(y * 1000.0)), EV_CLIMB);
+			if (e == NULL) break;
+			e->mask   = 1;
+			e->arg[0] = x;
+			continue;
+		}
+
+		if (strcmp(cmd, "temperature") == 0)	{ e = add_event(0, EV_TEMPERATURE); ok = sscanf(p, "%lf", &x) == 1; }
+		else if (strcmp(cmd, "battery") == 0)	{ e = add_event(0, EV_BATTERY); ok = sscanf(p, "%lf", &x) == 1; }
+		else if (strcmp(cmd, "pressure") == 0)	{ e = add_event(0, EV_PRESSURE); ok = sscanf(p, "%lf", &x) == 1; }
+		else if (strcmp(cmd, "accel") == 0)		{ e = add_event(0, EV_ACCEL); ok = sscanf(p, "%lf %lf %lf", &x, &y, &z) == 3; }
+		else if (strcmp(cmd, "end") == 0)		{ e = add_event(0, EV_END); }
+		else goto syntax;
+
+		if (e == NULL) break;
+		if (!ok) goto syntax;
+		e->time   = SIM_SEC(h * 3600 + m * 60 + s) + SIM_MS(ms);
+		e->arg[0] = x;
+		e->arg[1] = y;
+		e->arg[2] = z;
+		continue;
+
+syntax:
+		fprintf(stderr, "%s:%u: cannot parse '%s'\n", path, lineno, cmd);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	if (event_count == MAX_EVENTS)
+	{
+		fprintf(stderr, "%s: more than %u events\n", path, MAX_EVENTS);
+		return -1;
+	}
+	qsort(events, event_count, sizeof(events[0]), compare_events);
+	if (event_count == 0 || events[event_count - 1].type != EV_END)
+	{
+		fprintf(stderr, "%s: scenario must finish with 'end'\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+
+sim_time_t scenario_next_event(void)
+{
+	return (event_next < event_count) ? events[event_next].time : SIM_NEVER;
+}
+
+
+const char * scenario_name(void)
+{
+	return name;
+}
+
+
+// *************************************************************************************************
+// @fn          scenario_run
+// @brief       Apply all events that are due.
+// @param       sim_time_t now		Current time
+// @return      none
+// *************************************************************************************************
+void scenario_run(sim_time_t now)
+{
+	struct event * e;
+
+	while (event_next < event_count && events[event_next].time <= now)
+	{
+		e = &events[event_next++];
+		switch (e->type)
+		{
+			case EV_INPUT:			periph_set_inputs(e->mask, e->value); break;
+			case EV_TEMPERATURE:	sim_env.temperature = e->arg[0]; break;
+			case EV_BATTERY:		sim_env.battery = e->arg[0]; break;
+			case EV_PRESSURE:		sim_env.pressure = e->arg[0]; break;
+			case EV_ACCEL:			if (e->mask)
+									{
+										memcpy(sim_env.turn_from, sim_env.accel, sizeof(sim_env.turn_from));
+										sim_env.turn_start = e->time;
+										sim_env.turn_end   = e->time + SIM_MS((unsigned)(e->arg[3] * 1000.0));
+									}
+									memcpy(sim_env.accel, e->arg, sizeof(sim_env.accel));
+									break;
+			case EV_AP:				if (e->mask == 4) sim_env.ap_busy[(unsigned)e->arg[0]] = e->value;
+									else if (e->mask == 3) sim_env.ap_rssi = (int8_t)-e->value;
+									else if (e->mask == 2) sim_env.ap_loss = e->value;
+									else if (e->mask) sim_env.ap_cmd = e->value;
+									else sim_env.ap = e->value;
+									periph_ap_update();
+									break;
+			case EV_NOISE:			if (e->mask) sim_env.accel_noise = e->arg[0];
+									else sim_env.pressure_noise = e->arg[0];
+									break;
+			case EV_CLIMB:			if (e->mask)
+									{
+										sim_env.climb  = e->arg[0];
+										sim_env.vaccel = 0.0;
+									}
+									else sim_env.vaccel = (e->arg[0] - sim_env.climb) / e->arg[1];
+									break;
+			case EV_WALK:			sim_env.cadence = e->arg[0];
+									sim_env.step_g  = e->arg[1];
+									break;
+			case EV_TRACE:			periph_trace_start(); break;
+			case EV_END:			sim_finish();
+		}
+		sim_irq_update();
+	}
+}
@@ -0,0 +1,747 @@
+// *************************************************************************************************
+// Host simulation core: virtual time, status register / low power modes, interrupt dispatch,
+// register access hooks, per-module cycle accounting and the final report.
+// *************************************************************************************************
+
+#define _GNU_SOURCE
+
+// *************************************************************************************************
+// Include section
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+
+// *************************************************************************************************
+// Prototypes section
+extern int firmware_main(void);
+void sim_register_module(const char * name, void (*anchor)(void));
+volatile void * sim_io(unsigned short addr, unsigned char size);
+void sim_bis_sr(unsigned short bits);
+void sim_bic_sr(unsigned short bits);
+void sim_bic_sr_on_exit(unsigned short bits);
+unsigned short sim_get_sr(void);
+void __sanitizer_cov_trace_pc(void);
+unsigned short __get_interrupt_state(void);
+void __set_interrupt_state(unsigned short state);
+unsigned short __even_in_range(unsigned short value, unsigned short bound);
+void __delay_cycles(unsigned long cycles);
+
+// Firmware ISRs, resolved by name
+extern void RTC_ISR(void) __attribute__((weak));
+extern void PORT2_ISR(void) __attribute__((weak));
+extern void radio_ISR(void) __attribute__((weak));
+extern void TIMER0_A1_5_ISR(void) __attribute__((weak));
+extern void TIMER0_A0_ISR(void) __attribute__((weak));
+extern void ADC12ISR(void) __attribute__((weak));
+
+
+// *************************************************************************************************
+// Defines section
+
+// Status register bits (same encoding as the device)
+#define SR_GIE					(0x0008)
+#define SR_CPUOFF				(0x0010)
+#define SR_LPM_BITS				(0x00F0)
+
+#define MAX_MODULES				(64u)
+#define MAX_ISR_DEPTH			(8u)
+
+// Interrupt storm guard: dispatches of one vector without simulated time passing
+#define STORM_LIMIT				(10000u)
+
+struct sim_module
+{
+	const char *	name;
+	uintptr_t		anchor;
+	uint64_t		cycles;
+};
+
+struct sim_vector
+{
+	const char *	name;
+	void 			(*isr)(void);
+	uint64_t		calls;
+	uint64_t		wakeups;
+	uint64_t		cycles;
+	sim_time_t		last;
+	uint32_t		storm;
+};
+
+
+// *************************************************************************************************
+// Global Variable section
+sim_time_t sim_now;
+uint64_t sim_cycles;
+struct sim_env sim_env =
+{
+	.temperature	= 22.0,
+	.battery		= 3.0,
+	.pressure		= 101325.0,
+	.accel			= { 0.0, 0.0, 1.0 },
+	.step_g			= 0.3,
+	.ap_rssi		= -50,
+};
+volatile unsigned char sim_mem[0x1000];
+
+static jmp_buf sim_exit;
+static int sim_running;
+static int sim_status;
+static uint16_t sim_sr;
+static uint8_t isr_depth;
+static uint16_t isr_exit_clear[MAX_ISR_DEPTH];
+static int8_t isr_stack[MAX_ISR_DEPTH];
+static uint8_t irq_dirty = 1;
+
+static uint64_t cycle_fraction;
+static sim_time_t sleep_ticks;
+static uint64_t lpm_entries;
+static double charge[SIM_E_COUNT];				// nA * ticks
+static uint64_t main_cycles;
+
+static struct sim_module modules[MAX_MODULES];
+static uint8_t module_count;
+static uint8_t modules_sorted;
+static struct sim_module * module_last;
+
+static uint16_t io_pending_addr;
+static uint8_t io_pending_size;
+
+static struct sim_vector vectors[SIM_IRQ_COUNT] =
+{
+	[SIM_IRQ_RTC]		= { "RTC",			0 },
+	[SIM_IRQ_PORT2]		= { "PORT2",		0 },
+	[SIM_IRQ_CC1101]	= { "CC1101",		0 },
+	[SIM_IRQ_TIMER0_A1]	= { "TIMER0_A1",	0 },
+	[SIM_IRQ_TIMER0_A0]	= { "TIMER0_A0",	0 },
+	[SIM_IRQ_ADC12]		= { "ADC12",		0 },
+	[SIM_IRQ_USCI_A0]	= { "USCI_A0",		0 },
+};
+
+static const char * const energy_names[SIM_E_COUNT] =
+{
+	"LPM3", "CPU active", "LCD", "ADC/REF", "Flash", "Buzzer", "Backlight",
+	"Accelerometer", "Pressure sensor", "Radio",
+};
+
+
+// *************************************************************************************************
+// @fn          sim_fail
+// @brief       Abort the simulation with a diagnostic. The report is still printed.
+// @param       const char * fmt	printf style message
+// @return      none
+// *************************************************************************************************
+void sim_fail(const char * fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "sim: %02u:%02u:%02u.%03u: ", (unsigned)(sim_now / SIM_SEC(3600)),
+			(unsigned)(sim_now / SIM_SEC(60) % 60), (unsigned)(sim_now / SIM_SEC(1) % 60),
+			(unsigned)(sim_now % SIM_ACLK_HZ * 1000 / SIM_ACLK_HZ));
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+
+	if (!sim_running) exit(2);
+	sim_status = 1;
+	longjmp(sim_exit, 1);
+}
+
+
+// *************************************************************************************************
+// @fn          sim_finish
+// @brief       End of scenario reached. Leave the firmware and print the report.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void sim_finish(void)
+{
+	longjmp(sim_exit, 1);
+}
+
+
+// *************************************************************************************************
+// @fn          sim_register_module
+// @brief       Called from the constructor emitted by sim_module.h for each firmware file.
+// @param       const char * name		Module name
+//				void (*anchor)(void)	First function of the module
+// @return      none
+// *************************************************************************************************
+void sim_register_module(const char * name, void (*anchor)(void))
+{
+	if (module_count == MAX_MODULES) return;
+	modules[module_count].name   = name;
+	modules[module_count].anchor = (uintptr_t)anchor;
+	module_count++;
+	modules_sorted = 0;
+}
+
+
+static int module_compare(const void * a, const void * b)
+{
+	const struct sim_module * ma = a;
+	const struct sim_module * mb = b;
+
+	return (ma->anchor > mb->anchor) - (ma->anchor < mb->anchor);
+}
+
+
+// *************************************************************************************************
+// @fn          module_find
+// @brief       Map a code address to the firmware module containing it.
+// @param       uintptr_t pc		Code address
+// @return      struct sim_module *	Module or NULL
+// *************************************************************************************************
+static struct sim_module * module_find(uintptr_t pc)
+{
+	int lo, hi, mid;
+
+	if (!modules_sorted)
+	{
+		qsort(modules, module_count, sizeof(modules[0]), module_compare);
+		modules_sorted = 1;
+		module_last = NULL;
+	}
+
+	// Most blocks belong to the same module as the previous one
+	if (module_last != NULL && pc >= module_last->anchor &&
+		(module_last == &modules[module_count - 1] || pc < (module_last + 1)->anchor))
+	{
+		return module_last;
+	}
+
+	lo = 0;
+	hi = module_count - 1;
+	if (hi < 0 || pc < modules[0].anchor) return NULL;
+	while (lo < hi)
+	{
+		mid = (lo + hi + 1) / 2;
+		if (modules[mid].anchor <= pc) lo = mid;
+		else hi = mid - 1;
+	}
+	module_last = &modules[lo];
+	return module_last;
+}
+
+
+// *************************************************************************************************
+// @fn          account
+// @brief       Integrate current consumption over a span of simulated time.
+// @param       sim_time_t ticks	Span length
+//				int asleep			CPU in LPM3 during the span
+// @return      none
+// *************************************************************************************************
+static void account(sim_time_t ticks, int asleep)
+{
+	uint32_t na[SIM_E_COUNT];
+	int i;
+
+	memset(na, 0, sizeof(na));
+	periph_current(na);
+	if (asleep)
+	{
+		na[SIM_E_LPM] += SIM_NA_LPM3;
+		sleep_ticks += ticks;
+	}
+	else
+	{
+		na[SIM_E_CPU] += SIM_NA_ACTIVE;
+	}
+	for (i = 0; i < SIM_E_COUNT; i++) charge[i] += (double)na[i] * (double)ticks;
+}
+
+
+// *************************************************************************************************
+// @fn          sim_advance
+// @brief       Move simulated time forward, stepping through scenario events on the way.
+// @param       sim_time_t to		Target time
+//				int asleep			CPU sleeps during the span
+// @return      none
+// *************************************************************************************************
+static void sim_advance(sim_time_t to, int asleep)
+{
+	sim_time_t step, event;
+
+	while (sim_now < to)
+	{
+		step  = to;
+		event = scenario_next_event();
+		if (event < step) step = event;
+
+		account(step - sim_now, asleep);
+		periph_advance(sim_now, step);
+		sim_now = step;
+
+		if (sim_now >= event) scenario_run(sim_now);
+	}
+	irq_dirty = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          sim_charge
+// @brief       Charge active MCLK cycles to a module and to the current interrupt context.
+// @param       uintptr_t pc		Code address (0 = no module)
+//				uint32_t cycles		MCLK cycles
+// @return      none
+// *************************************************************************************************
+static void sim_charge(uintptr_t pc, uint32_t cycles)
+{
+	struct sim_module * m;
+	sim_time_t ticks;
+
+	if (pc != 0 && (m = module_find(pc)) != NULL) m->cycles += cycles;
+	if (isr_depth > 0) vectors[isr_stack[isr_depth - 1]].cycles += cycles;
+	else main_cycles += cycles;
+	sim_cycles += cycles;
+
+	// Active cycles to ACLK ticks at 12MHz, keeping the remainder
+	cycle_fraction += (uint64_t)cycles * SIM_ACLK_HZ;
+	if (cycle_fraction >= SIM_MCLK_HZ)
+	{
+		ticks = cycle_fraction / SIM_MCLK_HZ;
+		cycle_fraction -= ticks * SIM_MCLK_HZ;
+		sim_advance(sim_now + ticks, 0);
+	}
+}
+
+
+void sim_charge_cycles(uint32_t cycles)
+{
+	sim_charge(0, cycles);
+}
+
+
+// *************************************************************************************************
+// @fn          sim_radio_charge
+// @brief       Charge drawn by the radio so far, for the per-channel figures of sim/rf.c.
+// @param       none
+// @return      double		nA * ACLK ticks
+// *************************************************************************************************
+double sim_radio_charge(void)
+{
+	return charge[SIM_E_RADIO];
+}
+
+
+// *************************************************************************************************
+// @fn          sim_total_charge / sim_wakeups / sim_irq_calls
+// @brief       Charge, LPM wakeups and interrupt calls so far, for the figures per activity of
+//				the walk report in sim/periph.c.
+// @param       sim_irq_t irq		Interrupt source
+// @return      double				nA * ACLK ticks, all consumers
+//				uint64_t			Wakeups of all vectors / calls of one vector
+// *************************************************************************************************
+double sim_total_charge(void)
+{
+	double total = 0.0;
+	int i;
+
+	for (i = 0; i < SIM_E_COUNT; i++) total += charge[i];
+	return total;
+}
+
+
+uint64_t sim_wakeups(void)
+{
+	uint64_t wakeups = 0;
+	int i;
+
+	for (i = 0; i < SIM_IRQ_COUNT; i++) wakeups += vectors[i].wakeups;
+	return wakeups;
+}
+
+
+uint64_t sim_irq_calls(sim_irq_t irq)
+{
+	return vectors[irq].calls;
+}
+
+
+// *************************************************************************************************
+// @fn          sim_sleep_for
+// @brief       Let simulated time pass with the CPU busy (e.g. stalled by the flash controller).
+// @param       sim_time_t ticks	Duration
+// @return      none
+// *************************************************************************************************
+void sim_sleep_for(sim_time_t ticks)
+{
+	sim_cycles += ticks * SIM_MCLK_HZ / SIM_ACLK_HZ;
+	sim_advance(sim_now + ticks, 0);
+}
+
+
+// *************************************************************************************************
+// @fn          io_commit
+// @brief       Let peripherals react to the previous register access once the firmware is done
+//				with it (read-modify-write included).
+// @param       none
+// @return      none
+// *************************************************************************************************
+static inline void io_commit(void)
+{
+	uint8_t size = io_pending_size;
+
+	if (size)
+	{
+		io_pending_size = 0;
+		periph_commit(io_pending_addr, size);
+		irq_dirty = 1;
+	}
+}
+
+
+void sim_irq_update(void)
+{
+	irq_dirty = 1;
+}
+
+
+uint16_t sim_rd16(uint16_t addr)
+{
+	return (uint16_t)(sim_mem[addr] | (sim_mem[addr + 1] << 8));
+}
+
+
+void sim_wr16(uint16_t addr, uint16_t value)
+{
+	sim_mem[addr]     = (uint8_t)value;
+	sim_mem[addr + 1] = (uint8_t)(value >> 8);
+}
+
+
+// *************************************************************************************************
+// @fn          sim_io
+// @brief       Register access from the firmware (SFR_8BIT / SFR_16BIT).
+// @param       unsigned short addr		Register address
+//				unsigned char size		Access width in bytes
+// @return      volatile void *			Pointer to the register backing store
+// *************************************************************************************************
+volatile void * sim_io(unsigned short addr, unsigned char size)
+{
+	io_commit();
+	if (addr >= sizeof(sim_mem) - 1) sim_fail("register access outside I/O page: 0x%04X", addr);
+
+	periph_access(addr, size);
+	io_pending_addr = addr;
+	io_pending_size = size;
+	return &sim_mem[addr];
+}
+
+
+// *************************************************************************************************
+// @fn          irq_next
+// @brief       Highest priority interrupt that is pending, enabled and has a handler.
+// @param       none
+// @return      int		sim_irq_t or -1
+// *************************************************************************************************
+static int irq_next(void)
+{
+	int irq;
+
+	for (irq = SIM_IRQ_COUNT - 1; irq >= 0; irq--)
+	{
+		if (vectors[irq].isr != NULL && periph_irq_pending((sim_irq_t)irq)) return irq;
+	}
+	irq_dirty = 0;
+	return -1;
+}
+
+
+// *************************************************************************************************
+// @fn          irq_dispatch
+// @brief       Enter an ISR like the CPU does: push SR, clear GIE and LPM bits, call the
+//				handler and restore SR minus the bits cleared with _BIC_SR_IRQ.
+// @param       int irq		Interrupt source
+// @return      none
+// *************************************************************************************************
+static void irq_dispatch(int irq)
+{
+	struct sim_vector * v = &vectors[irq];
+	uint16_t sr = sim_sr;
+
+	if (isr_depth == MAX_ISR_DEPTH) sim_fail("interrupt nesting too deep in %s", v->name);
+	if (v->last == sim_now)
+	{
+		if (++v->storm > STORM_LIMIT) sim_fail("interrupt storm on %s (flag never cleared)", v->name);
+	}
+	else
+	{
+		v->last  = sim_now;
+		v->storm = 0;
+	}
+
+	v->calls++;
+	if (sr & SR_CPUOFF)
+	{
+		v->wakeups++;
+		sim_charge_cycles(SIM_CYCLES_PER_WAKEUP);
+	}
+
+	isr_exit_clear[isr_depth] = 0;
+	isr_stack[isr_depth++] = (int8_t)irq;
+	periph_irq_accept((sim_irq_t)irq);
+	sim_sr = sr & ~(SR_GIE | SR_LPM_BITS);
+	sim_charge_cycles(SIM_CYCLES_PER_ISR);
+
+	v->isr();
+
+	io_commit();
+	isr_depth--;
+	sim_sr = sr & ~isr_exit_clear[isr_depth];
+	irq_dirty = 1;
+}
+
+
+// *************************************************************************************************
+// @fn          irq_poll
+// @brief       Take all pending interrupts while GIE is set.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static inline void irq_poll(void)
+{
+	int irq;
+
+	while ((sim_sr & SR_GIE) && irq_dirty && (irq = irq_next()) >= 0) irq_dispatch(irq);
+}
+
+
+// *************************************************************************************************
+// @fn          cpu_sleep
+// @brief       Low power mode: service interrupts, otherwise jump to the next hardware or
+//				scenario event. Returns when an ISR cleared CPUOFF in the saved SR.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void cpu_sleep(void)
+{
+	sim_time_t next, event;
+	int irq;
+
+	lpm_entries++;
+	while (sim_sr & SR_CPUOFF)
+	{
+		if ((sim_sr & SR_GIE) && (irq = irq_next()) >= 0)
+		{
+			irq_dispatch(irq);
+			continue;
+		}
+
+		next  = periph_next_event();
+		event = scenario_next_event();
+		if (event < next) next = event;
+		if (next == SIM_NEVER) sim_fail("CPU sleeps without any wake-up source");
+		sim_advance(next, 1);
+	}
+}
+
+
+// *************************************************************************************************
+// Status register intrinsics
+// *************************************************************************************************
+void sim_bis_sr(unsigned short bits)
+{
+	io_commit();
+	sim_sr |= bits;
+	irq_dirty = 1;
+	if (sim_sr & SR_CPUOFF) cpu_sleep();
+	else irq_poll();
+}
+
+
+void sim_bic_sr(unsigned short bits)
+{
+	io_commit();
+	sim_sr &= ~bits;
+}
+
+
+void sim_bic_sr_on_exit(unsigned short bits)
+{
+	io_commit();
+	if (isr_depth > 0) isr_exit_clear[isr_depth - 1] |= bits;
+	else sim_sr &= ~bits;
+}
+
+
+unsigned short sim_get_sr(void)
+{
+	return sim_sr;
+}
+
+
+unsigned short __get_interrupt_state(void)
+{
+	return sim_sr;
+}
+
+
+void __set_interrupt_state(unsigned short state)
+{
+	io_commit();
+	sim_sr = (sim_sr & ~SR_GIE) | (state & SR_GIE);
+	irq_dirty = 1;
+	irq_poll();
+}
+
+
+unsigned short __even_in_range(unsigned short value, unsigned short bound)
+{
+	(void)bound;
+	return value;
+}
+
+
+void __delay_cycles(unsigned long cycles)
+{
+	io_commit();
+	sim_charge((uintptr_t)__builtin_return_address(0), (uint32_t)cycles);
+	irq_poll();
+}
+
+
+// *************************************************************************************************
+// @fn          __sanitizer_cov_trace_pc
+// @brief       Called by every basic block of the firmware (-fsanitize-coverage=trace-pc).
+//				Completes the previous register access, charges the block's cycles and takes
+//				interrupts that became pending.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void __sanitizer_cov_trace_pc(void)
+{
+	if (!sim_running) return;
+
+	io_commit();
+	sim_charge((uintptr_t)__builtin_return_address(0), SIM_CYCLES_PER_BLOCK);
+	irq_poll();
+}
+
+
+// *************************************************************************************************
+// @fn          flash_map
+// @brief       Map erased flash at the device addresses and install calibration data.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void flash_map(void)
+{
+	uint8_t * cal;
+
+	sim_flash_map();
+
+	// Calibration record in INFO D as written by the production test (see read_calibration_values)
+	cal = (uint8_t *)(uintptr_t)0x1800;
+	cal[0]  = 0x01;							// Record valid
+	cal[1]  = 0x00;							// RF frequency offset
+	cal[2]  = 0x00;	cal[3]  = 0x00;			// Temperature offset (0.1 degC)
+	cal[4]  = 0x00;	cal[5]  = 0x00;			// Battery offset (10mV)
+	cal[6]  = 0x79;	cal[7]  = 0x56;			// Device address
+	cal[8]  = 0x34;	cal[9]  = 0x12;
+	cal[10] = 0x00;	cal[11] = 0x00;			// Altitude offset
+	cal[12] = 0x01;							// Production test software version
+
+	sim_flash_protect();
+}
+
+
+// *************************************************************************************************
+// @fn          print_report
+// @brief       Summary of the simulated run.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void print_report(void)
+{
+	double seconds = (double)sim_now / SIM_ACLK_HZ;
+	double total = 0.0;
+	uint64_t active = 0;
+	int i;
+
+	printf("\n=== ezchronos-sim: %s ===\n", scenario_name());
+	printf("simulated time      %12.1f s\n", seconds);
+	if (sim_now == 0) return;
+
+	printf("LPM3 residency      %12.4f %%\n", 100.0 * (double)sleep_ticks / (double)sim_now);
+	printf("LPM entries         %12llu\n", (unsigned long long)lpm_entries);
+	printf("active cycles       %12llu (%.2f per second)\n", (unsigned long long)sim_cycles,
+		   (double)sim_cycles / seconds);
+
+	printf("\n%-16s %12s %12s %14s\n", "vector", "calls", "wakeups", "cycles");
+	for (i = SIM_IRQ_COUNT - 1; i >= 0; i--)
+	{
+		if (vectors[i].calls == 0) continue;
+		printf("%-16s %12llu %12llu %14llu\n", vectors[i].name, (unsigned long long)vectors[i].calls,
+			   (unsigned long long)vectors[i].wakeups, (unsigned long long)vectors[i].cycles);
+	}
+	printf("%-16s %12s %12s %14llu\n", "main", "", "", (unsigned long long)main_cycles);
+
+	for (i = 0; i < module_count; i++) active += modules[i].cycles;
+	printf("\n%-16s %14s %8s\n", "module", "cycles", "share");
+	for (i = 0; i < module_count; i++)
+	{
+		if (modules[i].cycles == 0) continue;
+		printf("%-16s %14llu %7.2f%%\n", modules[i].name, (unsigned long long)modules[i].cycles,
+			   active ? 100.0 * (double)modules[i].cycles / (double)active : 0.0);
+	}
+
+	periph_report();
+	rf_report();
+
+	printf("\n%-16s %12s\n", "consumer", "avg uA");
+	for (i = 0; i < SIM_E_COUNT; i++)
+	{
+		total += charge[i];
+		if (charge[i] == 0.0) continue;
+		printf("%-16s %12.3f\n", energy_names[i], charge[i] / (double)sim_now / 1000.0);
+	}
+	printf("%-16s %12.3f\n", "total", total / (double)sim_now / 1000.0);
+	printf("est. lifetime on 220mAh CR2032: %.0f days\n",
+		   220000.0 / (total / (double)sim_now / 1000.0) / 24.0);
+}
+
+
+// *************************************************************************************************
+// @fn          main
+// @brief       Run the firmware through a scenario and print the report.
+// @param       argc / argv		ezchronos-sim <scenario>
+// @return      0 on success, 1 if the simulation aborted
+// *************************************************************************************************
+int main(int argc, char ** argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <scenario>\n", argv[0]);
+		return 2;
+	}
+	if (scenario_load(argv[1]) != 0) return 2;
+
+	flash_map();
+	periph_reset();
+
+	vectors[SIM_IRQ_RTC].isr       = RTC_ISR;
+	vectors[SIM_IRQ_PORT2].isr     = PORT2_ISR;
+	vectors[SIM_IRQ_CC1101].isr    = radio_ISR;
+	vectors[SIM_IRQ_TIMER0_A1].isr = TIMER0_A1_5_ISR;
+	vectors[SIM_IRQ_TIMER0_A0].isr = TIMER0_A0_ISR;
+	vectors[SIM_IRQ_ADC12].isr     = ADC12ISR;
+
+	scenario_run(0);
+
+	if (setjmp(sim_exit) == 0)
+	{
+		sim_running = 1;
+		firmware_main();
+		sim_fail("main() returned");
+	}
+	sim_running = 0;
+
+	print_report();
+	return sim_status;
+}
@@ -0,0 +1,190 @@
+// *************************************************************************************************
+// Host simulation of the eZ430-Chronos firmware.
+//
+// The firmware (ezchronos.c, driver/, logic/) is compiled for the host against the register
+// stand-in in sim/include. Time is virtual and derived from the 32768Hz ACLK: sleeping in LPM
+// jumps straight to the next hardware event, active code advances time by an estimated number of
+// MCLK cycles per executed basic block. Peripheral models, a scripted scenario and the energy
+// bookkeeping live in the files next to this header.
+// *************************************************************************************************
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+
+
+// *************************************************************************************************
+// Defines section
+
+// Clock tree
+#define SIM_ACLK_HZ					(32768ull)
+#define SIM_MCLK_HZ					(12000000ull)
+#define SIM_NEVER					(~0ull)
+
+// Flash is mapped at its device address; the I/O page below it lives in sim_mem
+#define FLASH_START					(0x1000u)
+#define FLASH_END					(0x10000u)
+
+// Time conversion (ACLK ticks)
+#define SIM_SEC(s)					((sim_time_t)(s) * SIM_ACLK_HZ)
+#define SIM_MS(ms)					(((sim_time_t)(ms) * SIM_ACLK_HZ) / 1000)
+
+// Cycle model: MSP430 MCLK cycles charged per executed (host) basic block, per interrupt
+// entry/exit and per wake-up from LPM3 (DCO/FLL start-up)
+#define SIM_CYCLES_PER_BLOCK		(10u)
+#define SIM_CYCLES_PER_ISR			(11u)
+#define SIM_CYCLES_PER_WAKEUP		(60u)
+
+// Current model in nA. First-order values from the CC430F6137, CMA3000-D01 and SCP1000-D11
+// datasheets - calibrate against a measured watch before trusting absolute numbers.
+#define SIM_NA_LPM3					(1700u)		// LPM3, XT1 running, SVS off
+#define SIM_NA_LCD					(800u)		// LCD_B, 4-mux, no charge pump
+#define SIM_NA_LCD_CHARGE_PUMP		(4000u)		// Additional current with LCDCPEN
+#define SIM_NA_ACTIVE				(3300000u)	// Active mode, 12MHz, VCORE 3
+#define SIM_NA_ADC_REF				(250000u)	// ADC12 + REF module enabled
+#define SIM_NA_FLASH				(3000000u)	// Flash program / erase
+#define SIM_NA_BUZZER				(2000000u)	// Piezo buzzer driven at 4kHz
+#define SIM_NA_BACKLIGHT			(1500000u)	// Backlight LED
+#define SIM_NA_AS_STANDBY			(3000u)		// CMA3000 powered, no measurement
+#define SIM_NA_AS_MD				(7000u)		// CMA3000 motion detection (10Hz)
+#define SIM_NA_AS_40HZ				(10000u)	// CMA3000 measurement 40Hz
+#define SIM_NA_AS_100HZ				(50000u)	// CMA3000 measurement 100Hz
+#define SIM_NA_AS_400HZ				(70000u)	// CMA3000 measurement 400Hz
+#define SIM_NA_PS_STANDBY			(200u)		// SCP1000 standby
+#define SIM_NA_PS_LOW_POWER			(3500u)		// SCP1000 ultra low power, 1Hz
+#define SIM_NA_PS_HIGH_RES			(25000u)	// SCP1000 high resolution / high speed
+#define SIM_NA_RADIO_IDLE			(1700000u)	// RF1A IDLE (XOSC on)
+#define SIM_NA_RADIO_RX				(16000000u)	// RF1A RX
+#define SIM_NA_RADIO_TX				(30000000u)	// RF1A TX, +3dBm
+#define SIM_NA_RADIO_TX_M10			(15000000u)	// RF1A TX, -10dBm (PATABLE 0x27)
+#define SIM_NA_RADIO_TX_M20			(13000000u)	// RF1A TX, -20dBm (PATABLE 0x0F)
+#define SIM_NA_RADIO_WOR			(500u)		// RF1A SLEEP with RC oscillator (Wake-on-Radio)
+
+// Energy accounts
+typedef enum
+{
+	SIM_E_LPM = 0,
+	SIM_E_CPU,
+	SIM_E_LCD,
+	SIM_E_ADC,
+	SIM_E_FLASH,
+	SIM_E_BUZZER,
+	SIM_E_BACKLIGHT,
+	SIM_E_ACCEL,
+	SIM_E_PRESSURE,
+	SIM_E_RADIO,
+	SIM_E_COUNT
+} sim_energy_t;
+
+// Interrupt sources known to the simulator, lowest priority first
+typedef enum
+{
+	SIM_IRQ_RTC = 0,
+	SIM_IRQ_PORT2,
+	SIM_IRQ_CC1101,
+	SIM_IRQ_TIMER0_A1,
+	SIM_IRQ_TIMER0_A0,
+	SIM_IRQ_ADC12,
+	SIM_IRQ_USCI_A0,
+	SIM_IRQ_COUNT
+} sim_irq_t;
+
+// Scripted inputs
+#define SIM_BUTTON_DOWN				(0x01)
+#define SIM_BUTTON_NUM				(0x02)
+#define SIM_BUTTON_STAR				(0x04)
+#define SIM_BUTTON_BACKLIGHT		(0x08)
+#define SIM_BUTTON_UP				(0x10)
+#define SIM_AS_INT					(0x20)
+#define SIM_PS_INT					(0x40)
+
+// SimpliciTI logical channels (MRFI_NUM_LOGICAL_CHANS)
+#define SIM_AP_CHANNELS				(4u)
+
+typedef uint64_t sim_time_t;
+
+// Physical environment seen by the sensors
+struct sim_env
+{
+	double temperature;				// Die / sensor temperature (degC)
+	double battery;					// Supply voltage (V)
+	double pressure;				// Air pressure (Pa)
+	double accel[3];				// Acceleration X/Y/Z (g)
+	double turn_from[3];			// Reading before a turn of the wrist (g), turns into accel[]
+	sim_time_t turn_start;			// from turn_start to turn_end
+	sim_time_t turn_end;
+	double climb;					// Vertical speed (m/s), moves the pressure
+	double vaccel;					// Vertical acceleration (m/s2), adds to accel[] along gravity
+	double pressure_noise;			// Sensor noise (Pa rms)
+	double accel_noise;				// Sensor noise on every axis (g rms)
+	double cadence;					// Walking cadence (steps/min), 0 = not walking
+	double step_g;					// Acceleration of a step along gravity (g amplitude)
+	uint8_t ap;						// SimpliciTI access point in range
+	uint8_t ap_cmd;					// Sync command queued at the access point, 0 = none
+	uint8_t ap_loss;				// Packets lost between watch and access point (%)
+	int8_t ap_rssi;					// RSSI of access point frames at the watch (dBm)
+	uint8_t ap_busy[SIM_AP_CHANNELS];	// Time an interferer occupies each logical channel (%)
+};
+
+
+// *************************************************************************************************
+// Global Variable section
+extern sim_time_t sim_now;
+extern struct sim_env sim_env;
+extern volatile unsigned char sim_mem[0x1000];
+extern uint64_t sim_cycles;
+
+
+// *************************************************************************************************
+// Extern section
+
+// sim.c - core
+extern void sim_fail(const char * fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+extern void sim_finish(void) __attribute__((noreturn));
+extern void sim_irq_update(void);
+extern void sim_charge_cycles(uint32_t cycles);
+extern double sim_radio_charge(void);
+extern double sim_total_charge(void);
+extern uint64_t sim_wakeups(void);
+extern uint64_t sim_irq_calls(sim_irq_t irq);
+extern void sim_sleep_for(sim_time_t ticks);
+extern uint16_t sim_rd16(uint16_t addr);
+extern void sim_wr16(uint16_t addr, uint16_t value);
+#define sim_rd8(addr)				(sim_mem[(addr)])
+#define sim_wr8(addr, value)		(sim_mem[(addr)] = (value))
+
+// flash.c - flash write trapping
+extern uint8_t * sim_flash_map(void);
+extern void sim_flash_protect(void);
+
+// aes.c - AES-128 block cipher of the AES accelerator model
+extern void sim_aes_encrypt(const uint8_t * key, const uint8_t * in, uint8_t * out);
+
+// periph.c - peripheral models
+extern void periph_reset(void);
+extern void periph_access(uint16_t addr, uint8_t size);
+extern void periph_commit(uint16_t addr, uint8_t size);
+extern void periph_advance(sim_time_t from, sim_time_t to);
+extern sim_time_t periph_next_event(void);
+extern int periph_irq_pending(sim_irq_t irq);
+extern void periph_irq_accept(sim_irq_t irq);
+extern void periph_current(uint32_t * na);
+extern void periph_set_inputs(uint8_t mask, uint8_t value);
+extern void periph_ap_update(void);
+extern uint8_t periph_get_inputs(void);
+extern void periph_flash_write(uint16_t addr, uint16_t len, const uint8_t * before);
+extern int periph_trace_load(const char * path);
+extern void periph_trace_start(void);
+extern void periph_report(void);
+
+// scenario.c - scripted inputs
+extern int scenario_load(const char * path);
+extern sim_time_t scenario_next_event(void);
+extern void scenario_run(sim_time_t now);
+extern const char * scenario_name(void);
+
+// rf.c - radio stand-in
+extern void rf_report(void);
+
+#endif /*SIM_H_*/
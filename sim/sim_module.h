@@ -0,0 +1,28 @@
+// *************************************************************************************************
+// Host simulation: force-included into every firmware translation unit (-include sim_module.h).
+//
+// Emits an anchor function at the very start of the unit's code and registers it under the
+// unit's name (SIM_MODULE). The simulator maps the return address of each coverage callback to
+// the closest anchor below it to charge active cycles to the module that executed them.
+// *************************************************************************************************
+
+#ifndef SIM_MODULE_H_
+#define SIM_MODULE_H_
+
+#ifndef SIM_MODULE
+#define SIM_MODULE		"unknown"
+#endif
+
+extern void sim_register_module(const char * name, void (*anchor)(void));
+
+static void __attribute__((used, noinline)) sim_module_anchor(void)
+{
+	__asm__ volatile ("");
+}
+
+static void __attribute__((constructor, used)) sim_module_register(void)
+{
+	sim_register_module(SIM_MODULE, sim_module_anchor);
+}
+
+#endif /*SIM_MODULE_H_*/
@@ -28,6 +28,7 @@
 
 // *************************************************************************************************
 // Include section
+#include <string.h>
 #include "project.h"
 
 #include "bsp.h"
@@ -53,6 +54,15 @@
 // U16
 //typedef unsigned short u16;
 
+#ifdef CONFIG_LINK_CACHE
+// Link cache: join context of the last link and the address this device linked with
+typedef struct
+{
+	addr_t			edAddr;
+	ioctlJoinCtx_t	join;
+} linkCache_t;
+#endif
+
 // *************************************************************************************************
 // Prototypes section
 
@@ -63,6 +73,7 @@ extern uint8_t sInit_done;
 
 // SimpliciTI has no low power delay function, so we have to use ours
 extern void Timer0_A4_Delay(u16 ticks);
+extern u8 Timer0_A4_DelayUntil(u16 ticks, volatile u8 * flag, u8 mask);
 
 extern unsigned char simpliciti_payload_length;
 //extern txOpt_t  simpliciti_options;
@@ -73,6 +84,161 @@ extern unsigned char simpliciti_payload_length;
 // Global Variable section
 static linkID_t sLinkID1;
 
+// Output power level set in the radio
+static ioctlLevel_t sTxLevel;
+
+#ifdef CONFIG_FREQ_AGILITY
+// Logical channel the application wants the link on, SIMPLICITI_CHANNELS = stay
+static uint8_t sMoveTo = SIMPLICITI_CHANNELS;
+#endif
+
+
+// *************************************************************************************************
+// @fn          simpliciti_rx_callback
+// @brief       Called from the radio ISR for every received application frame. Flags the frame for
+//				code that sleeps in Timer0_A4_DelayUntil. Frame stays queued for SMPL_Receive.
+// @param       linkID_t lid		Link of received frame
+// @return      uint8_t				0 = keep frame
+// *************************************************************************************************
+static uint8_t simpliciti_rx_callback(linkID_t lid)
+{
+	setFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVED_DATA);
+	return (0);
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_link_event
+// @brief       Report a link event to the application and set the output power it asks for. Frames
+//				come with the RSSI and LQI SMPL_Receive saved for the link.
+// @param       uint8_t event		SIMPLICITI_LINK_START, _FRAME, _MISS, _IDLE
+// @return      none
+// *************************************************************************************************
+static void simpliciti_link_event(uint8_t event)
+{
+	ioctlRadioSiginfo_t sigInfo;
+	ioctlLevel_t level;
+
+	sigInfo.sigInfo.rssi = 0;
+	sigInfo.sigInfo.lqi  = 0;
+	if (event == SIMPLICITI_LINK_FRAME)
+	{
+		sigInfo.lid = sLinkID1;
+		SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SIGINFO, &sigInfo);
+	}
+
+	level = (ioctlLevel_t)(IOCTL_LEVEL_0 + simpliciti_link_quality_callback(event, sigInfo.sigInfo.rssi, sigInfo.sigInfo.lqi));
+	if (level != sTxLevel)
+	{
+		sTxLevel = level;
+		SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SETPWR, &sTxLevel);
+	}
+}
+
+
+#ifdef CONFIG_LINK_CACHE
+// *************************************************************************************************
+// @fn          simpliciti_link_resume
+// @brief       Fast reconnect. Restore the join context of the last link and send a single link 
+//				request. An access point that still holds the link answers it like a repeated request,
+//				no join and no one second wait before the link are needed. 
+// @param       addr_t * lAddr		Address of this device
+// @return      uint8_t				1 = Linked, 0 = Cache empty or no answer, join needed
+// *************************************************************************************************
+static uint8_t simpliciti_link_resume(addr_t * lAddr)
+{
+	linkCache_t cache;
+
+	if (!simpliciti_link_cache_load((unsigned char *)&cache, sizeof(cache))) return (0);
+
+	// Context belongs to another device address
+	if (memcmp(&cache.edAddr, lAddr, NET_ADDR_SIZE) != 0) return (0);
+
+	if (SMPL_InitNoJoin(simpliciti_rx_callback) != SMPL_SUCCESS) return (0);
+	if (SMPL_Ioctl(IOCTL_OBJ_JOINCTX, IOCTL_ACT_SET, &cache.join) != SMPL_SUCCESS) return (0);
+
+	sTxLevel = IOCTL_LEVEL_2;
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SETPWR, &sTxLevel);
+	simpliciti_link_event(SIMPLICITI_LINK_START);
+
+	return (SMPL_Link(&sLinkID1) == SMPL_SUCCESS);
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_link_save
+// @brief       Save the join context after a link with join. Flash is only written when it changed.
+// @param       addr_t * lAddr		Address of this device
+// @return      none
+// *************************************************************************************************
+static void simpliciti_link_save(addr_t * lAddr)
+{
+	linkCache_t cache, old;
+
+	memset(&cache, 0, sizeof(cache));
+	memcpy(&cache.edAddr, lAddr, NET_ADDR_SIZE);
+	if (SMPL_Ioctl(IOCTL_OBJ_JOINCTX, IOCTL_ACT_GET, &cache.join) != SMPL_SUCCESS) return;
+
+	if (simpliciti_link_cache_load((unsigned char *)&old, sizeof(old)) && 
+		memcmp(&old, &cache, sizeof(cache)) == 0) return;
+	simpliciti_link_cache_store((unsigned char *)&cache, sizeof(cache));
+}
+#endif
+
+
+// *************************************************************************************************
+// @fn          simpliciti_send
+// @brief       Send a frame on the link. With CONFIG_FREQ_AGILITY the clear channel assessments it 
+//				took go to the application, which may want the link on another channel.
+// @param       uint8_t * msg		Payload
+//				uint8_t len			Payload length
+// @return      none
+// *************************************************************************************************
+static void simpliciti_send(uint8_t * msg, uint8_t len)
+{
+#ifdef CONFIG_FREQ_AGILITY
+	ioctlRadioCca_t cca;
+	freqEntry_t chan;
+	uint8_t move;
+#endif
+
+	SMPL_SendOpt(sLinkID1, msg, len, SMPL_TXOPTION_NONE);
+#ifdef CONFIG_FREQ_AGILITY
+	SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_CCA, &cca);
+	SMPL_Ioctl(IOCTL_OBJ_FREQ, IOCTL_ACT_GET, &chan);
+	move = simpliciti_channel_callback(chan.logicalChan, cca.fails, cca.rssi);
+	if (move != chan.logicalChan) sMoveTo = move;
+#endif
+}
+
+
+#ifdef CONFIG_FREQ_AGILITY
+// *************************************************************************************************
+// @fn          simpliciti_channel_move
+// @brief       Ask the access point to move the link to the channel the application wants. Only
+//				between exchanges, the request waits for the answer. Without answer the link stays 
+//				where the access point is found, the next frames tell the application.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void simpliciti_channel_move(void)
+{
+	freqEntry_t chan;
+#ifdef CONFIG_LINK_CACHE
+	addr_t lAddr;
+#endif
+
+	if (sMoveTo >= SIMPLICITI_CHANNELS) return;
+	chan.logicalChan = sMoveTo;
+	sMoveTo = SIMPLICITI_CHANNELS;
+	if (SMPL_Ioctl(IOCTL_OBJ_FREQ, IOCTL_ACT_MOVE, &chan) != SMPL_SUCCESS) return;
+
+#ifdef CONFIG_LINK_CACHE
+	// Next link starts on the new channel
+	if (SMPL_Ioctl(IOCTL_OBJ_ADDR, IOCTL_ACT_GET, &lAddr) == SMPL_SUCCESS) simpliciti_link_save(&lAddr);
+#endif
+}
+#endif
 
 
 // *************************************************************************************************
@@ -87,7 +253,6 @@ unsigned char simpliciti_link(void)
   uint8_t timeout;
   addr_t lAddr;
   uint8_t i;
-  uint8_t pwr;
   uint8_t phase = 0;
   
   // Configure timer
@@ -102,32 +267,50 @@ unsigned char simpliciti_link(void)
   
   // Set flag	
   simpliciti_flag = SIMPLICITI_STATUS_LINKING;	
+#ifdef CONFIG_FREQ_AGILITY
+  sMoveTo = SIMPLICITI_CHANNELS;
+#endif
 	
   /* Keep trying to join (a side effect of successful initialization) until
    * successful. Toggle LEDS to indicate that joining has not occurred.
    */
   timeout = 0;
+#ifdef CONFIG_LINK_CACHE
+  // Try the last link first. Without answer SMPL_Init below only joins, the stack is set up.
+  if (simpliciti_link_resume(&lAddr))
+  {
+    simpliciti_flag = SIMPLICITI_STATUS_LINKED;
+    return (1);
+  }
+#endif
 #if 1
   while (1)
   {
     if (phase == 0) {
-        if(SMPL_SUCCESS == SMPL_Init(0)) {
+        if(SMPL_SUCCESS == SMPL_Init(simpliciti_rx_callback)) {
             phase = 1;
-            pwr = IOCTL_LEVEL_2;
-            SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SETPWR, &pwr);
+            
+            // Link at full output power, lower it when frames from the access point come in
+            sTxLevel = IOCTL_LEVEL_2;
+            SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SETPWR, &sTxLevel);
+            simpliciti_link_event(SIMPLICITI_LINK_START);
 
             /* Unconditional link to AP which is listening due to successful join. */
             timeout = 0;
         }
     } else {
-        if (SMPL_SUCCESS == SMPL_Link(&sLinkID1))
+        if (SMPL_SUCCESS == SMPL_Link(&sLinkID1)) {
+#ifdef CONFIG_LINK_CACHE
+            simpliciti_link_save(&lAddr);
+#endif
             break;
+        }
     }
             
     NWK_DELAY(1000);
 
     // Service watchdog
-	WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+	WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
     
     // Stop connecting after defined numbers of seconds (15)
     if (timeout++ > TIMEOUT) 
@@ -154,7 +337,7 @@ unsigned char simpliciti_link(void)
     NWK_DELAY(1000);
 
     // Service watchdog
-	WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+	WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
     
     // Stop connecting after defined numbers of seconds (15)
     if (timeout++ > TIMEOUT) 
@@ -175,8 +358,8 @@ unsigned char simpliciti_link(void)
   }
   
   // Set output power to +3.3dmB
-  pwr = IOCTL_LEVEL_2;
-  SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SETPWR, &pwr);
+  sTxLevel = IOCTL_LEVEL_2;
+  SMPL_Ioctl(IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SETPWR, &sTxLevel);
 
   /* Unconditional link to AP which is listening due to successful join. */
   timeout = 0;
@@ -185,7 +368,7 @@ unsigned char simpliciti_link(void)
     NWK_DELAY(1000);
     
     // Service watchdog
-	WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+	WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
 
     // Stop linking after timeout
     if (timeout++ > TIMEOUT) 
@@ -221,7 +404,7 @@ unsigned char simpliciti_link(void)
 // *************************************************************************************************
 void simpliciti_main_tx_only(void)
 {
-	uint8_t len, i;
+	uint8_t len, i, replied;
 	uint8_t ed_data[2];
 
 	while(1)
@@ -234,12 +417,15 @@ void simpliciti_main_tx_only(void)
 		   getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVE_DATA)) {
 
 			SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_AWAKE, 0);
+#ifdef CONFIG_FREQ_AGILITY
+			simpliciti_channel_move();
+#endif
 
 			// Send data when flag bit SIMPLICITI_TRIGGER_SEND_DATA is set
 			if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_SEND_DATA)) 
 			{
 			  // Acceleration / button events packets are 4 bytes long
-              SMPL_SendOpt(sLinkID1, simpliciti_data, simpliciti_payload_length, SMPL_TXOPTION_NONE);
+              simpliciti_send(simpliciti_data, simpliciti_payload_length);
 			  //SMPL_SendOpt(sLinkID1, simpliciti_data, simpliciti_payload_length, simpliciti_options);
               // reset options to default
               //simpliciti_options =  SMPL_TXOPTION_NONE;
@@ -263,8 +449,9 @@ void simpliciti_main_tx_only(void)
 				SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_RXON, 0);
 
 				// we try to receive 9 times by sending a R2R packet
+				replied = 0;
 				for (i = 0; i < 10; i++) {
-					SMPL_SendOpt(sLinkID1, ed_data, 2, SMPL_TXOPTION_NONE);
+					simpliciti_send(ed_data, 2);
 
 					//WDTCTL = WDTPW + WDTHOLD;
 
@@ -275,6 +462,9 @@ void simpliciti_main_tx_only(void)
 					{
 						if (len > 0)
 						{
+							replied = 1;
+							simpliciti_link_event(SIMPLICITI_LINK_FRAME);
+							
 							// Decode received data
 							if(simpliciti_get_rvc_callback(len))
 							{
@@ -286,6 +476,7 @@ void simpliciti_main_tx_only(void)
 					}
                     Timer0_A4_Delay(CONV_MS_TO_TICKS(500));
 				}
+				if (!replied) simpliciti_link_event(SIMPLICITI_LINK_MISS);
 			}
 
 			// Put radio back to SLEEP state
@@ -303,6 +494,112 @@ void simpliciti_main_tx_only(void)
 
 #endif
 
+// *************************************************************************************************
+// @fn          simpliciti_sync_bulk
+// @brief       Windowed memory download. Sends all unacknowledged frames of the window back to back,
+//				SMPL_SendOpt returns as soon as a frame is on air. Then sleeps until the host ACK 
+//				arrives and moves the window. Lost frames are repeated, received ones are not.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void simpliciti_sync_bulk(void)
+{
+	uint16_t base;
+	uint8_t acked, delta, retries, last, len, i;
+	uint8_t * ack;
+
+	base    = 0;
+	acked   = 0;
+	retries = 0;
+
+	// Listen for ACKs between the windows
+	SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_RXON, 0);
+
+	while (base < simpliciti_bulk_packets)
+	{
+		// Last frame to send in this window requests the ACK
+		last = 0;
+		for (i=0; i<BM_SYNC_BULK_WINDOW && base+i<simpliciti_bulk_packets; i++)
+		{
+			if (!(acked & (1 << i))) last = i;
+		}
+
+		clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVED_DATA);
+		for (i=0; i<=last; i++)
+		{
+			if (acked & (1 << i)) continue;
+			simpliciti_data[0] = SYNC_ED_TYPE_MEMORY_BULK;
+			simpliciti_sync_get_data_callback(base + i);
+			if (i == last) simpliciti_data[1] |= BM_SYNC_BULK_ACK_REQUEST;
+			simpliciti_send(simpliciti_data, BM_SYNC_BULK_DATA_LENGTH);
+		}
+
+		// Sleep until the ACK arrives
+		Timer0_A4_DelayUntil(CONV_MS_TO_TICKS(BM_SYNC_BULK_ACK_TIMEOUT), &simpliciti_flag, 
+							 SIMPLICITI_TRIGGER_RECEIVED_DATA | SIMPLICITI_TRIGGER_STOP);
+
+		// Move window to the first frame the host is missing. ACKs are read where the radio put them.
+		delta = 0xFF;
+		while (SMPL_ReceiveFrame(sLinkID1, &ack, &len) == SMPL_SUCCESS)
+		{
+			simpliciti_link_event(SIMPLICITI_LINK_FRAME);
+			if (len >= 3 && ack[0] == SYNC_AP_CMD_BULK_ACK)
+			{
+				delta = (ack[1] - base) & BM_SYNC_BULK_SEQ_MASK;
+				if (delta <= BM_SYNC_BULK_WINDOW)
+				{
+					base  += delta;
+					acked  = ack[2] << 1;
+				}
+			}
+			SMPL_ReleaseFrame(ack);
+		}
+		
+		// Service watchdog
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+
+		// Give up after some windows without valid ACK, or when stopped
+		if (delta > BM_SYNC_BULK_WINDOW) 
+		{
+			simpliciti_link_event(SIMPLICITI_LINK_MISS);
+			retries++;
+		}
+		else retries = 0;
+		if (retries > BM_SYNC_BULK_RETRIES || getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) break;
+	}
+	
+	simpliciti_bulk_packets = 0;
+}
+
+
+// *************************************************************************************************
+// @fn          simpliciti_sync_reply
+// @brief       Send the reply to a decoded host command: a windowed memory download or 
+//				simpliciti_reply_count packets of BM_SYNC_DATA_LENGTH bytes.
+// @param       none
+// @return      none
+// *************************************************************************************************
+static void simpliciti_sync_reply(void)
+{
+	uint8_t i;
+	
+	if (simpliciti_bulk_packets > 0)
+	{
+		simpliciti_sync_bulk();
+		return;
+	}
+
+	// Get reply data and send out reply packet burst (19 bytes each)
+	for (i=0; i<simpliciti_reply_count; i++)
+	{
+		NWK_DELAY(10);
+		simpliciti_sync_get_data_callback(i);
+		simpliciti_send(simpliciti_data, BM_SYNC_DATA_LENGTH);
+	}
+}
+
+
+#ifndef CONFIG_SYNC_WOR
 // *************************************************************************************************
 // @fn          simpliciti_main_sync
 // @brief       Send ready-to-receive packets in regular intervals. Listen shortly for host reply.
@@ -312,7 +609,7 @@ void simpliciti_main_tx_only(void)
 // *************************************************************************************************
 void simpliciti_main_sync(void)
 {
-	uint8_t len, i, contacted;
+	uint8_t len, contacted, received;
 	uint8_t ed_data[4];
 
 	contacted = 0;
@@ -326,7 +623,7 @@ void simpliciti_main_sync(void)
 			ed_data[0] = SIMPLICITI_SYNC_STARTED_EVENTS;
 			WATCH_ID(ed_data, 1);
 			ed_data[3] = 0x00;
-			SMPL_SendOpt(sLinkID1, ed_data, 4, SMPL_TXOPTION_NONE);
+			simpliciti_send(ed_data, 4);
 			SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SLEEP, 0);
 		}
 		// Sleep 0.5sec between ready-to-receive packets
@@ -335,48 +632,126 @@ void simpliciti_main_sync(void)
 		
 		// Get radio ready. Radio wakes up in IDLE state.
 		SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_AWAKE, 0);
+#ifdef CONFIG_FREQ_AGILITY
+		simpliciti_channel_move();
+#endif
 
 		// Send 2 byte long ready-to-receive packet to stimulate host reply
 		ed_data[0] = SYNC_ED_TYPE_R2R;
 		ed_data[1] = 0xCB;
-		SMPL_SendOpt(sLinkID1, ed_data, 2, SMPL_TXOPTION_NONE);
+		simpliciti_send(ed_data, 2);
 		
 		// Wait shortly for host reply
 		SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_RXON, 0);
 		NWK_DELAY(10);
 
 		// Check if a command packet was received
+		received = 0;
 		while (SMPL_Receive(sLinkID1, simpliciti_data, &len) == SMPL_SUCCESS)
 		{
 			// Decode received data
 			contacted = 1;
+			received  = 1;
+			simpliciti_link_event(SIMPLICITI_LINK_FRAME);
 			if (len > 0)
 			{
 				// Use callback function in application to decode data and react
 				simpliciti_sync_decode_ap_cmd_callback();
 				
-				// Get reply data and send out reply packet burst (19 bytes each)
-				for (i=0; i<simpliciti_reply_count; i++)
-				{
-					NWK_DELAY(10);
-					simpliciti_sync_get_data_callback(i);
-					SMPL_SendOpt(sLinkID1, simpliciti_data, BM_SYNC_DATA_LENGTH, SMPL_TXOPTION_NONE);
-				}
+				// Send out reply packets
+				simpliciti_sync_reply();
 			}
   		}
+		if (!received) simpliciti_link_event(SIMPLICITI_LINK_IDLE);
 
 		// Put radio back to sleep  		
   		SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SLEEP, 0);
   		
   		// Service watchdog
-		WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK + WDTCNTCL;
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
+  		
+		// Exit when flag bit SIMPLICITI_TRIGGER_STOP is set
+		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) 
+		{
+			// Clean up SimpliciTI stack to enable restarting
+			sInit_done = 0;
+			break;
+		}
+	}
+}
+#else
+
+// *************************************************************************************************
+// @fn          simpliciti_main_sync
+// @brief       Wake-on-Radio sync. Radio sleeps and sniffs for a carrier once per Event0 period,
+//				the access point wakes the watch with a packet train longer than that period.
+//				Decode received host command and trigger action. 
+// @param       none
+// @return      none
+// *************************************************************************************************
+void simpliciti_main_sync(void)
+{
+	uint8_t len, received;
+	uint8_t ed_data[4];
+
+	// Send a notification that we are in sync mode
+	SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_AWAKE, 0);
+	ed_data[0] = SIMPLICITI_SYNC_STARTED_EVENTS;
+	WATCH_ID(ed_data, 1);
+	ed_data[3] = 0x00;
+	simpliciti_send(ed_data, 4);
+
+	// Radio sleeps and listens on its own from now on
+	SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_WOR, 0);
+
+	while(1)
+	{
+		// Sleep until a frame arrives - the radio ISR ends LPM and simpliciti_rx_callback sets the 
+		// flag. Button STOP also ends the sleep, the timeout only services the watchdog.
+		Timer0_A4_DelayUntil(CONV_MS_TO_TICKS(BM_SYNC_WOR_TIMEOUT), &simpliciti_flag, 
+							 SIMPLICITI_TRIGGER_RECEIVED_DATA | SIMPLICITI_TRIGGER_STOP);
+		
+		// Frames received from now on end the next sleep at once
+		clearFlag(simpliciti_flag, SIMPLICITI_TRIGGER_RECEIVED_DATA);
+		
+		// Check if a command packet was received
+		received = 0;
+		while (SMPL_Receive(sLinkID1, simpliciti_data, &len) == SMPL_SUCCESS)
+		{
+			received = 1;
+			simpliciti_link_event(SIMPLICITI_LINK_FRAME);
+			if (len > 0)
+			{
+				// Use callback function in application to decode data and react
+				simpliciti_sync_decode_ap_cmd_callback();
+				
+				// Send out reply packets
+				simpliciti_sync_reply();
+			}
+  		}
+
+		// Replies leave the radio in RX - go back to sniffing
+		if (received) 
+		{
+#ifdef CONFIG_FREQ_AGILITY
+			simpliciti_channel_move();
+#endif
+			SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_WOR, 0);
+		}
+  		
+  		// Service watchdog
+		WDTCTL = WDTPW + WDT_INTERVAL + WDTSSEL__ACLK + WDTCNTCL;
   		
 		// Exit when flag bit SIMPLICITI_TRIGGER_STOP is set
 		if (getFlag(simpliciti_flag, SIMPLICITI_TRIGGER_STOP)) 
 		{
+			// Put radio back to sleep, this ends Wake-on-Radio mode
+			SMPL_Ioctl( IOCTL_OBJ_RADIO, IOCTL_ACT_RADIO_SLEEP, 0);
+
 			// Clean up SimpliciTI stack to enable restarting
 			sInit_done = 0;
 			break;
 		}
 	}
 }
+#endif
@@ -87,4 +87,9 @@
  */
 /* #define RX_POLLS */
 
+/* [BM] Move the link to the least busy logical channel, see CONFIG_FREQ_AGILITY */
+#ifdef CONFIG_FREQ_AGILITY
+#define FREQUENCY_AGILITY
+#endif
+
 #endif
\ No newline at end of file
@@ -5,13 +5,20 @@
 #define MAX_HOPS  3 
 #define MAX_HOPS_FROM_AP  1 
 #define MAX_NWK_PAYLOAD  9 
-#define MAX_APP_PAYLOAD  19 
 #define DEFAULT_LINK_TOKEN  0x01020304 
 #define DEFAULT_JOIN_TOKEN  0x05060708 
 #define APP_AUTO_ACK
 // if a app needs EXTENDED_API it should enable it here 
 #define xEXTENDED_API 
 #define xSMPL_SECURE 
+#define xSMPL_SECURE_XTEA 
+// [BM] 64 byte radio FIFO - length (1) - addresses (8) - NWK header (3, 6 with SMPL_SECURE)
+// - appended status (2), defined after the security option it depends on
+#ifdef SMPL_SECURE
+#define MAX_APP_PAYLOAD  47 
+#else
+#define MAX_APP_PAYLOAD  50 
+#endif
 #define xNVOBJECT_SUPPORT 
 #define SW_TIMER
 
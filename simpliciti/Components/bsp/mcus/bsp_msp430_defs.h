@@ -141,8 +141,9 @@
   #define __bsp_DISABLE_INTERRUPTS__()      dint()
   #define __bsp_INTERRUPTS_ARE_ENABLED__()  (READ_SR&0x0008)
   
-  #define __bsp_GET_ISTATE__()              (READ_SR&0x0008)
-  #define __bsp_RESTORE_ISTATE__(x)         __asm__("bis %0,r2" : : "ir" ((uint16_t) x))
+  /* [BM] same as READ_SR&GIE / bis x,r2, implemented in gcc/intrinsics.c */
+  #define __bsp_GET_ISTATE__()              __get_interrupt_state()
+  #define __bsp_RESTORE_ISTATE__(x)         __set_interrupt_state(x)
   #define __bsp_QUOTED_PRAGMA__(x)          _Pragma(#x)
 #endif
 
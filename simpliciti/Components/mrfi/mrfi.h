@@ -158,6 +158,7 @@ void    MRFI_Init(void);
 uint8_t MRFI_Transmit(mrfiPacket_t *, uint8_t);
 void    MRFI_Receive(mrfiPacket_t *);
 void    MRFI_RxCompleteISR(void); /* populated by code using MRFI */
+mrfiPacket_t *MRFI_RxBufferISR(void); /* [BM] populated by code using MRFI */
 uint8_t MRFI_GetRadioState(void);
 void    MRFI_RxOn(void);
 void    MRFI_RxIdle(void);
@@ -173,6 +174,12 @@ void    MRFI_DelayMs(uint16_t);
 void    MRFI_ReplyDelay(void);
 void    MRFI_PostKillSem(void);
 void    MRFI_SetRFPwr(uint8_t);
+#ifdef CONFIG_SYNC_WOR
+void    MRFI_WorOn(void);
+#endif
+#ifdef FREQUENCY_AGILITY
+uint8_t MRFI_CcaFailures(int8_t *); /* [BM] */
+#endif
 
 /* ------------------------------------------------------------------------------------------------
  *                                       Global Constants
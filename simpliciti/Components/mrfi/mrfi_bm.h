@@ -0,0 +1,38 @@
+/* ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+ *   MRFI (Minimal RF Interface)
+ *   [BM] Hooks of the watch firmware used by the radio: low power delays on Timer0_A4 and
+ *   the flag the user cancels a link with.
+ * ~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=~=
+ */
+
+#ifndef MRFI_BM_H
+#define MRFI_BM_H
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "project.h"
+#include "timer.h"
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+/* Link cancel flag: MRFI delays end early once the mask bit is set (SIMPLICITI_TRIGGER_STOP) */
+#define MRFI_CANCEL_FLAG                 (&simpliciti_flag)
+#define MRFI_CANCEL_MASK                 (BIT5)
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Externs
+ * ------------------------------------------------------------------------------------------------
+ */
+extern unsigned char simpliciti_flag;
+
+
+/**************************************************************************************************
+ */
+#endif
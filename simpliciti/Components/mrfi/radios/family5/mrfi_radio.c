@@ -48,6 +48,7 @@
 #include "mrfi_defs.h"
 #include "mrfi_radio_interface.h"
 #include "smartrf/CC430/smartrf_CC430.h"
+#include "mrfi_bm.h"
 
 /* ------------------------------------------------------------------------------------------------
  *                                    Global Constants
@@ -107,6 +108,26 @@ BSP_STATIC_ASSERT(MRFI_ADDR_SIZE == ((sizeof(mrfiBroadcastAddr)/sizeof(mrfiBroad
  */
 #define MRFI_SETTING_MCSM1      0x3C
 
+/* Main Radio Control State Machine control configuration - power up value:
+ * - No RX timeout, sync word search until end of packet
+ */
+#define MRFI_SETTING_MCSM2      0x07
+
+#ifdef CONFIG_SYNC_WOR
+/* Wake-on-Radio configuration:
+ * - Event0 = 750 / fXOSC * WOREVT = 500ms with 26MHz crystal and WOR_RES = 0
+ * - RX_TIME_RSSI: go back to SLEEP as soon as there is no carrier, otherwise
+ *   search for sync word during 0.45% of Event0 (RX_TIME = 3, 2.25ms)
+ * - RC oscillator on and calibrated, EVENT1 = 48 RC periods (1.4ms) for XOSC start-up
+ */
+#define MRFI_WOR_SETTING_MCSM2      (BV(4) | 0x03)
+#define MRFI_WOR_SETTING_WOREVT     17333
+#define MRFI_WOR_SETTING_WORCTRL    0x78
+
+/* WORCTRL power up value: RC oscillator off */
+#define MRFI_SETTING_WORCTRL        0xF8
+#endif
+
 /*
  *  Packet Length - Setting for maximum allowed packet length.
  *  The PKTLEN setting does not include the length field but maximum frame size does.
@@ -146,6 +167,12 @@ BSP_STATIC_ASSERT(MRFI_ADDR_SIZE == ((sizeof(mrfiBroadcastAddr)/sizeof(mrfiBroad
 #define APP_USEC_VALUE    1000
 #endif
 
+/* [BM] Millisecond delays sleep in LPM3 on Timer0_A4 (32768Hz ticks). One call
+ * covers at most 1s to keep the tick count within 16 bits.
+ */
+#define MRFI_LPM_DELAY_MAX_MS       1000
+#define MRFI_MS_TO_TICKS(ms)        (((ms) << 5) + (((ms) * 3) >> 2))
+
 /* ------------------------------------------------------------------------------------------------
  *                                           Macros
  * ------------------------------------------------------------------------------------------------
@@ -338,6 +365,9 @@ static void Mrfi_SyncPinRxIsr(void);
 static void Mrfi_RxModeOn(void);
 static void Mrfi_RandomBackoffDelay(void);
 static void Mrfi_RxModeOff(void);
+#ifdef CONFIG_SYNC_WOR
+static void Mrfi_WorModeOn(void);
+#endif
 static void Mrfi_DelayUsec(uint16_t howLong);
 static void Mrfi_DelayUsecSem(uint16_t howLong);
 static int8_t Mrfi_CalculateRssi(uint8_t rawValue);
@@ -350,8 +380,19 @@ static uint8_t Mrfi_RxAddrIsFiltered(uint8_t * pAddr);
  */
 static uint8_t mrfiRadioState  = MRFI_RADIO_STATE_UNKNOWN;
 static mrfiPacket_t mrfiIncomingPacket;
+/* [BM] Last received packet: the buffer supplied by MRFI_RxBufferISR() or mrfiIncomingPacket */
+static mrfiPacket_t * mrfiRxPacket = &mrfiIncomingPacket;
 static uint8_t mrfiRndSeed = 0;
 
+#ifdef CONFIG_SYNC_WOR
+static uint8_t mrfiWorOn = 0;
+#endif
+#ifdef FREQUENCY_AGILITY
+/* [BM] Clear channel assessments of the last CCA transmit: failures and RSSI of the last one */
+static uint8_t mrfiCcaFails = 0;
+static int8_t  mrfiCcaRssi  = 0;
+#endif
+
 /* reply delay support */
 static volatile uint8_t  sKillSem = 0;
 static volatile uint8_t  sReplyDelayContext = 0;
@@ -650,6 +691,9 @@ uint8_t MRFI_Transmit(mrfiPacket_t * pPacket, uint8_t txType)
 
     /* set number of CCA retries */
     ccaRetries = MRFI_CCA_RETRIES;
+#ifdef FREQUENCY_AGILITY
+    mrfiCcaFails = 0;
+#endif
 
 
     /* ===============================================================================
@@ -721,6 +765,12 @@ uint8_t MRFI_Transmit(mrfiPacket_t * pPacket, uint8_t txType)
          *   ----------------------------------
          */
 
+#ifdef FREQUENCY_AGILITY
+        /* [BM] Still in RX: note how strong whatever occupies the channel is */
+        mrfiCcaFails++;
+        mrfiCcaRssi = Mrfi_CalculateRssi(MRFI_RADIO_REG_READ( RSSI ));
+#endif
+
         /* Turn off radio and save some power during backoff */
 
         /* NOTE: Can't use Mrfi_RxModeOff() - since it tries to update the
@@ -778,6 +828,8 @@ uint8_t MRFI_Transmit(mrfiPacket_t * pPacket, uint8_t txType)
  * @brief       Copies last packet received to the location specified.
  *              This function is meant to be called after the ISR informs
  *              higher level code that there is a newly received packet.
+ *              [BM] Nothing is copied if the packet was received into the
+ *              location specified (see MRFI_RxBufferISR).
  *
  * @param       pPacket - pointer to location of where to copy received packet
  *
@@ -786,7 +838,10 @@ uint8_t MRFI_Transmit(mrfiPacket_t * pPacket, uint8_t txType)
  */
 void MRFI_Receive(mrfiPacket_t * pPacket)
 {
-  *pPacket = mrfiIncomingPacket;
+  if (pPacket != mrfiRxPacket)
+  {
+    *pPacket = *mrfiRxPacket;
+  }
 }
 
 /**************************************************************************************************
@@ -807,6 +862,7 @@ static void Mrfi_SyncPinRxIsr(void)
 {
   uint8_t frameLen = 0x00;
   uint8_t rxBytes;
+  mrfiPacket_t * pPacket;
 
   /* We should receive this interrupt only in RX state
    * Should never receive it if RX was turned On only for
@@ -923,17 +979,28 @@ static void Mrfi_SyncPinRxIsr(void)
        *   ------------
        */
 
-      /* clean out buffer to help protect against spurious frames */
-      memset(mrfiIncomingPacket.frame, 0x00, sizeof(mrfiIncomingPacket.frame));
+      /* [BM] Read straight into the buffer of the code using MRFI if it has
+       * one free, so it need not copy the packet. Otherwise use our own.
+       */
+      pPacket = MRFI_RxBufferISR();
+      if (!pPacket)
+      {
+        pPacket = &mrfiIncomingPacket;
+      }
+      mrfiRxPacket = pPacket;
 
       /* set length field */
-      mrfiIncomingPacket.frame[MRFI_LENGTH_FIELD_OFS] = frameLen;
+      pPacket->frame[MRFI_LENGTH_FIELD_OFS] = frameLen;
 
       /* get packet from FIFO */
-      MRFI_RADIO_READ_RX_FIFO(&(mrfiIncomingPacket.frame[MRFI_FRAME_BODY_OFS]), frameLen);
+      MRFI_RADIO_READ_RX_FIFO(&(pPacket->frame[MRFI_FRAME_BODY_OFS]), frameLen);
+
+      /* clean out the rest of the buffer to help protect against spurious frames */
+      memset(&(pPacket->frame[MRFI_FRAME_BODY_OFS + frameLen]), 0x00,
+             sizeof(pPacket->frame) - MRFI_FRAME_BODY_OFS - frameLen);
 
       /* get receive metrics from FIFO */
-      MRFI_RADIO_READ_RX_FIFO(&(mrfiIncomingPacket.rxMetrics[0]), MRFI_RX_METRICS_SIZE);
+      MRFI_RADIO_READ_RX_FIFO(&(pPacket->rxMetrics[0]), MRFI_RX_METRICS_SIZE);
 
 
       /* ------------------------------------------------------------------
@@ -951,7 +1018,7 @@ static void Mrfi_SyncPinRxIsr(void)
        */
 
       /* determine if CRC failed */
-      if (!(mrfiIncomingPacket.rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] & MRFI_RX_METRICS_CRC_OK_MASK))
+      if (!(pPacket->rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] & MRFI_RX_METRICS_CRC_OK_MASK))
       {
         /* CRC failed - do nothing, skip to end */
         crcFail++;
@@ -967,7 +1034,7 @@ static void Mrfi_SyncPinRxIsr(void)
          */
 
         /* if address is not filtered, receive is successful */
-        if (!Mrfi_RxAddrIsFiltered(MRFI_P_DST_ADDR(&mrfiIncomingPacket)))
+        if (!Mrfi_RxAddrIsFiltered(MRFI_P_DST_ADDR(pPacket)))
         {
           {
             /* ------------------------------------------------------------------
@@ -976,12 +1043,12 @@ static void Mrfi_SyncPinRxIsr(void)
              */
 
             /* Convert the raw RSSI value and do offset compensation for this radio */
-            mrfiIncomingPacket.rxMetrics[MRFI_RX_METRICS_RSSI_OFS] =
-                Mrfi_CalculateRssi(mrfiIncomingPacket.rxMetrics[MRFI_RX_METRICS_RSSI_OFS]);
+            pPacket->rxMetrics[MRFI_RX_METRICS_RSSI_OFS] =
+                Mrfi_CalculateRssi(pPacket->rxMetrics[MRFI_RX_METRICS_RSSI_OFS]);
 
             /* Remove the CRC valid bit from the LQI byte */
-            mrfiIncomingPacket.rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] =
-              (mrfiIncomingPacket.rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] & MRFI_RX_METRICS_LQI_MASK);
+            pPacket->rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] =
+              (pPacket->rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS] & MRFI_RX_METRICS_LQI_MASK);
 
 
             /* call external, higher level "receive complete" processing routine */
@@ -992,6 +1059,16 @@ static void Mrfi_SyncPinRxIsr(void)
     }
   }
 
+#ifdef CONFIG_SYNC_WOR
+  /* Radio stays in RX after a packet (MCSM1). In Wake-on-Radio mode go back
+   * to SLEEP and sniffing, whatever the packet was.
+   */
+  if (mrfiWorOn)
+  {
+    Mrfi_WorModeOn();
+  }
+#endif
+
   /* ------------------------------------------------------------------
    *    End of function
    *   -------------------
@@ -1067,8 +1144,84 @@ static void Mrfi_RxModeOff(void)
 
   /* clear receive interrupt */
   MRFI_CLEAR_SYNC_PIN_INT_FLAG();
+
+#ifdef CONFIG_SYNC_WOR
+  /* leave Wake-on-Radio mode: no RX timeout, RC oscillator off */
+  if (mrfiWorOn)
+  {
+    mrfiWorOn = 0;
+    MRFI_RADIO_REG_WRITE(MCSM2, MRFI_SETTING_MCSM2);
+    MRFI_RADIO_REG_WRITE(WORCTRL, MRFI_SETTING_WORCTRL);
+  }
+#endif
 }
 
+#ifdef CONFIG_SYNC_WOR
+/**************************************************************************************************
+ * @fn          Mrfi_WorModeOn
+ *
+ * @brief       Start the automatic RX polling sequence. The radio sleeps and wakes up once
+ *              per Event0 period to sniff for a carrier.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void Mrfi_WorModeOn(void)
+{
+  /* SWOR must be issued from IDLE state */
+  MRFI_STROBE_IDLE_AND_WAIT();
+
+  /* flush the receive FIFO of any residual data */
+  MRFI_STROBE( SFRX );
+
+  /* clear any residual receive interrupt */
+  MRFI_CLEAR_SYNC_PIN_INT_FLAG();
+
+  /* send strobe to enter Wake-on-Radio mode */
+  MRFI_STROBE( SWOR );
+
+  /* enable receive interrupts */
+  MRFI_ENABLE_SYNC_PIN_INT();
+}
+
+/**************************************************************************************************
+ * @fn          MRFI_WorOn
+ *
+ * @brief       Put radio to SLEEP with automatic preamble sniffing (Wake-on-Radio). A received
+ *              packet is handled like in RX state. Any call that takes the radio out of RX
+ *              (MRFI_RxIdle, MRFI_Sleep, MRFI_Transmit) ends Wake-on-Radio mode.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MRFI_WorOn(void)
+{
+  bspIState_t s;
+
+  BSP_ENTER_CRITICAL_SECTION(s);
+
+  /* configure radio in IDLE state */
+  MRFI_WakeUp();
+  MRFI_RxIdle();
+
+  MRFI_RADIO_REG_WRITE(MCSM2, MRFI_WOR_SETTING_MCSM2);
+  MRFI_RADIO_REG_WRITE(WOREVT1, MRFI_WOR_SETTING_WOREVT >> 8);
+  MRFI_RADIO_REG_WRITE(WOREVT0, MRFI_WOR_SETTING_WOREVT & 0xFF);
+  MRFI_RADIO_REG_WRITE(WORCTRL, MRFI_WOR_SETTING_WORCTRL);
+
+  /* received packets are processed like in RX state */
+  mrfiWorOn = 1;
+  mrfiRadioState = MRFI_RADIO_STATE_RX;
+  Mrfi_WorModeOn();
+
+  BSP_EXIT_CRITICAL_SECTION(s);
+}
+#endif
+
 
 /**************************************************************************************************
  * @fn          MRFI_RxIdle
@@ -1286,6 +1439,26 @@ int8_t MRFI_Rssi(void)
   return( Mrfi_CalculateRssi(regValue) );
 }
 
+#ifdef FREQUENCY_AGILITY
+/**************************************************************************************************
+ * @fn          MRFI_CcaFailures
+ *
+ * @brief       [BM] Failed clear channel assessments of the last CCA transmit. Feeds the channel
+ *              statistics of Frequency Agility.
+ *
+ * @param       pRssi - receives the RSSI of the last failed assessment in dBm, only valid if
+ *                      an assessment failed
+ *
+ * @return      Number of failed assessments. MRFI_CCA_RETRIES+1 means the frame was not sent.
+ **************************************************************************************************
+ */
+uint8_t MRFI_CcaFailures(int8_t * pRssi)
+{
+  *pRssi = mrfiCcaRssi;
+  return( mrfiCcaFails );
+}
+#endif
+
 
 /**************************************************************************************************
  * @fn          Mrfi_CalculateRssi
@@ -1449,10 +1622,28 @@ static void Mrfi_DelayUsecSem(uint16_t howLong)
  */
 void MRFI_DelayMs(uint16_t milliseconds)
 {
+  uint16_t chunk;
+
+  /* [BM] Spin only where we cannot sleep: interrupt context or critical section */
+  if (!BSP_INTERRUPTS_ARE_ENABLED())
+  {
+    while (milliseconds)
+    {
+      Mrfi_DelayUsec( APP_USEC_VALUE );
+      milliseconds--;
+    }
+    return;
+  }
+
+  /* [BM] Sleep in LPM3, cut short when the user cancels the link */
   while (milliseconds)
   {
-    Mrfi_DelayUsec( APP_USEC_VALUE );
-    milliseconds--;
+    chunk = (milliseconds > MRFI_LPM_DELAY_MAX_MS) ? MRFI_LPM_DELAY_MAX_MS : milliseconds;
+    if (Timer0_A4_DelayUntil(MRFI_MS_TO_TICKS(chunk), MRFI_CANCEL_FLAG, MRFI_CANCEL_MASK))
+    {
+      break;
+    }
+    milliseconds -= chunk;
   }
 }
 
@@ -1478,14 +1669,22 @@ void MRFI_ReplyDelay(void)
   sReplyDelayContext = 1;
   BSP_EXIT_CRITICAL_SECTION(s);
 
-  while (milliseconds)
+  if (!BSP_INTERRUPTS_ARE_ENABLED())
   {
-    Mrfi_DelayUsecSem( APP_USEC_VALUE );
-    if (sKillSem)
+    while (milliseconds)
     {
-      break;
+      Mrfi_DelayUsecSem( APP_USEC_VALUE );
+      if (sKillSem)
+      {
+        break;
+      }
+      milliseconds--;
     }
-    milliseconds--;
+  }
+  else if (milliseconds)
+  {
+    /* [BM] Sleep in LPM3, the radio ISR ends LPM after posting the kill semaphore */
+    Timer0_A4_DelayUntil(MRFI_MS_TO_TICKS(milliseconds), &sKillSem, 1);
   }
 
   BSP_ENTER_CRITICAL_SECTION(s);
@@ -327,6 +327,10 @@ static void initializeConnection(connInfo_t *pCInfo)
 void nwk_freeConnection(connInfo_t *pCInfo)
 {
 #if NUM_CONNECTIONS > 0
+#if defined(END_DEVICE)
+  /* [BM] drop the frames still queued for the connection */
+  nwk_QflushRx(&pCInfo->rxFifo);
+#endif
   pCInfo->connState = CONNSTATE_FREE;
 #endif
 }
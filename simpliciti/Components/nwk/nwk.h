@@ -98,6 +98,9 @@ typedef struct
            uint32_t    connTxCTR;
            uint32_t    connRxCTR;
 #endif
+#if defined(END_DEVICE)
+           rxFifo_t    rxFifo;      /* [BM] received frames of this connection */
+#endif
 } connInfo_t;
 
 /****************************************************************************************
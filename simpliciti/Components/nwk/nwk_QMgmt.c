@@ -71,10 +71,22 @@ static frameInfo_t  *sInFrameQ = NULL;
 
 static frameInfo_t   sOutFrameQ[SIZE_OUTFRAME_Q];
 
+#if defined(END_DEVICE)
+/* [BM] receive FIFOs of the NWK application ports, the connections hold their
+ * own. Arrival sequence of the last frame queued.
+ */
+static rxFifo_t      sNwkRxFifo[SMPL_PORT_MGMT];
+static uint8_t       sRxSeq;
+#endif
+
 /******************************************************************************
  * LOCAL FUNCTIONS
  */
 
+#if defined(END_DEVICE)
+static void rxFifoRemoveHead(rxFifo_t *);
+#endif
+
 /******************************************************************************
  * GLOBAL VARIABLES
  */
@@ -100,6 +112,10 @@ void nwk_QInit(void)
   memset(sInFrameQ, 0, sizeof(sInFrameQ));
 #endif  // SIZE_INFRAME_Q > 0
   memset(sOutFrameQ, 0, sizeof(sOutFrameQ));
+#if defined(END_DEVICE)
+  memset(sNwkRxFifo, 0, sizeof(sNwkRxFifo));
+  sRxSeq = 0;
+#endif
 }
  
 /******************************************************************************
@@ -137,6 +153,32 @@ frameInfo_t *nwk_QfindSlot(uint8_t which)
     num  = SIZE_OUTFRAME_Q;
   }
 
+#if defined(END_DEVICE)
+  /* [BM] Frames are queued in arrival order, so the oldest one heads its
+   * receive FIFO. Frames in transition belong to the reader.
+   */
+  if (INQ == which)
+  {
+    for (i=0; i<num; ++i, ++pFI)
+    {
+      if (FI_AVAILABLE == pFI->fi_usage)
+      {
+        return pFI;
+      }
+      if ((FI_INUSE_UNTIL_DEL == pFI->fi_usage) &&
+          (!oldest || ((int8_t)(pFI->orderStamp - oldest->orderStamp) < 0)))
+      {
+        oldest = pFI;
+      }
+    }
+    if (oldest)
+    {
+      rxFifoRemoveHead(oldest->fifo);
+    }
+    return oldest;
+  }
+#endif
+
   orderTest = num + 1;
 
   for (i=0; i<num; ++i, ++pFI)
@@ -200,6 +242,220 @@ frameInfo_t *nwk_QfindSlot(uint8_t which)
   return newFI;
 }
 
+/******************************************************************************
+ * @fn          nwk_QfindFreeRxSlot
+ *
+ * @brief       [BM] Finds a free input queue slot the radio can read the next
+ *              frame into directly. Unlike nwk_QfindSlot() no frame is cast
+ *              out: a frame that fails the CRC or address check must not
+ *              destroy a queued one. With the queue full the caller receives
+ *              into its own buffer and uses nwk_QfindSlot() afterwards.
+ *
+ *              This routine is running in interrupt context.
+ *
+ * input parameters
+ *
+ * output parameters
+ *
+ * @return      Pointer to a free slot, 0 if the queue is full
+ */
+frameInfo_t *nwk_QfindFreeRxSlot(void)
+{
+#if SIZE_INFRAME_Q > 0
+  frameInfo_t *pFI = sInFrameQ;
+  uint8_t      i;
+#if defined(END_DEVICE)
+
+  /* arrival sequence is stamped when the frame is queued */
+  for (i=0; i<SIZE_INFRAME_Q; ++i, ++pFI)
+  {
+    if (FI_AVAILABLE == pFI->fi_usage)
+    {
+      return pFI;
+    }
+  }
+
+  return (frameInfo_t *)0;
+#else
+  frameInfo_t *newFI = 0;
+  uint8_t      newOrder = 0;
+
+  for (i=0; i<SIZE_INFRAME_Q; ++i, ++pFI)
+  {
+    if (pFI->fi_usage != FI_AVAILABLE)
+    {
+      newOrder++;
+    }
+    else
+    {
+      newFI = pFI;
+    }
+  }
+
+  if (newFI)
+  {
+    /* same age value nwk_QfindSlot() gives an available slot */
+    newFI->orderStamp = ++newOrder;
+  }
+
+  return newFI;
+#endif  /* END_DEVICE */
+#else
+  return (frameInfo_t *)0;
+#endif  /* SIZE_INFRAME_Q > 0 */
+}
+
+#if defined(END_DEVICE)
+/******************************************************************************
+ * @fn          nwk_QrxFifo
+ *
+ * @brief       [BM] Receive FIFO of a receive context: the NWK application
+ *              port or the connection of the Link ID.
+ *
+ * input parameters
+ * @param   rcv   - receive context
+ *
+ * output parameters
+ *
+ * @return      Pointer to the FIFO, 0 if the context has none
+ */
+rxFifo_t *nwk_QrxFifo(rcvContext_t *rcv)
+{
+  connInfo_t *pCInfo;
+
+  if (RCV_NWK_PORT == rcv->type)
+  {
+    if (rcv->t.port && (rcv->t.port <= SMPL_PORT_MGMT))
+    {
+      return &sNwkRxFifo[rcv->t.port-1];
+    }
+  }
+  else if (RCV_APP_LID == rcv->type)
+  {
+    if ((pCInfo=nwk_getConnInfo(rcv->t.lid)))
+    {
+      return &pCInfo->rxFifo;
+    }
+  }
+
+  return (rxFifo_t *)0;
+}
+
+/******************************************************************************
+ * @fn          nwk_QputRx
+ *
+ * @brief       [BM] Keep a received frame for retrieval: append it to the
+ *              receive FIFO of its port or connection.
+ *
+ *              This routine is running in interrupt context.
+ *
+ * input parameters
+ * @param   pFI    - input queue frame dispatched to the FIFO
+ * @param   fifo   - receive FIFO
+ *
+ * output parameters
+ *
+ * @return      void
+ */
+void nwk_QputRx(frameInfo_t *pFI, rxFifo_t *fifo)
+{
+  uint8_t slot = (pFI - sInFrameQ) + 1;
+
+  pFI->fi_usage   = FI_INUSE_UNTIL_DEL;
+  pFI->orderStamp = ++sRxSeq;
+  pFI->fifo       = fifo;
+  pFI->next       = 0;
+
+  if (fifo->tail)
+  {
+    sInFrameQ[fifo->tail-1].next = slot;
+  }
+  else
+  {
+    fifo->head = slot;
+  }
+  fifo->tail = slot;
+}
+
+/******************************************************************************
+ * @fn          nwk_QgetRx
+ *
+ * @brief       [BM] Take the oldest frame out of a receive FIFO. The frame is
+ *              left in transition: it belongs to the caller until it is freed
+ *              (FI_AVAILABLE), the Rx ISR does not cast it out.
+ *
+ * input parameters
+ * @param   fifo   - receive FIFO
+ *
+ * output parameters
+ *
+ * @return      Pointer to the frame, 0 if the FIFO is empty
+ */
+frameInfo_t *nwk_QgetRx(rxFifo_t *fifo)
+{
+  frameInfo_t *pFI = 0;
+  bspIState_t  intState;
+
+  BSP_ENTER_CRITICAL_SECTION(intState);
+  if (fifo->head)
+  {
+    pFI = &sInFrameQ[fifo->head-1];
+    rxFifoRemoveHead(fifo);
+    pFI->fi_usage = FI_INUSE_TRANSITION;
+  }
+  BSP_EXIT_CRITICAL_SECTION(intState);
+
+  return pFI;
+}
+
+/******************************************************************************
+ * @fn          nwk_QflushRx
+ *
+ * @brief       [BM] Free all frames of a receive FIFO, the connection is gone.
+ *
+ * input parameters
+ * @param   fifo   - receive FIFO
+ *
+ * output parameters
+ *
+ * @return      void
+ */
+void nwk_QflushRx(rxFifo_t *fifo)
+{
+  bspIState_t  intState;
+
+  BSP_ENTER_CRITICAL_SECTION(intState);
+  while (fifo->head)
+  {
+    sInFrameQ[fifo->head-1].fi_usage = FI_AVAILABLE;
+    rxFifoRemoveHead(fifo);
+  }
+  BSP_EXIT_CRITICAL_SECTION(intState);
+}
+
+/******************************************************************************
+ * @fn          rxFifoRemoveHead
+ *
+ * @brief       [BM] Unlink the oldest frame of a receive FIFO. Called with
+ *              interrupts off.
+ *
+ * input parameters
+ * @param   fifo   - receive FIFO, not empty
+ *
+ * output parameters
+ *
+ * @return      void
+ */
+static void rxFifoRemoveHead(rxFifo_t *fifo)
+{
+  fifo->head = sInFrameQ[fifo->head-1].next;
+  if (!fifo->head)
+  {
+    fifo->tail = 0;
+  }
+}
+#endif  /* END_DEVICE */
+
 /******************************************************************************
  * @fn          nwk_QadjustOrder
  *
@@ -247,6 +503,7 @@ void nwk_QadjustOrder(uint8_t which, uint8_t stamp)
   return;
 }
 
+#if !defined(END_DEVICE)
 /******************************************************************************
  * @fn          nwk_QfindOldest
  *
@@ -354,7 +611,10 @@ frameInfo_t *nwk_QfindOldest(uint8_t which, rcvContext_t *rcv, uint8_t fi_usage)
         }
 #endif
 
-        addr12Compare = memcmp(pAddr1, pAddr2, NET_ADDR_SIZE);
+        /* [BM] NWK ports match on the port alone and leave the addresses
+         * unset, compare them only for the other lookups.
+         */
+        addr12Compare = (RCV_NWK_PORT == rcv->type) ? 0 : memcmp(pAddr1, pAddr2, NET_ADDR_SIZE);
         if (  (RCV_NWK_PORT == rcv->type) ||
               (!pAddr3 && !addr12Compare) ||
               (pAddr3 && !memcmp(pAddr3, MRFI_P_SRC_ADDR(&wPtr->mrfiPkt), NET_ADDR_SIZE))
@@ -397,6 +657,7 @@ frameInfo_t *nwk_QfindOldest(uint8_t which, rcvContext_t *rcv, uint8_t fi_usage)
 
   return fPtr;
 }
+#endif  /* !END_DEVICE */
 
 /******************************************************************************
  * @fn          nwk_getQ
@@ -46,8 +46,16 @@
 /* prototypes */
 void              nwk_QInit(void);
 frameInfo_t *nwk_QfindSlot(uint8_t);
+frameInfo_t *nwk_QfindFreeRxSlot(void);     /* [BM] */
 void              nwk_QadjustOrder(uint8_t, uint8_t);
+#if defined(END_DEVICE)
+rxFifo_t    *nwk_QrxFifo(rcvContext_t *);           /* [BM] */
+void         nwk_QputRx(frameInfo_t *, rxFifo_t *); /* [BM] */
+frameInfo_t *nwk_QgetRx(rxFifo_t *);                /* [BM] */
+void         nwk_QflushRx(rxFifo_t *);              /* [BM] */
+#else
 frameInfo_t *nwk_QfindOldest(uint8_t, rcvContext_t *, uint8_t);
+#endif
 frameInfo_t *nwk_getQ(uint8_t);
 
 #endif  /* NWK_QMGMT_H */
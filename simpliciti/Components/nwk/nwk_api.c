@@ -97,27 +97,22 @@ static uint8_t ioctlPreInitAccessIsOK(ioctlObject_t);
  */
 
 /***********************************************************************************
- * @fn          SMPL_Init
+ * @fn          SMPL_InitNoJoin
  *
- * @brief       Initialize the SimpliciTI stack.
+ * @brief       [BM] Initialize the SimpliciTI stack like SMPL_Init() but do not
+ *              join. The caller restores a saved join context instead
+ *              (IOCTL_OBJ_JOINCTX) and can link right away. If the AP does not
+ *              know the context any more a later SMPL_Init() only joins.
  *
  * input parameters
- * @param   f  - Pointer to call back function. Function called by NWK when
- *               user application frame received. The callback is done in the
- *               ISR thread. Argument is Link ID associated with frame. Function
- *               returns 0 if frame is to be kept by NWK, otherwise 1. Frame
- *               should be kept if application will do a SMPL_Receive() in the
- *               user thread (recommended). Pointer may be NULL.
+ * @param   f  - Pointer to call back function, see SMPL_Init().
  *
  * output parameters
  *
  * @return   Status of operation:
  *             SMPL_SUCCESS
- *             SMPL_NO_JOIN     No Join reply. AP possibly not yet up.
- *             SMPL_NO_CHANNEL  Only if Frequency Agility enabled. Channel scan
- *                              failed. AP possibly not yet up.
  */
-smplStatus_t SMPL_Init(uint8_t (*f)(linkID_t))
+smplStatus_t SMPL_InitNoJoin(uint8_t (*f)(linkID_t))
 {
   smplStatus_t rc;
 
@@ -155,6 +150,40 @@ smplStatus_t SMPL_Init(uint8_t (*f)(linkID_t))
   }
   sInit_done = 1;
 
+  return SMPL_SUCCESS;
+}
+
+/***********************************************************************************
+ * @fn          SMPL_Init
+ *
+ * @brief       Initialize the SimpliciTI stack.
+ *
+ * input parameters
+ * @param   f  - Pointer to call back function. Function called by NWK when
+ *               user application frame received. The callback is done in the
+ *               ISR thread. Argument is Link ID associated with frame. Function
+ *               returns 0 if frame is to be kept by NWK, otherwise 1. Frame
+ *               should be kept if application will do a SMPL_Receive() in the
+ *               user thread (recommended). Pointer may be NULL.
+ *
+ * output parameters
+ *
+ * @return   Status of operation:
+ *             SMPL_SUCCESS
+ *             SMPL_NO_JOIN     No Join reply. AP possibly not yet up.
+ *             SMPL_NO_CHANNEL  Only if Frequency Agility enabled. Channel scan
+ *                              failed. AP possibly not yet up.
+ */
+smplStatus_t SMPL_Init(uint8_t (*f)(linkID_t))
+{
+  smplStatus_t rc;
+
+  /* [BM] Stack setup shared with SMPL_InitNoJoin() */
+  if ((rc=SMPL_InitNoJoin(f)) != SMPL_SUCCESS)
+  {
+    return rc;
+  }
+
   /* Join. if no AP or Join fails that status is returned. */
   rc = nwk_join();
 
@@ -509,6 +538,70 @@ smplStatus_t SMPL_Receive(linkID_t lid, uint8_t *msg, uint8_t *len)
 #endif  /* RX_POLLS */
 }
 
+#if !defined(RX_POLLS)
+/**************************************************************************************
+ * @fn          SMPL_ReceiveFrame
+ *
+ * @brief       [BM] Receive a message from a peer application without a copy.
+ *              The message stays in the input frame queue and belongs to the
+ *              caller until SMPL_ReleaseFrame(). A held message takes a slot
+ *              the radio cannot receive into, release it soon.
+ *
+ * input parameters
+ * @param   lid     - Link ID (port) from application
+ *
+ * output parameters
+ * @param   msg     - pointer to where the pointer to the message is stored
+ * @param   len     - pointer to receive length of received message
+ *
+ * @return    Status of operation, see SMPL_Receive().
+ */
+smplStatus_t SMPL_ReceiveFrame(linkID_t lid, uint8_t **msg, uint8_t *len)
+{
+  connInfo_t  *pCInfo = nwk_getConnInfo(lid);
+  smplStatus_t rc = SMPL_BAD_PARAM;
+  rcvContext_t rcv;
+  frameInfo_t *fPtr;
+
+  *len = 0;
+  if (!pCInfo || ((rc=nwk_checkConnInfo(pCInfo, CHK_RX)) != SMPL_SUCCESS))
+  {
+    return rc;
+  }
+
+  rcv.type  = RCV_APP_LID;
+  rcv.t.lid = lid;
+
+  if ((rc=nwk_holdFrame(&rcv, &fPtr)) == SMPL_SUCCESS)
+  {
+    *msg = MRFI_P_PAYLOAD(&fPtr->mrfiPkt) + F_APP_PAYLOAD_OS;
+    *len = MRFI_GET_PAYLOAD_LEN(&fPtr->mrfiPkt) - F_APP_PAYLOAD_OS;
+  }
+
+  return rc;
+}
+
+/**************************************************************************************
+ * @fn          SMPL_ReleaseFrame
+ *
+ * @brief       [BM] Give a message received with SMPL_ReceiveFrame() back to
+ *              the input frame queue.
+ *
+ * input parameters
+ * @param   msg     - the message pointer SMPL_ReceiveFrame() returned
+ *
+ * output parameters
+ *
+ * @return    Status of operation.
+ *              SMPL_SUCCESS
+ *              SMPL_BAD_PARAM  Not a message held by the application
+ */
+smplStatus_t SMPL_ReleaseFrame(uint8_t *msg)
+{
+  return nwk_releasePayload(msg);
+}
+#endif  /* !RX_POLLS */
+
 
 /******************************************************************************
  * @fn          SMPL_Link
@@ -739,8 +832,18 @@ smplStatus_t SMPL_Ioctl(ioctlObject_t object, ioctlAction_t action, void *val)
     case IOCTL_OBJ_NVOBJ:
       rc = nwk_NVObj(action, (ioctlNVObj_t *)val);
       break;
+
 #endif  /* EXTENDED_API */
 
+#if !defined( ACCESS_POINT )
+    /* [BM] Restore or save the join context. Not under EXTENDED_API, the
+     * link cache of the end device needs it.
+     */
+    case IOCTL_OBJ_JOINCTX:
+      rc = nwk_joinContext(action, (ioctlJoinCtx_t *)val);
+      break;
+#endif
+
     case IOCTL_OBJ_CONNOBJ:
       rc = nwk_connectionControl(action, val);
       break;
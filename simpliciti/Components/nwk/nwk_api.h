@@ -41,11 +41,14 @@
 #define  SMPL_TXOPTION_ACKREQ     ((txOpt_t)0x01)
 
 smplStatus_t SMPL_Init(uint8_t (*)(linkID_t));
+smplStatus_t SMPL_InitNoJoin(uint8_t (*)(linkID_t));     /* [BM] */
 smplStatus_t SMPL_Link(linkID_t *);
 smplStatus_t SMPL_LinkListen(linkID_t *);
 smplStatus_t SMPL_Send(linkID_t lid, uint8_t *msg, uint8_t len);
 smplStatus_t SMPL_SendOpt(linkID_t lid, uint8_t *msg, uint8_t len, txOpt_t);
 smplStatus_t SMPL_Receive(linkID_t lid, uint8_t *msg, uint8_t *len);
+smplStatus_t SMPL_ReceiveFrame(linkID_t lid, uint8_t **msg, uint8_t *len);  /* [BM] */
+smplStatus_t SMPL_ReleaseFrame(uint8_t *msg);                             /* [BM] */
 smplStatus_t SMPL_Ioctl(ioctlObject_t, ioctlAction_t, void *);
 #ifdef EXTENDED_API
 smplStatus_t SMPL_Ping(linkID_t);
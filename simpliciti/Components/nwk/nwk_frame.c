@@ -75,6 +75,9 @@ static  fhStatus_t (* const func[])(mrfiPacket_t *) = { nwk_processPing,
                                                         nwk_processFreq,
                                                         nwk_processMgmt
                                                       };
+
+/* [BM] Input queue slot the radio reads the current frame into */
+static frameInfo_t *spRxSlot = 0;
 #endif  /* SIZE_INFRAME_Q > 0 */
 
 static uint8_t sTRACTID = 0;
@@ -94,6 +97,9 @@ static uint8_t  (*spCallback)(linkID_t) = NULL;
 #if SIZE_INFRAME_Q > 0
 /* local helper functions for Rx devices */
 static void  dispatchFrame(frameInfo_t *);
+#if defined(END_DEVICE)
+static void  keepFrame(frameInfo_t *, rcvType_t, uint8_t);
+#endif
 #if !defined(END_DEVICE)
 #if defined(ACCESS_POINT)
 /* only Access Points need to worry about duplicate S&F frames */
@@ -269,11 +275,14 @@ frameInfo_t *nwk_buildAckReqFrame(uint8_t port, uint8_t *msg, uint8_t len, uint8
  */
 void MRFI_RxCompleteISR()
 {
-  frameInfo_t  *fInfoPtr;
+  frameInfo_t  *fInfoPtr = spRxSlot;
+
+  spRxSlot = 0;
 
-  /* room for more? */
-  if (fInfoPtr=nwk_QfindSlot(INQ))
+  /* [BM] already received into a free slot? if not, room for more? */
+  if (fInfoPtr || (fInfoPtr=nwk_QfindSlot(INQ)))
   {
+    /* no copy if the radio read the frame into the slot */
     MRFI_Receive(&fInfoPtr->mrfiPkt);
 
     dispatchFrame(fInfoPtr);
@@ -282,6 +291,28 @@ void MRFI_RxCompleteISR()
   return;
 }
 
+/******************************************************************************
+ * @fn          MRFI_RxBufferISR
+ *
+ * @brief       [BM] Here on Rx interrupt from radio before the frame is read
+ *              from the radio Rx FIFO. Supplies a free input queue slot so the
+ *              frame needs no copy. The slot stays available until
+ *              MRFI_RxCompleteISR() dispatches the frame, a frame that fails
+ *              the CRC or address check leaves it free.
+ *
+ * input parameters
+ *
+ * output parameters
+ *
+ * @return      Packet buffer of a free slot, 0 if the queue is full
+ */
+mrfiPacket_t *MRFI_RxBufferISR(void)
+{
+  spRxSlot = nwk_QfindFreeRxSlot();
+
+  return spRxSlot ? &spRxSlot->mrfiPkt : (mrfiPacket_t *)0;
+}
+
 /******************************************************************************
  * @fn          nwk_retrieveFrame
  *
@@ -312,93 +343,191 @@ void MRFI_RxCompleteISR()
 smplStatus_t nwk_retrieveFrame(rcvContext_t *rcv, uint8_t *msg, uint8_t *len, addr_t *srcAddr, uint8_t *hopCount)
 {
   frameInfo_t *fPtr;
-  uint8_t      done;
+  smplStatus_t rc;
 
-  do {
-    /* look for a frame on requested port. */
-    *len = 0;
-    done = 1;
+  /* look for a frame on requested port. */
+  *len = 0;
+  if ((rc=nwk_holdFrame(rcv, &fPtr)) != SMPL_SUCCESS)
+  {
+    return rc;
+  }
+
+  /* it's on the requested port. */
+  *len = MRFI_GET_PAYLOAD_LEN(&fPtr->mrfiPkt) - F_APP_PAYLOAD_OS;
+  memcpy(msg, MRFI_P_PAYLOAD(&fPtr->mrfiPkt)+F_APP_PAYLOAD_OS, *len);
+  if (srcAddr)
+  {
+    /* copy source address if requested */
+    memcpy(srcAddr, MRFI_P_SRC_ADDR(&fPtr->mrfiPkt), NET_ADDR_SIZE);
+  }
+  if (hopCount)
+  {
+    /* copy hop count if requested */
+    *hopCount = GET_FROM_FRAME(MRFI_P_PAYLOAD(&fPtr->mrfiPkt), F_HOP_COUNT);
+  }
+  /* input frame no longer needed. free it. */
+  nwk_releaseFrame(fPtr);
+
+  return SMPL_SUCCESS;
+}
 
+/******************************************************************************
+ * @fn          nwk_holdFrame
+ *
+ * @brief       [BM] Take the oldest frame of a receive context out of the Rx
+ *              frame queue without copying it. A secure frame is checked and
+ *              decrypted in place, the signal info of a connection is saved.
+ *              The frame stays in its slot and belongs to the caller until
+ *              nwk_releaseFrame(). Should run in a user thread.
+ *
+ * input parameters
+ * @param    rcv     - receive context: NWK port or Link ID
+ *
+ * output parameters
+ * @param    frame   - the frame, 0 if none
+ *
+ * @return    SMPL_SUCCESS
+ *            SMPL_NO_FRAME  - no frame found for specified destination
+ *            SMPL_BAD_PARAM - no valid connection info for the Link ID
+ */
+smplStatus_t nwk_holdFrame(rcvContext_t *rcv, frameInfo_t **frame)
+{
+  frameInfo_t *fPtr;
+  connInfo_t  *pCInfo = 0;
+#if defined(END_DEVICE)
+  rxFifo_t    *fifo;
+#endif
+
+  *frame = 0;
+  if (RCV_APP_LID == rcv->type)
+  {
+    pCInfo = nwk_getConnInfo(rcv->t.lid);
+    if (!pCInfo)
+    {
+      return SMPL_BAD_PARAM;
+    }
+  }
+#if defined(END_DEVICE)
+  if (!(fifo=nwk_QrxFifo(rcv)))
+  {
+    return SMPL_BAD_PARAM;
+  }
+#endif
+
+  while (1)
+  {
+#if defined(END_DEVICE)
+    fPtr = nwk_QgetRx(fifo);
+#else
     fPtr = nwk_QfindOldest(INQ, rcv, USAGE_NORMAL);
-    if (fPtr)
+#endif
+    if (!fPtr)
     {
-      connInfo_t  *pCInfo = 0;
+      return SMPL_NO_FRAME;
+    }
 
-      if (RCV_APP_LID == rcv->type)
-      {
-        pCInfo = nwk_getConnInfo(rcv->t.lid);
-        if (!pCInfo)
-        {
-          return SMPL_BAD_PARAM;
-        }
+    if (pCInfo)
+    {
 #if defined(SMPL_SECURE)
-        /* decrypt here...we have all the context we need. */
-        {
-          uint32_t  ctr  = pCInfo->connRxCTR;
-          uint32_t *pctr = &ctr;
-          uint8_t   len  = MRFI_GET_PAYLOAD_LEN(&fPtr->mrfiPkt) - F_SEC_CTR_OS;
-
-          if (pCInfo->thisLinkID == SMPL_LINKID_USER_UUD)
-          {
-            pctr = NULL;
-          }
-#if defined(RX_POLLS)
-          else if ((F_APP_PAYLOAD_OS - F_SEC_CTR_OS) == len)
-          {
-            /* This was an empty poll reply frame generated by the AP.
-             * It uses the single-byte CTR value like network applications.
-             * We do not want to use the application layer counter in this case.
-             */
-            pctr = NULL;
-          }
-#endif
-          if (nwk_getSecureFrame(&fPtr->mrfiPkt, len, pctr))
-          {
-            if (pctr)
-            {
-              /* Update connection's counter. */
-              pCInfo->connRxCTR = ctr;
-            }
-          }
-          else
-          {
-            /* Frame bogus. Check for another frame. */
-            done = 0;
-            continue;
-          }
-        }
-#endif  /* SMPL_SECURE */
-      }
+      /* decrypt here...we have all the context we need. */
+      uint32_t  ctr  = pCInfo->connRxCTR;
+      uint32_t *pctr = &ctr;
+      uint8_t   len  = MRFI_GET_PAYLOAD_LEN(&fPtr->mrfiPkt) - F_SEC_CTR_OS;
 
-      /* it's on the requested port. */
-      *len = MRFI_GET_PAYLOAD_LEN(&fPtr->mrfiPkt) - F_APP_PAYLOAD_OS;
-      memcpy(msg, MRFI_P_PAYLOAD(&fPtr->mrfiPkt)+F_APP_PAYLOAD_OS, *len);
-      /* save signal info */
-      if (pCInfo)
+      if (pCInfo->thisLinkID == SMPL_LINKID_USER_UUD)
       {
-        /* Save Rx metrics... */
-        pCInfo->sigInfo.rssi = fPtr->mrfiPkt.rxMetrics[MRFI_RX_METRICS_RSSI_OFS];
-        pCInfo->sigInfo.lqi  = fPtr->mrfiPkt.rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS];
+        pctr = NULL;
       }
-      if (srcAddr)
+#if defined(RX_POLLS)
+      else if ((F_APP_PAYLOAD_OS - F_SEC_CTR_OS) == len)
+      {
+        /* This was an empty poll reply frame generated by the AP.
+         * It uses the single-byte CTR value like network applications.
+         * We do not want to use the application layer counter in this case.
+         */
+        pctr = NULL;
+      }
+#endif
+      if (!nwk_getSecureFrame(&fPtr->mrfiPkt, len, pctr))
       {
-        /* copy source address if requested */
-        memcpy(srcAddr, MRFI_P_SRC_ADDR(&fPtr->mrfiPkt), NET_ADDR_SIZE);
+        /* Frame bogus. [BM] Free its slot, check for another frame. */
+        nwk_releaseFrame(fPtr);
+        continue;
       }
-      if (hopCount)
+      if (pctr)
       {
-        /* copy hop count if requested */
-        *hopCount = GET_FROM_FRAME(MRFI_P_PAYLOAD(&fPtr->mrfiPkt), F_HOP_COUNT);
+        /* Update connection's counter. */
+        pCInfo->connRxCTR = ctr;
       }
-      /* input frame no longer needed. free it. */
-      nwk_QadjustOrder(INQ, fPtr->orderStamp);
+#endif  /* SMPL_SECURE */
 
-      fPtr->fi_usage = FI_AVAILABLE;
-      return SMPL_SUCCESS;
+      /* Save Rx metrics... */
+      pCInfo->sigInfo.rssi = fPtr->mrfiPkt.rxMetrics[MRFI_RX_METRICS_RSSI_OFS];
+      pCInfo->sigInfo.lqi  = fPtr->mrfiPkt.rxMetrics[MRFI_RX_METRICS_CRC_LQI_OFS];
     }
-  } while (!done);
 
-  return SMPL_NO_FRAME;
+    *frame = fPtr;
+    return SMPL_SUCCESS;
+  }
+}
+
+/******************************************************************************
+ * @fn          nwk_releaseFrame
+ *
+ * @brief       [BM] Free a frame taken with nwk_holdFrame().
+ *
+ * input parameters
+ * @param    frame   - the frame
+ *
+ * output parameters
+ *
+ * @return    void
+ */
+void nwk_releaseFrame(frameInfo_t *frame)
+{
+#if !defined(END_DEVICE)
+  nwk_QadjustOrder(INQ, frame->orderStamp);
+#endif
+  frame->fi_usage = FI_AVAILABLE;
+}
+
+/******************************************************************************
+ * @fn          nwk_releasePayload
+ *
+ * @brief       [BM] Free a frame taken with nwk_holdFrame() by the pointer to
+ *              its application payload the caller got.
+ *
+ * input parameters
+ * @param    msg     - application payload of the frame
+ *
+ * output parameters
+ *
+ * @return    SMPL_SUCCESS
+ *            SMPL_BAD_PARAM - not the payload of a frame held by the caller
+ */
+smplStatus_t nwk_releasePayload(uint8_t *msg)
+{
+  frameInfo_t *fPtr  = nwk_getQ(INQ);
+  uint8_t     *first = MRFI_P_PAYLOAD(&fPtr->mrfiPkt) + F_APP_PAYLOAD_OS;
+  uint16_t     os;
+
+  if (msg < first)
+  {
+    return SMPL_BAD_PARAM;
+  }
+  os = msg - first;
+  if ((os % sizeof(frameInfo_t)) || ((os / sizeof(frameInfo_t)) >= SIZE_INFRAME_Q))
+  {
+    return SMPL_BAD_PARAM;
+  }
+  fPtr += os / sizeof(frameInfo_t);
+  if (FI_INUSE_TRANSITION != fPtr->fi_usage)
+  {
+    return SMPL_BAD_PARAM;
+  }
+  nwk_releaseFrame(fPtr);
+
+  return SMPL_SUCCESS;
 }
 
 /******************************************************************************
@@ -468,7 +597,11 @@ static void dispatchFrame(frameInfo_t *fiPtr)
     rc = func[port-1](&fiPtr->mrfiPkt);
     if (FHS_KEEP == rc)
     {
+#if defined(END_DEVICE)
+      keepFrame(fiPtr, RCV_NWK_PORT, port);
+#else
       fiPtr->fi_usage = FI_INUSE_UNTIL_DEL;
+#endif
     }
 #if !defined(END_DEVICE)
     else if (FHS_REPLAY == rc)
@@ -508,7 +641,7 @@ static void dispatchFrame(frameInfo_t *fiPtr)
   {
     if (nwk_isConnectionValid(&fiPtr->mrfiPkt, &lid))
     {
-      fiPtr->fi_usage = FI_INUSE_UNTIL_DEL;
+      keepFrame(fiPtr, RCV_APP_LID, lid);
     }
     else
     {
@@ -523,12 +656,15 @@ static void dispatchFrame(frameInfo_t *fiPtr)
   /* it's destined for a user app. */
   if (nwk_isConnectionValid(&fiPtr->mrfiPkt, &lid))
   {
-    fiPtr->fi_usage = FI_INUSE_UNTIL_DEL;
+    /* [BM] The callback runs before the frame is queued, a frame it
+     * releases never enters the receive FIFO.
+     */
     if (spCallback && spCallback(lid))
     {
       fiPtr->fi_usage = FI_AVAILABLE;
       return;
     }
+    keepFrame(fiPtr, RCV_APP_LID, lid);
   }
   else
   {
@@ -626,6 +762,49 @@ static void dispatchFrame(frameInfo_t *fiPtr)
 #endif  /* !END_DEVICE */
   return;
 }
+
+#if defined(END_DEVICE)
+/******************************************************************************
+ * @fn          keepFrame
+ *
+ * @brief       [BM] Keep a dispatched frame for retrieval in the receive FIFO
+ *              of its NWK port or connection.
+ *
+ * input parameters
+ * @param   fiPtr    - frameInfo_t pointer to received frame
+ * @param   type     - RCV_NWK_PORT or RCV_APP_LID
+ * @param   id       - NWK port or Link ID
+ *
+ * output parameters
+ *
+ * @return   void
+ */
+static void keepFrame(frameInfo_t *fiPtr, rcvType_t type, uint8_t id)
+{
+  rcvContext_t rcv;
+  rxFifo_t    *fifo;
+
+  rcv.type = type;
+  if (RCV_NWK_PORT == type)
+  {
+    rcv.t.port = id;
+  }
+  else
+  {
+    rcv.t.lid = id;
+  }
+
+  if ((fifo=nwk_QrxFifo(&rcv)))
+  {
+    nwk_QputRx(fiPtr, fifo);
+  }
+  else
+  {
+    fiPtr->fi_usage = FI_AVAILABLE;
+  }
+}
+#endif  /* END_DEVICE */
+
 #endif   /* SIZE_INFRAME_Q > 0 */
 
 /******************************************************************************
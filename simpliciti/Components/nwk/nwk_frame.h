@@ -121,7 +121,14 @@ typedef struct
 typedef struct
 {
   volatile uint8_t      fi_usage;
-           uint8_t      orderStamp;
+           uint8_t      orderStamp;   /* [BM] end device: arrival sequence */
+#if defined(END_DEVICE)
+  /* [BM] receive FIFO the frame is queued in, slot number + 1 of the next
+   * frame in it (0 = last)
+   */
+           rxFifo_t    *fifo;
+           uint8_t      next;
+#endif
            mrfiPacket_t mrfiPkt;
 } frameInfo_t;
 
@@ -134,6 +141,9 @@ frameInfo_t  *nwk_buildAckReqFrame(uint8_t, uint8_t *, uint8_t, uint8_t, volatil
 void          nwk_receiveFrame(void);
 void          nwk_frameInit(uint8_t (*)(linkID_t));
 smplStatus_t  nwk_retrieveFrame(rcvContext_t *, uint8_t *, uint8_t *, addr_t *, uint8_t *);
+smplStatus_t  nwk_holdFrame(rcvContext_t *, frameInfo_t **);     /* [BM] */
+void          nwk_releaseFrame(frameInfo_t *);                  /* [BM] */
+smplStatus_t  nwk_releasePayload(uint8_t *);                    /* [BM] */
 smplStatus_t  nwk_sendFrame(frameInfo_t *, uint8_t txOption);
 frameInfo_t  *nwk_getSandFFrame(mrfiPacket_t *, uint8_t);
 uint8_t       nwk_getMyRxType(void);
@@ -73,7 +73,8 @@ enum ioctlObject  {
   IOCTL_OBJ_FWVER,
   IOCTL_OBJ_PROTOVER,
   IOCTL_OBJ_NVOBJ,
-  IOCTL_OBJ_TOKEN
+  IOCTL_OBJ_TOKEN,
+  IOCTL_OBJ_JOINCTX          /* [BM] */
 };
 
 enum ioctlAction  {
@@ -88,9 +89,12 @@ enum ioctlAction  {
   IOCTL_ACT_RADIO_RXON,
   IOCTL_ACT_RADIO_RXIDLE,
   IOCTL_ACT_RADIO_SETPWR,
+  IOCTL_ACT_RADIO_WOR,
+  IOCTL_ACT_RADIO_CCA,       /* [BM] */
   IOCTL_ACT_ON,
   IOCTL_ACT_OFF,
   IOCTL_ACT_SCAN,
+  IOCTL_ACT_MOVE,            /* [BM] */
   IOCTL_ACT_DELETE
 };
 
@@ -140,6 +144,13 @@ typedef struct
   rxMetrics_t  sigInfo;
 } ioctlRadioSiginfo_t;
 
+/* [BM] Clear channel assessments of the last frame sent with CCA */
+typedef struct
+{
+  uint8_t  fails;      /* failed assessments, MRFI_CCA_RETRIES+1 if the frame was not sent */
+  rssi_t   rssi;       /* RSSI of the last failed assessment */
+} ioctlRadioCca_t;
+
 
 /*                      *** Begin SET/GET token support ***                */
 enum tokenType
@@ -162,6 +173,17 @@ typedef struct
   tokenType_t  tokenType;
   token_t      token;
 } ioctlToken_t;
+
+/* [BM] Join context of a non-AP device: everything a successful join sets up.
+ * Saved after a link and restored after SMPL_InitNoJoin() instead of a new join.
+ */
+typedef struct
+{
+  addr_t    apAddr;
+  uint32_t  linkToken;
+  uint32_t  joinToken;
+  uint8_t   logicalChan;
+} ioctlJoinCtx_t;
 /*                      *** End SET/GET token support ***                */
 
 
@@ -270,6 +292,16 @@ typedef struct
     mrfiPacket_t *pkt;
   } t;
 } rcvContext_t;
+
+/* [BM] End device: received frames of one receive context (NWK application
+ * port or connection) in arrival order. Input queue slot number + 1 of the
+ * oldest and the newest frame, 0 if empty. The frames link to each other.
+ */
+typedef struct
+{
+  uint8_t  head;
+  uint8_t  tail;
+} rxFifo_t;
 /********    END: Object support for parameter context in queue management *********/
 
 #define SMPL_FWVERSION_SIZE  4
@@ -82,6 +82,8 @@ static void       replayFirst(mrfiPacket_t *);
 #ifdef ACCESS_POINT
 /* only the AP can broadcast this command */
 static void broadcast_channel_change(uint8_t);
+/* [BM] ...also on request of a linked device */
+static void move_on_request(mrfiPacket_t *);
 #else
 /* APs do not process this frame */
 static void change_channel_cmd(mrfiPacket_t *);
@@ -198,6 +200,11 @@ static fhStatus_t handle_freq_cmd(mrfiPacket_t *frame)
 
 #ifdef ACCESS_POINT
     case FREQ_REQ_REQ_MOVE:
+      /* [BM] Only devices linked to us may move the network */
+      if (nwk_findAddressMatch(frame))
+      {
+        move_on_request(frame);
+      }
       break;
 #endif
     default:
@@ -318,9 +325,74 @@ static void change_channel_cmd(mrfiPacket_t *frame)
   chan.logicalChan = *(MRFI_P_PAYLOAD(frame)+F_APP_PAYLOAD_OS+F_CHAN_OS);
 
   nwk_setChannel(&chan);
+
+  /* [BM] This may be the answer to our own move request: end its reply delay */
+  MRFI_PostKillSem();
 #endif
   return;
 }
+
+/******************************************************************************
+ * @fn          nwk_requestMove
+ *
+ * @brief       [BM] Ask the Access Point to move the network to another
+ *              logical channel. The AP answers by broadcasting the channel
+ *              change, which moves this device through change_channel_cmd().
+ *              If that broadcast is missed the AP may have moved anyway, so
+ *              it is looked for on all channels. Accessed by application
+ *              through IOCTL interface.
+ *
+ * input parameters
+ * @param   chan     - pointer to channel object of requested channel
+ *
+ * @return   status of operation:
+ *             SMPL_SUCCESS     on the requested channel, together with the AP
+ *             SMPL_BAD_PARAM   channel out of range or no AP known
+ *             SMPL_NO_CHANNEL  AP did not move. This device is on the channel
+ *                              the AP was found on, or unchanged if not found.
+ */
+smplStatus_t nwk_requestMove(freqEntry_t *chan)
+{
+  uint8_t        msg[FREQ_REQ_REQ_MOVE_FRAME_SIZE];
+  uint8_t        radioState = MRFI_GetRadioState();
+  addr_t        *apAddr = (addr_t *)nwk_getAPAddress();
+  freqEntry_t    curChan;
+  ioctlRawSend_t send;
+
+  if (!apAddr || chan->logicalChan >= NWK_FREQ_TBL_SIZE)
+  {
+    return SMPL_BAD_PARAM;
+  }
+
+  nwk_getChannel(&curChan);
+  if (curChan.logicalChan == chan->logicalChan)
+  {
+    return SMPL_SUCCESS;
+  }
+
+  msg[FB_APP_INFO_OS] = FREQ_REQ_REQ_MOVE;
+  msg[F_CHAN_OS]      = chan->logicalChan;
+
+  send.addr = apAddr;
+  send.msg  = msg;
+  send.len  = sizeof(msg);
+  send.port = SMPL_PORT_FREQ;
+
+  SMPL_Ioctl(IOCTL_OBJ_RAW_IO, IOCTL_ACT_WRITE, &send);
+
+  /* the channel change broadcast ends the delay early */
+  NWK_CHECK_FOR_SETRX(radioState);
+  NWK_REPLY_DELAY();
+  NWK_CHECK_FOR_RESTORE_STATE(radioState);
+
+  nwk_getChannel(&curChan);
+  if (curChan.logicalChan != chan->logicalChan && nwk_scanForChannels(&curChan))
+  {
+    nwk_setChannel(&curChan);
+  }
+
+  return (curChan.logicalChan == chan->logicalChan) ? SMPL_SUCCESS : SMPL_NO_CHANNEL;
+}
 #endif  /* !ACCESS_POINT */
 
 /******************************************************************************
@@ -534,6 +606,12 @@ smplStatus_t nwk_freqControl(ioctlAction_t action, void *val)
       }
       break;
 
+#ifndef ACCESS_POINT
+    case IOCTL_ACT_MOVE:
+      rc = nwk_requestMove((freqEntry_t *)val);
+      break;
+#endif  /* !ACCESS_POINT */
+
     default:
       rc = SMPL_BAD_PARAM;
       break;
@@ -583,6 +661,47 @@ static void broadcast_channel_change(uint8_t idx)
     SMPL_Ioctl(IOCTL_OBJ_RAW_IO, IOCTL_ACT_WRITE, &send);
   }
 }
+
+/******************************************************************************
+ * @fn          move_on_request
+ *
+ * @brief       [BM] For Access Point only: a linked device asks to move the
+ *              network to a channel it found less busy. Broadcast the change
+ *              once - there is no time for the delayed repeat of
+ *              broadcast_channel_change() while dispatching a received frame -
+ *              and follow.
+ *
+ * input parameters
+ * @param   frame  - pointer to frame with the requested logical channel
+ *
+ * @return   none.
+ */
+static void move_on_request(mrfiPacket_t *frame)
+{
+  uint8_t      msg[FREQ_REQ_MOVE_FRAME_SIZE];
+  frameInfo_t *pOutFrame;
+  freqEntry_t  chan;
+
+  chan.logicalChan = *(MRFI_P_PAYLOAD(frame)+F_APP_PAYLOAD_OS+F_CHAN_OS);
+  if (chan.logicalChan >= NWK_FREQ_TBL_SIZE || chan.logicalChan == sCurLogicalChan.logicalChan)
+  {
+    return;
+  }
+
+  msg[FB_APP_INFO_OS] = FREQ_REQ_MOVE;
+  msg[F_CHAN_OS]      = chan.logicalChan;
+
+  if (pOutFrame = nwk_buildFrame(SMPL_PORT_FREQ, msg, sizeof(msg), MAX_HOPS_FROM_AP))
+  {
+    memcpy(MRFI_P_DST_ADDR(&pOutFrame->mrfiPkt), nwk_getBCastAddress(), NET_ADDR_SIZE);
+#ifdef SMPL_SECURE
+    nwk_setSecureFrame(&pOutFrame->mrfiPkt, sizeof(msg), 0);
+#endif  /* SMPL_SECURE */
+    nwk_sendFrame(pOutFrame, MRFI_TX_TYPE_FORCED);
+  }
+
+  nwk_setChannel(&chan);
+}
 #endif  /* ACCESS_POINT */
 
 #else  /* FREQUENCY_AGILITY */
@@ -58,6 +58,7 @@
 /* set the out frame sizes */
 #define  FREQ_REQ_MOVE_FRAME_SIZE   2
 #define  FREQ_REQ_PING_FRAME_SIZE   2
+#define  FREQ_REQ_REQ_MOVE_FRAME_SIZE   2   /* [BM] */
 
 /* prototypes */
 void         nwk_freqInit(void);
@@ -67,6 +68,9 @@ smplStatus_t nwk_setChannel(freqEntry_t *);
 void         nwk_getChannel(freqEntry_t *);
 uint8_t      nwk_scanForChannels(freqEntry_t *);
 smplStatus_t nwk_freqControl(ioctlAction_t, void *);
+#ifndef ACCESS_POINT
+smplStatus_t nwk_requestMove(freqEntry_t *);  /* [BM] */
+#endif
 #endif
 
 #endif
@@ -215,7 +215,25 @@ smplStatus_t nwk_radioControl(ioctlAction_t action, void *val)
   {
     MRFI_RxIdle();
   }
-#ifdef EXTENDED_API
+#ifdef CONFIG_SYNC_WOR
+  else if (IOCTL_ACT_RADIO_WOR == action)
+  {
+    /* sleep and sniff for a carrier once per Event0 period */
+    MRFI_WorOn();
+  }
+#endif
+#ifdef FREQUENCY_AGILITY
+  else if (IOCTL_ACT_RADIO_CCA == action)
+  {
+    /* [BM] channel statistics: how hard the last frame had to fight for the channel */
+    ioctlRadioCca_t *pCca = (ioctlRadioCca_t *)val;
+
+    pCca->fails = MRFI_CcaFailures(&pCca->rssi);
+  }
+#endif
+  /* [BM] Not under EXTENDED_API: the link quality callback sets the output
+   * power of the end device through this request.
+   */
   else if (IOCTL_ACT_RADIO_SETPWR == action)
   {
     uint8_t idx;
@@ -240,7 +258,6 @@ smplStatus_t nwk_radioControl(ioctlAction_t action, void *val)
     MRFI_SetRFPwr(idx);
     return SMPL_SUCCESS;
   }
-#endif  /* EXTENDED_API */
   else
   {
     rc = SMPL_BAD_PARAM;
@@ -522,6 +522,67 @@ smplStatus_t nwk_join(void)
 
 }
 
+/******************************************************************************
+ * @fn          nwk_joinContext
+ *
+ * @brief       [BM] Get or set the join context: AP address, link and join
+ *              tokens and, with Frequency Agility, the logical channel.
+ *              Setting it takes the place of a successful nwk_join(). The
+ *              context is only valid as long as the AP keeps its link token.
+ *
+ * input parameters
+ * @param   action   - IOCTL_ACT_GET or IOCTL_ACT_SET
+ * @param   ctx      - pointer to the context (SET)
+ *
+ * output parameters
+ * @param   ctx      - populated context (GET)
+ *
+ * @return   Status of operation.
+ *             SMPL_SUCCESS
+ *             SMPL_BAD_PARAM  unknown action, no AP address or bad channel
+ */
+smplStatus_t nwk_joinContext(ioctlAction_t action, ioctlJoinCtx_t *ctx)
+{
+  addr_t const *apAddr;
+#if defined( FREQUENCY_AGILITY )
+  freqEntry_t   chan;
+#endif
+
+  if (IOCTL_ACT_GET == action)
+  {
+    if (!(apAddr=nwk_getAPAddress()))
+    {
+      return SMPL_BAD_PARAM;
+    }
+    memcpy(&ctx->apAddr, apAddr, NET_ADDR_SIZE);
+    nwk_getLinkToken(&ctx->linkToken);
+    ctx->joinToken = sJoinToken;
+#if defined( FREQUENCY_AGILITY )
+    nwk_getChannel(&chan);
+    ctx->logicalChan = chan.logicalChan;
+#else
+    ctx->logicalChan = 0;
+#endif
+    return SMPL_SUCCESS;
+  }
+  else if (IOCTL_ACT_SET == action)
+  {
+#if defined( FREQUENCY_AGILITY )
+    chan.logicalChan = ctx->logicalChan;
+    if (SMPL_SUCCESS != nwk_setChannel(&chan))
+    {
+      return SMPL_BAD_PARAM;
+    }
+#endif
+    nwk_setJoinToken(ctx->joinToken);
+    nwk_setLinkToken(ctx->linkToken);
+    nwk_setAPAddress(&ctx->apAddr);
+    return SMPL_SUCCESS;
+  }
+
+  return SMPL_BAD_PARAM;
+}
+
 #endif /* ACCESS_POINT */
 
 /******************************************************************************
@@ -85,6 +85,8 @@ void            nwk_setJoinToken(uint32_t);
 void            nwk_getJoinToken(uint32_t *);
 #ifdef ACCESS_POINT
 sfClientInfo_t *nwk_isSandFClient(uint8_t *, uint8_t *);
+#else
+smplStatus_t    nwk_joinContext(ioctlAction_t, ioctlJoinCtx_t *);
 #endif
 
 #endif
@@ -48,7 +48,20 @@
 
 /*                   *** GENERAL SECURITY OUTLINE ***
  *
- * We are using XTEA (eXtended Tiny Encryption Algorithm) with a fixed
+ * [BM] By default frames are secured with AES-128 on the AES accelerator of
+ * the CC430. Defining SMPL_SECURE_XTEA selects the original software XTEA
+ * cipher instead. Both peers must be built with the same cipher. The frame
+ * layout is the same for both.
+ *
+ * AES: The application payload is encrypted in CTR mode. Each 128-bit counter
+ * block is the 32-bit initialization vector, the 32-bit frame counter, the
+ * source address and the index of the block within the frame. The integrity
+ * check is a CMAC (NIST SP 800-38B) over the frame counter, the source address
+ * and the encrypted payload, truncated to the 16 bits XTEA uses for its FCS and
+ * MAC bytes. The CMAC is verified before anything is decrypted. The frame
+ * counter advances by one per frame.
+ *
+ * XTEA: We are using XTEA (eXtended Tiny Encryption Algorithm) with a fixed
  * number of rounds (32). We have removed the parameters from the API
  * we harvested from the public domain.
  *
@@ -61,6 +74,9 @@
  * than the message we simply discard the remaining cipher block.
  */
 
+#if !defined(SMPL_SECURE_XTEA) && !defined(__MSP430_HAS_AES__)
+#error ERROR: No AES accelerator on this MCU. Define SMPL_SECURE_XTEA.
+#endif
 
 /******************************************************************************
  * MACROS
@@ -80,10 +96,24 @@
 #error ERROR: 0 <= CTR_WINDOW < 256
 #endif
 
+#ifdef SMPL_SECURE_XTEA
 /* Number of rounds for XTEA algorithm. A parameter in the public domain code
  * but we fix it here at 32.
  */
 #define NUM_ROUNDS  32
+#else
+/* [BM] AES cipher block size. The accelerator is fed 16-bit words, little
+ * endian like the MCU, so a block in RAM keeps its byte order.
+ */
+#define AES_BLOCK_BYTES       16
+#define AES_BLOCK_WORDS        8
+
+/* [BM] CMAC input: frame counter, source address and payload, whole blocks */
+#define AES_CMAC_WORDS        ((4+NET_ADDR_SIZE+MAX_APP_PAYLOAD+AES_BLOCK_BYTES-1)/AES_BLOCK_BYTES*AES_BLOCK_WORDS)
+
+/* [BM] Bytes between the counter hint and the application payload */
+#define SEC_HDR_BYTES         (F_APP_PAYLOAD_OS - F_SEC_CTR_OS)
+#endif  /* SMPL_SECURE_XTEA */
 
 /* Key and cipher block size constants */
 #define SMPL_KEYSIZE_BYTES    16
@@ -97,6 +127,7 @@ typedef union
 {
   uint8_t  keyS[SMPL_KEYSIZE_BYTES];
   uint32_t keyL[SMPL_KEYSIZE_LONGS];
+  uint16_t keyW[SMPL_KEYSIZE_BYTES/2];  /* [BM] AES accelerator */
 } key_t;
 
 
@@ -114,9 +145,12 @@ static uint32_t const sIV = 0x87654321;
  * won't matter how the initialization is done if both peers are the same
  * endianness, good prectice will initialize these as a string (or character
  * array) so that the endianess reconciliation works properly for all cases.
+ *
+ * [BM] The AES accelerator is loaded with the key string as is, in words.
  */
 static key_t sKey = {"SimpliciTI's Key"};
 
+#ifdef SMPL_SECURE_XTEA
 /* Constant set as an authentication code. Note that since it is a
  * fixed value as opposed to a hash of the message it does not provide
  * an integrity check. It will only differentiate two message encryptions
@@ -129,14 +163,27 @@ static secMAC_t const sMAC = 0xA5;
  * is XOR'ed with the actual message to be encrypted.
  */
 static uint32_t sMsg[2] = {0, 0};
+#else
+/* [BM] CMAC subkeys K1 and K2, derived from the key in nwk_securityInit() */
+static uint16_t sK1[AES_BLOCK_WORDS];
+static uint16_t sK2[AES_BLOCK_WORDS];
+#endif  /* SMPL_SECURE_XTEA */
 
 /******************************************************************************
  * LOCAL FUNCTIONS
  */
+#ifdef SMPL_SECURE_XTEA
 static secFCS_t calcFCS(uint8_t *, uint8_t);
 static void     msg_encipher(uint8_t *, uint8_t, uint32_t *);
 static void     msg_decipher(uint8_t *, uint8_t, uint32_t *);
 static void     xtea_encipher(void);
+#else
+static void     aes_encipher(uint16_t *);
+static void     aes_subkey(uint16_t *, uint16_t const *);
+static void     aes_header(uint8_t *, mrfiPacket_t *, uint32_t);
+static void     aes_ctr(mrfiPacket_t *, uint8_t, uint32_t);
+static uint16_t aes_cmac(mrfiPacket_t *, uint8_t, uint32_t);
+#endif  /* SMPL_SECURE_XTEA */
 
 #endif  /* SMPL_SECURE */
 
@@ -154,6 +201,7 @@ static void     xtea_encipher(void);
 void nwk_securityInit(void)
 {
 #ifdef SMPL_SECURE
+#ifdef SMPL_SECURE_XTEA
   uint8_t  i;
 
   /* The key is set as a string. But the XTEA routines operate on 32-bit
@@ -165,6 +213,18 @@ void nwk_securityInit(void)
   {
     sKey.keyL[i] = ntohl(sKey.keyL[i]);
   }
+#else
+  /* [BM] The software reset selects encryption and clears any key. The key
+   * is loaded with the first block. The CMAC subkeys are derived from
+   * L = AES(key, 0).
+   */
+  AESACTL0 = AESSWRST;
+
+  memset(sK1, 0, sizeof(sK1));
+  aes_encipher(sK1);
+  aes_subkey(sK1, sK1);
+  aes_subkey(sK2, sK1);
+#endif  /* SMPL_SECURE_XTEA */
 
 #endif  /* SMPL_SECURE */
   return;
@@ -187,6 +247,8 @@ fhStatus_t nwk_processSecurity(mrfiPacket_t *frame)
   return FHS_RELEASE;
 }
 
+#ifdef SMPL_SECURE
+#ifdef SMPL_SECURE_XTEA
 /******************************************************************************
  * @fn          msg_encipher
  *
@@ -203,7 +265,6 @@ fhStatus_t nwk_processSecurity(mrfiPacket_t *frame)
  *
  * @return      void
  */
-#ifdef SMPL_SECURE
 static void msg_encipher(uint8_t *msg, uint8_t len, uint32_t *cntStart)
 {
   uint8_t  i, idx, done;
@@ -305,6 +366,236 @@ void xtea_encipher(void)
   sMsg[1]=v1;
 }
 
+/******************************************************************************
+ * @fn          calcFCS
+ *
+ * @brief       Calculate the frame check sequence. Currently it's just a
+ *              cumulative XOR of each byte starting with the MAC byte. The
+ *              FCS is placed in front of the MAC after the counter hint and is
+ *              included in the encryption.
+ *
+ * input parameters
+ * @param   msg      - pointer to message
+ * @param   len      - length of message
+ *
+ * output parameters
+ *
+ * @return      Returns the FCS using the typedef.
+ */
+static secFCS_t calcFCS(uint8_t *msg, uint8_t len)
+{
+  uint8_t  i;
+  secFCS_t result = 0;
+
+  for (i=0; i<len; ++i)
+  {
+    result ^= *(msg+i);
+  }
+
+  return result;
+}
+
+#else   /* SMPL_SECURE_XTEA */
+
+/******************************************************************************
+ * @fn          aes_encipher
+ *
+ * @brief       [BM] Encipher one block in place on the AES accelerator. The
+ *              key is loaded only if the accelerator does not hold it yet.
+ *              Frames are also secured from the radio ISR (acknowledgements)
+ *              so the accelerator is used with interrupts disabled.
+ *
+ * input parameters
+ * @param   block    - pointer to the block
+ *
+ * output parameters
+ * @param   block    - enciphered block
+ *
+ * @return      void
+ */
+static void aes_encipher(uint16_t *block)
+{
+  bspIState_t intState;
+  uint8_t     i;
+
+  BSP_ENTER_CRITICAL_SECTION(intState);
+
+  if (!(AESASTAT & AESKEYWR))
+  {
+    for (i=0; i<AES_BLOCK_WORDS; ++i)
+    {
+      AESAKEY = sKey.keyW[i];
+    }
+  }
+
+  for (i=0; i<AES_BLOCK_WORDS; ++i)
+  {
+    AESADIN = block[i];
+  }
+
+  while (AESASTAT & AESBUSY) ;
+
+  for (i=0; i<AES_BLOCK_WORDS; ++i)
+  {
+    block[i] = AESADOUT;
+  }
+
+  BSP_EXIT_CRITICAL_SECTION(intState);
+}
+
+/******************************************************************************
+ * @fn          aes_subkey
+ *
+ * @brief       [BM] CMAC subkey step: shift the block left by one bit and
+ *              XOR 0x87 into the last byte if the shifted out bit was set.
+ *              dst and src may be the same block.
+ *
+ * input parameters
+ * @param   src      - pointer to the source block
+ *
+ * output parameters
+ * @param   dst      - pointer to the derived block
+ *
+ * @return      void
+ */
+static void aes_subkey(uint16_t *dst, uint16_t const *src)
+{
+  uint8_t const *s = (uint8_t const *)src;
+  uint8_t       *d = (uint8_t *)dst;
+  uint8_t        i;
+  uint8_t        msb = s[0] & 0x80;
+
+  for (i=0; i<AES_BLOCK_BYTES-1; ++i)
+  {
+    d[i] = (s[i] << 1) | (s[i+1] >> 7);
+  }
+  d[AES_BLOCK_BYTES-1] = (s[AES_BLOCK_BYTES-1] << 1) ^ (msb ? 0x87 : 0);
+}
+
+/******************************************************************************
+ * @fn          aes_header
+ *
+ * @brief       [BM] Fill in the frame counter (network order) followed by the
+ *              source address of the frame. Both the CTR blocks and the CMAC
+ *              start with it.
+ *
+ * input parameters
+ * @param   frame    - pointer to frame
+ * @param   ctr      - frame counter
+ *
+ * output parameters
+ * @param   hdr      - 4 + NET_ADDR_SIZE bytes
+ *
+ * @return      void
+ */
+static void aes_header(uint8_t *hdr, mrfiPacket_t *frame, uint32_t ctr)
+{
+  hdr[0] = (uint8_t)(ctr >> 24);
+  hdr[1] = (uint8_t)(ctr >> 16);
+  hdr[2] = (uint8_t)(ctr >> 8);
+  hdr[3] = (uint8_t)ctr;
+  memcpy(hdr+4, MRFI_P_SRC_ADDR(frame), NET_ADDR_SIZE);
+}
+
+/******************************************************************************
+ * @fn          aes_ctr
+ *
+ * @brief       [BM] Encrypt or decrypt the application payload in CTR mode.
+ *
+ * input parameters
+ * @param   frame    - pointer to frame
+ * @param   len      - length of application payload
+ * @param   ctr      - frame counter
+ *
+ * output parameters
+ *
+ * @return      void
+ */
+static void aes_ctr(mrfiPacket_t *frame, uint8_t len, uint32_t ctr)
+{
+  uint16_t  blk[AES_BLOCK_WORDS];
+  uint8_t  *ks  = (uint8_t *)blk;
+  uint8_t  *msg = MRFI_P_PAYLOAD(frame)+F_APP_PAYLOAD_OS;
+  uint8_t   i, num = 0;
+
+  while (len)
+  {
+    /* IV | frame counter | source address | 0 ... | block number */
+    memset(blk, 0, sizeof(blk));
+    ks[0] = (uint8_t)(sIV >> 24);
+    ks[1] = (uint8_t)(sIV >> 16);
+    ks[2] = (uint8_t)(sIV >> 8);
+    ks[3] = (uint8_t)sIV;
+    aes_header(ks+4, frame, ctr);
+    ks[AES_BLOCK_BYTES-1] = num++;
+
+    aes_encipher(blk);
+
+    for (i=0; i<AES_BLOCK_BYTES && len; ++i, --len)
+    {
+      *msg++ ^= ks[i];
+    }
+  }
+}
+
+/******************************************************************************
+ * @fn          aes_cmac
+ *
+ * @brief       [BM] CMAC over frame counter, source address and the encrypted
+ *              application payload, truncated to 16 bits. The input is laid
+ *              out in whole blocks first so that it is chained word by word.
+ *
+ * input parameters
+ * @param   frame    - pointer to frame
+ * @param   len      - length of application payload
+ * @param   ctr      - frame counter
+ *
+ * output parameters
+ *
+ * @return      The first 16 bits of the CMAC.
+ */
+static uint16_t aes_cmac(mrfiPacket_t *frame, uint8_t len, uint32_t ctr)
+{
+  uint16_t        buf[AES_CMAC_WORDS];
+  uint16_t        x[AES_BLOCK_WORDS];
+  uint8_t        *b = (uint8_t *)buf;
+  uint16_t const *key = sK1;
+  uint16_t       *m;
+  uint8_t         total = 4+NET_ADDR_SIZE+len;
+  uint8_t         blocks = (total+AES_BLOCK_BYTES-1)/AES_BLOCK_BYTES;
+  uint8_t         i;
+
+  aes_header(b, frame, ctr);
+  memcpy(b+4+NET_ADDR_SIZE, MRFI_P_PAYLOAD(frame)+F_APP_PAYLOAD_OS, len);
+
+  /* a complete last block is masked with K1, a padded one with K2 */
+  if (total % AES_BLOCK_BYTES)
+  {
+    b[total] = 0x80;
+    memset(b+total+1, 0, blocks*AES_BLOCK_BYTES-total-1);
+    key = sK2;
+  }
+  m = buf+(blocks-1)*AES_BLOCK_WORDS;
+  for (i=0; i<AES_BLOCK_WORDS; ++i)
+  {
+    m[i] ^= key[i];
+  }
+
+  /* CBC chain over all blocks */
+  memset(x, 0, sizeof(x));
+  for (m=buf; blocks; --blocks, m+=AES_BLOCK_WORDS)
+  {
+    for (i=0; i<AES_BLOCK_WORDS; ++i)
+    {
+      x[i] ^= m[i];
+    }
+    aes_encipher(x);
+  }
+
+  return ((uint16_t)((uint8_t *)x)[0] << 8) | ((uint8_t *)x)[1];
+}
+#endif  /* SMPL_SECURE_XTEA */
+
 /******************************************************************************
  * @fn          nwk_setSecureFrame
  *
@@ -338,6 +629,7 @@ void nwk_setSecureFrame(mrfiPacket_t *frame, uint8_t msglen, uint32_t *ctr)
   /* place counter value into frame */
   PUT_INTO_FRAME(MRFI_P_PAYLOAD(frame), F_SEC_CTR_OS, (uint8_t)(locCnt & 0xFF));
 
+#ifdef SMPL_SECURE_XTEA
   /* Put MAC value in */
   nwk_putNumObjectIntoMsg((void *)&sMAC, (void *)(MRFI_P_PAYLOAD(frame)+F_SEC_MAC_OS), sizeof(secMAC_t));
 
@@ -350,6 +642,19 @@ void nwk_setSecureFrame(mrfiPacket_t *frame, uint8_t msglen, uint32_t *ctr)
 
   /* Encrypt frame */
   msg_encipher(MRFI_P_PAYLOAD(frame)+F_SEC_ICHK_OS, msglen+sizeof(secMAC_t)+sizeof(secFCS_t), &locCnt);
+#else
+  /* [BM] Encrypt the payload, then put the CMAC of the ciphertext in place of
+   * the FCS and MAC bytes. One counter value per frame.
+   */
+  aes_ctr(frame, msglen, locCnt);
+  {
+    uint16_t mac = aes_cmac(frame, msglen, locCnt);
+
+    PUT_INTO_FRAME(MRFI_P_PAYLOAD(frame), F_SEC_ICHK_OS, (uint8_t)(mac >> 8));
+    PUT_INTO_FRAME(MRFI_P_PAYLOAD(frame), F_SEC_MAC_OS, (uint8_t)mac);
+  }
+  locCnt++;
+#endif  /* SMPL_SECURE_XTEA */
 
   /* Set the Encryption bit */
   PUT_INTO_FRAME(MRFI_P_PAYLOAD(frame), F_ENCRYPT_OS, F_ENCRYPT_OS_MSK);
@@ -363,35 +668,6 @@ void nwk_setSecureFrame(mrfiPacket_t *frame, uint8_t msglen, uint32_t *ctr)
   return;
 }
 
-/******************************************************************************
- * @fn          calcFCS
- *
- * @brief       Calculate the frame check sequence. Currently it's just a
- *              cumulative XOR of each byte starting with the MAC byte. The
- *              FCS is placed in front of the MAC after the counter hint and is
- *              included in the encryption.
- *
- * input parameters
- * @param   msg      - pointer to message
- * @param   len      - length of message
- *
- * output parameters
- *
- * @return      Returns the FCS using the typedef.
- */
-static secFCS_t calcFCS(uint8_t *msg, uint8_t len)
-{
-  uint8_t  i;
-  secFCS_t result = 0;
-
-  for (i=0; i<len; ++i)
-  {
-    result ^= *(msg+i);
-  }
-
-  return result;
-}
-
 /******************************************************************************
  * @fn          nwk_getSecureFrame
  *
@@ -433,6 +709,7 @@ uint8_t nwk_getSecureFrame(mrfiPacket_t *frame, uint8_t msglen, uint32_t *ctr)
     /* See if counters match */
     if (locCnt == frameCnt)
     {
+#ifdef SMPL_SECURE_XTEA
       /* When the counters appear to match is the only time we actually decipher
        * the message. It is the only time we can do so since out-of-sync lsb counter
        * values guarantees that something is wrong somewhere. Decryption is successful
@@ -467,6 +744,23 @@ uint8_t nwk_getSecureFrame(mrfiPacket_t *frame, uint8_t msglen, uint32_t *ctr)
           rc = 0;
         }
       }
+#else
+      /* [BM] The CMAC covers the full counter, so a replayed or rogue frame with
+       * a matching counter hint fails here. Only an authentic frame is decrypted.
+       */
+      if ((msglen < SEC_HDR_BYTES) ||
+          (aes_cmac(frame, msglen-SEC_HDR_BYTES, locCnt) !=
+           (((uint16_t)GET_FROM_FRAME(MRFI_P_PAYLOAD(frame), F_SEC_ICHK_OS) << 8) |
+            GET_FROM_FRAME(MRFI_P_PAYLOAD(frame), F_SEC_MAC_OS))))
+      {
+        rc = 0;
+      }
+      else
+      {
+        aes_ctr(frame, msglen-SEC_HDR_BYTES, locCnt);
+        locCnt++;
+      }
+#endif  /* SMPL_SECURE_XTEA */
 
       /* we're done. */
       done = 1;
@@ -82,6 +82,9 @@
 //
 // *************************************************************************************************
 
+// Largest application payload (MAX_APP_PAYLOAD) sizes the windowed download frames
+#include "Applications/configuration/smpl_nwk_config.h"
+
 // ---------------------------------------------------------------
 // Generic defines and variables
 
@@ -92,7 +95,7 @@ extern unsigned char simpliciti_link(void);
 extern unsigned char simpliciti_ed_address[4];
 
 // Maximum data length
-#define SIMPLICITI_MAX_PAYLOAD_LENGTH       	(32u)
+#define SIMPLICITI_MAX_PAYLOAD_LENGTH       	(50u)
 
 // Data to send / receive 
 extern unsigned char simpliciti_data[SIMPLICITI_MAX_PAYLOAD_LENGTH];
@@ -119,6 +122,46 @@ extern unsigned char rf_frequoffset;
 #define toggleFlag(val, flag)					(val^=flag)
 
 
+// ---------------------------------------------------------------
+// Output power control
+
+// Output power levels IOCTL_LEVEL_0 .. IOCTL_LEVEL_2 (-20dBm, -10dBm, +1dBm, see mrfiRFPowerTable)
+#define SIMPLICITI_TX_LEVELS					(3u)
+
+// Link events reported to simpliciti_link_quality_callback
+#define SIMPLICITI_LINK_START					(0u)	// Joined, nothing received yet
+#define SIMPLICITI_LINK_FRAME					(1u)	// Frame from access point, rssi and lqi are valid
+#define SIMPLICITI_LINK_MISS					(2u)	// Expected reply did not arrive
+#define SIMPLICITI_LINK_IDLE					(3u)	// Ready-to-receive packet without reply
+
+// Callback function to track link quality. Returns the output power level to use from now on.
+extern unsigned char simpliciti_link_quality_callback(unsigned char event, signed char rssi, unsigned char lqi);
+
+
+// ---------------------------------------------------------------
+// Channel agility
+#ifdef CONFIG_FREQ_AGILITY
+// Logical channels (MRFI_NUM_LOGICAL_CHANS) and clear channel assessments per frame (MRFI_CCA_RETRIES + 1)
+#define SIMPLICITI_CHANNELS						(4u)
+#define SIMPLICITI_CCA_ATTEMPTS					(5u)
+
+// Callback function to keep channel statistics. Called after every frame sent with the logical channel
+// it was sent on, the failed clear channel assessments before it (SIMPLICITI_CCA_ATTEMPTS = not sent)
+// and the RSSI of the last failed one. Returns the logical channel to move the link to.
+extern unsigned char simpliciti_channel_callback(unsigned char chan, unsigned char cca_fails, signed char rssi);
+#endif
+
+
+// ---------------------------------------------------------------
+// Link cache
+#ifdef CONFIG_LINK_CACHE
+// Callback functions to keep the join context of the last link across sessions and resets. 
+// Load returns 1 when len bytes saved before were copied to data.
+extern unsigned char simpliciti_link_cache_load(unsigned char * data, unsigned char len);
+extern void simpliciti_link_cache_store(unsigned char * data, unsigned char len);
+#endif
+
+
 // ---------------------------------------------------------------
 // SimpliciTI RX only
 #ifdef SIMPLICITI_TX_ONLY_REQ
@@ -135,10 +178,21 @@ extern void simpliciti_get_ed_data_callback(void);
 // Sync data length
 #define BM_SYNC_DATA_LENGTH                     (19u)
 
+// Wake-on-Radio sync: longest sleep (msec) between two watchdog kicks when no frame arrives.
+// Timer0_A4_DelayUntil takes 16 bit ticks, which limits one sleep to 2 seconds.
+#define BM_SYNC_WOR_TIMEOUT                     (1900u)
+
 // Device data  (0)TYPE   (1) - (18) DATA 
+// Status: (1) bit7 metric units, hour  (2) minute  (3) second  (4..5) year  (6) month  (7) day  
+// (8) alarm hour  (9) alarm minute  (10..11) temperature  (12..13) altitude  (14..15) log packets 
+// (16) bits 7..6 output power level, bits 5..0 missed replies  (17) RSSI (dBm)  (18) LQI of the last 
+// frame from the access point
 #define SYNC_ED_TYPE_R2R                        (1u)
 #define SYNC_ED_TYPE_MEMORY                     (2u)
 #define SYNC_ED_TYPE_STATUS                     (3u)
+#define SYNC_ED_TYPE_ENERGY                     (4u)
+#define SYNC_ED_TYPE_MEMORY_BULK                (5u)
+#define SYNC_ED_TYPE_STEPS                      (6u)
 
 // Host data    (0)CMD    (1) - (18) DATA 
 #define SYNC_AP_CMD_NOP                         (1u)
@@ -148,6 +202,27 @@ extern void simpliciti_get_ed_data_callback(void);
 #define SYNC_AP_CMD_GET_MEMORY_BLOCKS_MODE_2   	(5u)
 #define SYNC_AP_CMD_ERASE_MEMORY                (6u)
 #define SYNC_AP_CMD_EXIT						(7u)
+#define SYNC_AP_CMD_GET_ENERGY                  (8u)
+#define SYNC_AP_CMD_GET_MEMORY_BULK             (9u)
+#define SYNC_AP_CMD_BULK_ACK                    (10u)
+#define SYNC_AP_CMD_GET_STEPS                   (11u)
+
+// Windowed memory download
+// Host:   (0) GET_MEMORY_BULK  (1..2) first log packet  (3..4) end log packet (exclusive)
+// Device: (0) MEMORY_BULK      (1) frame sequence, bit7 = last frame of window  (2..) as many 16 byte
+//         log packets as fit into MAX_APP_PAYLOAD (3 in 50 bytes)
+// Host:   (0) BULK_ACK         (1) next expected sequence  (2) bit j = frame (1)+1+j received
+// The device sends all unacknowledged frames of the window back to back and waits for the ACK.
+// A lost frame costs one repetition of that frame, a lost ACK one timeout (msec) and the whole window again.
+#define BM_SYNC_BULK_HEADER_LENGTH              (2u)
+#define BM_SYNC_BULK_PACKET_SIZE                (16u)
+#define BM_SYNC_BULK_LOG_PACKETS                ((MAX_APP_PAYLOAD - BM_SYNC_BULK_HEADER_LENGTH) / BM_SYNC_BULK_PACKET_SIZE)
+#define BM_SYNC_BULK_DATA_LENGTH                (BM_SYNC_BULK_HEADER_LENGTH + BM_SYNC_BULK_LOG_PACKETS * BM_SYNC_BULK_PACKET_SIZE)
+#define BM_SYNC_BULK_WINDOW                     (8u)
+#define BM_SYNC_BULK_SEQ_MASK                   (0x7Fu)
+#define BM_SYNC_BULK_ACK_REQUEST                (0x80u)
+#define BM_SYNC_BULK_ACK_TIMEOUT                (20u)
+#define BM_SYNC_BULK_RETRIES                    (5u)
 
 
 // Entry point into SimpliciTI library
@@ -162,3 +237,6 @@ extern void simpliciti_sync_get_data_callback(unsigned int index);
 // Send reply packets (>0), 0=no need to reply
 extern unsigned char simpliciti_reply_count;
 
+// Frames of a windowed memory download (>0), 0=no download requested
+extern unsigned int simpliciti_bulk_packets;
+
@@ -73,6 +73,31 @@ DATA["USE_WATCHDOG"] = {
         "help": "Protects the clock against deadlocks by rebooting it.",
 }
 
+DATA["USE_TICKLESS_IDLE"] = {
+        "name": "Tickless idle",
+        "default": True,
+        "help": "Stop the 1/s clock interrupt while only HH:MM and the date are shown. The RTC keeps the time and wakes up the main loop once a minute, the watchdog interval is raised from 16 to 256 seconds while the main loop sleeps.",
+}
+
+DATA["CONFIG_SYNC_WOR"] = {
+        "name": "Wake-on-Radio sync",
+        "default": False,
+        "help": "In SYNC mode the radio sleeps and sniffs for a carrier twice a second instead of sending a ready-to-receive packet and listening 10ms each time. Needs an access point that wakes the watch by repeating its command for more than 500ms.",
+}
+
+DATA["CONFIG_LINK_CACHE"] = {
+        "name": "Fast SimpliciTI reconnect",
+        "depends": ["CONFIG_INFOMEM"],
+        "default": False,
+        "help": "Keeps access point address, tokens and channel of the last link in the Information Memory. The next link first repeats the old link request, which an access point that still holds the link answers at once. Saves the join and the one second wait before linking. Falls back to a normal join otherwise.",
+}
+
+DATA["CONFIG_FREQ_AGILITY"] = {
+        "name": "SimpliciTI channel agility",
+        "default": False,
+        "help": "Keeps statistics of failed clear channel assessments and missed replies per logical channel and asks the access point to move the link when another channel promises fewer repetitions. The channel is kept for the next link with CONFIG_LINK_CACHE. Needs an access point that handles move requests.",
+}
+
 # FIXME implement
 # DATA["CONFIG_AUTOSYNC"] = {
 #         "name": "Automaticly SYNC after reboot",
@@ -127,7 +152,8 @@ DATA["CONFIG_PHASE_CLOCK"] = {
         "name": "Phase Clock (918 bytes)",
         "depends": [],
         "default": False,
-        "help": "Measures sleep phase by recording body movement and sending the data to the accesspoint.\n"
+        "help": "Measures sleep phase by recording body movement once per minute. The radio stays off during the night, "
+                "the epochs are uploaded to the accesspoint when recording stops or at the set interval.\n"
                 "Designed to be used with uberclock",
 }
 
@@ -144,11 +170,18 @@ DATA["CONFIG_VARIO"] = {
         "depends": [],
         "default": False}
 
+DATA["CONFIG_ALTI_KALMAN"] = {
+        "name": "Altitude and vertical speed from pressure and acceleration",
+        "depends": ["CONFIG_ALTITUDE"],
+        "default": False,
+        "help": "Replaces the pressure low pass and the once per second pressure difference of the vario with a Kalman filter for altitude, vertical speed and accelerometer bias. While the vario is shown, the acceleration sensor runs and vertical acceleration bridges the time between pressure samples, which removes most of the lag of the vario. Altimeter and accumulator read the same estimate.",
+}
+
 DATA["CONFIG_ALTI_ACCUMULATOR"] = {
 	"name": "Altitude accumulator (1068 bytes)",
 	"depends": [],
 	"default": False,
-	"help": "If active take altitude measurement once per minute and accumulate all ascending vertical meters."
+	"help": "If active take 4 triggered pressure samples once per minute in the background and accumulate ascending and descending vertical meters per hour of the day. Shows height difference, total ascent, peak altitude and today's ascent and descent."
 	}
 
 DATA["CONFIG_PROUT"] = {
@@ -181,6 +214,27 @@ DATA["CONFIG_ACCEL"] = {
         "help": "Acceleration applications (display and transmission). When no other application uses the acceleration sensor, it is disabled completely"
         }
 
+DATA["CONFIG_ACCEL_STREAM"] = {
+        "name": "  packed acceleration stream",
+        "depends": ["CONFIG_ACCEL"],
+        "default": False,
+        "help": "ACC mode sends every 400Hz sample, 15 per packet as one absolute sample and 4, 6 or 8 bit deltas (about 27 packets/s instead of about 87 packets/s carrying one sample each). Needs an access point and host software that decode the format, see contrib/read_acceleration.py."
+        }
+
+DATA["CONFIG_PEDOMETER"] = {
+        "name": "Pedometer",
+        "depends": [],
+        "default": False,
+        "help": "Counts steps around the clock and keeps steps and activity level per hour of the day for sync. The acceleration sensor samples at 40Hz while the wrist moves and waits in motion detection mode while it is still. Shows steps today, cadence and activity level.",
+        }
+
+DATA["CONFIG_FLICK_BACKLIGHT"] = {
+        "name": "Wrist flick backlight",
+        "depends": [],
+        "default": False,
+        "help": "Turning the wrist towards the face switches on the backlight and redraws the display, no button needed. The acceleration sensor stays off and powers up for a single sample every 1.9 sec, it samples at 40Hz only to follow a wrist that moved until it rests. A turn is noticed up to 2 sec late. With the pedometer on, the detector uses its samples.",
+        }
+
 DATA["CONFIG_STRENGTH"] = {
     "name": "Strength training timer (380 bytes)",
     "depends": [],
@@ -211,6 +265,16 @@ DATA["CONFIG_BATTERY"] = {
         "name": "Battery (360 bytes)",
         "depends": [],
         "default": True}
+DATA["CONFIG_DATALOG"] = {
+        "name": "Data logger (512 bytes RAM, 2 kB flash)",
+        "depends": [],
+        "default": True,
+        "help": "Record altitude, temperature, battery voltage and acceleration activity every 10 minutes into a ring buffer in main flash (0xF600-0xFDFF). The access point reads it with the SYNC memory burst commands."}
+DATA["CONFIG_ENERGY_STATS"] = {
+        "name": "Energy statistics",
+        "depends": ["CONFIG_BATTERY"],
+        "default": True,
+        "help": "Count the time spent in interrupts, measurements, display updates and radio/buzzer/backlight on-time. Press DOWN in the battery voltage screen to show the top consumers in seconds per day, long NUM clears the counters. SYNC command 8 reads the raw counters."}
 DATA["CONFIG_CLOCK"] = {
         "name": "Clock",
         "depends": [],
@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+"""
+Steady-state gains of the altitude estimator in logic/altitude.c.
+
+Runs the Riccati recursion of the Kalman filter until the gains settle and
+prints them as floats and as the Q16 constants used by the firmware. All
+figures are in the pressure domain (Pa, s).
+
+  kalman_gains.py [noise R] [accel q] [bias q]   pressure, pressure change, bias
+  kalman_gains.py -cv [noise R] [accel q]        pressure, pressure change
+
+R is the pressure noise variance (Pa^2), the q are spectral densities
+((Pa/s2)^2/s) of the random vertical acceleration and of the bias drift.
+"""
+
+import sys
+
+T = 1.0         # pressure sample interval (s)
+
+def mul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(len(b))) for j in range(len(b[0]))]
+            for i in range(len(a))]
+
+def transpose(a):
+    return [list(r) for r in zip(*a)]
+
+def gains(r, qu, qb=None):
+    if qb is None:
+        f = [[1, T], [0, 1]]
+        q = [[qu*T**3/3, qu*T**2/2], [qu*T**2/2, qu*T]]
+    else:
+        # Bias is subtracted from the measured acceleration
+        f = [[1, T, -T*T/2], [0, 1, -T], [0, 0, 1]]
+        q = [[qu*T**3/3, qu*T**2/2, 0], [qu*T**2/2, qu*T, 0], [0, 0, qb*T]]
+    n = len(f)
+    p = [[100.0 if i == j else 0.0 for j in range(n)] for i in range(n)]
+    for i in range(5000):
+        p = mul(mul(f, p), transpose(f))
+        p = [[p[i][j] + q[i][j] for j in range(n)] for i in range(n)]
+        s = p[0][0] + r
+        k = [p[i][0] / s for i in range(n)]
+        p = [[p[i][j] - k[i] * p[0][j] for j in range(n)] for i in range(n)]
+    return k
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    if args and args[0] == "-cv":
+        a = [float(x) for x in args[1:]] or [9.0, 2.0]
+        k = gains(a[0], a[1])
+    else:
+        a = [float(x) for x in args] or [9.0, 0.2, 0.002]
+        k = gains(a[0], a[1], a[2])
+    for x in k:
+        print("%10.6f  %6d" % (x, int(round(abs(x) * 65536))))
@@ -260,6 +260,9 @@ if __name__ == "__main__":
                   dest="format", help="output format [titxt,ihex]",
                   choices=["titxt", "ihex"],
                   default="titxt")
+    parser.add_option("-r", "--reserve", dest="reserve", action="append",
+                  default=[], metavar="START-END",
+                  help="fail if the image uses the address range (end exclusive)")
 
     (options, args) = parser.parse_args()
 
@@ -268,6 +271,13 @@ if __name__ == "__main__":
 
     mem = Memory()
     mem.loadFile(options.input)
+    for reserve in options.reserve:
+        start, end = [int(x, 0) for x in reserve.split("-")]
+        for seg in mem:
+            if seg.startaddress < end and seg.startaddress + len(seg) > start:
+                sys.stderr.write("error: 0x%04x-0x%04x overlaps reserved range %s\n" % (
+                    seg.startaddress, seg.startaddress + len(seg), reserve))
+                sys.exit(1)
     fp = open(options.output, "w")
     if options.format == "titxt":
         print "convert to TI Hex"